@@ -12,9 +12,11 @@
 #ifndef _ipc_h
 #define _ipc_h
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "sae.h"
+#include "trace_log.h"
 
 /*
  * IPC core identifiers
@@ -28,6 +30,36 @@
  */
 #define IPC_CYCLE_DOMAIN_MAX 4
 
+/*
+ * DSP jobs.  Each SHARC stream pair is a DSP node (node 0 SHARC0_IN ->
+ * SHARC0_OUT, node 1 SHARC1_IN -> SHARC1_OUT) and each node's output
+ * channels are split into IPC_DSP_GROUPS independent groups.  A job is
+ * one group of one node and can run on either SHARC.  A plan has one
+ * bit per job, set if SHARC1 runs it.  The home plan runs each node on
+ * its own SHARC.
+ */
+#define IPC_DSP_NODES        2
+#define IPC_DSP_GROUPS       4
+#define IPC_DSP_JOBS         (IPC_DSP_NODES * IPC_DSP_GROUPS)
+#define IPC_DSP_JOB(node, group)  ((node) * IPC_DSP_GROUPS + (group))
+#define IPC_DSP_NODE_MASK(node) \
+    (((1u << IPC_DSP_GROUPS) - 1) << ((node) * IPC_DSP_GROUPS))
+#define IPC_DSP_HOME_PLAN    IPC_DSP_NODE_MASK(1)
+#define IPC_DSP_JOB_CORE(plan, job) \
+    ((((plan) >> (job)) & 1) ? IPC_CORE_SHARC1 : IPC_CORE_SHARC0)
+
+/*
+ * Convolution.  Each SHARC has a partitioned convolver on the first
+ * IPC_CONV_CHANNELS output channels of its own node, with impulse
+ * responses up to IPC_CONV_TAPS long.  Its filter state, about 66 KB,
+ * has to fit one SHARC L1 block.  Responses are sent
+ * IPC_CONV_CHUNK_TAPS at a time to keep the messages small in the
+ * uncached L2 heap.
+ */
+#define IPC_CONV_CHANNELS    2
+#define IPC_CONV_TAPS        2048
+#define IPC_CONV_CHUNK_TAPS  256
+
 /*
  * IPC message types
  */
@@ -39,11 +71,17 @@ enum IPC_TYPE {
     IPC_TYPE_SHARC1_READY,
     IPC_TYPE_PROCESS_AUDIO,
     IPC_TYPE_CYCLES,
+    IPC_TYPE_TRACE_LOG,
+    IPC_TYPE_BLOCK,
+    IPC_TYPE_CONV,
+    IPC_TYPE_FFT_LEASE,
 };
 
 /*
  * Audio stream identifiers (IPC_TYPE_AUDIO messages).  IN and OUT are
- * as viewed from the ARM core.
+ * as viewed from the ARM core.  SHARC_LINK is the L2 buffer SHARC0
+ * writes and SHARC1 reads when the SHARCs are chained, the ARM never
+ * touches its audio.
  */
 enum IPC_STREAMID {
     IPC_STREAMID_UNKNOWN = 0,
@@ -51,6 +89,7 @@ enum IPC_STREAMID {
     IPC_STREAMID_SHARC0_OUT,
     IPC_STREAMID_SHARC1_IN,
     IPC_STREAMID_SHARC1_OUT,
+    IPC_STREAMID_SHARC_LINK,
     IPC_STREAM_ID_MAX
 };
 
@@ -70,7 +109,30 @@ typedef struct _IPC_MSG_AUDIO {
 #pragma pack()
 
 /*
- * CPU cycles (IPC_TYPE_CYCLES messages)
+ * Audio stream descriptor (IPC_TYPE_BLOCK messages).  'data' is the
+ * L2 address of the stream buffer, which the ARM owns for the life of
+ * the application.  'format' is an IPC_AUDIO_FORMAT.
+ */
+enum IPC_AUDIO_FORMAT {
+    IPC_AUDIO_FORMAT_FIXED = 0,     /* Left justified integer */
+    IPC_AUDIO_FORMAT_FLOAT,         /* float32, full scale +/-1.0 */
+};
+
+#pragma pack(1)
+typedef struct _IPC_MSG_AUDIO_DESC {
+    uint8_t streamID;
+    uint8_t clockDomain;
+    uint8_t wordSize;
+    uint8_t format;
+    uint16_t numChannels;
+    uint16_t numFrames;
+    uintptr_t data;
+} IPC_MSG_AUDIO_DESC;
+#pragma pack()
+
+/*
+ * CPU cycles (IPC_TYPE_CYCLES messages).  'jobCycles' is the last cost
+ * of each DSP job this core ran, 0 for jobs the other core ran.
  */
 #pragma pack(1)
 typedef struct _IPC_MSG_CYCLES {
@@ -78,19 +140,114 @@ typedef struct _IPC_MSG_CYCLES {
     uint8_t max;
     uint8_t reserved[2];
     uint32_t cycles[IPC_CYCLE_DOMAIN_MAX];
+    uint32_t jobCycles[IPC_DSP_JOBS];
 } IPC_MSG_CYCLES;
 #pragma pack()
 
 /*
- * Process (IPC_TYPE_PROCESS_AUDIO messages)
+ * Process (IPC_TYPE_PROCESS_AUDIO messages).  Each SHARC sets its
+ * 'done' flag in place when it has finished the block, the ARM polls
+ * them in zero added latency mode.
  */
+#define IPC_PROCESS_DONE_IDX(core)  ((core) - IPC_CORE_SHARC0)
+
 #pragma pack(1)
 typedef struct _IPC_MSG_PROCESS_AUDIO {
     uint8_t clockDomain;
-    uint8_t reserved[3];
+    uint8_t reserved;
+    volatile uint8_t done[2];
+    uint32_t timestamp;
 } IPC_MSG_PROCESS_AUDIO;
 #pragma pack()
 
+/*
+ * Block (IPC_TYPE_BLOCK messages).  One per clock domain block, sent to
+ * both SHARCs.  Carries every SHARC stream buffer in the clock domain
+ * followed by the process command, so it replaces the IPC_TYPE_AUDIO
+ * and IPC_TYPE_PROCESS_AUDIO messages with a single interrupt per core.
+ * Each SHARC runs the DSP jobs 'plan' gives it.  'done' is as in
+ * IPC_MSG_PROCESS_AUDIO.
+ *
+ * A block with a SHARC_LINK stream chains the SHARCs.  It goes to
+ * SHARC0 only, which processes SHARC0_IN into the link and then
+ * forwards the same message to SHARC1, which processes the link into
+ * SHARC1_OUT.  A chained block always carries the home plan.
+ */
+#define IPC_MSG_BLOCK_SIZE(streams) \
+    (offsetof(IPC_MSG, block.stream) + (streams) * sizeof(IPC_MSG_AUDIO_DESC))
+
+#pragma pack(1)
+typedef struct _IPC_MSG_BLOCK {
+    uint8_t clockDomain;
+    uint8_t numStreams;
+    volatile uint8_t done[2];
+    uint32_t timestamp;
+    uint32_t plan;
+    IPC_MSG_AUDIO_DESC stream[];
+} IPC_MSG_BLOCK;
+#pragma pack()
+
+/*
+ * Convolver impulse responses (IPC_TYPE_CONV messages).  Sent to the
+ * home SHARC of 'node' one piece at a time, in order from 'offset' 0.
+ * Each piece carries taps 'offset' up to 'offset + count' of 'channels'
+ * responses 'taps' long, 'ir' holding 'count' taps per channel one
+ * channel after the other.  Output channels past the last reuse it.
+ * 'offset' is a multiple of IPC_CONV_CHUNK_TAPS and 0 taps turns the
+ * convolver off.
+ *
+ * The SHARC transforms each piece in its background loop, passing audio
+ * through from the first piece until the last, then sets 'done'.  The
+ * sender keeps a reference and waits for it before sending the next.
+ * The node's DSP jobs must stay on its home SHARC while it's on, that's
+ * where the filter state lives.
+ */
+#define IPC_MSG_CONV_SIZE(channels, count) \
+    (offsetof(IPC_MSG, conv.ir) + (channels) * (count) * sizeof(float))
+
+enum IPC_CONV_DONE {
+    IPC_CONV_PENDING = 0,
+    IPC_CONV_LOADED,
+    IPC_CONV_REJECTED,
+};
+
+#pragma pack(1)
+typedef struct _IPC_MSG_CONV {
+    uint8_t node;
+    uint8_t channels;
+    volatile uint8_t done;
+    uint8_t reserved;
+    uint32_t taps;
+    uint32_t offset;
+    uint32_t count;
+    float ir[];
+} IPC_MSG_CONV;
+#pragma pack()
+
+/*
+ * FFT accelerator lease (IPC_TYPE_FFT_LEASE messages).  The accelerator
+ * is one block shared by the ARM's FFT queue and SHARC0's convolver.
+ * The ARM sends it to SHARC0 once at startup and keeps it referenced.
+ * A core takes 'lock' with sae_lock() before touching the accelerator
+ * and unlocks it once nothing it started is left running.  'owner' is
+ * the core that last had it, a core finding another there sets the
+ * accelerator up again.  Neither core ever waits on it in an interrupt.
+ */
+#pragma pack(1)
+typedef struct _IPC_MSG_FFT_LEASE {
+    volatile uint32_t lock;
+    volatile uint32_t owner;
+} IPC_MSG_FFT_LEASE;
+#pragma pack()
+
+/*
+ * SHARC trace log (IPC_TYPE_TRACE_LOG messages).  Sent once at startup.
+ * The message stays referenced so the ARM can keep reading the log in
+ * place.
+ */
+#define IPC_MSG_TRACE_LOG_SIZE(entries) \
+    (offsetof(IPC_MSG, traceLog) + TRACE_LOG_SIZE(entries))
+
 /*
  * Generic message.  Query type to determine which union'd payload to
  * use.
@@ -103,6 +260,10 @@ typedef struct _IPC_MSG {
         IPC_MSG_AUDIO audio;
         IPC_MSG_CYCLES cycles;
         IPC_MSG_PROCESS_AUDIO process;
+        IPC_MSG_BLOCK block;
+        IPC_MSG_CONV conv;
+        IPC_MSG_FFT_LEASE fftLease;
+        TRACE_LOG traceLog;
     };
 } IPC_MSG;
 #pragma pack()
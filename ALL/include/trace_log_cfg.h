@@ -0,0 +1,58 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _trace_log_cfg_h
+#define _trace_log_cfg_h
+
+/*
+ * Trace log entries per core.  Must be a power of 2.  The ARM log lives
+ * in SDRAM, the SHARC logs in the SAE message heap in shared L2.
+ */
+#define TRACE_LOG_ARM_ENTRIES      (4096)
+#define TRACE_LOG_SHARC_ENTRIES    (256)
+
+/* Cores that can own a trace log (matches the IPC core indices) */
+#define TRACE_LOG_MAX_CORES        (3)
+
+/*
+ * Timestamp source.  CGU0 TSCOUNT ticks at CGU_TS_CLK and is readable
+ * from every core so entries from all logs share one timebase.
+ */
+#ifndef TRACE_LOG_TIMESTAMP
+#include <sys/platform.h>
+#define TRACE_LOG_TIMESTAMP()      (*pREG_CGU0_TSCOUNT0)
+#endif
+
+/*
+ * Trace message formats shared by all cores.  Only the ID and up to
+ * four 32-bit integer arguments are stored so formats may only use
+ * integer conversions (%d, %u, %x).  Append new IDs at the end so
+ * SHARC images built against an older table still decode.
+ */
+#define TRACE_LOG_FORMATS(X) \
+    X(TRACE_ID_NONE,                "") \
+    X(TRACE_ID_WAV_SRC_UNDERFLOW,   "WAV src underflow, level %u of %u") \
+    X(TRACE_ID_WAV_SINK_OVERFLOW,   "WAV sink overflow, free %u of %u") \
+    X(TRACE_ID_RTP_RX_UNDERFLOW,    "RTP rx%u underflow, level %u") \
+    X(TRACE_ID_RTP_RX_OVERFLOW,     "RTP rx%u overflow, free %u need %u") \
+    X(TRACE_ID_RTP_TX_OVERFLOW,     "RTP tx overflow, free %u") \
+    X(TRACE_ID_VBAN_RX_UNDERFLOW,   "VBAN rx%u underflow, level %u") \
+    X(TRACE_ID_VBAN_RX_OVERFLOW,    "VBAN rx%u overflow, free %u need %u") \
+    X(TRACE_ID_VBAN_TX_OVERFLOW,    "VBAN tx overflow, free %u") \
+    X(TRACE_ID_SHARC_UNKNOWN_STREAM,"Unknown IPC audio stream %u") \
+    X(TRACE_ID_SHARC_CYCLES,        "Clock domain %u processed in %u cycles") \
+    X(TRACE_ID_XYZ_RFFT_START,      "Key analysis rfft, %u samples") \
+    X(TRACE_ID_XYZ_RFFT_ERROR,      "Key analysis rfft failed") \
+    X(TRACE_ID_XYZ_FUNDAMENTAL,     "Key analysis fundamental %u Hz, MIDI %u.%02u") \
+    X(TRACE_ID_SHARC_SYNC_MISS,     "Clock domain %u SHARC deadline missed, waited %u ticks") \
+    X(TRACE_ID_SHARC_CONV,          "Node %u convolver %u taps, %u responses")
+
+#endif
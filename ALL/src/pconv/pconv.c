@@ -0,0 +1,476 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "pconv.h"
+
+#define N       (PCONV_FFT_SIZE)
+#define B       (PCONV_BLOCK)
+#define M       (PCONV_FFT_SIZE / 2)
+
+/***********************************************************************
+ * Convolver
+ **********************************************************************/
+bool pconv_init(PCONV *c, void *mem, size_t size, unsigned channels,
+    unsigned maxParts, const PCONV_FFT *fft)
+{
+    PCONV_CHANNEL *ch;
+    uint8_t *p = mem;
+    unsigned i;
+
+    memset(c, 0, sizeof(*c));
+    if ((channels > PCONV_MAX_CHANNELS) ||
+        (size < PCONV_MEM_SIZE(maxParts, channels))) {
+        return(false);
+    }
+
+    c->fft = *fft;
+    c->channels = channels;
+    c->maxParts = maxParts;
+
+    for (i = 0; i < channels; i++) {
+        ch = &c->chan[i];
+        ch->fdl = (complex_float *)p;
+        p += maxParts * PCONV_BINS * sizeof(complex_float);
+        ch->filter = (complex_float *)p;
+        p += maxParts * PCONV_BINS * sizeof(complex_float);
+        ch->x = (float *)p;
+        p += N * sizeof(float);
+    }
+    pconv_reset(c);
+
+    return(true);
+}
+
+void pconv_reset(PCONV *c)
+{
+    PCONV_CHANNEL *ch;
+    unsigned i;
+
+    for (i = 0; i < c->channels; i++) {
+        ch = &c->chan[i];
+        memset(ch->x, 0, N * sizeof(float));
+        memset(ch->fdl, 0, c->maxParts * PCONV_BINS * sizeof(complex_float));
+        ch->head = 0;
+    }
+}
+
+void pconv_set_fft(PCONV *c, const PCONV_FFT *fft)
+{
+    c->fft = *fft;
+}
+
+bool pconv_load_ir(PCONV *c, unsigned channel, unsigned offset,
+    const float *ir, unsigned taps)
+{
+    PCONV_CHANNEL *ch;
+    complex_float *h;
+    unsigned part, last, len, i;
+    bool ok = true;
+
+    if ((channel >= c->channels) || (offset % B)) {
+        return(false);
+    }
+    ch = &c->chan[channel];
+    ch->parts = 0;
+
+    last = PCONV_PARTS(offset + taps);
+    if (last > c->maxParts) {
+        last = c->maxParts;
+        ok = false;
+    }
+
+    /* Each partition zero padded to the transform size */
+    for (part = offset / B; part < last; part++) {
+        len = offset + taps - part * B;
+        if (len > B) {
+            len = B;
+        }
+        memset(c->y, 0, sizeof(c->y));
+        memcpy(c->y, ir + (part * B - offset), len * sizeof(float));
+        h = ch->filter + part * PCONV_BINS;
+        c->fft.rfft(c->fft.usr, c->y, h);
+        c->fft.wait(c->fft.usr);
+        for (i = 0; i < PCONV_BINS; i++) {
+            h[i].re *= 1.0f / N;
+            h[i].im *= 1.0f / N;
+        }
+    }
+
+    return(ok);
+}
+
+void pconv_set_taps(PCONV *c, unsigned channel, unsigned taps)
+{
+    PCONV_CHANNEL *ch;
+    unsigned parts;
+
+    if (channel >= c->channels) {
+        return;
+    }
+    ch = &c->chan[channel];
+
+    parts = PCONV_PARTS(taps);
+    if (parts > c->maxParts) {
+        parts = c->maxParts;
+    }
+
+    memset(ch->x, 0, N * sizeof(float));
+    memset(ch->fdl, 0, c->maxParts * PCONV_BINS * sizeof(complex_float));
+    ch->head = 0;
+    ch->parts = parts;
+}
+
+bool pconv_set_ir(PCONV *c, unsigned channel, const float *ir,
+    unsigned taps)
+{
+    bool ok;
+
+    ok = pconv_load_ir(c, channel, 0, ir, taps);
+    pconv_set_taps(c, channel, taps);
+
+    return(ok);
+}
+
+/* Slides in a block of input and starts its transform */
+static void convLoad(PCONV *c, PCONV_CHANNEL *ch, const float *in,
+    unsigned stride)
+{
+    unsigned i;
+
+    memmove(ch->x, ch->x + B, B * sizeof(float));
+    for (i = 0; i < B; i++) {
+        ch->x[B + i] = *in;
+        in += stride;
+    }
+
+    ch->head = (ch->head + 1 < ch->parts) ? ch->head + 1 : 0;
+    c->fft.rfft(c->fft.usr, ch->x, ch->fdl + ch->head * PCONV_BINS);
+}
+
+static void convMac(complex_float *acc, const complex_float *h,
+    const complex_float *x)
+{
+    unsigned i;
+
+    for (i = 0; i < PCONV_BINS; i++) {
+        acc[i].re += (h[i].re * x[i].re) - (h[i].im * x[i].im);
+        acc[i].im += (h[i].re * x[i].im) + (h[i].im * x[i].re);
+    }
+}
+
+/* Every partition but the first, none of them need the new input */
+static void convTail(PCONV_CHANNEL *ch, complex_float *acc)
+{
+    unsigned part, slot;
+
+    memset(acc, 0, PCONV_BINS * sizeof(complex_float));
+    slot = ch->head;
+    for (part = 1; part < ch->parts; part++) {
+        slot = slot ? slot - 1 : ch->parts - 1;
+        convMac(acc, ch->filter + part * PCONV_BINS,
+            ch->fdl + slot * PCONV_BINS);
+    }
+}
+
+/* Overlap-save, the second half of the inverse is the new output */
+static void convStore(PCONV *c, float *out, unsigned stride)
+{
+    unsigned i;
+
+    for (i = 0; i < B; i++) {
+        *out = c->y[B + i];
+        out += stride;
+    }
+}
+
+/*
+ * Channels are interleaved so the accelerator is kept busy: the
+ * forward transform of the next channel runs under the first partition
+ * of this one and this channel's inverse runs under the rest of the
+ * next channel's partitions.
+ */
+void pconv_process(PCONV *c, unsigned first, unsigned last,
+    const float *in, float *out, unsigned stride)
+{
+    uint8_t active[PCONV_MAX_CHANNELS];
+    PCONV_CHANNEL *ch, *next;
+    unsigned n, i, j, buf;
+
+    if (last > c->channels) {
+        last = c->channels;
+    }
+
+    n = 0;
+    for (i = first; i < last; i++) {
+        if (c->chan[i].parts) {
+            active[n++] = i;
+        } else if (in != out) {
+            for (j = 0; j < B; j++) {
+                out[j * stride + (i - first)] = in[j * stride + (i - first)];
+            }
+        }
+    }
+    if (n == 0) {
+        return;
+    }
+
+    ch = &c->chan[active[0]];
+    convLoad(c, ch, in + (active[0] - first), stride);
+    convTail(ch, c->acc[0]);
+    c->fft.wait(c->fft.usr);
+
+    for (i = 0; i < n; i++) {
+        ch = &c->chan[active[i]];
+        next = (i + 1 < n) ? &c->chan[active[i + 1]] : NULL;
+        buf = i & 1;
+
+        if (next) {
+            convLoad(c, next, in + (active[i + 1] - first), stride);
+        }
+        convMac(c->acc[buf], ch->filter, ch->fdl + ch->head * PCONV_BINS);
+        c->fft.wait(c->fft.usr);
+
+        c->fft.irfft(c->fft.usr, c->acc[buf], c->y);
+        if (next) {
+            convTail(next, c->acc[buf ^ 1]);
+        }
+        c->fft.wait(c->fft.usr);
+
+        convStore(c, out + (active[i] - first), stride);
+    }
+}
+
+/***********************************************************************
+ * Software FFT
+ **********************************************************************/
+static void softCfft(PCONV_SOFT_FFT *s, bool inverse)
+{
+    complex_float *z = s->z;
+    complex_float t, u, w;
+    unsigned i, j, k, len, step;
+
+    for (i = 1, j = 0; i < M; i++) {
+        k = M >> 1;
+        while (j & k) {
+            j ^= k;
+            k >>= 1;
+        }
+        j |= k;
+        if (i < j) {
+            t = z[i]; z[i] = z[j]; z[j] = t;
+        }
+    }
+
+    for (len = 2; len <= M; len <<= 1) {
+        step = N / len;
+        for (i = 0; i < M; i += len) {
+            for (j = 0; j < len / 2; j++) {
+                w = s->tw[j * step];
+                if (inverse) {
+                    w.im = -w.im;
+                }
+                u = z[i + j];
+                k = i + j + len / 2;
+                t.re = (z[k].re * w.re) - (z[k].im * w.im);
+                t.im = (z[k].re * w.im) + (z[k].im * w.re);
+                z[i + j].re = u.re + t.re;
+                z[i + j].im = u.im + t.im;
+                z[k].re = u.re - t.re;
+                z[k].im = u.im - t.im;
+            }
+        }
+    }
+}
+
+/* Even samples real, odd imaginary, then the two halves split apart */
+static void softRfft(void *usr, const float *in, complex_float *out)
+{
+    PCONV_SOFT_FFT *s = usr;
+    complex_float a, b, e, o, w;
+    unsigned k;
+
+    for (k = 0; k < M; k++) {
+        s->z[k].re = in[2 * k];
+        s->z[k].im = in[2 * k + 1];
+    }
+    softCfft(s, false);
+
+    out[0].re = s->z[0].re + s->z[0].im;
+    out[0].im = 0.0f;
+    out[M].re = s->z[0].re - s->z[0].im;
+    out[M].im = 0.0f;
+    for (k = 1; k < M; k++) {
+        a = s->z[k];
+        b.re = s->z[M - k].re; b.im = -s->z[M - k].im;
+        e.re = 0.5f * (a.re + b.re);
+        e.im = 0.5f * (a.im + b.im);
+        o.re = 0.5f * (a.im - b.im);
+        o.im = -0.5f * (a.re - b.re);
+        w = s->tw[k];
+        out[k].re = e.re + (w.re * o.re) - (w.im * o.im);
+        out[k].im = e.im + (w.re * o.im) + (w.im * o.re);
+    }
+}
+
+static void softIrfft(void *usr, const complex_float *in, float *out)
+{
+    PCONV_SOFT_FFT *s = usr;
+    complex_float a, b, e, d, o, w;
+    unsigned k;
+
+    for (k = 0; k < M; k++) {
+        a = in[k];
+        b.re = in[M - k].re; b.im = -in[M - k].im;
+        e.re = a.re + b.re;
+        e.im = a.im + b.im;
+        d.re = a.re - b.re;
+        d.im = a.im - b.im;
+        w = s->tw[k];
+        o.re = (d.re * w.re) + (d.im * w.im);
+        o.im = (d.im * w.re) - (d.re * w.im);
+        s->z[k].re = e.re - o.im;
+        s->z[k].im = e.im + o.re;
+    }
+    softCfft(s, true);
+
+    for (k = 0; k < M; k++) {
+        out[2 * k] = s->z[k].re;
+        out[2 * k + 1] = s->z[k].im;
+    }
+}
+
+static void softWait(void *usr)
+{
+}
+
+void pconv_soft_fft_init(PCONV_SOFT_FFT *s, PCONV_FFT *fft)
+{
+    unsigned k;
+
+    for (k = 0; k < M; k++) {
+        s->tw[k].re = cosf((float)(2.0 * M_PI * k / N));
+        s->tw[k].im = -sinf((float)(2.0 * M_PI * k / N));
+    }
+
+    fft->rfft = softRfft;
+    fft->irfft = softIrfft;
+    fft->wait = softWait;
+    fft->usr = s;
+}
+
+/***********************************************************************
+ * FFT accelerator
+ **********************************************************************/
+#if defined(__ADSPSC589_FAMILY__) && defined(__ADSP21000__)
+
+/*
+ * One N point complex pipe runs both directions, so it's opened once
+ * and never reconfigured between the forward and inverse transforms of
+ * a block.  The forward transform takes the samples as the real part,
+ * the unscaled inverse is the real part of the forward transform of
+ * the conjugate spectrum.  Spectra are staged in 'in' and results in
+ * 'buf', the engine only keeps PCONV_BINS bins.  Sizes are in 32-bit
+ * words.
+ */
+static void accelStart(PCONV_ACCEL_FFT *a)
+{
+    if (a->h == NULL) {
+        a->h = accel_cfft_small_pipe(&a->mem, 1.0f, N);
+        a->enabled = false;
+    }
+    adi_fft_SubmitRxBuffer(a->h, a->buf, 2 * N);
+    adi_fft_SubmitTxBuffer(a->h, a->in, 2 * N);
+    if (!a->enabled) {
+        adi_fft_EnableRx(a->h, true);
+        adi_fft_EnableTx(a->h, true);
+        a->enabled = true;
+    }
+    a->busy = true;
+}
+
+static void accelRfft(void *usr, const float *in, complex_float *out)
+{
+    PCONV_ACCEL_FFT *a = usr;
+    unsigned k;
+
+    for (k = 0; k < N; k++) {
+        a->in[k].re = in[k];
+        a->in[k].im = 0.0f;
+    }
+    a->outBins = out;
+    a->outReal = NULL;
+    accelStart(a);
+}
+
+static void accelIrfft(void *usr, const complex_float *in, float *out)
+{
+    PCONV_ACCEL_FFT *a = usr;
+    unsigned k;
+
+    /* Conjugated, the negative bins are the positive ones unconjugated */
+    for (k = 0; k < PCONV_BINS; k++) {
+        a->in[k].re = in[k].re;
+        a->in[k].im = -in[k].im;
+    }
+    for (k = PCONV_BINS; k < N; k++) {
+        a->in[k] = in[N - k];
+    }
+    a->outBins = NULL;
+    a->outReal = out;
+    accelStart(a);
+}
+
+static void accelWait(void *usr)
+{
+    PCONV_ACCEL_FFT *a = usr;
+    void *done;
+    unsigned k;
+
+    if (!a->busy) {
+        return;
+    }
+    adi_fft_GetTxBuffer(a->h, &done);
+    adi_fft_GetRxBuffer(a->h, &done);
+    if (a->outBins) {
+        memcpy(a->outBins, a->buf, PCONV_BINS * sizeof(complex_float));
+    } else {
+        for (k = 0; k < N; k++) {
+            a->outReal[k] = a->buf[k].re;
+        }
+    }
+    a->busy = false;
+}
+
+void pconv_accel_fft_init(PCONV_ACCEL_FFT *a, PCONV_FFT *fft)
+{
+    memset(a, 0, sizeof(*a));
+
+    fft->rfft = accelRfft;
+    fft->irfft = accelIrfft;
+    fft->wait = accelWait;
+    fft->usr = a;
+}
+
+void pconv_accel_fft_reset(PCONV_ACCEL_FFT *a)
+{
+    if (a->h) {
+        adi_fft_Close(a->h);
+        a->h = NULL;
+    }
+    a->enabled = false;
+    a->busy = false;
+}
+
+#endif
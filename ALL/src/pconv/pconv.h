@@ -0,0 +1,170 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _pconv_h
+#define _pconv_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "adi_fft_wrapper.h"
+
+/*
+ * Uniformly partitioned overlap-save convolver.
+ *
+ * The impulse response is cut into PCONV_BLOCK long partitions and
+ * each is held as the spectrum of a PCONV_FFT_SIZE point transform.
+ * Every block the new input is transformed once into a frequency
+ * domain delay line and the output spectrum is the sum of each
+ * partition times the input spectrum that many blocks old.  The cost
+ * per block is two transforms plus one complex multiply-add per bin
+ * and partition, against PCONV_BLOCK multiply-adds per tap and sample
+ * in the time domain.  There is no added latency.
+ *
+ * Transforms go through a PCONV_FFT so they can run on the FFT
+ * accelerator.  A backend only ever has one transform in flight.  The
+ * engine starts it, works on the partitions that don't need its result,
+ * then waits.
+ */
+#ifndef PCONV_BLOCK
+#define PCONV_BLOCK          (64)
+#endif
+
+#ifndef PCONV_MAX_CHANNELS
+#define PCONV_MAX_CHANNELS   (8)
+#endif
+
+#define PCONV_FFT_SIZE       (2 * PCONV_BLOCK)
+#define PCONV_BINS           (PCONV_BLOCK + 1)
+
+/* Bytes of memory for 'channels' channels of up to 'parts' partitions */
+#define PCONV_MEM_SIZE(parts, channels) \
+    ((size_t)(channels) * \
+        ((2 * (size_t)(parts) * PCONV_BINS * sizeof(complex_float)) + \
+        (PCONV_FFT_SIZE * sizeof(float))))
+
+/* Partitions for 'taps' taps */
+#define PCONV_PARTS(taps)    (((taps) + PCONV_BLOCK - 1) / PCONV_BLOCK)
+
+/*
+ * Transform backend.  'rfft' starts a PCONV_FFT_SIZE point real FFT
+ * with PCONV_BINS bins out, 'irfft' its inverse.  Neither scales, so
+ * a round trip gains PCONV_FFT_SIZE.  'wait' returns once the last
+ * transform started has finished.
+ */
+typedef struct PCONV_FFT {
+    void (*rfft)(void *usr, const float *in, complex_float *out);
+    void (*irfft)(void *usr, const complex_float *in, float *out);
+    void (*wait)(void *usr);
+    void *usr;
+} PCONV_FFT;
+
+typedef struct PCONV_CHANNEL {
+    float *x;                   /* Last PCONV_FFT_SIZE input samples */
+    complex_float *fdl;         /* Input spectra, one per partition */
+    complex_float *filter;      /* Partition spectra, scaled by 1/N */
+    uint16_t head;              /* FDL slot of the newest input */
+    uint16_t parts;             /* 0 passes the channel through */
+} PCONV_CHANNEL;
+
+typedef struct PCONV {
+    PCONV_FFT fft;
+    unsigned channels;
+    unsigned maxParts;
+    PCONV_CHANNEL chan[PCONV_MAX_CHANNELS];
+    complex_float acc[2][PCONV_BINS];
+    float y[PCONV_FFT_SIZE];
+} PCONV;
+
+/*
+ * Sets up 'channels' channels of up to 'maxParts' partitions in 'mem'
+ * of at least PCONV_MEM_SIZE(maxParts, channels) bytes.  Every channel
+ * starts out passing through.
+ */
+bool pconv_init(PCONV *c, void *mem, size_t size, unsigned channels,
+    unsigned maxParts, const PCONV_FFT *fft);
+
+/*
+ * Loads a 'taps' long impulse response on 'channel' and clears its
+ * history.  0 taps passes the channel through.  Runs the transforms
+ * to completion, so call it between blocks.  Returns false if 'taps'
+ * is over the partitions in 'mem', the response is then truncated.
+ */
+bool pconv_set_ir(PCONV *c, unsigned channel, const float *ir,
+    unsigned taps);
+
+/*
+ * The same a piece at a time, for responses too long to hold at once.
+ * Transforms taps 'offset' up to 'offset + taps' of 'channel's next
+ * response, 'offset' a multiple of PCONV_BLOCK and every piece but the
+ * last whole partitions.  The channel passes through from the first
+ * piece until pconv_set_taps() puts it on the loaded response.  Must
+ * not run alongside pconv_process(), they share the transform buffer.
+ */
+bool pconv_load_ir(PCONV *c, unsigned channel, unsigned offset,
+    const float *ir, unsigned taps);
+void pconv_set_taps(PCONV *c, unsigned channel, unsigned taps);
+
+/* Clears the history of every channel */
+void pconv_reset(PCONV *c);
+
+/*
+ * Switches transform backend between blocks, for one core sharing the
+ * accelerator with others.
+ */
+void pconv_set_fft(PCONV *c, const PCONV_FFT *fft);
+
+/*
+ * Filters one PCONV_BLOCK frame block of channels 'first' up to
+ * 'last'.  'in' and 'out' point at channel 'first' of the first frame,
+ * 'stride' floats apart from frame to frame.  They may be the same.
+ */
+void pconv_process(PCONV *c, unsigned first, unsigned last,
+    const float *in, float *out, unsigned stride);
+
+/*
+ * Portable software backend, radix-2 with the real transforms done as
+ * a half size complex one.  Finishes each transform when started.
+ */
+typedef struct PCONV_SOFT_FFT {
+    complex_float tw[PCONV_FFT_SIZE / 2];
+    complex_float z[PCONV_FFT_SIZE / 2];
+} PCONV_SOFT_FFT;
+
+void pconv_soft_fft_init(PCONV_SOFT_FFT *s, PCONV_FFT *fft);
+
+#if defined(__ADSPSC589_FAMILY__) && defined(__ADSP21000__)
+/*
+ * FFT accelerator backend.  Uses the accelerator's continuous (pipe)
+ * mode so a transform runs while the core carries on, with one complex
+ * pipe for both directions so it's only set up once.  The accelerator
+ * is a single shared block, a core must hold it for as long as this
+ * backend runs.
+ */
+typedef struct PCONV_ACCEL_FFT {
+    ADI_FFT_DEVICE_MEMORY mem;
+    ADI_FFT_HANDLE h;
+    bool enabled;
+    bool busy;
+    complex_float *outBins;
+    float *outReal;
+    complex_float in[PCONV_FFT_SIZE];
+    complex_float buf[PCONV_FFT_SIZE];
+} PCONV_ACCEL_FFT;
+
+void pconv_accel_fft_init(PCONV_ACCEL_FFT *a, PCONV_FFT *fft);
+
+/* Drops the pipe, after another core has set the accelerator up */
+void pconv_accel_fft_reset(PCONV_ACCEL_FFT *a);
+#endif
+
+#endif
@@ -0,0 +1,160 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "trace_log.h"
+
+/*
+ * Slot reservation and store ordering.  GCC (ARM) has atomics.  On the
+ * SHARCs all writers run at one interrupt level and stores to shared
+ * L2 complete in program order.
+ */
+#if defined(__GNUC__)
+#define TRACE_LOG_RESERVE(p)   __atomic_fetch_add(p, 1, __ATOMIC_RELAXED)
+#define TRACE_LOG_BARRIER()    __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#define TRACE_LOG_RESERVE(p)   ((*(p))++)
+#define TRACE_LOG_BARRIER()
+#endif
+
+#define TRACE_LOG_FMT_STR(id, fmt) fmt,
+static const char * const traceLogFormats[TRACE_ID_MAX] = {
+    TRACE_LOG_FORMATS(TRACE_LOG_FMT_STR)
+};
+
+/* This core's log */
+static TRACE_LOG *myLog = NULL;
+
+/* Logs readable from this core */
+static TRACE_LOG *traceLogs[TRACE_LOG_MAX_CORES];
+
+TRACE_LOG *trace_log_init(void *mem, unsigned entries, unsigned core)
+{
+    TRACE_LOG *log = (TRACE_LOG *)mem;
+
+    if ((log == NULL) || (entries == 0) || (entries & (entries - 1))) {
+        return(NULL);
+    }
+
+    memset(log, 0, TRACE_LOG_SIZE(entries));
+    log->core = core;
+    log->entries = entries;
+    log->magic = TRACE_LOG_MAGIC;
+
+    myLog = log;
+    trace_log_attach(log);
+
+    return(log);
+}
+
+void trace_log_write(TRACE_LOG_ID id, unsigned nargs,
+    uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
+{
+    TRACE_LOG *log = myLog;
+    TRACE_LOG_ENTRY *e;
+    uint32_t idx;
+
+    if (log == NULL) {
+        return;
+    }
+
+    idx = TRACE_LOG_RESERVE(&log->head);
+    e = &log->entry[idx & (log->entries - 1)];
+
+    /* Invalidate the slot while it is filled in */
+    e->seq = 0;
+    TRACE_LOG_BARRIER();
+
+    e->timestamp = TRACE_LOG_TIMESTAMP();
+    e->id = id;
+    e->nargs = nargs;
+    e->args[0] = a0;
+    e->args[1] = a1;
+    e->args[2] = a2;
+    e->args[3] = a3;
+
+    TRACE_LOG_BARRIER();
+    e->seq = idx + 1;
+}
+
+bool trace_log_attach(TRACE_LOG *log)
+{
+    if ((log == NULL) || (log->magic != TRACE_LOG_MAGIC) ||
+        (log->core >= TRACE_LOG_MAX_CORES)) {
+        return(false);
+    }
+    traceLogs[log->core] = log;
+    return(true);
+}
+
+TRACE_LOG *trace_log_get(unsigned core)
+{
+    return((core < TRACE_LOG_MAX_CORES) ? traceLogs[core] : NULL);
+}
+
+bool trace_log_read(TRACE_LOG *log, TRACE_LOG_ENTRY *entry)
+{
+    TRACE_LOG_ENTRY *e;
+    uint32_t head;
+    uint32_t seq;
+
+    while (1) {
+        head = log->head;
+        if (head == log->tail) {
+            return(false);
+        }
+
+        /* Skip whatever the writer has already lapped */
+        if ((head - log->tail) > log->entries) {
+            log->lost += head - log->tail - log->entries;
+            log->tail = head - log->entries;
+        }
+
+        e = &log->entry[log->tail & (log->entries - 1)];
+        seq = e->seq;
+        if (seq != (log->tail + 1)) {
+            if ((seq != 0) && ((int32_t)(seq - (log->tail + 1)) > 0)) {
+                /* Overwritten by a later lap */
+                log->lost++;
+                log->tail++;
+                continue;
+            }
+            /* Reserved but not committed yet */
+            return(false);
+        }
+
+        memcpy(entry, e, sizeof(*entry));
+        TRACE_LOG_BARRIER();
+
+        /* Overwritten while being copied */
+        if (e->seq != seq) {
+            log->lost++;
+            log->tail++;
+            continue;
+        }
+
+        log->tail++;
+        return(true);
+    }
+}
+
+int trace_log_format(const TRACE_LOG_ENTRY *entry, char *buf, size_t max)
+{
+    if (entry->id >= TRACE_ID_MAX) {
+        return(snprintf(buf, max, "Unknown trace ID %u", (unsigned)entry->id));
+    }
+
+    return(snprintf(buf, max, traceLogFormats[entry->id],
+        entry->args[0], entry->args[1], entry->args[2], entry->args[3]));
+}
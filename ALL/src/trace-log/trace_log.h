@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _trace_log_h
+#define _trace_log_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "trace_log_cfg.h"
+
+/*
+ * Binary trace log.
+ *
+ * Each core writes into its own log.  Writers never block or take a
+ * lock so tracing is safe from any ISR.  On the ARM slots are reserved
+ * with an atomic increment.  On the SHARCs writers must all run at the
+ * same interrupt level.  When full the oldest entries are overwritten.
+ *
+ * Only a format ID, the timestamp and raw integer arguments are stored.
+ * Formatting happens later in the reader, which runs on the ARM and
+ * also reads the SHARC logs through shared L2.
+ */
+#define TRACE_LOG_MAGIC     (0x54524345)
+#define TRACE_LOG_MAX_ARGS  (4)
+
+#define TRACE_LOG_ID_ENUM(id, fmt) id,
+typedef enum TRACE_LOG_ID {
+    TRACE_LOG_FORMATS(TRACE_LOG_ID_ENUM)
+    TRACE_ID_MAX
+} TRACE_LOG_ID;
+
+/*
+ * 'seq' is the slot's reservation index + 1, written last.  The reader
+ * uses it to detect entries in progress or overwritten.
+ */
+typedef struct TRACE_LOG_ENTRY {
+    volatile uint32_t seq;
+    uint32_t timestamp;
+    uint16_t id;
+    uint16_t nargs;
+    uint32_t args[TRACE_LOG_MAX_ARGS];
+} TRACE_LOG_ENTRY;
+
+typedef struct TRACE_LOG {
+    uint32_t magic;
+    uint32_t core;
+    uint32_t entries;
+    volatile uint32_t head;
+    uint32_t tail;
+    uint32_t lost;
+    TRACE_LOG_ENTRY entry[];
+} TRACE_LOG;
+
+/* Bytes needed for a log of 'entries' entries */
+#define TRACE_LOG_SIZE(entries) \
+    (sizeof(TRACE_LOG) + (entries) * sizeof(TRACE_LOG_ENTRY))
+
+/*
+ * Initializes a log in 'mem' of TRACE_LOG_SIZE(entries) bytes and makes
+ * it this core's log.  'entries' must be a power of 2.
+ */
+TRACE_LOG *trace_log_init(void *mem, unsigned entries, unsigned core);
+
+/* Writes an entry to this core's log.  Safe from any context. */
+void trace_log_write(TRACE_LOG_ID id, unsigned nargs,
+    uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+
+#define TRACE_LOG0(id) \
+    trace_log_write(id, 0, 0, 0, 0, 0)
+#define TRACE_LOG1(id, a0) \
+    trace_log_write(id, 1, (uint32_t)(a0), 0, 0, 0)
+#define TRACE_LOG2(id, a0, a1) \
+    trace_log_write(id, 2, (uint32_t)(a0), (uint32_t)(a1), 0, 0)
+#define TRACE_LOG3(id, a0, a1, a2) \
+    trace_log_write(id, 3, (uint32_t)(a0), (uint32_t)(a1), (uint32_t)(a2), 0)
+#define TRACE_LOG4(id, a0, a1, a2, a3) \
+    trace_log_write(id, 4, (uint32_t)(a0), (uint32_t)(a1), (uint32_t)(a2), \
+        (uint32_t)(a3))
+
+/*
+ * Reader side (single reader per log).
+ *
+ * trace_log_attach() registers another core's log for reading.
+ * trace_log_get() returns the log registered for 'core' or NULL.
+ * trace_log_read() copies out the oldest committed entry and returns
+ * false when there is none.  Entries overwritten before they could be
+ * read are counted in the log's 'lost' field.
+ * trace_log_format() formats an entry's message into 'buf'.
+ */
+bool trace_log_attach(TRACE_LOG *log);
+TRACE_LOG *trace_log_get(unsigned core);
+bool trace_log_read(TRACE_LOG *log, TRACE_LOG_ENTRY *entry);
+int trace_log_format(const TRACE_LOG_ENTRY *entry, char *buf, size_t max);
+
+#endif
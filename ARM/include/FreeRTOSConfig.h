@@ -105,6 +105,9 @@ uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
 #define configUSE_QUEUE_SETS                    1
 #define configNUM_THREAD_LOCAL_STORAGE_POINTERS 16
 
+/* Index 1 is the FFT queue's (fft_queue_cfg.h), 0 is the task's own */
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES   2
+
 /*
  * Application and minimal OSAL TLS defines (not used by FreeRTOS).
  * The minimal OSAL expects its TLS pointers to start at
@@ -143,10 +146,41 @@ to exclude the API function. */
 #define INCLUDE_eTaskGetState                   1
 #define INCLUDE_uxTaskGetStackHighWaterMark     1
 #define INCLUDE_xTaskGetIdleTaskHandle          1
+#define INCLUDE_xTaskGetCurrentTaskHandle       1
 
 /* Task switch hook for idle time calculations */
 void taskSwitchHook(void *taskHandle);
-#define traceTASK_SWITCHED_IN()  taskSwitchHook(pxCurrentTCB)
+
+/* Scheduler timeline trace hooks (sched_trace.h) */
+#include "sched_trace.h"
+
+#define traceTASK_SWITCHED_IN() \
+    do { \
+        taskSwitchHook(pxCurrentTCB); \
+        SCHED_TRACE(SCHED_TRACE_TASK_IN, pxCurrentTCB, pxCurrentTCB->uxPriority); \
+    } while (0)
+#define traceTASK_CREATE(pxNewTCB) \
+    sched_trace_task_create(pxNewTCB, pxNewTCB->pcTaskName)
+#define traceTASK_DELETE(pxTCB) \
+    sched_trace_task_delete(pxTCB)
+#define traceTASK_NOTIFY(uxIndexToNotify) \
+    SCHED_TRACE(SCHED_TRACE_NOTIFY, pxTCB, uxIndexToNotify)
+#define traceTASK_NOTIFY_FROM_ISR(uxIndexToNotify) \
+    SCHED_TRACE(SCHED_TRACE_NOTIFY, pxTCB, uxIndexToNotify)
+#define traceTASK_NOTIFY_GIVE_FROM_ISR(uxIndexToNotify) \
+    SCHED_TRACE(SCHED_TRACE_NOTIFY, pxTCB, uxIndexToNotify)
+#define traceTASK_NOTIFY_TAKE_BLOCK(uxIndexToWait) \
+    SCHED_TRACE(SCHED_TRACE_NOTIFY_WAIT, uxIndexToWait, 0)
+#define traceTASK_NOTIFY_WAIT_BLOCK(uxIndexToWait) \
+    SCHED_TRACE(SCHED_TRACE_NOTIFY_WAIT, uxIndexToWait, 0)
+#define traceTASK_PRIORITY_INHERIT(pxTCBOfMutexHolder, uxInheritedPriority) \
+    SCHED_TRACE(SCHED_TRACE_PRIORITY_INHERIT, pxTCBOfMutexHolder, uxInheritedPriority)
+#define traceTASK_PRIORITY_DISINHERIT(pxTCBOfMutexHolder, uxOriginalPriority) \
+    SCHED_TRACE(SCHED_TRACE_PRIORITY_DISINHERIT, pxTCBOfMutexHolder, uxOriginalPriority)
+
+/* Called by the IRQ dispatcher around every interrupt handler */
+#define traceISR_ENTER(iid)  SCHED_TRACE(SCHED_TRACE_ISR_ENTER, iid, 0)
+#define traceISR_EXIT(iid)   SCHED_TRACE(SCHED_TRACE_ISR_EXIT, iid, 0)
 
 /* Enable FPU context support in all tasks.  This also config option also
  * enables FPU context support in the ISRs if configUSE_TASK_FPU_SUPPORT > 0.
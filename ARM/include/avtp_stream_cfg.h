@@ -0,0 +1,21 @@
+/**
+ * Copyright (c) 2022 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _avtp_cfg_h
+#define _avtp_cfg_h
+
+/* SR class A maximum transit time (ns) */
+#define AVTP_DEFAULT_TRANSIT_TIME    (2000000)
+
+/* 8 frames @ 48kHz is one packet per 166us */
+#define AVTP_DEFAULT_FRAMES_PER_PKT  (8)
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _fft_queue_cfg_h
+#define _fft_queue_cfg_h
+
+/*
+ * Job priorities, 0 is the most urgent.  Live DSP, display and
+ * background analysis each get their own.
+ */
+#define FFT_QUEUE_PRIORITIES        (3)
+
+/* Most jobs started together as one batch */
+#define FFT_QUEUE_BATCH             (8)
+
+/*
+ * Only transforms up to this many points are batched.  Larger ones
+ * run long enough that batching gains nothing and would only hold up
+ * more urgent jobs.
+ */
+#define FFT_QUEUE_BATCH_MAX_POINTS  (1024)
+
+/* Job timestamps, same timebase as the trace log */
+#ifndef FFT_QUEUE_TIMESTAMP
+#include <sys/platform.h>
+#define FFT_QUEUE_TIMESTAMP()       (*pREG_CGU0_TSCOUNT0)
+#endif
+
+/*
+ * Queue lock.  Jobs are submitted, cancelled and waited on from tasks
+ * and only the owner task starts and finishes them, so a task critical
+ * section is enough.
+ *
+ * The owner and waiting producers sleep on a task notification index
+ * of their own so they never take one meant for something else.
+ * FFT_QUEUE_IDLE() runs between the owner's polls of a running batch,
+ * FFT_QUEUE_BACKOFF() when the backend is waiting on the other core.
+ * The owner takes on the priority of the tasks it is working for.
+ */
+#ifndef FFT_QUEUE_LOCK
+#include "FreeRTOS.h"
+#include "task.h"
+#define FFT_QUEUE_LOCK()            taskENTER_CRITICAL()
+#define FFT_QUEUE_UNLOCK()          taskEXIT_CRITICAL()
+#define FFT_QUEUE_NOTIFY_INDEX      (1)
+#define FFT_QUEUE_TASK              TaskHandle_t
+#define FFT_QUEUE_SELF()            xTaskGetCurrentTaskHandle()
+#define FFT_QUEUE_WAKE(t) \
+    xTaskNotifyGiveIndexed(t, FFT_QUEUE_NOTIFY_INDEX)
+#define FFT_QUEUE_SLEEP() \
+    ulTaskNotifyTakeIndexed(FFT_QUEUE_NOTIFY_INDEX, pdTRUE, portMAX_DELAY)
+#define FFT_QUEUE_IDLE()            taskYIELD()
+#define FFT_QUEUE_BACKOFF()         vTaskDelay(1)
+#define FFT_QUEUE_PRIORITY_T        UBaseType_t
+#define FFT_QUEUE_PRIORITY()        uxTaskPriorityGet(NULL)
+#define FFT_QUEUE_SET_PRIORITY(t, p) vTaskPrioritySet(t, p)
+#endif
+
+#endif
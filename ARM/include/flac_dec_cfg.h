@@ -0,0 +1,35 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _flac_dec_cfg_h
+#define _flac_dec_cfg_h
+
+#include "umm_malloc.h"
+
+/*
+ * Largest block size and channel count accepted from STREAMINFO.  The
+ * decoded block buffers (channels * max block size * 4 bytes) come from
+ * SDRAM when a file is opened.  4608 is the FLAC streamable subset limit
+ * which covers all common encoder settings.
+ */
+#define FLAC_DEC_MAX_BLOCK_SIZE   (4608)
+#define FLAC_DEC_MAX_CHANNELS     (8)
+
+/* Compressed input buffer, refilled from the file one read at a time */
+#define FLAC_DEC_IN_BUF_SIZE      (4 * 1024)
+
+/* Set to 0 to skip the per-frame CRC-16 check */
+#define FLAC_DEC_CHECK_CRC16      1
+
+#define FLAC_DEC_CALLOC(x,y)      umm_calloc_heap(UMM_SDRAM_HEAP, x, y)
+#define FLAC_DEC_FREE(x)          umm_free_heap(UMM_SDRAM_HEAP, x)
+
+#endif
@@ -0,0 +1,32 @@
+/**
+ * Copyright (c) 2022 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _gptp_cfg_h
+#define _gptp_cfg_h
+
+/* Offset (ns) below which the servo counts a sync as good */
+#define GPTP_LOCK_THRESHOLD              (1000)
+
+/* Consecutive good syncs needed to report lock */
+#define GPTP_LOCK_COUNT                  (8)
+
+/* Offset (ns) above which the mapping is stepped instead of slewed */
+#define GPTP_STEP_THRESHOLD              (1000000)
+
+/* 802.1AS syncReceiptTimeout and announceReceiptTimeout (ns) */
+#define GPTP_SYNC_TIMEOUT                (375000000ULL)
+#define GPTP_ANNOUNCE_TIMEOUT            (3000000000ULL)
+
+/* Pdelay_Req interval (ns) and asCapable path delay limit (ns) */
+#define GPTP_PDELAY_INTERVAL             (1000000000ULL)
+#define GPTP_NEIGHBOR_PROP_DELAY_THRESH  (800)
+
+#endif
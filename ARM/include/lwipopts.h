@@ -31,6 +31,13 @@
 #define DEFAULT_TCP_RECVMBOX_SIZE       64
 #define DEFAULT_ACCEPTMBOX_SIZE         10
 
+/* Core locking.  Rx frames are input directly from the netif worker
+ * thread instead of being posted to the tcpip thread, and the RTP/VBAN
+ * raw API streams lock the core to send.
+ */
+#define LWIP_TCPIP_CORE_LOCKING         1
+#define LWIP_TCPIP_CORE_LOCKING_INPUT   1
+
 /* Enable APIs */
 #define LWIP_NETIF_API                  1
 #define LWIP_RAW                        0
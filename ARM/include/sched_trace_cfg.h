@@ -0,0 +1,43 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _SCHED_TRACE_CFG_H
+#define _SCHED_TRACE_CFG_H
+
+/* Set to 0 to compile the scheduler trace hooks out entirely */
+#define SCHED_TRACE_ENABLE         1
+
+/*
+ * Events in the capture ring.  Must be a power of 2.  Each event is
+ * 16 bytes so the default ring uses 1MB of SDRAM, allocated on the
+ * first 'sched start'.
+ */
+#define SCHED_TRACE_ENTRIES        (65536)
+
+/* Task names remembered for the export */
+#define SCHED_TRACE_MAX_TASKS      (48)
+
+#define SCHED_TRACE_HEAP           UMM_SDRAM_HEAP
+#define SCHED_TRACE_MALLOC(x)      umm_malloc_heap(SCHED_TRACE_HEAP, x)
+#define SCHED_TRACE_FREE(x)        umm_free_heap(SCHED_TRACE_HEAP, x)
+
+/* Event timestamps, same timebase as the cpu load and trace log */
+#ifndef SCHED_TRACE_TIMESTAMP
+#define SCHED_TRACE_TIMESTAMP()    (*pREG_CGU0_TSCOUNT0)
+#endif
+#define SCHED_TRACE_TIMESTAMP_HZ   (CGU_TS_CLK)
+
+/* Export file write buffer */
+#define SCHED_TRACE_FILE_BUF_SIZE  (16 * 1024)
+
+#define SCHED_TRACE_DEFAULT_FILE   "sd:sched_trace.json"
+
+#endif
@@ -18,13 +18,18 @@
 
 /* The priorities assigned to the tasks (higher number == higher prio). */
 #define HOUSEKEEPING_PRIORITY       (tskIDLE_PRIORITY + 1)
+#define FFT_QUEUE_TASK_PRIORITY     (tskIDLE_PRIORITY + 1)
 #define STARTUP_TASK_LOW_PRIORITY   (tskIDLE_PRIORITY + 1)
+#define TRACE_TASK_PRIORITY         (tskIDLE_PRIORITY + 1)
 #define TELNET_TASK_PRIORITY        (tskIDLE_PRIORITY + 2)
 #define VU_TASK_PRIORITY            (tskIDLE_PRIORITY + 2)
+#define TRACK_CACHE_TASK_PRIORITY   (tskIDLE_PRIORITY + 2)
 #define UAC20_TASK_PRIORITY         (tskIDLE_PRIORITY + 3)
 #define WAV_TASK_PRIORITY           (tskIDLE_PRIORITY + 3)
 #define RTP_TASK_PRIORITY           (tskIDLE_PRIORITY + 3)
 #define VBAN_TASK_PRIORITY          (tskIDLE_PRIORITY + 3)
+#define AVTP_TASK_PRIORITY          (tskIDLE_PRIORITY + 4)
+#define GPTP_TASK_PRIORITY          (tskIDLE_PRIORITY + 4)
 #define ETHERNET_PRIORITY           (tskIDLE_PRIORITY + 4)
 #define ETHER_WORKER_PRIO           (tskIDLE_PRIORITY + 4)
 #define A2B_IRQ_TASK_PRIORITY       (tskIDLE_PRIORITY + 4)
@@ -36,9 +41,14 @@
 #define TELNET_TASK_STACK_SIZE       (configMINIMAL_STACK_SIZE + 8192)
 #define UAC20_TASK_STACK_SIZE        (configMINIMAL_STACK_SIZE + 1024)
 #define VU_TASK_STACK_SIZE           (configMINIMAL_STACK_SIZE + 128)
+#define TRACE_TASK_STACK_SIZE        (configMINIMAL_STACK_SIZE + 256)
 #define WAV_TASK_STACK_SIZE          (configMINIMAL_STACK_SIZE + 128)
+#define TRACK_CACHE_TASK_STACK_SIZE  (configMINIMAL_STACK_SIZE + 128)
 #define RTP_TASK_STACK_SIZE          (configMINIMAL_STACK_SIZE + 256)
 #define VBAN_TASK_STACK_SIZE         (configMINIMAL_STACK_SIZE + 256)
+#define FFT_QUEUE_TASK_STACK_SIZE    (configMINIMAL_STACK_SIZE + 256)
+#define AVTP_TASK_STACK_SIZE         (configMINIMAL_STACK_SIZE + 256)
+#define GPTP_TASK_STACK_SIZE         (configMINIMAL_STACK_SIZE + 256)
 #define ETHERNET_TASK_STACK_SIZE     (configMINIMAL_STACK_SIZE + 256)
 #define TCPIP_THREAD_STACKSIZE       (configMINIMAL_STACK_SIZE + 256)
 #define GENERIC_TASK_STACK_SIZE      (configMINIMAL_STACK_SIZE)
@@ -0,0 +1,36 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _track_cache_cfg_h
+#define _track_cache_cfg_h
+
+#include "umm_malloc.h"
+
+/*
+ * SDRAM set aside for cached audio.  Regions are allocated on first use
+ * so an idle cache costs nothing, and whatever the heap can't supply
+ * is simply never cached.
+ */
+#define TRACK_CACHE_SIZE           (8 * 1024 * 1024)
+
+/* Unit of residency and eviction, one SD read per region */
+#define TRACK_CACHE_REGION_SIZE    (256 * 1024)
+
+/* Playing track regions kept loaded ahead of the read position */
+#define TRACK_CACHE_READ_AHEAD     (4)
+
+/* Playing, queued and recently played tracks tracked at once */
+#define TRACK_CACHE_MAX_TRACKS     (4)
+
+#define TRACK_CACHE_CALLOC(x,y)    umm_calloc_heap(UMM_SDRAM_HEAP, x, y)
+#define TRACK_CACHE_FREE(x)        umm_free_heap(UMM_SDRAM_HEAP, x)
+
+#endif
@@ -18,11 +18,36 @@
 #include "umm_malloc_heaps.h"
 
 #define UMM_INFO
+
+/*
+ * Per-operation heap integrity and poison checks walk the heap and are
+ * far too slow to leave on while streaming.  Build with HEAP_DEBUG=yes
+ * (-DUMM_DEBUG) to enable them.
+ */
+#ifdef UMM_DEBUG
 #define UMM_INTEGRITY_CHECK
 #define UMM_POISON_CHECK
+#endif
 
 #define UMM_BLOCK_SIZE    64
 
+/*
+ * Allocation latency is measured with the CPU load timestamp counter
+ */
+#ifdef FREE_RTOS
+    #include "cpu_load.h"
+    #define UMM_TIMESTAMP()          cpuLoadGetTimeStamp()
+    #define UMM_TIMESTAMP_TO_US(x)   cpuLoadCyclesToMicrosecond(x)
+#endif
+
+/*
+ * TLSF (two-level segregated fit) backend.  Heaps larger than
+ * 1 << UMM_TLSF_FL_INDEX_MAX bytes only use the first part.  Each first
+ * level range is split into 1 << UMM_TLSF_SL_INDEX_COUNT_LOG2 classes.
+ */
+#define UMM_TLSF_FL_INDEX_MAX         25
+#define UMM_TLSF_SL_INDEX_COUNT_LOG2  4
+
 /*
  * End SAM specific configuration for umm_malloc
  */
@@ -113,6 +138,15 @@
     unsigned int freeBlocks;
 
     unsigned int maxFreeContiguousBlocks;
+
+    /* Byte totals, valid for every allocator */
+    size_t totalBytes;
+    size_t usedBytes;
+    size_t freeBytes;
+    size_t maxFreeContiguousBytes;
+
+    /* 0% when all free memory is one block */
+    unsigned int fragmentation;
   }
   UMM_HEAP_INFO;
 
@@ -122,6 +156,31 @@
   size_t umm_free_heap_size( umm_heap_t heap );
 #endif
 
+/*
+ * Per-heap allocation statistics.  Latencies are in UMM_TIMESTAMP()
+ * ticks and cover the allocator itself, not the wait for the heap lock.
+ */
+typedef struct UMM_HEAP_STATS_t {
+  unsigned int allocs;
+  unsigned int frees;
+  unsigned int failures;
+  size_t usedBytes;
+  size_t peakUsedBytes;
+  unsigned int mallocMaxTicks;
+  unsigned int freeMaxTicks;
+  unsigned long long mallocTicks;
+  unsigned long long freeTicks;
+}
+UMM_HEAP_STATS;
+
+void umm_heap_stats( umm_heap_t heap, UMM_HEAP_STATS *stats, int reset );
+const char *umm_heap_allocator( umm_heap_t heap );
+
+#ifndef UMM_TIMESTAMP
+#define UMM_TIMESTAMP()          0
+#define UMM_TIMESTAMP_TO_US(x)   (x)
+#endif
+
 
 /*
  * A couple of macros to make it easier to protect the memory allocator
@@ -155,13 +214,13 @@
  * for corruption.
  */
 
+int umm_integrity_check( umm_heap_t heap );
+#define UMM_HEAP_CORRUPTION_CB(x) printf( "Heap Corruption (Heap #%d)!", x )
+
 #ifdef UMM_INTEGRITY_CHECK
-   int umm_integrity_check( umm_heap_t heap );
 #  define INTEGRITY_CHECK(x) umm_integrity_check(x)
-   extern void umm_corruption(void);
-#  define UMM_HEAP_CORRUPTION_CB(x) printf( "Heap Corruption (Heap #%d)!", x )
 #else
-#  define INTEGRITY_CHECK() 0
+#  define INTEGRITY_CHECK(x) ((void)0)
 #endif
 
 /*
@@ -194,7 +253,7 @@
 
 #define UMM_POISON_SIZE_BEFORE 4
 #define UMM_POISON_SIZE_AFTER 4
-#define UMM_POISONED_BLOCK_LEN_TYPE short
+#define UMM_POISONED_BLOCK_LEN_TYPE unsigned int
 
 #ifdef UMM_POISON_CHECK
    void *umm_poison_malloc( umm_heap_t heap, size_t size );
@@ -204,7 +263,7 @@
    int   umm_poison_check( umm_heap_t heap );
 #  define POISON_CHECK(x) umm_poison_check(x)
 #else
-#  define POISON_CHECK() 0
+#  define POISON_CHECK(x) 0
 #endif
 
 #endif /* _UMM_MALLOC_CFG_H */
@@ -30,6 +30,23 @@
     "UMM_L2_UNCACHED_HEAP",    \
 }                              \
 
+/*
+ * Allocator used by each heap.  TLSF gives O(1) malloc/free for the
+ * large SDRAM heaps which are allocated from while audio is running.
+ * The small L2 heaps stay first-fit, their free lists are short and the
+ * TLSF index would cost a large part of them.
+ */
+#define UMM_ALLOC_FIRST_FIT    0
+#define UMM_ALLOC_TLSF         1
+
+#define UMM_HEAP_ALLOCATORS    \
+{                              \
+    UMM_ALLOC_TLSF,            \
+    UMM_ALLOC_TLSF,            \
+    UMM_ALLOC_FIRST_FIT,       \
+    UMM_ALLOC_FIRST_FIT,       \
+}                              \
+
 typedef enum {
     UMM_SDRAM_HEAP = 0,
     UMM_SDRAM_UNCACHED_HEAP,
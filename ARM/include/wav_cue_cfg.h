@@ -0,0 +1,47 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _wav_cue_cfg_h
+#define _wav_cue_cfg_h
+
+#include "umm_malloc.h"
+
+/* Hot cues per deck */
+#define WAV_CUE_MAX_CUES        (8)
+
+/*
+ * Audio pinned in RAM after each hot cue.  It plays while the source
+ * task seeks the file and refills the ring, so it must cover an SD
+ * seek and a few reads.
+ */
+#define WAV_CUE_PIN_MS          (250)
+
+/* Longest loop, the whole loop is pinned */
+#define WAV_CUE_LOOP_MAX_MS     (16000)
+
+/* Crossfade on jumps and loop wraps, at most one block */
+#define WAV_CUE_XFADE_FRAMES    (32)
+
+/*
+ * Scratch playback window, decoded audio kept resident around the read
+ * head in both directions, in blocks of WAV_SCRATCH_BLOCK_FRAMES.
+ */
+#define WAV_SCRATCH_WINDOW_MS       (3000)
+#define WAV_SCRATCH_BLOCK_FRAMES    (1024)
+
+/* Largest change in scratch rate per audio block, and the rate limit */
+#define WAV_SCRATCH_SLEW            (0.5f)
+#define WAV_SCRATCH_MAX_RATE        (4.0f)
+
+#define WAV_CUE_MALLOC(x)       umm_malloc_heap(UMM_SDRAM_HEAP, x)
+#define WAV_CUE_FREE(x)         umm_free_heap(UMM_SDRAM_HEAP, x)
+
+#endif
@@ -0,0 +1,42 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _wav_rec_cfg_h
+#define _wav_rec_cfg_h
+
+#include <sys/platform.h>
+
+#include "umm_malloc.h"
+
+/*
+ * Recording time reserved up front for each file.  The request is
+ * halved until a contiguous free area is found and is capped at the
+ * 4GB RIFF limit.  Unused space is returned to the volume on close.
+ */
+#define WAV_REC_PREALLOC_SECONDS  (30 * 60)
+
+/* Most stem files a session may be split into */
+#define WAV_REC_MAX_FILES         (8)
+
+/*
+ * Minimum bytes per f_write().  Rounded up to a whole number of
+ * clusters so every write after the first starts on a cluster.
+ */
+#define WAV_REC_WRITE_SIZE        (32 * 1024)
+
+/* Rewrite the header after this much new audio is on the card */
+#define WAV_REC_COMMIT_SECONDS    (2)
+
+/* Staging buffers go straight to the SD DMA so align them on cache lines */
+#define WAV_REC_MALLOC(x)   umm_malloc_heap_aligned(UMM_SDRAM_HEAP, x, ADI_CACHE_LINE_LENGTH)
+#define WAV_REC_FREE(x)     umm_free_heap_aligned(UMM_SDRAM_HEAP, x)
+
+#endif
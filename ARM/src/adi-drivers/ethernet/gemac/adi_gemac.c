@@ -883,6 +883,8 @@ static void process_int(ADI_EMAC_DEVICE *pDev,ADI_EMAC_CHANNEL *pChannel, int32_
     ADI_EMAC_DMA_CHANNEL *pDMAChannel = &pChannel->DMAChan[nDMADeviceNum];
     ADI_ETHER_BUFFER *pProcessedBuffer = pDMAChannel->Active.pQueueHead;
     ADI_EMAC_DMADESC *pCurDmaDesc = NULL;
+    ADI_EMAC_DMADESC *pLastDmaDesc = NULL;
+    ADI_EMAC_DMADESC *pNextDmaDesc = NULL;
     ADI_ETHER_EVENT   Event;
 
     short *pLength;
@@ -892,12 +894,15 @@ static void process_int(ADI_EMAC_DEVICE *pDev,ADI_EMAC_CHANNEL *pChannel, int32_
     while (pProcessedBuffer)
     {
         pCurDmaDesc  = ( (ADI_EMAC_BUFINFO*)pProcessedBuffer)->pDmaDesc;
+        pLastDmaDesc = ( (ADI_EMAC_BUFINFO*)pProcessedBuffer)->pLastDesc;
 
         /* data cache is enabled then flush and invalidate the descriptor */
-        if (pDev->Cache) { SIMPLEFLUSHINV(pCurDmaDesc); }
+        if (pDev->Cache) { SIMPLEFLUSHINV(pLastDmaDesc); }
 
-        /* break out of the loop if any descriptor is owned by the emac */
-        if(pCurDmaDesc->Status & ADI_EMAC_DMAOWN)
+        /* break out of the loop if any descriptor is owned by the emac.
+         * The last descriptor of a frame is released last.
+         */
+        if(pLastDmaDesc->Status & ADI_EMAC_DMAOWN)
         {
             break;
         }
@@ -906,7 +911,6 @@ static void process_int(ADI_EMAC_DEVICE *pDev,ADI_EMAC_CHANNEL *pChannel, int32_
         pDMAChannel->Active.pQueueHead = pProcessedBuffer->pNext;
         pDMAChannel->Active.ElementCount--;
         pProcessedBuffer->pNext = NULL;
-        pCurDmaDesc->pNextDesc  = NULL;
 
         /* Clear the frame status frag */
         pProcessedBuffer->Status = 0u;
@@ -916,7 +920,7 @@ static void process_int(ADI_EMAC_DEVICE *pDev,ADI_EMAC_CHANNEL *pChannel, int32_
          */
         if (pChannel->Recv)
         {
-            pProcessedBuffer->ProcessedElementCount = ((pCurDmaDesc->Status >> 16) & 0x3FFF);
+            pProcessedBuffer->ProcessedElementCount = ((pLastDmaDesc->Status >> 16) & 0x3FFF);
             inv_area( (uint8_t *)pProcessedBuffer->Data, (uint32_t)(pProcessedBuffer->ProcessedElementCount + sizeof(*pLength)));
             pLength = (short*)pProcessedBuffer->Data;
             *pLength = pProcessedBuffer->ProcessedElementCount + 6;
@@ -930,19 +934,19 @@ static void process_int(ADI_EMAC_DEVICE *pDev,ADI_EMAC_CHANNEL *pChannel, int32_
         {
 
             if (   (    (pChannel->Recv)
-                    && (pCurDmaDesc->Status & (1u << 7))    /*      Timestamp available bit is set */
-                    && (pCurDmaDesc->Status & (1u << 8)))   /* AND  Last Descriptor bit is set     */
+                    && (pLastDmaDesc->Status & (1u << 7))    /*      Timestamp available bit is set */
+                    && (pLastDmaDesc->Status & (1u << 8)))   /* AND  Last Descriptor bit is set     */
                 || (    (!pChannel->Recv)
-                    && (pCurDmaDesc->Status & (1u << 17))   /*      Timestamp available bit is set */
-                    && (pCurDmaDesc->Status & (1u << 29)))   /* AND  Last Segment bit is set     */
+                    && (pLastDmaDesc->Status & (1u << 17))   /*      Timestamp available bit is set */
+                    && (pLastDmaDesc->Status & (1u << 29)))   /* AND  Last Segment bit is set     */
                     )
             {
                 /* Mark the status as timestamp available */
                 pProcessedBuffer->Status |= ADI_ETHER_BUFFER_STATUS_TIMESTAMP_AVAIL;
 
                 pProcessedBuffer->TimeStamp.HSecond = pDev->pEMAC_REGS->EMAC_TM_HISEC;
-                pProcessedBuffer->TimeStamp.LSecond = pCurDmaDesc->TimeStampHi;
-                pProcessedBuffer->TimeStamp.NanoSecond = pCurDmaDesc->TimeStampLo;
+                pProcessedBuffer->TimeStamp.LSecond = pLastDmaDesc->TimeStampHi;
+                pProcessedBuffer->TimeStamp.NanoSecond = pLastDmaDesc->TimeStampLo;
             }
         }
 #endif
@@ -953,18 +957,25 @@ static void process_int(ADI_EMAC_DEVICE *pDev,ADI_EMAC_CHANNEL *pChannel, int32_
          /* see if next buffer in the active list is also done */
          pProcessedBuffer = pDMAChannel->Active.pQueueHead;
 
-         /* place the finished dma descriptor in the available list for the channel */
-
-         if (pDMAChannel->pDmaDescTail != NULL)
-         {
-             pDMAChannel->pDmaDescTail->pNextDesc =  pCurDmaDesc;
-             pDMAChannel->pDmaDescTail = pCurDmaDesc;
-         }
-         else
+         /* place the finished dma descriptors in the available list for the channel */
+         while (pCurDmaDesc != NULL)
          {
-             pDMAChannel->pDmaDescHead = pDMAChannel->pDmaDescTail =  pCurDmaDesc;
+             pNextDmaDesc = (pCurDmaDesc == pLastDmaDesc) ? NULL : pCurDmaDesc->pNextDesc;
+             pCurDmaDesc->pNextDesc = NULL;
+
+             if (pDMAChannel->pDmaDescTail != NULL)
+             {
+                 pDMAChannel->pDmaDescTail->pNextDesc =  pCurDmaDesc;
+                 pDMAChannel->pDmaDescTail = pCurDmaDesc;
+             }
+             else
+             {
+                 pDMAChannel->pDmaDescHead = pDMAChannel->pDmaDescTail =  pCurDmaDesc;
+             }
+             pDMAChannel->NumAvailDmaDesc += 1;
+
+             pCurDmaDesc = pNextDmaDesc;
          }
-         pDMAChannel->NumAvailDmaDesc += 1;
     }
 
     /* determine the event */
@@ -1892,6 +1903,11 @@ ADI_ETHER_RESULT adi_ether_GemacRead( ADI_ETHER_HANDLE const phDevice,
  *
  *              All read and write operations are DMA driven. Programmed I/O is not available.
  *
+ *              A buffer with nFrags set is sent as a scatter-gather frame. The buffer data
+ *              is the first segment and each fragment is sent from its own chained descriptor,
+ *              so the frame needs nFrags + 1 descriptors. The fragments are owned by the driver
+ *              until the buffer is returned.
+ *
  * @param [in]  phDevice        Handle to the ethernet device
  *
  * @param [in]  pBuffer         Pointer to a single buffer or list of buffers
@@ -2726,13 +2742,19 @@ static void  set_descriptor(
     {
         pDmaDesc->StartAddr   = (uint32_t)((uint8_t*)pBindedBuf->Data+2);
         pDmaDesc->ControlDesc -= 2;
-        pDmaDesc->Status |= ( (1UL << 30)     /* Interrupt on Completion */
-                             | (1UL << 29)    /* Last Segment */
-                             | (1UL << 28)    /* First Segment */
+        pDmaDesc->Status |= ( (1UL << 28)     /* First Segment */
                              | (1UL << 20)    /* Second Address Chained */
                              | (3UL << 22)    /* Hardware checksum calculation */
                              );
 
+        /* the last fragment descriptor ends a scatter-gather frame */
+        if (pBindedBuf->nFrags == 0u)
+        {
+            pDmaDesc->Status |= ( (1UL << 30)     /* Interrupt on Completion */
+                                 | (1UL << 29)    /* Last Segment */
+                                 );
+        }
+
 #ifdef ADI_ETHER_SUPPORT_PTP
         if (pDev->Capability & ADI_EMAC_CAPABILITY_PTP) {
             /* Timestamp is enabled for the TX packet */
@@ -2763,6 +2785,49 @@ static void  set_descriptor(
     }
 }
 
+/**
+ * @brief       Sets transmit fragment descriptor values
+ *
+ * @details     Fragment descriptors follow the first descriptor of a transmit
+ *              frame. Only the last one carries the last segment and interrupt
+ *              on completion bits.
+ *
+ * @param [in]  hDevice       Handle to the device
+ * @param [in]  pDmaDesc      Pointer to the dma descriptor
+ * @param [in]  pFrag         Pointer to the fragment
+ * @param [in]  bLast         Last fragment of the frame
+ *
+ * @return      void
+ *
+ * @note        used by bind_buf_with_desc()
+ */
+static void  set_frag_descriptor(
+                                 ADI_ETHER_HANDLE hDevice,
+                                 ADI_EMAC_DMADESC *pDmaDesc,
+                                 ADI_ETHER_FRAG   *pFrag,
+                                 bool              bLast
+                                 )
+{
+    ADI_EMAC_DEVICE*    const  pDev = (ADI_EMAC_DEVICE*)hDevice;
+
+    pDmaDesc->StartAddr   = (uint32_t)pFrag->Data;
+    pDmaDesc->ControlDesc = pFrag->Length;
+    pDmaDesc->Status      = (1UL << 20);      /* Second Address Chained */
+
+    if (bLast)
+    {
+        pDmaDesc->Status |= ( (1UL << 30)     /* Interrupt on Completion */
+                             | (1UL << 29)    /* Last Segment */
+                             );
+    }
+
+    /* data cache is enabled flush the cache for the fragment */
+    if(pDev->Cache)
+    {
+        flush_area((uint8_t*)pFrag->Data, pFrag->Length);
+    }
+}
+
 /**
  * @brief       Bind buffers with descriptors.
  *
@@ -2784,7 +2849,10 @@ static void  set_descriptor(
 static ADI_ETHER_RESULT bind_buf_with_desc(ADI_ETHER_HANDLE hDevice,ADI_EMAC_CHANNEL *pChannel, int32_t nDMADeviceNum)
 {
     ADI_EMAC_DMADESC *pAvailDesc;
+    ADI_EMAC_DMADESC *pLastDesc;
+    ADI_EMAC_DMADESC *pFragDesc;
     ADI_ETHER_BUFFER *pQueuedBuf;
+    uint32_t nDesc, nFrag;
     ADI_EMAC_DMA_CHANNEL* pDMAChannel = &pChannel->DMAChan[nDMADeviceNum];
 
     /* Mask off etherent interrupt alone */
@@ -2806,10 +2874,17 @@ static ADI_ETHER_RESULT bind_buf_with_desc(ADI_ETHER_HANDLE hDevice,ADI_EMAC_CHA
     /* We will leave the last descriptor without associating with a buffer. This is
      * because the DMA will fetch the descriptor and enter into suspend state. We do
      * not want to stop and restart DMA but rather use the last descriptor to continue
-     * from the suspended state.
+     * from the suspended state.  A scatter-gather transmit frame needs one
+     * descriptor per fragment in addition to its first descriptor.
      */
-    while (pAvailDesc && (pDMAChannel->NumAvailDmaDesc > 1) && pQueuedBuf)
+    while (pAvailDesc && pQueuedBuf)
     {
+        nDesc = pChannel->Recv ? 1u : (1u + pQueuedBuf->nFrags);
+        if (pDMAChannel->NumAvailDmaDesc <= nDesc)
+        {
+            break;
+        }
+
         /* remove the queued buffer from the queue */
         pDMAChannel->Queued.pQueueHead = pDMAChannel->Queued.pQueueHead->pNext;
         pDMAChannel->Queued.ElementCount--;
@@ -2824,6 +2899,22 @@ static ADI_ETHER_RESULT bind_buf_with_desc(ADI_ETHER_HANDLE hDevice,ADI_EMAC_CHA
 
         set_descriptor(hDevice,pAvailDesc,pQueuedBuf,pChannel, nDMADeviceNum);
 
+        /* chain the fragment descriptors behind the first one */
+        pLastDesc = pAvailDesc;
+        for (nFrag = 1u; nFrag < nDesc; nFrag++)
+        {
+            pFragDesc = pDMAChannel->pDmaDescHead;
+            pDMAChannel->pDmaDescHead = pFragDesc->pNextDesc;
+            pDMAChannel->NumAvailDmaDesc--;
+
+            set_frag_descriptor(hDevice, pFragDesc, &pQueuedBuf->pFrags[nFrag - 1u],
+                                (nFrag + 1u) == nDesc);
+
+            pLastDesc->pNextDesc = pFragDesc;
+            pLastDesc = pFragDesc;
+        }
+        ((ADI_EMAC_BUFINFO*)pQueuedBuf)->pLastDesc = pLastDesc;
+
         /* now put the buffer in the pending list */
         if (pDMAChannel->Pending.pQueueHead == NULL)
         {
@@ -2834,7 +2925,7 @@ static ADI_ETHER_RESULT bind_buf_with_desc(ADI_ETHER_HANDLE hDevice,ADI_EMAC_CHA
         else
         {
            /* link the descriptors */
-            ((ADI_EMAC_BUFINFO*)pDMAChannel->Pending.pQueueTail)->pDmaDesc->pNextDesc = pAvailDesc;
+            ((ADI_EMAC_BUFINFO*)pDMAChannel->Pending.pQueueTail)->pLastDesc->pNextDesc = pAvailDesc;
 
             pDMAChannel->Pending.pQueueTail->pNext = pQueuedBuf;
             pDMAChannel->Pending.pQueueTail = pQueuedBuf;
@@ -2842,7 +2933,7 @@ static ADI_ETHER_RESULT bind_buf_with_desc(ADI_ETHER_HANDLE hDevice,ADI_EMAC_CHA
         }
 
         /* next available descriptor will be always at the end */
-        pAvailDesc->pNextDesc = pDMAChannel->pDmaDescHead;
+        pLastDesc->pNextDesc = pDMAChannel->pDmaDescHead;
 
         pAvailDesc = pDMAChannel->pDmaDescHead;
         pQueuedBuf = pDMAChannel->Queued.pQueueHead;
@@ -2866,7 +2957,7 @@ static ADI_ETHER_RESULT activate_channel(ADI_ETHER_HANDLE hDevice,ADI_EMAC_CHANN
     ADI_EMAC_DEVICE*    const  pDev      = (ADI_EMAC_DEVICE*)hDevice;
     ADI_EMAC_REGISTERS* const  pEmacRegs = pDev->pEMAC_REGS;
     ADI_ETHER_BUFFER *pPendQFirstBuf, *pActiveQLastBuf, *pBuffer;
-    ADI_EMAC_DMADESC *pLastDmaDesc, *pNextDmaDesc, *pDmaDesc;
+    ADI_EMAC_DMADESC *pLastDmaDesc, *pNextDmaDesc, *pDmaDesc, *pFragDesc;
     ADI_EMAC_DMA_CHANNEL* pDMAChannel = &pChannel->DMAChan[nDMADeviceNum];
     uint32_t index;
 
@@ -2887,7 +2978,7 @@ static ADI_ETHER_RESULT activate_channel(ADI_ETHER_HANDLE hDevice,ADI_EMAC_CHANN
             copy_queue_elements(&pDMAChannel->Active, &pDMAChannel->Pending);
 
             pNextDmaDesc = ((ADI_EMAC_BUFINFO*)pDMAChannel->Active.pQueueHead)->pDmaDesc;
-            pLastDmaDesc = ((ADI_EMAC_BUFINFO*)pDMAChannel->Active.pQueueTail)->pDmaDesc;
+            pLastDmaDesc = ((ADI_EMAC_BUFINFO*)pDMAChannel->Active.pQueueTail)->pLastDesc;
             if(pChannel->Recv) {
                 if ((pEmacRegs->EMAC_DMA_STAT & BITM_EMAC_DMA_STAT_RS) == ENUM_EMAC_DMA_STAT_RS_STOPPED)
                 {
@@ -2903,7 +2994,7 @@ static ADI_ETHER_RESULT activate_channel(ADI_ETHER_HANDLE hDevice,ADI_EMAC_CHANN
              pActiveQLastBuf = pDMAChannel->Active.pQueueTail;
              pPendQFirstBuf  = pDMAChannel->Pending.pQueueHead;
 
-             pLastDmaDesc = ((ADI_EMAC_BUFINFO*)pActiveQLastBuf)->pDmaDesc;
+             pLastDmaDesc = ((ADI_EMAC_BUFINFO*)pActiveQLastBuf)->pLastDesc;
              pNextDmaDesc = ((ADI_EMAC_BUFINFO*)pPendQFirstBuf)->pDmaDesc;
 
              /* now link the descriptors */
@@ -2923,9 +3014,20 @@ static ADI_ETHER_RESULT activate_channel(ADI_ETHER_HANDLE hDevice,ADI_EMAC_CHANN
         pBuffer = pDMAChannel->Pending.pQueueHead;
         while(pBuffer) {
             pDmaDesc = ((ADI_EMAC_BUFINFO*)pBuffer)->pDmaDesc;
+            pLastDmaDesc = ((ADI_EMAC_BUFINFO*)pBuffer)->pLastDesc;
             if (((index++ % pDev->TxIntPeriod) != 0) && (pBuffer->pNext != NULL)) {
                 /* Clear interrupt status */
-                pDmaDesc->Status &= (~(1u << 30));
+                pLastDmaDesc->Status &= (~(1u << 30));
+            }
+
+            /* hand the fragments over before the first descriptor so the
+             * DMA never starts a frame it cannot finish
+             */
+            pFragDesc = pDmaDesc;
+            while (pFragDesc != pLastDmaDesc) {
+                pFragDesc = pFragDesc->pNextDesc;
+                pFragDesc->Status |= ADI_EMAC_DMAOWN;
+                if(pDev->Cache) { SIMPLEFLUSHINV(pFragDesc); }
             }
 
             pDmaDesc->Status     |= ADI_EMAC_DMAOWN;
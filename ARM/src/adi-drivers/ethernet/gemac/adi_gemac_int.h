@@ -414,6 +414,7 @@ typedef struct ADI_EMAC_DMADESC
 typedef struct ADI_EMAC_BUFINFO
 {
    ADI_EMAC_DMADESC           *pDmaDesc;   /*!< pointer to DMA descriptor */
+   ADI_EMAC_DMADESC           *pLastDesc;  /*!< last descriptor of the frame */
 
 } ADI_EMAC_BUFINFO;
 
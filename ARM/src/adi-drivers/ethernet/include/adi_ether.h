@@ -177,6 +177,20 @@ enum ADI_ETHER_CMD
 
 #define ADI_ETHER_DRIVER_MEM  (20)            /*!< Driver memory - primarily used for DMA */
 
+/**
+ * \struct ADI_ETHER_FRAG
+ *
+ * Transmit fragment.  A transmit buffer may carry a list of fragments
+ * which are sent after the buffer's own data as one frame, each from its
+ * own chained DMA descriptor.  Fragment memory must stay valid until the
+ * buffer is returned by the transmit complete callback.
+ */
+typedef struct ADI_ETHER_FRAG
+{
+    void     *Data;                           /*!< Pointer to fragment data. */
+    uint32_t Length;                          /*!< Fragment length in bytes. */
+} ADI_ETHER_FRAG;
+
 /**
  * \struct __ADI_ETHER_BUFFER
  *
@@ -208,6 +222,8 @@ typedef struct __ADI_ETHER_BUFFER
 #endif
     uint32_t Status;                          /*!< Status for the Buffer - ORed value of ADI_ETHER_BUFFER_STATUS */
     uint32_t Flag;                            /*!< Flag for the Buffer  - ORed value of ADI_ETHER_BUFFER_FLAG */
+    ADI_ETHER_FRAG *pFrags;                   /*!< Transmit fragments (scatter-gather) */
+    uint32_t nFrags;                          /*!< Number of transmit fragments */
 
 } ADI_ETHER_BUFFER;
 
@@ -0,0 +1,249 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "audio_pool.h"
+#include "process_audio.h"
+#include "util.h"
+#include "umm_malloc.h"
+
+/* Smallest ring, in blocks */
+#define AUDIO_POOL_MIN_BLOCKS  (4)
+
+/*
+ * Pool ring.  The ring buffer is the first member so the ring can be
+ * passed around as a plain PaUtilRingBuffer.  Ring data follows the
+ * header in the same allocation.
+ */
+typedef struct AUDIO_POOL_RING {
+    PaUtilRingBuffer rb;
+    SYSTEM_AUDIO_TYPE *block;
+    umm_heap_t blockHeap;
+    unsigned bytes;
+    unsigned low;
+    unsigned high;
+    bool lowArmed;
+    bool highArmed;
+    AUDIO_POOL_WATERMARK_CALLBACK lowCb;
+    AUDIO_POOL_WATERMARK_CALLBACK highCb;
+    void *usrPtr;
+} AUDIO_POOL_RING;
+
+typedef struct AUDIO_POOL_SCRATCH_BUF {
+    SemaphoreHandle_t lock;
+    SYSTEM_AUDIO_TYPE *buf;
+} AUDIO_POOL_SCRATCH_BUF;
+
+static AUDIO_POOL_SCRATCH_BUF scratchBufs[AUDIO_POOL_SCRATCH_MAX];
+static AUDIO_POOL_STATS poolStats;
+static SemaphoreHandle_t poolLock;
+
+/* Try to fit into L2 first for performance */
+static void *audio_pool_calloc_fast(size_t size, umm_heap_t *heap)
+{
+    void *ptr;
+
+    *heap = UMM_L2_CACHED_HEAP;
+    ptr = umm_calloc_heap(*heap, size, 1);
+    if (ptr == NULL) {
+        *heap = UMM_SDRAM_HEAP;
+        ptr = umm_calloc_heap(*heap, size, 1);
+    }
+
+    return(ptr);
+}
+
+void audio_pool_init(void)
+{
+    unsigned i;
+
+    poolLock = xSemaphoreCreateMutex();
+    for (i = 0; i < AUDIO_POOL_SCRATCH_MAX; i++) {
+        scratchBufs[i].lock = xSemaphoreCreateMutex();
+        scratchBufs[i].buf = NULL;
+    }
+    memset(&poolStats, 0, sizeof(poolStats));
+}
+
+PaUtilRingBuffer *audio_pool_ring_alloc(unsigned channels, unsigned latencyMs)
+{
+    AUDIO_POOL_RING *ring;
+    uint32_t samples;
+    uint32_t minSamples;
+    unsigned blockBytes;
+    unsigned bytes;
+
+    if (channels == 0) {
+        return(NULL);
+    }
+
+    samples = (SYSTEM_SAMPLE_RATE / 1000) * latencyMs * channels;
+    minSamples = AUDIO_POOL_MIN_BLOCKS * SYSTEM_BLOCK_SIZE * channels;
+    if (samples < minSamples) {
+        samples = minSamples;
+    }
+    samples = roundUpPow2(samples);
+
+    bytes = sizeof(*ring) + samples * sizeof(SYSTEM_AUDIO_TYPE);
+    blockBytes = channels * SYSTEM_BLOCK_SIZE * sizeof(SYSTEM_AUDIO_TYPE);
+
+    ring = umm_calloc_heap(UMM_SDRAM_HEAP, bytes, 1);
+    if (ring) {
+        ring->block = audio_pool_calloc_fast(blockBytes, &ring->blockHeap);
+        if (ring->block == NULL) {
+            umm_free_heap(UMM_SDRAM_HEAP, ring);
+            ring = NULL;
+        }
+    }
+
+    xSemaphoreTake(poolLock, portMAX_DELAY);
+    if (ring) {
+        ring->bytes = bytes + blockBytes;
+        poolStats.rings++;
+        poolStats.ringBytes += ring->bytes;
+        if (poolStats.ringBytes > poolStats.peakRingBytes) {
+            poolStats.peakRingBytes = poolStats.ringBytes;
+        }
+    } else {
+        poolStats.allocFailures++;
+    }
+    xSemaphoreGive(poolLock);
+
+    if (ring == NULL) {
+        return(NULL);
+    }
+
+    PaUtil_InitializeRingBuffer(&ring->rb,
+        sizeof(SYSTEM_AUDIO_TYPE), samples, ring + 1);
+
+    return(&ring->rb);
+}
+
+void audio_pool_ring_free(PaUtilRingBuffer **rb)
+{
+    AUDIO_POOL_RING *ring = (AUDIO_POOL_RING *)*rb;
+
+    if (ring == NULL) {
+        return;
+    }
+
+    /*
+     * Detach with the audio interrupts masked.  An ISR running before
+     * this is done with the ring, one running after finds it gone.
+     * Streams waiting on their clock domain to be routed still point
+     * at the ring's block, those are dropped too.
+     */
+    taskENTER_CRITICAL();
+    *rb = NULL;
+    processAudioDetach(ring->block);
+    taskEXIT_CRITICAL();
+
+    xSemaphoreTake(poolLock, portMAX_DELAY);
+    poolStats.rings--;
+    poolStats.ringBytes -= ring->bytes;
+    xSemaphoreGive(poolLock);
+
+    umm_free_heap(ring->blockHeap, ring->block);
+    umm_free_heap(UMM_SDRAM_HEAP, ring);
+}
+
+SYSTEM_AUDIO_TYPE *audio_pool_ring_block(PaUtilRingBuffer *rb)
+{
+    return(rb ? ((AUDIO_POOL_RING *)rb)->block : NULL);
+}
+
+void audio_pool_ring_watermarks(PaUtilRingBuffer *rb,
+    unsigned low, AUDIO_POOL_WATERMARK_CALLBACK lowCb,
+    unsigned high, AUDIO_POOL_WATERMARK_CALLBACK highCb,
+    void *usrPtr)
+{
+    AUDIO_POOL_RING *ring = (AUDIO_POOL_RING *)rb;
+
+    ring->low = low;
+    ring->high = high;
+    ring->lowCb = lowCb;
+    ring->highCb = highCb;
+    ring->usrPtr = usrPtr;
+    ring->lowArmed = (lowCb != NULL);
+    ring->highArmed = (highCb != NULL);
+}
+
+void audio_pool_ring_update(PaUtilRingBuffer *rb)
+{
+    AUDIO_POOL_RING *ring = (AUDIO_POOL_RING *)rb;
+    unsigned level;
+
+    if (ring == NULL) {
+        return;
+    }
+
+    level = PaUtil_GetRingBufferReadAvailable(rb);
+
+    if (ring->lowCb) {
+        if (level > ring->low) {
+            ring->lowArmed = true;
+        } else if (ring->lowArmed) {
+            ring->lowArmed = false;
+            ring->lowCb(rb, ring->usrPtr);
+        }
+    }
+
+    if (ring->highCb) {
+        if (level < ring->high) {
+            ring->highArmed = true;
+        } else if (ring->highArmed) {
+            ring->highArmed = false;
+            ring->highCb(rb, ring->usrPtr);
+        }
+    }
+}
+
+void *audio_pool_scratch_take(AUDIO_POOL_SCRATCH scratch)
+{
+    AUDIO_POOL_SCRATCH_BUF *s = &scratchBufs[scratch];
+    unsigned bytes = AUDIO_POOL_SCRATCH_SAMPLES * sizeof(SYSTEM_AUDIO_TYPE);
+    umm_heap_t heap;
+
+    xSemaphoreTake(s->lock, portMAX_DELAY);
+
+    /* Allocated on first use and kept */
+    if (s->buf == NULL) {
+        s->buf = audio_pool_calloc_fast(bytes, &heap);
+        if (s->buf) {
+            xSemaphoreTake(poolLock, portMAX_DELAY);
+            poolStats.scratchBytes += bytes;
+            xSemaphoreGive(poolLock);
+        }
+    }
+    if (s->buf == NULL) {
+        xSemaphoreGive(s->lock);
+    }
+
+    return(s->buf);
+}
+
+void audio_pool_scratch_give(AUDIO_POOL_SCRATCH scratch)
+{
+    xSemaphoreGive(scratchBufs[scratch].lock);
+}
+
+void audio_pool_stats(AUDIO_POOL_STATS *stats)
+{
+    xSemaphoreTake(poolLock, portMAX_DELAY);
+    *stats = poolStats;
+    xSemaphoreGive(poolLock);
+}
@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _audio_pool_h
+#define _audio_pool_h
+
+#include <stdbool.h>
+
+#include "context.h"
+#include "pa_ringbuffer.h"
+
+/*
+ * Central pool for streaming audio buffers.
+ *
+ * Stream ring buffers are allocated when a stream is opened and returned
+ * when it is closed.  Rings are sized for the requested latency at the
+ * stream's channel count and measured in SYSTEM_AUDIO_TYPE sized words.
+ * Each ring also carries the single block buffer the stream exchanges
+ * with the audio router in ISR context.
+ *
+ * Scratch buffers are shared by every user of a scratch group.  Users
+ * bracket each use with audio_pool_scratch_take() and
+ * audio_pool_scratch_give() so tasks in a group never use a buffer
+ * concurrently.
+ */
+typedef enum AUDIO_POOL_SCRATCH {
+    AUDIO_POOL_SCRATCH_FILE = 0,    /* Audio file tasks */
+    AUDIO_POOL_SCRATCH_NET,         /* Network receive callbacks */
+    AUDIO_POOL_SCRATCH_MAX
+} AUDIO_POOL_SCRATCH;
+
+/*
+ * Ring watermark callback.  Called from the context that moved the ring
+ * level across the watermark, typically the audio ISR.
+ */
+typedef void (*AUDIO_POOL_WATERMARK_CALLBACK)(PaUtilRingBuffer *rb,
+    void *usrPtr);
+
+/* Scratch buffer size in SYSTEM_AUDIO_TYPE sized words */
+#define AUDIO_POOL_SCRATCH_SAMPLES  (WAV_MAX_CHANNELS * SYSTEM_BLOCK_SIZE)
+
+typedef struct AUDIO_POOL_STATS {
+    unsigned rings;
+    unsigned ringBytes;
+    unsigned peakRingBytes;
+    unsigned scratchBytes;
+    unsigned allocFailures;
+} AUDIO_POOL_STATS;
+
+void audio_pool_init(void);
+
+/*
+ * Allocates a ring for 'channels' interleaved channels holding at least
+ * 'latencyMs' of audio.  Returns NULL when out of memory.
+ */
+PaUtilRingBuffer *audio_pool_ring_alloc(unsigned channels, unsigned latencyMs);
+
+/*
+ * Detaches the ring at '*rb' from the audio ISRs and returns it to the
+ * pool.  Task context only.
+ */
+void audio_pool_ring_free(PaUtilRingBuffer **rb);
+
+/* Returns the ring's block buffer (channels * SYSTEM_BLOCK_SIZE words) */
+SYSTEM_AUDIO_TYPE *audio_pool_ring_block(PaUtilRingBuffer *rb);
+
+/*
+ * Registers fill level watermarks in words.  'lowCb' is called once when
+ * the fill level falls to or below 'low' and 'highCb' once when it
+ * rises to or above 'high'.  Each re-arms when the level moves back
+ * across its watermark.  Either callback may be NULL.  Call before the
+ * ring is published to the ISR.
+ */
+void audio_pool_ring_watermarks(PaUtilRingBuffer *rb,
+    unsigned low, AUDIO_POOL_WATERMARK_CALLBACK lowCb,
+    unsigned high, AUDIO_POOL_WATERMARK_CALLBACK highCb,
+    void *usrPtr);
+
+/*
+ * Checks the ring's fill level against its watermarks and fires any
+ * crossed callback.  Call after reading or writing the ring.
+ */
+void audio_pool_ring_update(PaUtilRingBuffer *rb);
+
+void *audio_pool_scratch_take(AUDIO_POOL_SCRATCH scratch);
+void audio_pool_scratch_give(AUDIO_POOL_SCRATCH scratch);
+
+void audio_pool_stats(AUDIO_POOL_STATS *stats);
+
+#endif
@@ -0,0 +1,453 @@
+/**
+ * Copyright (c) 2022 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+#include "context.h"
+#include "util.h"
+#include "avtp_audio.h"
+#include "avtp_stream.h"
+#include "audio_pool.h"
+#include "clock_domain.h"
+#include "gptp_clock.h"
+#include "lwip_adi_ether_netif.h"
+
+static unsigned avtpRxUnderflow = 0;
+static unsigned avtpRxOverflow = 0;
+static unsigned avtpRxLate = 0;
+static unsigned avtpTxOverflow = 0;
+
+/*
+ * Presentation time of the oldest sample in the Rx ring buffer.  Set by
+ * the receive task while the ring is empty and consumed by the audio
+ * ISR to start playout.
+ */
+static volatile uint32_t avtpRxPlayTime;
+static volatile bool avtpRxPlayTimeValid = false;
+
+/* Default Milan AAF multicast destination */
+static const uint8_t AVTP_DEFAULT_DST_MAC[6] = {
+    0x91, 0xE0, 0xF0, 0x00, 0xFE, 0x00
+};
+
+/* Task notification values */
+enum {
+    AVTP_TASK_NO_ACTION,
+    AVTP_TASK_AUDIO_TX_MORE_DATA,
+};
+
+void avtpAudioStats(unsigned *rxUnderflow, unsigned *rxOverflow,
+    unsigned *rxLate, unsigned *txOverflow)
+{
+    *rxUnderflow = avtpRxUnderflow;
+    *rxOverflow = avtpRxOverflow;
+    *rxLate = avtpRxLate;
+    *txOverflow = avtpTxOverflow;
+}
+
+/***********************************************************************
+ * EMAC link
+ **********************************************************************/
+static uint8_t *avtpLinkTxGet(void *linkPtr, void **handle)
+{
+    return(adi_ether_netif_raw_tx_get((struct netif *)linkPtr, handle));
+}
+
+static int avtpLinkTxSend(void *linkPtr, void *handle, unsigned len)
+{
+    return(adi_ether_netif_raw_tx_send((struct netif *)linkPtr,
+        handle, len));
+}
+
+static uint32_t avtpLinkNow(void *linkPtr)
+{
+    uint64_t now;
+
+    if (!gptpClockNow(&mainAppContext, &now)) {
+        return(0);
+    }
+
+    return((uint32_t)now);
+}
+
+/*
+ * 1722 frames arrive here from the EMAC worker task without passing
+ * through lwIP.  The first two bytes of the frame are the driver's
+ * length field.
+ */
+static void avtpRxFrame(adi_ether_netif *adi_ether, uint8_t *pktData,
+    uint16_t pktSize, void *pkt)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)adi_ether->usrPtr;
+
+    /* The stream lock keeps the Rx ring from being freed underneath */
+    if (pktSize > sizeof(uint16_t)) {
+        xSemaphoreTake((SemaphoreHandle_t)context->avtpRx.lock, portMAX_DELAY);
+        avtpRecvFrame(&context->avtpRx, pktData + sizeof(uint16_t),
+            pktSize - sizeof(uint16_t));
+        xSemaphoreGive((SemaphoreHandle_t)context->avtpRx.lock);
+    }
+
+    adi_ether_netif_p1722_free(adi_ether, pkt);
+}
+
+/*
+ * This callback puts AAF payloads into the Rx ring buffer.  Playout
+ * of the first packet after a (re)start is held off until its
+ * presentation time, after that the ring drains at the audio rate.
+ */
+static void avtpRxAudio(AVTP_STREAM *avtpRx, void *data, unsigned samples,
+    uint32_t presentationTime, void *usrPtr)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
+    PaUtilRingBuffer *avtpRxRB = context->avtpRxRB;
+    ring_buffer_size_t size1, size2;
+    void *buf1, *buf2;
+    unsigned samplesOut;
+
+    if (avtpRxRB == NULL) {
+        return;
+    }
+
+    samplesOut = PaUtil_GetRingBufferWriteAvailable(avtpRxRB);
+    if (samplesOut < samples) {
+        avtpRxOverflow++;
+        return;
+    }
+
+    if (avtpRx->preRoll && !avtpRxPlayTimeValid) {
+        avtpRxPlayTime = presentationTime;
+        avtpRxPlayTimeValid = true;
+    }
+
+    PaUtil_GetRingBufferWriteRegions(avtpRxRB, samples,
+        &buf1, &size1, &buf2, &size2);
+    swapAndConvert(
+        data, avtpRx->wordSizeBytes,
+        buf1, sizeof(SYSTEM_AUDIO_TYPE), size1
+    );
+    if (size2) {
+        swapAndConvert(
+            (uint8_t *)data + size1 * avtpRx->wordSizeBytes,
+            avtpRx->wordSizeBytes,
+            buf2, sizeof(SYSTEM_AUDIO_TYPE), size2
+        );
+    }
+    PaUtil_AdvanceRingBufferWriteIndex(avtpRxRB, samples);
+}
+
+/* Wakes the Tx task once AVTP_TX_WAKE_BLOCKS are queued (ISR context) */
+static void avtpTxHighWatermark(PaUtilRingBuffer *rb, void *usrPtr)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
+    BaseType_t wake = pdFALSE;
+
+    xTaskNotifyFromISR(context->avtpTxTaskHandle,
+        AVTP_TASK_AUDIO_TX_MORE_DATA, eSetValueWithoutOverwrite, &wake
+    );
+    portYIELD_FROM_ISR(wake);
+}
+
+/*
+ * This task emits AAF frames from the Tx ring buffer.  Samples are
+ * converted straight into the EMAC Tx DMA buffer and each packet is
+ * filled completely before giving the buffer back to the driver.
+ */
+portTASK_FUNCTION(avtpTxTask, pvParameters)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
+    AVTP_STREAM *avtpTx = &context->avtpTx;
+    PaUtilRingBuffer *avtpTxRB;
+    ring_buffer_size_t size1, size2;
+    void *buf1, *buf2;
+    uint32_t whatToDo;
+    unsigned samplesIn;
+    unsigned wsize;
+    void *data;
+    bool stalled;
+
+    while (1) {
+        xSemaphoreTake((SemaphoreHandle_t)avtpTx->lock, portMAX_DELAY);
+        avtpTxRB = context->avtpTxRB;
+        stalled = false;
+        if (avtpTx->enabled && avtpTxRB) {
+            samplesIn = PaUtil_GetRingBufferReadAvailable(avtpTxRB);
+            while (samplesIn >= avtpTx->maxSamples) {
+                wsize = avtpWriteSamplesAvailable(avtpTx, &data);
+                if (wsize == 0) {
+                    stalled = true;
+                    break;
+                }
+                PaUtil_GetRingBufferReadRegions(avtpTxRB, wsize,
+                    &buf1, &size1, &buf2, &size2);
+                swapAndConvert(
+                    buf1, sizeof(SYSTEM_AUDIO_TYPE),
+                    data, avtpTx->wordSizeBytes, size1
+                );
+                if (size2) {
+                    swapAndConvert(
+                        buf2, sizeof(SYSTEM_AUDIO_TYPE),
+                        (uint8_t *)data + size1 * avtpTx->wordSizeBytes,
+                        avtpTx->wordSizeBytes, size2
+                    );
+                }
+                PaUtil_AdvanceRingBufferReadIndex(avtpTxRB, wsize);
+                avtpWriteSamples(avtpTx, wsize);
+                samplesIn = PaUtil_GetRingBufferReadAvailable(avtpTxRB);
+            }
+        } else if (avtpTxRB) {
+            PaUtil_FlushRingBuffer(avtpTxRB);
+        }
+        xSemaphoreGive((SemaphoreHandle_t)avtpTx->lock);
+
+        /*
+         * The watermark only re-arms once the ring drains, so retry
+         * while the EMAC is out of Tx buffers instead of waiting on it
+         */
+        whatToDo = ulTaskNotifyTake(pdTRUE,
+            stalled ? pdMS_TO_TICKS(1) : portMAX_DELAY);
+    }
+}
+
+static void avtp_audio_init_stream(AVTP_STREAM *as, APP_CONTEXT *context,
+    bool isRx)
+{
+    struct netif *netif = &context->eth[0].netif;
+
+    as->lock =  (SemaphoreHandle_t)xSemaphoreCreateMutex();
+    as->isRx = isRx;
+    as->channels = 2;
+    as->wordSizeBytes = sizeof(int16_t);
+    as->sampleRate = SYSTEM_SAMPLE_RATE;
+    memcpy(as->dstMac, AVTP_DEFAULT_DST_MAC, sizeof(as->dstMac));
+    memcpy(as->srcMac, netif->hwaddr, sizeof(as->srcMac));
+    as->vlanID = 2;
+    as->vlanPcp = 3;
+    as->link.txGet = avtpLinkTxGet;
+    as->link.txSend = avtpLinkTxSend;
+    as->link.now = avtpLinkNow;
+    as->link.linkPtr = netif;
+    as->usrPtr = context;
+}
+
+static PaUtilRingBuffer **avtpRing(APP_CONTEXT *context, AVTP_STREAM *as)
+{
+    return(as->isRx ? &context->avtpRxRB : &context->avtpTxRB);
+}
+
+/*
+ * Allocates the stream's ring buffer and opens the stream.  Call with
+ * the stream's lock held after the stream is configured.
+ */
+bool avtp_audio_open(APP_CONTEXT *context, AVTP_STREAM *as)
+{
+    PaUtilRingBuffer **slot = avtpRing(context, as);
+    PaUtilRingBuffer *rb;
+    bool ok;
+
+    if (as->enabled) {
+        return(false);
+    }
+
+    audio_pool_ring_free(slot);
+    rb = audio_pool_ring_alloc(as->channels, AVTP_RING_LATENCY_MS);
+    if (rb == NULL) {
+        return(false);
+    }
+
+    /* The ISR wakes the Tx task, which otherwise blocks indefinitely */
+    if (!as->isRx) {
+        audio_pool_ring_watermarks(rb, 0, NULL,
+            AVTP_TX_WAKE_BLOCKS * as->channels * SYSTEM_BLOCK_SIZE,
+            avtpTxHighWatermark, context);
+    }
+    *slot = rb;
+
+    ok = avtpOpenStream(as);
+    if (!ok) {
+        audio_pool_ring_free(slot);
+    }
+
+    return(ok);
+}
+
+/* Closes the stream and returns its ring buffer to the audio pool */
+void avtp_audio_close(APP_CONTEXT *context, AVTP_STREAM *as)
+{
+    avtpCloseStream(as);
+    audio_pool_ring_free(avtpRing(context, as));
+}
+
+void avtp_audio_init(APP_CONTEXT *context)
+{
+    unsigned i;
+
+    /* Ring buffers are allocated from the audio pool on open */
+    context->avtpRxRB = NULL;
+    context->avtpTxRB = NULL;
+
+    avtp_audio_init_stream(&context->avtpRx, context, true);
+    context->avtpRx.rxCallback = avtpRxAudio;
+    avtp_audio_init_stream(&context->avtpTx, context, false);
+
+    /* Talker stream ID is the source MAC followed by a unique ID of 0 */
+    for (i = 0; i < 6; i++) {
+        context->avtpTx.streamID =
+            (context->avtpTx.streamID << 8) | context->avtpTx.srcMac[i];
+    }
+    context->avtpTx.streamID <<= 16;
+
+    context->eth[0].adi_ether->p1722PktCb = avtpRxFrame;
+
+    xTaskCreate(avtpTxTask, "AvtpTxTask", AVTP_TASK_STACK_SIZE,
+        context, AVTP_TASK_PRIORITY, &context->avtpTxTaskHandle );
+}
+
+/* Transfers AVTP Tx audio (ISR context) */
+int xferAvtpTxAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd,
+    unsigned *numChannels)
+{
+    unsigned samplesIn;
+    unsigned samplesOut;
+    AVTP_STREAM *avtpTx = &context->avtpTx;
+    PaUtilRingBuffer *avtpTxRB = context->avtpTxRB;
+    CLOCK_DOMAIN myCd;
+
+    static bool first = true;
+
+    myCd = clock_domain_get(context, CLOCK_DOMAIN_BITM_AVTP_TX);
+    if (myCd != cd) {
+        return(0);
+    }
+    clock_domain_set_active(context, myCd, CLOCK_DOMAIN_BITM_AVTP_TX);
+
+    *audio = audio_pool_ring_block(avtpTxRB);
+    if (!avtpTx->enabled || (*audio == NULL)) {
+        *numChannels = 0;
+        first = true;
+        return(1);
+    }
+
+    /*
+     * Sees what the Tx task has sent since the last block.  It leaves
+     * less than a packet behind so the one block watermark re-arms.
+     */
+    audio_pool_ring_update(avtpTxRB);
+
+    samplesIn = avtpTx->channels * SYSTEM_BLOCK_SIZE;
+    samplesOut = PaUtil_GetRingBufferWriteAvailable(avtpTxRB);
+
+    if ((samplesIn == 0) || (samplesOut == 0)) {
+         *numChannels = 0;
+        return(1);
+    }
+
+    if (samplesIn <= samplesOut) {
+        if (!first) {
+            PaUtil_WriteRingBuffer(avtpTxRB, *audio, samplesIn);
+        }
+    } else {
+        avtpTxOverflow++;
+    }
+
+    memset(*audio, 0, samplesIn * sizeof(SYSTEM_AUDIO_TYPE));
+    *numChannels = avtpTx->channels;
+    first = false;
+
+    audio_pool_ring_update(avtpTxRB);
+
+    return(1);
+}
+
+/*
+ * Transfers AVTP Rx audio (ISR context).  While pre-rolling nothing is
+ * played until the gPTP time reaches the presentation time of the
+ * oldest buffered sample.  Audio that is already more than a transit
+ * time late is discarded so playout restarts on fresh packets.
+ */
+int xferAvtpRxAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd,
+    unsigned *numChannels)
+{
+    unsigned samplesIn;
+    unsigned samplesOut;
+    AVTP_STREAM *avtpRx = &context->avtpRx;
+    PaUtilRingBuffer *avtpRxRB = context->avtpRxRB;
+    CLOCK_DOMAIN myCd;
+    int32_t late;
+
+    myCd = clock_domain_get(context, CLOCK_DOMAIN_BITM_AVTP_RX);
+    if (myCd != cd) {
+        return(0);
+    }
+    clock_domain_set_active(context, myCd, CLOCK_DOMAIN_BITM_AVTP_RX);
+
+    *audio = audio_pool_ring_block(avtpRxRB);
+    if (*audio == NULL) {
+        avtpRxPlayTimeValid = false;
+        *numChannels = 0;
+        return(1);
+    }
+
+    samplesIn = PaUtil_GetRingBufferReadAvailable(avtpRxRB);
+
+    /* Drain stale audio from the consumer side while stopped */
+    if (!avtpRx->enabled) {
+        PaUtil_AdvanceRingBufferReadIndex(avtpRxRB, samplesIn);
+        avtpRxPlayTimeValid = false;
+        *numChannels = 0;
+        return(1);
+    }
+
+    if (avtpRx->preRoll) {
+        *numChannels = 0;
+        if (!avtpRxPlayTimeValid) {
+            return(1);
+        }
+        late = (int32_t)(avtpLinkNow(avtpRx->link.linkPtr) - avtpRxPlayTime);
+        if (late < 0) {
+            return(1);
+        }
+        if (late > (int32_t)avtpRx->transitTime) {
+            PaUtil_AdvanceRingBufferReadIndex(avtpRxRB, samplesIn);
+            avtpRxPlayTimeValid = false;
+            avtpRxLate++;
+            return(1);
+        }
+        avtpRx->preRoll = false;
+    }
+
+    samplesOut = avtpRx->channels * SYSTEM_BLOCK_SIZE;
+
+    if ((samplesIn == 0) || (samplesOut == 0)) {
+        *numChannels = 0;
+        return(1);
+    }
+
+    if (samplesIn >= samplesOut) {
+        PaUtil_ReadRingBuffer(avtpRxRB, *audio, samplesOut);
+        *numChannels = avtpRx->channels;
+    } else {
+        /* Resynchronize to the presentation time of the next packet */
+        PaUtil_AdvanceRingBufferReadIndex(avtpRxRB, samplesIn);
+        avtpRxPlayTimeValid = false;
+        avtpRx->preRoll = true;
+        avtpRxUnderflow++;
+        *numChannels = 0;
+    }
+
+    return(1);
+}
@@ -0,0 +1,30 @@
+/**
+ * Copyright (c) 2022 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _avtp_audio_h
+#define _avtp_audio_h
+
+#include "context.h"
+#include "ipc.h"
+
+void avtp_audio_init(APP_CONTEXT *context);
+bool avtp_audio_open(APP_CONTEXT *context, AVTP_STREAM *as);
+void avtp_audio_close(APP_CONTEXT *context, AVTP_STREAM *as);
+
+int xferAvtpRxAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd,
+    unsigned *numChannels);
+int xferAvtpTxAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd,
+    unsigned *numChannels);
+
+void avtpAudioStats(unsigned *rxUnderflow, unsigned *rxOverflow,
+    unsigned *rxLate, unsigned *txOverflow);
+
+#endif
@@ -13,6 +13,7 @@
 #include "context.h"
 #include "clock_domain_defs.h"
 #include "clock_domain.h"
+#include "media_clock.h"
 
 char *clock_domain_str(CLOCK_DOMAIN domain)
 {
@@ -109,6 +110,13 @@ bool clock_domain_ready(APP_CONTEXT *context, CLOCK_DOMAIN domain)
 
 void clock_domain_init(APP_CONTEXT *context)
 {
+    unsigned cd;
+
+    for (cd = 0; cd < CLOCK_DOMAIN_MAX; cd++) {
+        mediaClockInit(&context->mediaClock[cd],
+            SYSTEM_SAMPLE_RATE, SYSTEM_BLOCK_SIZE);
+    }
+
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_CODEC_IN);
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_CODEC_OUT);
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_SPDIF_IN);
@@ -119,9 +127,15 @@ void clock_domain_init(APP_CONTEXT *context)
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_WAV_SINK);
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_VU_IN);
     clock_domain_set(context, CLOCK_DOMAIN_RTP, CLOCK_DOMAIN_BITM_RTP_RX);
+    clock_domain_set(context, CLOCK_DOMAIN_RTP, CLOCK_DOMAIN_BITM_RTP2_RX);
+    clock_domain_set(context, CLOCK_DOMAIN_RTP, CLOCK_DOMAIN_BITM_RTP3_RX);
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_RTP_TX);
     clock_domain_set(context, CLOCK_DOMAIN_VBAN, CLOCK_DOMAIN_BITM_VBAN_RX);
+    clock_domain_set(context, CLOCK_DOMAIN_VBAN, CLOCK_DOMAIN_BITM_VBAN2_RX);
+    clock_domain_set(context, CLOCK_DOMAIN_VBAN, CLOCK_DOMAIN_BITM_VBAN3_RX);
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_VBAN_TX);
+    clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_AVTP_RX);
+    clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_AVTP_TX);
 #ifdef SHARC_AUDIO_ENABLE
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_SHARC0_IN);
     clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_SHARC0_OUT);
@@ -41,6 +41,12 @@ enum {
     CLOCK_DOMAIN_BITM_VBAN_TX    = 0x00040000u,
     CLOCK_DOMAIN_BITM_A2B2_IN    = 0x00080000u,
     CLOCK_DOMAIN_BITM_A2B2_OUT   = 0x00100000u,
+    CLOCK_DOMAIN_BITM_RTP2_RX    = 0x00200000u,
+    CLOCK_DOMAIN_BITM_RTP3_RX    = 0x00400000u,
+    CLOCK_DOMAIN_BITM_VBAN2_RX   = 0x00800000u,
+    CLOCK_DOMAIN_BITM_VBAN3_RX   = 0x01000000u,
+    CLOCK_DOMAIN_BITM_AVTP_RX    = 0x02000000u,
+    CLOCK_DOMAIN_BITM_AVTP_TX    = 0x04000000u,
 };
 
 #endif
@@ -31,12 +31,18 @@
 #include "ipc.h"
 #include "a2b_to_sport_cfg.h"
 #include "wav_file.h"
+#include "wav_cue.h"
 #include "clock_domain_defs.h"
 #include "spiffs.h"
 #include "route.h"
 #include "uac2.h"
 #include "rtp_stream.h"
 #include "vban_stream.h"
+#include "avtp_stream.h"
+#include "gptp.h"
+#include "media_clock.h"
+#include "sharc_sched.h"
+#include "fft_queue.h"
 
 #include "lwip_adi_ether_netif.h"
 #include "lwip/netif.h"
@@ -73,11 +79,32 @@
 #define USB_OUT_RING_BUFF_FILL         (USB_OUT_RING_BUFF_FRAMES / 2)
 #define USB_IN_RING_BUFF_FILL          (USB_IN_RING_BUFF_FRAMES / 2)
 
-#define WAV_RING_BUF_SAMPLES           (128 * 1024)
-#define RTP_RING_BUF_SAMPLES           (128 * 1024)
-#define VBAN_RING_BUF_SAMPLES          (128 * 1024)
+/*
+ * WAV, RTP, VBAN and AVTP rings come from the audio pool when a stream
+ * is opened.  They are sized to hold this much audio at the stream's
+ * channel count.
+ */
+#define WAV_RING_LATENCY_MS            (500)
+#define RTP_RING_LATENCY_MS            (250)
+#define VBAN_RING_LATENCY_MS           (250)
+#define AVTP_RING_LATENCY_MS           (100)
+
+/* Track cache read-ahead is topped up at least this often */
+#define TRACK_CACHE_POLL_MS            (10)
+
+/* A wav task without its scratch buffer tries again after this long */
+#define WAV_SCRATCH_RETRY_MS           (10)
+
+/* Blocks queued in a network Tx ring before its task is woken */
+#define RTP_TX_WAKE_BLOCKS             (8)
+#define VBAN_TX_WAKE_BLOCKS            (8)
+#define AVTP_TX_WAKE_BLOCKS            (1)
 #define FILE_RING_BUF_SAMPLES          (128 * 1024)
 
+/* Concurrent network receive streams, each with its own jitter buffer */
+#define RTP_RX_STREAMS                 (3)
+#define VBAN_RX_STREAMS                (3)
+
 #define WAV_MAX_CHANNELS               (64)
 #define VU_MAX_CHANNELS                (64)
 
@@ -95,6 +122,44 @@
 #define SHARC1_AUDIO_IN_CHANNELS    (SYSTEM_MAX_CHANNELS)
 #define SHARC1_AUDIO_OUT_CHANNELS   (SYSTEM_MAX_CHANNELS)
 
+/*
+ * Zero added latency SHARC mode.  The audio ISR waits at most this long
+ * for both SHARCs to finish a block before falling back to the previous
+ * block's output.
+ */
+#define SHARC_SYNC_TIMEOUT_US       (250)
+#define SHARC_SYNC_DEFAULT          (false)
+
+/*
+ * Send each clock domain block to the SHARCs as one IPC_TYPE_BLOCK
+ * message carrying every SHARC stream, one interrupt per core per
+ * block.  Set to 0 for the original per-stream IPC_TYPE_AUDIO and
+ * IPC_TYPE_PROCESS_AUDIO messages.
+ */
+#define SHARC_IPC_BLOCK             (1)
+
+/*
+ * SHARC0 -> SHARC1 link channels and the default for chaining the
+ * SHARCs through it, which needs SHARC_IPC_BLOCK.
+ */
+#define SHARC_LINK_CHANNELS         (SYSTEM_MAX_CHANNELS)
+#define SHARC_CHAIN_DEFAULT         (false)
+
+/*
+ * Share the SHARC DSP jobs between the cores by measured cost, needs
+ * SHARC_IPC_BLOCK.  Off runs each SHARC's own streams on that SHARC.
+ */
+#define SHARC_SCHED_DEFAULT         (true)
+
+/*
+ * Carry the SHARC streams as float32 (full scale +/-1.0) rather than
+ * SYSTEM_AUDIO_TYPE.  The router converts on routes between a SHARC
+ * stream and the fixed point hardware, USB and network streams, and
+ * sums routes between SHARC streams in float with no clipping.  The
+ * buffers are the same size either way.
+ */
+#define SHARC_AUDIO_FLOAT           (0)
+
 /*
  * The A2B I2C addresses are latched at power up and cannot be changed
  * at runtime. Use the 'a2b' command to set the I2C address at runtime to
@@ -261,10 +326,11 @@ typedef struct _APP_CONTEXT {
     TaskHandle_t a2bIrqTaskHandle;
     TaskHandle_t telnetTaskHandle;
     TaskHandle_t vuTaskHandle;
-    TaskHandle_t rtpRxTaskHandle;
     TaskHandle_t rtpTxTaskHandle;
-    TaskHandle_t vbanRxTaskHandle;
     TaskHandle_t vbanTxTaskHandle;
+    TaskHandle_t avtpTxTaskHandle;
+    TaskHandle_t fftQueueTaskHandle;
+    TaskHandle_t gptpTaskHandle;
 
     /* A2B XML init items */
     void *a2bInitSequence;
@@ -281,6 +347,7 @@ typedef struct _APP_CONTEXT {
     void *sharc0AudioOut[2];
     void *sharc1AudioIn[2];
     void *sharc1AudioOut[2];
+    void *sharcLinkAudio[2];
     void *a2b2AudioIn[2];
     void *a2b2AudioOut[2];
 
@@ -295,12 +362,14 @@ typedef struct _APP_CONTEXT {
     unsigned sharc0AudioOutLen;
     unsigned sharc1AudioInLen;
     unsigned sharc1AudioOutLen;
+    unsigned sharcLinkAudioLen;
 
     /* SAE buffer pointers */
     SAE_MSG_BUFFER *sharc0MsgIn[2];
     SAE_MSG_BUFFER *sharc0MsgOut[2];
     SAE_MSG_BUFFER *sharc1MsgIn[2];
     SAE_MSG_BUFFER *sharc1MsgOut[2];
+    SAE_MSG_BUFFER *sharcLinkMsg[2];
 
     /* Audio routing table */
     ROUTE_INFO *routingTable;
@@ -319,29 +388,48 @@ typedef struct _APP_CONTEXT {
     uint32_t sharc0Cycles[CLOCK_DOMAIN_MAX];
     uint32_t sharc1Cycles[CLOCK_DOMAIN_MAX];
 
+    /* Zero added latency SHARC mode */
+    volatile bool sharcSync;
+    uint32_t sharcSyncBlocks;
+    uint32_t sharcSyncMisses;
+    uint32_t sharcSyncWaitPeak;
+
+    /* SHARC0 -> SHARC1 chained through sharcLinkAudio */
+    volatile bool sharcChain;
+
+    /* SHARC DSP job scheduler */
+    SHARC_SCHED sharcSched;
+
+    /* Shared FFT accelerator job queue */
+    FFT_QUEUE fftQueue;
+#if defined(__ADSPARM__)
+    FFT_QUEUE_ACCEL fftAccel;
+#endif
+
     /* WAV file related variables and settings */
     WAV_FILE wavSrc;
     WAV_FILE wavSink;
     PaUtilRingBuffer *wavSrcRB;
-    void *wavSrcRBData;
     PaUtilRingBuffer *wavSinkRB;
-    void *wavSinkRBData;
+    WAV_CUE wavSrcCue;
 
     /* RTP related variables and settings */
-    RTP_STREAM rtpRx;
+    RTP_STREAM rtpRx[RTP_RX_STREAMS];
     RTP_STREAM rtpTx;
-    PaUtilRingBuffer *rtpRxRB;
-    void *rtpRxRBData;
+    PaUtilRingBuffer *rtpRxRB[RTP_RX_STREAMS];
     PaUtilRingBuffer *rtpTxRB;
-    void *rtpTxRBData;
 
     /* VBAN related variables and settings */
-    VBAN_STREAM vbanRx;
+    VBAN_STREAM vbanRx[VBAN_RX_STREAMS];
     VBAN_STREAM vbanTx;
-    PaUtilRingBuffer *vbanRxRB;
-    void *vbanRxRBData;
+    PaUtilRingBuffer *vbanRxRB[VBAN_RX_STREAMS];
     PaUtilRingBuffer *vbanTxRB;
-    void *vbanTxRBData;
+
+    /* IEEE 1722 AAF related variables and settings */
+    AVTP_STREAM avtpRx;
+    AVTP_STREAM avtpTx;
+    PaUtilRingBuffer *avtpRxRB;
+    PaUtilRingBuffer *avtpTxRB;
 
     /* A2B mode */
     A2B_BUS_MODE a2bmode;
@@ -356,6 +444,12 @@ typedef struct _APP_CONTEXT {
     /* Clock domain management */
     uint32_t clockDomainMask[CLOCK_DOMAIN_MAX];
     uint32_t clockDomainActive[CLOCK_DOMAIN_MAX];
+    MEDIA_CLOCK mediaClock[CLOCK_DOMAIN_MAX];
+
+    /* 802.1AS time synchronization */
+    GPTP gptp;
+    void *gptpLock;
+    bool gptpRunning;
 
     /* Ethernet Network interface */
     ETH eth[2];
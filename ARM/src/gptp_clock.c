@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2022 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "context.h"
+#include "clocks.h"
+#include "gptp.h"
+#include "gptp_clock.h"
+#include "lwip_adi_ether_netif.h"
+
+#define GPTP_POLL_MS  (100)
+
+/* 802.1AS link-local multicast address */
+static const uint8_t GPTP_DST_MAC[6] = {
+    0x01, 0x80, 0xC2, 0x00, 0x00, 0x0E
+};
+
+static bool gptpLocalNow(struct netif *netif, uint64_t *now)
+{
+    uint32_t second, nanoSecond;
+    err_t err;
+
+    err = adi_ether_netif_ptp_time(netif, &second, &nanoSecond);
+    if (err != ERR_OK) {
+        return(false);
+    }
+    *now = (uint64_t)second * 1000000000ULL + nanoSecond;
+
+    return(true);
+}
+
+bool gptpClockNow(APP_CONTEXT *context, uint64_t *now)
+{
+    uint64_t local;
+
+    if (!context->gptpRunning) {
+        return(false);
+    }
+    if (!gptpLocalNow(&context->eth[0].netif, &local)) {
+        return(false);
+    }
+    gptpLocalToMaster(&context->gptp, local, now);
+
+    return(true);
+}
+
+static int gptpTxMsg(void *linkPtr, uint8_t *msg, unsigned len, bool timestamp)
+{
+    struct netif *netif = (struct netif *)linkPtr;
+
+    return(adi_ether_netif_ptp_tx_frame(netif, netif->hwaddr,
+        (uint8_t *)GPTP_DST_MAC, GPTP_ETHTYPE, msg, len, timestamp));
+}
+
+/*
+ * PTP frames (timestamped or not) from the EMAC worker task.  'pktData'
+ * starts at the destination MAC and 'pktSize' includes the driver's
+ * 2 byte length field.  General messages arrive with a zero time.
+ */
+static void gptpPktCb(adi_ether_netif *adi_ether, uint8_t *pktData,
+    uint16_t pktSize, uint8_t pktType, uint32_t second, uint32_t nanoSecond)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)adi_ether->usrPtr;
+    unsigned len = pktSize - sizeof(uint16_t);
+    uint64_t t;
+
+    if ((second == 0) && (nanoSecond == 0)) {
+        if (!gptpLocalNow(&context->eth[0].netif, &t)) {
+            return;
+        }
+    } else {
+        t = (uint64_t)second * 1000000000ULL + nanoSecond;
+    }
+
+    xSemaphoreTake((SemaphoreHandle_t)context->gptpLock, portMAX_DELAY);
+    if (pktType == ADI_ETHER_PKT_TYPE_TX) {
+        gptpTxTimestamp(&context->gptp, pktData, len, t);
+    } else {
+        gptpRecvFrame(&context->gptp, pktData, len, t);
+    }
+    xSemaphoreGive((SemaphoreHandle_t)context->gptpLock);
+}
+
+/* This task runs the gPTP timeouts and peer delay requests */
+portTASK_FUNCTION(gptpTask, pvParameters)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
+    uint64_t now;
+
+    while (1) {
+        if (gptpLocalNow(&context->eth[0].netif, &now)) {
+            xSemaphoreTake((SemaphoreHandle_t)context->gptpLock, portMAX_DELAY);
+            gptpPoll(&context->gptp, now);
+            xSemaphoreGive((SemaphoreHandle_t)context->gptpLock);
+        }
+        vTaskDelay(pdMS_TO_TICKS(GPTP_POLL_MS));
+    }
+}
+
+void gptp_clock_init(APP_CONTEXT *context)
+{
+    struct netif *netif = &context->eth[0].netif;
+    GPTP *g = &context->gptp;
+    err_t err;
+
+    /* EUI-64 clock identity from the MAC address */
+    memcpy(g->clockIdentity, netif->hwaddr, 3);
+    g->clockIdentity[3] = 0xFF;
+    g->clockIdentity[4] = 0xFE;
+    memcpy(g->clockIdentity + 5, netif->hwaddr + 3, 3);
+    g->link.txMsg = gptpTxMsg;
+    g->link.linkPtr = netif;
+    gptpInit(g);
+
+    context->gptpLock = (SemaphoreHandle_t)xSemaphoreCreateMutex();
+
+    /* The EMAC PTP clock is the free running local time base */
+    err = adi_ether_netif_ptp_start(netif, SCLK0);
+    if (err != ERR_OK) {
+        return;
+    }
+    context->eth[0].adi_ether->ptpPktCb = gptpPktCb;
+    context->gptpRunning = true;
+
+    xTaskCreate(gptpTask, "GptpTask", GPTP_TASK_STACK_SIZE,
+        context, GPTP_TASK_PRIORITY, &context->gptpTaskHandle );
+}
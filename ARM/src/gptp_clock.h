@@ -0,0 +1,29 @@
+/**
+ * Copyright (c) 2022 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _gptp_clock_h
+#define _gptp_clock_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "context.h"
+
+void gptp_clock_init(APP_CONTEXT *context);
+
+/*
+ * Returns the current gPTP time in ns (ISR safe).  Until the servo has
+ * a master this is the free running EMAC time.  Returns false if the
+ * EMAC time base isn't running yet.
+ */
+bool gptpClockNow(APP_CONTEXT *context, uint64_t *now);
+
+#endif
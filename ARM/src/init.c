@@ -1554,6 +1554,16 @@ void sae_buffer_init(APP_CONTEXT *context)
             &context->sharc1AudioOut[i]
         );
         memset(context->sharc1AudioOut[i], 0, context->sharc1AudioOutLen);
+
+        /* SHARC0 -> SHARC1 link, the ARM never touches the audio */
+        context->sharcLinkAudioLen =
+            SHARC_LINK_CHANNELS * sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+        context->sharcLinkMsg[i] = allocateIpcAudioMsg(
+            context, context->sharcLinkAudioLen,
+            IPC_STREAMID_SHARC_LINK, SHARC_LINK_CHANNELS, sizeof(SYSTEM_AUDIO_TYPE),
+            &context->sharcLinkAudio[i]
+        );
+        memset(context->sharcLinkAudio[i], 0, context->sharcLinkAudioLen);
     }
 }
 
@@ -1563,6 +1573,12 @@ void sae_buffer_init(APP_CONTEXT *context)
 void audio_routing_init(APP_CONTEXT *context)
 {
     context->routingTable = calloc(MAX_AUDIO_ROUTES, sizeof(ROUTE_INFO));
+    context->sharcSync = SHARC_SYNC_DEFAULT;
+    context->sharcChain = SHARC_CHAIN_DEFAULT;
+    sharc_sched_init(&context->sharcSched,
+        (uint32_t)(((uint64_t)CCLK * SYSTEM_BLOCK_SIZE) / SYSTEM_SAMPLE_RATE));
+    sharc_sched_enable(&context->sharcSched,
+        SHARC_IPC_BLOCK && SHARC_SCHED_DEFAULT);
 }
 
 /**********************************************************************
@@ -57,6 +57,9 @@
 #include "vu_audio.h"
 #include "rtp_audio.h"
 #include "vban_audio.h"
+#include "audio_pool.h"
+#include "trace_syslog.h"
+#include "sched_trace.h"
 #include "a2b_slave.h"
 #include "clock_domain.h"
 #include "cpu_load.h"
@@ -64,6 +67,10 @@
 #include "a2b_irq.h"
 #include "uac2.h"
 #include "ethernet_init.h"
+#include "xyz_utils.h"
+#include "sharc_audio.h"
+#include "avtp_audio.h"
+#include "gptp_clock.h"
 #include "ipc.h"
 #include "pushbutton.h"
 #include "exception.h"
@@ -194,6 +201,10 @@ uint32_t rtosTimeMs()
 SAE_RESULT ipcToCore(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *ipcBuffer, SAE_CORE_IDX core)
 {
     SAE_RESULT result;
+    IPC_MSG *msg;
+
+    msg = (IPC_MSG *)sae_getMsgBufferPayload(ipcBuffer);
+    SCHED_TRACE(SCHED_TRACE_IPC_TX, core, msg->type);
 
     result = sae_sendMsgBuffer(saeContext, ipcBuffer, core, true);
     if (result != SAE_RESULT_OK) {
@@ -230,6 +241,8 @@ static void ipcMsgHandler(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *buffer,
     SAE_RESULT result;
     uint32_t max, i;
 
+    SCHED_TRACE(SCHED_TRACE_IPC_RX, msg->type, 0);
+
     /* Process the message */
     switch (msg->type) {
         case IPC_TYPE_PING:
@@ -252,6 +265,14 @@ static void ipcMsgHandler(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *buffer,
                     context->sharc1Cycles[i] = cycles->cycles[i];
                 }
             }
+            sharc_sched_cycles(&context->sharcSched, cycles->jobCycles);
+            sharc_sched_balance(&context->sharcSched);
+            break;
+        case IPC_TYPE_TRACE_LOG:
+            /* Keep the reference, the SHARC writes the log in place */
+            if (trace_log_attach(&msg->traceLog)) {
+                return;
+            }
             break;
         default:
             break;
@@ -332,6 +353,17 @@ static void sdcardCheck(APP_CONTEXT *context)
     }
 }
 
+/*
+ * Owns the FFT accelerator, starts and finishes every queued job.  Sits
+ * at the lowest priority and takes on that of the tasks it works for.
+ */
+static portTASK_FUNCTION( fftQueueTask, pvParameters )
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
+
+    fft_queue_run(&context->fftQueue);
+}
+
 /* Background storage polling task */
 static portTASK_FUNCTION( pollStorage, pvParameters )
 {
@@ -479,6 +511,7 @@ static portTASK_FUNCTION( startupTask, pvParameters )
     SDCARD_SIMPLE_RESULT sdcardResult;
     FS_DEVMAN_DEVICE *device;
     FS_DEVMAN_RESULT fsdResult;
+    FFT_QUEUE_LEASE fftLease;
     s32_t spiffsResult;
 
     /* Install exception handlers */
@@ -599,6 +632,18 @@ static portTASK_FUNCTION( startupTask, pvParameters )
     /* Initialize the audio routing table */
     audio_routing_init(context);
 
+    /* Share the FFT accelerator through the job queue, and with SHARC0 */
+    fft_queue_accel_init(&context->fftAccel, &context->fftQueue);
+    if (sharcFftLease(context, &fftLease)) {
+        fft_queue_accel_lease(&context->fftAccel, &fftLease);
+    }
+    xTaskCreate(fftQueueTask, "FftQueueTask", FFT_QUEUE_TASK_STACK_SIZE,
+        context, FFT_QUEUE_TASK_PRIORITY, &context->fftQueueTaskHandle);
+    xyz_set_fft_queue(&context->fftQueue);
+
+    /* Initialize the streaming audio buffer pool */
+    audio_pool_init();
+
     /* Initialize the wave audio module */
     wav_audio_init(context);
 
@@ -652,6 +697,12 @@ static portTASK_FUNCTION( startupTask, pvParameters )
     /* Initialize lwIP and the Ethernet interfaces */
     ethernet_init(context, &context->eth[0], &context->cfg.eth0);
 
+    /* Start 802.1AS time synchronization (needs the EMAC) */
+    gptp_clock_init(context);
+
+    /* Initialize the IEEE 1722 audio module (needs gPTP) */
+    avtp_audio_init(context);
+
     /* Start the UAC20 task */
     xTaskCreate( uac2Task, "UAC2Task", UAC20_TASK_STACK_SIZE,
         context, UAC20_TASK_PRIORITY, &context->uac2TaskHandle );
@@ -725,6 +776,9 @@ int main(int argc, char *argv[])
     /* Init the system logger */
     syslog_init();
 
+    /* Init the binary trace log */
+    trace_syslog_init();
+
     /* Initialize the simple UART driver */
     uartResult = uart_init();
 
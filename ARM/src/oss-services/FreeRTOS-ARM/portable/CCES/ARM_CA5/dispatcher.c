@@ -19,6 +19,14 @@
 /* Scheduler includes. */
 #include "FreeRTOS.h"
 
+/* Optional interrupt entry/exit trace hooks (FreeRTOSConfig.h) */
+#ifndef traceISR_ENTER
+#define traceISR_ENTER(iid)
+#endif
+#ifndef traceISR_EXIT
+#define traceISR_EXIT(iid)
+#endif
+
 /* Dispatched interrupt vector table, defined by CCES runtime */
 extern adi_dispatched_data_t adi_dispatched_int_vector_table[ADI_DISPATCHED_VECTOR_TABLE_SIZE];
 
@@ -60,6 +68,8 @@ void vApplicationIRQHandler( uint32_t ulICCIAR )
 		/* Call the interrupt handler, as a plain C function, passing the interrupt ID and the
 		 * user-provided parameter as arguments.
 		 */
+		traceISR_ENTER(iid);
 		(*adi_dispatched_int_vector_table[idx].handler)(iid, (adi_dispatched_callback_arg_t)(adi_dispatched_int_vector_table[idx].callback_arg));
+		traceISR_EXIT(iid);
 	}
 }
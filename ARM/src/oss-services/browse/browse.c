@@ -85,6 +85,8 @@ static FileExt getFileExtension(const char *fname) {
         return EXT_WAV;
     } else if (browse_stricmp(ext, "mp3") == 0) {
         return EXT_MP3;
+    } else if (browse_stricmp(ext, "flac") == 0) {
+        return EXT_FLAC;
     }
 
     return EXT_UNKNOWN;
@@ -387,6 +389,7 @@ void browseRefreshScreen(void) {
             const char *ext_str = "";
             if (ext == EXT_WAV) ext_str = "wav";
             else if (ext == EXT_MP3) ext_str = "mp3";
+            else if (ext == EXT_FLAC) ext_str = "flac";
 
             char *render_ptr = r->render + B.coloff;
             int rlen = strlen(render_ptr);
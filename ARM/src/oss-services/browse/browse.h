@@ -121,7 +121,8 @@ typedef enum {
 typedef enum {
     EXT_UNKNOWN = -1,
     EXT_WAV = 0,
-    EXT_MP3 = 1
+    EXT_MP3 = 1,
+    EXT_FLAC = 2
 } FileExt;
 
 /*!****************************************************************
@@ -78,6 +78,8 @@ SHELL_FUNC( shell_cmp );
 SHELL_FUNC( shell_a2b );
 SHELL_FUNC( shell_rtp );
 SHELL_FUNC( shell_vban );
+SHELL_FUNC( shell_avtp );
+SHELL_FUNC( shell_ptp );
 SHELL_FUNC( shell_cmdlist );
 SHELL_FUNC( shell_edit );
 SHELL_FUNC( shell_drive );
@@ -86,9 +88,13 @@ SHELL_FUNC( shell_dump );
 SHELL_FUNC( shell_fdump );
 SHELL_FUNC( shell_vu );
 SHELL_FUNC( shell_eth );
+SHELL_FUNC( shell_iperf );
 SHELL_FUNC( shell_resize );
 SHELL_FUNC( shell_date );
 SHELL_FUNC( shell_browse );
+SHELL_FUNC( shell_sched );
+SHELL_FUNC( shell_sharc );
+SHELL_FUNC( shell_fft );
 
 SHELL_HELP( help );
 SHELL_HELP( ver );
@@ -120,6 +126,8 @@ SHELL_HELP( cmp );
 SHELL_HELP( a2b );
 SHELL_HELP( rtp );
 SHELL_HELP( vban );
+SHELL_HELP( avtp );
+SHELL_HELP( ptp );
 SHELL_HELP( cmdlist );
 SHELL_HELP( edit );
 SHELL_HELP( drive );
@@ -128,9 +136,13 @@ SHELL_HELP( dump );
 SHELL_HELP( fdump );
 SHELL_HELP( vu );
 SHELL_HELP( eth );
+SHELL_HELP( iperf );
 SHELL_HELP( resize );
 SHELL_HELP( date );
 SHELL_HELP( browse );
+SHELL_HELP( sched );
+SHELL_HELP( sharc );
+SHELL_HELP( fft );
 
 //static const SHELL_COMMAND shell_commands[] =
 const SHELL_COMMAND shell_commands[] =
@@ -170,6 +182,8 @@ const SHELL_COMMAND shell_commands[] =
   { "a2b", shell_a2b },
   { "rtp", shell_rtp },
   { "vban", shell_vban },
+  { "avtp", shell_avtp },
+  { "ptp", shell_ptp },
   { "cmdlist", shell_cmdlist },
   { "edit", shell_edit },
   { "drive", shell_drive },
@@ -178,9 +192,13 @@ const SHELL_COMMAND shell_commands[] =
   { "fdump", shell_fdump },
   { "vu", shell_vu },
   { "eth", shell_eth },
+  { "iperf", shell_iperf },
   { "resize", shell_resize },
   { "date", shell_date },
   { "browse", shell_browse },
+  { "sched", shell_sched },
+  { "sharc", shell_sharc },
+  { "fft", shell_fft },
   { "exit", NULL },
   { NULL, NULL }
 };
@@ -217,6 +235,8 @@ static const SHELL_HELP_DATA shell_help_data[] =
   SHELL_INFO( a2b ),
   SHELL_INFO( rtp ),
   SHELL_INFO( vban ),
+  SHELL_INFO( avtp ),
+  SHELL_INFO( ptp ),
   SHELL_INFO( cmdlist ),
   SHELL_INFO( edit ),
   SHELL_INFO( drive ),
@@ -225,9 +245,13 @@ static const SHELL_HELP_DATA shell_help_data[] =
   SHELL_INFO( fdump ),
   SHELL_INFO( vu ),
   SHELL_INFO( eth ),
+  SHELL_INFO( iperf ),
   SHELL_INFO( resize ),
   SHELL_INFO( date ),
   SHELL_INFO( browse ),
+  SHELL_INFO( sched ),
+  SHELL_INFO( sharc ),
+  SHELL_INFO( fft ),
   { NULL, NULL, NULL }
 };
 
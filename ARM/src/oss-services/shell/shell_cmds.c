@@ -641,9 +641,10 @@ void shell_i2c_probe(SHELL_CONTEXT *ctx, int argc, char **argv)
  * CMD: syslog
  **********************************************************************/
 const char shell_help_syslog[] = "\n";
-const char shell_help_summary_syslog[] = "Show the live system log";
+const char shell_help_summary_syslog[] = "Show the live system and trace log";
 
 #include "syslog.h"
+#include "trace_syslog.h"
 
 #define MAX_TS_LINE  32
 #define MAX_LOG_LINE 256
@@ -660,6 +661,7 @@ void shell_syslog(SHELL_CONTEXT *ctx, int argc, char **argv)
 
     c = 0;
     do {
+        trace_syslog_drain();
         line = syslog_next(ts, MAX_TS_LINE, lbuf, MAX_LOG_LINE);
         if (line) {
             printf("%s %s\n", ts, line);
@@ -1465,10 +1467,10 @@ void shell_stacks( SHELL_CONTEXT *ctx, int argc, char **argv )
     shell_print_task_stack(ctx, context->a2bIrqTaskHandle);
     shell_print_task_stack(ctx, context->telnetTaskHandle);
     shell_print_task_stack(ctx, context->vuTaskHandle);
-    shell_print_task_stack(ctx, context->rtpRxTaskHandle);
     shell_print_task_stack(ctx, context->rtpTxTaskHandle);
-    shell_print_task_stack(ctx, context->vbanRxTaskHandle);
     shell_print_task_stack(ctx, context->vbanTxTaskHandle);
+    shell_print_task_stack(ctx, context->avtpTxTaskHandle);
+    shell_print_task_stack(ctx, context->gptpTaskHandle);
 }
 
 /***********************************************************************
@@ -1491,12 +1493,16 @@ void shell_cpu( SHELL_CONTEXT *ctx, int argc, char **argv )
 
     printf("SHARC0 Load:\n");
     for (i = 0; i < CLOCK_DOMAIN_MAX; i++) {
-        printf(" %s: %lu cycles\n", clock_domain_str(i), context->sharc0Cycles[i]);
+        printf(" %s: %lu cycles (%lu%%)\n", clock_domain_str(i),
+            context->sharc0Cycles[i], (unsigned long)(((uint64_t)
+            context->sharc0Cycles[i] * 100) / context->sharcSched.budget));
     }
 
     printf("SHARC1 Load:\n");
     for (i = 0; i < CLOCK_DOMAIN_MAX; i++) {
-        printf(" %s: %lu cycles\n", clock_domain_str(i), context->sharc1Cycles[i]);
+        printf(" %s: %lu cycles (%lu%%)\n", clock_domain_str(i),
+            context->sharc1Cycles[i], (unsigned long)(((uint64_t)
+            context->sharc1Cycles[i] * 100) / context->sharcSched.budget));
     }
 }
 
@@ -1698,11 +1704,13 @@ void shell_update(SHELL_CONTEXT *ctx, int argc, char **argv)
 /***********************************************************************
  * CMD: meminfo
  **********************************************************************/
-const char shell_help_meminfo[] = "\n";
+const char shell_help_meminfo[] = "[reset]\n"
+  "  reset - Clear the heap allocation counters and latencies\n";
 const char shell_help_summary_meminfo[] = "Displays UMM_MALLOC heap statistics";
 
 #include "umm_malloc_cfg.h"
 #include "umm_malloc_heaps.h"
+#include "audio_pool.h"
 #include "sae.h"
 
 const static char *heapNames[] = UMM_HEAP_NAMES;
@@ -1711,11 +1719,16 @@ void shell_meminfo(SHELL_CONTEXT *ctx, int argc, char **argv )
 {
     int i;
     int ok;
+    bool reset;
+
+    reset = (argc > 1) && (strcmp(argv[1], "reset") == 0);
 
     /* UMM Malloc */
     UMM_HEAP_INFO ummHeapInfo;
+    UMM_HEAP_STATS ummHeapStats;
     for (i = 0; i < UMM_NUM_HEAPS; i++) {
-        printf("Heap %s Info:\n", heapNames[i]);
+        printf("Heap %s Info (%s):\n", heapNames[i],
+            umm_heap_allocator((umm_heap_t)i));
         ok = umm_integrity_check((umm_heap_t)i);
         if (ok) {
             umm_info((umm_heap_t)i, &ummHeapInfo, NULL, 0);
@@ -1724,19 +1737,45 @@ void shell_meminfo(SHELL_CONTEXT *ctx, int argc, char **argv )
                 ummHeapInfo.usedEntries,
                 ummHeapInfo.freeEntries
             );
-            printf("   Blocks: Total  %8i, Allocated %8i, Free %8i\n",
-                ummHeapInfo.totalBlocks,
-                ummHeapInfo.usedBlocks,
-                ummHeapInfo.freeBlocks
+            printf("    Bytes: Total  %8u, Allocated %8u, Free %8u\n",
+                (unsigned)ummHeapInfo.totalBytes,
+                (unsigned)ummHeapInfo.usedBytes,
+                (unsigned)ummHeapInfo.freeBytes
             );
-            printf("   Contig: Blocks %8i,     Bytes %8i\n",
-                ummHeapInfo.maxFreeContiguousBlocks,
-                ummHeapInfo.maxFreeContiguousBlocks * umm_block_size()
+            printf("   Contig: Bytes  %8u, Fragmentation %3u%%\n",
+                (unsigned)ummHeapInfo.maxFreeContiguousBytes,
+                ummHeapInfo.fragmentation
             );
         }
         printf("  Heap Integrity: %s\n", ok ? "OK" : "Corrupt");
+
+        umm_heap_stats((umm_heap_t)i, &ummHeapStats, reset);
+        printf("    Calls: Malloc %8u, Free      %8u, Fail %8u\n",
+            ummHeapStats.allocs, ummHeapStats.frees, ummHeapStats.failures
+        );
+        printf("     Peak: Bytes  %8u\n", (unsigned)ummHeapStats.peakUsedBytes);
+        printf("  Latency: Malloc avg %4u us, max %4u us, "
+               "Free avg %4u us, max %4u us\n",
+            (unsigned)UMM_TIMESTAMP_TO_US(ummHeapStats.allocs ?
+                ummHeapStats.mallocTicks / ummHeapStats.allocs : 0),
+            (unsigned)UMM_TIMESTAMP_TO_US(ummHeapStats.mallocMaxTicks),
+            (unsigned)UMM_TIMESTAMP_TO_US(ummHeapStats.frees ?
+                ummHeapStats.freeTicks / ummHeapStats.frees : 0),
+            (unsigned)UMM_TIMESTAMP_TO_US(ummHeapStats.freeMaxTicks)
+        );
     }
 
+    /* Audio buffer pool */
+    AUDIO_POOL_STATS poolStats;
+    audio_pool_stats(&poolStats);
+
+    printf("Audio Pool Info:\n");
+    printf("    Rings: Open   %8u, Bytes     %8u, Peak %8u\n",
+        poolStats.rings, poolStats.ringBytes, poolStats.peakRingBytes
+    );
+    printf("  Scratch: Bytes  %8u, Alloc Fail %7u\n",
+        poolStats.scratchBytes, poolStats.allocFailures
+    );
 
     /* FreeRTOS */
     HeapStats_t rtosHeapStats;
@@ -2225,8 +2264,11 @@ const char shell_help_route[] =
     "  sharc1     - SHARC1 Audio\n"
 #endif
     "  wav        - WAV file src/sink\n"
-    "  rtp        - RTP network audio tx\n"
-    "  vban       - VBAN network audio tx\n"
+    "  rtp        - RTP network audio rx/tx\n"
+    "  rtp2, rtp3 - Additional RTP network audio rx\n"
+    "  vban       - VBAN network audio rx/tx\n"
+    "  vban2, vban3 - Additional VBAN network audio rx\n"
+    "  avtp       - IEEE 1722 AAF network audio rx/tx\n"
     "  vu         - VU Meter sink\n"
     "  off        - Turn off the stream\n"
     " No arguments\n"
@@ -2293,15 +2335,33 @@ static char *stream2str(int streamID)
         case STREAM_ID_RTP_RX:
             str = "RTP_RX";
             break;
+        case STREAM_ID_RTP2_RX:
+            str = "RTP2_RX";
+            break;
+        case STREAM_ID_RTP3_RX:
+            str = "RTP3_RX";
+            break;
         case STREAM_ID_RTP_TX:
             str = "RTP_TX";
             break;
         case STREAM_ID_VBAN_RX:
             str = "VBAN_RX";
             break;
+        case STREAM_ID_VBAN2_RX:
+            str = "VBAN2_RX";
+            break;
+        case STREAM_ID_VBAN3_RX:
+            str = "VBAN3_RX";
+            break;
         case STREAM_ID_VBAN_TX:
             str = "VBAN_TX";
             break;
+        case STREAM_ID_AVTP_RX:
+            str = "AVTP_RX";
+            break;
+        case STREAM_ID_AVTP_TX:
+            str = "AVTP_TX";
+            break;
         default:
             str = "UNKNOWN";
             break;
@@ -2330,8 +2390,18 @@ STREAM_ID str2stream(char *stream, bool src)
         return(src ? STREAM_ID_MAX : STREAM_ID_VU_IN);
     } else if (strcmp(stream, "rtp") == 0) {
         return(src ? STREAM_ID_RTP_RX : STREAM_ID_RTP_TX);
+    } else if (strcmp(stream, "rtp2") == 0) {
+        return(src ? STREAM_ID_RTP2_RX : STREAM_ID_MAX);
+    } else if (strcmp(stream, "rtp3") == 0) {
+        return(src ? STREAM_ID_RTP3_RX : STREAM_ID_MAX);
     } else if (strcmp(stream, "vban") == 0) {
         return(src ? STREAM_ID_VBAN_RX : STREAM_ID_VBAN_TX);
+    } else if (strcmp(stream, "vban2") == 0) {
+        return(src ? STREAM_ID_VBAN2_RX : STREAM_ID_MAX);
+    } else if (strcmp(stream, "vban3") == 0) {
+        return(src ? STREAM_ID_VBAN3_RX : STREAM_ID_MAX);
+    } else if (strcmp(stream, "avtp") == 0) {
+        return(src ? STREAM_ID_AVTP_RX : STREAM_ID_AVTP_TX);
     } else if (strcmp(stream, "a2b2") == 0) {
         return(src ? STREAM_ID_A2B2_IN : STREAM_ID_A2B2_OUT);
     } else if (strcmp(stream, "off") == 0) {
@@ -2468,23 +2538,314 @@ void shell_route(SHELL_CONTEXT *ctx, int argc, char **argv)
 /***********************************************************************
  * CMD: wav
  **********************************************************************/
-const char shell_help_wav[] = "<src|sink> <on|off> [file] [channels] [bits]\n";
+const char shell_help_wav[] =
+    "<src|sink> <on|off> [file] [channels] [bits] [stem]\n"
+    "  src - plays U8, S16_LE, S24_3LE, S32_LE, FLOAT_LE and FLAC files\n"
+    "  bits - Sink bit depth.  16, 24 and 32 supported (Default 16)\n"
+    "  stem - Sink channels per file, split as file_1.wav, file_2.wav, ...\n"
+    "         SD card sinks are preallocated (Default all in one file)\n"
+    "wav cache [file|clear]\n"
+    "  file - Queue a source file for preloading into SDRAM\n"
+    "  clear - Empty the preload queue, no argument shows cache stats\n"
+    "wav cue [1-8 [set [frame]|clear]]\n"
+    "  Jumps to a src hot cue, setting it here if unset, or lists them\n"
+    "wav loop [in [frame]|out [frame]|<beats>|off]\n"
+    "  beats - Loop length, e.g. 4 or 1/2.  Sets a loop from here, or\n"
+    "          resizes the active loop.  No argument re-enters the loop\n"
+    "wav bpm [bpm] - Src tempo for beat loop lengths (Default 120)\n"
+    "wav scratch [on|off] - Src variable-rate playback, or show cost\n"
+    "wav jog <rate> - Scratch rate, e.g. -1 plays backwards\n";
 const char shell_help_summary_wav[] = "Manages wave file source/sink";
 
 #include "wav_file.h"
+#include "wav_rec.h"
+#include "track_cache.h"
+#include "wav_cue.h"
+#include "wav_audio.h"
 #include "clock_domain.h"
+#include "clocks.h"
+#include "fs_devman.h"
 
 static void wav_state(SHELL_CONTEXT *ctx, char *name, int clockDomainMask, WAV_FILE *wf)
 {
+    WAV_REC_STATS stats;
+
     printf(
-        "%s: %s, %s, %d-bit, %d ch, %s\n",
+        "%s: %s, %s, %s, %d ch, %s\n",
         name,
         wf->enabled ? "ON" : "OFF",
         wf->fname ? wf->fname : "N/A",
-        wf->wordSizeBytes == 2 ? 16 : 32,
+        waveFmtName(wf->waveInfo.waveFmt),
         wf->channels,
         clock_domain_str(clock_domain_get(context, clockDomainMask))
     );
+    if (wf->rec) {
+        wav_rec_stats(wf->rec, &stats);
+        printf(
+            "  %u file(s), %lu MB prealloc, %lu KB writes, "
+            "%lu appended, %lu commits, %lu errors\n",
+            stats.files,
+            (unsigned long)(stats.preallocBytes >> 20),
+            (unsigned long)(stats.writeBytes >> 10),
+            (unsigned long)stats.appendBlocks,
+            (unsigned long)stats.commits,
+            (unsigned long)stats.errors
+        );
+    }
+}
+
+/*
+ * Returns the FatFs path of a sink that lands on the SD card, NULL if
+ * it goes to another device through stdio.
+ */
+static char *wav_rec_path(const char *fname)
+{
+    const char *dev = NULL;
+    char *path = NULL;
+
+    if (strncmp(fname, SDCARD_VOL_NAME, strlen(SDCARD_VOL_NAME)) == 0) {
+        dev = "";
+    } else if (strchr(fname, ':') == NULL) {
+        if ((fs_devman_get_default(&dev) != FS_DEVMAN_OK) ||
+            (strcmp(dev, SDCARD_VOL_NAME) != 0)) {
+            dev = NULL;
+        }
+    }
+    if (dev) {
+        path = SHELL_MALLOC(strlen(dev) + strlen(fname) + 1);
+        if (path) {
+            strcpy(path, dev); strcat(path, fname);
+        }
+    }
+
+    return(path);
+}
+
+static bool wav_rec_sink_open(WAV_FILE *wf, const char *path,
+    unsigned stemChannels)
+{
+    wf->rec = wav_rec_open(path, wf->channels, wf->sampleRate,
+        wf->wordSizeBytes, stemChannels);
+    if (wf->rec == NULL) {
+        return(false);
+    }
+    switch (wf->wordSizeBytes) {
+        case 2: wf->waveInfo.waveFmt = WAVE_FMT_SIGNED_16BIT_LE; break;
+        case 3: wf->waveInfo.waveFmt = WAVE_FMT_SIGNED_24BIT_LE; break;
+        default: wf->waveInfo.waveFmt = WAVE_FMT_SIGNED_32BIT_LE; break;
+    }
+    wf->enabled = true;
+
+    return(true);
+}
+
+/* PCM sources read through the SDRAM track cache */
+static void wav_cache_attach(WAV_FILE *wf)
+{
+    wf->readUsr = track_cache_open(wf->fname);
+    if (wf->readUsr) {
+        wf->read = track_cache_read;
+    }
+}
+
+static void wav_cache(int argc, char **argv)
+{
+    TRACK_CACHE_STATS stats;
+
+    if (argc >= 3) {
+        if (strcmp(argv[2], "clear") == 0) {
+            track_cache_queue(NULL);
+        } else if (!track_cache_queue(argv[2])) {
+            printf("Unable to queue %s\n", argv[2]);
+        }
+        return;
+    }
+
+    track_cache_stats(&stats);
+    printf("Cache: %u tracks, %u/%u regions resident\n",
+        stats.tracks, stats.resident, stats.regions);
+    printf("  %lu hits, %lu misses, %lu loads, %lu evictions, %lu errors\n",
+        (unsigned long)stats.hits, (unsigned long)stats.misses,
+        (unsigned long)stats.loads, (unsigned long)stats.evictions,
+        (unsigned long)stats.readErrors);
+}
+
+static void wav_cue_list(WAV_CUE *cue)
+{
+    WAV_CUE_PIN *pin;
+    WAV_CUE_STATS stats;
+    unsigned i;
+
+    printf("Position: %lu\n", (unsigned long)wav_cue_position(cue));
+    for (i = 0; i < WAV_CUE_MAX_CUES; i++) {
+        pin = &cue->pins[i];
+        if (pin->buf) {
+            printf("Cue %u: %lu%s\n", i + 1, (unsigned long)pin->frame,
+                pin->ready ? "" : " (loading)");
+        }
+    }
+    pin = &cue->pins[WAV_CUE_LOOP];
+    if (pin->buf) {
+        printf("Loop: %lu-%lu, %s%s\n",
+            (unsigned long)cue->loopIn, (unsigned long)cue->loopOut,
+            cue->looping ? "on" : "off", pin->ready ? "" : " (loading)");
+    }
+    wav_cue_stats(cue, &stats);
+    printf("  %lu jumps, %lu wraps, %lu seeks, %lu underflows, "
+        "%lu errors, %lu KB pinned\n",
+        (unsigned long)stats.jumps, (unsigned long)stats.loops,
+        (unsigned long)stats.seeks, (unsigned long)stats.underflows,
+        (unsigned long)stats.readErrors,
+        (unsigned long)(stats.pinnedBytes >> 10));
+}
+
+static unsigned long ticks_us(uint32_t ticks)
+{
+    return((unsigned long)(((uint64_t)ticks * 1000000) / CGU_TS_CLK));
+}
+
+static void wav_scratch_cmd(WAV_CUE *cue, int argc, char **argv)
+{
+    WAV_CUE_STATS stats;
+    int centiRate;
+
+    if (argc >= 3) {
+        if (!wav_cue_scratch(cue, strcmp(argv[2], "on") == 0)) {
+            printf("Out of memory\n");
+        }
+        return;
+    }
+
+    centiRate = (int)(cue->scratch.rate * 100.0f);
+    wav_cue_stats(cue, &stats);
+    printf("Scratch: %s, rate %s%d.%02d\n",
+        cue->scratching ? "on" : (cue->scratchReq ? "loading" : "off"),
+        (centiRate < 0) ? "-" : "", abs(centiRate) / 100,
+        abs(centiRate) % 100);
+    printf("  %lu blocks, %lu misses, %lu loads, %lu us/block (peak %lu)\n",
+        (unsigned long)stats.scratchBlocks,
+        (unsigned long)stats.scratchMisses,
+        (unsigned long)stats.scratchLoads,
+        ticks_us(stats.renderTicks), ticks_us(stats.peakRenderTicks));
+}
+
+static void wav_cue_cmd(WAV_CUE *cue, int argc, char **argv)
+{
+    unsigned idx;
+    uint32_t frame;
+    bool ok = true;
+
+    if (argc < 3) {
+        wav_cue_list(cue);
+        return;
+    }
+
+    idx = atoi(argv[2]) - 1;
+    if (idx >= WAV_CUE_MAX_CUES) {
+        printf("Bad cue\n");
+        return;
+    }
+
+    if ((argc >= 4) && (strcmp(argv[3], "clear") == 0)) {
+        ok = wav_cue_clear(cue, idx);
+    } else if (((argc >= 4) && (strcmp(argv[3], "set") == 0)) ||
+            (cue->pins[idx].buf == NULL)) {
+        frame = (argc >= 5) ? strtoul(argv[4], NULL, 0) :
+            wav_cue_position(cue);
+        ok = wav_cue_set(cue, idx, frame);
+    } else if (!wav_cue_jump(cue, idx)) {
+        printf("Cue %u is still loading\n", idx + 1);
+        return;
+    }
+    if (!ok) {
+        printf("Cue %u is playing or out of memory\n", idx + 1);
+    }
+}
+
+static void wav_loop_cmd(WAV_CUE *cue, int argc, char **argv)
+{
+    static uint32_t loopIn = 0;
+    unsigned num, den;
+    uint32_t frame;
+    uint32_t in;
+    char *slash;
+    bool ok;
+
+    if (argc < 3) {
+        ok = wav_cue_reloop(cue);
+    } else if (strcmp(argv[2], "off") == 0) {
+        wav_cue_loop_exit(cue);
+        ok = true;
+    } else if ((strcmp(argv[2], "in") == 0) ||
+            (strcmp(argv[2], "out") == 0)) {
+        frame = (argc >= 4) ? strtoul(argv[3], NULL, 0) :
+            wav_cue_position(cue);
+        ok = true;
+        if (argv[2][0] == 'i') {
+            loopIn = frame;
+        } else {
+            ok = wav_cue_loop(cue, loopIn, frame);
+        }
+    } else {
+        /* Beat lengths resize an active loop from its in point */
+        num = atoi(argv[2]);
+        slash = strchr(argv[2], '/');
+        den = slash ? atoi(slash + 1) : 1;
+        in = cue->looping ? cue->loopIn : wav_cue_position(cue);
+        frame = wav_cue_beat_frames(cue, num, den);
+        ok = (frame > 0) && wav_cue_loop(cue, in, in + frame);
+    }
+    if (!ok) {
+        printf("Unable to set loop\n");
+    }
+}
+
+/* Hot cues and loops on the src */
+static void wav_cue_shell(int argc, char **argv)
+{
+    WAV_FILE *wf = &context->wavSrc;
+    WAV_CUE *cue = &context->wavSrcCue;
+    unsigned centiBpm;
+
+    xSemaphoreTake((SemaphoreHandle_t)wf->lock, portMAX_DELAY);
+    if (!wf->enabled || (cue->wf == NULL)) {
+        printf("Needs a PCM src playing\n");
+    } else if (strcmp(argv[1], "cue") == 0) {
+        wav_cue_cmd(cue, argc, argv);
+    } else if (strcmp(argv[1], "loop") == 0) {
+        wav_loop_cmd(cue, argc, argv);
+    } else if (strcmp(argv[1], "scratch") == 0) {
+        wav_scratch_cmd(cue, argc, argv);
+    } else if (strcmp(argv[1], "jog") == 0) {
+        if ((argc < 3) || !wav_cue_jog(cue, atof(argv[2]))) {
+            printf("Scratch isn't on\n");
+        }
+    } else {
+        if (argc >= 3) {
+            cue->bpm = atof(argv[2]);
+        }
+        centiBpm = (unsigned)(cue->bpm * 100.0f + 0.5f);
+        printf("%u.%02u BPM\n", centiBpm / 100, centiBpm % 100);
+    }
+    xSemaphoreGive((SemaphoreHandle_t)wf->lock);
+}
+
+static void wav_close(WAV_FILE *wf)
+{
+    if (wf->read) {
+        track_cache_close(wf->readUsr);
+        wf->read = NULL; wf->readUsr = NULL;
+    }
+    if (wf->rec) {
+        if (!wav_rec_close(wf->rec)) {
+            printf("Recording errors, %s may be short\n", wf->fname);
+        }
+        wf->rec = NULL;
+        wf->enabled = false;
+        wf->channels = 0;
+    } else {
+        closeWave(wf);
+    }
 }
 
 void shell_wav( SHELL_CONTEXT *ctx, int argc, char **argv )
@@ -2499,6 +2860,8 @@ void shell_wav( SHELL_CONTEXT *ctx, int argc, char **argv )
     bool ok = true;
     int clockDomainMask;
     bool channelsSpecified = false;
+    unsigned stemChannels;
+    char *recPath;
 
     if (argc == 1) {
         wav_state(ctx, "Src", CLOCK_DOMAIN_BITM_WAV_SRC, &context->wavSrc);
@@ -2506,6 +2869,19 @@ void shell_wav( SHELL_CONTEXT *ctx, int argc, char **argv )
         return;
     }
 
+    if ((argc >= 2) && (strcmp(argv[1], "cache") == 0)) {
+        wav_cache(argc, argv);
+        return;
+    }
+
+    if ((argc >= 2) && ((strcmp(argv[1], "cue") == 0) ||
+            (strcmp(argv[1], "loop") == 0) || (strcmp(argv[1], "bpm") == 0) ||
+            (strcmp(argv[1], "scratch") == 0) ||
+            (strcmp(argv[1], "jog") == 0))) {
+        wav_cue_shell(argc, argv);
+        return;
+    }
+
     if (argc >= 2) {
         if (strcmp(argv[1], "src") == 0) {
             wf = &context->wavSrc;
@@ -2584,18 +2960,23 @@ void shell_wav( SHELL_CONTEXT *ctx, int argc, char **argv )
     wordSizeBytes = sizeof(int16_t);
     if (argc >= 6) {
         bits = atoi(argv[5]);
-        if (bits == 32) {
-            wordSizeBytes = 4;
+        if ((bits == 24) || (bits == 32)) {
+            wordSizeBytes = bits / 8;
         }
     }
 
+    stemChannels = 0;
+    if (argc >= 7) {
+        stemChannels = atoi(argv[6]);
+    }
+
     xSemaphoreTake((SemaphoreHandle_t)wf->lock, portMAX_DELAY);
     if (on) {
         if (!isSrc) {
             wf->channels = channels;
             wf->sampleRate = SYSTEM_SAMPLE_RATE;
             wf->wordSizeBytes = wordSizeBytes;
-            wf->frameSizeBytes = SYSTEM_BLOCK_SIZE * wf->wordSizeBytes;
+            wf->frameSizeBytes = wf->channels * wf->wordSizeBytes;
         }
         if (fname) {
             if (wf->fname) {
@@ -2605,7 +2986,13 @@ void shell_wav( SHELL_CONTEXT *ctx, int argc, char **argv )
             strcpy(wf->fname, fname);
         }
         wf->isSrc = isSrc;
-        ok = openWave(wf);
+        recPath = isSrc ? NULL : wav_rec_path(wf->fname);
+        if (recPath) {
+            ok = wav_rec_sink_open(wf, recPath, stemChannels);
+            SHELL_FREE(recPath);
+        } else {
+            ok = openWave(wf);
+        }
         if (!ok) {
             printf("Failed to open %s\n", wf->fname);
         } else {
@@ -2614,9 +3001,8 @@ void shell_wav( SHELL_CONTEXT *ctx, int argc, char **argv )
                     printf("Must be less than %d channels\n", WAV_MAX_CHANNELS);
                     closeWave(wf);
                 }
-                if ((wf->waveInfo.waveFmt != WAVE_FMT_SIGNED_32BIT_LE) &&
-                    (wf->waveInfo.waveFmt != WAVE_FMT_SIGNED_16BIT_LE)) {
-                    printf("Must be S16_LE or S32_LE format\n");
+                if (wf->waveInfo.waveFmt == WAVE_FMT_UNKNOWN) {
+                    printf("Must be U8, S16_LE, S24_3LE, S32_LE, FLOAT_LE or FLAC format\n");
                     closeWave(wf);
                 }
                 if (wf->waveInfo.sampleRate != SYSTEM_SAMPLE_RATE) {
@@ -2629,9 +3015,24 @@ void shell_wav( SHELL_CONTEXT *ctx, int argc, char **argv )
                     }
                 }
             }
+            if (wf->enabled && isSrc && !wf->flac) {
+                wav_cache_attach(wf);
+            }
+            if (wf->enabled && !wav_audio_open_ring(context, wf)) {
+                printf("Out of audio buffer memory\n");
+                wav_close(wf);
+            }
+            if (wf->enabled && isSrc) {
+                wav_cue_attach(&context->wavSrcCue, wf, SYSTEM_BLOCK_SIZE,
+                    getTimeStamp);
+            }
         }
     } else {
-        closeWave(wf);
+        if (isSrc) {
+            wav_cue_attach(&context->wavSrcCue, NULL, 0, NULL);
+        }
+        wav_close(wf);
+        wav_audio_close_ring(context, wf);
     }
     xSemaphoreGive((SemaphoreHandle_t)wf->lock);
 }
@@ -2640,30 +3041,50 @@ void shell_wav( SHELL_CONTEXT *ctx, int argc, char **argv )
  * CMD: rtp
  **********************************************************************/
 const char shell_help_rtp[] =
-    "<rx|tx> <on|off> <ip> [port] [channels] [bits]\n"
+    "<rx|rx2|rx3|tx> <on|off> <ip> [port] [channels] [bits] [ssrc]\n"
     "  ip - Source IP address for rx or dest IP address for tx\n"
-    "  port - IP port number (Default 6970)\n"
+    "       Multicast rx addresses join the group, 0.0.0.0 accepts any\n"
+    "  port - IP port number (Default 6970), may be shared by rx streams\n"
     "  channels - Routable channels (Default 2)\n"
-    "  bits - Audio bit depth.  16 and 32 supported (Default 16)\n";
+    "  bits - Audio bit depth.  16 and 32 supported (Default 16)\n"
+    "  ssrc - Only accept this SSRC on rx, or send it on tx (0 any)\n";
 const char shell_help_summary_rtp[] = "Manages RTP stream Rx/Tx";
 
 #include "rtp_stream.h"
+#include "rtp_audio.h"
 #include "clock_domain.h"
 
 static void rtp_state(SHELL_CONTEXT *ctx, char *name, int clockDomainMask, RTP_STREAM *rs)
 {
     printf(
-        "%s: %s, %s:%d, %d-bit, %d ch, %s\n",
+        "%s: %s, %s:%d, %d-bit, %d ch, ssrc %08x, %s\n",
         name,
         rs->enabled ? "ON" : "OFF",
         rs->ipStr ? rs->ipStr : "N/A",
         rs->port,
         rs->wordSizeBytes == 2 ? 16 : 32,
         rs->channels,
+        (unsigned)rs->ssrc,
         clock_domain_str(clock_domain_get(context, clockDomainMask))
     );
 }
 
+/* Parses "rx", "rx2", ... into a zero based rx stream index */
+static int net_rx_idx(char *arg, int maxStreams)
+{
+    int idx;
+
+    if (strncmp(arg, "rx", 2) != 0) {
+        return(-1);
+    }
+    idx = (arg[2] == '\0') ? 0 : atoi(arg + 2) - 1;
+    if ((idx < 0) || (idx >= maxStreams)) {
+        return(-1);
+    }
+
+    return(idx);
+}
+
 void shell_rtp( SHELL_CONTEXT *ctx, int argc, char **argv )
 {
     RTP_STREAM *rs = NULL;
@@ -2675,19 +3096,26 @@ void shell_rtp( SHELL_CONTEXT *ctx, int argc, char **argv )
     bool ok = true;
     int clockDomainMask;
     int port;
+    uint32_t ssrc;
     char *ipStr = NULL;
+    char name[8];
+    int idx;
 
     if (argc == 1) {
-        rtp_state(ctx, "Rx", CLOCK_DOMAIN_BITM_RTP_RX, &context->rtpRx);
+        for (idx = 0; idx < RTP_RX_STREAMS; idx++) {
+            snprintf(name, sizeof(name), idx ? "Rx%d" : "Rx", idx + 1);
+            rtp_state(ctx, name, rtpRxClockDomainMask(idx), &context->rtpRx[idx]);
+        }
         rtp_state(ctx, "Tx", CLOCK_DOMAIN_BITM_RTP_TX, &context->rtpTx);
         return;
     }
 
     if (argc >= 2) {
-        if (strcmp(argv[1], "rx") == 0) {
-            rs = &context->rtpRx;
+        idx = net_rx_idx(argv[1], RTP_RX_STREAMS);
+        if (idx >= 0) {
+            rs = &context->rtpRx[idx];
             isRx = true;
-            clockDomainMask = CLOCK_DOMAIN_BITM_RTP_RX;
+            clockDomainMask = rtpRxClockDomainMask(idx);
         } else if (strcmp(argv[1], "tx") == 0) {
             rs = &context->rtpTx;
             isRx = false;
@@ -2781,6 +3209,12 @@ void shell_rtp( SHELL_CONTEXT *ctx, int argc, char **argv )
         wordSizeBytes = rs->wordSizeBytes;
     }
 
+    if (argc >= 8) {
+        ssrc = strtoul(argv[7], NULL, 0);
+    } else {
+        ssrc = rs->ssrc;
+    }
+
     xSemaphoreTake((SemaphoreHandle_t)rs->lock, portMAX_DELAY);
     if (on) {
         if (ipStr) {
@@ -2794,12 +3228,13 @@ void shell_rtp( SHELL_CONTEXT *ctx, int argc, char **argv )
         rs->wordSizeBytes = wordSizeBytes;
         rs->port = port;
         rs->isRx = isRx;
-        ok = openRtpStream(rs);
+        rs->ssrc = ssrc;
+        ok = rtp_audio_open(context, rs);
         if (!ok) {
             printf("Failed to open port %d\n", rs->port);
         }
     } else {
-        closeRtpStream(rs);
+        rtp_audio_close(context, rs);
     }
     xSemaphoreGive((SemaphoreHandle_t)rs->lock);
 }
@@ -2808,26 +3243,31 @@ void shell_rtp( SHELL_CONTEXT *ctx, int argc, char **argv )
  * CMD: vban
  **********************************************************************/
 const char shell_help_vban[] =
-    "<rx|tx> <on|off> <ip> [port] [channels] [bits]\n"
+    "<rx|rx2|rx3|tx> <on|off> <ip> [port] [channels] [bits] [name]\n"
     "  ip - Source IP address for rx or dest IP address for tx\n"
-    "  port - IP port number (Default 6980)\n"
+    "       Multicast rx addresses join the group, 0.0.0.0 accepts any\n"
+    "  port - IP port number (Default 6980), may be shared by rx streams\n"
     "  channels - Routable channels (Default 2)\n"
-    "  bits - Audio bit depth.  16 and 32 supported (Default 16)\n";
+    "  bits - Audio bit depth.  16 and 32 supported (Default 16)\n"
+    "  name - Only accept this stream name on rx, or send it on tx\n"
+    "         ('-' clears)\n";
 const char shell_help_summary_vban[] = "Manages VBAN stream Rx/Tx";
 
 #include "vban_stream.h"
+#include "vban_audio.h"
 #include "clock_domain.h"
 
 static void vban_state(SHELL_CONTEXT *ctx, char *name, int clockDomainMask, VBAN_STREAM *rs)
 {
     printf(
-        "%s: %s, %s:%d, %d-bit, %d ch, %s\n",
+        "%s: %s, %s:%d, %d-bit, %d ch, '%.16s', %s\n",
         name,
         rs->enabled ? "ON" : "OFF",
         rs->ipStr ? rs->ipStr : "N/A",
         rs->port,
         rs->wordSizeBytes == 2 ? 16 : 32,
         rs->channels,
+        rs->streamName,
         clock_domain_str(clock_domain_get(context, clockDomainMask))
     );
 }
@@ -2844,18 +3284,25 @@ void shell_vban( SHELL_CONTEXT *ctx, int argc, char **argv )
     int clockDomainMask;
     int port;
     char *ipStr = NULL;
+    char *streamName = NULL;
+    char name[8];
+    int idx;
 
     if (argc == 1) {
-        vban_state(ctx, "Rx", CLOCK_DOMAIN_BITM_VBAN_RX, &context->vbanRx);
+        for (idx = 0; idx < VBAN_RX_STREAMS; idx++) {
+            snprintf(name, sizeof(name), idx ? "Rx%d" : "Rx", idx + 1);
+            vban_state(ctx, name, vbanRxClockDomainMask(idx), &context->vbanRx[idx]);
+        }
         vban_state(ctx, "Tx", CLOCK_DOMAIN_BITM_VBAN_TX, &context->vbanTx);
         return;
     }
 
     if (argc >= 2) {
-        if (strcmp(argv[1], "rx") == 0) {
-            rs = &context->vbanRx;
+        idx = net_rx_idx(argv[1], VBAN_RX_STREAMS);
+        if (idx >= 0) {
+            rs = &context->vbanRx[idx];
             isRx = true;
-            clockDomainMask = CLOCK_DOMAIN_BITM_VBAN_RX;
+            clockDomainMask = vbanRxClockDomainMask(idx);
         } else if (strcmp(argv[1], "tx") == 0) {
             rs = &context->vbanTx;
             isRx = false;
@@ -2949,6 +3396,10 @@ void shell_vban( SHELL_CONTEXT *ctx, int argc, char **argv )
         wordSizeBytes = rs->wordSizeBytes;
     }
 
+    if (argc >= 8) {
+        streamName = argv[7];
+    }
+
     xSemaphoreTake((SemaphoreHandle_t)rs->lock, portMAX_DELAY);
     if (on) {
         if (ipStr) {
@@ -2958,21 +3409,248 @@ void shell_vban( SHELL_CONTEXT *ctx, int argc, char **argv )
             rs->ipStr = SHELL_MALLOC(strlen(ipStr) + 1);
             strcpy(rs->ipStr, ipStr);
         }
+        if (streamName) {
+            memset(rs->streamName, 0, sizeof(rs->streamName));
+            if (strcmp(streamName, "-") != 0) {
+                strncpy(rs->streamName, streamName, sizeof(rs->streamName));
+            }
+        }
         rs->channels = channels;
         rs->wordSizeBytes = wordSizeBytes;
         rs->port = port;
         rs->isRx = isRx;
         rs->systemSampleRate = SYSTEM_SAMPLE_RATE;
-        ok = vbanOpenStream(rs);
+        ok = vban_audio_open(context, rs);
         if (!ok) {
             printf("Failed to open port %d\n", rs->port);
         }
     } else {
-        vbanCloseStream(rs);
+        vban_audio_close(context, rs);
     }
     xSemaphoreGive((SemaphoreHandle_t)rs->lock);
 }
 
+/***********************************************************************
+ * CMD: avtp
+ **********************************************************************/
+const char shell_help_avtp[] =
+    "<rx|tx> <on|off> [streamid] [channels] [bits] [dstmac]\n"
+    "  streamid - 64-bit stream ID in hex, 0 accepts any on rx\n"
+    "             (Default tx is the MAC address with unique ID 0)\n"
+    "  channels - Routable channels (Default 2)\n"
+    "  bits - Audio bit depth.  16 and 32 supported (Default 16)\n"
+    "  dstmac - Tx destination MAC xx:xx:xx:xx:xx:xx\n"
+    "           (Default 91:e0:f0:00:fe:00)\n"
+    "<rx|tx> domain <a2b|system>\n"
+    " No arguments\n"
+    "  Show stream state and statistics\n";
+const char shell_help_summary_avtp[] = "Manages IEEE 1722 AAF stream Rx/Tx";
+
+#include "avtp_stream.h"
+#include "avtp_audio.h"
+
+static void avtp_state(SHELL_CONTEXT *ctx, char *name, int clockDomainMask, AVTP_STREAM *as)
+{
+    printf(
+        "%s: %s, %08lx%08lx, %02x:%02x:%02x:%02x:%02x:%02x, %d-bit, %d ch, %s\n",
+        name,
+        as->enabled ? "ON" : "OFF",
+        (unsigned long)(as->streamID >> 32),
+        (unsigned long)(as->streamID & 0xFFFFFFFF),
+        as->dstMac[0], as->dstMac[1], as->dstMac[2],
+        as->dstMac[3], as->dstMac[4], as->dstMac[5],
+        as->wordSizeBytes == 2 ? 16 : 32,
+        as->channels,
+        clock_domain_str(clock_domain_get(context, clockDomainMask))
+    );
+}
+
+void shell_avtp( SHELL_CONTEXT *ctx, int argc, char **argv )
+{
+    AVTP_STREAM *as = NULL;
+    unsigned rxUnderflow, rxOverflow, rxLate, txOverflow;
+    unsigned mac[6];
+    uint64_t streamID;
+    int channels;
+    int wordSizeBytes;
+    int bits;
+    bool on;
+    bool ok = true;
+    int clockDomainMask;
+    int i;
+
+    if (argc == 1) {
+        avtp_state(ctx, "Rx", CLOCK_DOMAIN_BITM_AVTP_RX, &context->avtpRx);
+        avtp_state(ctx, "Tx", CLOCK_DOMAIN_BITM_AVTP_TX, &context->avtpTx);
+        avtpAudioStats(&rxUnderflow, &rxOverflow, &rxLate, &txOverflow);
+        printf("Rx: %u pkts, %u seq err, %u fmt err, %u late\n",
+            context->avtpRx.rxPkts, context->avtpRx.rxSeqErrors,
+            context->avtpRx.rxFmtErrors, rxLate);
+        printf("Rx: %u underflow, %u overflow\n", rxUnderflow, rxOverflow);
+        printf("Tx: %u overflow\n", txOverflow);
+        return;
+    }
+
+    if (strcmp(argv[1], "rx") == 0) {
+        as = &context->avtpRx;
+        clockDomainMask = CLOCK_DOMAIN_BITM_AVTP_RX;
+    } else if (strcmp(argv[1], "tx") == 0) {
+        as = &context->avtpTx;
+        clockDomainMask = CLOCK_DOMAIN_BITM_AVTP_TX;
+    } else {
+        printf("Invalid rx/tx\n");
+        return;
+    }
+
+    if (argc >= 3) {
+        if (strcmp(argv[2], "on") == 0) {
+            if (as->enabled) {
+                printf("Already on\n");
+                return;
+            }
+            on = true;
+        } else if (strcmp(argv[2], "off") == 0) {
+            if (!as->enabled) {
+                printf("Already off\n");
+                return;
+            }
+            on = false;
+        } else if (strcmp(argv[2], "domain") == 0) {
+            if (argc >= 4) {
+                if (strcmp(argv[3], "a2b") == 0) {
+                    clock_domain_set(context, CLOCK_DOMAIN_A2B, clockDomainMask);
+                } else if (strcmp(argv[3], "system") == 0) {
+                    clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, clockDomainMask);
+                } else {
+                    printf("Bad domain\n");
+                }
+            }
+            return;
+        } else {
+            ok = false;
+        }
+    } else {
+        ok = false;
+    }
+    if (!ok) {
+        printf("Invalid on/off/domain\n");
+        return;
+    }
+
+    if (argc >= 4) {
+        streamID = strtoull(argv[3], NULL, 16);
+    } else {
+        streamID = as->streamID;
+    }
+
+    if (argc >= 5) {
+        channels = atoi(argv[4]);
+        if (channels > SYSTEM_MAX_CHANNELS) {
+            channels = SYSTEM_MAX_CHANNELS;
+        }
+    } else {
+        channels = as->channels;
+    }
+
+    if (argc >= 6) {
+        bits = atoi(argv[5]);
+        if (bits > 16) {
+            wordSizeBytes = 4;
+        } else {
+            wordSizeBytes = 2;
+        }
+    } else {
+        wordSizeBytes = as->wordSizeBytes;
+    }
+
+    if (argc >= 7) {
+        if (sscanf(argv[6], "%x:%x:%x:%x:%x:%x",
+                &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]) != 6) {
+            printf("Invalid MAC address\n");
+            return;
+        }
+    }
+
+    xSemaphoreTake((SemaphoreHandle_t)as->lock, portMAX_DELAY);
+    if (on) {
+        if (argc >= 7) {
+            for (i = 0; i < 6; i++) {
+                as->dstMac[i] = mac[i];
+            }
+        }
+        as->streamID = streamID;
+        as->channels = channels;
+        as->wordSizeBytes = wordSizeBytes;
+        as->sampleRate = SYSTEM_SAMPLE_RATE;
+        ok = avtp_audio_open(context, as);
+        if (!ok) {
+            printf("Failed to open stream\n");
+        }
+    } else {
+        avtp_audio_close(context, as);
+    }
+    xSemaphoreGive((SemaphoreHandle_t)as->lock);
+}
+
+/***********************************************************************
+ * CMD: ptp
+ **********************************************************************/
+const char shell_help_ptp[] =
+    "[reset]\n"
+    "  reset - Clear the counters and maximum offset\n"
+    " No arguments\n"
+    "  Show 802.1AS state and media clock rates\n";
+const char shell_help_summary_ptp[] = "Shows gPTP time synchronization status";
+
+#include "gptp.h"
+#include "gptp_clock.h"
+#include "media_clock.h"
+
+void shell_ptp( SHELL_CONTEXT *ctx, int argc, char **argv )
+{
+    GPTP *g = &context->gptp;
+    GPTP_STATS stats;
+    uint64_t now;
+    unsigned cd;
+
+    if ((argc >= 2) && (strcmp(argv[1], "reset") == 0)) {
+        xSemaphoreTake((SemaphoreHandle_t)context->gptpLock, portMAX_DELAY);
+        gptpResetStats(g);
+        xSemaphoreGive((SemaphoreHandle_t)context->gptpLock);
+        return;
+    }
+
+    gptpGetStats(g, &stats);
+    printf("State: %s%s\n", stats.locked ? "LOCKED" : "UNLOCKED",
+        stats.asCapable ? ", asCapable" : "");
+    if (g->masterValid) {
+        printf("GM: %02x%02x%02x.%02x%02x.%02x%02x%02x\n",
+            g->gmIdentity[0], g->gmIdentity[1], g->gmIdentity[2],
+            g->gmIdentity[3], g->gmIdentity[4], g->gmIdentity[5],
+            g->gmIdentity[6], g->gmIdentity[7]);
+    } else {
+        printf("GM: None\n");
+    }
+    if (gptpClockNow(context, &now)) {
+        printf("Time: %lu.%09lu\n",
+            (unsigned long)(now / 1000000000ULL),
+            (unsigned long)(now % 1000000000ULL));
+    }
+    printf("Offset: %ld ns (max %ld), Rate: %ld ppb\n",
+        (long)stats.offset, (long)stats.offsetMax, (long)stats.ratePpb);
+    printf("Path delay: %lu ns\n", (unsigned long)stats.meanPathDelay);
+    printf("Syncs: %u, Locks: %u, Steps: %u, Timeouts: %u\n",
+        stats.syncs, stats.locks, stats.steps, stats.timeouts);
+    printf("Pdelays: %u, Pdelay errors: %u\n",
+        stats.pdelays, stats.pdelayErrors);
+    for (cd = 0; cd < CLOCK_DOMAIN_MAX; cd++) {
+        printf("%s: %ld ppb, %u resyncs\n",
+            clock_domain_str((CLOCK_DOMAIN)cd),
+            (long)mediaClockRatePpb(&context->mediaClock[cd]),
+            context->mediaClock[cd].resyncs);
+    }
+}
+
 /***********************************************************************
  * CMD: cmp (file compare)
  **********************************************************************/
@@ -3352,6 +4030,155 @@ void shell_eth(SHELL_CONTEXT *ctx, int argc, char **argv )
     }
 }
 
+/***********************************************************************
+ * CMD: iperf
+ **********************************************************************/
+
+#include "lwip/apps/lwiperf.h"
+#include "lwip/tcpip.h"
+#include "lwip_adi_ether_netif.h"
+
+const char shell_help_iperf[] =
+    "<server|client|stop> [ip] [copy]\n"
+    "  server - Start an iperf TCP server on port 5001\n"
+    "  client - Run a 10 second iperf TCP transmit test to <ip> and\n"
+    "           report throughput, CPU load and zero-copy bytes\n"
+    "  stop   - Stop the server\n"
+    "  copy   - Run the client test with scatter-gather transmit off\n";
+const char shell_help_summary_iperf[] = "Runs iperf throughput tests";
+
+#define IPERF_CLIENT_TIMEOUT_S  15
+
+typedef struct IPERF_REPORT {
+    volatile bool done;
+    enum lwiperf_report_type type;
+    uint32_t bytes;
+    uint32_t ms;
+    uint32_t kbps;
+} IPERF_REPORT;
+
+static void *iperfServer;
+static IPERF_REPORT iperfReport;
+
+static void shell_iperf_report(void *arg, enum lwiperf_report_type report_type,
+    const ip_addr_t* local_addr, u16_t local_port, const ip_addr_t* remote_addr,
+    u16_t remote_port, u32_t bytes_transferred, u32_t ms_duration,
+    u32_t bandwidth_kbitpsec)
+{
+    IPERF_REPORT *report = (IPERF_REPORT *)arg;
+
+    report->type = report_type;
+    report->bytes = bytes_transferred;
+    report->ms = ms_duration;
+    report->kbps = bandwidth_kbitpsec;
+    report->done = true;
+}
+
+static void shell_iperf_print(SHELL_CONTEXT *ctx, IPERF_REPORT *report)
+{
+    printf("%s: %lu bytes in %lu ms, %lu kbit/s\n",
+        (report->type == LWIPERF_TCP_DONE_SERVER) ? "RX" :
+        (report->type == LWIPERF_TCP_DONE_CLIENT) ? "TX" : "Aborted",
+        (unsigned long)report->bytes, (unsigned long)report->ms,
+        (unsigned long)report->kbps);
+}
+
+static void shell_iperf_client(SHELL_CONTEXT *ctx, ip_addr_t *addr, bool copy)
+{
+    struct netif *n = &context->eth[0].netif;
+    uint32_t zeroCopyBytes, copyBytes;
+    uint32_t load, maxLoad, sumLoad;
+    void *session;
+    unsigned secs;
+
+    memset(&iperfReport, 0, sizeof(iperfReport));
+    adi_ether_netif_tx_zero_copy(n, !copy);
+    adi_ether_netif_tx_stats(n, NULL, NULL, true);
+    cpuLoadGetLoad(NULL, true);
+
+    LOCK_TCPIP_CORE();
+    session = lwiperf_start_tcp_client_default(addr,
+        shell_iperf_report, &iperfReport);
+    UNLOCK_TCPIP_CORE();
+
+    if (session == NULL) {
+        printf("Unable to start client\n");
+        adi_ether_netif_tx_zero_copy(n, true);
+        return;
+    }
+
+    /* Sample the CPU load once a second while the test runs */
+    sumLoad = 0;
+    for (secs = 0; secs < IPERF_CLIENT_TIMEOUT_S; secs++) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        if (iperfReport.done) {
+            break;
+        }
+        sumLoad += cpuLoadGetLoad(NULL, false);
+    }
+
+    if (!iperfReport.done) {
+        LOCK_TCPIP_CORE();
+        lwiperf_abort(session);
+        UNLOCK_TCPIP_CORE();
+        printf("Timeout\n");
+    } else {
+        shell_iperf_print(ctx, &iperfReport);
+    }
+
+    load = secs ? sumLoad / secs : cpuLoadGetLoad(NULL, false);
+    cpuLoadGetLoad(&maxLoad, false);
+    adi_ether_netif_tx_stats(n, &zeroCopyBytes, &copyBytes, false);
+    adi_ether_netif_tx_zero_copy(n, true);
+
+    printf("ARM CPU Load: %u%% (%u%% peak)\n",
+        (unsigned)load, (unsigned)maxLoad);
+    printf("TX zero-copy: %lu bytes, copied: %lu bytes\n",
+        (unsigned long)zeroCopyBytes, (unsigned long)copyBytes);
+}
+
+void shell_iperf(SHELL_CONTEXT *ctx, int argc, char **argv )
+{
+    ip_addr_t addr;
+
+    if (argc < 2) {
+        printf("Server %s\n", iperfServer ? "running" : "stopped");
+        if (iperfReport.done) {
+            shell_iperf_print(ctx, &iperfReport);
+        }
+        return;
+    }
+
+    if (strcmp(argv[1], "server") == 0) {
+        if (iperfServer == NULL) {
+            memset(&iperfReport, 0, sizeof(iperfReport));
+            LOCK_TCPIP_CORE();
+            iperfServer = lwiperf_start_tcp_server_default(
+                shell_iperf_report, &iperfReport);
+            UNLOCK_TCPIP_CORE();
+        }
+        if (iperfServer == NULL) {
+            printf("Unable to start server\n");
+        }
+    } else if (strcmp(argv[1], "stop") == 0) {
+        if (iperfServer) {
+            LOCK_TCPIP_CORE();
+            lwiperf_abort(iperfServer);
+            UNLOCK_TCPIP_CORE();
+            iperfServer = NULL;
+        }
+    } else if ((strcmp(argv[1], "client") == 0) && (argc >= 3)) {
+        if (!ipaddr_aton(argv[2], &addr)) {
+            printf("Invalid IP address\n");
+            return;
+        }
+        shell_iperf_client(ctx, &addr,
+            (argc >= 4) && (strcmp(argv[3], "copy") == 0));
+    } else {
+        printf("Invalid arguments\n");
+    }
+}
+
 /***********************************************************************
  * CMD: browse
  **********************************************************************/
@@ -3645,3 +4472,179 @@ void shell_browse(SHELL_CONTEXT *ctx, int argc, char **argv)
     /*     printf("Invalid input parameter. Type help [<command>] for usage.\n"); */
     /* } */
 }
+
+/***********************************************************************
+ * CMD: sched
+ **********************************************************************/
+#include "sched_trace.h"
+
+const char shell_help_sched[] =
+    "<start|stop|status|save [file]>\n"
+    "  start  - Start capturing scheduler, ISR and IPC events\n"
+    "  stop   - Stop capturing, the most recent events are kept\n"
+    "  status - Show the capture state\n"
+    "  save   - Stop and write the capture as Chrome trace JSON\n"
+    "           (default " SCHED_TRACE_DEFAULT_FILE ")\n"
+    "  Open the file in chrome://tracing or ui.perfetto.dev\n";
+
+const char shell_help_summary_sched[] =
+    "Capture a FreeRTOS scheduler timeline";
+
+void shell_sched(SHELL_CONTEXT *ctx, int argc, char **argv)
+{
+    SCHED_TRACE_STATUS status;
+    const char *fname;
+    int events;
+
+    if (argc < 2) {
+        printf("Invalid arguments. Type help [<command>] for usage.\n");
+        return;
+    }
+
+    if (strcmp(argv[1], "start") == 0) {
+        if (!sched_trace_start()) {
+            printf("Unable to allocate trace buffer\n");
+        }
+    } else if (strcmp(argv[1], "stop") == 0) {
+        sched_trace_stop();
+    } else if (strcmp(argv[1], "status") == 0) {
+        sched_trace_status(&status);
+        printf("Capture: %s\n", status.running ? "running" : "stopped");
+        printf("Events: %u of %u\n",
+            (unsigned)status.events, (unsigned)status.capacity);
+        printf("Tasks: %u\n", (unsigned)status.tasks);
+    } else if (strcmp(argv[1], "save") == 0) {
+        fname = (argc > 2) ? argv[2] : SCHED_TRACE_DEFAULT_FILE;
+        events = sched_trace_save(fname);
+        if (events < 0) {
+            printf("Error saving %s\n", fname);
+        } else {
+            printf("Saved %d events to %s\n", events, fname);
+        }
+    } else {
+        printf("Invalid arguments. Type help [<command>] for usage.\n");
+    }
+}
+
+/***********************************************************************
+ * CMD: sharc
+ **********************************************************************/
+#include "clocks.h"
+#include "sharc_audio.h"
+
+const char shell_help_sharc[] =
+    "[sync|pipelined] | [chain <on|off>] | [sched <on|off>] |\n"
+    "  [conv <node> <file|off>]\n"
+    "  sync      - Route SHARC output in the same block, with a bounded\n"
+    "              wait for the SHARCs\n"
+    "  pipelined - SHARC output a block later, never waits (default)\n"
+    "  chain     - SHARC0 output feeds SHARC1 directly, route into\n"
+    "              sharc0 and out of sharc1\n"
+    "  sched     - Share DSP jobs between the SHARCs by measured cost\n"
+    "  conv      - Convolve DSP node 0 or 1 with the impulse responses\n"
+    "              in a wave file, one per channel, or turn it off\n"
+    "  No argument shows the mode, deadline misses and job plan\n";
+
+const char shell_help_summary_sharc[] = "Selects the SHARC processing latency";
+
+void shell_sharc(SHELL_CONTEXT *ctx, int argc, char **argv)
+{
+    SHARC_SCHED *sched;
+    uint32_t load[2];
+    unsigned job;
+    int i;
+
+    if (argc >= 2) {
+        if (strcmp(argv[1], "sync") == 0) {
+            context->sharcSync = true;
+        } else if (strcmp(argv[1], "pipelined") == 0) {
+            context->sharcSync = false;
+        } else if ((argc >= 3) && (strcmp(argv[1], "chain") == 0)) {
+#if SHARC_IPC_BLOCK
+            context->sharcChain = (strcmp(argv[2], "on") == 0);
+#else
+            printf("Chaining needs SHARC_IPC_BLOCK\n");
+#endif
+        } else if ((argc >= 3) && (strcmp(argv[1], "sched") == 0)) {
+#if SHARC_IPC_BLOCK
+            sharc_sched_enable(&context->sharcSched,
+                strcmp(argv[2], "on") == 0);
+#else
+            printf("Scheduling needs SHARC_IPC_BLOCK\n");
+#endif
+        } else if ((argc >= 4) && (strcmp(argv[1], "conv") == 0)) {
+            if (!sharcConvLoad(context, strtoul(argv[2], NULL, 0),
+                    (strcmp(argv[3], "off") == 0) ? NULL : argv[3])) {
+                printf("Convolver load failed\n");
+            }
+        } else {
+            printf("Invalid arguments. Type help [<command>] for usage.\n");
+        }
+        return;
+    }
+
+    printf("SHARC mode: %s%s\n", context->sharcSync ? "sync" : "pipelined",
+        context->sharcChain ? ", chained" : "");
+    printf("  %lu blocks, %lu deadline misses, peak wait %lu us\n",
+        (unsigned long)context->sharcSyncBlocks,
+        (unsigned long)context->sharcSyncMisses,
+        (unsigned long)(((uint64_t)context->sharcSyncWaitPeak * 1000000) /
+            CGU_TS_CLK));
+
+    sched = &context->sharcSched;
+    printf("DSP jobs: %s, %lu rebalances\n",
+        sched->enabled ? "shared" : "home cores",
+        (unsigned long)sched->rebalances);
+    for (job = 0; job < IPC_DSP_JOBS; job++) {
+        printf("  node %u group %u: SHARC%u, %lu cycles%s\n",
+            job / IPC_DSP_GROUPS, job % IPC_DSP_GROUPS,
+            (unsigned)(IPC_DSP_JOB_CORE(sched->plan, job) - IPC_CORE_SHARC0),
+            (unsigned long)sched->jobCycles[job],
+            (sched->pinned & (1u << job)) ? ", pinned" : "");
+    }
+    sharc_sched_cost(sched, sched->plan, load);
+    for (i = 0; i < 2; i++) {
+        printf("  SHARC%d: %lu%% of a block\n", i,
+            (unsigned long)(((uint64_t)load[i] * 100) / sched->budget));
+    }
+}
+
+/***********************************************************************
+ * CMD: fft
+ **********************************************************************/
+const char shell_help_fft[] =
+    "[reset]\n"
+    "  Shows the FFT accelerator queue utilization, batching and the\n"
+    "  job latency by priority since the last reset\n"
+    "  reset - Show, then start the stats over\n";
+
+const char shell_help_summary_fft[] = "Shows FFT accelerator queue stats";
+
+void shell_fft(SHELL_CONTEXT *ctx, int argc, char **argv)
+{
+    static const char *prioName[FFT_QUEUE_PRIORITIES] = {
+        "live", "display", "background"
+    };
+    FFT_QUEUE_PRIO_STATS *ps;
+    FFT_QUEUE_STATS st;
+    bool reset;
+    unsigned p;
+
+    reset = (argc >= 2) && (strcmp(argv[1], "reset") == 0);
+    fft_queue_stats(&context->fftQueue, &st, reset);
+
+    printf("FFT queue: %lu jobs in %lu batches, %lu batched, %lu errors\n",
+        (unsigned long)st.jobs, (unsigned long)st.batches,
+        (unsigned long)st.batched, (unsigned long)st.errors);
+    printf("  %lu%% busy over %lu ms, deepest queue %lu\n",
+        st.elapsed ? (unsigned long)((st.busy * 100) / st.elapsed) : 0UL,
+        (unsigned long)(((uint64_t)st.elapsed * 1000) / CGU_TS_CLK),
+        (unsigned long)st.queuedMax);
+    for (p = 0; p < FFT_QUEUE_PRIORITIES; p++) {
+        ps = &st.prio[p];
+        printf("  %-10s %6lu jobs, latency avg %lu max %lu us, "
+            "wait max %lu us\n", prioName[p], (unsigned long)ps->jobs,
+            ps->jobs ? ticks_us((uint32_t)(ps->latencySum / ps->jobs)) : 0UL,
+            ticks_us(ps->latencyMax), ticks_us(ps->waitMax));
+    }
+}
@@ -22,10 +22,13 @@
  * R.Hempel 2016-12-04 - Add support for Unity test framework
  *                     - Reorganize source files to avoid redundant content
  *                     - Move integrity and poison checking to separate file
+ * ADI 2026-10-19      - Per-heap allocator selection with a TLSF backend
+ *                     - Per-heap allocation statistics
  * ----------------------------------------------------------------------------
  */
 
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 
 
@@ -65,6 +68,9 @@ SemaphoreHandle_t umm_heap_locks[UMM_NUM_HEAPS];
 umm_block *umm_heaps[UMM_NUM_HEAPS];
 unsigned umm_heap_blocks[UMM_NUM_HEAPS];
 
+const unsigned char umm_heap_alloc[UMM_NUM_HEAPS] = UMM_HEAP_ALLOCATORS;
+UMM_HEAP_STATS umm_heap_stat[UMM_NUM_HEAPS];
+
 /* ------------------------------------------------------------------------ */
 
 #define UMM_BLOCK(b)  (umm_heap[b])
@@ -83,6 +89,11 @@ unsigned umm_heap_blocks[UMM_NUM_HEAPS];
  * -------------------------------------------------------------------------
  */
 
+static void *umm_heap_malloc( umm_heap_t heap, size_t size );
+static void *umm_heap_realloc( umm_heap_t heap, void *ptr, size_t size );
+static void  umm_heap_free( umm_heap_t heap, void *ptr );
+
+#include "umm_tlsf.c_"
 #include "umm_integrity.c_"
 #include "umm_poison.c_"
 #include "umm_info.c_"
@@ -209,6 +220,13 @@ void umm_init( umm_heap_t HEAP_TYPE, void *UMM_MALLOC_CFG_HEAP_ADDR, unsigned in
   memset(umm_heap, 0x00, UMM_MALLOC_CFG_HEAP_SIZE);
   umm_heap_blocks[HEAP_TYPE] = umm_numblocks;
 
+  memset(&umm_heap_stat[HEAP_TYPE], 0x00, sizeof(umm_heap_stat[HEAP_TYPE]));
+
+  if (umm_heap_alloc[HEAP_TYPE] == UMM_ALLOC_TLSF) {
+    umm_tlsf_init(HEAP_TYPE, UMM_MALLOC_CFG_HEAP_ADDR, UMM_MALLOC_CFG_HEAP_SIZE);
+    return;
+  }
+
   /* setup initial blank heap structure */
   {
     /* index of the 0th `umm_block` */
@@ -261,7 +279,11 @@ void umm_init( umm_heap_t HEAP_TYPE, void *UMM_MALLOC_CFG_HEAP_ADDR, unsigned in
 
 /* ------------------------------------------------------------------------ */
 
-void umm_free_heap(umm_heap_t heap, void *ptr ) {
+/*
+ * The first-fit functions below are called by the umm_heap_*() dispatchers
+ * with the heap lock held.
+ */
+static void umm_ff_free(umm_heap_t heap, void *ptr ) {
 
   umm_block *umm_heap;
   unsigned int c;
@@ -283,9 +305,6 @@ void umm_free_heap(umm_heap_t heap, void *ptr ) {
    *        on the free list!
    */
 
-  /* Protect the critical section... */
-  UMM_CRITICAL_ENTRY(heap);
-
   /* Select the appropriate heap */
   umm_heap = umm_heaps[heap];
 
@@ -321,14 +340,11 @@ void umm_free_heap(umm_heap_t heap, void *ptr ) {
 
     UMM_NBLOCK(c)          |= UMM_FREELIST_MASK;
   }
-
-  /* Release the critical section... */
-  UMM_CRITICAL_EXIT(heap);
 }
 
 /* ------------------------------------------------------------------------ */
 
-void *umm_malloc_heap(umm_heap_t heap, size_t size ) {
+static void *umm_ff_malloc(umm_heap_t heap, size_t size ) {
 
   umm_block *umm_heap;
 
@@ -353,9 +369,6 @@ void *umm_malloc_heap(umm_heap_t heap, size_t size ) {
     return( (void *)NULL );
   }
 
-  /* Protect the critical section... */
-  UMM_CRITICAL_ENTRY(heap);
-
   /* Select the appropriate heap */
   umm_heap = umm_heaps[heap];
 
@@ -447,21 +460,15 @@ void *umm_malloc_heap(umm_heap_t heap, size_t size ) {
 
     DBGLOG_DEBUG(  "Can't allocate %5i blocks\n", blocks );
 
-    /* Release the critical section... */
-    UMM_CRITICAL_EXIT(heap);
-
     return( (void *)NULL );
   }
 
-  /* Release the critical section... */
-  UMM_CRITICAL_EXIT(heap);
-
   return( (void *)&UMM_DATA(cf) );
 }
 
 /* ------------------------------------------------------------------------ */
 
-void *umm_realloc_heap(umm_heap_t heap, void *ptr, size_t size ) {
+static void *umm_ff_realloc(umm_heap_t heap, void *ptr, size_t size ) {
 
   umm_block *umm_heap;
 
@@ -483,7 +490,7 @@ void *umm_realloc_heap(umm_heap_t heap, void *ptr, size_t size ) {
   if( ((void *)NULL == ptr) ) {
     DBGLOG_DEBUG( "realloc the NULL pointer - call malloc()\n" );
 
-    return( umm_malloc_heap(heap, size) );
+    return( umm_ff_malloc(heap, size) );
   }
 
   /*
@@ -495,14 +502,11 @@ void *umm_realloc_heap(umm_heap_t heap, void *ptr, size_t size ) {
   if( 0 == size ) {
     DBGLOG_DEBUG( "realloc to 0 size, just free the block\n" );
 
-    umm_free_heap( heap, ptr );
+    umm_ff_free( heap, ptr );
 
     return( (void *)NULL );
   }
 
-  /* Protect the critical section... */
-  UMM_CRITICAL_ENTRY(heap);
-
   /* Select the appropriate heap */
   umm_heap = umm_heaps[heap];
 
@@ -540,9 +544,6 @@ void *umm_realloc_heap(umm_heap_t heap, void *ptr, size_t size ) {
 
     DBGLOG_DEBUG( "realloc the same size block - %i, do nothing\n", blocks );
 
-    /* Release the critical section... */
-    UMM_CRITICAL_EXIT(heap);
-
     return( ptr );
   }
 
@@ -611,7 +612,7 @@ void *umm_realloc_heap(umm_heap_t heap, void *ptr, size_t size ) {
     DBGLOG_DEBUG( "realloc %i to a smaller block %i, shrink and free the leftover bits\n", blockSize, blocks );
 
     umm_split_block( umm_heap, c, blocks, 0 );
-    umm_free_heap( heap, (void *)&UMM_DATA(c+blocks) );
+    umm_ff_free( heap, (void *)&UMM_DATA(c+blocks) );
   } else {
     /* New block is bigger than the old block... */
 
@@ -624,14 +625,78 @@ void *umm_realloc_heap(umm_heap_t heap, void *ptr, size_t size ) {
      * free up the old block, but only if the malloc was sucessful!
      */
 
-    if( (ptr = umm_malloc_heap( heap, size )) ) {
+    if( (ptr = umm_ff_malloc( heap, size )) ) {
       memcpy( ptr, oldptr, curSize );
     }
 
-    umm_free_heap( heap, oldptr );
+    umm_ff_free( heap, oldptr );
+  }
+
+  return( ptr );
+}
+
+/* ------------------------------------------------------------------------ */
+
+/*
+ * Usable size of an allocated block, used for the heap statistics.
+ */
+static size_t umm_heap_block_size( umm_heap_t heap, void *ptr ) {
+  umm_block *umm_heap;
+  unsigned int c;
+
+  if( umm_heap_alloc[heap] == UMM_ALLOC_TLSF ) {
+    return( umm_tlsf_block_size( ptr ) );
+  }
+
+  umm_heap = umm_heaps[heap];
+  c = (((char *)ptr)-(char *)(&(umm_heap[0])))/sizeof(umm_block);
+
+  return( ((UMM_NBLOCK(c) & UMM_BLOCKNO_MASK) - c) * sizeof(umm_block) -
+    sizeof(((umm_block *)0)->header) );
+}
+
+/* ------------------------------------------------------------------------ */
+
+static void umm_heap_used( UMM_HEAP_STATS *stats, size_t freed, size_t alloced ) {
+  stats->usedBytes = stats->usedBytes - freed + alloced;
+  if( stats->usedBytes > stats->peakUsedBytes ) {
+    stats->peakUsedBytes = stats->usedBytes;
+  }
+}
+
+/* ------------------------------------------------------------------------ */
+/*
+ * Backend dispatchers.  These take the heap lock, run the integrity check
+ * when enabled and time the allocator itself for the heap statistics.
+ */
+static void *umm_heap_malloc( umm_heap_t heap, size_t size ) {
+  UMM_HEAP_STATS *stats = &umm_heap_stat[heap];
+  unsigned int ticks;
+  void *ptr;
+
+  UMM_CRITICAL_ENTRY(heap);
+
+  INTEGRITY_CHECK(heap);
+
+  ticks = UMM_TIMESTAMP();
+  if( umm_heap_alloc[heap] == UMM_ALLOC_TLSF ) {
+    ptr = umm_tlsf_malloc( heap, size );
+  } else {
+    ptr = umm_ff_malloc( heap, size );
+  }
+  ticks = UMM_TIMESTAMP() - ticks;
+
+  stats->mallocTicks += ticks;
+  if( ticks > stats->mallocMaxTicks ) {
+    stats->mallocMaxTicks = ticks;
+  }
+  if( ptr ) {
+    stats->allocs++;
+    umm_heap_used( stats, 0, umm_heap_block_size( heap, ptr ) );
+  } else if( size ) {
+    stats->failures++;
   }
 
-  /* Release the critical section... */
   UMM_CRITICAL_EXIT(heap);
 
   return( ptr );
@@ -639,6 +704,113 @@ void *umm_realloc_heap(umm_heap_t heap, void *ptr, size_t size ) {
 
 /* ------------------------------------------------------------------------ */
 
+static void umm_heap_free( umm_heap_t heap, void *ptr ) {
+  UMM_HEAP_STATS *stats = &umm_heap_stat[heap];
+  unsigned int ticks;
+  size_t size;
+
+  if( ptr == NULL ) {
+    return;
+  }
+
+  UMM_CRITICAL_ENTRY(heap);
+
+  INTEGRITY_CHECK(heap);
+
+  size = umm_heap_block_size( heap, ptr );
+
+  ticks = UMM_TIMESTAMP();
+  if( umm_heap_alloc[heap] == UMM_ALLOC_TLSF ) {
+    umm_tlsf_free( heap, ptr );
+  } else {
+    umm_ff_free( heap, ptr );
+  }
+  ticks = UMM_TIMESTAMP() - ticks;
+
+  stats->frees++;
+  stats->freeTicks += ticks;
+  if( ticks > stats->freeMaxTicks ) {
+    stats->freeMaxTicks = ticks;
+  }
+  umm_heap_used( stats, size, 0 );
+
+  UMM_CRITICAL_EXIT(heap);
+}
+
+/* ------------------------------------------------------------------------ */
+
+static void *umm_heap_realloc( umm_heap_t heap, void *ptr, size_t size ) {
+  UMM_HEAP_STATS *stats = &umm_heap_stat[heap];
+  size_t oldSize;
+  void *ret;
+
+  if( ptr == NULL ) {
+    return( umm_heap_malloc( heap, size ) );
+  }
+  if( size == 0 ) {
+    umm_heap_free( heap, ptr );
+    return( NULL );
+  }
+
+  UMM_CRITICAL_ENTRY(heap);
+
+  INTEGRITY_CHECK(heap);
+
+  oldSize = umm_heap_block_size( heap, ptr );
+
+  if( umm_heap_alloc[heap] == UMM_ALLOC_TLSF ) {
+    ret = umm_tlsf_realloc( heap, ptr, size );
+  } else {
+    ret = umm_ff_realloc( heap, ptr, size );
+  }
+
+  if( ret ) {
+    umm_heap_used( stats, oldSize, umm_heap_block_size( heap, ret ) );
+  } else {
+    stats->failures++;
+    if( umm_heap_alloc[heap] != UMM_ALLOC_TLSF ) {
+      /* The first-fit realloc releases the old block on failure */
+      umm_heap_used( stats, oldSize, 0 );
+    }
+  }
+
+  UMM_CRITICAL_EXIT(heap);
+
+  return( ret );
+}
+
+/* ------------------------------------------------------------------------ */
+
+void umm_free_heap( umm_heap_t heap, void *ptr ) {
+#ifdef UMM_POISON_CHECK
+  umm_poison_free( heap, ptr );
+#else
+  umm_heap_free( heap, ptr );
+#endif
+}
+
+/* ------------------------------------------------------------------------ */
+
+void *umm_malloc_heap( umm_heap_t heap, size_t size ) {
+#ifdef UMM_POISON_CHECK
+  return( umm_poison_malloc( heap, size ) );
+#else
+  return( umm_heap_malloc( heap, size ) );
+#endif
+}
+
+/* ------------------------------------------------------------------------ */
+
+void *umm_realloc_heap( umm_heap_t heap, void *ptr, size_t size ) {
+#ifdef UMM_POISON_CHECK
+  return( umm_poison_realloc( heap, ptr, size ) );
+#else
+  return( umm_heap_realloc( heap, ptr, size ) );
+#endif
+}
+
+/* ------------------------------------------------------------------------ */
+
 void *umm_calloc_heap(umm_heap_t heap, size_t num, size_t item_size ) {
   void *ret;
 
@@ -651,6 +823,33 @@ void *umm_calloc_heap(umm_heap_t heap, size_t num, size_t item_size ) {
 
 /* ------------------------------------------------------------------------ */
 
+void umm_heap_stats( umm_heap_t heap, UMM_HEAP_STATS *stats, int reset ) {
+  UMM_HEAP_STATS *s = &umm_heap_stat[heap];
+
+  UMM_CRITICAL_ENTRY(heap);
+
+  if( stats ) {
+    *stats = *s;
+  }
+
+  if( reset ) {
+    s->allocs = s->frees = s->failures = 0;
+    s->mallocMaxTicks = s->freeMaxTicks = 0;
+    s->mallocTicks = s->freeTicks = 0;
+    s->peakUsedBytes = s->usedBytes;
+  }
+
+  UMM_CRITICAL_EXIT(heap);
+}
+
+/* ------------------------------------------------------------------------ */
+
+const char *umm_heap_allocator( umm_heap_t heap ) {
+  return( (umm_heap_alloc[heap] == UMM_ALLOC_TLSF) ? "TLSF" : "First-fit" );
+}
+
+/* ------------------------------------------------------------------------ */
+
 void umm_free( void *ptr ) {
   umm_free_heap( UMM_DEFAULT_HEAP, ptr );
 }
@@ -674,7 +873,6 @@ void *umm_calloc( size_t num, size_t item_size ) {
 }
 
 /* ------------------------------------------------------------------------ */
-#include <inttypes.h>
 
 void *umm_malloc_heap_aligned(umm_heap_t heap, size_t size, size_t alignment)
 {
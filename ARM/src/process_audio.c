@@ -24,6 +24,9 @@
 #include "wav_audio.h"
 #include "rtp_audio.h"
 #include "vban_audio.h"
+#include "avtp_audio.h"
+#include "gptp_clock.h"
+#include "media_clock.h"
 #include "vu_audio.h"
 #include "usb_audio.h"
 #include "sharc_audio.h"
@@ -32,134 +35,32 @@
 
 static STREAM_INFO STREAMS[STREAM_ID_MAX];
 
-static SYSTEM_AUDIO_TYPE wavSrcBuffer[WAV_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
-static SYSTEM_AUDIO_TYPE wavSinkBuffer[WAV_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
-static SYSTEM_AUDIO_TYPE rtpRxBuffer[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
-static SYSTEM_AUDIO_TYPE rtpTxBuffer[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
-static SYSTEM_AUDIO_TYPE vbanRxBuffer[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
-static SYSTEM_AUDIO_TYPE vbanTxBuffer[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
-
-/* Routes audio between sources and sinks */
-static void routeAudio(CLOCK_DOMAIN clockDomain,
-    STREAM_INFO *streamInfo, unsigned numStreams,
-    ROUTE_INFO *routeInfo, unsigned numRoutes)
+/* Stamps all streams in a clock domain with the block's gPTP time */
+static void stampAudio(CLOCK_DOMAIN clockDomain, STREAM_INFO *streamInfo,
+    uint32_t timestamp)
 {
-    ROUTE_INFO *route;
-    STREAM_INFO *src, *sink, *stream;
-    unsigned channels;
-    int32_t *in32, *out32;
-    int16_t *in16, *out16;
-    unsigned inChannel, outChannel;
-    unsigned frame;
-    unsigned channel;
-    SYSTEM_AUDIO_TYPE sample;
+    STREAM_INFO *stream;
     unsigned i;
-    unsigned attenuationShift;
-    unsigned size;
-
-    /* Run all routes associated with this clock domain */
-    for (i = 0; i < numRoutes; i++) {
-
-        route = &routeInfo[i];
-
-        if (route->srcID == STREAM_ID_UNKNOWN) {
-            continue;
-        }
-        if (route->sinkID == STREAM_ID_UNKNOWN) {
-            continue;
-        }
-
-        src = &streamInfo[route->srcID];
-        sink = &streamInfo[route->sinkID];
-
-        if ((src->data == NULL) || (sink->data == NULL)) {
-            continue;
-        }
-
-        if (src->clockDomain != clockDomain) {
-            continue;
-        }
-        if (sink->clockDomain != clockDomain) {
-            continue;
-        }
-
-#if 1
-        if (src->numFrames != sink->numFrames) {
-            continue;
-        }
-        if ( (src->wordSize != sizeof(int32_t)) &&
-             (src->wordSize != sizeof(int16_t)) ) {
-            continue;
-        }
-        if ( (sink->wordSize != sizeof(int32_t)) &&
-             (sink->wordSize != sizeof(int16_t)) ) {
-            continue;
-        }
-        if (route->srcOffset >= src->numChannels) {
-            continue;
-        }
-        if (route->sinkOffset >= sink->numChannels) {
-            continue;
-        }
-#endif
-
-        inChannel = route->srcOffset;
-        outChannel = route->sinkOffset;
 
-        channels = route->channels;
-        in32 = (int32_t *)src->data + inChannel; in16 = (int16_t *)src->data + inChannel;
-        out32 = (int32_t *)sink->data + outChannel; out16 = (int16_t *)sink->data + outChannel;
-
-        attenuationShift = route->attenuation / 6;
-
-        for (frame = 0; frame < src->numFrames; frame++) {
-            for (channel = 0; channel < channels; channel++) {
-                if ((outChannel + channel) < sink->numChannels) {
-                    if ((inChannel + channel) < src->numChannels) {
-                        if (src->wordSize == sizeof(int32_t)) {
-                            sample = *(in32 + channel);
-                        } else {
-                            sample = *(in16 + channel) << 16;
-                        }
-                     } else {
-                        sample = 0;
-                    }
-                    sample >>= attenuationShift;
-                    if (route->mix) {
-                       if (sink->wordSize == sizeof(int32_t)) {
-                            *(out32 + channel) += sample;
-                        } else {
-                            *(out16 + channel) += sample >> 16;
-                        }
-                    } else {
-                        if (sink->wordSize == sizeof(int32_t)) {
-                            *(out32 + channel) = sample;
-                        } else {
-                            *(out16 + channel) = sample >> 16;
-                        }
-                     }
-                }
-            }
-            in32 += src->numChannels; in16 += src->numChannels;
-            out32 += sink->numChannels; out16 += sink->numChannels;
-        }
-    }
-
-    /* Invalidate all active streams associated with this clock domain */
     for (i = 0; i < STREAM_ID_MAX; i++) {
         stream = &streamInfo[i];
-        if ( (stream->streamID != STREAM_ID_UNKNOWN) &&
+        if ( (stream->data != NULL) &&
              (stream->clockDomain == clockDomain) ) {
-            if (stream->flush) {
-                size = stream->numChannels * stream->numFrames * stream->wordSize;
-                flush_data_buffer(stream->data, (char *)stream->data + size, 0);
-            }
-            stream->streamID = STREAM_ID_UNKNOWN;
-            stream->data = NULL;
+            stream->timestamp = timestamp;
         }
     }
 }
 
+/* Only the SHARC streams can be float, see SHARC_AUDIO_FLOAT */
+static bool inline streamIsFloat(STREAM_ID streamID)
+{
+    return(SHARC_AUDIO_FLOAT &&
+        ((streamID == STREAM_ID_SHARC0_IN) ||
+         (streamID == STREAM_ID_SHARC0_OUT) ||
+         (streamID == STREAM_ID_SHARC1_IN) ||
+         (streamID == STREAM_ID_SHARC1_OUT)));
+}
+
 static void inline setStreamInfo(STREAM_ID streamID,
     unsigned numChannels, unsigned numFrames, unsigned wordSize, CLOCK_DOMAIN cd,
     void *data, bool flush)
@@ -173,8 +74,44 @@ static void inline setStreamInfo(STREAM_ID streamID,
     streamInfo->clockDomain = cd;
     streamInfo->data = data;
     streamInfo->flush = flush;
+    streamInfo->isFloat = streamIsFloat(streamID);
+}
+
+#ifdef SHARC_AUDIO_ENABLE
+/* Points a SHARC output stream at the block the SHARC just finished */
+static void sharcOutNow(CLOCK_DOMAIN cd, STREAM_ID streamID, void *data)
+{
+    STREAM_INFO *stream = STREAMS + streamID;
+
+    if (data && (stream->data != NULL) && (stream->clockDomain == cd)) {
+        stream->data = data;
+    }
 }
 
+/*
+ * Zero added latency mode.  Routes into the SHARCs, runs them on that
+ * block and routes their output onward in the same block.  Routes into
+ * a SHARC input from a SHARC output take the previous block's output,
+ * as they always have.
+ */
+static void sharcSyncAudio(APP_CONTEXT *context, CLOCK_DOMAIN cd,
+    uint32_t timestamp)
+{
+    const uint32_t sharcIn =
+        (1u << STREAM_ID_SHARC0_IN) | (1u << STREAM_ID_SHARC1_IN);
+    void *out[2];
+
+    routeAudioSinks(cd, STREAMS, STREAM_ID_MAX,
+        context->routingTable, MAX_AUDIO_ROUTES, sharcIn, true);
+    sharcProcessAudio(context, cd, timestamp, out);
+    sharcOutNow(cd, STREAM_ID_SHARC0_OUT, out[0]);
+    sharcOutNow(cd, STREAM_ID_SHARC1_OUT, out[1]);
+    routeAudioSinks(cd, STREAMS, STREAM_ID_MAX,
+        context->routingTable, MAX_AUDIO_ROUTES, sharcIn, false);
+    routeAudioRelease(cd, STREAMS, STREAM_ID_MAX);
+}
+#endif
+
 /*
  * This function processes audio that is ready in the various clock domains.
  * 'clockSource' is true for audio sources and sinks that drive a clock
@@ -195,6 +132,9 @@ void processAudio(APP_CONTEXT *context, unsigned mask, STREAM_ID streamID,
 {
     CLOCK_DOMAIN cd;
     bool ready;
+    unsigned i;
+    uint64_t now;
+    uint32_t timestamp;
 
     /*
      * Only audio sources/sinks with inherent clocks call this function so
@@ -211,28 +151,40 @@ void processAudio(APP_CONTEXT *context, unsigned mask, STREAM_ID streamID,
      */
     if (clockSource) {
         if (source) {
-            ready = xferWavSrcAudio(context, wavSrcBuffer, cd, &numChannels);
+            ready = xferWavSrcAudio(context, &data, cd, &numChannels);
             if (ready) {
                 setStreamInfo(
                     STREAM_ID_WAV_SRC, numChannels,
                     SYSTEM_BLOCK_SIZE, sizeof(SYSTEM_AUDIO_TYPE),
-                    cd, wavSrcBuffer, false
+                    cd, data, false
                 );
             }
-            ready = xferRtpRxAudio(context, rtpRxBuffer, cd, &numChannels);
-            if (ready) {
-                setStreamInfo(
-                    STREAM_ID_RTP_RX, numChannels,
-                    SYSTEM_BLOCK_SIZE, sizeof(SYSTEM_AUDIO_TYPE),
-                    cd, rtpRxBuffer, false
-                );
+            for (i = 0; i < RTP_RX_STREAMS; i++) {
+                ready = xferRtpRxAudio(context, i, &data, cd, &numChannels);
+                if (ready) {
+                    setStreamInfo(
+                        rtpRxStreamID(i), numChannels,
+                        SYSTEM_BLOCK_SIZE, sizeof(SYSTEM_AUDIO_TYPE),
+                        cd, data, false
+                    );
+                }
+            }
+            for (i = 0; i < VBAN_RX_STREAMS; i++) {
+                ready = xferVbanRxAudio(context, i, &data, cd, &numChannels);
+                if (ready) {
+                    setStreamInfo(
+                        vbanRxStreamID(i), numChannels,
+                        SYSTEM_BLOCK_SIZE, sizeof(SYSTEM_AUDIO_TYPE),
+                        cd, data, false
+                    );
+                }
             }
-            ready = xferVbanRxAudio(context, vbanRxBuffer, cd, &numChannels);
+            ready = xferAvtpRxAudio(context, &data, cd, &numChannels);
             if (ready) {
                 setStreamInfo(
-                    STREAM_ID_VBAN_RX, numChannels,
+                    STREAM_ID_AVTP_RX, numChannels,
                     SYSTEM_BLOCK_SIZE, sizeof(SYSTEM_AUDIO_TYPE),
-                    cd, vbanRxBuffer, false
+                    cd, data, false
                 );
             }
             ready = xferUsbRxAudio(context, &data, cd);
@@ -262,28 +214,36 @@ void processAudio(APP_CONTEXT *context, unsigned mask, STREAM_ID streamID,
             }
 #endif
         } else {
-            ready = xferWavSinkAudio(context, wavSinkBuffer, cd, &numChannels);
+            ready = xferWavSinkAudio(context, &data, cd, &numChannels);
             if (ready) {
                 setStreamInfo(
                     STREAM_ID_WAV_SINK, numChannels,
                     SYSTEM_BLOCK_SIZE, sizeof(SYSTEM_AUDIO_TYPE),
-                    cd, wavSinkBuffer, false
+                    cd, data, false
                 );
             }
-            ready = xferRtpTxAudio(context, rtpTxBuffer, cd, &numChannels);
+            ready = xferRtpTxAudio(context, &data, cd, &numChannels);
             if (ready) {
                 setStreamInfo(
                     STREAM_ID_RTP_TX, numChannels,
                     SYSTEM_BLOCK_SIZE, sizeof(SYSTEM_AUDIO_TYPE),
-                    cd, rtpTxBuffer, false
+                    cd, data, false
                 );
             }
-            ready = xferVbanTxAudio(context, vbanTxBuffer, cd, &numChannels);
+            ready = xferVbanTxAudio(context, &data, cd, &numChannels);
             if (ready) {
                 setStreamInfo(
                     STREAM_ID_VBAN_TX, numChannels,
                     SYSTEM_BLOCK_SIZE, sizeof(SYSTEM_AUDIO_TYPE),
-                    cd, vbanTxBuffer, false
+                    cd, data, false
+                );
+            }
+            ready = xferAvtpTxAudio(context, &data, cd, &numChannels);
+            if (ready) {
+                setStreamInfo(
+                    STREAM_ID_AVTP_TX, numChannels,
+                    SYSTEM_BLOCK_SIZE, sizeof(SYSTEM_AUDIO_TYPE),
+                    cd, data, false
                 );
             }
             ready = xferUsbTxAudio(context, &data, cd);
@@ -328,18 +288,20 @@ void processAudio(APP_CONTEXT *context, unsigned mask, STREAM_ID streamID,
      */
     ready = clock_domain_ready(context, cd);
     if (ready) {
+        /* Filter the block completion time through the media clock */
+        if (gptpClockNow(context, &now)) {
+            now = mediaClockUpdate(&context->mediaClock[cd], now);
+        } else {
+            now = 0;
+        }
+        timestamp = (uint32_t)now;
+        stampAudio(cd, STREAMS, timestamp);
 #ifdef SHARC_AUDIO_ENABLE
-        SAE_CONTEXT *sae = context->saeContext;
-        SAE_MSG_BUFFER *msg;
-        IPC_MSG *ipcMsg;
-        msg = sae_createMsgBuffer(sae, sizeof(*ipcMsg), (void **)&ipcMsg);
-        if (msg) {
-           ipcMsg->type = IPC_TYPE_PROCESS_AUDIO;
-           ipcMsg->process.clockDomain = cd;
-           sendMsg(sae, msg, IPC_CORE_SHARC0);
-           sendMsg(sae, msg, IPC_CORE_SHARC1);
-           sae_unRefMsgBuffer(sae, msg);
+        if (context->sharcSync) {
+            sharcSyncAudio(context, cd, timestamp);
+            return;
         }
+        sharcProcessAudio(context, cd, timestamp, NULL);
 #endif
         routeAudio(cd,
             STREAMS, STREAM_ID_MAX,
@@ -347,3 +309,22 @@ void processAudio(APP_CONTEXT *context, unsigned mask, STREAM_ID streamID,
         );
     }
 }
+
+void processAudioDetach(const void *data)
+{
+    STREAM_INFO *stream;
+    unsigned i;
+
+    if (data == NULL) {
+        return;
+    }
+
+    for (i = 0; i < STREAM_ID_MAX; i++) {
+        stream = &STREAMS[i];
+        if (stream->data == data) {
+            stream->streamID = STREAM_ID_UNKNOWN;
+            stream->numChannels = 0;
+            stream->data = NULL;
+        }
+    }
+}
@@ -22,4 +22,10 @@ void processAudio(APP_CONTEXT *context, unsigned mask, STREAM_ID streamID,
     void *data, bool flush,
     bool clockSource, bool source);
 
+/*
+ * Drops every stream whose block is 'data' so the block is not routed.
+ * Call with the audio interrupts masked.
+ */
+void processAudioDetach(const void *data);
+
 #endif
@@ -12,6 +12,9 @@
 #ifndef _route_h
 #define _route_h
 
+#include <stdint.h>
+#include <stdbool.h>
+
 #include "clock_domain_defs.h"
 
 /*
@@ -30,9 +33,15 @@ typedef enum _STREAM_ID {
     STREAM_ID_WAV_SRC,
     STREAM_ID_WAV_SINK,
     STREAM_ID_RTP_RX,
+    STREAM_ID_RTP2_RX,
+    STREAM_ID_RTP3_RX,
     STREAM_ID_RTP_TX,
     STREAM_ID_VBAN_RX,
+    STREAM_ID_VBAN2_RX,
+    STREAM_ID_VBAN3_RX,
     STREAM_ID_VBAN_TX,
+    STREAM_ID_AVTP_RX,
+    STREAM_ID_AVTP_TX,
     STREAM_ID_SHARC0_IN,
     STREAM_ID_SHARC0_OUT,
     STREAM_ID_SHARC1_IN,
@@ -43,6 +52,13 @@ typedef enum _STREAM_ID {
     STREAM_ID_MAX
 } STREAM_ID;
 
+/*
+ * Streams are fixed point, 16 or 32-bit left justified, unless
+ * 'isFloat' is set.  Float streams are 32-bit, full scale +/-1.0, and
+ * may go past full scale.  A route between the two converts, saturating
+ * into fixed point, and a route into a float stream mixes without
+ * clipping.
+ */
 typedef struct _STREAM_INFO {
     STREAM_ID streamID;
     unsigned numChannels;
@@ -50,7 +66,10 @@ typedef struct _STREAM_INFO {
     unsigned  wordSize;
     CLOCK_DOMAIN clockDomain;
     bool flush;
+    bool isFloat;
     void *data;
+    /* gPTP time (ns, lower 32 bits) the clock domain completes the block */
+    uint32_t timestamp;
 } STREAM_INFO;
 
 typedef struct _ROUTE_INFO {
@@ -63,4 +82,25 @@ typedef struct _ROUTE_INFO {
     unsigned mix;
 } ROUTE_INFO;
 
+/*
+ * Runs every route whose source and sink are both in 'clockDomain'
+ * then releases all of that clock domain's streams.
+ */
+void routeAudio(CLOCK_DOMAIN clockDomain,
+    STREAM_INFO *streamInfo, unsigned numStreams,
+    ROUTE_INFO *routeInfo, unsigned numRoutes);
+
+/*
+ * routeAudio() in two steps.  routeAudioSinks() runs, in table order,
+ * only the routes whose sink is (or with 'inMask' false, isn't) one of
+ * the STREAM_ID bits in 'sinkMask'.  routeAudioRelease() then releases
+ * the clock domain's streams.
+ */
+void routeAudioSinks(CLOCK_DOMAIN clockDomain,
+    STREAM_INFO *streamInfo, unsigned numStreams,
+    ROUTE_INFO *routeInfo, unsigned numRoutes,
+    uint32_t sinkMask, bool inMask);
+void routeAudioRelease(CLOCK_DOMAIN clockDomain,
+    STREAM_INFO *streamInfo, unsigned numStreams);
+
 #endif
@@ -0,0 +1,318 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(__ADSPARM__)
+#include <runtime/cache/adi_cache.h>
+#else
+#include <sys/cache.h>
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "route.h"
+
+/* Widest stream the float path converts a frame of at a time */
+#define ROUTE_FLOAT_MAX_CHANNELS  (64)
+
+#define ROUTE_SCALE_32  (2147483648.0f)
+#define ROUTE_SCALE_16  (32768.0f)
+
+/*
+ * Loads 'n' channels of one frame as float, times 'gain', zero past
+ * 'avail'.
+ */
+static void routeLoadFloat(const STREAM_INFO *src, const void *in,
+    float *x, unsigned n, unsigned avail, float gain)
+{
+    const int32_t *in32 = in;
+    const int16_t *in16 = in;
+    const float *inF = in;
+    unsigned i = 0;
+    float scale;
+
+    if (avail > n) {
+        avail = n;
+    }
+
+    if (src->isFloat) {
+        for (; i < avail; i++) {
+            x[i] = inF[i] * gain;
+        }
+    } else if (src->wordSize == sizeof(int32_t)) {
+        scale = gain / ROUTE_SCALE_32;
+#if defined(__ARM_NEON)
+        for (; (i + 4) <= avail; i += 4) {
+            vst1q_f32(x + i,
+                vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(in32 + i)), scale));
+        }
+#endif
+        for (; i < avail; i++) {
+            x[i] = (float)in32[i] * scale;
+        }
+    } else {
+        scale = gain / ROUTE_SCALE_16;
+        for (; i < avail; i++) {
+            x[i] = (float)in16[i] * scale;
+        }
+    }
+
+    for (; i < n; i++) {
+        x[i] = 0.0f;
+    }
+}
+
+/* Scales full scale 'y' to an integer, saturating at +/-'max' */
+static inline int32_t routeSaturate(float y, float scale, int32_t max)
+{
+    y *= scale;
+    if (y >= scale) {
+        return(max);
+    }
+    if (y < -scale) {
+        return(-max - 1);
+    }
+    return((int32_t)y);
+}
+
+/*
+ * Stores 'n' channels of one frame, mixing if asked.  A fixed point
+ * sink mixes in float and saturates once rather than wrapping.
+ */
+static void routeStoreFloat(STREAM_INFO *sink, void *out, const float *x,
+    unsigned n, bool mix)
+{
+    int32_t *out32 = out;
+    int16_t *out16 = out;
+    float *outF = out;
+    unsigned i = 0;
+
+    if (sink->isFloat) {
+        if (mix) {
+            for (; i < n; i++) {
+                outF[i] += x[i];
+            }
+        } else {
+            for (; i < n; i++) {
+                outF[i] = x[i];
+            }
+        }
+    } else if (sink->wordSize == sizeof(int32_t)) {
+#if defined(__ARM_NEON)
+        /* vcvtq_s32_f32() truncates and saturates like routeSaturate() */
+        for (; (i + 4) <= n; i += 4) {
+            float32x4_t y = vmulq_n_f32(vld1q_f32(x + i), ROUTE_SCALE_32);
+            if (mix) {
+                y = vaddq_f32(y, vcvtq_f32_s32(vld1q_s32(out32 + i)));
+            }
+            vst1q_s32(out32 + i, vcvtq_s32_f32(y));
+        }
+#endif
+        for (; i < n; i++) {
+            out32[i] = routeSaturate(mix ?
+                x[i] + (float)out32[i] / ROUTE_SCALE_32 : x[i],
+                ROUTE_SCALE_32, INT32_MAX);
+        }
+    } else {
+        for (; i < n; i++) {
+            out16[i] = (int16_t)routeSaturate(mix ?
+                x[i] + (float)out16[i] / ROUTE_SCALE_16 : x[i],
+                ROUTE_SCALE_16, INT16_MAX);
+        }
+    }
+}
+
+/* A route with a float stream at either end */
+static void routeFloat(ROUTE_INFO *route, STREAM_INFO *src, STREAM_INFO *sink)
+{
+    float x[ROUTE_FLOAT_MAX_CHANNELS];
+    unsigned channels, avail;
+    unsigned frame;
+    uint8_t *in, *out;
+    float gain;
+
+    /* Whole 6dB steps, the same as the fixed point shift */
+    gain = 1.0f / (float)(1u << (route->attenuation / 6));
+
+    channels = route->channels;
+    if (route->sinkOffset + channels > sink->numChannels) {
+        channels = sink->numChannels - route->sinkOffset;
+    }
+    if (channels > ROUTE_FLOAT_MAX_CHANNELS) {
+        channels = ROUTE_FLOAT_MAX_CHANNELS;
+    }
+    avail = src->numChannels - route->srcOffset;
+
+    in = (uint8_t *)src->data + route->srcOffset * src->wordSize;
+    out = (uint8_t *)sink->data + route->sinkOffset * sink->wordSize;
+
+    for (frame = 0; frame < src->numFrames; frame++) {
+        routeLoadFloat(src, in, x, channels, avail, gain);
+        routeStoreFloat(sink, out, x, channels, route->mix);
+        in += src->numChannels * src->wordSize;
+        out += sink->numChannels * sink->wordSize;
+    }
+}
+
+/*
+ * Routes audio between sources and sinks.  Kept apart from
+ * processAudio() so the kernel can be checked and benchmarked on a
+ * host against test/test_route.c.
+ */
+void routeAudioSinks(CLOCK_DOMAIN clockDomain,
+    STREAM_INFO *streamInfo, unsigned numStreams,
+    ROUTE_INFO *routeInfo, unsigned numRoutes,
+    uint32_t sinkMask, bool inMask)
+{
+    ROUTE_INFO *route;
+    STREAM_INFO *src, *sink;
+    unsigned channels;
+    int32_t *in32, *out32;
+    int16_t *in16, *out16;
+    unsigned inChannel, outChannel;
+    unsigned frame;
+    unsigned channel;
+    int32_t sample;
+    unsigned i;
+    unsigned attenuationShift;
+
+    /* Run all routes associated with this clock domain */
+    for (i = 0; i < numRoutes; i++) {
+
+        route = &routeInfo[i];
+
+        if (route->srcID == STREAM_ID_UNKNOWN) {
+            continue;
+        }
+        if (route->sinkID == STREAM_ID_UNKNOWN) {
+            continue;
+        }
+        if (((sinkMask & (1u << route->sinkID)) != 0) != inMask) {
+            continue;
+        }
+
+        src = &streamInfo[route->srcID];
+        sink = &streamInfo[route->sinkID];
+
+        if ((src->data == NULL) || (sink->data == NULL)) {
+            continue;
+        }
+
+        if (src->clockDomain != clockDomain) {
+            continue;
+        }
+        if (sink->clockDomain != clockDomain) {
+            continue;
+        }
+
+#if 1
+        if (src->numFrames != sink->numFrames) {
+            continue;
+        }
+        if ( (src->wordSize != sizeof(int32_t)) &&
+             (src->wordSize != sizeof(int16_t)) ) {
+            continue;
+        }
+        if ( (sink->wordSize != sizeof(int32_t)) &&
+             (sink->wordSize != sizeof(int16_t)) ) {
+            continue;
+        }
+        if (route->srcOffset >= src->numChannels) {
+            continue;
+        }
+        if (route->sinkOffset >= sink->numChannels) {
+            continue;
+        }
+#endif
+
+        if (src->isFloat || sink->isFloat) {
+            routeFloat(route, src, sink);
+            continue;
+        }
+
+        inChannel = route->srcOffset;
+        outChannel = route->sinkOffset;
+
+        channels = route->channels;
+        in32 = (int32_t *)src->data + inChannel; in16 = (int16_t *)src->data + inChannel;
+        out32 = (int32_t *)sink->data + outChannel; out16 = (int16_t *)sink->data + outChannel;
+
+        attenuationShift = route->attenuation / 6;
+
+        for (frame = 0; frame < src->numFrames; frame++) {
+            for (channel = 0; channel < channels; channel++) {
+                if ((outChannel + channel) < sink->numChannels) {
+                    if ((inChannel + channel) < src->numChannels) {
+                        if (src->wordSize == sizeof(int32_t)) {
+                            sample = *(in32 + channel);
+                        } else {
+                            sample = *(in16 + channel) << 16;
+                        }
+                     } else {
+                        sample = 0;
+                    }
+                    sample >>= attenuationShift;
+                    if (route->mix) {
+                       if (sink->wordSize == sizeof(int32_t)) {
+                            *(out32 + channel) += sample;
+                        } else {
+                            *(out16 + channel) += sample >> 16;
+                        }
+                    } else {
+                        if (sink->wordSize == sizeof(int32_t)) {
+                            *(out32 + channel) = sample;
+                        } else {
+                            *(out16 + channel) = sample >> 16;
+                        }
+                     }
+                }
+            }
+            in32 += src->numChannels; in16 += src->numChannels;
+            out32 += sink->numChannels; out16 += sink->numChannels;
+        }
+    }
+}
+
+void routeAudioRelease(CLOCK_DOMAIN clockDomain,
+    STREAM_INFO *streamInfo, unsigned numStreams)
+{
+    STREAM_INFO *stream;
+    unsigned size;
+    unsigned i;
+
+    /* Invalidate all active streams associated with this clock domain */
+    for (i = 0; i < STREAM_ID_MAX; i++) {
+        stream = &streamInfo[i];
+        if ( (stream->streamID != STREAM_ID_UNKNOWN) &&
+             (stream->clockDomain == clockDomain) ) {
+            if (stream->flush) {
+                size = stream->numChannels * stream->numFrames * stream->wordSize;
+                flush_data_buffer(stream->data, (char *)stream->data + size, 0);
+            }
+            stream->streamID = STREAM_ID_UNKNOWN;
+            stream->data = NULL;
+        }
+    }
+}
+
+void routeAudio(CLOCK_DOMAIN clockDomain,
+    STREAM_INFO *streamInfo, unsigned numStreams,
+    ROUTE_INFO *routeInfo, unsigned numRoutes)
+{
+    routeAudioSinks(clockDomain, streamInfo, numStreams,
+        routeInfo, numRoutes, 0, false);
+    routeAudioRelease(clockDomain, streamInfo, numStreams);
+}
@@ -21,171 +21,231 @@
 #include "util.h"
 #include "rtp_audio.h"
 #include "rtp_stream.h"
-#include "umm_malloc.h"
+#include "audio_pool.h"
+#include "trace_log.h"
 #include "clock_domain.h"
 
-static unsigned rtpRxUnderflow = 0;
+static unsigned rtpRxUnderflow[RTP_RX_STREAMS];
+static unsigned rtpRxOverflow[RTP_RX_STREAMS];
 static unsigned rtpTxOverflow = 0;
 
+/* Route stream and clock domain of each Rx stream */
+static const STREAM_ID rtpRxStreamIDs[RTP_RX_STREAMS] = {
+    STREAM_ID_RTP_RX, STREAM_ID_RTP2_RX, STREAM_ID_RTP3_RX
+};
+static const unsigned rtpRxClockDomainMasks[RTP_RX_STREAMS] = {
+    CLOCK_DOMAIN_BITM_RTP_RX, CLOCK_DOMAIN_BITM_RTP2_RX,
+    CLOCK_DOMAIN_BITM_RTP3_RX
+};
+
 /* Task notification values */
 enum {
     RTP_TASK_NO_ACTION,
-    RTP_TASK_AUDIO_RX_MORE_DATA,
     RTP_TASK_AUDIO_TX_MORE_DATA,
 };
 
-static SYSTEM_AUDIO_TYPE rxBuffer[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
-static SYSTEM_AUDIO_TYPE txBuffer[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
+STREAM_ID rtpRxStreamID(unsigned idx)
+{
+    return(rtpRxStreamIDs[idx]);
+}
 
-/* This task puts RTP frames into the RTP Rx ring buffer */
-portTASK_FUNCTION(rtpRxTask, pvParameters)
+unsigned rtpRxClockDomainMask(unsigned idx)
 {
-    APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
-    RTP_STREAM *rtpRx = &context->rtpRx;
-    PaUtilRingBuffer *rtpRxRB = context->rtpRxRB;
-    uint32_t whatToDo;
-    unsigned samplesIn;
+    return(rtpRxClockDomainMasks[idx]);
+}
+
+/*
+ * This callback puts RTP payloads into the stream's Rx ring buffer
+ * (jitter buffer).  It runs in the lwIP receive context for every
+ * stream the packet was demultiplexed to and converts directly from
+ * the network buffer into the ring buffer's write regions.
+ */
+static void rtpRxAudio(RTP_STREAM *rtpRx, void *data, unsigned samples,
+    void *usrPtr)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
+    unsigned idx = rtpRx - context->rtpRx;
+    PaUtilRingBuffer *rtpRxRB = context->rtpRxRB[idx];
+    ring_buffer_size_t size1, size2;
+    void *buf1, *buf2;
     unsigned samplesOut;
-    unsigned framesIn;
-    unsigned framesOut;
-    void *data;
 
-    while (1) {
-        xSemaphoreTake((SemaphoreHandle_t)rtpRx->lock, portMAX_DELAY);
-        if (rtpRx->enabled) {
-            samplesIn = rtpReadSamplesAvailable(rtpRx, &data);
-            samplesOut = PaUtil_GetRingBufferWriteAvailable(rtpRxRB);
-            while (samplesIn && (samplesOut >= samplesIn)) {
-                framesIn = samplesIn / rtpRx->channels;
-                framesOut = samplesOut / rtpRx->channels;
-                if (framesOut > SYSTEM_BLOCK_SIZE) {
-                    framesOut = SYSTEM_BLOCK_SIZE;
-                }
-                if (framesOut > framesIn) {
-                    framesOut = framesIn;
-                }
-                samplesOut = framesOut * rtpRx->channels;
-                if (rtpRx->wordSizeBytes == sizeof(SYSTEM_AUDIO_TYPE)) {
-                    PaUtil_WriteRingBuffer(rtpRxRB, data, samplesOut);
-                } else {
-                    copyAndConvert(
-                        data, rtpRx->wordSizeBytes, rtpRx->channels,
-                        rxBuffer, sizeof(SYSTEM_AUDIO_TYPE), rtpRx->channels,
-                        framesOut, false
-                    );
-                    PaUtil_WriteRingBuffer(rtpRxRB, rxBuffer, samplesOut);
-                }
-                rtpReadSamples(rtpRx, samplesOut);
-                samplesIn = rtpReadSamplesAvailable(rtpRx, &data);
-                samplesOut = PaUtil_GetRingBufferWriteAvailable(rtpRxRB);
-                if (rtpRx->preRoll && (samplesOut < (RTP_RING_BUF_SAMPLES / 2))) {
-                    rtpRx->preRoll = false;
-                }
-            }
-        } else {
-            PaUtil_FlushRingBuffer(rtpRxRB);
-            rtpRx->preRoll = true;
-        }
-        xSemaphoreGive((SemaphoreHandle_t)rtpRx->lock);
-        whatToDo = ulTaskNotifyTake(pdTRUE, 1);
+    if (rtpRxRB == NULL) {
+        return;
+    }
+
+    samplesOut = PaUtil_GetRingBufferWriteAvailable(rtpRxRB);
+    if (samplesOut < samples) {
+        rtpRxOverflow[idx]++;
+        TRACE_LOG3(TRACE_ID_RTP_RX_OVERFLOW, idx, samplesOut, samples);
+        return;
+    }
+
+    PaUtil_GetRingBufferWriteRegions(rtpRxRB, samples,
+        &buf1, &size1, &buf2, &size2);
+    swapAndConvert(
+        data, rtpRx->wordSizeBytes,
+        buf1, sizeof(SYSTEM_AUDIO_TYPE), size1
+    );
+    if (size2) {
+        swapAndConvert(
+            (uint8_t *)data + size1 * rtpRx->wordSizeBytes, rtpRx->wordSizeBytes,
+            buf2, sizeof(SYSTEM_AUDIO_TYPE), size2
+        );
+    }
+    PaUtil_AdvanceRingBufferWriteIndex(rtpRxRB, samples);
+
+    samplesOut -= samples;
+    if (rtpRx->preRoll && (samplesOut < (rtpRxRB->bufferSize / 2))) {
+        rtpRx->preRoll = false;
     }
 }
 
+/* Wakes the Tx task once RTP_TX_WAKE_BLOCKS are queued (ISR context) */
+static void rtpTxHighWatermark(PaUtilRingBuffer *rb, void *usrPtr)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
+    BaseType_t wake = pdFALSE;
+
+    xTaskNotifyFromISR(context->rtpTxTaskHandle,
+        RTP_TASK_AUDIO_TX_MORE_DATA, eSetValueWithoutOverwrite, &wake
+    );
+    portYIELD_FROM_ISR(wake);
+}
+
 /* This task emits RTP frames from the RTP Tx ring buffer */
 portTASK_FUNCTION(rtpTxTask, pvParameters)
 {
     APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
     RTP_STREAM *rtpTx = &context->rtpTx;
-    PaUtilRingBuffer *rtpTxRB = context->rtpTxRB;
+    PaUtilRingBuffer *rtpTxRB;
+    ring_buffer_size_t size1, size2;
+    void *buf1, *buf2;
     uint32_t whatToDo;
     unsigned samplesIn;
     unsigned samplesOut;
     unsigned wsize;
-    bool ok;
     void *data;
 
     while (1) {
         xSemaphoreTake((SemaphoreHandle_t)rtpTx->lock, portMAX_DELAY);
-        if (rtpTx->enabled) {
+        rtpTxRB = context->rtpTxRB;
+        if (rtpTx->enabled && rtpTxRB) {
             samplesIn = PaUtil_GetRingBufferReadAvailable(rtpTxRB);
             samplesOut = rtpTx->channels * SYSTEM_BLOCK_SIZE;
-            ok = true;
-            while (ok && (samplesIn > samplesOut)) {
+            while (samplesIn > samplesOut) {
                 wsize = rtpWriteSamplesAvailable(rtpTx, &data);
                 if (wsize > samplesOut) {
                     wsize = samplesOut;
                 }
-                if (rtpTx->wordSizeBytes == sizeof(SYSTEM_AUDIO_TYPE)) {
-                    PaUtil_ReadRingBuffer(rtpTxRB, data, wsize);
-                } else {
-                    PaUtil_ReadRingBuffer(rtpTxRB, txBuffer, wsize);
-                    copyAndConvert(
-                        txBuffer, sizeof(SYSTEM_AUDIO_TYPE), rtpTx->channels,
-                        data, rtpTx->wordSizeBytes, rtpTx->channels,
-                        wsize / rtpTx->channels, false
+                PaUtil_GetRingBufferReadRegions(rtpTxRB, wsize,
+                    &buf1, &size1, &buf2, &size2);
+                swapAndConvert(
+                    buf1, sizeof(SYSTEM_AUDIO_TYPE),
+                    data, rtpTx->wordSizeBytes, size1
+                );
+                if (size2) {
+                    swapAndConvert(
+                        buf2, sizeof(SYSTEM_AUDIO_TYPE),
+                        (uint8_t *)data + size1 * rtpTx->wordSizeBytes,
+                        rtpTx->wordSizeBytes, size2
                     );
                 }
+                PaUtil_AdvanceRingBufferReadIndex(rtpTxRB, wsize);
                 rtpWriteSamples(rtpTx, wsize);
                 samplesIn = PaUtil_GetRingBufferReadAvailable(rtpTxRB);
             }
-        } else {
+        } else if (rtpTxRB) {
             PaUtil_FlushRingBuffer(rtpTxRB);
         }
         xSemaphoreGive((SemaphoreHandle_t)rtpTx->lock);
-        whatToDo = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+        whatToDo = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     }
 }
 
-static void rtp_audio_init_stream(RTP_STREAM *rs)
+static void rtp_audio_init_stream(RTP_STREAM *rs, APP_CONTEXT *context)
 {
     rs->lock =  (SemaphoreHandle_t)xSemaphoreCreateMutex();
     rs->port = 6970;
     rs->channels = 2;
     rs->wordSizeBytes = sizeof(int16_t);
+    rs->usrPtr = context;
+}
+
+static PaUtilRingBuffer **rtpRing(APP_CONTEXT *context, RTP_STREAM *rs)
+{
+    if (rs == &context->rtpTx) {
+        return(&context->rtpTxRB);
+    }
+    return(&context->rtpRxRB[rs - context->rtpRx]);
+}
+
+/*
+ * Allocates the stream's ring buffer and opens the stream.  Call with
+ * the stream's lock held after the stream is configured.
+ */
+bool rtp_audio_open(APP_CONTEXT *context, RTP_STREAM *rs)
+{
+    PaUtilRingBuffer **slot = rtpRing(context, rs);
+    PaUtilRingBuffer *rb;
+    bool ok;
+
+    if (rs->enabled) {
+        return(false);
+    }
+
+    audio_pool_ring_free(slot);
+    rb = audio_pool_ring_alloc(rs->channels, RTP_RING_LATENCY_MS);
+    if (rb == NULL) {
+        return(false);
+    }
+
+    /* The ISR wakes the Tx task, which otherwise blocks indefinitely */
+    if (rs == &context->rtpTx) {
+        audio_pool_ring_watermarks(rb, 0, NULL,
+            RTP_TX_WAKE_BLOCKS * rs->channels * SYSTEM_BLOCK_SIZE,
+            rtpTxHighWatermark, context);
+    }
+    *slot = rb;
+
+    ok = openRtpStream(rs);
+    if (!ok) {
+        audio_pool_ring_free(slot);
+    }
+
+    return(ok);
+}
+
+/* Closes the stream and returns its ring buffer to the audio pool */
+void rtp_audio_close(APP_CONTEXT *context, RTP_STREAM *rs)
+{
+    closeRtpStream(rs);
+    audio_pool_ring_free(rtpRing(context, rs));
 }
 
 void rtp_audio_init(APP_CONTEXT *context)
 {
-    uint32_t dataSize;
-
-    /* Allocate and configure the rtp rx ring buffer.
-     * The ring buffer unit of measure is in SYSTEM_AUDIO_TYPE sized
-     * words
-     */
-    context->rtpRxRB =
-        (PaUtilRingBuffer *)umm_malloc(sizeof(PaUtilRingBuffer));
-    assert(context->rtpRxRB);
-    dataSize = roundUpPow2(RTP_RING_BUF_SAMPLES);
-    context->rtpRxRBData = umm_calloc(dataSize, sizeof(SYSTEM_AUDIO_TYPE));
-    assert(context->rtpRxRBData);
-    PaUtil_InitializeRingBuffer(context->rtpRxRB,
-        sizeof(SYSTEM_AUDIO_TYPE), dataSize, context->rtpRxRBData);
-
-    /* Allocate and configure the rtp tx ring buffer.
-     * The ring buffer unit of measure is in SYSTEM_AUDIO_TYPE sized
-     * words
-     */
-    context->rtpTxRB =
-        (PaUtilRingBuffer *)umm_malloc(sizeof(PaUtilRingBuffer));
-    assert(context->rtpTxRB);
-    dataSize = roundUpPow2(RTP_RING_BUF_SAMPLES);
-    context->rtpTxRBData = umm_calloc(dataSize, sizeof(SYSTEM_AUDIO_TYPE));
-    assert(context->rtpTxRBData);
-    PaUtil_InitializeRingBuffer(context->rtpTxRB,
-        sizeof(SYSTEM_AUDIO_TYPE), dataSize, context->rtpTxRBData);
-
-    rtp_audio_init_stream(&context->rtpRx);
-    rtp_audio_init_stream(&context->rtpTx);
-
-    xTaskCreate(rtpRxTask, "RtpRxTask", RTP_TASK_STACK_SIZE,
-        context, RTP_TASK_PRIORITY, &context->rtpRxTaskHandle );
+    unsigned i;
+
+    /* Ring buffers are allocated from the audio pool on open */
+    for (i = 0; i < RTP_RX_STREAMS; i++) {
+        context->rtpRxRB[i] = NULL;
+    }
+    context->rtpTxRB = NULL;
+
+    for (i = 0; i < RTP_RX_STREAMS; i++) {
+        rtp_audio_init_stream(&context->rtpRx[i], context);
+        context->rtpRx[i].rxCallback = rtpRxAudio;
+    }
+    rtp_audio_init_stream(&context->rtpTx, context);
+
     xTaskCreate(rtpTxTask, "RtpTxTask", RTP_TASK_STACK_SIZE,
         context, RTP_TASK_PRIORITY, &context->rtpTxTaskHandle );
 
 }
 
 /* Transfers RTP Tx audio (ISR context) */
-int xferRtpTxAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
+int xferRtpTxAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd,
     unsigned *numChannels)
 {
     unsigned samplesIn;
@@ -193,7 +253,6 @@ int xferRtpTxAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
     RTP_STREAM *rtpTx = &context->rtpTx;
     PaUtilRingBuffer *rtpTxRB = context->rtpTxRB;
     CLOCK_DOMAIN myCd;
-    BaseType_t wake;
 
     static bool first = true;
 
@@ -203,7 +262,8 @@ int xferRtpTxAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
     }
     clock_domain_set_active(context, myCd, CLOCK_DOMAIN_BITM_RTP_TX);
 
-    if (!rtpTx->enabled) {
+    *audio = audio_pool_ring_block(rtpTxRB);
+    if (!rtpTx->enabled || (*audio == NULL)) {
         *numChannels = 0;
         first = true;
         return(1);
@@ -214,55 +274,67 @@ int xferRtpTxAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
 
     if ((samplesIn == 0) || (samplesOut == 0)) {
          *numChannels = 0;
+        audio_pool_ring_update(rtpTxRB);
         return(1);
     }
 
     if (samplesIn <= samplesOut) {
         if (!first) {
             PaUtil_WriteRingBuffer(
-                rtpTxRB, audio, rtpTx->channels * SYSTEM_BLOCK_SIZE
+                rtpTxRB, *audio, rtpTx->channels * SYSTEM_BLOCK_SIZE
             );
         }
     } else {
         rtpTxOverflow++;
+        TRACE_LOG1(TRACE_ID_RTP_TX_OVERFLOW, samplesOut);
     }
 
-    memset(audio, 0, samplesIn * sizeof(SYSTEM_AUDIO_TYPE));
+    memset(*audio, 0, samplesIn * sizeof(SYSTEM_AUDIO_TYPE));
     *numChannels = rtpTx->channels;
     first = false;
 
-    if (samplesOut < (RTP_RING_BUF_SAMPLES / 2)) {
-        xTaskNotifyFromISR(context->rtpTxTaskHandle,
-            RTP_TASK_AUDIO_TX_MORE_DATA, eSetValueWithoutOverwrite, &wake
-        );
-        portYIELD_FROM_ISR(wake);
-    }
+    audio_pool_ring_update(rtpTxRB);
 
     return(1);
 }
 
-/* Transfers RTP Rx audio (ISR context) */
-int xferRtpRxAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
-    unsigned *numChannels)
+/* Transfers RTP Rx audio for stream 'idx' (ISR context) */
+int xferRtpRxAudio(APP_CONTEXT *context, unsigned idx, void **audio,
+    CLOCK_DOMAIN cd, unsigned *numChannels)
 {
     unsigned samplesIn;
     unsigned samplesOut;
-    RTP_STREAM *rtpRx = &context->rtpRx;
-    PaUtilRingBuffer *rtpRxRB = context->rtpRxRB;
+    RTP_STREAM *rtpRx = &context->rtpRx[idx];
+    PaUtilRingBuffer *rtpRxRB = context->rtpRxRB[idx];
+    unsigned mask = rtpRxClockDomainMasks[idx];
     CLOCK_DOMAIN myCd;
 
-    myCd = clock_domain_get(context, CLOCK_DOMAIN_BITM_RTP_RX);
+    myCd = clock_domain_get(context, mask);
     if (myCd != cd) {
         return(0);
     }
-    clock_domain_set_active(context, myCd, CLOCK_DOMAIN_BITM_RTP_RX);
+    clock_domain_set_active(context, myCd, mask);
 
-    if (!rtpRx->enabled || rtpRx->preRoll) {
+    *audio = audio_pool_ring_block(rtpRxRB);
+    if (*audio == NULL) {
         *numChannels = 0;
         return(1);
     }
 
     samplesIn = PaUtil_GetRingBufferReadAvailable(rtpRxRB);
+
+    /* Drain stale audio from the consumer side while stopped */
+    if (!rtpRx->enabled) {
+        PaUtil_AdvanceRingBufferReadIndex(rtpRxRB, samplesIn);
+        *numChannels = 0;
+        return(1);
+    }
+
+    if (rtpRx->preRoll) {
+        *numChannels = 0;
+        return(1);
+    }
+
     samplesOut = rtpRx->channels * SYSTEM_BLOCK_SIZE;
 
     if ((samplesIn == 0) || (samplesOut == 0)) {
@@ -272,12 +344,13 @@ int xferRtpRxAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
 
     if (samplesIn >= samplesOut) {
         PaUtil_ReadRingBuffer(
-            rtpRxRB, audio, samplesOut
+            rtpRxRB, *audio, samplesOut
         );
         *numChannels = rtpRx->channels;
     } else {
         rtpRx->preRoll = true;
-        rtpRxUnderflow++;
+        rtpRxUnderflow[idx]++;
+        TRACE_LOG2(TRACE_ID_RTP_RX_UNDERFLOW, idx, samplesIn);
         *numChannels = 0;
     }
 
@@ -14,13 +14,20 @@
 
 #include "context.h"
 #include "ipc.h"
+#include "rtp_stream.h"
 
 void rtp_audio_init(APP_CONTEXT *context);
 
-int xferRtpRxAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
-    unsigned *numChannels);
+bool rtp_audio_open(APP_CONTEXT *context, RTP_STREAM *rs);
+void rtp_audio_close(APP_CONTEXT *context, RTP_STREAM *rs);
+
+int xferRtpRxAudio(APP_CONTEXT *context, unsigned idx, void **audio,
+    CLOCK_DOMAIN cd, unsigned *numChannels);
+
+STREAM_ID rtpRxStreamID(unsigned idx);
+unsigned rtpRxClockDomainMask(unsigned idx);
 
-int xferRtpTxAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
+int xferRtpTxAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd,
     unsigned *numChannels);
 
 #endif
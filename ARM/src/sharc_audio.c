@@ -10,18 +10,38 @@
  */
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 
 #include "context.h"
 #include "clock_domain.h"
 #include "sharc_audio.h"
+#include "clocks.h"
+#include "util.h"
 #include "sae.h"
+#include "sae_lock.h"
+#include "trace_log.h"
+#include "sharc_sched.h"
+#include "wav_file.h"
+
+#define SHARC_SYNC_TIMEOUT_TICKS \
+    ((uint32_t)(((uint64_t)SHARC_SYNC_TIMEOUT_US * CGU_TS_CLK) / 1000000))
+
+/* Output ping/pong index, shared with sharcProcessAudio() */
+static int sharc0OutPP = 0;
+static int sharc1OutPP = 0;
+
+#if SHARC_IPC_BLOCK
+/* Buffers queued for the next IPC_TYPE_BLOCK message, by IPC stream */
+static IPC_MSG_AUDIO_DESC sharcDesc[IPC_STREAM_ID_MAX];
+static int sharcLinkPP = 0;
+#endif
 
 /*
  *  Send audio messages by IPC to the SHARC.  Add a ref to the message
  *  to keep the message from being deallocated on the SHARC after
  *  processing.
  */
-void sendMsg(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *msg, int core)
+bool sendMsg(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *msg, int core)
 {
     SAE_RESULT result;
 
@@ -30,15 +50,28 @@ void sendMsg(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *msg, int core)
     if (result != SAE_RESULT_OK) {
         sae_unRefMsgBuffer(saeContext, msg);
     }
+
+    return(result == SAE_RESULT_OK);
 }
 
+/*
+ *  Returns the buffer the ARM works on this block and hands the SHARC
+ *  the other one.  With 'sync' the SHARC gets this block's buffer
+ *  instead, for input routed into before the SHARC runs.  In block
+ *  mode the SHARC's buffer is queued for sharcProcessAudio() rather
+ *  than sent on its own.
+ */
 void *xferSharcAudio(APP_CONTEXT *context, CLOCK_DOMAIN cd, uint32_t cdMask,
-    int core, SAE_MSG_BUFFER *sharcMsg[], void *sharcAudio[], int *pp)
+    int core, SAE_MSG_BUFFER *sharcMsg[], void *sharcAudio[], int *pp,
+    unsigned channels, bool sync)
 {
     CLOCK_DOMAIN myCd;
     SAE_MSG_BUFFER *msg;
     IPC_MSG *ipcMsg;
     void *audio;
+#if SHARC_IPC_BLOCK
+    IPC_MSG_AUDIO_DESC *desc;
+#endif
 
     myCd = clock_domain_get(context, cdMask);
     if (myCd != cd) {
@@ -52,8 +85,24 @@ void *xferSharcAudio(APP_CONTEXT *context, CLOCK_DOMAIN cd, uint32_t cdMask,
 
     msg = sharcMsg[*pp];
     ipcMsg = sae_getMsgBufferPayload(msg);
+#if SHARC_IPC_BLOCK
+    desc = &sharcDesc[ipcMsg->audio.streamID];
+    desc->streamID = ipcMsg->audio.streamID;
+    desc->clockDomain = myCd;
+    desc->wordSize = sizeof(SYSTEM_AUDIO_TYPE);
+    desc->format = SHARC_AUDIO_FLOAT ?
+        IPC_AUDIO_FORMAT_FLOAT : IPC_AUDIO_FORMAT_FIXED;
+    desc->numChannels = channels;
+    desc->numFrames = SYSTEM_BLOCK_SIZE;
+    desc->data = (uintptr_t)sharcAudio[*pp];
+#else
     ipcMsg->audio.clockDomain = myCd;
     sendMsg(context->saeContext, msg, core);
+#endif
+
+    if (sync) {
+        audio = sharcAudio[*pp];
+    }
 
     return(audio);
 }
@@ -65,7 +114,8 @@ void *xferSharc0InAudio(APP_CONTEXT *context, CLOCK_DOMAIN cd)
 
     audio = xferSharcAudio(
         context, cd, CLOCK_DOMAIN_BITM_SHARC0_IN, IPC_CORE_SHARC0,
-        context->sharc0MsgIn, context->sharc0AudioIn, &pp
+        context->sharc0MsgIn, context->sharc0AudioIn, &pp,
+        SHARC0_AUDIO_IN_CHANNELS, context->sharcSync
     );
 
     return(audio);
@@ -73,12 +123,12 @@ void *xferSharc0InAudio(APP_CONTEXT *context, CLOCK_DOMAIN cd)
 
 void *xferSharc0OutAudio(APP_CONTEXT *context, CLOCK_DOMAIN cd)
 {
-    static int pp = 0;
     void *audio;
 
     audio = xferSharcAudio(
         context, cd, CLOCK_DOMAIN_BITM_SHARC0_OUT, IPC_CORE_SHARC0,
-        context->sharc0MsgOut, context->sharc0AudioOut, &pp
+        context->sharc0MsgOut, context->sharc0AudioOut, &sharc0OutPP,
+        SHARC0_AUDIO_OUT_CHANNELS, false
     );
 
     return(audio);
@@ -92,7 +142,8 @@ void *xferSharc1InAudio(APP_CONTEXT *context, CLOCK_DOMAIN cd)
 
     audio = xferSharcAudio(
         context, cd, CLOCK_DOMAIN_BITM_SHARC1_IN, IPC_CORE_SHARC1,
-        context->sharc1MsgIn, context->sharc1AudioIn, &pp
+        context->sharc1MsgIn, context->sharc1AudioIn, &pp,
+        SHARC1_AUDIO_IN_CHANNELS, context->sharcSync
     );
 
     return(audio);
@@ -100,13 +151,367 @@ void *xferSharc1InAudio(APP_CONTEXT *context, CLOCK_DOMAIN cd)
 
 void *xferSharc1OutAudio(APP_CONTEXT *context, CLOCK_DOMAIN cd)
 {
-    static int pp = 0;
     void *audio;
 
     audio = xferSharcAudio(
         context, cd, CLOCK_DOMAIN_BITM_SHARC1_OUT, IPC_CORE_SHARC1,
-        context->sharc1MsgOut, context->sharc1AudioOut, &pp
+        context->sharc1MsgOut, context->sharc1AudioOut, &sharc1OutPP,
+        SHARC1_AUDIO_OUT_CHANNELS, false
     );
 
     return(audio);
 }
+
+/*
+ * Starts both SHARCs on the clock domain's block.  In zero added
+ * latency mode ('out' not NULL) this then spins, at most
+ * SHARC_SYNC_TIMEOUT_US, until both have finished and returns the
+ * output buffers they just wrote.  A SHARC that misses the deadline
+ * gets a NULL so the caller keeps the previous block's output, which
+ * is the pipelined behavior.
+ */
+void sharcProcessAudio(APP_CONTEXT *context, CLOCK_DOMAIN cd,
+    uint32_t timestamp, void *out[2])
+{
+    SAE_CONTEXT *sae = context->saeContext;
+    SAE_MSG_BUFFER *msg;
+    IPC_MSG *ipcMsg;
+    volatile uint8_t *done;
+    uint32_t plan = IPC_DSP_HOME_PLAN;
+    bool sent0, sent1;
+    bool done0, done1;
+    unsigned ready, node;
+    uint32_t start, waited;
+#if SHARC_IPC_BLOCK
+    IPC_MSG_AUDIO_DESC *desc;
+    bool chain;
+    unsigned i, n;
+#endif
+
+    if (out) {
+        out[0] = NULL; out[1] = NULL;
+    }
+
+#if SHARC_IPC_BLOCK
+    msg = sae_createMsgBuffer(sae,
+        IPC_MSG_BLOCK_SIZE(IPC_STREAM_ID_MAX), (void **)&ipcMsg);
+#else
+    msg = sae_createMsgBuffer(sae, sizeof(*ipcMsg), (void **)&ipcMsg);
+#endif
+    if (msg == NULL) {
+        if (out) {
+            context->sharcSyncMisses++;
+        }
+        return;
+    }
+
+#if SHARC_IPC_BLOCK
+    /* Every SHARC buffer queued for this clock domain */
+    ipcMsg->type = IPC_TYPE_BLOCK;
+    ipcMsg->block.clockDomain = cd;
+    ipcMsg->block.timestamp = timestamp;
+    for (i = 0, n = 0; i < IPC_STREAM_ID_MAX; i++) {
+        if (sharcDesc[i].data && (sharcDesc[i].clockDomain == cd)) {
+            ipcMsg->block.stream[n++] = sharcDesc[i];
+            sharcDesc[i].data = 0;
+        }
+    }
+
+    /*
+     * Chained, SHARC0 hands the block on to SHARC1 through the link.
+     * Alternate link buffers so a late SHARC1 never reads a half
+     * written block.
+     */
+    chain = context->sharcChain;
+    if (chain) {
+        sharcLinkPP = sharcLinkPP ? 0 : 1;
+        desc = &ipcMsg->block.stream[n++];
+        desc->streamID = IPC_STREAMID_SHARC_LINK;
+        desc->clockDomain = cd;
+        desc->wordSize = sizeof(SYSTEM_AUDIO_TYPE);
+        desc->format = SHARC_AUDIO_FLOAT ?
+            IPC_AUDIO_FORMAT_FLOAT : IPC_AUDIO_FORMAT_FIXED;
+        desc->numChannels = SHARC_LINK_CHANNELS;
+        desc->numFrames = SYSTEM_BLOCK_SIZE;
+        desc->data = (uintptr_t)context->sharcLinkAudio[sharcLinkPP];
+    }
+    ipcMsg->block.numStreams = n;
+
+    /* A chained block has to run SHARC0's node before SHARC1's */
+    if (!chain) {
+        plan = sharc_sched_plan(&context->sharcSched);
+    }
+    ipcMsg->block.plan = plan;
+    done = ipcMsg->block.done;
+#else
+    ipcMsg->type = IPC_TYPE_PROCESS_AUDIO;
+    ipcMsg->process.clockDomain = cd;
+    ipcMsg->process.timestamp = timestamp;
+    done = ipcMsg->process.done;
+#endif
+    done[0] = 0;
+    done[1] = 0;
+    sent0 = sendMsg(sae, msg, IPC_CORE_SHARC0);
+#if SHARC_IPC_BLOCK
+    sent1 = chain ? sent0 : sendMsg(sae, msg, IPC_CORE_SHARC1);
+#else
+    sent1 = sendMsg(sae, msg, IPC_CORE_SHARC1);
+#endif
+
+    /* Our reference keeps the done flags valid while we poll them */
+    if (out) {
+        start = getTimeStamp();
+        do {
+            done0 = !sent0 || done[IPC_PROCESS_DONE_IDX(IPC_CORE_SHARC0)];
+            done1 = !sent1 || done[IPC_PROCESS_DONE_IDX(IPC_CORE_SHARC1)];
+            waited = getTimeStamp() - start;
+        } while (!(done0 && done1) && (waited < SHARC_SYNC_TIMEOUT_TICKS));
+
+        context->sharcSyncBlocks++;
+        if (waited > context->sharcSyncWaitPeak) {
+            context->sharcSyncWaitPeak = waited;
+        }
+        /* A node's output is ready once every core with its jobs is */
+        ready = ((sent0 && done0) ? 1 : 0) | ((sent1 && done1) ? 2 : 0);
+        for (node = 0; node < IPC_DSP_NODES; node++) {
+            if ((sharc_sched_cores(plan, node) & ~ready) == 0) {
+                out[node] = (node == 0) ?
+                    context->sharc0AudioOut[sharc0OutPP] :
+                    context->sharc1AudioOut[sharc1OutPP];
+            }
+        }
+        if (!out[0] || !out[1]) {
+            context->sharcSyncMisses++;
+            TRACE_LOG2(TRACE_ID_SHARC_SYNC_MISS, cd, waited);
+        }
+    }
+
+    sae_unRefMsgBuffer(sae, msg);
+}
+
+/* Frames per read while loading an impulse response */
+#define SHARC_CONV_READ_FRAMES  (256)
+
+/* De-interleaves the next 'taps' frames of 'wf' into 'ir' as float */
+static bool sharcConvRead(WAV_FILE *wf, float *ir, unsigned channels,
+    unsigned taps)
+{
+    int32_t *raw, *dec;
+    unsigned done, frames, frame, ch;
+    size_t samples;
+    bool ok = true;
+
+    raw = malloc(SHARC_CONV_READ_FRAMES * wf->channels * sizeof(int32_t));
+    dec = malloc(SHARC_CONV_READ_FRAMES * wf->channels * sizeof(int32_t));
+    if (!raw || !dec) {
+        free(raw); free(dec);
+        return(false);
+    }
+
+    for (done = 0; ok && (done < taps); done += frames) {
+        frames = taps - done;
+        if (frames > SHARC_CONV_READ_FRAMES) {
+            frames = SHARC_CONV_READ_FRAMES;
+        }
+        samples = frames * wf->channels;
+        ok = (readWave(wf, raw, samples) == samples);
+        if (ok) {
+            decodeWave(wf, raw, dec, samples);
+            for (frame = 0; frame < frames; frame++) {
+                for (ch = 0; ch < channels; ch++) {
+                    ir[ch * taps + done + frame] =
+                        (float)dec[frame * wf->channels + ch] *
+                        (1.0f / 2147483648.0f);
+                }
+            }
+        }
+    }
+
+    free(raw); free(dec);
+
+    return(ok);
+}
+
+/* Longest wait for a SHARC to transform one response piece */
+#define SHARC_CONV_TIMEOUT_MS   (1000)
+
+/*
+ * Sends one response piece and waits for the SHARC to finish with it.
+ * Our reference keeps 'done' valid while we poll it.
+ */
+static bool sharcConvSend(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *msgBuffer,
+    IPC_MSG *msg, unsigned node)
+{
+    TickType_t start;
+
+    msg->conv.done = IPC_CONV_PENDING;
+    if (!sendMsg(saeContext, msgBuffer,
+            node ? IPC_CORE_SHARC1 : IPC_CORE_SHARC0)) {
+        /* Never delivered, nothing else holds it */
+        msg->conv.done = IPC_CONV_REJECTED;
+        return(false);
+    }
+
+    start = xTaskGetTickCount();
+    while (msg->conv.done == IPC_CONV_PENDING) {
+        if ((xTaskGetTickCount() - start) >=
+                pdMS_TO_TICKS(SHARC_CONV_TIMEOUT_MS)) {
+            return(false);
+        }
+        vTaskDelay(1);
+    }
+
+    return(msg->conv.done == IPC_CONV_LOADED);
+}
+
+/*
+ * Loads the impulse responses in 'fname' on 'node's convolver, one per
+ * channel up to IPC_CONV_CHANNELS and IPC_CONV_TAPS long.  NULL turns
+ * it off.  The node is held on its home SHARC while it convolves.
+ *
+ * The responses go IPC_CONV_CHUNK_TAPS at a time through a single small
+ * message, each piece waiting for the SHARC to transform the last.
+ * Task context only.
+ */
+bool sharcConvLoad(APP_CONTEXT *context, unsigned node, const char *fname)
+{
+    SAE_CONTEXT *saeContext = context->saeContext;
+    SAE_MSG_BUFFER *msgBuffer;
+    WAV_FILE *wf = NULL;
+    unsigned channels = 0;
+    unsigned taps = 0;
+    unsigned offset = 0;
+    unsigned count;
+    IPC_MSG *msg;
+    bool ok = true;
+    bool sent = false;
+
+    if (node >= IPC_DSP_NODES) {
+        return(false);
+    }
+
+    if (fname) {
+        wf = calloc(1, sizeof(*wf));
+        if (wf == NULL) {
+            return(false);
+        }
+        wf->fname = (char *)fname;
+        wf->isSrc = true;
+        if (!openWave(wf)) {
+            free(wf);
+            return(false);
+        }
+        channels = (wf->channels < IPC_CONV_CHANNELS) ?
+            wf->channels : IPC_CONV_CHANNELS;
+        taps = wf->dataSize / wf->channels;
+        if (taps > IPC_CONV_TAPS) {
+            taps = IPC_CONV_TAPS;
+        }
+    }
+
+    msgBuffer = sae_createMsgBuffer(saeContext,
+        IPC_MSG_CONV_SIZE(channels, IPC_CONV_CHUNK_TAPS), (void **)&msg);
+    if (msgBuffer) {
+        msg->type = IPC_TYPE_CONV;
+        msg->conv.node = node;
+        msg->conv.channels = channels;
+        msg->conv.taps = taps;
+    } else {
+        ok = false;
+    }
+
+    /* Held home before the SHARC starts convolving */
+    if (ok && taps) {
+        sharc_sched_pin(&context->sharcSched, node, true);
+    }
+
+    /* An empty piece turns it off */
+    while (ok && (!sent || (offset < taps))) {
+        count = taps - offset;
+        if (count > IPC_CONV_CHUNK_TAPS) {
+            count = IPC_CONV_CHUNK_TAPS;
+        }
+        msg->conv.offset = offset;
+        msg->conv.count = count;
+        if (wf) {
+            ok = sharcConvRead(wf, msg->conv.ir, channels, count);
+        }
+        if (ok) {
+            ok = sharcConvSend(saeContext, msgBuffer, msg, node);
+            sent = true;
+        }
+        offset += count;
+    }
+
+    if (wf) {
+        closeWave(wf);
+        free(wf);
+    }
+
+    /* Released once the SHARC has stopped convolving */
+    if (ok && !taps) {
+        sharc_sched_pin(&context->sharcSched, node, false);
+    }
+
+    /*
+     * A SHARC that never answered may still transform the piece later,
+     * so the message is left referenced rather than freed under it.
+     */
+    if (msgBuffer && (!sent || (msg->conv.done != IPC_CONV_PENDING))) {
+        sae_unRefMsgBuffer(saeContext, msgBuffer);
+    }
+
+    return(ok);
+}
+
+/* FFT queue lease hooks on the shared IPC_MSG_FFT_LEASE */
+static bool sharcFftTake(void *usr, bool *lost)
+{
+    IPC_MSG_FFT_LEASE *lease = usr;
+
+    if (!sae_lock(&lease->lock)) {
+        return(false);
+    }
+    *lost = (lease->owner != IPC_CORE_ARM);
+    lease->owner = IPC_CORE_ARM;
+
+    return(true);
+}
+
+static void sharcFftGive(void *usr)
+{
+    IPC_MSG_FFT_LEASE *lease = usr;
+
+    sae_unlock(&lease->lock);
+}
+
+/*
+ * Shares the FFT accelerator with SHARC0's convolver.  Creates the
+ * lease in shared L2 and sends it to SHARC0, 'lease' then takes it for
+ * the ARM's FFT queue.  The message is never freed.  Returns false if
+ * SHARC0 isn't there, the accelerator is then the ARM's alone.
+ */
+bool sharcFftLease(APP_CONTEXT *context, FFT_QUEUE_LEASE *lease)
+{
+    SAE_CONTEXT *saeContext = context->saeContext;
+    SAE_MSG_BUFFER *msgBuffer;
+    IPC_MSG *msg;
+
+    msgBuffer = sae_createMsgBuffer(saeContext, sizeof(*msg), (void **)&msg);
+    if (msgBuffer == NULL) {
+        return(false);
+    }
+    msg->type = IPC_TYPE_FFT_LEASE;
+    msg->fftLease.lock = SAE_SHARC_ARM_IPC_UNLOCKED;
+    msg->fftLease.owner = IPC_CORE_ARM;
+    if (!sendMsg(saeContext, msgBuffer, IPC_CORE_SHARC0)) {
+        sae_unRefMsgBuffer(saeContext, msgBuffer);
+        return(false);
+    }
+
+    lease->take = sharcFftTake;
+    lease->give = sharcFftGive;
+    lease->usr = &msg->fftLease;
+
+    return(true);
+}
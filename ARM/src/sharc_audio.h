@@ -12,11 +12,12 @@
 #define _sharc_audio_h
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "context.h"
 #include "sae.h"
 
-void sendMsg(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *msg, int core);
+bool sendMsg(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *msg, int core);
 
 void *xferSharc0InAudio(APP_CONTEXT *context, CLOCK_DOMAIN cd);
 void *xferSharc0OutAudio(APP_CONTEXT *context, CLOCK_DOMAIN cd);
@@ -24,4 +25,11 @@ void *xferSharc0OutAudio(APP_CONTEXT *context, CLOCK_DOMAIN cd);
 void *xferSharc1InAudio(APP_CONTEXT *context, CLOCK_DOMAIN cd);
 void *xferSharc1OutAudio(APP_CONTEXT *context, CLOCK_DOMAIN cd);
 
+void sharcProcessAudio(APP_CONTEXT *context, CLOCK_DOMAIN cd,
+    uint32_t timestamp, void *out[2]);
+
+bool sharcConvLoad(APP_CONTEXT *context, unsigned node, const char *fname);
+
+bool sharcFftLease(APP_CONTEXT *context, FFT_QUEUE_LEASE *lease);
+
 #endif
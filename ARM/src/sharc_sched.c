@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "sharc_sched.h"
+
+/* A new plan must cut the worst core load by this much to be taken */
+#ifndef SHARC_SCHED_HYSTERESIS_PCT
+#define SHARC_SCHED_HYSTERESIS_PCT  (10)
+#endif
+
+/* A core over this share of its budget is rebalanced regardless */
+#ifndef SHARC_SCHED_BUDGET_PCT
+#define SHARC_SCHED_BUDGET_PCT      (90)
+#endif
+
+static unsigned homeCore(unsigned job)
+{
+    return((IPC_DSP_HOME_PLAN >> job) & 1);
+}
+
+void sharc_sched_init(SHARC_SCHED *s, uint32_t budget)
+{
+    memset(s, 0, sizeof(*s));
+    s->budget = budget;
+    s->plan = IPC_DSP_HOME_PLAN;
+}
+
+void sharc_sched_enable(SHARC_SCHED *s, bool enable)
+{
+    s->enabled = enable;
+    if (!enable) {
+        s->plan = IPC_DSP_HOME_PLAN;
+    }
+    sharc_sched_cost(s, s->plan, s->coreCycles);
+}
+
+void sharc_sched_pin(SHARC_SCHED *s, unsigned node, bool pin)
+{
+    if (pin) {
+        s->pinned |= IPC_DSP_NODE_MASK(node);
+    } else {
+        s->pinned &= ~IPC_DSP_NODE_MASK(node);
+    }
+    s->plan = (s->plan & ~s->pinned) | (IPC_DSP_HOME_PLAN & s->pinned);
+    sharc_sched_cost(s, s->plan, s->coreCycles);
+}
+
+void sharc_sched_cycles(SHARC_SCHED *s, const uint32_t *jobCycles)
+{
+    unsigned job;
+
+    for (job = 0; job < IPC_DSP_JOBS; job++) {
+        if (jobCycles[job]) {
+            s->jobCycles[job] = jobCycles[job];
+        }
+    }
+}
+
+uint32_t sharc_sched_cost(SHARC_SCHED *s, uint32_t plan, uint32_t load[2])
+{
+    uint32_t l[2] = { 0, 0 };
+    unsigned job;
+
+    for (job = 0; job < IPC_DSP_JOBS; job++) {
+        l[(plan >> job) & 1] += s->jobCycles[job];
+    }
+    if (load) {
+        load[0] = l[0]; load[1] = l[1];
+    }
+
+    return((l[0] > l[1]) ? l[0] : l[1]);
+}
+
+bool sharc_sched_balance(SHARC_SCHED *s)
+{
+    uint8_t order[IPC_DSP_JOBS];
+    uint32_t load[2] = { 0, 0 };
+    uint32_t plan = 0;
+    uint32_t cur, next, over;
+    unsigned i, j, job, core;
+    uint8_t t;
+
+    if (!s->enabled) {
+        return(false);
+    }
+
+    /* Longest job first, stable so equal jobs keep their order */
+    for (i = 0; i < IPC_DSP_JOBS; i++) {
+        order[i] = i;
+    }
+    for (i = 1; i < IPC_DSP_JOBS; i++) {
+        for (j = i; j > 0; j--) {
+            if (s->jobCycles[order[j]] <= s->jobCycles[order[j-1]]) {
+                break;
+            }
+            t = order[j]; order[j] = order[j-1]; order[j-1] = t;
+        }
+    }
+
+    /* Pinned jobs first, they have no choice */
+    for (job = 0; job < IPC_DSP_JOBS; job++) {
+        if (s->pinned & (1u << job)) {
+            core = homeCore(job);
+            load[core] += s->jobCycles[job];
+            plan |= (uint32_t)core << job;
+        }
+    }
+
+    /* Each onto the lighter core, the home core when even */
+    for (i = 0; i < IPC_DSP_JOBS; i++) {
+        job = order[i];
+        if (s->pinned & (1u << job)) {
+            continue;
+        }
+        if (load[0] == load[1]) {
+            core = homeCore(job);
+        } else {
+            core = (load[0] < load[1]) ? 0 : 1;
+        }
+        load[core] += s->jobCycles[job];
+        plan |= (uint32_t)core << job;
+    }
+
+    cur = sharc_sched_cost(s, s->plan, s->coreCycles);
+    next = (load[0] > load[1]) ? load[0] : load[1];
+    over = (uint32_t)(((uint64_t)s->budget * SHARC_SCHED_BUDGET_PCT) / 100);
+
+    if ((plan == s->plan) || (next >= cur)) {
+        return(false);
+    }
+    if ((uint64_t)(cur - next) * 100 <=
+        (uint64_t)cur * SHARC_SCHED_HYSTERESIS_PCT) {
+        if (cur <= over) {
+            return(false);
+        }
+    }
+
+    s->plan = plan;
+    s->coreCycles[0] = load[0];
+    s->coreCycles[1] = load[1];
+    s->rebalances++;
+
+    return(true);
+}
+
+uint32_t sharc_sched_plan(SHARC_SCHED *s)
+{
+    return(s->enabled ? s->plan : IPC_DSP_HOME_PLAN);
+}
+
+unsigned sharc_sched_cores(uint32_t plan, unsigned node)
+{
+    uint32_t jobs = plan & IPC_DSP_NODE_MASK(node);
+    unsigned cores = 0;
+
+    if (jobs != IPC_DSP_NODE_MASK(node)) {
+        cores |= 1;
+    }
+    if (jobs) {
+        cores |= 2;
+    }
+
+    return(cores);
+}
@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _sharc_sched_h
+#define _sharc_sched_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ipc.h"
+
+/*
+ * DSP job scheduler for the two SHARCs.
+ *
+ * Each DSP job (see IPC_DSP_JOBS in ipc.h) has a cost in cycles, taken
+ * from the IPC_MSG_CYCLES reports of whichever core last ran it.  After
+ * each report the scheduler works out the plan that gives the smallest
+ * worst-case core load, longest job first onto the lighter core with
+ * ties going to the job's home core.  The new plan is only taken if it
+ * beats the current one by more than the hysteresis, or if a core is
+ * over its budget, so the plan doesn't flap on measurement noise.
+ *
+ * Pinned jobs always run on their home core, for nodes with state
+ * that lives in that core's memory.
+ *
+ * The plan is a single word so the audio ISR always sees a whole plan.
+ */
+typedef struct SHARC_SCHED {
+    uint32_t jobCycles[IPC_DSP_JOBS];
+    uint32_t coreCycles[2];        /* Predicted, under 'plan' */
+    uint32_t budget;               /* Cycles per block per core */
+    volatile uint32_t plan;
+    uint32_t pinned;               /* Jobs held on their home core */
+    uint32_t rebalances;
+    volatile bool enabled;
+} SHARC_SCHED;
+
+void sharc_sched_init(SHARC_SCHED *s, uint32_t budget);
+
+/* Enables dynamic plans, disabled goes back to the home plan */
+void sharc_sched_enable(SHARC_SCHED *s, bool enable);
+
+/* Holds or releases every job of 'node' on its home core */
+void sharc_sched_pin(SHARC_SCHED *s, unsigned node, bool pin);
+
+/* Takes a core's IPC_MSG_CYCLES job costs, 0 is 'not run here' */
+void sharc_sched_cycles(SHARC_SCHED *s, const uint32_t *jobCycles);
+
+/* Recomputes the plan, returns true if it changed */
+bool sharc_sched_balance(SHARC_SCHED *s);
+
+/* Plan for the next block */
+uint32_t sharc_sched_plan(SHARC_SCHED *s);
+
+/* Bit 0 SHARC0, bit 1 SHARC1, set for each core with jobs of 'node' */
+unsigned sharc_sched_cores(uint32_t plan, unsigned node);
+
+/* Worst-case cost of 'plan', core loads in 'load' if not NULL */
+uint32_t sharc_sched_cost(SHARC_SCHED *s, uint32_t plan, uint32_t load[2]);
+
+#endif
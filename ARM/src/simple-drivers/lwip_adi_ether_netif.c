@@ -14,6 +14,8 @@
 #include <stdbool.h>
 #include <machine/endian.h>
 
+#include <runtime/cache/adi_cache.h>
+
 #include "lwip/opt.h"
 #include "lwip/def.h"
 #include "lwip/mem.h"
@@ -132,6 +134,8 @@ adi_ether_netif_reset_tx_buff(ADI_ETHER_BUFFER *txBuff)
 #ifdef ADI_ETHER_SUPPORT_AV
     txBuff->nChannel = 0;
 #endif
+    txBuff->pFrags = NULL;
+    txBuff->nFrags = 0;
     txBuff->pNext = NULL;
 }
 
@@ -154,11 +158,40 @@ adi_ether_netif_init_tx(adi_ether_netif *adi_ether)
 }
 
 /*
- * Queue a frame received from ptp or lwIP for transmit.
+ * Returns the number of bytes at the end of 'q' that can be sent in
+ * place.  The part before the first cache line boundary is copied so
+ * only whole lines of pbuf memory are handed to the DMA.
+ */
+static uint16_t
+adi_ether_netif_tx_in_place(struct pbuf *q, uint16_t skip)
+{
+    uintptr_t start, end;
+
+    if (PBUF_NEEDS_COPY(q) || (skip >= q->len)) {
+        return(0);
+    }
+
+    start = (uintptr_t)q->payload + skip;
+    start = (start + ADI_CACHE_LINE_LENGTH - 1) &
+        ~(uintptr_t)(ADI_CACHE_LINE_LENGTH - 1);
+    end = (uintptr_t)q->payload + q->len;
+
+    if ((start >= end) || ((end - start) < ADI_ETHER_TX_MIN_FRAG)) {
+        return(0);
+    }
+
+    return((uint16_t)(end - start));
+}
+
+/*
+ * Queue a frame received from ptp or lwIP for transmit.  With
+ * 'zeroCopy' the frame is sent scatter-gather straight from the pbuf
+ * chain, which is referenced until the driver returns the Tx buffer.
  * WARNING: This function assumes ETH_PAD_SIZE is 2
  */
 static err_t
-adi_ether_netif_tx_frame(struct netif *netif, struct pbuf *p, bool ptpCB)
+adi_ether_netif_tx_frame(struct netif *netif, struct pbuf *p, bool ptpCB,
+    bool zeroCopy)
 {
     adi_ether_netif *adi_ether = netif->state;
     uint16_t len;
@@ -167,6 +200,12 @@ adi_ether_netif_tx_frame(struct netif *netif, struct pbuf *p, bool ptpCB)
     ADI_ETHER_BUFFER *txBuff;
     ADI_ETHER_RESULT etherResult;
     uint16_t txPktNext;
+    ADI_ETHER_FRAG *frags;
+    ADI_ETHER_FRAG *copyFrag;
+    uint16_t nFrags;
+    uint16_t headLen;
+    uint16_t inPlace;
+    uint16_t copy;
 
     /* Make sure to never exceed the TX buffer pool */
     txPktNext = adi_ether->txPktHead + 1;
@@ -180,12 +219,48 @@ adi_ether_netif_tx_frame(struct netif *netif, struct pbuf *p, bool ptpCB)
 
     /* Grab the next TX buffer */
     txBuff = &adi_ether->txBuff[adi_ether->txPktHead];
+    frags = adi_ether->txFrags[adi_ether->txPktHead];
 
-    /* Insert the lwIP payload into the frame */
+    /* Insert the lwIP payload into the frame.  Copied data always goes
+     * into the Tx buffer in order, either extending the head segment,
+     * the current copy fragment or starting a new one after a fragment
+     * that is sent in place.  Two fragment slots are kept free for an
+     * in place fragment and the copy that may follow it.
+     */
     out = (uint8_t *)txBuff->Data;
+    nFrags = 0;
+    headLen = p->tot_len;
+    copyFrag = NULL;
     for (q = p; q != NULL; q = q->next) {
-        memcpy(out, q->payload, q->len);
-        out += q->len;
+        inPlace = 0;
+        if (zeroCopy && ((nFrags + 2) <= ADI_ETHER_TX_MAX_FRAGS)) {
+            inPlace = adi_ether_netif_tx_in_place(q,
+                (q == p) ? (ETH_PAD_SIZE + SIZEOF_ETH_HDR) : 0);
+        }
+        copy = q->len - inPlace;
+        if (copy) {
+            if ((nFrags > 0) && (copyFrag == NULL)) {
+                copyFrag = &frags[nFrags++];
+                copyFrag->Data = out;
+                copyFrag->Length = 0;
+            }
+            memcpy(out, q->payload, copy);
+            out += copy;
+            if (copyFrag) {
+                copyFrag->Length += copy;
+            }
+            adi_ether->txCopyBytes += copy;
+        }
+        if (inPlace) {
+            if (nFrags == 0) {
+                headLen = out - (uint8_t *)txBuff->Data;
+            }
+            frags[nFrags].Data = (uint8_t *)q->payload + copy;
+            frags[nFrags].Length = inPlace;
+            nFrags++;
+            copyFrag = NULL;
+            adi_ether->txZeroCopyBytes += inPlace;
+        }
     }
 
     /* Put the total length (including 2 bytes of padding which
@@ -197,7 +272,11 @@ adi_ether_netif_tx_frame(struct netif *netif, struct pbuf *p, bool ptpCB)
 
     /* Prepare the ADI_ETHER_BUFFER for transmission by the driver */
     adi_ether_netif_reset_tx_buff(txBuff);
-    txBuff->ElementCount = len;
+    txBuff->ElementCount = headLen;
+    if (nFrags) {
+        txBuff->pFrags = frags;
+        txBuff->nFrags = nFrags;
+    }
 
     /* Request a timestamp for PTP packets */
     if (ptpCB) {
@@ -207,11 +286,19 @@ adi_ether_netif_tx_frame(struct netif *netif, struct pbuf *p, bool ptpCB)
 
     /* Send it out if the link is up */
     if (adi_ether->linkUp) {
+        if (nFrags) {
+            pbuf_ref(p);
+            adi_ether->txPbuf[adi_ether->txPktHead] = p;
+        }
         etherResult = adi_ether_Write(adi_ether->hEthernet, txBuff);
         if (etherResult == ADI_ETHER_RESULT_SUCCESS) {
             adi_ether->txPktHead = txPktNext;
             LINK_STATS_INC(link.xmit);
         } else {
+            if (nFrags) {
+                adi_ether->txPbuf[adi_ether->txPktHead] = NULL;
+                pbuf_free(p);
+            }
             LINK_STATS_INC(link.drop);
         }
     } else {
@@ -232,7 +319,7 @@ adi_ether_netif_lwip_tx_frame(struct netif *netif, struct pbuf *p)
     err_t err;
 
     sys_mutex_lock(&adi_ether->writeLock);
-    err = adi_ether_netif_tx_frame(netif, p, false);
+    err = adi_ether_netif_tx_frame(netif, p, false, adi_ether->txZeroCopy);
     sys_mutex_unlock(&adi_ether->writeLock);
 
     return (err);
@@ -282,7 +369,7 @@ adi_ether_netif_ptp_tx_frame(struct netif *netif, uint8_t *srcMacAddr,
     p[0].tot_len = p[0].len + p[1].len +p[2].len + p[3].len + p[4].len;
 
     sys_mutex_lock(&adi_ether->writeLock);
-    err = adi_ether_netif_tx_frame(netif, p, txCallback);
+    err = adi_ether_netif_tx_frame(netif, p, txCallback, false);
     sys_mutex_unlock(&adi_ether->writeLock);
 
     return (err);
@@ -341,12 +428,169 @@ adi_ether_netif_1722_tx_frame(struct netif *netif, uint8_t *srcMacAddr,
     }
 
     sys_mutex_lock(&adi_ether->writeLock);
-    err = adi_ether_netif_tx_frame(netif, p, NULL);
+    err = adi_ether_netif_tx_frame(netif, p, false, false);
     sys_mutex_unlock(&adi_ether->writeLock);
 
     return(err);
 }
 
+/*
+ * Enables or disables scatter-gather transmit of lwIP frames.  When
+ * disabled every frame is copied into a Tx buffer.
+ */
+void
+adi_ether_netif_tx_zero_copy(struct netif *netif, bool enable)
+{
+    adi_ether_netif *adi_ether = netif->state;
+
+    sys_mutex_lock(&adi_ether->writeLock);
+    adi_ether->txZeroCopy = enable;
+    sys_mutex_unlock(&adi_ether->writeLock);
+}
+
+/*
+ * Reports the number of transmitted bytes sent in place from pbufs and
+ * copied into Tx buffers.
+ */
+void
+adi_ether_netif_tx_stats(struct netif *netif, uint32_t *zeroCopyBytes,
+    uint32_t *copyBytes, bool reset)
+{
+    adi_ether_netif *adi_ether = netif->state;
+
+    if (zeroCopyBytes) {
+        *zeroCopyBytes = adi_ether->txZeroCopyBytes;
+    }
+    if (copyBytes) {
+        *copyBytes = adi_ether->txCopyBytes;
+    }
+    if (reset) {
+        adi_ether->txZeroCopyBytes = 0;
+        adi_ether->txCopyBytes = 0;
+    }
+}
+
+/*
+ * Claim the next Tx buffer so a frame can be built in place in DMA
+ * memory.  Returns a pointer to the start of the Ethernet frame (just
+ * past the length field) or NULL if the Tx pool is exhausted.  The
+ * write lock is held until adi_ether_netif_raw_tx_send() is called.
+ */
+uint8_t *
+adi_ether_netif_raw_tx_get(struct netif *netif, void **handle)
+{
+    adi_ether_netif *adi_ether = netif->state;
+    uint16_t txPktNext;
+
+    sys_mutex_lock(&adi_ether->writeLock);
+
+    txPktNext = adi_ether->txPktHead + 1;
+    if (txPktNext == ADI_ETHER_NUM_TX_BUFFS) {
+        txPktNext = 0;
+    }
+    if (txPktNext == adi_ether->txPktTail) {
+        LINK_STATS_INC(link.drop);
+        sys_mutex_unlock(&adi_ether->writeLock);
+        return(NULL);
+    }
+
+    *handle = &adi_ether->txBuff[adi_ether->txPktHead];
+
+    return((uint8_t *)adi_ether->txBuff[adi_ether->txPktHead].Data +
+        sizeof(uint16_t));
+}
+
+/*
+ * Send a frame built by adi_ether_netif_raw_tx_get().  'len' excludes
+ * the length field.
+ */
+err_t
+adi_ether_netif_raw_tx_send(struct netif *netif, void *handle, uint16_t len)
+{
+    adi_ether_netif *adi_ether = netif->state;
+    ADI_ETHER_BUFFER *txBuff = (ADI_ETHER_BUFFER *)handle;
+    ADI_ETHER_RESULT etherResult;
+    uint16_t txPktNext;
+
+    txPktNext = adi_ether->txPktHead + 1;
+    if (txPktNext == ADI_ETHER_NUM_TX_BUFFS) {
+        txPktNext = 0;
+    }
+
+    len += sizeof(uint16_t);
+    *((uint16_t *)txBuff->Data) = len;
+
+    adi_ether_netif_reset_tx_buff(txBuff);
+    txBuff->ElementCount = len;
+
+    if (adi_ether->linkUp) {
+        etherResult = adi_ether_Write(adi_ether->hEthernet, txBuff);
+        if (etherResult == ADI_ETHER_RESULT_SUCCESS) {
+            adi_ether->txPktHead = txPktNext;
+            LINK_STATS_INC(link.xmit);
+        } else {
+            LINK_STATS_INC(link.drop);
+        }
+    } else {
+        LINK_STATS_INC(link.drop);
+    }
+
+    sys_mutex_unlock(&adi_ether->writeLock);
+
+    return(ERR_OK);
+}
+
+/*
+ * Start the EMAC PTP clock from SCLK.  Rx timestamps are captured for
+ * 802.1AS (layer 2 PTPv2) event messages only, so those frames are
+ * handed to the ptp callback and everything else is unaffected.
+ */
+err_t
+adi_ether_netif_ptp_start(struct netif *netif, uint32_t clkFreq)
+{
+    adi_ether_netif *adi_ether = netif->state;
+    ADI_ETHER_GEMAC_PTP_CONFIG ptpConfig;
+    ADI_ETHER_RESULT etherResult;
+
+    memset(&ptpConfig, 0, sizeof(ptpConfig));
+    ptpConfig.eClkSrc = ADI_ETHER_GEMAC_PTP_CLK_SRC_SCLK;
+    ptpConfig.nClkFreq = clkFreq;
+    ptpConfig.nPTPClkFreq = clkFreq / 2;
+    ptpConfig.RxPktFilter =
+        ADI_ETHER_GEMAC_PKT_TYPE_PTP_SYNC |
+        ADI_ETHER_GEMAC_PKT_TYPE_PTP_PDELAY_REQ |
+        ADI_ETHER_GEMAC_PKT_TYPE_PTP_PDELAY_RESP |
+        ADI_ETHER_GEMAC_PKT_TYPE_PTP_OVER_ETHERNET_FRAME |
+        ADI_ETHER_GEMAC_PKT_TYPE_PTP_V2;
+
+    etherResult = adi_ether_ptp_Config(adi_ether->hEthernet, &ptpConfig, NULL);
+    if (etherResult == ADI_ETHER_RESULT_SUCCESS) {
+        etherResult = adi_ether_ptp_Enable(adi_ether->hEthernet, true);
+    }
+
+    return((etherResult == ADI_ETHER_RESULT_SUCCESS) ? ERR_OK : ERR_IF);
+}
+
+/* Read the current EMAC PTP time, safe from ISR context */
+err_t
+adi_ether_netif_ptp_time(struct netif *netif, uint32_t *second,
+    uint32_t *nanoSecond)
+{
+    adi_ether_netif *adi_ether = netif->state;
+    ADI_ETHER_TIME now;
+    ADI_ETHER_RESULT etherResult;
+
+    etherResult = adi_ether_ptp_GetCurrentTime(adi_ether->hEthernet, &now);
+    if (etherResult != ADI_ETHER_RESULT_SUCCESS) {
+        return(ERR_IF);
+    }
+
+    *second = now.LSecond;
+    *nanoSecond = now.NanoSecond;
+
+    return(ERR_OK);
+}
+
 /*
  * Receive a frame into lwIP.
  * WARNING: This function assumes ETH_PAD_SIZE is 2
@@ -403,6 +647,7 @@ adi_ether_netif_ptp_frame(struct adi_ether_netif *adi_ether, ADI_ETHER_BUFFER *p
 {
     uint16_t len;
     uint8_t *in;
+    uint32_t second, nanoSecond;
 
     /* Get the length from the first 2 bytes of the frame */
     in = (uint8_t *)pktBuffer->Data;
@@ -411,10 +656,19 @@ adi_ether_netif_ptp_frame(struct adi_ether_netif *adi_ether, ADI_ETHER_BUFFER *p
     /* Skip the length field */
     in += sizeof(uint16_t);
 
+    /* General (untimestamped) messages report a zero time */
+    if ((pktType == ADI_ETHER_PKT_TYPE_RX) &&
+        !(pktBuffer->Status & ADI_ETHER_BUFFER_STATUS_TIMESTAMP_AVAIL)) {
+        second = 0;
+        nanoSecond = 0;
+    } else {
+        second = pktBuffer->TimeStamp.LSecond;
+        nanoSecond = pktBuffer->TimeStamp.NanoSecond;
+    }
+
     /* Call the callback */
     if (adi_ether->ptpPktCb) {
-        adi_ether->ptpPktCb(adi_ether, in, len, pktType,
-            pktBuffer->TimeStamp.LSecond, pktBuffer->TimeStamp.NanoSecond);
+        adi_ether->ptpPktCb(adi_ether, in, len, pktType, second, nanoSecond);
     }
 
     /* Return receive pktBuffers to the driver */
@@ -439,8 +693,10 @@ static bool isP1722(ADI_ETHER_BUFFER *pktBuffer)
     /* Examine the Ethernet header */
     ethhdr = (struct eth_hdr *)pktBuffer->Data;
 
-    /* Identify and process 1722 AAF frames */
-    if (ethhdr->type == __htons(ETHTYPE_VLAN)) {
+    /* Identify and process tagged and untagged 1722 AAF frames */
+    if (ethhdr->type == __htons(ETHTYPE_AVBTP)) {
+        is1722 = true;
+    } else if (ethhdr->type == __htons(ETHTYPE_VLAN)) {
         vlan = (struct eth_vlan_hdr *)((uint8_t *)pktBuffer->Data + SIZEOF_ETH_HDR);
         if (vlan->tpid == __htons(ETHTYPE_AVBTP)) {
             is1722 = true;
@@ -450,6 +706,20 @@ static bool isP1722(ADI_ETHER_BUFFER *pktBuffer)
     return(is1722);
 }
 
+/*
+ * Check if a frame is an untagged PTP frame.  Only event messages are
+ * timestamped by the EMAC, this catches the general messages.
+ */
+#define ETHTYPE_PTP     0x88f7
+static bool isPtp(ADI_ETHER_BUFFER *pktBuffer)
+{
+    struct eth_hdr *ethhdr;
+
+    ethhdr = (struct eth_hdr *)pktBuffer->Data;
+
+    return(ethhdr->type == __htons(ETHTYPE_PTP));
+}
+
 /* This function returns a 1722 Rx frame to the driver */
 void
 adi_ether_netif_p1722_free(struct adi_ether_netif *adi_ether, void *p)
@@ -478,9 +748,11 @@ adi_ether_netif_p1722_frame(struct adi_ether_netif *adi_ether, ADI_ETHER_BUFFER
     in = (uint8_t *)pktBuffer->Data;
     len = *((uint16_t *)in);
 
-    /* Call the callback */
+    /* Call the callback, it must return the buffer when done */
     if (adi_ether->p1722PktCb) {
         adi_ether->p1722PktCb(adi_ether, in, len, pktBuffer);
+    } else {
+        adi_ether_netif_p1722_free(adi_ether, pktBuffer);
     }
 }
 
@@ -517,6 +789,8 @@ adi_ether_netif_worker(void *pvParameters)
                     pktBuffer->pNext = NULL;
                     if (pktBuffer->Status & ADI_ETHER_BUFFER_STATUS_TIMESTAMP_AVAIL) {
                         adi_ether_netif_ptp_frame(adi_ether, pktBuffer, ADI_ETHER_PKT_TYPE_RX);
+                    } else if (adi_ether->ptpPktCb && isPtp(pktBuffer)) {
+                        adi_ether_netif_ptp_frame(adi_ether, pktBuffer, ADI_ETHER_PKT_TYPE_RX);
                     } else if (isP1722(pktBuffer)) {
                         adi_ether_netif_p1722_frame(adi_ether, pktBuffer);
                     } else {
@@ -535,6 +809,10 @@ adi_ether_netif_worker(void *pvParameters)
                     if (pktBuffer->CallbackParameter) {
                         adi_ether_netif_ptp_frame(adi_ether, pktBuffer, ADI_ETHER_PKT_TYPE_TX);
                     }
+                    if (adi_ether->txPbuf[adi_ether->txPktTail]) {
+                        pbuf_free(adi_ether->txPbuf[adi_ether->txPktTail]);
+                        adi_ether->txPbuf[adi_ether->txPktTail] = NULL;
+                    }
                     adi_ether->txPktTail++;
                     if (adi_ether->txPktTail == ADI_ETHER_NUM_TX_BUFFS) {
                         adi_ether->txPktTail = 0;
@@ -763,6 +1041,8 @@ adi_ether_netif_new(void *usrPtr)
     ADI_ETHER_MEMSET(adi_ether->txBuff, 0, sizeof(adi_ether->txBuff));
     ADI_ETHER_MEMSET(adi_ether->rxPktData, 0, sizeof(adi_ether->rxPktData));
     ADI_ETHER_MEMSET(adi_ether->txPktData, 0, sizeof(adi_ether->txPktData));
+    ADI_ETHER_MEMSET(adi_ether->txPbuf, 0, sizeof(adi_ether->txPbuf));
+    adi_ether->txZeroCopy = true;
 
     /* Set up the EMAC driver DMA descriptor memory */
     adi_ether->etherMemTable.BaseMemLen = 0;
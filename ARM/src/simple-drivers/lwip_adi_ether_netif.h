@@ -28,10 +28,20 @@
 
 #define ADI_ETHER_DMA_DESCRIPTOR_SIZE   (32)
 #define ADI_ETHER_NUM_RECV_DESC         (128)
-#define ADI_ETHER_NUM_XMIT_DESC         (64)
+#define ADI_ETHER_NUM_XMIT_DESC         (128)
 #define ADI_ETHER_NUM_TX_BUFFS          (64)
 #define ADI_ETHER_NUM_RX_BUFFS          (128)
 
+/*
+ * Scatter-gather transmit.  pbuf data at or beyond the first cache line
+ * boundary is sent in place from its own DMA descriptor, everything
+ * else (the Ethernet header, unaligned heads, short or volatile pbufs)
+ * is copied into the Tx buffer.  Runs shorter than ADI_ETHER_TX_MIN_FRAG
+ * are cheaper to copy than to describe.
+ */
+#define ADI_ETHER_TX_MAX_FRAGS          (8)
+#define ADI_ETHER_TX_MIN_FRAG           (128)
+
 #define ADI_ETHER_NUM_MBOX_EVENTS       (20)
 
 typedef enum ADI_ETHER_EMAC_PORT {
@@ -132,6 +142,13 @@ typedef struct adi_ether_netif {
     uint16_t txPktHead;
     uint16_t txPktTail;
 
+    /* Scatter-gather fragments and the pbufs they point into */
+    ADI_ETHER_FRAG txFrags[ADI_ETHER_NUM_TX_BUFFS][ADI_ETHER_TX_MAX_FRAGS];
+    struct pbuf *txPbuf[ADI_ETHER_NUM_TX_BUFFS];
+    bool txZeroCopy;
+    uint32_t txZeroCopyBytes;
+    uint32_t txCopyBytes;
+
     /* Worker thread */
     sys_thread_t worker;
     sys_mbox_t workerToDo;
@@ -184,4 +201,21 @@ adi_ether_netif_1722_tx_frame(struct netif *netif, uint8_t *srcMacAddr,
     uint8_t *dstMacAddr, uint16_t etherType, uint8_t *p1722, uint16_t p1722Len,
     uint8_t *audio, uint16_t audioLen);
 
+uint8_t *
+adi_ether_netif_raw_tx_get(struct netif *netif, void **handle);
+err_t
+adi_ether_netif_raw_tx_send(struct netif *netif, void *handle, uint16_t len);
+
+void
+adi_ether_netif_tx_zero_copy(struct netif *netif, bool enable);
+void
+adi_ether_netif_tx_stats(struct netif *netif, uint32_t *zeroCopyBytes,
+    uint32_t *copyBytes, bool reset);
+
+err_t
+adi_ether_netif_ptp_start(struct netif *netif, uint32_t clkFreq);
+err_t
+adi_ether_netif_ptp_time(struct netif *netif, uint32_t *second,
+    uint32_t *nanoSecond);
+
 #endif
@@ -175,7 +175,7 @@ uint32_t cpuLoadGetLoad(uint32_t *maxLoad, bool clearMax)
 
 uint32_t cpuLoadGetTimeStamp(void)
 {
-    return(getTime());
+    return(getTime ? getTime() : 0);
 }
 
 uint32_t cpuLoadCyclesToMicrosecond(uint32_t cycles)
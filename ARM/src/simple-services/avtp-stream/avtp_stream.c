@@ -0,0 +1,355 @@
+/**
+ * Copyright (c) 2022 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * IEEE 1722-2016 clause 7 (AAF) PCM streams.  Only the INT_16BIT and
+ * INT_32BIT formats are supported.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "avtp_stream_cfg.h"
+#include "avtp_stream.h"
+
+#ifndef AVTP_DEFAULT_TRANSIT_TIME
+#define AVTP_DEFAULT_TRANSIT_TIME  (2000000)
+#endif
+
+#ifndef AVTP_DEFAULT_FRAMES_PER_PKT
+#define AVTP_DEFAULT_FRAMES_PER_PKT (8)
+#endif
+
+#define ETHTYPE_VLAN           (0x8100)
+#define ETH_HDR_SIZE           (14)
+#define VLAN_HDR_SIZE          (4)
+#define ETH_MAX_PAYLOAD        (1500)
+
+#define AAF_SUBTYPE            (0x02)
+#define AAF_HDR_SIZE           (24)
+#define AAF_MAX_PAYLOAD        (ETH_MAX_PAYLOAD - AAF_HDR_SIZE)
+
+#define AAF_SV                 (0x80)
+#define AAF_TV                 (0x01)
+#define AAF_SP                 (0x10)
+
+#define AAF_FORMAT_INT_32BIT   (0x02)
+#define AAF_FORMAT_INT_16BIT   (0x04)
+
+/* AAF header field offsets */
+#define AAF_SUBTYPE_OFFSET     (0)
+#define AAF_FLAGS_OFFSET       (1)
+#define AAF_SEQ_OFFSET         (2)
+#define AAF_STREAM_ID_OFFSET   (4)
+#define AAF_TIMESTAMP_OFFSET   (12)
+#define AAF_FORMAT_OFFSET      (16)
+#define AAF_NSR_OFFSET         (17)
+#define AAF_CHANNELS_OFFSET    (18)
+#define AAF_BIT_DEPTH_OFFSET   (19)
+#define AAF_LENGTH_OFFSET      (20)
+#define AAF_EVT_OFFSET         (22)
+
+#define NS_PER_SEC             (1000000000ULL)
+
+/* Nominal sample rate codes (Table 14) */
+static const struct {
+    unsigned sampleRate;
+    uint8_t nsr;
+} AAF_NSR[] = {
+    {  8000, 0x01 }, {  16000, 0x02 }, {  32000, 0x03 },
+    { 44100, 0x04 }, {  48000, 0x05 }, {  88200, 0x06 },
+    { 96000, 0x07 }, { 176400, 0x08 }, { 192000, 0x09 },
+    { 24000, 0x0A }
+};
+
+static int aafNsr(unsigned sampleRate)
+{
+    int i;
+
+    for (i = 0; i < sizeof(AAF_NSR) / sizeof(AAF_NSR[0]); i++) {
+        if (AAF_NSR[i].sampleRate == sampleRate) {
+            return(AAF_NSR[i].nsr);
+        }
+    }
+
+    return(-1);
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v >> 8; p[1] = v;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+static void put64(uint8_t *p, uint64_t v)
+{
+    put32(p, v >> 32); put32(p + 4, v);
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return(((uint16_t)p[0] << 8) | p[1]);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | p[3]);
+}
+
+static uint64_t get64(const uint8_t *p)
+{
+    return(((uint64_t)get32(p) << 32) | get32(p + 4));
+}
+
+static unsigned avtpHdrOffset(AVTP_STREAM *as)
+{
+    return(ETH_HDR_SIZE + (as->vlanID ? VLAN_HDR_SIZE : 0));
+}
+
+bool avtpOpenStream(AVTP_STREAM *as)
+{
+    unsigned frameBytes;
+
+    if (as->enabled) {
+        return(false);
+    }
+
+    if ((as->wordSizeBytes != 2) && (as->wordSizeBytes != 4)) {
+        return(false);
+    }
+
+    if (aafNsr(as->sampleRate) < 0) {
+        return(false);
+    }
+
+    frameBytes = as->channels * as->wordSizeBytes;
+    if ((frameBytes == 0) || (frameBytes > AAF_MAX_PAYLOAD)) {
+        return(false);
+    }
+
+    if (as->framesPerPkt == 0) {
+        as->framesPerPkt = AVTP_DEFAULT_FRAMES_PER_PKT;
+    }
+    if (as->framesPerPkt * frameBytes > AAF_MAX_PAYLOAD) {
+        as->framesPerPkt = AAF_MAX_PAYLOAD / frameBytes;
+    }
+    if (as->transitTime == 0) {
+        as->transitTime = AVTP_DEFAULT_TRANSIT_TIME;
+    }
+
+    as->maxSamples = as->framesPerPkt * as->channels;
+    as->size = avtpHdrOffset(as) + AAF_HDR_SIZE +
+        as->maxSamples * as->wordSizeBytes;
+    as->frame = NULL;
+    as->frameHandle = NULL;
+    as->samples = 0;
+    as->ptValid = false;
+    as->sync = false;
+    as->rxPkts = 0;
+    as->rxSeqErrors = 0;
+    as->rxFmtErrors = 0;
+    as->preRoll = as->isRx;
+    as->enabled = true;
+
+    return(true);
+}
+
+void avtpCloseStream(AVTP_STREAM *as)
+{
+    uint8_t *hdr;
+
+    /* A claimed frame buffer must go back to the link, send it short */
+    if (as->frame) {
+        hdr = as->frame + avtpHdrOffset(as);
+        put16(hdr + AAF_LENGTH_OFFSET, as->samples * as->wordSizeBytes);
+        as->link.txSend(as->link.linkPtr, as->frameHandle,
+            as->size - (as->maxSamples - as->samples) * as->wordSizeBytes);
+        as->frame = NULL;
+    }
+    as->enabled = false;
+}
+
+/* Writes the Ethernet and constant AAF headers into a new frame */
+static void avtpInitFrame(AVTP_STREAM *as, uint8_t *frame)
+{
+    uint8_t *hdr;
+
+    memcpy(frame + 0, as->dstMac, 6);
+    memcpy(frame + 6, as->srcMac, 6);
+    if (as->vlanID) {
+        put16(frame + 12, ETHTYPE_VLAN);
+        put16(frame + 14, ((uint16_t)as->vlanPcp << 13) | (as->vlanID & 0x0FFF));
+        put16(frame + 16, AVTP_ETHTYPE);
+    } else {
+        put16(frame + 12, AVTP_ETHTYPE);
+    }
+
+    hdr = frame + avtpHdrOffset(as);
+    memset(hdr, 0, AAF_HDR_SIZE);
+    hdr[AAF_SUBTYPE_OFFSET] = AAF_SUBTYPE;
+    hdr[AAF_FLAGS_OFFSET] = AAF_SV | AAF_TV;
+    put64(hdr + AAF_STREAM_ID_OFFSET, as->streamID);
+    hdr[AAF_FORMAT_OFFSET] = (as->wordSizeBytes == 2) ?
+        AAF_FORMAT_INT_16BIT : AAF_FORMAT_INT_32BIT;
+    hdr[AAF_NSR_OFFSET] = (aafNsr(as->sampleRate) << 4) |
+        ((as->channels >> 8) & 0x03);
+    hdr[AAF_CHANNELS_OFFSET] = as->channels & 0xFF;
+    hdr[AAF_BIT_DEPTH_OFFSET] = as->wordSizeBytes * 8;
+    put16(hdr + AAF_LENGTH_OFFSET, as->maxSamples * as->wordSizeBytes);
+    hdr[AAF_EVT_OFFSET] = AAF_SP;
+}
+
+unsigned avtpWriteSamplesAvailable(AVTP_STREAM *as, void **data)
+{
+    if (as->frame == NULL) {
+        as->frame = as->link.txGet(as->link.linkPtr, &as->frameHandle);
+        if (as->frame == NULL) {
+            return(0);
+        }
+        avtpInitFrame(as, as->frame);
+        as->data = as->frame + avtpHdrOffset(as) + AAF_HDR_SIZE;
+        as->samples = 0;
+    }
+    if (data) {
+        *data = (void *)as->data;
+    }
+    return(as->maxSamples - as->samples);
+}
+
+/*
+ * Presentation time of the next packet.  The frame count is folded
+ * into the base every second so the 64-bit product can't overflow.
+ */
+static uint32_t avtpTxPresentationTime(AVTP_STREAM *as)
+{
+    uint32_t pt;
+
+    if (!as->ptValid) {
+        as->ptBase = as->link.now(as->link.linkPtr) + as->transitTime;
+        as->ptFrames = 0;
+        as->ptValid = true;
+    }
+
+    pt = as->ptBase +
+        (uint32_t)(((uint64_t)as->ptFrames * NS_PER_SEC) / as->sampleRate);
+
+    as->ptFrames += as->framesPerPkt;
+    if (as->ptFrames >= as->sampleRate) {
+        as->ptFrames -= as->sampleRate;
+        as->ptBase += (uint32_t)NS_PER_SEC;
+    }
+
+    return(pt);
+}
+
+unsigned avtpWriteSamples(AVTP_STREAM *as, unsigned samples)
+{
+    uint8_t *hdr;
+
+    as->samples += samples;
+    as->data += samples * as->wordSizeBytes;
+
+    if (as->samples == as->maxSamples) {
+        hdr = as->frame + avtpHdrOffset(as);
+        hdr[AAF_SEQ_OFFSET] = as->sequence;
+        put32(hdr + AAF_TIMESTAMP_OFFSET, avtpTxPresentationTime(as));
+        as->link.txSend(as->link.linkPtr, as->frameHandle, as->size);
+        as->frame = NULL;
+        as->samples = 0;
+        as->sequence++;
+    }
+
+    return(samples);
+}
+
+bool avtpRecvFrame(AVTP_STREAM *as, uint8_t *frame, unsigned len)
+{
+    uint8_t *hdr;
+    unsigned offset;
+    unsigned channels;
+    unsigned wordSizeBytes;
+    unsigned dataLen;
+    unsigned samples;
+    uint32_t pt;
+    uint8_t format;
+
+    if (!as->enabled || (len < ETH_HDR_SIZE + AAF_HDR_SIZE)) {
+        return(false);
+    }
+
+    /* Locate the AVTP header behind an optional VLAN tag */
+    offset = ETH_HDR_SIZE;
+    if (get16(frame + 12) == ETHTYPE_VLAN) {
+        if (get16(frame + 16) != AVTP_ETHTYPE) {
+            return(false);
+        }
+        offset += VLAN_HDR_SIZE;
+    } else if (get16(frame + 12) != AVTP_ETHTYPE) {
+        return(false);
+    }
+    if (len < offset + AAF_HDR_SIZE) {
+        return(false);
+    }
+    hdr = frame + offset;
+
+    /* Stream selection */
+    if ((hdr[AAF_SUBTYPE_OFFSET] != AAF_SUBTYPE) ||
+        !(hdr[AAF_FLAGS_OFFSET] & AAF_SV)) {
+        return(false);
+    }
+    if (as->streamID &&
+        (get64(hdr + AAF_STREAM_ID_OFFSET) != as->streamID)) {
+        return(false);
+    }
+
+    as->rxPkts++;
+
+    /* Format must match what the listener was opened with */
+    format = hdr[AAF_FORMAT_OFFSET];
+    wordSizeBytes = (format == AAF_FORMAT_INT_16BIT) ? 2 :
+        (format == AAF_FORMAT_INT_32BIT) ? 4 : 0;
+    channels = ((hdr[AAF_NSR_OFFSET] & 0x03) << 8) | hdr[AAF_CHANNELS_OFFSET];
+    dataLen = get16(hdr + AAF_LENGTH_OFFSET);
+    if ((wordSizeBytes != as->wordSizeBytes) ||
+        (channels != as->channels) ||
+        ((hdr[AAF_NSR_OFFSET] >> 4) != aafNsr(as->sampleRate)) ||
+        (offset + AAF_HDR_SIZE + dataLen > len)) {
+        as->rxFmtErrors++;
+        return(true);
+    }
+
+    /* Track sequence continuity */
+    if (as->sync && (hdr[AAF_SEQ_OFFSET] != as->sequence)) {
+        as->rxSeqErrors++;
+    }
+    as->sequence = hdr[AAF_SEQ_OFFSET] + 1;
+    as->sync = true;
+
+    /* Packets without a valid timestamp play as soon as possible */
+    if (hdr[AAF_FLAGS_OFFSET] & AAF_TV) {
+        pt = get32(hdr + AAF_TIMESTAMP_OFFSET);
+    } else {
+        pt = as->link.now ? as->link.now(as->link.linkPtr) : 0;
+    }
+
+    samples = (dataLen / (channels * wordSizeBytes)) * channels;
+    if (samples && as->rxCallback) {
+        as->rxCallback(as, hdr + AAF_HDR_SIZE, samples, pt, as->usrPtr);
+    }
+
+    return(true);
+}
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2022 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _avtp_stream_h
+#define _avtp_stream_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * IEEE 1722-2016 AVTP Audio Format (AAF) PCM talker/listener.  Frames
+ * are raw Ethernet (optionally VLAN tagged) and never touch lwIP.
+ */
+#define AVTP_ETHTYPE          (0x22F0)
+#define AVTP_MAX_FRAME_SIZE   (1518)
+
+struct AVTP_STREAM;
+
+/*
+ * Link layer used by a stream.  On the target this is the EMAC with
+ * frames built in place in the Tx DMA buffers.  A host test can supply
+ * a capture file instead.
+ *   txGet  - Returns a frame buffer of AVTP_MAX_FRAME_SIZE bytes and an
+ *            opaque handle for txSend(), or NULL if none are free.
+ *   txSend - Sends 'len' bytes of a buffer obtained from txGet().
+ *   now    - Current gPTP time in nanoseconds (lower 32 bits).
+ */
+typedef struct AVTP_LINK {
+    uint8_t *(*txGet)(void *linkPtr, void **handle);
+    int (*txSend)(void *linkPtr, void *handle, unsigned len);
+    uint32_t (*now)(void *linkPtr);
+    void *linkPtr;
+} AVTP_LINK;
+
+/*
+ * Rx payload callback with 'samples' whole frames of network order
+ * audio.  'presentationTime' is the gPTP time at which the first frame
+ * must be played.  'data' is only valid for the duration of the call.
+ */
+typedef void (*AVTP_RX_CALLBACK)(struct AVTP_STREAM *as, void *data,
+    unsigned samples, uint32_t presentationTime, void *usrPtr);
+
+typedef struct AVTP_STREAM {
+    bool enabled;
+    void *lock;
+    bool isRx;
+    unsigned channels;
+    unsigned wordSizeBytes;
+    unsigned sampleRate;
+    unsigned framesPerPkt;
+    uint64_t streamID;
+    uint8_t dstMac[6];
+    uint8_t srcMac[6];
+    uint16_t vlanID;
+    uint8_t vlanPcp;
+    uint32_t transitTime;
+    AVTP_LINK link;
+    uint8_t *frame;
+    void *frameHandle;
+    uint8_t *data;
+    unsigned samples;
+    unsigned maxSamples;
+    unsigned size;
+    uint8_t sequence;
+    bool ptValid;
+    uint32_t ptBase;
+    uint32_t ptFrames;
+    bool sync;
+    unsigned rxPkts;
+    unsigned rxSeqErrors;
+    unsigned rxFmtErrors;
+    bool preRoll;
+    AVTP_RX_CALLBACK rxCallback;
+    void *usrPtr;
+} AVTP_STREAM;
+
+/*
+ * A zero Rx 'streamID' accepts any AAF stream.  Tx presentation times
+ * are 'transitTime' ns after the link time the stream started at and
+ * advance with the number of frames sent.
+ */
+bool avtpOpenStream(AVTP_STREAM *as);
+void avtpCloseStream(AVTP_STREAM *as);
+
+/*
+ * Tx samples must be written in network byte order directly into the
+ * link's frame buffer.  A frame buffer is claimed by the first call to
+ * avtpWriteSamplesAvailable() and sent as soon as it is full so fill
+ * each packet without blocking.
+ */
+unsigned avtpWriteSamplesAvailable(AVTP_STREAM *as, void **data);
+unsigned avtpWriteSamples(AVTP_STREAM *as, unsigned samples);
+
+/*
+ * Offers a received Ethernet frame (starting at the destination MAC)
+ * to a listener.  Returns true if the frame belonged to the stream.
+ */
+bool avtpRecvFrame(AVTP_STREAM *as, uint8_t *frame, unsigned len);
+
+#endif
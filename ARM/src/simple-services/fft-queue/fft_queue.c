@@ -0,0 +1,570 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "fft_queue.h"
+
+void fft_queue_init(FFT_QUEUE *q, const FFT_QUEUE_BACKEND *be)
+{
+    memset(q, 0, sizeof(*q));
+    q->be = *be;
+    q->statsStart = FFT_QUEUE_TIMESTAMP();
+}
+
+/* Can 'job' share a batch started by 'first' */
+static bool batchable(const FFT_JOB *first, const FFT_JOB *job)
+{
+    return((job->type == first->type) && (job->npts == first->npts) &&
+        (job->scale == first->scale));
+}
+
+/*
+ * Takes the most urgent job and those that can ride along with it off
+ * the queue.  Called locked with something queued.
+ */
+static unsigned nextBatch(FFT_QUEUE *q, uint32_t now)
+{
+    FFT_JOB *job, *prev, *next;
+    unsigned p, n;
+
+    for (p = 0; q->head[p] == NULL; p++);
+
+    n = 0;
+    for (; (p < FFT_QUEUE_PRIORITIES) && (n < FFT_QUEUE_BATCH); p++) {
+        prev = NULL;
+        for (job = q->head[p]; job && (n < FFT_QUEUE_BATCH); job = next) {
+            next = job->next;
+            if ((n > 0) && !batchable(q->batch[0], job)) {
+                prev = job;
+                continue;
+            }
+            if (prev) {
+                prev->next = next;
+            } else {
+                q->head[p] = next;
+            }
+            if (q->tail[p] == job) {
+                q->tail[p] = prev;
+            }
+            job->next = NULL;
+            job->state = FFT_JOB_RUNNING;
+            job->started = now;
+            q->batch[n++] = job;
+            if (q->batch[0]->npts > FFT_QUEUE_BATCH_MAX_POINTS) {
+                break;
+            }
+        }
+        if (q->batch[0]->npts > FFT_QUEUE_BATCH_MAX_POINTS) {
+            break;
+        }
+    }
+
+    q->queued -= n;
+    q->batchLen = n;
+    q->batchDone = 0;
+    q->batchStart = now;
+    q->busy = true;
+    q->stats.batches++;
+    if (n > 1) {
+        q->stats.batched += n;
+    }
+
+    return(n);
+}
+
+/*
+ * Puts the owner at the priority of the most urgent task it's working
+ * for, never below the one it started at.  Called locked.
+ */
+static void ownerPriority(FFT_QUEUE *q)
+{
+    FFT_QUEUE_PRIORITY_T prio = q->basePriority;
+    FFT_JOB *job;
+    unsigned i;
+
+    if (q->owner == NULL) {
+        return;
+    }
+    for (i = q->batchDone; q->busy && (i < q->batchLen); i++) {
+        if (q->batch[i]->taskPriority > prio) {
+            prio = q->batch[i]->taskPriority;
+        }
+    }
+    for (i = 0; i < FFT_QUEUE_PRIORITIES; i++) {
+        for (job = q->head[i]; job; job = job->next) {
+            if (job->taskPriority > prio) {
+                prio = job->taskPriority;
+            }
+        }
+    }
+    if (prio != q->ownerPriority) {
+        q->ownerPriority = prio;
+        FFT_QUEUE_SET_PRIORITY(q->owner, prio);
+    }
+}
+
+bool fft_queue_submit(FFT_QUEUE *q, FFT_JOB *job)
+{
+    FFT_QUEUE_PRIORITY_T prio;
+    FFT_QUEUE_TASK owner;
+    unsigned p = job->priority;
+
+    if (p >= FFT_QUEUE_PRIORITIES) {
+        return(false);
+    }
+    prio = FFT_QUEUE_PRIORITY();
+
+    FFT_QUEUE_LOCK();
+    if ((job->state == FFT_JOB_QUEUED) || (job->state == FFT_JOB_RUNNING)) {
+        FFT_QUEUE_UNLOCK();
+        return(false);
+    }
+    job->state = FFT_JOB_QUEUED;
+    job->ok = false;
+    job->waiter = NULL;
+    job->taskPriority = prio;
+    job->submitted = FFT_QUEUE_TIMESTAMP();
+    job->next = NULL;
+    if (q->tail[p]) {
+        q->tail[p]->next = job;
+    } else {
+        q->head[p] = job;
+    }
+    q->tail[p] = job;
+    q->queued++;
+    if (q->queued > q->stats.queuedMax) {
+        q->stats.queuedMax = q->queued;
+    }
+    ownerPriority(q);
+    owner = q->owner;
+    FFT_QUEUE_UNLOCK();
+
+    if (owner) {
+        FFT_QUEUE_WAKE(owner);
+    }
+
+    return(true);
+}
+
+bool fft_queue_cancel(FFT_QUEUE *q, FFT_JOB *job)
+{
+    FFT_QUEUE_TASK waiter = NULL;
+    FFT_JOB *prev = NULL;
+    FFT_JOB *j;
+    unsigned p = job->priority;
+    bool ok = false;
+
+    FFT_QUEUE_LOCK();
+    if ((p < FFT_QUEUE_PRIORITIES) && (job->state == FFT_JOB_QUEUED)) {
+        for (j = q->head[p]; j && (j != job); j = j->next) {
+            prev = j;
+        }
+        if (j) {
+            if (prev) {
+                prev->next = job->next;
+            } else {
+                q->head[p] = job->next;
+            }
+            if (q->tail[p] == job) {
+                q->tail[p] = prev;
+            }
+            job->next = NULL;
+            job->state = FFT_JOB_IDLE;
+            waiter = job->waiter;
+            job->waiter = NULL;
+            q->queued--;
+            ownerPriority(q);
+            ok = true;
+        }
+    }
+    FFT_QUEUE_UNLOCK();
+
+    /* Anyone waiting on it gets it back unfinished */
+    if (waiter) {
+        FFT_QUEUE_WAKE(waiter);
+    }
+
+    return(ok);
+}
+
+void fft_queue_complete(FFT_QUEUE *q, bool ok)
+{
+    FFT_QUEUE_PRIO_STATS *ps;
+    FFT_QUEUE_TASK waiter;
+    uint32_t now, latency, wait;
+    FFT_JOB *job;
+
+    FFT_QUEUE_LOCK();
+    if (q->batchDone >= q->batchLen) {
+        FFT_QUEUE_UNLOCK();
+        return;
+    }
+    now = FFT_QUEUE_TIMESTAMP();
+    job = q->batch[q->batchDone++];
+    job->finished = now;
+    job->ok = ok;
+
+    latency = now - job->submitted;
+    wait = job->started - job->submitted;
+    ps = &q->stats.prio[job->priority];
+    ps->jobs++;
+    ps->latencySum += latency;
+    if (latency > ps->latencyMax) {
+        ps->latencyMax = latency;
+    }
+    if (wait > ps->waitMax) {
+        ps->waitMax = wait;
+    }
+    q->stats.jobs++;
+    if (!ok) {
+        q->stats.errors++;
+    }
+
+    if (q->batchDone == q->batchLen) {
+        q->stats.busy += now - q->batchStart;
+        q->busy = false;
+    }
+
+    /* The producer may resubmit from its callback */
+    job->state = FFT_JOB_DONE;
+    waiter = job->waiter;
+    job->waiter = NULL;
+    FFT_QUEUE_UNLOCK();
+
+    if (job->done) {
+        job->done(job, job->usr);
+    }
+    if (waiter) {
+        FFT_QUEUE_WAKE(waiter);
+    }
+}
+
+/*
+ * Starts batches until the backend is busy.  A backend completing
+ * inside 'start' just leaves the next batch to the loop.
+ */
+bool fft_queue_service(FFT_QUEUE *q)
+{
+    unsigned n;
+    bool busy;
+
+    if (q->be.poll) {
+        q->be.poll(q->be.usr);
+    }
+
+    FFT_QUEUE_LOCK();
+    while (!q->busy && q->queued) {
+        n = nextBatch(q, FFT_QUEUE_TIMESTAMP());
+        ownerPriority(q);
+        FFT_QUEUE_UNLOCK();
+        q->be.start(q->be.usr, q->batch, n);
+        FFT_QUEUE_LOCK();
+    }
+    ownerPriority(q);
+    busy = q->busy;
+    FFT_QUEUE_UNLOCK();
+
+    return(busy);
+}
+
+void fft_queue_backoff(FFT_QUEUE *q)
+{
+    q->backoff = true;
+}
+
+/*
+ * Sleeps while there's nothing to do, a submit wakes it.  Polls a
+ * running batch through, that's only as long as the accelerator takes
+ * to run it, and at the priority of the tasks waiting on it.  A backend
+ * held up by something slower gets a tick before the next poll.
+ */
+void fft_queue_run(FFT_QUEUE *q)
+{
+    FFT_QUEUE_LOCK();
+    q->owner = FFT_QUEUE_SELF();
+    q->basePriority = FFT_QUEUE_PRIORITY();
+    q->ownerPriority = q->basePriority;
+    FFT_QUEUE_UNLOCK();
+
+    while (1) {
+        if (!fft_queue_service(q)) {
+            FFT_QUEUE_SLEEP();
+        } else if (q->backoff) {
+            q->backoff = false;
+            FFT_QUEUE_BACKOFF();
+        } else {
+            FFT_QUEUE_IDLE();
+        }
+    }
+}
+
+/* Stale wake ups from an earlier job just go round again */
+bool fft_queue_wait(FFT_QUEUE *q, FFT_JOB *job)
+{
+    bool ok;
+
+    FFT_QUEUE_LOCK();
+    while ((job->state == FFT_JOB_QUEUED) || (job->state == FFT_JOB_RUNNING)) {
+        job->waiter = FFT_QUEUE_SELF();
+        FFT_QUEUE_UNLOCK();
+        FFT_QUEUE_SLEEP();
+        FFT_QUEUE_LOCK();
+    }
+    ok = job->ok;
+    FFT_QUEUE_UNLOCK();
+
+    return(ok);
+}
+
+void fft_queue_stats(FFT_QUEUE *q, FFT_QUEUE_STATS *stats, bool reset)
+{
+    uint32_t now;
+
+    FFT_QUEUE_LOCK();
+    now = FFT_QUEUE_TIMESTAMP();
+    q->stats.elapsed = now - q->statsStart;
+    *stats = q->stats;
+    if (reset) {
+        memset(&q->stats, 0, sizeof(q->stats));
+        q->statsStart = now;
+    }
+    FFT_QUEUE_UNLOCK();
+}
+
+#if defined(__ADSPSC589_FAMILY__) && defined(__ADSPARM__)
+
+#include <runtime/cache/adi_cache.h>
+
+/* 32-bit words in and out of a 'type' transform of 'npts' points */
+static void accelWords(FFT_JOB_TYPE type, unsigned npts,
+    uint32_t *inWords, uint32_t *outWords)
+{
+    switch (type) {
+        case FFT_JOB_RFFT:
+            *inWords = npts; *outWords = 2 * npts;
+            break;
+        case FFT_JOB_IRFFT:
+            *inWords = 2 * npts; *outWords = npts;
+            break;
+        case FFT_JOB_RFFT_MAG_SQ:
+            *inWords = npts; *outWords = npts / 2;
+            break;
+        default:
+            *inWords = 2 * npts; *outWords = 2 * npts;
+            break;
+    }
+}
+
+static bool accelPipe(FFT_QUEUE_ACCEL *a, const FFT_JOB *job)
+{
+    if (a->h && (a->type == job->type) && (a->npts == job->npts) &&
+        (a->scale == job->scale)) {
+        return(true);
+    }
+    if (a->h) {
+        adi_fft_Close(a->h);
+        a->h = NULL;
+    }
+    switch (job->type) {
+        case FFT_JOB_RFFT:
+            a->h = accel_rfft_small_pipe(&a->mem, job->scale, job->npts);
+            break;
+        case FFT_JOB_IRFFT:
+            a->h = accel_irfft_small_pipe(&a->mem, job->scale, job->npts);
+            break;
+        case FFT_JOB_CFFT:
+            a->h = accel_cfft_small_pipe(&a->mem, job->scale, job->npts);
+            break;
+        case FFT_JOB_IFFT:
+            a->h = accel_ifft_small_pipe(&a->mem, job->scale, job->npts);
+            break;
+        case FFT_JOB_RFFT_MAG_SQ:
+            a->h = accel_rfft_small_mag_sq_pipe(&a->mem, job->scale,
+                job->npts);
+            break;
+    }
+    a->type = job->type;
+    a->npts = job->npts;
+    a->scale = job->scale;
+    a->enabled = false;
+
+    return(a->h != NULL);
+}
+
+static void accelSubmit(FFT_QUEUE_ACCEL *a, FFT_JOB *job)
+{
+    uint32_t inWords, outWords;
+
+    accelWords(job->type, job->npts, &inWords, &outWords);
+
+    /* Input out to memory, no stale output lines left behind */
+    flush_data_buffer((void *)job->in,
+        (char *)job->in + inWords * sizeof(uint32_t), ADI_FLUSH_DATA_NOINV);
+    flush_data_buffer(job->out,
+        (char *)job->out + outWords * sizeof(uint32_t), ADI_FLUSH_DATA_INV);
+
+    adi_fft_SubmitRxBuffer(a->h, job->out, outWords);
+    adi_fft_SubmitTxBuffer(a->h, (void *)job->in, inWords);
+    if (!a->enabled) {
+        adi_fft_EnableRx(a->h, true);
+        adi_fft_EnableTx(a->h, true);
+        a->enabled = true;
+    }
+}
+
+static bool accelLarge(FFT_QUEUE_ACCEL *a, FFT_JOB *job)
+{
+    void *out = NULL;
+
+    /* The blocking calls set the accelerator up themselves */
+    if (a->h) {
+        adi_fft_Close(a->h);
+        a->h = NULL;
+    }
+    switch (job->type) {
+        case FFT_JOB_RFFT:
+            out = accel_rfft_large(job->in, job->out, job->twiddles,
+                job->twiddleStride, job->scale, job->npts);
+            break;
+        case FFT_JOB_IRFFT:
+            out = accel_irfft_large(job->in, job->out, job->temp,
+                job->twiddles, job->twiddleStride, job->scale, job->npts);
+            break;
+        case FFT_JOB_CFFT:
+            out = accel_cfft_large(job->in, job->out, job->twiddles,
+                job->twiddleStride, job->scale, job->npts);
+            break;
+        case FFT_JOB_IFFT:
+            out = accel_ifft_large(job->in, job->out, job->twiddles,
+                job->twiddleStride, job->scale, job->npts);
+            break;
+        case FFT_JOB_RFFT_MAG_SQ:
+            out = accel_rfft_large_mag_sq(job->in, job->out, job->temp,
+                job->twiddles, job->twiddleStride, job->scale, job->npts);
+            break;
+    }
+
+    return(out != NULL);
+}
+
+/*
+ * Takes the lease for the batch and starts its first small job, false
+ * if the other core has the accelerator.  Large jobs wait for a poll.
+ */
+static bool accelBegin(FFT_QUEUE_ACCEL *a)
+{
+    bool lost = false;
+
+    if (!a->held) {
+        if (a->lease.take && !a->lease.take(a->lease.usr, &lost)) {
+            return(false);
+        }
+        /* The other core's setup replaced our pipe */
+        if (lost && a->h) {
+            adi_fft_Close(a->h);
+            a->h = NULL;
+        }
+        a->held = true;
+        if (a->jobs[0]->npts <= MAX_POINTS_FOR_SMALL_FFT) {
+            if (accelPipe(a, a->jobs[0])) {
+                accelSubmit(a, a->jobs[0]);
+            }
+        }
+    }
+
+    return(true);
+}
+
+static void accelEnd(FFT_QUEUE_ACCEL *a)
+{
+    if (a->held && a->lease.give) {
+        a->lease.give(a->lease.usr);
+    }
+    a->held = false;
+}
+
+static void accelStart(void *usr, FFT_JOB *const *jobs, unsigned n)
+{
+    FFT_QUEUE_ACCEL *a = usr;
+
+    memcpy(a->jobs, jobs, n * sizeof(*jobs));
+    a->n = n;
+    a->next = 0;
+    if (!accelBegin(a)) {
+        fft_queue_backoff(a->q);
+    }
+}
+
+static void accelPoll(void *usr)
+{
+    FFT_QUEUE_ACCEL *a = usr;
+    FFT_JOB *job;
+    bool avail;
+    void *buf;
+
+    if (a->next >= a->n) {
+        return;
+    }
+    if (!accelBegin(a)) {
+        fft_queue_backoff(a->q);
+        return;
+    }
+
+    while (a->next < a->n) {
+        job = a->jobs[a->next];
+        if (job->npts > MAX_POINTS_FOR_SMALL_FFT) {
+            a->next++;
+            fft_queue_complete(a->q, accelLarge(a, job));
+            continue;
+        }
+        if (a->h == NULL) {
+            a->next++;
+            fft_queue_complete(a->q, false);
+            continue;
+        }
+        avail = false;
+        adi_fft_IsRxBufferAvailable(a->h, &avail);
+        if (!avail) {
+            break;
+        }
+        adi_fft_GetTxBuffer(a->h, &buf);
+        adi_fft_GetRxBuffer(a->h, &buf);
+        a->next++;
+        if (a->next < a->n) {
+            accelSubmit(a, a->jobs[a->next]);
+        }
+        fft_queue_complete(a->q, true);
+    }
+
+    /* Free for the other core between batches */
+    if (a->next >= a->n) {
+        accelEnd(a);
+    }
+}
+
+void fft_queue_accel_init(FFT_QUEUE_ACCEL *a, FFT_QUEUE *q)
+{
+    FFT_QUEUE_BACKEND be = { accelStart, accelPoll, a };
+
+    memset(a, 0, sizeof(*a));
+    a->q = q;
+    fft_queue_init(q, &be);
+}
+
+void fft_queue_accel_lease(FFT_QUEUE_ACCEL *a, const FFT_QUEUE_LEASE *lease)
+{
+    a->lease = *lease;
+}
+
+#endif
@@ -0,0 +1,235 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _fft_queue_h
+#define _fft_queue_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "adi_fft_wrapper.h"
+#include "fft_queue_cfg.h"
+
+/*
+ * FFT accelerator job queue.
+ *
+ * Producers fill in an FFT_JOB and submit it.  Jobs wait in one FIFO
+ * per priority and the most urgent waiting job starts as soon as the
+ * accelerator is free.  A running batch is never preempted.  Waiting
+ * jobs of the same type and size ride along with it, up to
+ * FFT_QUEUE_BATCH of them, so a run of small transforms sets up the
+ * accelerator once.
+ *
+ * One owner task, running fft_queue_run(), starts and finishes every
+ * job, so the backend is only ever driven from one place.  It sleeps
+ * while the queue is empty and polls a running batch through.  While
+ * it has work it runs at the priority of the most urgent task that
+ * submitted some, so a background transform never holds up tasks more
+ * urgent than the one that asked for it.  A finished job calls its
+ * callback, if it has one, from the owner.  fft_queue_wait() sleeps
+ * until the owner has finished one job.
+ *
+ * The transforms themselves are done by a backend, normally the
+ * accelerator one below.
+ */
+typedef enum FFT_QUEUE_PRIO {
+    FFT_QUEUE_PRIO_LIVE = 0,
+    FFT_QUEUE_PRIO_DISPLAY,
+    FFT_QUEUE_PRIO_BACKGROUND
+} FFT_QUEUE_PRIO;
+
+/* Transforms, each the same as the matching accel_*() wrapper call */
+typedef enum FFT_JOB_TYPE {
+    FFT_JOB_RFFT = 0,           /* float in, complex_float out */
+    FFT_JOB_IRFFT,              /* complex_float in, float out */
+    FFT_JOB_CFFT,               /* complex_float in and out */
+    FFT_JOB_IFFT,               /* complex_float in and out */
+    FFT_JOB_RFFT_MAG_SQ         /* float in, npts / 2 floats out */
+} FFT_JOB_TYPE;
+
+typedef enum FFT_JOB_STATE {
+    FFT_JOB_IDLE = 0,
+    FFT_JOB_QUEUED,
+    FFT_JOB_RUNNING,
+    FFT_JOB_DONE
+} FFT_JOB_STATE;
+
+typedef struct FFT_JOB FFT_JOB;
+
+typedef void (*FFT_JOB_CALLBACK)(FFT_JOB *job, void *usr);
+
+/*
+ * 'temp', 'twiddles' and 'twiddleStride' are only used by transforms
+ * over MAX_POINTS_FOR_SMALL_FFT points, as for accel_*_large().  'in'
+ * and 'out' must be cache line aligned for the accelerator's DMA.  The
+ * job belongs to the queue from submit until it is done.
+ */
+struct FFT_JOB {
+    FFT_JOB_TYPE type;
+    unsigned npts;
+    float scale;
+    const void *in;
+    void *out;
+    complex_float *temp;
+    const complex_float *twiddles;
+    int twiddleStride;
+    unsigned priority;
+    FFT_JOB_CALLBACK done;
+    void *usr;
+
+    /* Owned by the queue */
+    volatile FFT_JOB_STATE state;
+    bool ok;
+    FFT_QUEUE_TASK waiter;
+    FFT_QUEUE_PRIORITY_T taskPriority;  /* Of the submitting task */
+    uint32_t submitted;
+    uint32_t started;
+    uint32_t finished;
+    FFT_JOB *next;
+};
+
+/*
+ * Backend, only ever called by the owner.  'start' starts 'n' jobs of
+ * one type and size, in order, and must not block.  Each is then
+ * finished by fft_queue_complete() in the same order, from 'poll' or
+ * from 'start' itself.  A backend that can't go on for now, for the
+ * want of a lease, calls fft_queue_backoff() and is polled a tick later.
+ */
+typedef struct FFT_QUEUE_BACKEND {
+    void (*start)(void *usr, FFT_JOB *const *jobs, unsigned n);
+    void (*poll)(void *usr);
+    void *usr;
+} FFT_QUEUE_BACKEND;
+
+/*
+ * Lease on an accelerator shared with another core.  'take' returns
+ * false while the other core has it, and sets '*lost' when the other
+ * core has used it since, its setup replacing ours.  'give' hands it
+ * back.
+ */
+typedef struct FFT_QUEUE_LEASE {
+    bool (*take)(void *usr, bool *lost);
+    void (*give)(void *usr);
+    void *usr;
+} FFT_QUEUE_LEASE;
+
+/* Latencies are in FFT_QUEUE_TIMESTAMP() ticks */
+typedef struct FFT_QUEUE_PRIO_STATS {
+    uint32_t jobs;
+    uint64_t latencySum;        /* Submit to done */
+    uint32_t latencyMax;
+    uint32_t waitMax;           /* Submit to start */
+} FFT_QUEUE_PRIO_STATS;
+
+typedef struct FFT_QUEUE_STATS {
+    uint32_t jobs;
+    uint32_t batches;
+    uint32_t batched;           /* Jobs that shared a batch */
+    uint32_t errors;
+    uint32_t queuedMax;
+    uint64_t busy;              /* Ticks with a batch running */
+    uint32_t elapsed;           /* Ticks covered by these stats */
+    FFT_QUEUE_PRIO_STATS prio[FFT_QUEUE_PRIORITIES];
+} FFT_QUEUE_STATS;
+
+typedef struct FFT_QUEUE {
+    FFT_QUEUE_BACKEND be;
+    FFT_JOB *head[FFT_QUEUE_PRIORITIES];
+    FFT_JOB *tail[FFT_QUEUE_PRIORITIES];
+    unsigned queued;
+    FFT_JOB *batch[FFT_QUEUE_BATCH];
+    unsigned batchLen;
+    unsigned batchDone;
+    uint32_t batchStart;
+    bool busy;
+    FFT_QUEUE_TASK owner;
+    FFT_QUEUE_PRIORITY_T basePriority;
+    FFT_QUEUE_PRIORITY_T ownerPriority;
+    bool backoff;
+    uint32_t statsStart;
+    FFT_QUEUE_STATS stats;
+} FFT_QUEUE;
+
+void fft_queue_init(FFT_QUEUE *q, const FFT_QUEUE_BACKEND *be);
+
+/*
+ * Queues 'job'.  Returns false if it is already queued or running or
+ * its priority is out of range.
+ */
+bool fft_queue_submit(FFT_QUEUE *q, FFT_JOB *job);
+
+/* Takes back a job that hasn't started yet, false if too late */
+bool fft_queue_cancel(FFT_QUEUE *q, FFT_JOB *job);
+
+/* Backend only, finishes the oldest running job */
+void fft_queue_complete(FFT_QUEUE *q, bool ok);
+
+/* Backend only, the owner waits a tick before polling it again */
+void fft_queue_backoff(FFT_QUEUE *q);
+
+/*
+ * The owner task's loop, never returns.  Runs fft_queue_service()
+ * whenever there is work, FFT_QUEUE_IDLE() between polls of a running
+ * batch and FFT_QUEUE_BACKOFF() after a fft_queue_backoff().  The
+ * owner's priority when it starts is the least it runs at.
+ */
+void fft_queue_run(FFT_QUEUE *q);
+
+/*
+ * One pass of the owner, finishes what the backend has done and starts
+ * more.  Returns true while a batch is running.  Owner only.
+ */
+bool fft_queue_service(FFT_QUEUE *q);
+
+/*
+ * Sleeps until 'job' is done, returns whether it succeeded.  Not from
+ * the owner, nor a job callback.
+ */
+bool fft_queue_wait(FFT_QUEUE *q, FFT_JOB *job);
+
+/*
+ * Copies out the stats, and starts them over if 'reset'.  Utilization
+ * is 'busy' over 'elapsed'.
+ */
+void fft_queue_stats(FFT_QUEUE *q, FFT_QUEUE_STATS *stats, bool reset);
+
+#if defined(__ADSPSC589_FAMILY__) && defined(__ADSPARM__)
+/*
+ * FFT accelerator backend.  Small transforms run in the accelerator's
+ * continuous (pipe) mode while the core carries on, one job at a time,
+ * the pipe staying open across jobs and batches of the same type, size
+ * and scale.  Larger ones need the driver's descriptor chains so they
+ * run with the blocking accel_*_large() calls, in the owner.  With a
+ * lease each batch holds it from its first job to its last, a batch
+ * that can't get it backs off.
+ */
+typedef struct FFT_QUEUE_ACCEL {
+    FFT_QUEUE *q;
+    FFT_QUEUE_LEASE lease;
+    ADI_FFT_DEVICE_MEMORY mem;
+    ADI_FFT_HANDLE h;
+    FFT_JOB_TYPE type;
+    unsigned npts;
+    float scale;
+    FFT_JOB *jobs[FFT_QUEUE_BATCH];
+    unsigned n;
+    unsigned next;
+    bool enabled;
+    bool held;
+} FFT_QUEUE_ACCEL;
+
+void fft_queue_accel_init(FFT_QUEUE_ACCEL *a, FFT_QUEUE *q);
+
+/* Shares the accelerator through 'lease', set before any job runs */
+void fft_queue_accel_lease(FFT_QUEUE_ACCEL *a, const FFT_QUEUE_LEASE *lease);
+#endif
+
+#endif
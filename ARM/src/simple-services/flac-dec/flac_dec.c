@@ -0,0 +1,896 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Bitstream reference:
+ *   https://www.rfc-editor.org/rfc/rfc9639.html
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "flac_dec_cfg.h"
+#include "flac_dec.h"
+
+#ifndef FLAC_DEC_MAX_BLOCK_SIZE
+#define FLAC_DEC_MAX_BLOCK_SIZE   (4608)
+#endif
+
+#ifndef FLAC_DEC_MAX_CHANNELS
+#define FLAC_DEC_MAX_CHANNELS     (8)
+#endif
+
+#ifndef FLAC_DEC_IN_BUF_SIZE
+#define FLAC_DEC_IN_BUF_SIZE      (4 * 1024)
+#endif
+
+#ifndef FLAC_DEC_CHECK_CRC16
+#define FLAC_DEC_CHECK_CRC16      1
+#endif
+
+#ifndef FLAC_DEC_CALLOC
+#define FLAC_DEC_CALLOC calloc
+#endif
+
+#ifndef FLAC_DEC_FREE
+#define FLAC_DEC_FREE free
+#endif
+
+#define FLAC_MAGIC               (0x664C6143)    /* "fLaC" */
+#define FLAC_MAX_BPS             (24)
+#define FLAC_MAX_LPC_ORDER       (32)
+#define FLAC_MAX_HEADER          (16)
+
+/*
+ * Zeroed samples in front of each channel buffer so the vector LPC
+ * loop can read a whole number of taps behind the first warm-up sample.
+ */
+#define FLAC_GUARD               (4)
+
+/* Stereo decorrelation modes from the frame header */
+enum {
+    FLAC_CH_INDEPENDENT = 0,
+    FLAC_CH_LEFT_SIDE = 8,
+    FLAC_CH_RIGHT_SIDE = 9,
+    FLAC_CH_MID_SIDE = 10
+};
+
+/*
+ * MSB first bit reader.  'cache' holds 'bits' valid bits left aligned,
+ * the unused low bits are always zero.  A new input buffer is only
+ * fetched when a read needs more bits than are cached, so every cached
+ * byte belongs to the read that triggers the fetch.  That lets the
+ * frame CRC run over whole input buffers instead of byte by byte.
+ */
+typedef struct FLAC_BITS {
+    FLAC_DEC_READ read;
+    void *usr;
+    uint8_t *buf;
+    size_t pos;
+    size_t len;
+    uint32_t base;             /* Stream offset of buf[0] */
+    uint64_t cache;
+    unsigned bits;
+    bool eof;
+    bool error;
+    size_t crcPos;
+    uint16_t crc16;
+} FLAC_BITS;
+
+typedef struct FLAC_FRAME {
+    unsigned blockSize;
+    unsigned channels;
+    unsigned chMode;
+    unsigned bps;
+} FLAC_FRAME;
+
+struct FLAC_DEC {
+    FLAC_BITS bits;
+    FLAC_STREAM_INFO info;
+    FLAC_DEC_STATS stats;
+    uint32_t audioOffset;
+    int32_t *blockMem;
+    int32_t *chan[FLAC_DEC_MAX_CHANNELS];
+    unsigned blockSize;        /* Samples per channel in the current block */
+    unsigned bps;              /* Bits per sample of the current block */
+    unsigned readPos;          /* Interleaved read index into the block */
+    bool end;
+};
+
+static uint8_t crc8Table[256];
+static uint16_t crc16Table[256];
+static bool crcInit = false;
+
+/***********************************************************************
+ * CRCs (CRC-8 poly 0x07, CRC-16 poly 0x8005, both MSB first, init 0)
+ **********************************************************************/
+static void flacCrcInit(void)
+{
+    unsigned i, j;
+    uint8_t c8;
+    uint16_t c16;
+
+    for (i = 0; i < 256; i++) {
+        c8 = (uint8_t)i;
+        c16 = (uint16_t)(i << 8);
+        for (j = 0; j < 8; j++) {
+            c8 = (c8 & 0x80) ? (uint8_t)((c8 << 1) ^ 0x07) : (uint8_t)(c8 << 1);
+            c16 = (c16 & 0x8000) ?
+                (uint16_t)((c16 << 1) ^ 0x8005) : (uint16_t)(c16 << 1);
+        }
+        crc8Table[i] = c8;
+        crc16Table[i] = c16;
+    }
+    crcInit = true;
+}
+
+static uint8_t flacCrc8(const uint8_t *p, size_t len)
+{
+    uint8_t crc = 0;
+    while (len--) {
+        crc = crc8Table[crc ^ *p++];
+    }
+    return(crc);
+}
+
+static uint16_t flacCrc16(uint16_t crc, const uint8_t *p, size_t len)
+{
+    while (len--) {
+        crc = (uint16_t)(crc << 8) ^ crc16Table[(crc >> 8) ^ *p++];
+    }
+    return(crc);
+}
+
+/***********************************************************************
+ * Bit reader
+ **********************************************************************/
+static size_t flacConsumed(FLAC_BITS *b)
+{
+    return(b->pos - b->bits / 8);
+}
+
+static bool flacFill(FLAC_BITS *b)
+{
+    size_t len;
+
+#if FLAC_DEC_CHECK_CRC16
+    b->crc16 = flacCrc16(b->crc16, b->buf + b->crcPos, b->len - b->crcPos);
+#endif
+    b->crcPos = 0;
+    b->base += b->len;
+    b->pos = 0;
+    b->len = 0;
+
+    len = b->read(b->usr, b->buf, FLAC_DEC_IN_BUF_SIZE);
+    if (len == (size_t)-1) {
+        b->error = true;
+        len = 0;
+    }
+    if (len == 0) {
+        b->eof = true;
+        return(false);
+    }
+    b->len = len;
+
+    return(true);
+}
+
+/* Makes at least 'n' (<= 32) bits available, zeros past the end */
+static inline void flacLoad(FLAC_BITS *b, unsigned n)
+{
+    while ((b->bits <= 56) && (b->pos < b->len)) {
+        b->cache |= (uint64_t)b->buf[b->pos++] << (56 - b->bits);
+        b->bits += 8;
+    }
+    while (b->bits < n) {
+        if ((b->pos < b->len) || flacFill(b)) {
+            while ((b->bits <= 56) && (b->pos < b->len)) {
+                b->cache |= (uint64_t)b->buf[b->pos++] << (56 - b->bits);
+                b->bits += 8;
+            }
+        } else {
+            b->bits += 8;
+        }
+    }
+}
+
+static inline uint32_t flacBits(FLAC_BITS *b, unsigned n)
+{
+    uint32_t v;
+
+    if (n == 0) {
+        return(0);
+    }
+    if (b->bits < n) {
+        flacLoad(b, n);
+    }
+    v = (uint32_t)(b->cache >> (64 - n));
+    b->cache <<= n;
+    b->bits -= n;
+
+    return(v);
+}
+
+static inline int32_t flacSBits(FLAC_BITS *b, unsigned n)
+{
+    if (n == 0) {
+        return(0);
+    }
+    return((int32_t)(flacBits(b, n) << (32 - n)) >> (32 - n));
+}
+
+static inline uint32_t flacUnary(FLAC_BITS *b)
+{
+    uint32_t q = 0;
+    unsigned z;
+
+    while (1) {
+        if (b->cache) {
+            z = (unsigned)__builtin_clzll(b->cache);
+            b->cache <<= z; b->cache <<= 1;
+            b->bits -= z + 1;
+            return(q + z);
+        }
+        q += b->bits;
+        b->bits = 0;
+        if (b->eof) {
+            return(q);
+        }
+        flacLoad(b, 8);
+    }
+}
+
+static void flacAlign(FLAC_BITS *b)
+{
+    unsigned n = b->bits & 7;
+    b->cache <<= n;
+    b->bits -= n;
+}
+
+static void flacSkip(FLAC_BITS *b, uint32_t bytes)
+{
+    size_t n;
+
+    while (bytes && b->bits) {
+        flacBits(b, 8); bytes--;
+    }
+    while (bytes) {
+        if ((b->pos == b->len) && !flacFill(b)) {
+            break;
+        }
+        n = b->len - b->pos;
+        n = (n > bytes) ? bytes : n;
+        b->pos += n; bytes -= n;
+    }
+}
+
+/***********************************************************************
+ * Subframes
+ **********************************************************************/
+static bool flacResidual(FLAC_BITS *b, int32_t *x, unsigned n, unsigned order)
+{
+    unsigned method, porder, parts, psize, cnt, k, raw, p, i, j;
+    uint32_t u;
+
+    method = flacBits(b, 2);
+    if (method > 1) {
+        return(false);
+    }
+    porder = flacBits(b, 4);
+    parts = 1u << porder;
+    psize = n >> porder;
+    if (((psize << porder) != n) || (psize < order)) {
+        return(false);
+    }
+
+    i = order;
+    for (p = 0; p < parts; p++) {
+        cnt = (p == 0) ? psize - order : psize;
+        k = flacBits(b, method ? 5 : 4);
+        if (k == (method ? 31u : 15u)) {
+            raw = flacBits(b, 5);
+            for (j = 0; j < cnt; j++) {
+                x[i++] = flacSBits(b, raw);
+            }
+        } else {
+            for (j = 0; j < cnt; j++) {
+                u = (flacUnary(b) << k) | flacBits(b, k);
+                x[i++] = (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+            }
+        }
+        if (b->eof) {
+            return(false);
+        }
+    }
+
+    return(true);
+}
+
+static void flacFixed(int32_t *x, unsigned n, unsigned order)
+{
+    unsigned i;
+
+    switch (order) {
+        case 1:
+            for (i = 1; i < n; i++) {
+                x[i] += x[i-1];
+            }
+            break;
+        case 2:
+            for (i = 2; i < n; i++) {
+                x[i] += 2 * x[i-1] - x[i-2];
+            }
+            break;
+        case 3:
+            for (i = 3; i < n; i++) {
+                x[i] += 3 * (x[i-1] - x[i-2]) + x[i-3];
+            }
+            break;
+        case 4:
+            for (i = 4; i < n; i++) {
+                x[i] += 4 * (x[i-1] + x[i-3]) - 6 * x[i-2] - x[i-4];
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * LPC restoration, x[i] += (sum(coef[j] * x[i-1-j]) >> shift).  The
+ * sum fits 32 bits when bps + precision + log2(order) <= 32, otherwise
+ * it is accumulated in 64 bits.
+ */
+static void flacLpc(int32_t *x, unsigned n, const int32_t *coef,
+    unsigned order, int shift, bool wide)
+{
+    unsigned i, j;
+
+#if defined(__ARM_NEON)
+    /*
+     * One output per pass, the taps run four wide over a window that
+     * ends at x[i-1].  The window is padded at its old end with zero
+     * coefficients so it always spans whole vectors, FLAC_GUARD makes
+     * those reads safe for the first outputs.
+     */
+    int32_t rev[FLAC_MAX_LPC_ORDER];
+    unsigned taps = (order + 3) & ~3u;
+    int32x4_t acc, c;
+    int64x2_t acc64;
+    int32x2_t s;
+    const int32_t *w;
+
+    for (j = 0; j < taps; j++) {
+        rev[j] = (taps - 1 - j < order) ? coef[taps - 1 - j] : 0;
+    }
+    if (!wide) {
+        for (i = order; i < n; i++) {
+            w = x + i - taps;
+            acc = vmulq_s32(vld1q_s32(rev), vld1q_s32(w));
+            for (j = 4; j < taps; j += 4) {
+                acc = vmlaq_s32(acc, vld1q_s32(rev + j), vld1q_s32(w + j));
+            }
+            s = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+            s = vpadd_s32(s, s);
+            x[i] += vget_lane_s32(s, 0) >> shift;
+        }
+    } else {
+        for (i = order; i < n; i++) {
+            w = x + i - taps;
+            acc64 = vdupq_n_s64(0);
+            for (j = 0; j < taps; j += 4) {
+                c = vld1q_s32(rev + j);
+                acc = vld1q_s32(w + j);
+                acc64 = vmlal_s32(acc64, vget_low_s32(c), vget_low_s32(acc));
+                acc64 = vmlal_s32(acc64, vget_high_s32(c), vget_high_s32(acc));
+            }
+            x[i] += (int32_t)((vgetq_lane_s64(acc64, 0) +
+                vgetq_lane_s64(acc64, 1)) >> shift);
+        }
+    }
+#else
+    int32_t sum;
+    int64_t sum64;
+
+    if (!wide) {
+        for (i = order; i < n; i++) {
+            sum = 0;
+            for (j = 0; j < order; j++) {
+                sum += coef[j] * x[i - 1 - j];
+            }
+            x[i] += sum >> shift;
+        }
+    } else {
+        for (i = order; i < n; i++) {
+            sum64 = 0;
+            for (j = 0; j < order; j++) {
+                sum64 += (int64_t)coef[j] * x[i - 1 - j];
+            }
+            x[i] += (int32_t)(sum64 >> shift);
+        }
+    }
+#endif
+}
+
+static unsigned flacLog2(unsigned v)
+{
+    unsigned l = 0;
+    while (v >>= 1) {
+        l++;
+    }
+    return(l);
+}
+
+static bool flacSubframe(FLAC_BITS *b, int32_t *x, unsigned n, unsigned bps)
+{
+    int32_t coef[FLAC_MAX_LPC_ORDER];
+    unsigned type, wasted, order, precision, i;
+    int shift;
+    int32_t v;
+
+    if (flacBits(b, 1) != 0) {
+        return(false);
+    }
+    type = flacBits(b, 6);
+    wasted = 0;
+    if (flacBits(b, 1)) {
+        wasted = flacUnary(b) + 1;
+        if (wasted >= bps) {
+            return(false);
+        }
+        bps -= wasted;
+    }
+
+    if (type == 0) {
+        v = flacSBits(b, bps);
+        for (i = 0; i < n; i++) {
+            x[i] = v;
+        }
+    } else if (type == 1) {
+        for (i = 0; i < n; i++) {
+            x[i] = flacSBits(b, bps);
+        }
+    } else if ((type >= 8) && (type <= 12)) {
+        order = type - 8;
+        if (order > n) {
+            return(false);
+        }
+        for (i = 0; i < order; i++) {
+            x[i] = flacSBits(b, bps);
+        }
+        if (!flacResidual(b, x, n, order)) {
+            return(false);
+        }
+        flacFixed(x, n, order);
+    } else if (type >= 32) {
+        order = type - 31;
+        if (order > n) {
+            return(false);
+        }
+        for (i = 0; i < order; i++) {
+            x[i] = flacSBits(b, bps);
+        }
+        precision = flacBits(b, 4) + 1;
+        shift = flacSBits(b, 5);
+        if ((precision == 16) || (shift < 0)) {
+            return(false);
+        }
+        for (i = 0; i < order; i++) {
+            coef[i] = flacSBits(b, precision);
+        }
+        if (!flacResidual(b, x, n, order)) {
+            return(false);
+        }
+        flacLpc(x, n, coef, order, shift,
+            bps + precision + flacLog2(order) > 32);
+    } else {
+        return(false);
+    }
+
+    if (wasted) {
+        for (i = 0; i < n; i++) {
+            x[i] = (int32_t)((uint32_t)x[i] << wasted);
+        }
+    }
+
+    return(!b->eof);
+}
+
+/***********************************************************************
+ * Frames
+ **********************************************************************/
+/* Parses the header following a sync code, 'hdr' holds the sync bytes */
+static bool flacHeader(FLAC_DEC *dec, FLAC_FRAME *fr, uint8_t *hdr)
+{
+    static const unsigned bpsCodes[8] = { 0, 8, 12, 0, 16, 20, 24, 32 };
+    FLAC_BITS *b = &dec->bits;
+    unsigned len, bsCode, srCode, ssCode, ones, i;
+
+    len = 2;
+    for (i = 0; i < 2; i++) {
+        hdr[len++] = (uint8_t)flacBits(b, 8);
+    }
+    bsCode = hdr[2] >> 4;
+    srCode = hdr[2] & 0xF;
+    fr->chMode = hdr[3] >> 4;
+    ssCode = (hdr[3] >> 1) & 0x7;
+    if ((bsCode == 0) || (srCode == 15) || (fr->chMode > FLAC_CH_MID_SIDE) ||
+        (ssCode == 3) || (hdr[3] & 1)) {
+        return(false);
+    }
+
+    /* Frame or sample number, UTF-8 style, 1 to 7 bytes */
+    hdr[len] = (uint8_t)flacBits(b, 8);
+    ones = 0;
+    while ((ones < 8) && (hdr[len] & (0x80 >> ones))) {
+        ones++;
+    }
+    if ((ones == 1) || (ones > 7)) {
+        return(false);
+    }
+    len++;
+    for (i = 1; i < ones; i++) {
+        hdr[len] = (uint8_t)flacBits(b, 8);
+        if ((hdr[len++] & 0xC0) != 0x80) {
+            return(false);
+        }
+    }
+
+    if (bsCode == 1) {
+        fr->blockSize = 192;
+    } else if (bsCode <= 5) {
+        fr->blockSize = 576u << (bsCode - 2);
+    } else if (bsCode == 6) {
+        hdr[len] = (uint8_t)flacBits(b, 8);
+        fr->blockSize = hdr[len++] + 1u;
+    } else if (bsCode == 7) {
+        hdr[len] = (uint8_t)flacBits(b, 8);
+        hdr[len + 1] = (uint8_t)flacBits(b, 8);
+        fr->blockSize = ((unsigned)hdr[len] << 8 | hdr[len + 1]) + 1u;
+        len += 2;
+    } else {
+        fr->blockSize = 256u << (bsCode - 8);
+    }
+
+    /* Sample rate is not used, just skip the extra bytes */
+    if (srCode == 12) {
+        hdr[len++] = (uint8_t)flacBits(b, 8);
+    } else if ((srCode == 13) || (srCode == 14)) {
+        hdr[len++] = (uint8_t)flacBits(b, 8);
+        hdr[len++] = (uint8_t)flacBits(b, 8);
+    }
+
+    if (flacCrc8(hdr, len) != flacBits(b, 8)) {
+        return(false);
+    }
+
+    fr->channels = (fr->chMode < FLAC_CH_LEFT_SIDE) ? fr->chMode + 1 : 2;
+    fr->bps = ssCode ? bpsCodes[ssCode] : dec->info.bitsPerSample;
+
+    return(!b->eof && (fr->channels == dec->info.channels) &&
+        (fr->bps <= FLAC_MAX_BPS) &&
+        (fr->blockSize <= dec->info.maxBlockSize));
+}
+
+/* Finds the next valid frame header, false at the end of the stream */
+static bool flacSync(FLAC_DEC *dec, FLAC_FRAME *fr)
+{
+    FLAC_BITS *b = &dec->bits;
+    uint8_t hdr[FLAC_MAX_HEADER];
+    unsigned prev, x;
+
+    flacAlign(b);
+    prev = 0;
+    while (1) {
+        x = flacBits(b, 8);
+        if (b->eof) {
+            return(false);
+        }
+        if ((prev == 0xFF) && ((x & 0xFE) == 0xF8)) {
+            hdr[0] = 0xFF; hdr[1] = (uint8_t)x;
+            b->crc16 = flacCrc16(0, hdr, 2);
+            b->crcPos = flacConsumed(b);
+            if (flacHeader(dec, fr, hdr)) {
+                return(true);
+            }
+            if (b->eof) {
+                return(false);
+            }
+            dec->stats.syncErrors++;
+            x = 0;
+        }
+        prev = x;
+    }
+}
+
+static void flacDecorrelate(FLAC_DEC *dec, unsigned mode, unsigned n)
+{
+    int32_t *a = dec->chan[0], *s = dec->chan[1];
+    int32_t m;
+    unsigned i;
+
+    switch (mode) {
+        case FLAC_CH_LEFT_SIDE:
+            for (i = 0; i < n; i++) {
+                s[i] = a[i] - s[i];
+            }
+            break;
+        case FLAC_CH_RIGHT_SIDE:
+            for (i = 0; i < n; i++) {
+                a[i] += s[i];
+            }
+            break;
+        case FLAC_CH_MID_SIDE:
+            for (i = 0; i < n; i++) {
+                m = (int32_t)((uint32_t)a[i] << 1) | (s[i] & 1);
+                a[i] = (m + s[i]) >> 1;
+                s[i] = (m - s[i]) >> 1;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/* Decodes the next frame into the block buffers, false at the end */
+static bool flacFrame(FLAC_DEC *dec)
+{
+    FLAC_BITS *b = &dec->bits;
+    FLAC_FRAME fr;
+    unsigned c, bps;
+    uint16_t crc;
+    bool ok;
+
+    if (!flacSync(dec, &fr)) {
+        return(false);
+    }
+
+    ok = true;
+    for (c = 0; ok && (c < fr.channels); c++) {
+        /* The side channel carries one extra bit */
+        bps = fr.bps;
+        if (((fr.chMode == FLAC_CH_LEFT_SIDE) && (c == 1)) ||
+            ((fr.chMode == FLAC_CH_RIGHT_SIDE) && (c == 0)) ||
+            ((fr.chMode == FLAC_CH_MID_SIDE) && (c == 1))) {
+            bps++;
+        }
+        ok = flacSubframe(b, dec->chan[c], fr.blockSize, bps);
+    }
+    if (b->eof) {
+        return(false);
+    }
+
+    if (ok) {
+        flacAlign(b);
+#if FLAC_DEC_CHECK_CRC16
+        crc = flacCrc16(b->crc16, b->buf + b->crcPos,
+            flacConsumed(b) - b->crcPos);
+        if (crc != flacBits(b, 16)) {
+            dec->stats.crcErrors++;
+            ok = false;
+        }
+#else
+        (void)crc;
+        flacBits(b, 16);
+#endif
+    } else {
+        dec->stats.syncErrors++;
+    }
+
+    /* Bad frames play as silence to keep the timing */
+    if (ok) {
+        flacDecorrelate(dec, fr.chMode, fr.blockSize);
+    } else {
+        for (c = 0; c < fr.channels; c++) {
+            memset(dec->chan[c], 0, fr.blockSize * sizeof(int32_t));
+        }
+    }
+
+    dec->blockSize = fr.blockSize;
+    dec->bps = fr.bps;
+    dec->readPos = 0;
+    dec->stats.frames++;
+
+    return(true);
+}
+
+/***********************************************************************
+ * Output
+ **********************************************************************/
+static void flacInterleave(FLAC_DEC *dec, int32_t *dst, size_t n)
+{
+    unsigned ch = dec->info.channels;
+    unsigned shift = 32 - dec->bps;
+    unsigned pos = dec->readPos;
+    unsigned f, c;
+
+    dec->readPos += n;
+
+    /* Finish a frame started by the previous call */
+    while (n && (pos % ch)) {
+        *dst++ = (int32_t)((uint32_t)dec->chan[pos % ch][pos / ch] << shift);
+        pos++; n--;
+    }
+    f = pos / ch;
+
+#if defined(__ARM_NEON)
+    if (ch == 2) {
+        int32x4x2_t v;
+        int32x4_t sh = vdupq_n_s32((int32_t)shift);
+        for (; n >= 8; n -= 8, f += 4, dst += 8) {
+            v.val[0] = vshlq_s32(vld1q_s32(dec->chan[0] + f), sh);
+            v.val[1] = vshlq_s32(vld1q_s32(dec->chan[1] + f), sh);
+            vst2q_s32(dst, v);
+        }
+    }
+#endif
+
+    for (; n >= ch; n -= ch, f++) {
+        for (c = 0; c < ch; c++) {
+            *dst++ = (int32_t)((uint32_t)dec->chan[c][f] << shift);
+        }
+    }
+    for (c = 0; n; c++, n--) {
+        *dst++ = (int32_t)((uint32_t)dec->chan[c][f] << shift);
+    }
+}
+
+/***********************************************************************
+ * API
+ **********************************************************************/
+FLAC_DEC *flac_dec_open(FLAC_DEC_READ read, void *usr)
+{
+    FLAC_DEC *dec;
+    FLAC_BITS *b;
+    FLAC_STREAM_INFO *info;
+    unsigned last, type, c;
+    uint32_t len;
+    bool gotInfo;
+    bool ok;
+
+    if (!crcInit) {
+        flacCrcInit();
+    }
+
+    dec = FLAC_DEC_CALLOC(1, sizeof(*dec));
+    if (dec == NULL) {
+        return(NULL);
+    }
+    b = &dec->bits;
+    info = &dec->info;
+    b->read = read;
+    b->usr = usr;
+    b->buf = FLAC_DEC_CALLOC(FLAC_DEC_IN_BUF_SIZE, 1);
+    if (b->buf == NULL) {
+        FLAC_DEC_FREE(dec);
+        return(NULL);
+    }
+
+    ok = (flacBits(b, 32) == FLAC_MAGIC);
+    gotInfo = false;
+    last = 0;
+    while (ok && !last && !b->eof) {
+        last = flacBits(b, 1);
+        type = flacBits(b, 7);
+        len = flacBits(b, 24);
+        if ((type == 0) && (len >= 34)) {
+            info->minBlockSize = flacBits(b, 16);
+            info->maxBlockSize = flacBits(b, 16);
+            flacBits(b, 24); flacBits(b, 24);
+            info->sampleRate = flacBits(b, 20);
+            info->channels = flacBits(b, 3) + 1;
+            info->bitsPerSample = flacBits(b, 5) + 1;
+            info->totalFrames = (uint64_t)flacBits(b, 4) << 32;
+            info->totalFrames |= flacBits(b, 32);
+            len -= 18;
+            gotInfo = true;
+        }
+        flacSkip(b, len);
+    }
+
+    ok = ok && gotInfo && !b->eof &&
+        (info->channels <= FLAC_DEC_MAX_CHANNELS) &&
+        (info->bitsPerSample >= 4) && (info->bitsPerSample <= FLAC_MAX_BPS) &&
+        (info->maxBlockSize >= 16) &&
+        (info->maxBlockSize <= FLAC_DEC_MAX_BLOCK_SIZE);
+
+    if (ok) {
+        dec->audioOffset = b->base + flacConsumed(b);
+        dec->blockMem = FLAC_DEC_CALLOC(
+            info->channels * (info->maxBlockSize + FLAC_GUARD), sizeof(int32_t));
+        ok = (dec->blockMem != NULL);
+    }
+    if (!ok) {
+        flac_dec_close(dec);
+        return(NULL);
+    }
+
+    for (c = 0; c < info->channels; c++) {
+        dec->chan[c] = dec->blockMem +
+            c * (info->maxBlockSize + FLAC_GUARD) + FLAC_GUARD;
+    }
+
+    return(dec);
+}
+
+void flac_dec_close(FLAC_DEC *dec)
+{
+    if (dec == NULL) {
+        return;
+    }
+    if (dec->blockMem) {
+        FLAC_DEC_FREE(dec->blockMem);
+    }
+    if (dec->bits.buf) {
+        FLAC_DEC_FREE(dec->bits.buf);
+    }
+    FLAC_DEC_FREE(dec);
+}
+
+const FLAC_STREAM_INFO *flac_dec_info(FLAC_DEC *dec)
+{
+    return(&dec->info);
+}
+
+uint32_t flac_dec_audio_offset(FLAC_DEC *dec)
+{
+    return(dec->audioOffset);
+}
+
+size_t flac_dec_read(FLAC_DEC *dec, int32_t *dst, size_t samples)
+{
+    size_t done, avail, n;
+
+    done = 0;
+    while (done < samples) {
+        avail = dec->blockSize * dec->info.channels - dec->readPos;
+        if (avail == 0) {
+            if (dec->end || !flacFrame(dec)) {
+                dec->end = true;
+                break;
+            }
+            continue;
+        }
+        n = samples - done;
+        n = (n > avail) ? avail : n;
+        flacInterleave(dec, dst + done, n);
+        done += n;
+    }
+
+    if ((done == 0) && dec->bits.error) {
+        return((size_t)-1);
+    }
+
+    return(done);
+}
+
+void flac_dec_restart(FLAC_DEC *dec)
+{
+    FLAC_BITS *b = &dec->bits;
+
+    b->pos = b->len = b->crcPos = 0;
+    b->base = dec->audioOffset;
+    b->cache = 0;
+    b->bits = 0;
+    b->eof = false;
+    b->error = false;
+    dec->blockSize = 0;
+    dec->readPos = 0;
+    dec->end = false;
+}
+
+void flac_dec_stats(FLAC_DEC *dec, FLAC_DEC_STATS *stats)
+{
+    *stats = dec->stats;
+}
@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _flac_dec_h
+#define _flac_dec_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Streaming fixed-point FLAC decoder.
+ *
+ * Compressed bytes are pulled through a read callback one input buffer
+ * at a time and decoded a frame (block) at a time into planar 32-bit
+ * buffers.  flac_dec_read() interleaves the decoded block into the
+ * caller's buffer as left-justified signed 32-bit samples, the same
+ * format decodeWave() produces, so the caller can hand it ring buffer
+ * regions directly.
+ *
+ * Supports everything the reference encoder produces: CONSTANT,
+ * VERBATIM, FIXED and LPC subframes, wasted bits, all stereo
+ * decorrelation modes and 4 to 24 bits per sample.  Frames with a bad
+ * CRC are replaced with silence and the decoder resyncs on the next
+ * frame header.
+ */
+
+/* Returns bytes read into 'buf', 0 at end of stream */
+typedef size_t (*FLAC_DEC_READ)(void *usr, void *buf, size_t len);
+
+typedef struct FLAC_STREAM_INFO {
+    unsigned minBlockSize;
+    unsigned maxBlockSize;
+    unsigned sampleRate;
+    unsigned channels;
+    unsigned bitsPerSample;
+    uint64_t totalFrames;      /* Samples per channel, 0 if unknown */
+} FLAC_STREAM_INFO;
+
+typedef struct FLAC_DEC_STATS {
+    uint32_t frames;
+    uint32_t crcErrors;
+    uint32_t syncErrors;
+} FLAC_DEC_STATS;
+
+typedef struct FLAC_DEC FLAC_DEC;
+
+/*
+ * Parses the "fLaC" marker and metadata blocks from the start of the
+ * stream.  Returns NULL if the stream is not FLAC, exceeds the
+ * configured block size or channel limits or is out of memory.
+ */
+FLAC_DEC *flac_dec_open(FLAC_DEC_READ read, void *usr);
+void flac_dec_close(FLAC_DEC *dec);
+
+const FLAC_STREAM_INFO *flac_dec_info(FLAC_DEC *dec);
+
+/* Byte offset of the first frame from the start of the stream */
+uint32_t flac_dec_audio_offset(FLAC_DEC *dec);
+
+/*
+ * Decodes up to 'samples' interleaved samples into 'dst'.  Partial
+ * frames are fine, the next call continues where this one stopped.
+ * Returns the number of samples written, 0 at the end of the stream
+ * or (size_t)-1 on a read error.
+ */
+size_t flac_dec_read(FLAC_DEC *dec, int32_t *dst, size_t samples);
+
+/*
+ * Drops all buffered input and decoded samples.  The caller must
+ * reposition the stream to a frame boundary, usually
+ * flac_dec_audio_offset(), before the next read.
+ */
+void flac_dec_restart(FLAC_DEC *dec);
+
+void flac_dec_stats(FLAC_DEC *dec, FLAC_DEC_STATS *stats);
+
+#endif
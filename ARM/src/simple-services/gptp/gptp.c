@@ -0,0 +1,596 @@
+/**
+ * Copyright (c) 2022 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * 802.1AS slave.  Two-step Sync/Follow_Up drives a PI servo that slews
+ * a software local-to-master mapping, peer delay is measured towards
+ * the link partner and answered for it, and the master is chosen from
+ * Announce messages by comparing the grandmaster priority vectors.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "gptp_cfg.h"
+#include "gptp.h"
+
+#ifndef GPTP_LOCK_THRESHOLD
+#define GPTP_LOCK_THRESHOLD            (1000)
+#endif
+
+#ifndef GPTP_LOCK_COUNT
+#define GPTP_LOCK_COUNT                (8)
+#endif
+
+#ifndef GPTP_STEP_THRESHOLD
+#define GPTP_STEP_THRESHOLD            (1000000)
+#endif
+
+#ifndef GPTP_SYNC_TIMEOUT
+#define GPTP_SYNC_TIMEOUT              (1000000000ULL)
+#endif
+
+#ifndef GPTP_ANNOUNCE_TIMEOUT
+#define GPTP_ANNOUNCE_TIMEOUT          (3000000000ULL)
+#endif
+
+#ifndef GPTP_PDELAY_INTERVAL
+#define GPTP_PDELAY_INTERVAL           (1000000000ULL)
+#endif
+
+#ifndef GPTP_NEIGHBOR_PROP_DELAY_THRESH
+#define GPTP_NEIGHBOR_PROP_DELAY_THRESH (800)
+#endif
+
+/* Servo gains in 1/10ths */
+#ifndef GPTP_SERVO_KP
+#define GPTP_SERVO_KP                  (7)
+#endif
+#ifndef GPTP_SERVO_KI
+#define GPTP_SERVO_KI                  (3)
+#endif
+
+#define GPTP_MAX_DRIFT_PPB             (500000)
+#define NS_PER_SEC                     (1000000000LL)
+
+/* Message types */
+#define MSG_SYNC                  (0x0)
+#define MSG_PDELAY_REQ            (0x2)
+#define MSG_PDELAY_RESP           (0x3)
+#define MSG_FOLLOW_UP             (0x8)
+#define MSG_PDELAY_RESP_FOLLOW_UP (0xA)
+#define MSG_ANNOUNCE              (0xB)
+
+/* Header layout */
+#define HDR_TYPE_OFFSET           (0)
+#define HDR_VERSION_OFFSET        (1)
+#define HDR_LENGTH_OFFSET         (2)
+#define HDR_FLAGS_OFFSET          (6)
+#define HDR_CORRECTION_OFFSET     (8)
+#define HDR_PORT_ID_OFFSET        (20)
+#define HDR_SEQ_OFFSET            (30)
+#define HDR_CONTROL_OFFSET        (32)
+#define HDR_LOG_INTERVAL_OFFSET   (33)
+#define HDR_SIZE                  (34)
+
+#define TRANSPORT_SPECIFIC_8021AS (0x10)
+#define PTP_VERSION               (0x02)
+#define FLAG_TWO_STEP             (0x02)
+#define FLAG_PTP_TIMESCALE        (0x08)
+
+/* Message body layout */
+#define BODY_TIMESTAMP_OFFSET     (HDR_SIZE)
+#define BODY_PORT_ID_OFFSET       (HDR_SIZE + 10)
+#define ANNOUNCE_VECTOR_OFFSET    (HDR_SIZE + 13)
+#define ANNOUNCE_PRIORITY2_OFFSET (HDR_SIZE + 18)
+#define ANNOUNCE_GM_ID_OFFSET     (HDR_SIZE + 19)
+#define ANNOUNCE_SIZE             (HDR_SIZE + 30)
+#define PDELAY_SIZE               (HDR_SIZE + 20)
+#define FOLLOW_UP_SIZE            (HDR_SIZE + 10)
+
+#define ETH_HDR_SIZE              (14)
+
+/* Peer delay initiator progress */
+#define PDELAY_HAVE_T1            (0x01)
+#define PDELAY_HAVE_T2_T4         (0x02)
+#define PDELAY_HAVE_T3            (0x04)
+#define PDELAY_HAVE_ALL           (0x07)
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v >> 8; p[1] = v;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return(((uint16_t)p[0] << 8) | p[1]);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | p[3]);
+}
+
+/* PTP timestamps are 48-bit seconds and 32-bit nanoseconds */
+static void putTimestamp(uint8_t *p, uint64_t t)
+{
+    uint64_t sec = t / NS_PER_SEC;
+
+    put16(p, sec >> 32);
+    put32(p + 2, sec);
+    put32(p + 6, t % NS_PER_SEC);
+}
+
+static uint64_t getTimestamp(const uint8_t *p)
+{
+    uint64_t sec = ((uint64_t)get16(p) << 32) | get32(p + 2);
+
+    return(sec * NS_PER_SEC + get32(p + 6));
+}
+
+static void getPortId(const uint8_t *p, GPTP_PORT_ID *id)
+{
+    memcpy(id->clockIdentity, p, 8);
+    id->portNumber = get16(p + 8);
+}
+
+static void putPortId(uint8_t *p, const GPTP_PORT_ID *id)
+{
+    memcpy(p, id->clockIdentity, 8);
+    put16(p + 8, id->portNumber);
+}
+
+static bool samePortId(const GPTP_PORT_ID *a, const GPTP_PORT_ID *b)
+{
+    return((a->portNumber == b->portNumber) &&
+        (memcmp(a->clockIdentity, b->clockIdentity, 8) == 0));
+}
+
+static int64_t absDiff(int64_t v)
+{
+    return((v < 0) ? -v : v);
+}
+
+static void gptpInitHdr(GPTP *g, uint8_t *msg, uint8_t type, unsigned len,
+    uint16_t seq, int8_t logInterval)
+{
+    memset(msg, 0, len);
+    msg[HDR_TYPE_OFFSET] = TRANSPORT_SPECIFIC_8021AS | type;
+    msg[HDR_VERSION_OFFSET] = PTP_VERSION;
+    put16(msg + HDR_LENGTH_OFFSET, len);
+    msg[HDR_FLAGS_OFFSET + 1] = FLAG_PTP_TIMESCALE;
+    memcpy(msg + HDR_PORT_ID_OFFSET, g->clockIdentity, 8);
+    put16(msg + HDR_PORT_ID_OFFSET + 8, 1);
+    put16(msg + HDR_SEQ_OFFSET, seq);
+    msg[HDR_CONTROL_OFFSET] = 5;
+    msg[HDR_LOG_INTERVAL_OFFSET] = (uint8_t)logInterval;
+}
+
+/***********************************************************************
+ * Local to master time mapping
+ **********************************************************************/
+static uint64_t gptpMap(const GPTP_MAP *map, uint64_t local)
+{
+    int64_t delta = (int64_t)(local - map->localBase);
+
+    return(map->masterBase + delta + (delta * map->ratePpb) / NS_PER_SEC);
+}
+
+static void gptpSetMap(GPTP *g, uint64_t local, uint64_t master,
+    int32_t ratePpb)
+{
+    unsigned idx = g->mapIdx ^ 1;
+
+    g->map[idx].localBase = local;
+    g->map[idx].masterBase = master;
+    g->map[idx].ratePpb = ratePpb;
+    g->mapIdx = idx;
+}
+
+bool gptpLocalToMaster(GPTP *g, uint64_t local, uint64_t *master)
+{
+    const GPTP_MAP *map;
+
+    if (g->servo == GPTP_SERVO_INIT) {
+        *master = local;
+        return(false);
+    }
+
+    map = &g->map[g->mapIdx];
+    *master = gptpMap(map, local);
+
+    return(true);
+}
+
+/***********************************************************************
+ * Servo
+ **********************************************************************/
+static void gptpUnlock(GPTP *g)
+{
+    g->stats.locked = false;
+    g->goodSyncs = 0;
+}
+
+static void gptpServo(GPTP *g, uint64_t local, uint64_t master)
+{
+    const GPTP_MAP *map = &g->map[g->mapIdx];
+    uint64_t predicted;
+    int64_t offset;
+    int64_t offsetPpb;
+    int64_t interval;
+    int64_t ppb;
+
+    g->stats.syncs++;
+
+    switch (g->servo) {
+
+        case GPTP_SERVO_INIT:
+            gptpSetMap(g, local, master, 0);
+            g->drift = 0;
+            g->servo = GPTP_SERVO_STEPPED;
+            break;
+
+        case GPTP_SERVO_STEPPED:
+            /* Initial frequency estimate from two syncs */
+            interval = (int64_t)(local - g->prevLocal);
+            if (interval <= 0) {
+                break;
+            }
+            ppb = (((int64_t)(master - g->prevMaster) - interval) *
+                NS_PER_SEC) / interval;
+            if (absDiff(ppb) > GPTP_MAX_DRIFT_PPB) {
+                ppb = 0;
+            }
+            g->drift = ppb;
+            gptpSetMap(g, local, master, (int32_t)ppb);
+            g->servo = GPTP_SERVO_TRACKING;
+            break;
+
+        case GPTP_SERVO_TRACKING:
+            predicted = gptpMap(map, local);
+            offset = (int64_t)(predicted - master);
+            g->stats.offset = (int32_t)offset;
+            if (absDiff(offset) > absDiff(g->stats.offsetMax)) {
+                g->stats.offsetMax = (int32_t)offset;
+            }
+
+            if (absDiff(offset) > GPTP_STEP_THRESHOLD) {
+                gptpSetMap(g, local, master, (int32_t)g->drift);
+                g->stats.steps++;
+                gptpUnlock(g);
+                break;
+            }
+
+            /* PI on the offset expressed as a rate over the interval */
+            interval = (int64_t)(local - g->prevLocal);
+            if (interval <= 0) {
+                break;
+            }
+            offsetPpb = (offset * NS_PER_SEC) / interval;
+            g->drift -= (offsetPpb * GPTP_SERVO_KI) / 10;
+            if (g->drift > GPTP_MAX_DRIFT_PPB) {
+                g->drift = GPTP_MAX_DRIFT_PPB;
+            } else if (g->drift < -GPTP_MAX_DRIFT_PPB) {
+                g->drift = -GPTP_MAX_DRIFT_PPB;
+            }
+            ppb = g->drift - (offsetPpb * GPTP_SERVO_KP) / 10;
+
+            /* Rebase on the prediction so the clock never jumps */
+            gptpSetMap(g, local, predicted, (int32_t)ppb);
+            g->stats.ratePpb = (int32_t)ppb;
+
+            if (absDiff(offset) < GPTP_LOCK_THRESHOLD) {
+                if (!g->stats.locked && (++g->goodSyncs >= GPTP_LOCK_COUNT)) {
+                    g->stats.locked = true;
+                    g->stats.locks++;
+                }
+            } else {
+                g->goodSyncs = 0;
+                if (absDiff(offset) > 10 * GPTP_LOCK_THRESHOLD) {
+                    gptpUnlock(g);
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    g->prevLocal = local;
+    g->prevMaster = master;
+}
+
+static void gptpLoseMaster(GPTP *g)
+{
+    g->masterValid = false;
+    g->syncValid = false;
+    if (g->servo == GPTP_SERVO_STEPPED) {
+        g->servo = GPTP_SERVO_INIT;
+    }
+    gptpUnlock(g);
+    g->stats.timeouts++;
+}
+
+/***********************************************************************
+ * Message handlers
+ **********************************************************************/
+static void gptpRecvAnnounce(GPTP *g, uint8_t *msg, unsigned len,
+    GPTP_PORT_ID *src, uint64_t now)
+{
+    uint8_t vector[14];
+
+    if (len < ANNOUNCE_SIZE) {
+        return;
+    }
+
+    /* priority1, clockQuality, priority2, grandmasterIdentity */
+    memcpy(vector, msg + ANNOUNCE_VECTOR_OFFSET, 5);
+    vector[5] = msg[ANNOUNCE_PRIORITY2_OFFSET];
+    memcpy(vector + 6, msg + ANNOUNCE_GM_ID_OFFSET, 8);
+
+    /* Ignore announces we originated through a loop */
+    if (memcmp(vector + 6, g->clockIdentity, 8) == 0) {
+        return;
+    }
+
+    if (g->masterValid && samePortId(src, &g->masterPort)) {
+        memcpy(g->masterVector, vector, sizeof(vector));
+        memcpy(g->gmIdentity, vector + 6, 8);
+        g->announceTime = now;
+        return;
+    }
+
+    if (!g->masterValid ||
+        (memcmp(vector, g->masterVector, sizeof(vector)) < 0)) {
+        g->masterValid = true;
+        g->masterPort = *src;
+        memcpy(g->masterVector, vector, sizeof(vector));
+        memcpy(g->gmIdentity, vector + 6, 8);
+        g->announceTime = now;
+        g->lastSyncTime = now;
+        g->syncValid = false;
+    }
+}
+
+static void gptpRecvFollowUp(GPTP *g, uint8_t *msg, unsigned len)
+{
+    uint64_t master;
+    int64_t correction;
+
+    if ((len < FOLLOW_UP_SIZE) || !g->syncValid ||
+        (get16(msg + HDR_SEQ_OFFSET) != g->syncSeq)) {
+        return;
+    }
+    g->syncValid = false;
+
+    correction = (int64_t)(((uint64_t)get32(msg + HDR_CORRECTION_OFFSET) << 32) |
+        get32(msg + HDR_CORRECTION_OFFSET + 4));
+
+    master = getTimestamp(msg + BODY_TIMESTAMP_OFFSET) +
+        (correction >> 16) + g->stats.meanPathDelay;
+
+    gptpServo(g, g->syncRx, master);
+}
+
+static void gptpPdelayDone(GPTP *g)
+{
+    int64_t delay;
+
+    if (g->pdelayHave != PDELAY_HAVE_ALL) {
+        return;
+    }
+    g->pdelayHave = 0;
+
+    delay = ((int64_t)(g->pdelayT4 - g->pdelayT1) -
+        (int64_t)(g->pdelayT3 - g->pdelayT2)) / 2;
+    if ((delay < 0) || (delay > 100 * GPTP_NEIGHBOR_PROP_DELAY_THRESH)) {
+        g->stats.pdelayErrors++;
+        return;
+    }
+
+    if (g->pdelayValid) {
+        g->stats.meanPathDelay +=
+            (int32_t)(delay - g->stats.meanPathDelay) / 8;
+    } else {
+        g->stats.meanPathDelay = (uint32_t)delay;
+        g->pdelayValid = true;
+    }
+    g->stats.asCapable =
+        (g->stats.meanPathDelay <= GPTP_NEIGHBOR_PROP_DELAY_THRESH);
+    g->stats.pdelays++;
+}
+
+static void gptpRecvPdelayReq(GPTP *g, uint8_t *msg, unsigned len,
+    GPTP_PORT_ID *src, uint64_t rxTime)
+{
+    uint8_t resp[PDELAY_SIZE];
+
+    if (len < PDELAY_SIZE) {
+        return;
+    }
+
+    g->respPort = *src;
+    g->respSeq = get16(msg + HDR_SEQ_OFFSET);
+    g->respPending = true;
+
+    gptpInitHdr(g, resp, MSG_PDELAY_RESP, PDELAY_SIZE, g->respSeq, 0x7F);
+    resp[HDR_FLAGS_OFFSET] = FLAG_TWO_STEP;
+    putTimestamp(resp + BODY_TIMESTAMP_OFFSET, rxTime);
+    putPortId(resp + BODY_PORT_ID_OFFSET, src);
+    g->link.txMsg(g->link.linkPtr, resp, PDELAY_SIZE, true);
+}
+
+static bool gptpIsOurRequest(GPTP *g, uint8_t *msg)
+{
+    GPTP_PORT_ID req;
+
+    getPortId(msg + BODY_PORT_ID_OFFSET, &req);
+    return((memcmp(req.clockIdentity, g->clockIdentity, 8) == 0) &&
+        (get16(msg + HDR_SEQ_OFFSET) == g->pdelaySeq));
+}
+
+void gptpRecvFrame(GPTP *g, uint8_t *frame, unsigned len, uint64_t rxTime)
+{
+    GPTP_PORT_ID src;
+    uint8_t *msg;
+    uint8_t type;
+
+    if ((len < ETH_HDR_SIZE + HDR_SIZE) ||
+        (get16(frame + 12) != GPTP_ETHTYPE)) {
+        return;
+    }
+    msg = frame + ETH_HDR_SIZE;
+    len -= ETH_HDR_SIZE;
+
+    if (((msg[HDR_TYPE_OFFSET] & 0xF0) != TRANSPORT_SPECIFIC_8021AS) ||
+        ((msg[HDR_VERSION_OFFSET] & 0x0F) != PTP_VERSION)) {
+        return;
+    }
+    type = msg[HDR_TYPE_OFFSET] & 0x0F;
+    getPortId(msg + HDR_PORT_ID_OFFSET, &src);
+
+    switch (type) {
+
+        case MSG_ANNOUNCE:
+            gptpRecvAnnounce(g, msg, len, &src, rxTime);
+            break;
+
+        case MSG_SYNC:
+            if (g->masterValid && samePortId(&src, &g->masterPort)) {
+                g->syncSeq = get16(msg + HDR_SEQ_OFFSET);
+                g->syncRx = rxTime;
+                g->syncValid = true;
+                g->lastSyncTime = rxTime;
+            }
+            break;
+
+        case MSG_FOLLOW_UP:
+            if (g->masterValid && samePortId(&src, &g->masterPort)) {
+                gptpRecvFollowUp(g, msg, len);
+            }
+            break;
+
+        case MSG_PDELAY_REQ:
+            gptpRecvPdelayReq(g, msg, len, &src, rxTime);
+            break;
+
+        case MSG_PDELAY_RESP:
+            if ((len >= PDELAY_SIZE) && gptpIsOurRequest(g, msg)) {
+                g->pdelayT2 = getTimestamp(msg + BODY_TIMESTAMP_OFFSET);
+                g->pdelayT4 = rxTime;
+                g->pdelayHave |= PDELAY_HAVE_T2_T4;
+                gptpPdelayDone(g);
+            }
+            break;
+
+        case MSG_PDELAY_RESP_FOLLOW_UP:
+            if ((len >= PDELAY_SIZE) && gptpIsOurRequest(g, msg)) {
+                g->pdelayT3 = getTimestamp(msg + BODY_TIMESTAMP_OFFSET);
+                g->pdelayHave |= PDELAY_HAVE_T3;
+                gptpPdelayDone(g);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void gptpTxTimestamp(GPTP *g, uint8_t *frame, unsigned len, uint64_t txTime)
+{
+    uint8_t fup[PDELAY_SIZE];
+    uint8_t *msg;
+    uint8_t type;
+    uint16_t seq;
+
+    if ((len < ETH_HDR_SIZE + HDR_SIZE) ||
+        (get16(frame + 12) != GPTP_ETHTYPE)) {
+        return;
+    }
+    msg = frame + ETH_HDR_SIZE;
+    type = msg[HDR_TYPE_OFFSET] & 0x0F;
+    seq = get16(msg + HDR_SEQ_OFFSET);
+
+    if ((type == MSG_PDELAY_REQ) && (seq == g->pdelaySeq)) {
+        g->pdelayT1 = txTime;
+        g->pdelayHave |= PDELAY_HAVE_T1;
+        gptpPdelayDone(g);
+    } else if ((type == MSG_PDELAY_RESP) && g->respPending &&
+               (seq == g->respSeq)) {
+        g->respPending = false;
+        gptpInitHdr(g, fup, MSG_PDELAY_RESP_FOLLOW_UP, PDELAY_SIZE,
+            g->respSeq, 0x7F);
+        putTimestamp(fup + BODY_TIMESTAMP_OFFSET, txTime);
+        putPortId(fup + BODY_PORT_ID_OFFSET, &g->respPort);
+        g->link.txMsg(g->link.linkPtr, fup, PDELAY_SIZE, false);
+    }
+}
+
+void gptpPoll(GPTP *g, uint64_t now)
+{
+    uint8_t req[PDELAY_SIZE];
+
+    if (g->masterValid) {
+        if (((int64_t)(now - g->announceTime) > (int64_t)GPTP_ANNOUNCE_TIMEOUT) ||
+            ((int64_t)(now - g->lastSyncTime) > (int64_t)GPTP_SYNC_TIMEOUT)) {
+            gptpLoseMaster(g);
+        }
+    }
+
+    if ((int64_t)(now - g->pdelayTime) >= (int64_t)GPTP_PDELAY_INTERVAL) {
+        if (g->pdelayHave != 0) {
+            g->stats.pdelayErrors++;
+        }
+        g->pdelayTime = now;
+        g->pdelaySeq++;
+        g->pdelayHave = 0;
+        gptpInitHdr(g, req, MSG_PDELAY_REQ, PDELAY_SIZE, g->pdelaySeq, 0);
+        g->link.txMsg(g->link.linkPtr, req, PDELAY_SIZE, true);
+    }
+}
+
+void gptpInit(GPTP *g)
+{
+    GPTP_LINK link = g->link;
+    uint8_t clockIdentity[8];
+
+    memcpy(clockIdentity, g->clockIdentity, sizeof(clockIdentity));
+    memset(g, 0, sizeof(*g));
+    memcpy(g->clockIdentity, clockIdentity, sizeof(clockIdentity));
+    g->link = link;
+}
+
+bool gptpLocked(GPTP *g)
+{
+    return(g->stats.locked);
+}
+
+void gptpGetStats(GPTP *g, GPTP_STATS *stats)
+{
+    *stats = g->stats;
+}
+
+void gptpResetStats(GPTP *g)
+{
+    g->stats.offsetMax = 0;
+    g->stats.syncs = 0;
+    g->stats.steps = 0;
+    g->stats.timeouts = 0;
+    g->stats.pdelays = 0;
+    g->stats.pdelayErrors = 0;
+}
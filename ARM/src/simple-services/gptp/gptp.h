@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2022 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _gptp_h
+#define _gptp_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * IEEE 802.1AS slave-only time-aware end station.
+ *
+ * The local timestamp clock is never adjusted.  Instead the servo
+ * maintains a software mapping from local time to grandmaster time
+ * which can be read from any context with gptpLocalToMaster().  All
+ * times are nanoseconds.
+ */
+#define GPTP_ETHTYPE       (0x88F7)
+#define GPTP_MAX_MSG_SIZE  (128)
+
+/*
+ * Link layer used by the protocol.
+ *   txMsg - Sends a PTP message (starting at the PTP header) to the
+ *           802.1AS multicast address.  When 'timestamp' is true the
+ *           transmit time must later be reported by gptpTxTimestamp().
+ */
+typedef struct GPTP_LINK {
+    int (*txMsg)(void *linkPtr, uint8_t *msg, unsigned len, bool timestamp);
+    void *linkPtr;
+} GPTP_LINK;
+
+typedef struct GPTP_PORT_ID {
+    uint8_t clockIdentity[8];
+    uint16_t portNumber;
+} GPTP_PORT_ID;
+
+typedef enum GPTP_SERVO_STATE {
+    GPTP_SERVO_INIT = 0,
+    GPTP_SERVO_STEPPED,
+    GPTP_SERVO_TRACKING
+} GPTP_SERVO_STATE;
+
+/* Local to grandmaster time mapping */
+typedef struct GPTP_MAP {
+    uint64_t localBase;
+    uint64_t masterBase;
+    int32_t ratePpb;
+} GPTP_MAP;
+
+typedef struct GPTP_STATS {
+    bool locked;
+    bool asCapable;
+    int32_t offset;
+    int32_t offsetMax;
+    int32_t ratePpb;
+    uint32_t meanPathDelay;
+    unsigned syncs;
+    unsigned locks;
+    unsigned steps;
+    unsigned timeouts;
+    unsigned pdelays;
+    unsigned pdelayErrors;
+} GPTP_STATS;
+
+typedef struct GPTP {
+    /* Configuration */
+    uint8_t clockIdentity[8];
+    GPTP_LINK link;
+
+    /* Selected master */
+    bool masterValid;
+    GPTP_PORT_ID masterPort;
+    uint8_t masterVector[14];
+    uint8_t gmIdentity[8];
+    uint64_t announceTime;
+
+    /* Sync/Follow_Up */
+    bool syncValid;
+    uint16_t syncSeq;
+    uint64_t syncRx;
+    uint64_t lastSyncTime;
+
+    /* Servo */
+    GPTP_SERVO_STATE servo;
+    uint64_t prevLocal;
+    uint64_t prevMaster;
+    int64_t drift;
+    unsigned goodSyncs;
+
+    /* Double buffered so readers never see a partial update */
+    GPTP_MAP map[2];
+    volatile unsigned mapIdx;
+
+    /* Peer delay initiator */
+    uint16_t pdelaySeq;
+    uint8_t pdelayHave;
+    uint64_t pdelayT1;
+    uint64_t pdelayT2;
+    uint64_t pdelayT3;
+    uint64_t pdelayT4;
+    uint64_t pdelayTime;
+    bool pdelayValid;
+
+    /* Peer delay responder */
+    GPTP_PORT_ID respPort;
+    uint16_t respSeq;
+    bool respPending;
+
+    GPTP_STATS stats;
+} GPTP;
+
+void gptpInit(GPTP *g);
+
+/*
+ * Offers a received Ethernet frame (starting at the destination MAC)
+ * with its local receive timestamp.  General messages are not
+ * timestamped by the MAC, pass the current local time for them.
+ */
+void gptpRecvFrame(GPTP *g, uint8_t *frame, unsigned len, uint64_t rxTime);
+
+/* Reports the local transmit time of a frame sent with a timestamp */
+void gptpTxTimestamp(GPTP *g, uint8_t *frame, unsigned len, uint64_t txTime);
+
+/* Runs timeouts and the peer delay initiator, call every ~100ms */
+void gptpPoll(GPTP *g, uint64_t now);
+
+/*
+ * Converts local time to grandmaster time.  Safe from ISR context.
+ * Returns false (and 'local') until the servo has a mapping.
+ */
+bool gptpLocalToMaster(GPTP *g, uint64_t local, uint64_t *master);
+
+bool gptpLocked(GPTP *g);
+void gptpGetStats(GPTP *g, GPTP_STATS *stats);
+void gptpResetStats(GPTP *g);
+
+#endif
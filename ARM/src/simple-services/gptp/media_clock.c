@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2022 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * See F. Adriaensen, "Using a DLL to filter time".  The loop gains are
+ * b = 1/16 and c = 1/512, roughly a bandwidth of 1/140th of the block
+ * rate with critical damping.  The period is kept in Q16 nanoseconds.
+ *
+ * The loop period still carries some of the input jitter so the
+ * reported rate is measured from filtered block times over a longer
+ * window instead.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "media_clock.h"
+
+#define MEDIA_CLOCK_B_SHIFT   (4)
+#define MEDIA_CLOCK_C_SHIFT   (9)
+#define MEDIA_CLOCK_RESYNC    (4)
+#define MEDIA_CLOCK_RATE_BLOCKS (1024)
+
+void mediaClockInit(MEDIA_CLOCK *mc, unsigned sampleRate, unsigned frames)
+{
+    memset(mc, 0, sizeof(*mc));
+    mc->period = (uint32_t)(((uint64_t)frames * 1000000000ULL) / sampleRate);
+}
+
+uint64_t mediaClockUpdate(MEDIA_CLOCK *mc, uint64_t now)
+{
+    int64_t e = 0;
+    int64_t elapsed;
+    int64_t nominal;
+
+    if (mc->valid) {
+        e = (int64_t)(now - mc->t1);
+        if ((e > (int64_t)mc->period * MEDIA_CLOCK_RESYNC) ||
+            (e < -(int64_t)mc->period * MEDIA_CLOCK_RESYNC)) {
+            mc->valid = false;
+            mc->resyncs++;
+        }
+    }
+
+    if (!mc->valid) {
+        mc->e2 = (int64_t)mc->period << 16;
+        mc->t0 = now;
+        mc->t1 = now + mc->period;
+        mc->valid = true;
+        mc->rateBase = now;
+        mc->rateBlocks = 0;
+        mc->ratePpb = 0;
+        return(mc->t0);
+    }
+
+    mc->t0 = mc->t1;
+    mc->t1 += (e >> MEDIA_CLOCK_B_SHIFT) + (mc->e2 >> 16);
+    mc->e2 += (e << 16) >> MEDIA_CLOCK_C_SHIFT;
+
+    if (++mc->rateBlocks == MEDIA_CLOCK_RATE_BLOCKS) {
+        elapsed = (int64_t)(mc->t0 - mc->rateBase);
+        nominal = (int64_t)mc->period * MEDIA_CLOCK_RATE_BLOCKS;
+        mc->ratePpb = (int32_t)(((nominal - elapsed) * 1000000000LL) / elapsed);
+        mc->rateBase = mc->t0;
+        mc->rateBlocks = 0;
+    }
+
+    return(mc->t0);
+}
+
+uint64_t mediaClockNext(MEDIA_CLOCK *mc)
+{
+    return(mc->t1);
+}
+
+int32_t mediaClockRatePpb(MEDIA_CLOCK *mc)
+{
+    return(mc->valid ? mc->ratePpb : 0);
+}
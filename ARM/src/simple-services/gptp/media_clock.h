@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) 2022 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _media_clock_h
+#define _media_clock_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Second order delay-locked loop that follows an audio clock in gPTP
+ * time.  It is updated once per audio block with the (jittery) time
+ * the block completed and produces smoothed block times plus the
+ * audio clock's rate against gPTP.  Integer only so it can run in the
+ * audio ISR.
+ */
+typedef struct MEDIA_CLOCK {
+    bool valid;
+    uint32_t period;
+    uint64_t t0;
+    uint64_t t1;
+    int64_t e2;
+    uint64_t rateBase;
+    unsigned rateBlocks;
+    int32_t ratePpb;
+    unsigned resyncs;
+} MEDIA_CLOCK;
+
+void mediaClockInit(MEDIA_CLOCK *mc, unsigned sampleRate, unsigned frames);
+
+/*
+ * Updates the loop with the time a block completed and returns the
+ * filtered completion time.  Restarts the loop when 'now' is more than
+ * a few blocks off the prediction.
+ */
+uint64_t mediaClockUpdate(MEDIA_CLOCK *mc, uint64_t now);
+
+/* Predicted completion time of the next block */
+uint64_t mediaClockNext(MEDIA_CLOCK *mc);
+
+/*
+ * Audio clock rate relative to nominal in parts per billion, negative
+ * when slow.  Updated every 1024 blocks.
+ */
+int32_t mediaClockRatePpb(MEDIA_CLOCK *mc);
+
+#endif
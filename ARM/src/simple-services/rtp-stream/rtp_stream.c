@@ -11,8 +11,14 @@
 
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 
-#include "compat/posix/sys/socket.h"
+#include "lwip/def.h"
+#include "lwip/pbuf.h"
+#include "lwip/udp.h"
+#include "lwip/igmp.h"
+#include "lwip/ip.h"
+#include "lwip/tcpip.h"
 
 #include "rtp_stream_cfg.h"
 #include "rtp_stream.h"
@@ -39,12 +45,184 @@ typedef struct _RTP_PKT_HDR {
 #define RTP_MAX_PACKET_SIZE  (1472)
 #define RTP_MAX_PAYLOAD_SIZE (RTP_MAX_PACKET_SIZE - sizeof(RTP_PKT_HDR))
 
+/*
+ * Rx streams are demultiplexed from a single pcb per UDP port so that
+ * several senders, multicast groups or SSRCs can share one port.  The
+ * port and stream lists are only touched with the lwIP core locked.
+ */
+typedef struct _RTP_RX_PORT {
+    struct udp_pcb *pcb;
+    u16_t port;
+    RTP_STREAM *streams;
+    struct _RTP_RX_PORT *next;
+} RTP_RX_PORT;
+
+static RTP_RX_PORT *rtpRxPorts = NULL;
+
+static bool rtpRxMatch(RTP_STREAM *rs, RTP_PKT_HDR *hdr,
+    const ip_addr_t *addr)
+{
+    if (ip_addr_ismulticast(&rs->ipAddr)) {
+        if (!ip_addr_cmp(&rs->ipAddr, ip_current_dest_addr())) {
+            return(false);
+        }
+    } else if (!ip_addr_isany(&rs->ipAddr)) {
+        if (!ip_addr_cmp(&rs->ipAddr, addr)) {
+            return(false);
+        }
+    }
+
+    if (rs->ssrc && (lwip_ntohl(hdr->ssrc) != rs->ssrc)) {
+        return(false);
+    }
+
+    return(true);
+}
+
+/*
+ * Receive callback (lwIP core locked).  The payload is handed to each
+ * matching stream straight out of the zero-copy Rx pbuf.  Chained
+ * pbufs are rare (jumbo or reassembled datagrams) and are flattened
+ * into the first stream's packet buffer first.
+ */
+static void rtpRecv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+    const ip_addr_t *addr, u16_t port)
+{
+    RTP_RX_PORT *rp = (RTP_RX_PORT *)arg;
+    RTP_STREAM *rs;
+    RTP_PKT_HDR *hdr;
+    unsigned size;
+    unsigned samples;
+
+    size = p->tot_len;
+    if ((size < sizeof(*hdr)) || (size > RTP_MAX_PACKET_SIZE)) {
+        goto abort;
+    }
+
+    if (rp->streams == NULL) {
+        goto abort;
+    }
+
+    if (p->len == p->tot_len) {
+        hdr = (RTP_PKT_HDR *)p->payload;
+    } else {
+        pbuf_copy_partial(p, rp->streams->pkt, size, 0);
+        hdr = (RTP_PKT_HDR *)rp->streams->pkt;
+    }
+
+    for (rs = rp->streams; rs != NULL; rs = rs->next) {
+        if (!rtpRxMatch(rs, hdr, addr)) {
+            continue;
+        }
+        rs->size = size;
+        rs->sequence = lwip_ntohs(hdr->sequence);
+        rs->timeStamp = lwip_ntohl(hdr->timeStamp);
+        rs->maxSamples = (size - sizeof(*hdr)) / rs->wordSizeBytes;
+        rs->maxFrames = rs->maxSamples / rs->channels;
+        samples = rs->maxFrames * rs->channels;
+        if (samples && rs->rxCallback) {
+            rs->rxCallback(rs, hdr->data, samples, rs->usrPtr);
+        }
+    }
+
+abort:
+    pbuf_free(p);
+}
+
+/* Joins the stream to its port (and multicast group), core locked */
+static bool rtpRxAttach(RTP_STREAM *rs)
+{
+    RTP_RX_PORT *rp;
+    bool ok = true;
+    err_t err;
+
+    if (ip_addr_ismulticast(&rs->ipAddr)) {
+        err = igmp_joingroup(IP4_ADDR_ANY4, ip_2_ip4(&rs->ipAddr));
+        if (err != ERR_OK) {
+            return(false);
+        }
+    }
+
+    for (rp = rtpRxPorts; rp != NULL; rp = rp->next) {
+        if (rp->port == rs->port) {
+            break;
+        }
+    }
+
+    if (rp == NULL) {
+        rp = RTP_MALLOC(sizeof(*rp));
+        ok = (rp != NULL);
+        if (ok) {
+            memset(rp, 0, sizeof(*rp));
+            rp->port = rs->port;
+            rp->pcb = udp_new();
+            ok = (rp->pcb != NULL);
+        }
+        if (ok) {
+            err = udp_bind(rp->pcb, IP_ADDR_ANY, rp->port);
+            ok = (err == ERR_OK);
+        }
+        if (ok) {
+            udp_recv(rp->pcb, rtpRecv, rp);
+            rp->next = rtpRxPorts;
+            rtpRxPorts = rp;
+        } else {
+            if (rp) {
+                if (rp->pcb) {
+                    udp_remove(rp->pcb);
+                }
+                RTP_FREE(rp);
+            }
+            if (ip_addr_ismulticast(&rs->ipAddr)) {
+                igmp_leavegroup(IP4_ADDR_ANY4, ip_2_ip4(&rs->ipAddr));
+            }
+            return(false);
+        }
+    }
+
+    rs->next = rp->streams;
+    rp->streams = rs;
+    rs->rxPort = rp;
+
+    return(true);
+}
+
+/* Removes the stream from its port, releasing the port when idle */
+static void rtpRxDetach(RTP_STREAM *rs)
+{
+    RTP_RX_PORT *rp = (RTP_RX_PORT *)rs->rxPort;
+    RTP_RX_PORT **prp;
+    RTP_STREAM **prs;
+
+    for (prs = &rp->streams; *prs != NULL; prs = &(*prs)->next) {
+        if (*prs == rs) {
+            *prs = rs->next;
+            break;
+        }
+    }
+    rs->next = NULL;
+    rs->rxPort = NULL;
+
+    if (ip_addr_ismulticast(&rs->ipAddr)) {
+        igmp_leavegroup(IP4_ADDR_ANY4, ip_2_ip4(&rs->ipAddr));
+    }
+
+    if (rp->streams == NULL) {
+        for (prp = &rtpRxPorts; *prp != NULL; prp = &(*prp)->next) {
+            if (*prp == rp) {
+                *prp = rp->next;
+                break;
+            }
+        }
+        udp_remove(rp->pcb);
+        RTP_FREE(rp);
+    }
+}
+
 bool openRtpStream(RTP_STREAM *rs)
 {
-    struct sockaddr_in srcAddr;
     RTP_PKT_HDR *hdr;
     bool ok = false;
-    int ret;
 
     if (rs->ipStr == NULL) {
         return(false);
@@ -54,51 +232,27 @@ bool openRtpStream(RTP_STREAM *rs)
         return(false);
     }
 
-    memset(&rs->ipAddr, 0, sizeof(rs->ipAddr));
-    rs->ipAddr.sin_family = AF_INET;
-    rs->ipAddr.sin_len = sizeof(rs->ipAddr);
-    ok = inet_aton(rs->ipStr, &rs->ipAddr.sin_addr.s_addr);
+    ok = ipaddr_aton(rs->ipStr, &rs->ipAddr);
     if (!ok) {
         goto abort;
     }
-    rs->ipAddr.sin_port = htons(rs->port);
 
-    rs->socket = socket(AF_INET, SOCK_DGRAM, 0);
-    ok = (rs->socket >= 0);
+    rs->pkt = RTP_MALLOC(RTP_MAX_PACKET_SIZE);
+    ok = (rs->pkt != NULL);
     if (!ok) {
         goto abort;
     }
-
-    if (rs->isRx) {
-        memset(&srcAddr, 0, sizeof(srcAddr));
-        srcAddr.sin_family = AF_INET;
-        srcAddr.sin_len = sizeof(srcAddr);
-        srcAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-        srcAddr.sin_port = htons(rs->port);
-
-        ret = bind(rs->socket, (struct sockaddr *)&srcAddr, sizeof(srcAddr));
-        ok = (ret == 0);
-        if (!ok) {
-            goto abort;
-        }
-    }
-
-    rs->pkt = RTP_MALLOC(RTP_MAX_PACKET_SIZE);
     memset(rs->pkt, 0, RTP_MAX_PACKET_SIZE);
 
     hdr = (RTP_PKT_HDR *)rs->pkt;
     rs->data = hdr->data;
 
     if (rs->isRx) {
-        struct timeval tv;
-        tv.tv_sec = 0;
-        tv.tv_usec = 100000;
-        setsockopt(rs->socket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof tv);
         rs->preRoll = true;
     } else {
         hdr->flags = 0x80;
         hdr->type = 96;
-        hdr->ssrc = htonl(rand());
+        hdr->ssrc = lwip_htonl(rs->ssrc ? rs->ssrc : rand());
         rs->sequence = rand();
         rs->timeStamp = 0;
         rs->maxSamples = (RTP_MAX_PACKET_SIZE - sizeof(*hdr)) / rs->wordSizeBytes;
@@ -110,9 +264,19 @@ bool openRtpStream(RTP_STREAM *rs)
     rs->samples = 0;
     rs->enabled = true;
 
-    ok = true;
+    LOCK_TCPIP_CORE();
+    if (rs->isRx) {
+        ok = rtpRxAttach(rs);
+    } else {
+        rs->pcb = udp_new();
+        ok = (rs->pcb != NULL);
+    }
+    UNLOCK_TCPIP_CORE();
 
 abort:
+    if (!ok) {
+        closeRtpStream(rs);
+    }
     return(ok);
 }
 
@@ -124,31 +288,36 @@ unsigned rtpWriteSamplesAvailable(RTP_STREAM *rs, void **data)
     return(rs->maxSamples - rs->samples);
 }
 
+/*
+ * The packet buffer is referenced (PBUF_REF) rather than copied into
+ * a new pbuf.  lwIP is done with it once udp_sendto() returns; the
+ * netif copies it out and ARP clones anything it must queue.
+ */
+static void rtpSendPkt(RTP_STREAM *rs)
+{
+    struct pbuf *p;
+
+    LOCK_TCPIP_CORE();
+    p = pbuf_alloc(PBUF_TRANSPORT, rs->size, PBUF_REF);
+    if (p) {
+        p->payload = rs->pkt;
+        udp_sendto(rs->pcb, p, &rs->ipAddr, rs->port);
+        pbuf_free(p);
+    }
+    UNLOCK_TCPIP_CORE();
+}
+
 unsigned rtpWriteSamples(RTP_STREAM *rs, unsigned samples)
 {
     RTP_PKT_HDR *hdr = (RTP_PKT_HDR *)rs->pkt;
-    uint16_t *u16;
-    uint32_t *u32;
-    unsigned i;
 
     rs->samples += samples;
     rs->data += samples * rs->wordSizeBytes;
 
     if (rs->samples == rs->maxSamples) {
-        hdr->sequence = htons(rs->sequence);
-        hdr->timeStamp = htonl(rs->timeStamp);
-        if (rs->wordSizeBytes == 2) {
-            u16 = (uint16_t *)hdr->data;
-            for (i = 0; i < rs->maxSamples; i++) {
-                *u16 = htons(*u16); u16++;
-            }
-        } else {
-            u32 = (uint32_t *)hdr->data;
-            for (i = 0; i < rs->maxSamples; i++) {
-                *u32 = htonl(*u32); u32++;
-            }
-        }
-        sendto(rs->socket, hdr, rs->size, 0, (struct sockaddr *)&rs->ipAddr, sizeof(rs->ipAddr));
+        hdr->sequence = lwip_htons(rs->sequence);
+        hdr->timeStamp = lwip_htonl(rs->timeStamp);
+        rtpSendPkt(rs);
         rs->data = hdr->data;
         rs->samples = 0;
         rs->sequence += 1;
@@ -158,68 +327,22 @@ unsigned rtpWriteSamples(RTP_STREAM *rs, unsigned samples)
     return(samples);
 }
 
-unsigned rtpReadSamplesAvailable(RTP_STREAM *rs, void **data)
-{
-    RTP_PKT_HDR *hdr = (RTP_PKT_HDR *)rs->pkt;
-    ssize_t size = 0;
-    uint16_t *u16;
-    uint32_t *u32;
-    unsigned i;
-
-    if (rs->samples == 0) {
-        socklen_t addrLen = sizeof(rs->ipAddr);
-        size = recvfrom(
-            rs->socket, rs->pkt, RTP_MAX_PACKET_SIZE, 0,
-            (struct sockaddr *)&rs->ipAddr, &addrLen
-        );
-        if (size < (ssize_t)sizeof(*hdr)) {
-            return(0);
-        }
-        rs->size = (unsigned)size;
-        rs->data = hdr->data;
-        rs->maxSamples = (rs->size - sizeof(*hdr)) / rs->wordSizeBytes;
-        rs->maxFrames = rs->maxSamples / rs->channels;
-        rs->samples = rs->maxFrames * rs->channels;
-        if (rs->maxFrames == 0) {
-            return(0);
-        }
-        if (rs->wordSizeBytes == 2) {
-            u16 = (uint16_t *)hdr->data;
-            for (i = 0; i < rs->maxSamples; i++) {
-                *u16 = ntohs(*u16); u16++;
-            }
-        } else {
-            u32 = (uint32_t *)hdr->data;
-            for (i = 0; i < rs->maxSamples; i++) {
-                *u32 = ntohl(*u32); u32++;
-            }
-        }
-
-    }
-
-    if (data) {
-        *data = (void *)rs->data;
-    }
-
-    return(rs->samples);
-}
-
-unsigned rtpReadSamples(RTP_STREAM *rs, unsigned samples)
-{
-    rs->samples -= samples;
-    rs->data += samples * rs->wordSizeBytes;
-    return(rs->samples);
-}
-
 void closeRtpStream(RTP_STREAM *rs)
 {
-    if (rs->socket >= 0) {
-        lwip_close(rs->socket);
+    if (rs->rxPort) {
+        LOCK_TCPIP_CORE();
+        rtpRxDetach(rs);
+        UNLOCK_TCPIP_CORE();
     }
+    if (rs->pcb) {
+        LOCK_TCPIP_CORE();
+        udp_remove(rs->pcb);
+        UNLOCK_TCPIP_CORE();
+        rs->pcb = NULL;
+    }
+    rs->enabled = false;
     if (rs->pkt) {
         RTP_FREE(rs->pkt);
         rs->pkt = NULL;
     }
-    rs->socket = -1;
-    rs->enabled = false;
 }
@@ -16,7 +16,19 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-#include "compat/posix/sys/socket.h"
+#include "lwip/ip_addr.h"
+#include "lwip/udp.h"
+
+struct RTP_STREAM;
+
+/*
+ * Rx payload callback.  Called from the lwIP receive context (core
+ * locked) with 'samples' whole frames of network order audio.  'data'
+ * points directly into the received packet and is only valid for the
+ * duration of the call.
+ */
+typedef void (*RTP_RX_CALLBACK)(struct RTP_STREAM *rs, void *data,
+    unsigned samples, void *usrPtr);
 
 typedef struct RTP_STREAM {
     bool enabled;
@@ -24,10 +36,10 @@ typedef struct RTP_STREAM {
     unsigned channels;
     unsigned wordSizeBytes;
     bool isRx;
-    int socket;
+    struct udp_pcb *pcb;
     int port;
     char *ipStr;
-    struct sockaddr_in ipAddr;
+    ip_addr_t ipAddr;
     void *pkt;
     uint8_t *data;
     uint32_t timeStamp;
@@ -37,16 +49,28 @@ typedef struct RTP_STREAM {
     unsigned maxSamples;
     unsigned maxFrames;
     bool preRoll;
+    uint32_t ssrc;
+    RTP_RX_CALLBACK rxCallback;
+    void *usrPtr;
+    void *rxPort;
+    struct RTP_STREAM *next;
 } RTP_STREAM;
 
+/*
+ * Any number of Rx streams may share a UDP port.  Packets are fanned
+ * out to every stream whose filters match:
+ *   ipStr - Multicast group to join, unicast sender, or "0.0.0.0"
+ *   ssrc  - Sender SSRC, zero accepts all.  Sent as-is for Tx when
+ *           non-zero, otherwise a random SSRC is used.
+ */
 bool openRtpStream(RTP_STREAM *rs);
 void closeRtpStream(RTP_STREAM *rs);
 
+/*
+ * Tx samples must be written in network byte order.  The packet is
+ * sent as soon as it is full.
+ */
 unsigned rtpWriteSamplesAvailable(RTP_STREAM *rs, void **data);
 unsigned rtpWriteSamples(RTP_STREAM *rs, unsigned samples);
 
-unsigned rtpReadPkt(RTP_STREAM *rs);
-unsigned rtpReadSamplesAvailable(RTP_STREAM *rs, void **data);
-unsigned rtpReadSamples(RTP_STREAM *rs, unsigned samples);
-
 #endif
@@ -0,0 +1,469 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <sys/platform.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "sched_trace.h"
+#include "clocks.h"
+#include "umm_malloc.h"
+
+/* Chrome trace thread IDs */
+#define SCHED_TRACE_PID          (1)
+#define SCHED_TRACE_ISR_TID      (1)
+#define SCHED_TRACE_UNKNOWN_TID  (2)
+#define SCHED_TRACE_TASK_TID(i)  (3 + (i))
+
+/* Export task index before the first switch in (-1 is an unknown task) */
+#define SCHED_TRACE_NO_TASK      (-2)
+
+typedef struct SCHED_TRACE_ENTRY {
+    uint32_t timestamp;
+    uint32_t event;
+    uint32_t arg0;
+    uint32_t arg1;
+} SCHED_TRACE_ENTRY;
+
+typedef struct SCHED_TRACE_TASK {
+    void *task;
+    bool deleted;
+    char name[configMAX_TASK_NAME_LEN];
+} SCHED_TRACE_TASK;
+
+/* Per-task export state */
+typedef struct SCHED_TRACE_EXPORT_TASK {
+    SCHED_TRACE_TASK t;
+    uint32_t flowId;
+} SCHED_TRACE_EXPORT_TASK;
+
+typedef struct SCHED_TRACE_EXPORT {
+    FILE *f;
+    SCHED_TRACE_EXPORT_TASK *tasks;
+    unsigned numTasks;
+    uint64_t now;
+    int curTask;
+    uint64_t curStart;
+    uint32_t curPrio;
+    unsigned isrDepth;
+    uint32_t flowId;
+} SCHED_TRACE_EXPORT;
+
+volatile uint32_t schedTraceRunning = 0;
+
+static SCHED_TRACE_ENTRY *schedRing = NULL;
+static volatile uint32_t schedHead = 0;
+static SCHED_TRACE_TASK schedTasks[SCHED_TRACE_MAX_TASKS];
+
+static const char *coreNames[] = {
+    "ARM", "SHARC0", "SHARC1"
+};
+
+/***********************************************************************
+ * Recording
+ **********************************************************************/
+void sched_trace_record(SCHED_TRACE_EVENT event, uint32_t arg0, uint32_t arg1)
+{
+    SCHED_TRACE_ENTRY *e;
+    uint32_t idx;
+
+    idx = __atomic_fetch_add(&schedHead, 1, __ATOMIC_RELAXED);
+    e = &schedRing[idx & (SCHED_TRACE_ENTRIES - 1)];
+
+    e->timestamp = SCHED_TRACE_TIMESTAMP();
+    e->event = event;
+    e->arg0 = arg0;
+    e->arg1 = arg1;
+}
+
+/* Called with the scheduler in a critical section */
+void sched_trace_task_create(void *task, const char *name)
+{
+    SCHED_TRACE_TASK *slot = NULL;
+    unsigned i;
+
+    /* Reuse this task's old slot, else an empty one, else a deleted one */
+    for (i = 0; i < SCHED_TRACE_MAX_TASKS; i++) {
+        if (schedTasks[i].task == task) {
+            slot = &schedTasks[i];
+            break;
+        }
+        if ((slot == NULL) && (schedTasks[i].task == NULL)) {
+            slot = &schedTasks[i];
+        }
+    }
+    for (i = 0; (slot == NULL) && (i < SCHED_TRACE_MAX_TASKS); i++) {
+        if (schedTasks[i].deleted) {
+            slot = &schedTasks[i];
+        }
+    }
+    if (slot == NULL) {
+        return;
+    }
+
+    slot->task = task;
+    slot->deleted = false;
+    strncpy(slot->name, name, sizeof(slot->name) - 1);
+    slot->name[sizeof(slot->name) - 1] = '\0';
+}
+
+/* Called with the scheduler in a critical section */
+void sched_trace_task_delete(void *task)
+{
+    unsigned i;
+
+    for (i = 0; i < SCHED_TRACE_MAX_TASKS; i++) {
+        if (schedTasks[i].task == task) {
+            schedTasks[i].deleted = true;
+            break;
+        }
+    }
+}
+
+/***********************************************************************
+ * Capture control
+ **********************************************************************/
+bool sched_trace_start(void)
+{
+    if (schedRing == NULL) {
+        schedRing = SCHED_TRACE_MALLOC(
+            SCHED_TRACE_ENTRIES * sizeof(SCHED_TRACE_ENTRY));
+        if (schedRing == NULL) {
+            return(false);
+        }
+    }
+
+    schedTraceRunning = 0;
+    schedHead = 0;
+    schedTraceRunning = 1;
+
+    return(true);
+}
+
+void sched_trace_stop(void)
+{
+    if (schedTraceRunning) {
+        schedTraceRunning = 0;
+        /* Let any writer already past the running check finish */
+        vTaskDelay(pdMS_TO_TICKS(2));
+    }
+}
+
+void sched_trace_status(SCHED_TRACE_STATUS *status)
+{
+    uint32_t head = schedHead;
+    unsigned i;
+
+    status->running = (schedTraceRunning != 0);
+    status->events = (head < SCHED_TRACE_ENTRIES) ?
+        head : SCHED_TRACE_ENTRIES;
+    status->capacity = SCHED_TRACE_ENTRIES;
+    status->tasks = 0;
+    for (i = 0; i < SCHED_TRACE_MAX_TASKS; i++) {
+        if (schedTasks[i].task) {
+            status->tasks++;
+        }
+    }
+}
+
+/***********************************************************************
+ * Chrome trace export
+ **********************************************************************/
+static void sched_trace_fmt_ts(char *buf, size_t max, uint64_t ticks)
+{
+    uint64_t sec = ticks / SCHED_TRACE_TIMESTAMP_HZ;
+    uint64_t rem = ticks % SCHED_TRACE_TIMESTAMP_HZ;
+    uint64_t ns;
+
+    ns = sec * 1000000000ULL +
+        (rem * 1000000000ULL) / SCHED_TRACE_TIMESTAMP_HZ;
+
+    snprintf(buf, max, "%lu.%03u",
+        (unsigned long)(ns / 1000), (unsigned)(ns % 1000));
+}
+
+static int sched_trace_task_idx(SCHED_TRACE_EXPORT *x, uint32_t task)
+{
+    unsigned i;
+
+    for (i = 0; i < x->numTasks; i++) {
+        if ((uint32_t)(uintptr_t)x->tasks[i].t.task == task) {
+            return(i);
+        }
+    }
+    return(-1);
+}
+
+static unsigned sched_trace_tid(int taskIdx)
+{
+    return((taskIdx < 0) ? SCHED_TRACE_UNKNOWN_TID :
+        SCHED_TRACE_TASK_TID(taskIdx));
+}
+
+static const char *sched_trace_name(SCHED_TRACE_EXPORT *x, int taskIdx)
+{
+    return((taskIdx < 0) ? "Unknown" : x->tasks[taskIdx].t.name);
+}
+
+/* Thread of whatever was running when an event was recorded */
+static unsigned sched_trace_ctx_tid(SCHED_TRACE_EXPORT *x)
+{
+    return(x->isrDepth ? SCHED_TRACE_ISR_TID : sched_trace_tid(x->curTask));
+}
+
+static void sched_trace_instant(SCHED_TRACE_EXPORT *x, unsigned tid,
+    const char *name, const char *args)
+{
+    char ts[24];
+
+    sched_trace_fmt_ts(ts, sizeof(ts), x->now);
+    fprintf(x->f,
+        ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%u,"
+        "\"tid\":%u,\"ts\":%s,\"args\":{%s}}",
+        name, SCHED_TRACE_PID, tid, ts, args);
+}
+
+static void sched_trace_flow(SCHED_TRACE_EXPORT *x, unsigned tid,
+    uint32_t id, bool start)
+{
+    char ts[24];
+
+    sched_trace_fmt_ts(ts, sizeof(ts), x->now);
+    fprintf(x->f,
+        ",\n{\"name\":\"wake\",\"cat\":\"notify\",\"ph\":\"%s\",\"id\":%u,"
+        "\"pid\":%u,\"tid\":%u,\"ts\":%s%s}",
+        start ? "s" : "f", (unsigned)id, SCHED_TRACE_PID, tid, ts,
+        start ? "" : ",\"bp\":\"e\"");
+}
+
+/* Closes the running task's slice at the current time */
+static void sched_trace_task_out(SCHED_TRACE_EXPORT *x)
+{
+    char ts[24];
+    char dur[24];
+
+    if (x->curTask == SCHED_TRACE_NO_TASK) {
+        return;
+    }
+
+    sched_trace_fmt_ts(ts, sizeof(ts), x->curStart);
+    sched_trace_fmt_ts(dur, sizeof(dur),
+        (x->now > x->curStart) ? x->now - x->curStart : 0);
+    fprintf(x->f,
+        ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,"
+        "\"ts\":%s,\"dur\":%s,\"args\":{\"priority\":%u}}",
+        sched_trace_name(x, x->curTask), SCHED_TRACE_PID,
+        sched_trace_tid(x->curTask), ts, dur, (unsigned)x->curPrio);
+}
+
+static void sched_trace_isr_exit(SCHED_TRACE_EXPORT *x)
+{
+    char ts[24];
+
+    /* Unmatched if the entry was overwritten by the ring */
+    if (x->isrDepth == 0) {
+        return;
+    }
+
+    sched_trace_fmt_ts(ts, sizeof(ts), x->now);
+    fprintf(x->f,
+        ",\n{\"ph\":\"E\",\"pid\":%u,\"tid\":%u,\"ts\":%s}",
+        SCHED_TRACE_PID, SCHED_TRACE_ISR_TID, ts);
+    x->isrDepth--;
+}
+
+static void sched_trace_event(SCHED_TRACE_EXPORT *x, SCHED_TRACE_ENTRY *e)
+{
+    char args[64];
+    char name[48];
+    char ts[24];
+    int idx;
+
+    switch (e->event) {
+        case SCHED_TRACE_TASK_IN:
+            sched_trace_task_out(x);
+            x->curTask = sched_trace_task_idx(x, e->arg0);
+            x->curStart = x->now;
+            x->curPrio = e->arg1;
+            if ((x->curTask >= 0) && x->tasks[x->curTask].flowId) {
+                sched_trace_flow(x, sched_trace_tid(x->curTask),
+                    x->tasks[x->curTask].flowId, false);
+                x->tasks[x->curTask].flowId = 0;
+            }
+            break;
+        case SCHED_TRACE_ISR_ENTER:
+            sched_trace_fmt_ts(ts, sizeof(ts), x->now);
+            fprintf(x->f,
+                ",\n{\"name\":\"IRQ %u\",\"ph\":\"B\",\"pid\":%u,"
+                "\"tid\":%u,\"ts\":%s}",
+                (unsigned)e->arg0, SCHED_TRACE_PID, SCHED_TRACE_ISR_TID, ts);
+            x->isrDepth++;
+            break;
+        case SCHED_TRACE_ISR_EXIT:
+            sched_trace_isr_exit(x);
+            break;
+        case SCHED_TRACE_NOTIFY:
+            idx = sched_trace_task_idx(x, e->arg0);
+            snprintf(args, sizeof(args), "\"task\":\"%s\",\"index\":%u",
+                sched_trace_name(x, idx), (unsigned)e->arg1);
+            sched_trace_instant(x, sched_trace_ctx_tid(x), "notify", args);
+            /* Arrow from the notifier to the task's next switch in */
+            if ((idx >= 0) && ((idx != x->curTask) || x->isrDepth)) {
+                x->flowId++;
+                sched_trace_flow(x, sched_trace_ctx_tid(x), x->flowId, true);
+                x->tasks[idx].flowId = x->flowId;
+            }
+            break;
+        case SCHED_TRACE_NOTIFY_WAIT:
+            snprintf(args, sizeof(args), "\"index\":%u", (unsigned)e->arg0);
+            sched_trace_instant(x, sched_trace_tid(x->curTask),
+                "notify wait", args);
+            break;
+        case SCHED_TRACE_PRIORITY_INHERIT:
+        case SCHED_TRACE_PRIORITY_DISINHERIT:
+            idx = sched_trace_task_idx(x, e->arg0);
+            snprintf(args, sizeof(args), "\"priority\":%u",
+                (unsigned)e->arg1);
+            sched_trace_instant(x, sched_trace_tid(idx),
+                (e->event == SCHED_TRACE_PRIORITY_INHERIT) ?
+                    "priority inherit" : "priority disinherit", args);
+            break;
+        case SCHED_TRACE_IPC_TX:
+            snprintf(name, sizeof(name), "IPC tx %s",
+                (e->arg0 < (sizeof(coreNames) / sizeof(coreNames[0]))) ?
+                    coreNames[e->arg0] : "?");
+            snprintf(args, sizeof(args), "\"type\":%u", (unsigned)e->arg1);
+            sched_trace_instant(x, sched_trace_ctx_tid(x), name, args);
+            break;
+        case SCHED_TRACE_IPC_RX:
+            snprintf(args, sizeof(args), "\"type\":%u", (unsigned)e->arg0);
+            sched_trace_instant(x, sched_trace_ctx_tid(x), "IPC rx", args);
+            break;
+        default:
+            break;
+    }
+}
+
+static void sched_trace_thread_name(SCHED_TRACE_EXPORT *x, unsigned tid,
+    const char *name)
+{
+    fprintf(x->f,
+        ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,"
+        "\"args\":{\"name\":\"%s\"}}",
+        SCHED_TRACE_PID, tid, name);
+    fprintf(x->f,
+        ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":%u,"
+        "\"tid\":%u,\"args\":{\"sort_index\":%u}}",
+        SCHED_TRACE_PID, tid, tid);
+}
+
+int sched_trace_save(const char *fname)
+{
+    SCHED_TRACE_EXPORT x;
+    SCHED_TRACE_ENTRY *e;
+    char *fbuf = NULL;
+    int result = -1;
+    uint32_t head, first, last, n, i;
+    char *c;
+
+    sched_trace_stop();
+
+    if (schedRing == NULL) {
+        return(-1);
+    }
+
+    memset(&x, 0, sizeof(x));
+    x.curTask = SCHED_TRACE_NO_TASK;
+
+    x.tasks = SCHED_TRACE_MALLOC(
+        SCHED_TRACE_MAX_TASKS * sizeof(*x.tasks));
+    fbuf = SCHED_TRACE_MALLOC(SCHED_TRACE_FILE_BUF_SIZE);
+    x.f = fopen(fname, "w");
+    if ((x.tasks == NULL) || (fbuf == NULL) || (x.f == NULL)) {
+        goto abort;
+    }
+    setvbuf(x.f, fbuf, _IOFBF, SCHED_TRACE_FILE_BUF_SIZE);
+
+    /* Snapshot the task names */
+    taskENTER_CRITICAL();
+    for (i = 0; i < SCHED_TRACE_MAX_TASKS; i++) {
+        if (schedTasks[i].task) {
+            x.tasks[x.numTasks].t = schedTasks[i];
+            x.tasks[x.numTasks].flowId = 0;
+            x.numTasks++;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    /* Keep the JSON valid whatever a task was called */
+    for (i = 0; i < x.numTasks; i++) {
+        for (c = x.tasks[i].t.name; *c; c++) {
+            if ((*c == '"') || (*c == '\\') || (*c < ' ')) {
+                *c = '_';
+            }
+        }
+    }
+
+    fprintf(x.f,
+        "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,"
+        "\"args\":{\"name\":\"ARM\"}}",
+        SCHED_TRACE_PID);
+    sched_trace_thread_name(&x, SCHED_TRACE_ISR_TID, "Interrupts");
+    sched_trace_thread_name(&x, SCHED_TRACE_UNKNOWN_TID, "Unknown");
+    for (i = 0; i < x.numTasks; i++) {
+        sched_trace_thread_name(&x, SCHED_TRACE_TASK_TID(i),
+            x.tasks[i].t.name);
+    }
+
+    head = schedHead;
+    n = (head < SCHED_TRACE_ENTRIES) ? head : SCHED_TRACE_ENTRIES;
+    first = head - n;
+    last = n ? schedRing[first & (SCHED_TRACE_ENTRIES - 1)].timestamp : 0;
+
+    for (i = first; i != head; i++) {
+        e = &schedRing[i & (SCHED_TRACE_ENTRIES - 1)];
+        /* Unwrap, writers racing for a slot can land slightly out of order */
+        if ((int32_t)(e->timestamp - last) > 0) {
+            x.now += e->timestamp - last;
+            last = e->timestamp;
+        }
+        sched_trace_event(&x, e);
+    }
+
+    /* Close whatever was still running */
+    sched_trace_task_out(&x);
+    while (x.isrDepth) {
+        sched_trace_isr_exit(&x);
+    }
+
+    fprintf(x.f, "\n],\"otherData\":{\"events\":%u,\"lost\":%u}}\n",
+        (unsigned)n, (unsigned)(head - n));
+    result = (int)n;
+
+abort:
+    if (x.f) {
+        fclose(x.f);
+    }
+    if (fbuf) {
+        SCHED_TRACE_FREE(fbuf);
+    }
+    if (x.tasks) {
+        SCHED_TRACE_FREE(x.tasks);
+    }
+
+    return(result);
+}
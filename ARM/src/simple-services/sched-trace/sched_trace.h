@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _sched_trace_h
+#define _sched_trace_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sched_trace_cfg.h"
+
+/*
+ * FreeRTOS scheduler and ISR timeline tracer.
+ *
+ * The FreeRTOS trace macros (FreeRTOSConfig.h), the IRQ dispatcher and
+ * the IPC send/receive paths record raw events into an SDRAM ring while
+ * a capture is running.  The ring wraps so a stopped capture holds the
+ * most recent SCHED_TRACE_ENTRIES events.  sched_trace_save() converts
+ * the capture into Chrome trace JSON which loads directly into
+ * chrome://tracing or ui.perfetto.dev.
+ *
+ * This header is included by FreeRTOSConfig.h so it must not include
+ * any FreeRTOS headers.
+ */
+typedef enum SCHED_TRACE_EVENT {
+    SCHED_TRACE_TASK_IN = 0,           /* arg0: task, arg1: priority */
+    SCHED_TRACE_ISR_ENTER,             /* arg0: interrupt ID */
+    SCHED_TRACE_ISR_EXIT,              /* arg0: interrupt ID */
+    SCHED_TRACE_NOTIFY,                /* arg0: task notified, arg1: index */
+    SCHED_TRACE_NOTIFY_WAIT,           /* arg0: index */
+    SCHED_TRACE_PRIORITY_INHERIT,      /* arg0: task, arg1: new priority */
+    SCHED_TRACE_PRIORITY_DISINHERIT,   /* arg0: task, arg1: new priority */
+    SCHED_TRACE_IPC_TX,                /* arg0: core, arg1: IPC type */
+    SCHED_TRACE_IPC_RX,                /* arg0: IPC type */
+    SCHED_TRACE_EVENT_MAX
+} SCHED_TRACE_EVENT;
+
+typedef struct SCHED_TRACE_STATUS {
+    bool running;
+    uint32_t events;
+    uint32_t capacity;
+    uint32_t tasks;
+} SCHED_TRACE_STATUS;
+
+/* Non-zero while a capture is running */
+extern volatile uint32_t schedTraceRunning;
+
+/* Records an event.  Safe from any context, use SCHED_TRACE(). */
+void sched_trace_record(SCHED_TRACE_EVENT event, uint32_t arg0, uint32_t arg1);
+
+#if SCHED_TRACE_ENABLE
+#define SCHED_TRACE(event, arg0, arg1) \
+    do { \
+        if (schedTraceRunning) { \
+            sched_trace_record(event, (uint32_t)(uintptr_t)(arg0), \
+                (uint32_t)(uintptr_t)(arg1)); \
+        } \
+    } while (0)
+#else
+#define SCHED_TRACE(event, arg0, arg1)
+#endif
+
+/*
+ * Task name bookkeeping, called from the FreeRTOS create and delete
+ * trace macros.  Names are kept after a task is deleted so a capture
+ * can still be exported.
+ */
+void sched_trace_task_create(void *task, const char *name);
+void sched_trace_task_delete(void *task);
+
+/*
+ * Capture control (task context).  sched_trace_start() allocates the
+ * ring on first use and returns false if that fails.
+ */
+bool sched_trace_start(void);
+void sched_trace_stop(void);
+void sched_trace_status(SCHED_TRACE_STATUS *status);
+
+/*
+ * Stops any running capture and writes it to 'fname' as Chrome trace
+ * JSON.  Returns the number of events written or -1 on error.
+ */
+int sched_trace_save(const char *fname);
+
+#endif
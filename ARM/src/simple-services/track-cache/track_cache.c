@@ -0,0 +1,541 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+#include "track_cache_cfg.h"
+#include "track_cache.h"
+
+#ifndef TRACK_CACHE_SIZE
+#define TRACK_CACHE_SIZE           (8 * 1024 * 1024)
+#endif
+
+#ifndef TRACK_CACHE_REGION_SIZE
+#define TRACK_CACHE_REGION_SIZE    (256 * 1024)
+#endif
+
+#ifndef TRACK_CACHE_READ_AHEAD
+#define TRACK_CACHE_READ_AHEAD     (4)
+#endif
+
+#ifndef TRACK_CACHE_MAX_TRACKS
+#define TRACK_CACHE_MAX_TRACKS     (4)
+#endif
+
+#ifndef TRACK_CACHE_CALLOC
+#define TRACK_CACHE_CALLOC calloc
+#endif
+
+#ifndef TRACK_CACHE_FREE
+#define TRACK_CACHE_FREE free
+#endif
+
+#define TRACK_CACHE_MAX_REGIONS \
+    (TRACK_CACHE_SIZE / TRACK_CACHE_REGION_SIZE)
+
+typedef enum TRACK_CACHE_PRIO {
+    TRACK_CACHE_PRIO_QUEUED,
+    TRACK_CACHE_PRIO_OPEN
+} TRACK_CACHE_PRIO;
+
+struct TRACK_CACHE_TRACK {
+    char *fname;
+    FILE *f;                   /* Shared by readers and the loader */
+    uint32_t size;
+    uint32_t regions;
+    uint32_t pos;              /* Offset of the last read */
+    unsigned refs;
+    unsigned queued;           /* Queue order, 0 if not queued */
+    uint32_t lastUse;
+};
+
+/* A region is loading while it has a track but isn't valid yet */
+typedef struct TRACK_CACHE_REGION {
+    uint8_t *data;
+    TRACK_CACHE_TRACK *track;
+    uint32_t index;
+    uint32_t len;
+    uint32_t lastUse;
+    unsigned pins;
+    bool valid;
+} TRACK_CACHE_REGION;
+
+static TRACK_CACHE_TRACK cacheTracks[TRACK_CACHE_MAX_TRACKS];
+static TRACK_CACHE_REGION cacheRegions[TRACK_CACHE_MAX_REGIONS];
+static unsigned numRegions;
+static bool regionAllocFailed;
+static uint32_t useClock;
+static unsigned queueSeq;
+static TRACK_CACHE_STATS cacheStats;
+
+/* Lock order is cacheLock then ioLock */
+static SemaphoreHandle_t cacheLock;
+static SemaphoreHandle_t ioLock;
+
+static void lock(SemaphoreHandle_t l)
+{
+    xSemaphoreTake(l, portMAX_DELAY);
+}
+
+static void unlock(SemaphoreHandle_t l)
+{
+    xSemaphoreGive(l);
+}
+
+static TRACK_CACHE_REGION *findRegion(TRACK_CACHE_TRACK *t, uint32_t index)
+{
+    TRACK_CACHE_REGION *r;
+    unsigned i;
+
+    for (i = 0; i < numRegions; i++) {
+        r = &cacheRegions[i];
+        if ((r->track == t) && (r->index == index)) {
+            return(r);
+        }
+    }
+
+    return(NULL);
+}
+
+static bool trackBusy(TRACK_CACHE_TRACK *t)
+{
+    TRACK_CACHE_REGION *r;
+    unsigned i;
+
+    for (i = 0; i < numRegions; i++) {
+        r = &cacheRegions[i];
+        if ((r->track == t) && (r->pins || !r->valid)) {
+            return(true);
+        }
+    }
+
+    return(false);
+}
+
+static bool trackIdle(TRACK_CACHE_TRACK *t)
+{
+    return((t->refs == 0) && (t->queued == 0));
+}
+
+/* Drops a track and everything it has resident */
+static void trackFree(TRACK_CACHE_TRACK *t)
+{
+    unsigned i;
+
+    for (i = 0; i < numRegions; i++) {
+        if (cacheRegions[i].track == t) {
+            cacheRegions[i].track = NULL;
+            cacheRegions[i].valid = false;
+        }
+    }
+    if (t->f) {
+        lock(ioLock);
+        fclose(t->f);
+        unlock(ioLock);
+    }
+    TRACK_CACHE_FREE(t->fname);
+    memset(t, 0, sizeof(*t));
+}
+
+/*
+ * Finds the track for 'fname', setting up a slot for it if needed.
+ * The least recently used idle track gives up its slot when all are
+ * taken.  Call with the cache lock held.
+ */
+static TRACK_CACHE_TRACK *trackGet(const char *fname)
+{
+    TRACK_CACHE_TRACK *t;
+    TRACK_CACHE_TRACK *victim = NULL;
+    FILE *f;
+    long size;
+    unsigned i;
+
+    for (i = 0; i < TRACK_CACHE_MAX_TRACKS; i++) {
+        t = &cacheTracks[i];
+        if (t->fname && (strcmp(t->fname, fname) == 0)) {
+            return(t);
+        }
+    }
+
+    for (i = 0; i < TRACK_CACHE_MAX_TRACKS; i++) {
+        t = &cacheTracks[i];
+        if (t->fname == NULL) {
+            victim = t;
+            break;
+        }
+        if (trackIdle(t) && !trackBusy(t) &&
+            (!victim || (t->lastUse < victim->lastUse))) {
+            victim = t;
+        }
+    }
+    if (victim == NULL) {
+        return(NULL);
+    }
+    if (victim->fname) {
+        trackFree(victim);
+    }
+
+    lock(ioLock);
+    f = fopen(fname, "rb");
+    size = -1;
+    if (f) {
+        if (fseek(f, 0, SEEK_END) == 0) {
+            size = ftell(f);
+        }
+        if (size < 0) {
+            fclose(f); f = NULL;
+        }
+    }
+    unlock(ioLock);
+    if (f == NULL) {
+        return(NULL);
+    }
+
+    t = victim;
+    t->fname = TRACK_CACHE_CALLOC(strlen(fname) + 1, 1);
+    if (t->fname == NULL) {
+        lock(ioLock);
+        fclose(f);
+        unlock(ioLock);
+        return(NULL);
+    }
+    strcpy(t->fname, fname);
+    t->f = f;
+    t->size = (uint32_t)size;
+    t->regions = (t->size + TRACK_CACHE_REGION_SIZE - 1) /
+        TRACK_CACHE_REGION_SIZE;
+    t->lastUse = ++useClock;
+
+    return(t);
+}
+
+/* True if 'r' is within its open track's read-ahead window */
+static bool inReadAhead(TRACK_CACHE_REGION *r)
+{
+    TRACK_CACHE_TRACK *t = r->track;
+    uint32_t ahead;
+
+    if (t->refs == 0) {
+        return(false);
+    }
+    ahead = (r->index + t->regions - t->pos / TRACK_CACHE_REGION_SIZE) %
+        t->regions;
+
+    return(ahead < TRACK_CACHE_READ_AHEAD);
+}
+
+/*
+ * Picks the region to load into.  Free and newly allocated regions
+ * first, then the LRU region of an idle track.  Open tracks may also
+ * take back played regions and, last, the tail of the latest queued
+ * track.
+ */
+static TRACK_CACHE_REGION *regionGet(TRACK_CACHE_PRIO prio)
+{
+    TRACK_CACHE_REGION *r;
+    TRACK_CACHE_REGION *idle = NULL;
+    TRACK_CACHE_REGION *played = NULL;
+    TRACK_CACHE_REGION *queued = NULL;
+    unsigned i;
+
+    for (i = 0; i < numRegions; i++) {
+        if (cacheRegions[i].track == NULL) {
+            return(&cacheRegions[i]);
+        }
+    }
+
+    if ((numRegions < TRACK_CACHE_MAX_REGIONS) && !regionAllocFailed) {
+        r = &cacheRegions[numRegions];
+        r->data = TRACK_CACHE_CALLOC(TRACK_CACHE_REGION_SIZE, 1);
+        if (r->data) {
+            numRegions++;
+            return(r);
+        }
+        regionAllocFailed = true;
+    }
+
+    for (i = 0; i < numRegions; i++) {
+        r = &cacheRegions[i];
+        if (r->pins || !r->valid) {
+            continue;
+        }
+        if (trackIdle(r->track)) {
+            if (!idle || (r->lastUse < idle->lastUse)) {
+                idle = r;
+            }
+        } else if (r->track->refs) {
+            if (!inReadAhead(r) &&
+                (!played || (r->lastUse < played->lastUse))) {
+                played = r;
+            }
+        } else {
+            if (!queued || (r->track->queued > queued->track->queued) ||
+                ((r->track == queued->track) && (r->index > queued->index))) {
+                queued = r;
+            }
+        }
+    }
+
+    if (idle) {
+        return(idle);
+    }
+    if (prio == TRACK_CACHE_PRIO_OPEN) {
+        return(played ? played : queued);
+    }
+
+    return(NULL);
+}
+
+/* Next region wanted, open tracks' read-ahead before queued tracks */
+static TRACK_CACHE_TRACK *nextLoad(uint32_t *index, TRACK_CACHE_PRIO *prio)
+{
+    TRACK_CACHE_TRACK *t;
+    TRACK_CACHE_TRACK *next;
+    uint32_t first;
+    unsigned i, k;
+
+    for (i = 0; i < TRACK_CACHE_MAX_TRACKS; i++) {
+        t = &cacheTracks[i];
+        if (!t->fname || !t->refs || !t->regions) {
+            continue;
+        }
+        first = t->pos / TRACK_CACHE_REGION_SIZE;
+        for (k = 0; (k < TRACK_CACHE_READ_AHEAD) && (k < t->regions); k++) {
+            *index = (first + k) % t->regions;
+            if (findRegion(t, *index) == NULL) {
+                *prio = TRACK_CACHE_PRIO_OPEN;
+                return(t);
+            }
+        }
+    }
+
+    /* Queued tracks from the front of the queue, each from its start */
+    next = NULL;
+    do {
+        t = next; next = NULL;
+        for (i = 0; i < TRACK_CACHE_MAX_TRACKS; i++) {
+            if (cacheTracks[i].queued &&
+                (!t || (cacheTracks[i].queued > t->queued)) &&
+                (!next || (cacheTracks[i].queued < next->queued))) {
+                next = &cacheTracks[i];
+            }
+        }
+        if (next) {
+            for (*index = 0; *index < next->regions; (*index)++) {
+                if (findRegion(next, *index) == NULL) {
+                    *prio = TRACK_CACHE_PRIO_QUEUED;
+                    return(next);
+                }
+            }
+        }
+    } while (next);
+
+    return(NULL);
+}
+
+void track_cache_init(void)
+{
+    cacheLock = xSemaphoreCreateMutex();
+    ioLock = xSemaphoreCreateMutex();
+}
+
+TRACK_CACHE_TRACK *track_cache_open(const char *fname)
+{
+    TRACK_CACHE_TRACK *t;
+
+    lock(cacheLock);
+    t = trackGet(fname);
+    if (t) {
+        t->refs++;
+        t->queued = 0;
+        t->pos = 0;
+        t->lastUse = ++useClock;
+    }
+    unlock(cacheLock);
+
+    return(t);
+}
+
+void track_cache_close(TRACK_CACHE_TRACK *t)
+{
+    lock(cacheLock);
+    if (t->refs) {
+        t->refs--;
+    }
+    t->lastUse = ++useClock;
+    unlock(cacheLock);
+}
+
+size_t track_cache_read(void *usr, uint32_t offset, void *buf, size_t len)
+{
+    TRACK_CACHE_TRACK *t = (TRACK_CACHE_TRACK *)usr;
+    TRACK_CACHE_REGION *r;
+    uint8_t *dst = (uint8_t *)buf;
+    uint32_t within;
+    size_t total;
+    size_t rsize;
+    size_t n;
+
+    if (offset >= t->size) {
+        return(0);
+    }
+    if (len > t->size - offset) {
+        len = t->size - offset;
+    }
+
+    total = 0;
+    while (len) {
+        within = offset % TRACK_CACHE_REGION_SIZE;
+        n = TRACK_CACHE_REGION_SIZE - within;
+        if (n > len) {
+            n = len;
+        }
+
+        /* Pin a resident region so it can't be evicted during the copy */
+        lock(cacheLock);
+        t->pos = offset;
+        r = findRegion(t, offset / TRACK_CACHE_REGION_SIZE);
+        if (r && r->valid) {
+            r->pins++;
+            r->lastUse = ++useClock;
+            cacheStats.hits++;
+        } else {
+            r = NULL;
+            cacheStats.misses++;
+        }
+        unlock(cacheLock);
+
+        if (r) {
+            memcpy(dst, r->data + within, n);
+            lock(cacheLock);
+            r->pins--;
+            unlock(cacheLock);
+            rsize = n;
+        } else {
+            lock(ioLock);
+            rsize = 0;
+            if (fseek(t->f, offset, SEEK_SET) == 0) {
+                rsize = fread(dst, 1, n, t->f);
+            }
+            unlock(ioLock);
+            if (rsize != n) {
+                lock(cacheLock);
+                cacheStats.readErrors++;
+                unlock(cacheLock);
+                return((size_t)-1);
+            }
+        }
+
+        dst += n; offset += n; len -= n; total += n;
+    }
+
+    return(total);
+}
+
+bool track_cache_queue(const char *fname)
+{
+    TRACK_CACHE_TRACK *t;
+    unsigned i;
+
+    lock(cacheLock);
+    if (fname == NULL) {
+        for (i = 0; i < TRACK_CACHE_MAX_TRACKS; i++) {
+            cacheTracks[i].queued = 0;
+        }
+        t = NULL;
+    } else {
+        t = trackGet(fname);
+        if (t && (t->refs == 0) && (t->queued == 0)) {
+            t->queued = ++queueSeq;
+        }
+    }
+    unlock(cacheLock);
+
+    return((fname == NULL) || (t != NULL));
+}
+
+bool track_cache_service(void)
+{
+    TRACK_CACHE_TRACK *t;
+    TRACK_CACHE_REGION *r;
+    TRACK_CACHE_PRIO prio;
+    uint32_t index;
+    size_t rsize;
+    bool ok;
+
+    lock(cacheLock);
+    t = nextLoad(&index, &prio);
+    r = t ? regionGet(prio) : NULL;
+    if (r == NULL) {
+        unlock(cacheLock);
+        return(false);
+    }
+    if (r->track) {
+        cacheStats.evictions++;
+    }
+    r->track = t;
+    r->index = index;
+    r->valid = false;
+    r->len = t->size - index * TRACK_CACHE_REGION_SIZE;
+    if (r->len > TRACK_CACHE_REGION_SIZE) {
+        r->len = TRACK_CACHE_REGION_SIZE;
+    }
+    r->lastUse = ++useClock;
+    unlock(cacheLock);
+
+    /* The track can't be dropped while one of its regions is loading */
+    lock(ioLock);
+    rsize = 0;
+    if (fseek(t->f, index * TRACK_CACHE_REGION_SIZE, SEEK_SET) == 0) {
+        rsize = fread(r->data, 1, r->len, t->f);
+    }
+    unlock(ioLock);
+
+    lock(cacheLock);
+    ok = (rsize == r->len);
+    if (ok) {
+        r->valid = true;
+        cacheStats.loads++;
+    } else {
+        r->track = NULL;
+        cacheStats.readErrors++;
+    }
+    unlock(cacheLock);
+
+    return(ok);
+}
+
+void track_cache_stats(TRACK_CACHE_STATS *stats)
+{
+    unsigned i;
+
+    lock(cacheLock);
+    *stats = cacheStats;
+    stats->regions = numRegions;
+    stats->resident = 0;
+    for (i = 0; i < numRegions; i++) {
+        if (cacheRegions[i].valid) {
+            stats->resident++;
+        }
+    }
+    stats->tracks = 0;
+    for (i = 0; i < TRACK_CACHE_MAX_TRACKS; i++) {
+        if (cacheTracks[i].fname) {
+            stats->tracks++;
+        }
+    }
+    unlock(cacheLock);
+}
@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _track_cache_h
+#define _track_cache_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * SDRAM cache of audio files, in fixed size regions with LRU eviction.
+ *
+ * Open tracks are read by byte offset through track_cache_read().
+ * Resident regions are copied out of SDRAM, anything else is read from
+ * the file straight into the caller's buffer.  track_cache_service(),
+ * run from a low priority task, loads regions in the background:
+ *
+ *   1. The regions ahead of each open track's last read, wrapping to
+ *      the start for looped playback.
+ *   2. Queued tracks from the start, in queue order, for an instant
+ *      start when they are opened.
+ *
+ * Queued preloads only use free regions or those of tracks that are
+ * neither open nor queued.  Read-ahead evicts those first, then regions
+ * an open track already played, then queued ones.  Regions stay
+ * resident after a track closes so replaying it is instant too.
+ */
+
+typedef struct TRACK_CACHE_TRACK TRACK_CACHE_TRACK;
+
+typedef struct TRACK_CACHE_STATS {
+    unsigned regions;          /* Allocated */
+    unsigned resident;         /* Holding valid data */
+    unsigned tracks;
+    uint32_t hits;             /* Region sized pieces of reads */
+    uint32_t misses;
+    uint32_t loads;
+    uint32_t evictions;
+    uint32_t readErrors;
+} TRACK_CACHE_STATS;
+
+void track_cache_init(void);
+
+/*
+ * Opens a track for reading.  Tracks are matched by file name so a
+ * queued or recently played file picks up its resident regions.
+ * Returns NULL if the file can't be opened or all track slots are busy.
+ */
+TRACK_CACHE_TRACK *track_cache_open(const char *fname);
+void track_cache_close(TRACK_CACHE_TRACK *track);
+
+/*
+ * Reads 'len' bytes at 'offset'.  Signature matches WAVE_FILE_READ with
+ * the track as 'usr'.  Returns the bytes read, short at the end of the
+ * file, or (size_t)-1 on a read error.
+ */
+size_t track_cache_read(void *usr, uint32_t offset, void *buf, size_t len);
+
+/* Appends a file to the preload queue, NULL empties the queue */
+bool track_cache_queue(const char *fname);
+
+/*
+ * Loads at most one region.  Returns true if there is more to do so
+ * the caller can loop until the cache is settled.
+ */
+bool track_cache_service(void);
+
+void track_cache_stats(TRACK_CACHE_STATS *stats);
+
+#endif
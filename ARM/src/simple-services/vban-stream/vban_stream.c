@@ -18,7 +18,11 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "compat/posix/sys/socket.h"
+#include "lwip/pbuf.h"
+#include "lwip/udp.h"
+#include "lwip/igmp.h"
+#include "lwip/ip.h"
+#include "lwip/tcpip.h"
 
 #include "vban_stream_cfg.h"
 #include "vban_stream.h"
@@ -134,12 +138,113 @@ static int vbanGetFmt(int wordSizeBytes)
     return(fmt);
 }
 
+/* One pcb per UDP port, shared by every Rx stream bound to it */
+typedef struct _VBAN_RX_PORT {
+    struct udp_pcb *pcb;
+    u16_t port;
+    VBAN_STREAM *streams;
+    struct _VBAN_RX_PORT *next;
+} VBAN_RX_PORT;
+
+static VBAN_RX_PORT *vbanRxPorts = NULL;
+
+static void vbanRecv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+    const ip_addr_t *addr, u16_t port);
+
+/* Called with the lwIP core locked */
+static bool vbanRxAttach(VBAN_STREAM *rs)
+{
+    VBAN_RX_PORT *rp;
+    bool ok = true;
+    err_t err;
+
+    if (ip_addr_ismulticast(&rs->ipAddr)) {
+        err = igmp_joingroup(IP4_ADDR_ANY4, ip_2_ip4(&rs->ipAddr));
+        if (err != ERR_OK) {
+            return(false);
+        }
+    }
+
+    for (rp = vbanRxPorts; rp != NULL; rp = rp->next) {
+        if (rp->port == rs->port) {
+            break;
+        }
+    }
+
+    if (rp == NULL) {
+        rp = VBAN_MALLOC(sizeof(*rp));
+        ok = (rp != NULL);
+        if (ok) {
+            memset(rp, 0, sizeof(*rp));
+            rp->port = rs->port;
+            rp->pcb = udp_new();
+            ok = (rp->pcb != NULL);
+        }
+        if (ok) {
+            err = udp_bind(rp->pcb, IP_ADDR_ANY, rp->port);
+            ok = (err == ERR_OK);
+        }
+        if (ok) {
+            udp_recv(rp->pcb, vbanRecv, rp);
+            rp->next = vbanRxPorts;
+            vbanRxPorts = rp;
+        } else {
+            if (rp) {
+                if (rp->pcb) {
+                    udp_remove(rp->pcb);
+                }
+                VBAN_FREE(rp);
+            }
+            if (ip_addr_ismulticast(&rs->ipAddr)) {
+                igmp_leavegroup(IP4_ADDR_ANY4, ip_2_ip4(&rs->ipAddr));
+            }
+            return(false);
+        }
+    }
+
+    rs->next = rp->streams;
+    rp->streams = rs;
+    rs->rxPort = rp;
+
+    return(true);
+}
+
+/* Called with the lwIP core locked */
+static void vbanRxDetach(VBAN_STREAM *rs)
+{
+    VBAN_RX_PORT *rp = (VBAN_RX_PORT *)rs->rxPort;
+    VBAN_RX_PORT **prp;
+    VBAN_STREAM **prs;
+
+    for (prs = &rp->streams; *prs != NULL; prs = &(*prs)->next) {
+        if (*prs == rs) {
+            *prs = rs->next;
+            break;
+        }
+    }
+    rs->next = NULL;
+    rs->rxPort = NULL;
+
+    if (ip_addr_ismulticast(&rs->ipAddr)) {
+        igmp_leavegroup(IP4_ADDR_ANY4, ip_2_ip4(&rs->ipAddr));
+    }
+
+    if (rp->streams == NULL) {
+        for (prp = &vbanRxPorts; *prp != NULL; prp = &(*prp)->next) {
+            if (*prp == rp) {
+                *prp = rp->next;
+                break;
+            }
+        }
+        udp_remove(rp->pcb);
+        VBAN_FREE(rp);
+    }
+}
+
 bool vbanOpenStream(VBAN_STREAM *rs)
 {
-    struct sockaddr_in srcAddr;
     VBAN_PKT_HDR *hdr;
     bool ok = false;
-    int ret;
 
     if (rs->ipStr == NULL) {
         return(false);
@@ -149,36 +254,16 @@ bool vbanOpenStream(VBAN_STREAM *rs)
         return(false);
     }
 
-    memset(&rs->ipAddr, 0, sizeof(rs->ipAddr));
-    rs->ipAddr.sin_family = AF_INET;
-    rs->ipAddr.sin_len = sizeof(rs->ipAddr);
-    ok = inet_aton(rs->ipStr, &rs->ipAddr.sin_addr.s_addr);
+    ok = ipaddr_aton(rs->ipStr, &rs->ipAddr);
     if (!ok) {
         goto abort;
     }
-    rs->ipAddr.sin_port = htons(rs->port);
 
-    rs->socket = socket(AF_INET, SOCK_DGRAM, 0);
-    ok = (rs->socket >= 0);
+    rs->pkt = VBAN_MALLOC(VBAN_MAX_PACKET_SIZE);
+    ok = (rs->pkt != NULL);
     if (!ok) {
         goto abort;
     }
-
-    if (rs->isRx) {
-        memset(&srcAddr, 0, sizeof(srcAddr));
-        srcAddr.sin_family = AF_INET;
-        srcAddr.sin_len = sizeof(srcAddr);
-        srcAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-        srcAddr.sin_port = htons(rs->port);
-
-        ret = bind(rs->socket, (struct sockaddr *)&srcAddr, sizeof(srcAddr));
-        ok = (ret == 0);
-        if (!ok) {
-            goto abort;
-        }
-    }
-
-    rs->pkt = VBAN_MALLOC(VBAN_MAX_PACKET_SIZE);
     memset(rs->pkt, 0, VBAN_MAX_PACKET_SIZE);
 
     hdr = (VBAN_PKT_HDR *)rs->pkt;
@@ -186,17 +271,17 @@ bool vbanOpenStream(VBAN_STREAM *rs)
     rs->format_SR = vbanGetSrIdx(rs->systemSampleRate) | VBAN_PROTOCOL_AUDIO;
 
     if (rs->isRx) {
-        struct timeval tv;
-        tv.tv_sec = 0;
-        tv.tv_usec = 100000;
-        setsockopt(rs->socket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof tv);
         rs->preRoll = true;
     } else {
         hdr->vban = VBAN_FOURC;
         hdr->format_SR = rs->format_SR;
         hdr->format_bit = vbanGetFmt(rs->wordSizeBytes) | VBAN_CODEC_PCM;
         hdr->format_nbc = rs->channels - 1;
-        strcpy(hdr->streamname, VBAN_STREAM_NAME);
+        if (rs->streamName[0]) {
+            memcpy(hdr->streamname, rs->streamName, sizeof(hdr->streamname));
+        } else {
+            strcpy(hdr->streamname, VBAN_STREAM_NAME);
+        }
         rs->sequence = rand();
         rs->maxSamples = (VBAN_MAX_PACKET_SIZE - sizeof(*hdr)) / rs->wordSizeBytes;
         rs->maxSamples = (rs->maxSamples / rs->channels) * rs->channels;
@@ -211,9 +296,19 @@ bool vbanOpenStream(VBAN_STREAM *rs)
     rs->samples = 0;
     rs->enabled = true;
 
-    ok = true;
+    LOCK_TCPIP_CORE();
+    if (rs->isRx) {
+        ok = vbanRxAttach(rs);
+    } else {
+        rs->pcb = udp_new();
+        ok = (rs->pcb != NULL);
+    }
+    UNLOCK_TCPIP_CORE();
 
 abort:
+    if (!ok) {
+        vbanCloseStream(rs);
+    }
     return(ok);
 }
 
@@ -225,6 +320,21 @@ unsigned vbanWriteSamplesAvailable(VBAN_STREAM *rs, void **data)
     return(rs->maxSamples - rs->samples);
 }
 
+/* Send by reference, lwIP no longer needs 'pkt' after udp_sendto() */
+static void vbanSendPkt(VBAN_STREAM *rs)
+{
+    struct pbuf *p;
+
+    LOCK_TCPIP_CORE();
+    p = pbuf_alloc(PBUF_TRANSPORT, rs->size, PBUF_REF);
+    if (p) {
+        p->payload = rs->pkt;
+        udp_sendto(rs->pcb, p, &rs->ipAddr, rs->port);
+        pbuf_free(p);
+    }
+    UNLOCK_TCPIP_CORE();
+}
+
 unsigned vbanWriteSamples(VBAN_STREAM *rs, unsigned samples)
 {
     VBAN_PKT_HDR *hdr = (VBAN_PKT_HDR *)rs->pkt;
@@ -235,7 +345,7 @@ unsigned vbanWriteSamples(VBAN_STREAM *rs, unsigned samples)
     if (rs->samples == rs->maxSamples) {
         hdr->format_nbs = rs->maxFrames - 1;
         hdr->nuFrame = rs->sequence;
-        sendto(rs->socket, hdr, rs->size, 0, (struct sockaddr *)&rs->ipAddr, sizeof(rs->ipAddr));
+        vbanSendPkt(rs);
         rs->data = hdr->data;
         rs->samples = 0;
         rs->sequence += 1;
@@ -307,48 +417,89 @@ abort:
     return(ok);
 }
 
-unsigned vbanReadSamplesAvailable(VBAN_STREAM *rs, void **data)
+/* Sender, multicast group and stream name filters */
+static bool vbanRxMatch(VBAN_STREAM *rs, VBAN_PKT_HDR *hdr,
+    const ip_addr_t *addr)
 {
-    VBAN_PKT_HDR *hdr = (VBAN_PKT_HDR *)rs->pkt;
-    ssize_t size = 0;
-
-    if (rs->samples == 0) {
-        socklen_t addrLen = sizeof(rs->ipAddr);
-        size = recvfrom(
-            rs->socket, rs->pkt, VBAN_MAX_PACKET_SIZE, 0,
-            (struct sockaddr *)&rs->ipAddr, &addrLen
-        );
-        if (size < (ssize_t)sizeof(*hdr)) {
-            return(0);
+    if (ip_addr_ismulticast(&rs->ipAddr)) {
+        if (!ip_addr_cmp(&rs->ipAddr, ip_current_dest_addr())) {
+            return(false);
         }
-        if (!vbanPktOk(rs, hdr, (unsigned)size)) {
-            return(0);
+    } else if (!ip_addr_isany(&rs->ipAddr)) {
+        if (!ip_addr_cmp(&rs->ipAddr, addr)) {
+            return(false);
         }
     }
 
-    if (data) {
-        *data = (void *)rs->data;
+    if (rs->streamName[0] &&
+        strncmp(hdr->streamname, rs->streamName, sizeof(hdr->streamname))) {
+        return(false);
     }
 
-    return(rs->samples);
+    return(true);
 }
 
-unsigned vbanReadSamples(VBAN_STREAM *rs, unsigned samples)
+/*
+ * Validate and fan Rx packets out to every matching stream on the
+ * port (lwIP core locked)
+ */
+static void vbanRecv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+    const ip_addr_t *addr, u16_t port)
 {
-    rs->samples -= samples;
-    rs->data += samples * rs->wordSizeBytes;
-    return(rs->samples);
+    VBAN_RX_PORT *rp = (VBAN_RX_PORT *)arg;
+    VBAN_STREAM *rs;
+    VBAN_PKT_HDR *hdr;
+    unsigned size;
+
+    size = p->tot_len;
+    if ((size < sizeof(*hdr)) || (size > VBAN_MAX_PACKET_SIZE)) {
+        goto abort;
+    }
+
+    if (rp->streams == NULL) {
+        goto abort;
+    }
+
+    if (p->len == p->tot_len) {
+        hdr = (VBAN_PKT_HDR *)p->payload;
+    } else {
+        pbuf_copy_partial(p, rp->streams->pkt, size, 0);
+        hdr = (VBAN_PKT_HDR *)rp->streams->pkt;
+    }
+
+    for (rs = rp->streams; rs != NULL; rs = rs->next) {
+        if (!vbanRxMatch(rs, hdr, addr)) {
+            continue;
+        }
+        if (!vbanPktOk(rs, hdr, size)) {
+            continue;
+        }
+        if (rs->rxCallback) {
+            rs->rxCallback(rs, hdr->data, rs->samples, rs->usrPtr);
+        }
+        rs->samples = 0;
+    }
+
+abort:
+    pbuf_free(p);
 }
 
 void vbanCloseStream(VBAN_STREAM *rs)
 {
-    if (rs->socket >= 0) {
-        lwip_close(rs->socket);
+    if (rs->rxPort) {
+        LOCK_TCPIP_CORE();
+        vbanRxDetach(rs);
+        UNLOCK_TCPIP_CORE();
+    }
+    if (rs->pcb) {
+        LOCK_TCPIP_CORE();
+        udp_remove(rs->pcb);
+        UNLOCK_TCPIP_CORE();
+        rs->pcb = NULL;
     }
+    rs->enabled = false;
     if (rs->pkt) {
         VBAN_FREE(rs->pkt);
         rs->pkt = NULL;
     }
-    rs->socket = -1;
-    rs->enabled = false;
 }
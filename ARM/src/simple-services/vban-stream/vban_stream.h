@@ -16,7 +16,19 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-#include "compat/posix/sys/socket.h"
+#include "lwip/ip_addr.h"
+#include "lwip/udp.h"
+
+struct VBAN_STREAM;
+
+/*
+ * Rx payload callback.  Called from the lwIP receive context (core
+ * locked) with a validated packet of 'samples' little-endian samples
+ * ('streamChannels' interleaved).  'data' points directly into the
+ * received packet and is only valid for the duration of the call.
+ */
+typedef void (*VBAN_RX_CALLBACK)(struct VBAN_STREAM *rs, void *data,
+    unsigned samples, void *usrPtr);
 
 typedef struct VBAN_STREAM {
     bool enabled;
@@ -24,10 +36,10 @@ typedef struct VBAN_STREAM {
     unsigned channels;
     unsigned wordSizeBytes;
     bool isRx;
-    int socket;
+    struct udp_pcb *pcb;
     int port;
     char *ipStr;
-    struct sockaddr_in ipAddr;
+    ip_addr_t ipAddr;
     void *pkt;
     uint8_t *data;
     uint32_t sequence;
@@ -40,16 +52,24 @@ typedef struct VBAN_STREAM {
     unsigned streamChannels;
     bool sync;
     bool preRoll;
+    char streamName[16];
+    VBAN_RX_CALLBACK rxCallback;
+    void *usrPtr;
+    void *rxPort;
+    struct VBAN_STREAM *next;
 } VBAN_STREAM;
 
+/*
+ * Rx streams sharing a port each get a copy of every packet that
+ * passes their filters.  'ipStr' selects a multicast group to join,
+ * a single unicast sender, or "0.0.0.0" for any sender.  A non-empty
+ * 'streamName' only accepts that VBAN stream on Rx and names the
+ * stream on Tx.
+ */
 bool vbanOpenStream(VBAN_STREAM *rs);
 void vbanCloseStream(VBAN_STREAM *rs);
 
 unsigned vbanWriteSamplesAvailable(VBAN_STREAM *rs, void **data);
 unsigned vbanWriteSamples(VBAN_STREAM *rs, unsigned samples);
 
-unsigned vbanReadPkt(VBAN_STREAM *rs);
-unsigned vbanReadSamplesAvailable(VBAN_STREAM *rs, void **data);
-unsigned vbanReadSamples(VBAN_STREAM *rs, unsigned samples);
-
 #endif
@@ -0,0 +1,677 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "wav_cue_cfg.h"
+#include "wav_cue.h"
+
+#ifndef WAV_CUE_PIN_MS
+#define WAV_CUE_PIN_MS          (250)
+#endif
+
+#ifndef WAV_CUE_LOOP_MAX_MS
+#define WAV_CUE_LOOP_MAX_MS     (16000)
+#endif
+
+#ifndef WAV_CUE_XFADE_FRAMES
+#define WAV_CUE_XFADE_FRAMES    (32)
+#endif
+
+#ifndef WAV_SCRATCH_WINDOW_MS
+#define WAV_SCRATCH_WINDOW_MS   (3000)
+#endif
+
+#ifndef WAV_SCRATCH_BLOCK_FRAMES
+#define WAV_SCRATCH_BLOCK_FRAMES (1024)
+#endif
+
+#ifndef WAV_SCRATCH_MAX_RATE
+#define WAV_SCRATCH_MAX_RATE    (4.0f)
+#endif
+
+#ifndef WAV_CUE_MALLOC
+#define WAV_CUE_MALLOC          malloc
+#endif
+
+#ifndef WAV_CUE_FREE
+#define WAV_CUE_FREE            free
+#endif
+
+#define WAV_CUE_DEFAULT_BPM     (120.0f)
+
+static uint32_t msFrames(WAV_CUE *cue, uint32_t ms)
+{
+    return((uint32_t)(((uint64_t)ms * cue->sampleRate) / 1000));
+}
+
+/*
+ * Linear crossfade from 'from' to 'to' over WAV_CUE_XFADE_FRAMES,
+ * starting 'pos' frames in.  'dst' may be 'to'.
+ */
+static void crossfade(int32_t *dst, const int32_t *to, const int32_t *from,
+    unsigned frames, unsigned channels, unsigned pos)
+{
+    int64_t d;
+    unsigned i, c;
+
+    for (i = 0; i < frames; i++, pos++) {
+        for (c = 0; c < channels; c++) {
+            d = (int64_t)*to++ - *from;
+            *dst++ = (int32_t)(*from++ + (d * pos) / WAV_CUE_XFADE_FRAMES);
+        }
+    }
+}
+
+static bool pinAlloc(WAV_CUE *cue, WAV_CUE_PIN *pin, uint32_t frames)
+{
+    if (pin->size < frames) {
+        if (pin->buf) {
+            WAV_CUE_FREE(pin->buf);
+        }
+        pin->size = 0;
+        pin->buf = WAV_CUE_MALLOC(frames * cue->channels * sizeof(int32_t));
+        if (pin->buf == NULL) {
+            return(false);
+        }
+        pin->size = frames;
+    }
+
+    return(true);
+}
+
+static void pinFree(WAV_CUE_PIN *pin)
+{
+    if (pin->buf) {
+        WAV_CUE_FREE(pin->buf);
+    }
+    memset(pin, 0, sizeof(*pin));
+}
+
+/* Takes a pin away from the xfer path, fails if it is playing */
+static bool pinRelease(WAV_CUE *cue, WAV_CUE_PIN *pin)
+{
+    bool busy;
+
+    taskENTER_CRITICAL();
+    busy = (cue->playing == pin);
+    if (!busy) {
+        pin->ready = false;
+    }
+    taskEXIT_CRITICAL();
+
+    return(!busy);
+}
+
+static bool pinLoad(WAV_CUE *cue, WAV_CUE_PIN *pin, uint32_t frame,
+    uint32_t frames)
+{
+    if (!pinRelease(cue, pin)) {
+        return(false);
+    }
+    if (!pinAlloc(cue, pin, frames)) {
+        pinFree(pin);
+        return(false);
+    }
+    pin->frame = frame % cue->totalFrames;
+    pin->frames = 0;
+    pin->want = frames;
+
+    return(true);
+}
+
+/* xfer path --------------------------------------------------------------*/
+
+static void seekTo(WAV_CUE *cue, uint32_t frame)
+{
+    cue->seekFrame = frame % cue->totalFrames;
+    cue->seekReq++;
+    cue->wake = true;
+    cue->stats.seeks++;
+}
+
+/* Drops ring audio written before the last seek */
+static void discardStale(WAV_CUE *cue, PaUtilRingBuffer *rb)
+{
+    ring_buffer_size_t n;
+
+    if (cue->stale && (cue->seekAck == cue->seekReq)) {
+        n = (cue->seekMark - rb->readIndex) & rb->bigMask;
+        PaUtil_AdvanceRingBufferReadIndex(rb, n);
+        cue->stale = false;
+    }
+}
+
+static void pinCopy(WAV_CUE *cue, int32_t *out, unsigned frames)
+{
+    WAV_CUE_PIN *pin = cue->playing;
+    unsigned ch = cue->channels;
+    const int32_t *src = pin->buf + cue->playPos * ch;
+    const int32_t *tail;
+    unsigned n = 0;
+
+    /* Fade from the audio past the out point into the in point */
+    if (cue->seam && (cue->playPos < WAV_CUE_XFADE_FRAMES)) {
+        n = WAV_CUE_XFADE_FRAMES - cue->playPos;
+        if (n > frames) {
+            n = frames;
+        }
+        tail = pin->buf + (cue->loopOut - cue->loopIn + cue->playPos) * ch;
+        crossfade(out, src, tail, n, ch, cue->playPos);
+    }
+    memcpy(out + n * ch, src + n * ch, (frames - n) * ch * sizeof(int32_t));
+}
+
+/*
+ * Plays 'frames' from the current source.  Returns false if there was
+ * nothing at all to play, any shortfall after some audio is silence.
+ */
+static bool play(WAV_CUE *cue, PaUtilRingBuffer *rb, int32_t *out,
+    unsigned frames)
+{
+    WAV_CUE_PIN *loop = &cue->pins[WAV_CUE_LOOP];
+    WAV_CUE_PIN *pin;
+    unsigned ch = cue->channels;
+    uint32_t frame;
+    uint32_t end;
+    unsigned n;
+    bool any = false;
+
+    while (frames) {
+        pin = cue->playing;
+        if (pin) {
+            end = ((pin == loop) && cue->looping) ?
+                cue->loopOut - cue->loopIn : pin->frames;
+            if (cue->playPos >= end) {
+                if (end < pin->frames) {
+                    cue->playPos = 0;
+                    cue->seam = true;
+                    cue->stats.loops++;
+                } else {
+                    cue->playing = NULL;
+                }
+                continue;
+            }
+            n = end - cue->playPos;
+            if (n > frames) {
+                n = frames;
+            }
+            pinCopy(cue, out, n);
+            cue->playPos += n;
+            if (cue->playPos >= WAV_CUE_XFADE_FRAMES) {
+                cue->seam = false;
+            }
+            cue->playFrame = (pin->frame + cue->playPos) % cue->totalFrames;
+        } else {
+            /* Switch to the loop exactly at its in point */
+            n = frames;
+            frame = cue->playFrame;
+            if (cue->looping && loop->ready) {
+                if ((frame >= cue->loopIn) && (frame < cue->loopOut)) {
+                    cue->playing = loop;
+                    cue->playPos = frame - cue->loopIn;
+                    cue->seam = false;
+                    seekTo(cue, loop->frame + loop->frames);
+                    continue;
+                }
+                if ((frame < cue->loopIn) && (cue->loopIn - frame < n)) {
+                    n = cue->loopIn - frame;
+                }
+            }
+            if ((cue->seekAck != cue->seekReq) ||
+                (PaUtil_GetRingBufferReadAvailable(rb) < n * ch)) {
+                memset(out, 0, frames * ch * sizeof(int32_t));
+                cue->stats.underflows++;
+                break;
+            }
+            PaUtil_ReadRingBuffer(rb, out, n * ch);
+            cue->playFrame = (frame + n) % cue->totalFrames;
+        }
+        out += n * ch; frames -= n;
+        any = true;
+    }
+
+    return(any);
+}
+
+static unsigned xfadeFrames(WAV_CUE *cue)
+{
+    return((WAV_CUE_XFADE_FRAMES > cue->blockFrames) ?
+        cue->blockFrames : WAV_CUE_XFADE_FRAMES);
+}
+
+/* Renders one block from the scratch window and times it */
+static void scratchRender(WAV_CUE *cue, int32_t *out)
+{
+    WAV_SCRATCH *s = &cue->scratch;
+    uint32_t center = s->center;
+    uint32_t misses = s->misses;
+    uint32_t t0 = 0;
+    uint32_t dt;
+
+    if (cue->timeStamp) {
+        t0 = cue->timeStamp();
+    }
+    wav_scratch_render(s, out, cue->blockFrames);
+    if (cue->timeStamp) {
+        dt = cue->timeStamp() - t0;
+        cue->stats.renderTicks = dt;
+        if (dt > cue->stats.peakRenderTicks) {
+            cue->stats.peakRenderTicks = dt;
+        }
+    }
+
+    /* The source task follows the head with the window */
+    if ((s->center != center) || (s->misses != misses)) {
+        cue->wake = true;
+    }
+    cue->playFrame = wav_scratch_frame(s);
+    cue->stats.scratchBlocks++;
+}
+
+/*
+ * Scratch mode.  On release the rate slews back to exactly 1 so the
+ * head moves a whole block each xfer, the ring is seeked to a block
+ * boundary a pin's length ahead and playback crossfades into it when
+ * the head gets there.  Returns false once back on the ring.
+ */
+static bool scratchXfer(WAV_CUE *cue, PaUtilRingBuffer *rb, int32_t *out)
+{
+    WAV_SCRATCH *s = &cue->scratch;
+    uint32_t margin;
+
+    /* Cues and loops wait until scratching is over */
+    cue->jumpReq = -1;
+
+    if (cue->scratchReq) {
+        cue->handoff = false;
+    } else {
+        s->target = 1.0f;
+        if (!cue->handoff && (s->rate == 1.0f)) {
+            margin = msFrames(cue, WAV_CUE_PIN_MS) + cue->blockFrames - 1;
+            margin -= margin % cue->blockFrames;
+            cue->handFrame = (cue->playFrame + margin) % cue->totalFrames;
+            cue->handoff = true;
+            seekTo(cue, cue->handFrame);
+        } else if (cue->handoff && (cue->playFrame == cue->handFrame)) {
+            if ((cue->seekAck == cue->seekReq) &&
+                (PaUtil_GetRingBufferReadAvailable(rb) >=
+                    cue->blockFrames * cue->channels)) {
+                scratchRender(cue, cue->xfade);
+                cue->scratching = false;
+                cue->handoff = false;
+                cue->playFrame = cue->handFrame;
+                return(false);
+            }
+            /* Ring isn't there yet, go round again further on */
+            cue->handoff = false;
+        }
+    }
+
+    scratchRender(cue, out);
+
+    return(true);
+}
+
+bool wav_cue_xfer(WAV_CUE *cue, PaUtilRingBuffer *rb, int32_t *out,
+    bool *wake)
+{
+    WAV_CUE_PIN *loop = &cue->pins[WAV_CUE_LOOP];
+    WAV_CUE_PIN *target = NULL;
+    bool handoff;
+    int req;
+    bool ok;
+
+    cue->wake = false;
+    discardStale(cue, rb);
+
+    if (cue->scratchReq && !cue->scratching) {
+        /* Switch over once the window is loaded around the play position */
+        wav_scratch_locate(&cue->scratch, cue->playFrame);
+        if (wav_scratch_ready(&cue->scratch, cue->playFrame,
+                cue->blockFrames * (unsigned)WAV_SCRATCH_MAX_RATE)) {
+            cue->scratching = true;
+            cue->handoff = false;
+            cue->playing = NULL;
+            cue->looping = false;
+            cue->scratch.rate = 1.0f;
+        } else {
+            cue->wake = true;
+        }
+    }
+    if (cue->scratching) {
+        if (scratchXfer(cue, rb, out)) {
+            *wake = cue->wake;
+            return(true);
+        }
+        handoff = true;
+    } else {
+        handoff = false;
+    }
+
+    req = cue->jumpReq;
+    if (req >= 0) {
+        cue->jumpReq = -1;
+        if (cue->pins[req].ready) {
+            target = &cue->pins[req];
+        }
+        if (req != WAV_CUE_LOOP) {
+            cue->looping = false;
+        }
+    } else if (cue->looping && loop->ready && (cue->playing != loop) &&
+            (cue->playFrame >= cue->loopOut)) {
+        /* Loop set behind the play position, go back to its start */
+        target = loop;
+    }
+
+    if (target) {
+        ok = play(cue, rb, cue->xfade, cue->blockFrames);
+        if (!ok) {
+            memset(cue->xfade, 0,
+                cue->blockFrames * cue->channels * sizeof(int32_t));
+        }
+        cue->playing = target;
+        cue->playPos = 0;
+        cue->seam = false;
+        seekTo(cue, target->frame + target->frames);
+        cue->stats.jumps++;
+        ok = play(cue, rb, out, cue->blockFrames);
+        crossfade(out, out, cue->xfade, xfadeFrames(cue), cue->channels, 0);
+    } else {
+        ok = play(cue, rb, out, cue->blockFrames);
+        if (handoff) {
+            /* Out of scratch mode, the last scratch block is in xfade */
+            crossfade(out, out, cue->xfade, xfadeFrames(cue),
+                cue->channels, 0);
+            ok = true;
+        }
+    }
+
+    *wake = cue->wake;
+
+    return(ok);
+}
+
+/* Source task ------------------------------------------------------------*/
+
+bool wav_cue_seek(WAV_CUE *cue, PaUtilRingBuffer *rb)
+{
+    unsigned req = cue->seekReq;
+
+    if ((cue->wf == NULL) || (req == cue->seekAck)) {
+        return(false);
+    }
+
+    seekWave(cue->wf, cue->seekFrame * cue->channels);
+
+    /* Everything before this index is from before the seek */
+    cue->seekMark = rb->writeIndex;
+    cue->stale = true;
+    cue->seekAck = req;
+
+    return(true);
+}
+
+bool wav_cue_service(WAV_CUE *cue, void *scratch, size_t scratchSamples)
+{
+    WAV_CUE_PIN *pin = NULL;
+    uint32_t frame;
+    size_t rsize;
+    unsigned n;
+    unsigned i;
+
+    if (cue->wf == NULL) {
+        return(false);
+    }
+    if ((cue->scratchReq || cue->scratching) &&
+        wav_scratch_service(&cue->scratch, cue->wf, scratch, scratchSamples,
+            &cue->stats.readErrors)) {
+        return(true);
+    }
+    for (i = 0; i <= WAV_CUE_LOOP; i++) {
+        if (cue->pins[i].buf && !cue->pins[i].ready &&
+            (cue->pins[i].frames < cue->pins[i].want)) {
+            pin = &cue->pins[i];
+            break;
+        }
+    }
+    if (pin == NULL) {
+        return(false);
+    }
+
+    /* Pins run on from the start of the file like playback does */
+    frame = (pin->frame + pin->frames) % cue->totalFrames;
+    n = pin->want - pin->frames;
+    if (n > scratchSamples / cue->channels) {
+        n = scratchSamples / cue->channels;
+    }
+    if (n > cue->totalFrames - frame) {
+        n = cue->totalFrames - frame;
+    }
+
+    rsize = readWaveAt(cue->wf, frame * cue->channels, scratch,
+        n * cue->channels);
+    if (rsize != n * cue->channels) {
+        cue->stats.readErrors++;
+        pinFree(pin);
+        return(true);
+    }
+    decodeWave(cue->wf, scratch, pin->buf + pin->frames * cue->channels,
+        n * cue->channels);
+
+    taskENTER_CRITICAL();
+    pin->frames += n;
+    if (pin->frames == pin->want) {
+        pin->ready = true;
+    }
+    taskEXIT_CRITICAL();
+
+    return(true);
+}
+
+/* Control ----------------------------------------------------------------*/
+
+bool wav_cue_attach(WAV_CUE *cue, WAV_FILE *wf, unsigned blockFrames,
+    uint32_t (*timeStamp)(void))
+{
+    unsigned i;
+
+    /* The xfer path goes back to the plain ring first */
+    taskENTER_CRITICAL();
+    cue->wf = NULL;
+    taskEXIT_CRITICAL();
+
+    for (i = 0; i <= WAV_CUE_LOOP; i++) {
+        pinFree(&cue->pins[i]);
+    }
+    if (cue->xfade) {
+        WAV_CUE_FREE(cue->xfade);
+    }
+    wav_scratch_free(&cue->scratch);
+    memset(cue, 0, sizeof(*cue));
+    cue->jumpReq = -1;
+    cue->timeStamp = timeStamp;
+
+    if (wf == NULL) {
+        return(true);
+    }
+    if (wf->flac || (wf->channels == 0) || (wf->dataSize < wf->channels)) {
+        return(false);
+    }
+
+    cue->channels = wf->channels;
+    cue->blockFrames = blockFrames;
+    cue->totalFrames = wf->dataSize / wf->channels;
+    cue->sampleRate = wf->sampleRate;
+    cue->bpm = WAV_CUE_DEFAULT_BPM;
+    cue->xfade = WAV_CUE_MALLOC(blockFrames * wf->channels * sizeof(int32_t));
+    if (cue->xfade == NULL) {
+        return(false);
+    }
+
+    /* Playback starts over from the beginning of the data */
+    taskENTER_CRITICAL();
+    cue->wf = wf;
+    taskEXIT_CRITICAL();
+
+    return(true);
+}
+
+bool wav_cue_set(WAV_CUE *cue, unsigned idx, uint32_t frame)
+{
+    uint32_t frames;
+
+    if ((cue->wf == NULL) || (idx >= WAV_CUE_MAX_CUES)) {
+        return(false);
+    }
+    frames = msFrames(cue, WAV_CUE_PIN_MS);
+    if (frames > cue->totalFrames) {
+        frames = cue->totalFrames;
+    }
+
+    return(pinLoad(cue, &cue->pins[idx], frame, frames));
+}
+
+bool wav_cue_clear(WAV_CUE *cue, unsigned idx)
+{
+    if ((cue->wf == NULL) || (idx >= WAV_CUE_MAX_CUES) ||
+        !pinRelease(cue, &cue->pins[idx])) {
+        return(false);
+    }
+    pinFree(&cue->pins[idx]);
+
+    return(true);
+}
+
+bool wav_cue_jump(WAV_CUE *cue, unsigned idx)
+{
+    if ((cue->wf == NULL) || (idx > WAV_CUE_LOOP) || !cue->pins[idx].ready) {
+        return(false);
+    }
+    cue->jumpReq = idx;
+
+    return(true);
+}
+
+bool wav_cue_loop(WAV_CUE *cue, uint32_t in, uint32_t out)
+{
+    WAV_CUE_PIN *pin = &cue->pins[WAV_CUE_LOOP];
+    uint32_t len = out - in;
+    bool inPlace;
+
+    if ((cue->wf == NULL) || (out <= in) || (out > cue->totalFrames) ||
+        (len > msFrames(cue, WAV_CUE_LOOP_MAX_MS))) {
+        return(false);
+    }
+
+    /* A shorter loop from the same in point is already pinned */
+    taskENTER_CRITICAL();
+    inPlace = pin->ready && (in == cue->loopIn) &&
+        (len + WAV_CUE_XFADE_FRAMES <= pin->frames);
+    if (inPlace) {
+        cue->loopOut = out;
+        cue->looping = true;
+        if ((cue->playing == pin) && (cue->playPos >= len)) {
+            cue->jumpReq = WAV_CUE_LOOP;
+        }
+    }
+    taskEXIT_CRITICAL();
+    if (inPlace) {
+        return(true);
+    }
+
+    if (!pinLoad(cue, pin, in, len + WAV_CUE_XFADE_FRAMES)) {
+        return(false);
+    }
+    cue->loopIn = in;
+    cue->loopOut = out;
+    cue->looping = true;
+
+    return(true);
+}
+
+bool wav_cue_reloop(WAV_CUE *cue)
+{
+    if ((cue->wf == NULL) || (cue->pins[WAV_CUE_LOOP].buf == NULL)) {
+        return(false);
+    }
+    cue->looping = true;
+
+    return(true);
+}
+
+void wav_cue_loop_exit(WAV_CUE *cue)
+{
+    cue->looping = false;
+}
+
+bool wav_cue_scratch(WAV_CUE *cue, bool on)
+{
+    if (cue->wf == NULL) {
+        return(false);
+    }
+    if (!on) {
+        cue->scratchReq = false;
+        return(true);
+    }
+    if ((cue->scratch.buf == NULL) &&
+        !wav_scratch_init(&cue->scratch, cue->channels, cue->totalFrames,
+            msFrames(cue, WAV_SCRATCH_WINDOW_MS))) {
+        return(false);
+    }
+    cue->scratchReq = true;
+
+    return(true);
+}
+
+bool wav_cue_jog(WAV_CUE *cue, float rate)
+{
+    if ((cue->wf == NULL) || !cue->scratchReq) {
+        return(false);
+    }
+    wav_scratch_jog(&cue->scratch, rate);
+
+    return(true);
+}
+
+uint32_t wav_cue_beat_frames(WAV_CUE *cue, unsigned num, unsigned den)
+{
+    if ((cue->bpm <= 0.0f) || (den == 0)) {
+        return(0);
+    }
+
+    return((uint32_t)((60.0f * cue->sampleRate * num) /
+        (cue->bpm * den) + 0.5f));
+}
+
+uint32_t wav_cue_position(WAV_CUE *cue)
+{
+    return(cue->playFrame);
+}
+
+void wav_cue_stats(WAV_CUE *cue, WAV_CUE_STATS *stats)
+{
+    unsigned i;
+
+    *stats = cue->stats;
+    stats->scratchMisses = cue->scratch.misses;
+    stats->scratchLoads = cue->scratch.loads;
+    stats->pinnedBytes = cue->scratch.numSlots * WAV_SCRATCH_BLOCK_FRAMES *
+        cue->channels * sizeof(int32_t);
+    for (i = 0; i <= WAV_CUE_LOOP; i++) {
+        stats->pinnedBytes +=
+            cue->pins[i].size * cue->channels * sizeof(int32_t);
+    }
+}
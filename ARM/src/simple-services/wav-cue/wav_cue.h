@@ -0,0 +1,177 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _wav_cue_h
+#define _wav_cue_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pa_ringbuffer.h"
+#include "wav_file.h"
+#include "wav_scratch.h"
+#include "wav_cue_cfg.h"
+
+#ifndef WAV_CUE_MAX_CUES
+#define WAV_CUE_MAX_CUES        (8)
+#endif
+
+/* Pin slot of the loop, after the hot cues */
+#define WAV_CUE_LOOP            (WAV_CUE_MAX_CUES)
+
+/*
+ * Loop and hot-cue engine for a PCM wave file source.
+ *
+ * The audio after each hot cue, and the whole of the active loop, is
+ * decoded into RAM ("pinned") by the source task.  The xfer path plays
+ * a pin straight away at a block boundary, crossfading from the
+ * outgoing audio, and asks the source task to seek the file to where
+ * the pin ends.  The ring then refills from there while the pin plays,
+ * so a jump never waits for the SD card.  Ring data written before the
+ * seek is dropped by the xfer path using the ring index the source task
+ * hands back with the seek.
+ *
+ * Loops run from their pin and wrap sample-accurately, crossfading the
+ * audio past the out point into the in point.  Exiting a loop plays on
+ * past the out point into the ring, which was seeked there on entry.
+ *
+ * Scratch mode plays from a window of decoded audio around the play
+ * position instead, at whatever rate and direction the jog sets (see
+ * wav_scratch.h).  Cues and loops are suspended while it is engaged.
+ * Releasing it slews the rate back to 1, seeks the ring to a block a
+ * pin's length ahead and crossfades into the ring there.
+ *
+ * Positions are in file frames.  Playback wraps at the end of the file
+ * like readWave() does.
+ */
+
+typedef struct WAV_CUE_PIN {
+    int32_t *buf;              /* Decoded, interleaved */
+    uint32_t size;             /* Frames 'buf' holds */
+    uint32_t frame;            /* File frame of buf[0] */
+    uint32_t frames;           /* Loaded so far */
+    uint32_t want;
+    volatile bool ready;       /* Fully loaded, the xfer path may play it */
+} WAV_CUE_PIN;
+
+typedef struct WAV_CUE_STATS {
+    uint32_t jumps;
+    uint32_t loops;            /* Loop wraps */
+    uint32_t seeks;
+    uint32_t underflows;
+    uint32_t readErrors;
+    uint32_t pinnedBytes;
+    uint32_t scratchBlocks;    /* Blocks rendered from the window */
+    uint32_t scratchMisses;    /* ... with taps that weren't resident */
+    uint32_t scratchLoads;
+    uint32_t renderTicks;      /* Cost of the last scratch block */
+    uint32_t peakRenderTicks;
+} WAV_CUE_STATS;
+
+typedef struct WAV_CUE {
+    WAV_FILE *wf;              /* NULL when detached */
+    unsigned channels;
+    unsigned blockFrames;
+    uint32_t totalFrames;
+    unsigned sampleRate;
+    float bpm;
+    WAV_CUE_PIN pins[WAV_CUE_MAX_CUES + 1];
+    int32_t *xfade;            /* Outgoing block of a jump */
+
+    /* Active loop is [loopIn, loopOut) */
+    uint32_t loopIn;
+    uint32_t loopOut;
+    volatile bool looping;
+
+    /* Owned by the xfer path */
+    volatile uint32_t playFrame;
+    WAV_CUE_PIN *playing;      /* NULL while playing the ring */
+    uint32_t playPos;
+    bool seam;                 /* Crossfading a loop wrap */
+    bool wake;
+    volatile int jumpReq;
+
+    /* Seek handshake, xfer path to source task and back */
+    volatile uint32_t seekFrame;
+    volatile unsigned seekReq;
+    volatile unsigned seekAck;
+    volatile ring_buffer_size_t seekMark;
+    volatile bool stale;
+
+    /* Scratch playback */
+    WAV_SCRATCH scratch;
+    volatile bool scratchReq;  /* Engaged by the control side */
+    bool scratching;           /* xfer path is playing the window */
+    bool handoff;              /* Ring seeked to handFrame on release */
+    uint32_t handFrame;
+    uint32_t (*timeStamp)(void);
+
+    WAV_CUE_STATS stats;
+} WAV_CUE;
+
+/*
+ * Attaches the engine to an opened source, or detaches it if 'wf' is
+ * NULL.  All cues and the loop are dropped either way.  FLAC sources
+ * can't seek so they are left detached and false is returned.
+ * 'timeStamp' times scratch rendering, it may be NULL.  Call with the
+ * source lock held.
+ */
+bool wav_cue_attach(WAV_CUE *cue, WAV_FILE *wf, unsigned blockFrames,
+    uint32_t (*timeStamp)(void));
+
+/*
+ * Cue and loop control, all with the source lock held.  Pins load in
+ * the background, a jump to a cue that isn't loaded yet fails.  A cue
+ * or loop can't be moved while it is playing, except that a loop may
+ * shrink in place (e.g. halved) since its audio is already pinned.
+ */
+bool wav_cue_set(WAV_CUE *cue, unsigned idx, uint32_t frame);
+bool wav_cue_clear(WAV_CUE *cue, unsigned idx);
+bool wav_cue_jump(WAV_CUE *cue, unsigned idx);
+bool wav_cue_loop(WAV_CUE *cue, uint32_t in, uint32_t out);
+bool wav_cue_reloop(WAV_CUE *cue);
+void wav_cue_loop_exit(WAV_CUE *cue);
+
+/*
+ * Engages or releases scratch mode.  The window is allocated on first
+ * use and playback switches over once it is loaded around the play
+ * position.  wav_cue_jog() sets the rate while engaged.
+ */
+bool wav_cue_scratch(WAV_CUE *cue, bool on);
+bool wav_cue_jog(WAV_CUE *cue, float rate);
+
+/* Loop length of num/den beats at the deck's tempo */
+uint32_t wav_cue_beat_frames(WAV_CUE *cue, unsigned num, unsigned den);
+
+/* File frame playing now */
+uint32_t wav_cue_position(WAV_CUE *cue);
+
+void wav_cue_stats(WAV_CUE *cue, WAV_CUE_STATS *stats);
+
+/*
+ * Source task side, with the source lock held.  wav_cue_seek() carries
+ * out a seek requested by the xfer path and must run before every ring
+ * write.  wav_cue_service() loads at most one scratch buffer of audio
+ * into the scratch window or a pin and returns true if there is more
+ * to load.
+ */
+bool wav_cue_seek(WAV_CUE *cue, PaUtilRingBuffer *rb);
+bool wav_cue_service(WAV_CUE *cue, void *scratch, size_t scratchSamples);
+
+/*
+ * Fills one block of 'blockFrames' frames.  Returns false, leaving
+ * the ring untouched, if there was no audio at all.  Sets 'wake' when
+ * the source task has a seek to carry out.
+ */
+bool wav_cue_xfer(WAV_CUE *cue, PaUtilRingBuffer *rb, int32_t *out,
+    bool *wake);
+
+#endif
@@ -0,0 +1,371 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "wav_cue_cfg.h"
+#include "wav_scratch.h"
+
+#ifndef WAV_SCRATCH_BLOCK_FRAMES
+#define WAV_SCRATCH_BLOCK_FRAMES    (1024)
+#endif
+
+#ifndef WAV_SCRATCH_SLEW
+#define WAV_SCRATCH_SLEW            (0.5f)
+#endif
+
+#ifndef WAV_SCRATCH_MAX_RATE
+#define WAV_SCRATCH_MAX_RATE        (4.0f)
+#endif
+
+#ifndef WAV_CUE_MALLOC
+#define WAV_CUE_MALLOC              malloc
+#endif
+
+#ifndef WAV_CUE_FREE
+#define WAV_CUE_FREE                free
+#endif
+
+#define BF                          (WAV_SCRATCH_BLOCK_FRAMES)
+
+/* Smallest window, the taps of one output frame may span two blocks */
+#define WAV_SCRATCH_MIN_SLOTS       (4)
+
+#define Q32_ONE                     (4294967296.0f)
+
+static uint32_t blockLen(WAV_SCRATCH *s, uint32_t block)
+{
+    uint32_t n = s->totalFrames - block * BF;
+
+    return((n > BF) ? BF : n);
+}
+
+/* Blocks between 'a' and 'b' going the short way round the file */
+static uint32_t blockDist(WAV_SCRATCH *s, uint32_t a, uint32_t b)
+{
+    uint32_t d = (a > b) ? a - b : b - a;
+
+    return((d > s->numBlocks - d) ? s->numBlocks - d : d);
+}
+
+static const int32_t *frameAt(WAV_SCRATCH *s, uint32_t frame)
+{
+    uint32_t block = frame / BF;
+    unsigned idx = block % s->numSlots;
+    WAV_SCRATCH_SLOT *slot = &s->slots[idx];
+
+    if (!slot->valid || (slot->block != block)) {
+        return(NULL);
+    }
+
+    return(s->buf + ((size_t)idx * BF + (frame - block * BF)) * s->channels);
+}
+
+static uint32_t wrapFrame(WAV_SCRATCH *s, int64_t frame)
+{
+    frame %= s->totalFrames;
+    if (frame < 0) {
+        frame += s->totalFrames;
+    }
+
+    return((uint32_t)frame);
+}
+
+/*
+ * Catmull-Rom through p1 and p2.  Float keeps 24 bits, whole frame
+ * positions are copied instead so rate +/-1 from a whole frame is
+ * bit-exact.
+ */
+static int32_t cubic(int32_t a, int32_t b, int32_t c, int32_t d, float t)
+{
+    float p0 = (float)a, p1 = (float)b, p2 = (float)c, p3 = (float)d;
+    float c1, c2, c3, y;
+
+    c1 = 0.5f * (p2 - p0);
+    c2 = p0 - 2.5f * p1 + 2.0f * p2 - 0.5f * p3;
+    c3 = 0.5f * (p3 - p0) + 1.5f * (p1 - p2);
+    y = ((c3 * t + c2) * t + c1) * t + p1;
+
+    if (y >= 2147483647.0f) {
+        return(INT32_MAX);
+    }
+    if (y <= -2147483648.0f) {
+        return(INT32_MIN);
+    }
+
+    return((int32_t)y);
+}
+
+bool wav_scratch_init(WAV_SCRATCH *s, unsigned channels, uint32_t totalFrames,
+    uint32_t windowFrames)
+{
+    memset(s, 0, sizeof(*s));
+    if ((channels == 0) || (totalFrames == 0)) {
+        return(false);
+    }
+
+    s->channels = channels;
+    s->totalFrames = totalFrames;
+    s->numBlocks = (totalFrames + BF - 1) / BF;
+    s->numSlots = (windowFrames + BF - 1) / BF;
+    if (s->numSlots < WAV_SCRATCH_MIN_SLOTS) {
+        s->numSlots = WAV_SCRATCH_MIN_SLOTS;
+    }
+    if (s->numSlots > s->numBlocks) {
+        s->numSlots = s->numBlocks;
+    }
+
+    s->slots = WAV_CUE_MALLOC(s->numSlots * sizeof(*s->slots));
+    s->buf = WAV_CUE_MALLOC((size_t)s->numSlots * BF * channels *
+        sizeof(int32_t));
+    if ((s->slots == NULL) || (s->buf == NULL)) {
+        wav_scratch_free(s);
+        return(false);
+    }
+    memset(s->slots, 0, s->numSlots * sizeof(*s->slots));
+    s->rate = 1.0f;
+    s->target = 1.0f;
+
+    return(true);
+}
+
+void wav_scratch_free(WAV_SCRATCH *s)
+{
+    if (s->slots) {
+        WAV_CUE_FREE(s->slots);
+    }
+    if (s->buf) {
+        WAV_CUE_FREE(s->buf);
+    }
+    memset(s, 0, sizeof(*s));
+}
+
+void wav_scratch_locate(WAV_SCRATCH *s, uint32_t frame)
+{
+    frame %= s->totalFrames;
+    s->head = (int64_t)frame << 32;
+    s->center = frame / BF;
+}
+
+void wav_scratch_jog(WAV_SCRATCH *s, float rate)
+{
+    if (rate > WAV_SCRATCH_MAX_RATE) {
+        rate = WAV_SCRATCH_MAX_RATE;
+    } else if (rate < -WAV_SCRATCH_MAX_RATE) {
+        rate = -WAV_SCRATCH_MAX_RATE;
+    }
+    s->target = rate;
+}
+
+bool wav_scratch_ready(WAV_SCRATCH *s, uint32_t frame, unsigned frames)
+{
+    uint32_t span = 2 * frames + 3;
+    uint32_t k = 0;
+
+    if (s->buf == NULL) {
+        return(false);
+    }
+
+    /* Every block from one tap behind 'frames' back to two ahead */
+    for (;;) {
+        if (!frameAt(s, wrapFrame(s, (int64_t)frame - frames - 1 + k))) {
+            return(false);
+        }
+        if (k == span) {
+            break;
+        }
+        k = (k + BF < span) ? k + BF : span;
+    }
+
+    return(true);
+}
+
+/* Source task ------------------------------------------------------------*/
+
+/* Nearest block that isn't resident, false if the window is full */
+static bool nextBlock(WAV_SCRATCH *s, uint32_t *block)
+{
+    uint32_t center = s->center;
+    uint32_t half = (s->numSlots - 1) / 2;
+    WAV_SCRATCH_SLOT *slot;
+    uint32_t b;
+    uint32_t d;
+    int side;
+
+    if (half > s->numBlocks / 2) {
+        half = s->numBlocks / 2;
+    }
+    for (d = 0; d <= half; d++) {
+        for (side = 0; side < 2; side++) {
+            /* Blocks the head is moving towards go first */
+            if ((side == 0) != s->reverse) {
+                b = (center + d) % s->numBlocks;
+            } else {
+                b = (center + s->numBlocks - d) % s->numBlocks;
+            }
+            slot = &s->slots[b % s->numSlots];
+            if (slot->valid && (slot->block == b)) {
+                continue;
+            }
+            /* Near the end of the file two window blocks can share a slot */
+            if (slot->valid && (blockDist(s, slot->block, center) <= d)) {
+                continue;
+            }
+            *block = b;
+            return(true);
+        }
+    }
+
+    return(false);
+}
+
+bool wav_scratch_service(WAV_SCRATCH *s, WAV_FILE *wf, void *scratch,
+    size_t scratchSamples, uint32_t *readErrors)
+{
+    WAV_SCRATCH_SLOT *slot;
+    unsigned ch = s->channels;
+    uint32_t frame;
+    size_t rsize;
+    unsigned n;
+
+    if (s->buf == NULL) {
+        return(false);
+    }
+
+    if (!s->filling) {
+        if (!nextBlock(s, &s->fillBlock)) {
+            return(false);
+        }
+        slot = &s->slots[s->fillBlock % s->numSlots];
+        taskENTER_CRITICAL();
+        slot->valid = false;
+        taskEXIT_CRITICAL();
+        s->fillFrames = 0;
+        s->filling = true;
+    }
+    slot = &s->slots[s->fillBlock % s->numSlots];
+
+    frame = s->fillBlock * BF + s->fillFrames;
+    n = blockLen(s, s->fillBlock) - s->fillFrames;
+    if (n > scratchSamples / ch) {
+        n = scratchSamples / ch;
+    }
+
+    rsize = readWaveAt(wf, (size_t)frame * ch, scratch, n * ch);
+    if (rsize != n * ch) {
+        /* Try again on the next wake rather than spinning on the card */
+        if (readErrors) {
+            (*readErrors)++;
+        }
+        s->filling = false;
+        return(false);
+    }
+    decodeWave(wf, scratch,
+        s->buf + ((size_t)(s->fillBlock % s->numSlots) * BF +
+            s->fillFrames) * ch, n * ch);
+
+    s->fillFrames += n;
+    if (s->fillFrames == blockLen(s, s->fillBlock)) {
+        taskENTER_CRITICAL();
+        slot->block = s->fillBlock;
+        slot->valid = true;
+        taskEXIT_CRITICAL();
+        s->filling = false;
+        s->loads++;
+    }
+
+    return(true);
+}
+
+/* xfer path --------------------------------------------------------------*/
+
+void wav_scratch_render(WAV_SCRATCH *s, int32_t *out, unsigned frames)
+{
+    const int64_t total = (int64_t)s->totalFrames << 32;
+    const int32_t *p0, *p1, *p2, *p3;
+    unsigned ch = s->channels;
+    int64_t head = s->head;
+    int64_t step, dstep;
+    float r0, r1, d;
+    uint32_t i, next;
+    uint32_t off;
+    float t;
+    unsigned n, c;
+    bool miss = false;
+
+    /* Ramp towards the jog target */
+    r0 = s->rate;
+    r1 = s->target;
+    d = r1 - r0;
+    if (d > WAV_SCRATCH_SLEW) {
+        r1 = r0 + WAV_SCRATCH_SLEW;
+    } else if (d < -WAV_SCRATCH_SLEW) {
+        r1 = r0 - WAV_SCRATCH_SLEW;
+    }
+    step = (int64_t)(r0 * Q32_ONE);
+    dstep = ((int64_t)(r1 * Q32_ONE) - step) / (int64_t)frames;
+
+    for (n = 0; n < frames; n++, out += ch) {
+        i = (uint32_t)(head >> 32);
+        off = i % BF;
+        if ((off >= 1) && (off + 2 < BF) && (i + 2 < s->totalFrames)) {
+            /* All four taps in one block */
+            p1 = frameAt(s, i);
+            p0 = p1 ? p1 - ch : NULL;
+            p2 = p1 ? p1 + ch : NULL;
+            p3 = p1 ? p2 + ch : NULL;
+        } else {
+            p0 = frameAt(s, i ? i - 1 : s->totalFrames - 1);
+            p1 = frameAt(s, i);
+            next = (i + 1 < s->totalFrames) ? i + 1 : 0;
+            p2 = frameAt(s, next);
+            next = (next + 1 < s->totalFrames) ? next + 1 : 0;
+            p3 = frameAt(s, next);
+        }
+
+        t = (float)(uint32_t)head * (1.0f / Q32_ONE);
+        if (!p0 || !p1 || !p2 || !p3) {
+            memset(out, 0, ch * sizeof(int32_t));
+            miss = true;
+        } else if ((uint32_t)head == 0) {
+            memcpy(out, p1, ch * sizeof(int32_t));
+        } else {
+            for (c = 0; c < ch; c++) {
+                out[c] = cubic(p0[c], p1[c], p2[c], p3[c], t);
+            }
+        }
+
+        head += step;
+        step += dstep;
+        if (head >= total) {
+            head -= total;
+        } else if (head < 0) {
+            head += total;
+        }
+    }
+
+    s->head = head;
+    s->rate = r1;
+    s->reverse = (r1 < 0.0f);
+    s->center = (uint32_t)(head >> 32) / BF;
+    if (miss) {
+        s->misses++;
+    }
+}
+
+uint32_t wav_scratch_frame(WAV_SCRATCH *s)
+{
+    return((uint32_t)(s->head >> 32));
+}
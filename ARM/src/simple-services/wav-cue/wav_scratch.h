@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _wav_scratch_h
+#define _wav_scratch_h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "wav_file.h"
+#include "wav_cue_cfg.h"
+
+/*
+ * Variable-rate, either-direction playback of a PCM wave file.
+ *
+ * Decoded audio around the read head is kept in a direct-mapped window
+ * of fixed size blocks.  The source task refills it nearest block first,
+ * working outwards from where the xfer path says the head is, leaning
+ * the way the head is moving.  The xfer path renders from the window
+ * with a 4-point cubic interpolator, a block whose taps aren't resident
+ * plays silence and is counted as a miss.
+ *
+ * The head is a signed Q32.32 file frame and wraps at the end of the
+ * file.  The rate ramps linearly across each block towards the target
+ * the jog control sets, by at most WAV_SCRATCH_SLEW per block.
+ */
+
+typedef struct WAV_SCRATCH_SLOT {
+    uint32_t block;            /* File block held */
+    volatile bool valid;
+} WAV_SCRATCH_SLOT;
+
+typedef struct WAV_SCRATCH {
+    int32_t *buf;              /* numSlots blocks, interleaved */
+    WAV_SCRATCH_SLOT *slots;
+    unsigned numSlots;
+    unsigned channels;
+    uint32_t totalFrames;
+    uint32_t numBlocks;
+
+    /* Source task fill in progress */
+    uint32_t fillBlock;
+    uint32_t fillFrames;
+    bool filling;
+
+    /* Owned by the xfer path */
+    volatile uint32_t center;  /* Block the window follows */
+    volatile bool reverse;
+    int64_t head;
+    float rate;
+    volatile float target;
+    uint32_t misses;
+    uint32_t loads;
+} WAV_SCRATCH;
+
+/*
+ * Allocates a window of 'windowFrames' around the head.  Nothing is
+ * resident until the source task services it.
+ */
+bool wav_scratch_init(WAV_SCRATCH *s, unsigned channels, uint32_t totalFrames,
+    uint32_t windowFrames);
+void wav_scratch_free(WAV_SCRATCH *s);
+
+/* Moves the head, and the window with it, at the current rate */
+void wav_scratch_locate(WAV_SCRATCH *s, uint32_t frame);
+
+/* Target rate in file frames per output frame, negative is reverse */
+void wav_scratch_jog(WAV_SCRATCH *s, float rate);
+
+/* True if the taps for 'frames' output frames either side are resident */
+bool wav_scratch_ready(WAV_SCRATCH *s, uint32_t frame, unsigned frames);
+
+/*
+ * Source task side.  Loads at most one scratch buffer of the nearest
+ * missing block and returns true if there is more to load.
+ */
+bool wav_scratch_service(WAV_SCRATCH *s, WAV_FILE *wf, void *scratch,
+    size_t scratchSamples, uint32_t *readErrors);
+
+/* xfer path, renders 'frames' frames and advances the head */
+void wav_scratch_render(WAV_SCRATCH *s, int32_t *out, unsigned frames);
+
+/* Whole frame under the head, 0 .. totalFrames - 1 */
+uint32_t wav_scratch_frame(WAV_SCRATCH *s);
+
+#endif
@@ -13,6 +13,10 @@
 #include <string.h>
 #include <stdio.h>
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "wav_file_cfg.h"
 #include "wav_file.h"
 
@@ -48,6 +52,7 @@
  *
  */
 #define WAVE_FORMAT_PCM         (0x0001)
+#define WAVE_FORMAT_IEEE_FLOAT  (0x0003)
 #define WAVE_FORMAT_EXTENSIBLE  (0xFFFE)
 #define WAVEFORMATEXTENSIBLE_MINIMUM_SIZE (22)
 
@@ -134,8 +139,14 @@ static uint32_t fix_uint32(uint32_t val, WAVE_ENDIAN endian)
 static bool translateWaveFmt(WAVE_INFO *waveInfo, WAVEFORMATX *waveFormat, WAVE_ENDIAN endian)
 {
     WAVEFORMATPCM *waveFormatPcm =  (WAVEFORMATPCM *)waveFormat;
+    unsigned bits;
+    uint32_t format;
 
-    if (waveInfo->audioFormat == WAVE_FORMAT_EXTENSIBLE) {
+    waveInfo->extensionSize = 0;
+    waveInfo->validBitsPerSample = 0;
+    waveInfo->channelMask = 0;
+
+    if (fix_uint16(waveFormat->wFormatTag, endian) == WAVE_FORMAT_EXTENSIBLE) {
 
         WAVEFORMATEX *waveFormatEx = (WAVEFORMATEX *)waveFormat;
         waveInfo->extensionSize = fix_uint16(waveFormatEx->cbSize, endian);
@@ -155,25 +166,32 @@ static bool translateWaveFmt(WAVE_INFO *waveInfo, WAVEFORMATX *waveFormat, WAVE_
     waveInfo->bitsPerSample = fix_uint16(waveFormatPcm->wBitsPerSample, endian);
     waveInfo->Signed = (waveInfo->bitsPerSample > 8) ? true : false;
 
-    if (waveInfo->validBitsPerSample > 0) {
-        if (waveInfo->validBitsPerSample == 32) {
-            waveInfo->waveFmt = WAVE_FMT_SIGNED_32BIT_LE;
-        } else {
-            waveInfo->waveFmt = WAVE_FMT_SIGNED_16BIT_LE;
-        }
-    } else if (waveInfo->bitsPerSample > 0) {
-        if (waveInfo->bitsPerSample == 32) {
-            waveInfo->waveFmt = WAVE_FMT_SIGNED_32BIT_LE;
-        } else {
-            waveInfo->waveFmt = WAVE_FMT_SIGNED_16BIT_LE;
-        }
+    /* The container size, not the valid bits, sets the sample layout */
+    bits = waveInfo->bitsPerSample;
+    if ((bits == 0) && (waveInfo->numChannels > 0)) {
+        bits = (waveInfo->blockAlign / waveInfo->numChannels) * 8;
+    }
+
+    /* Extensible files carry the real format tag in the sub-format GUID */
+    format = waveInfo->audioFormat;
+    if ((format == WAVE_FORMAT_EXTENSIBLE) &&
+        (waveInfo->extensionSize >= WAVEFORMATEXTENSIBLE_MINIMUM_SIZE)) {
+        format = fix_uint32(waveInfo->subAudioFormat.Data1, endian);
+    }
+
+    if (format == WAVE_FORMAT_IEEE_FLOAT) {
+        waveInfo->waveFmt = (bits == 32) ?
+            WAVE_FMT_FLOAT_32BIT_LE : WAVE_FMT_UNKNOWN;
+    } else if (bits == 32) {
+        waveInfo->waveFmt = WAVE_FMT_SIGNED_32BIT_LE;
+    } else if (bits == 24) {
+        waveInfo->waveFmt = WAVE_FMT_SIGNED_24BIT_LE;
+    } else if (bits == 8) {
+        waveInfo->waveFmt = WAVE_FMT_UNSIGNED_8BIT;
+    } else if (bits == 16) {
+        waveInfo->waveFmt = WAVE_FMT_SIGNED_16BIT_LE;
     } else {
-        waveInfo->waveFmt = (waveInfo->blockAlign / waveInfo->numChannels) * 8;
-        if (waveInfo->waveFmt == 32) {
-            waveInfo->waveFmt = WAVE_FMT_SIGNED_32BIT_LE;
-        } else {
-            waveInfo->waveFmt = WAVE_FMT_SIGNED_16BIT_LE;
-        }
+        waveInfo->waveFmt = WAVE_FMT_UNKNOWN;
     }
 
     return(true);
@@ -204,6 +222,7 @@ static bool processSubChunks(FILE *f, WAVE_INFO *waveInfo, WAVE_ENDIAN endian)
                     WAVEFORMATX *waveFormat = (WAVEFORMATX *)fmtContainer;
                     uint16_t wFormatTag = fix_uint16(waveFormat->wFormatTag, endian);
                     if ((wFormatTag == WAVE_FORMAT_PCM) ||
+                        (wFormatTag == WAVE_FORMAT_IEEE_FLOAT) ||
                         (wFormatTag == WAVE_FORMAT_EXTENSIBLE)) {
                         bool ok = translateWaveFmt(waveInfo, waveFormat, endian);
                         if (ok) {
@@ -222,7 +241,7 @@ static bool processSubChunks(FILE *f, WAVE_INFO *waveInfo, WAVE_ENDIAN endian)
                 if (waveInfo->dataSize == 0) {
                     fseek(f, 0, SEEK_END);
                     waveInfo->dataSize = ftell(f) - waveInfo->dataOffset;
-                    fseek(f, SEEK_SET, waveInfo->dataOffset);
+                    fseek(f, waveInfo->dataOffset, SEEK_SET);
                 }
                 fseek(f, header.size, SEEK_CUR);
                 found |= FOUND_DATA_CHUNK;
@@ -274,6 +293,48 @@ static bool isWave(WAV_FILE *waveFile)
     return(isWave);
 }
 
+static size_t flacRead(void *usr, void *buf, size_t len)
+{
+    FILE *f = (FILE *)usr;
+    size_t rsize;
+
+    rsize = fread(buf, 1, len, f);
+    if ((rsize == 0) && ferror(f)) {
+        return((size_t)-1);
+    }
+    return(rsize);
+}
+
+static bool isFlac(WAV_FILE *waveFile)
+{
+    WAVE_INFO *waveInfo = &waveFile->waveInfo;
+    const FLAC_STREAM_INFO *info;
+
+    fseek(waveFile->f, 0, SEEK_SET);
+    waveFile->flac = flac_dec_open(flacRead, waveFile->f);
+    if (waveFile->flac == NULL) {
+        return(false);
+    }
+
+    /* Describe the decoded stream, 32-bit samples in native channels */
+    info = flac_dec_info(waveFile->flac);
+    memset(waveInfo, 0, sizeof(*waveInfo));
+    memcpy(waveInfo->riffHead, "fLaC", 4);
+    waveInfo->numChannels = info->channels;
+    waveInfo->sampleRate = info->sampleRate;
+    waveInfo->bitsPerSample = sizeof(int32_t) * 8;
+    waveInfo->validBitsPerSample = info->bitsPerSample;
+    waveInfo->blockAlign = info->channels * sizeof(int32_t);
+    waveInfo->byteRate = info->sampleRate * waveInfo->blockAlign;
+    waveInfo->Signed = true;
+    waveInfo->dataOffset = flac_dec_audio_offset(waveFile->flac);
+    waveInfo->dataSize =
+        (uint32_t)info->totalFrames * waveInfo->blockAlign;
+    waveInfo->waveFmt = WAVE_FMT_FLAC;
+
+    return(true);
+}
+
 static bool writeWaveHeader(WAV_FILE *wf)
 {
     FILE *f = wf->f;
@@ -285,7 +346,8 @@ static bool writeWaveHeader(WAV_FILE *wf)
 
     memcpy(riff.RIFF, "RIFF", 4);
     memcpy(riff.WAVE, "WAVE", 4);
-    riff.size = wf->dataSize + sizeof(fmt) + 2 * sizeof(subChunkHdr);
+    riff.size = sizeof(riff.WAVE) + sizeof(fmt) + 2 * sizeof(subChunkHdr) +
+        wf->dataSize * wf->wordSizeBytes;
     fwrite(&riff, sizeof(riff), 1, f);
 
     memcpy(&subChunkHdr.type, "fmt ", 4);
@@ -318,10 +380,14 @@ bool openWave(WAV_FILE *wf)
 #else
         wf->fileBuf = NULL;
 #endif
+        wf->flac = NULL;
         if (wf->isSrc) {
-            ok = isWave(wf);
+            ok = isWave(wf) || isFlac(wf);
             if (ok) {
                 fseek(wf->f, wf->waveInfo.dataOffset, SEEK_SET);
+                if (wf->flac) {
+                    flac_dec_restart(wf->flac);
+                }
                 wf->channels = wf->waveInfo.numChannels;
                 wf->sampleRate = wf->waveInfo.sampleRate;
                 wf->frameSizeBytes = wf->waveInfo.blockAlign;
@@ -331,6 +397,14 @@ bool openWave(WAV_FILE *wf)
                 wf->enabled = true;
             }
         } else {
+            /* Sinks record integer PCM in the requested word size */
+            switch (wf->wordSizeBytes) {
+                case 1: wf->waveInfo.waveFmt = WAVE_FMT_UNSIGNED_8BIT; break;
+                case 2: wf->waveInfo.waveFmt = WAVE_FMT_SIGNED_16BIT_LE; break;
+                case 3: wf->waveInfo.waveFmt = WAVE_FMT_SIGNED_24BIT_LE; break;
+                case 4: wf->waveInfo.waveFmt = WAVE_FMT_SIGNED_32BIT_LE; break;
+                default: wf->waveInfo.waveFmt = WAVE_FMT_UNKNOWN; break;
+            }
             writeWaveHeader(wf);
             wf->enabled = true;
             wf->dataOffset = 0;
@@ -343,6 +417,10 @@ bool openWave(WAV_FILE *wf)
 
 void overrideWave(WAV_FILE *wf, unsigned channels)
 {
+    /* FLAC frames always decode to the stream's own channel count */
+    if (wf->flac) {
+        return;
+    }
     wf->channels = channels;
     wf->frameSizeBytes = wf->channels * wf->wordSizeBytes;
     wf->dataSize -= wf->dataSize % wf->channels;
@@ -359,6 +437,9 @@ void closeWave(WAV_FILE *wf)
     if (wf->fileBuf) {
         WAVE_FILE_FREE(wf->fileBuf); wf->fileBuf = NULL;
     }
+    if (wf->flac) {
+        flac_dec_close(wf->flac); wf->flac = NULL;
+    }
     wf->enabled = false;
     wf->channels = 0;
 }
@@ -371,35 +452,112 @@ size_t readWave(WAV_FILE *wf, void *buf, size_t samples)
     bool ok;
     bool resetData;
 
+    /* Streams without a length in STREAMINFO play to the end of file */
     remaining = wf->dataSize - wf->dataOffset;
-    size = samples > remaining ? remaining : samples;
+    size = samples;
+    if (wf->dataSize || !wf->flac) {
+        size = samples > remaining ? remaining : samples;
+    }
 
     resetData = false; ok = true;
 
-    rsize = fread(buf, wf->wordSizeBytes, size, wf->f);
-    if (rsize != size) {
-        if (feof(wf->f)) {
-            resetData = true;
-        } else if (ferror(wf->f)) {
-            ok = false;
-        } else if (rsize <= 0) {
-            ok = false;
+    if (wf->flac) {
+        rsize = flac_dec_read(wf->flac, (int32_t *)buf, size);
+        ok = (rsize != (size_t)-1);
+        if (ok) {
+            wf->dataOffset += rsize;
+            resetData = (rsize < size) ||
+                (wf->dataSize && (wf->dataOffset >= wf->dataSize));
+        }
+    } else if (wf->read) {
+        /* Positioned reads leave the stdio stream where it is */
+        rsize = wf->read(wf->readUsr,
+            wf->waveInfo.dataOffset + wf->dataOffset * wf->wordSizeBytes,
+            buf, size * wf->wordSizeBytes);
+        ok = (rsize != (size_t)-1);
+        if (ok) {
+            rsize /= wf->wordSizeBytes;
+            wf->dataOffset += rsize;
+            resetData = (rsize < size) || (wf->dataOffset >= wf->dataSize);
         }
     } else {
-        wf->dataOffset += rsize;
-        if (wf->dataOffset >= wf->dataSize) {
-            resetData = true;
+        rsize = fread(buf, wf->wordSizeBytes, size, wf->f);
+        if (rsize != size) {
+            if (feof(wf->f)) {
+                resetData = true;
+            } else if (ferror(wf->f)) {
+                ok = false;
+            } else if (rsize <= 0) {
+                ok = false;
+            }
+        } else {
+            wf->dataOffset += rsize;
+            if (wf->dataOffset >= wf->dataSize) {
+                resetData = true;
+            }
         }
     }
 
     if (resetData) {
         fseek(wf->f, wf->waveInfo.dataOffset, SEEK_SET);
         wf->dataOffset = 0;
+        if (wf->flac) {
+            flac_dec_restart(wf->flac);
+        }
     }
 
     return(ok ? rsize : -1);
 }
 
+bool seekWave(WAV_FILE *wf, size_t dataOffset)
+{
+    if (wf->flac || (dataOffset >= wf->dataSize)) {
+        return(false);
+    }
+    if (wf->read == NULL) {
+        if (fseek(wf->f, wf->waveInfo.dataOffset +
+                dataOffset * wf->wordSizeBytes, SEEK_SET) != 0) {
+            return(false);
+        }
+    }
+    wf->dataOffset = dataOffset;
+
+    return(true);
+}
+
+size_t readWaveAt(WAV_FILE *wf, size_t dataOffset, void *buf, size_t samples)
+{
+    size_t rsize;
+    long pos;
+
+    if (wf->flac || (dataOffset >= wf->dataSize)) {
+        return(-1);
+    }
+    if (samples > wf->dataSize - dataOffset) {
+        samples = wf->dataSize - dataOffset;
+    }
+
+    if (wf->read) {
+        rsize = wf->read(wf->readUsr,
+            wf->waveInfo.dataOffset + dataOffset * wf->wordSizeBytes,
+            buf, samples * wf->wordSizeBytes);
+        return((rsize == (size_t)-1) ? rsize : rsize / wf->wordSizeBytes);
+    }
+
+    /* Put the stream back where readWave() left it */
+    pos = ftell(wf->f);
+    rsize = -1;
+    if ((pos >= 0) && (fseek(wf->f, wf->waveInfo.dataOffset +
+            dataOffset * wf->wordSizeBytes, SEEK_SET) == 0)) {
+        rsize = fread(buf, wf->wordSizeBytes, samples, wf->f);
+    }
+    if ((pos < 0) || (fseek(wf->f, pos, SEEK_SET) != 0)) {
+        rsize = -1;
+    }
+
+    return(rsize);
+}
+
 size_t writeWave(WAV_FILE *wf, void *buf, size_t samples)
 {
     size_t wsize;
@@ -416,3 +574,199 @@ size_t writeWave(WAV_FILE *wf, void *buf, size_t samples)
 
     return (ok ? wsize : -1);
 }
+
+/***********************************************************************
+ * Sample format converters
+ **********************************************************************/
+/* Float to Q31 with the same clipping and truncation as NEON vcvt */
+static int32_t floatToQ31(float f)
+{
+    if (f != f) {
+        return(0);
+    }
+    if (f >= 1.0f) {
+        return(INT32_MAX);
+    }
+    if (f < -1.0f) {
+        return(INT32_MIN);
+    }
+    return((int32_t)(f * 2147483648.0f));
+}
+
+void decodeWave(WAV_FILE *wf, const void *src, int32_t *dst, size_t samples)
+{
+    const uint8_t *s8 = src;
+    size_t i = 0;
+    int16_t s16;
+    float f;
+
+    switch (wf->waveInfo.waveFmt) {
+        case WAVE_FMT_SIGNED_32BIT_LE:
+        case WAVE_FMT_FLAC:
+            if (dst != src) {
+                memcpy(dst, src, samples * sizeof(int32_t));
+            }
+            break;
+        case WAVE_FMT_SIGNED_16BIT_LE:
+#if defined(__ARM_NEON)
+            for (; (i + 8) <= samples; i += 8) {
+                int16x8_t v = vreinterpretq_s16_u8(vld1q_u8(s8));
+                vst1q_s32(dst + i, vshll_n_s16(vget_low_s16(v), 16));
+                vst1q_s32(dst + i + 4, vshll_n_s16(vget_high_s16(v), 16));
+                s8 += 16;
+            }
+#endif
+            for (; i < samples; i++) {
+                memcpy(&s16, s8, sizeof(s16));
+                dst[i] = (int32_t)s16 << 16;
+                s8 += 2;
+            }
+            break;
+        case WAVE_FMT_SIGNED_24BIT_LE:
+#if defined(__ARM_NEON)
+            /* De-interleave 16 samples, re-interleave with a zero LSB */
+            for (; (i + 16) <= samples; i += 16) {
+                uint8x16x3_t in = vld3q_u8(s8);
+                uint8x16x4_t out;
+                out.val[0] = vdupq_n_u8(0);
+                out.val[1] = in.val[0];
+                out.val[2] = in.val[1];
+                out.val[3] = in.val[2];
+                vst4q_u8((uint8_t *)(dst + i), out);
+                s8 += 48;
+            }
+#endif
+            for (; i < samples; i++) {
+                dst[i] = (int32_t)(((uint32_t)s8[0] << 8) |
+                    ((uint32_t)s8[1] << 16) | ((uint32_t)s8[2] << 24));
+                s8 += 3;
+            }
+            break;
+        case WAVE_FMT_FLOAT_32BIT_LE:
+#if defined(__ARM_NEON)
+            for (; (i + 4) <= samples; i += 4) {
+                float32x4_t v = vreinterpretq_f32_u8(vld1q_u8(s8));
+                vst1q_s32(dst + i, vcvtq_n_s32_f32(v, 31));
+                s8 += 16;
+            }
+#endif
+            for (; i < samples; i++) {
+                memcpy(&f, s8, sizeof(f));
+                dst[i] = floatToQ31(f);
+                s8 += 4;
+            }
+            break;
+        case WAVE_FMT_UNSIGNED_8BIT:
+#if defined(__ARM_NEON)
+            for (; (i + 8) <= samples; i += 8) {
+                int8x8_t v = vreinterpret_s8_u8(veor_u8(vld1_u8(s8), vdup_n_u8(0x80)));
+                int16x8_t w = vshll_n_s8(v, 8);
+                vst1q_s32(dst + i, vshll_n_s16(vget_low_s16(w), 16));
+                vst1q_s32(dst + i + 4, vshll_n_s16(vget_high_s16(w), 16));
+                s8 += 8;
+            }
+#endif
+            for (; i < samples; i++) {
+                dst[i] = (int32_t)((uint32_t)(*s8++ ^ 0x80) << 24);
+            }
+            break;
+        default:
+            memset(dst, 0, samples * sizeof(int32_t));
+            break;
+    }
+}
+
+void encodeWave(WAV_FILE *wf, const int32_t *src, void *dst, size_t samples)
+{
+    uint8_t *d8 = dst;
+    size_t i = 0;
+    int16_t s16;
+    float f;
+
+    switch (wf->waveInfo.waveFmt) {
+        case WAVE_FMT_SIGNED_32BIT_LE:
+            memcpy(dst, src, samples * sizeof(int32_t));
+            break;
+        case WAVE_FMT_SIGNED_16BIT_LE:
+#if defined(__ARM_NEON)
+            for (; (i + 8) <= samples; i += 8) {
+                int16x8_t v = vcombine_s16(
+                    vshrn_n_s32(vld1q_s32(src + i), 16),
+                    vshrn_n_s32(vld1q_s32(src + i + 4), 16));
+                vst1q_u8(d8, vreinterpretq_u8_s16(v));
+                d8 += 16;
+            }
+#endif
+            for (; i < samples; i++) {
+                s16 = (int16_t)(src[i] >> 16);
+                memcpy(d8, &s16, sizeof(s16));
+                d8 += 2;
+            }
+            break;
+        case WAVE_FMT_SIGNED_24BIT_LE:
+#if defined(__ARM_NEON)
+            /* Drop the LSB of 16 samples and pack them */
+            for (; (i + 16) <= samples; i += 16) {
+                uint8x16x4_t in = vld4q_u8((const uint8_t *)(src + i));
+                uint8x16x3_t out;
+                out.val[0] = in.val[1];
+                out.val[1] = in.val[2];
+                out.val[2] = in.val[3];
+                vst3q_u8(d8, out);
+                d8 += 48;
+            }
+#endif
+            for (; i < samples; i++) {
+                d8[0] = (uint8_t)(src[i] >> 8);
+                d8[1] = (uint8_t)(src[i] >> 16);
+                d8[2] = (uint8_t)(src[i] >> 24);
+                d8 += 3;
+            }
+            break;
+        case WAVE_FMT_FLOAT_32BIT_LE:
+#if defined(__ARM_NEON)
+            for (; (i + 4) <= samples; i += 4) {
+                float32x4_t v = vcvtq_n_f32_s32(vld1q_s32(src + i), 31);
+                vst1q_u8(d8, vreinterpretq_u8_f32(v));
+                d8 += 16;
+            }
+#endif
+            for (; i < samples; i++) {
+                f = (float)src[i] * (1.0f / 2147483648.0f);
+                memcpy(d8, &f, sizeof(f));
+                d8 += 4;
+            }
+            break;
+        case WAVE_FMT_UNSIGNED_8BIT:
+#if defined(__ARM_NEON)
+            for (; (i + 8) <= samples; i += 8) {
+                int16x8_t w = vcombine_s16(
+                    vshrn_n_s32(vld1q_s32(src + i), 16),
+                    vshrn_n_s32(vld1q_s32(src + i + 4), 16));
+                uint8x8_t v = vreinterpret_u8_s8(vshrn_n_s16(w, 8));
+                vst1_u8(d8, veor_u8(v, vdup_n_u8(0x80)));
+                d8 += 8;
+            }
+#endif
+            for (; i < samples; i++) {
+                *d8++ = (uint8_t)((uint32_t)src[i] >> 24) ^ 0x80;
+            }
+            break;
+        default:
+            memset(dst, 0, samples * wf->wordSizeBytes);
+            break;
+    }
+}
+
+const char *waveFmtName(WAVE_FMT fmt)
+{
+    switch (fmt) {
+        case WAVE_FMT_SIGNED_32BIT_LE: return("S32_LE");
+        case WAVE_FMT_SIGNED_16BIT_LE: return("S16_LE");
+        case WAVE_FMT_SIGNED_24BIT_LE: return("S24_3LE");
+        case WAVE_FMT_FLOAT_32BIT_LE:  return("FLOAT_LE");
+        case WAVE_FMT_UNSIGNED_8BIT:   return("U8");
+        case WAVE_FMT_FLAC:            return("FLAC");
+        default:                       return("unknown");
+    }
+}
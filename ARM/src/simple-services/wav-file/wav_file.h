@@ -19,10 +19,16 @@
 #include "FreeRTOS.h"
 #include "semphr.h"
 
+#include "flac_dec.h"
+
 typedef enum WAVE_FMT {
     WAVE_FMT_UNKNOWN = 0,
     WAVE_FMT_SIGNED_32BIT_LE,
-    WAVE_FMT_SIGNED_16BIT_LE
+    WAVE_FMT_SIGNED_16BIT_LE,
+    WAVE_FMT_SIGNED_24BIT_LE,      /* 3-byte packed */
+    WAVE_FMT_FLOAT_32BIT_LE,       /* IEEE float, +/-1.0 full scale */
+    WAVE_FMT_UNSIGNED_8BIT,
+    WAVE_FMT_FLAC                  /* Decoded to left-justified 32-bit */
 } WAVE_FMT;
 
 #pragma pack(push,1)
@@ -55,6 +61,15 @@ typedef struct WAVE_INFO {
     WAVE_FMT waveFmt;
 } WAVE_INFO;
 
+/*
+ * Positioned reader used for PCM data instead of fread() when set, e.g.
+ * the SDRAM track cache.  'offset' is from the start of the file.
+ * Returns the bytes read, short at the end of the file, or (size_t)-1
+ * on error.
+ */
+typedef size_t (*WAVE_FILE_READ)(void *usr, uint32_t offset, void *buf,
+    size_t len);
+
 typedef struct WAV_FILE {
     char *fname;
     FILE *f;
@@ -70,12 +85,42 @@ typedef struct WAV_FILE {
     bool isSrc;
     void *fileBuf;
     size_t dataOffset;
+    FLAC_DEC *flac;
+    struct WAV_REC *rec;       /* Sinks recorded by wav_rec instead */
+    WAVE_FILE_READ read;
+    void *readUsr;
 } WAV_FILE;
 
+/*
+ * Sources open RIFF/RIFX WAVE or FLAC files.  FLAC files are decoded
+ * by readWave(), which then returns 32-bit samples ready for the ring
+ * and decodeWave() becomes a copy.
+ */
 bool openWave(WAV_FILE *wf);
 void closeWave(WAV_FILE *wf);
 size_t readWave(WAV_FILE *wf, void *buf, size_t samples);
 size_t writeWave(WAV_FILE *wf, void *buf, size_t samples);
+
+/*
+ * PCM sources only.  seekWave() moves the stream readWave() continues
+ * from, readWaveAt() reads native samples at any data offset without
+ * disturbing it.  Offsets are in samples from the start of the data.
+ * Call both with the file's lock held.
+ */
+bool seekWave(WAV_FILE *wf, size_t dataOffset);
+size_t readWaveAt(WAV_FILE *wf, size_t dataOffset, void *buf, size_t samples);
 void overrideWave(WAV_FILE *wf, unsigned channels);
 
+/*
+ * Block converters between a file's native sample format and
+ * left-justified signed 32-bit samples.  'samples' is a sample count,
+ * not a frame count.  Floats are clipped to full scale.  'src' and
+ * 'dst' need not be aligned beyond their natural word size.
+ */
+void decodeWave(WAV_FILE *wf, const void *src, int32_t *dst, size_t samples);
+void encodeWave(WAV_FILE *wf, const int32_t *src, void *dst, size_t samples);
+
+/* Short name of a WAVE_FMT, "unknown" if unsupported */
+const char *waveFmtName(WAVE_FMT fmt);
+
 #endif
@@ -0,0 +1,574 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ff.h"
+
+#include "wav_file.h"
+#include "wav_rec_cfg.h"
+#include "wav_rec.h"
+
+#ifndef WAV_REC_PREALLOC_SECONDS
+#define WAV_REC_PREALLOC_SECONDS  (30 * 60)
+#endif
+
+#ifndef WAV_REC_MAX_FILES
+#define WAV_REC_MAX_FILES         (8)
+#endif
+
+#ifndef WAV_REC_WRITE_SIZE
+#define WAV_REC_WRITE_SIZE        (32 * 1024)
+#endif
+
+#ifndef WAV_REC_COMMIT_SECONDS
+#define WAV_REC_COMMIT_SECONDS    (2)
+#endif
+
+#ifndef WAV_REC_MALLOC
+#define WAV_REC_MALLOC malloc
+#endif
+
+#ifndef WAV_REC_FREE
+#define WAV_REC_FREE free
+#endif
+
+#if FF_USE_EXPAND == 0 || FF_USE_FASTSEEK == 0
+#error "wav_rec requires FF_USE_EXPAND and FF_USE_FASTSEEK"
+#endif
+
+/*
+ * The header fills exactly one sector: RIFF, fmt and data chunk
+ * headers with a JUNK chunk soaking up the rest so audio starts on a
+ * sector boundary.
+ */
+#define WAV_REC_HDR_SIZE          (512)
+#define WAV_REC_JUNK_SIZE         (WAV_REC_HDR_SIZE - 12 - 24 - 8 - 8)
+
+/* Keeps both the RIFF size and the FAT32 file size within 32 bits */
+#define WAV_REC_MAX_DATA          (0xFFFFFFFFUL - WAV_REC_HDR_SIZE)
+
+/*
+ * Cluster link map for fast seeks.  A preallocated file is a single
+ * fragment which needs 4 entries.
+ */
+#define WAV_REC_CLMT_SIZE         (8)
+
+/*
+ * Room past the end of a staging block for the tail of a sample that
+ * straddles it, rounded up to keep the header sector buffer aligned.
+ */
+#define WAV_REC_SLACK             (64)
+
+typedef struct WAV_REC_FILE {
+    FIL f;
+    WAV_FILE wf;                /* Format for encodeWave() */
+    DWORD clmt[WAV_REC_CLMT_SIZE];
+    uint8_t *buf;               /* Staging block */
+    uint8_t *hdr;               /* Header sector */
+    size_t fill;
+    FSIZE_t pos;                /* File offset of the staging block */
+    FSIZE_t prealloc;
+    uint32_t flushed;           /* Audio bytes on the card */
+    uint32_t committed;         /* Audio bytes in the last header */
+    uint32_t commitBytes;
+    unsigned firstChannel;
+    bool open;
+} WAV_REC_FILE;
+
+struct WAV_REC {
+    WAV_REC_FILE file[WAV_REC_MAX_FILES];
+    unsigned nFiles;
+    unsigned channels;
+    unsigned stemChannels;
+    unsigned chanPos;
+    uint64_t samples;
+    uint64_t maxSamples;
+    size_t bufSize;
+    WAV_REC_STATS stats;
+};
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    put16(p, (uint16_t)v); put16(p + 2, (uint16_t)(v >> 16));
+}
+
+/* Builds the header sector for 'dataBytes' of audio */
+static void buildHeader(WAV_REC_FILE *rf, uint8_t *h, uint32_t dataBytes)
+{
+    WAV_FILE *wf = &rf->wf;
+
+    memset(h, 0, WAV_REC_HDR_SIZE);
+
+    memcpy(h + 0, "RIFF", 4);
+    put32(h + 4, (WAV_REC_HDR_SIZE - 8) + dataBytes);
+    memcpy(h + 8, "WAVE", 4);
+
+    memcpy(h + 12, "fmt ", 4);
+    put32(h + 16, 16);
+    put16(h + 20, 1);                                   /* PCM */
+    put16(h + 22, wf->channels);
+    put32(h + 24, wf->sampleRate);
+    put32(h + 28, wf->sampleRate * wf->frameSizeBytes);
+    put16(h + 32, wf->frameSizeBytes);
+    put16(h + 34, wf->wordSizeBytes * 8);
+
+    memcpy(h + 36, "JUNK", 4);
+    put32(h + 40, WAV_REC_JUNK_SIZE);
+
+    memcpy(h + WAV_REC_HDR_SIZE - 8, "data", 4);
+    put32(h + WAV_REC_HDR_SIZE - 4, dataBytes);
+}
+
+/* Whole frames among the bytes that reached the card */
+static uint32_t playableBytes(WAV_REC_FILE *rf)
+{
+    return(rf->flushed - (rf->flushed % rf->wf.frameSizeBytes));
+}
+
+/*
+ * Rewrites the header sector in place and syncs the directory entry.
+ * The link map makes both seeks free while inside the preallocation.
+ */
+static bool commitHeader(WAV_REC *rec, WAV_REC_FILE *rf)
+{
+    uint32_t dataBytes = playableBytes(rf);
+    FSIZE_t pos = f_tell(&rf->f);
+    FRESULT res;
+    UINT bw;
+
+    buildHeader(rf, rf->hdr, dataBytes);
+    res = f_lseek(&rf->f, 0);
+    if (res == FR_OK) {
+        res = f_write(&rf->f, rf->hdr, WAV_REC_HDR_SIZE, &bw);
+    }
+    if (res == FR_OK) {
+        res = f_lseek(&rf->f, pos);
+    }
+    if (res == FR_OK) {
+        res = f_sync(&rf->f);
+    }
+    if (res != FR_OK) {
+        rec->stats.errors++;
+        return(false);
+    }
+
+    rf->committed = dataBytes;
+    rec->stats.commits++;
+
+    return(true);
+}
+
+/*
+ * Writes 'len' bytes of the staging block.  The first block carries
+ * the header so later blocks start on a cluster boundary.
+ */
+static bool flushBlock(WAV_REC *rec, WAV_REC_FILE *rf, size_t len)
+{
+    size_t audio = len;
+    FRESULT res;
+    UINT bw;
+
+    if (len == 0) {
+        return(true);
+    }
+
+    if (rf->pos == 0) {
+        audio -= WAV_REC_HDR_SIZE;
+        buildHeader(rf, rf->buf, audio - (audio % rf->wf.frameSizeBytes));
+    }
+
+    /* FatFs can't grow a file through the link map */
+    if (rf->f.cltbl && (rf->pos + len > rf->prealloc)) {
+        rf->f.cltbl = NULL;
+    }
+    if (rf->f.cltbl == NULL) {
+        rec->stats.appendBlocks++;
+    }
+
+    res = f_write(&rf->f, rf->buf, len, &bw);
+    if ((res != FR_OK) || (bw != len)) {
+        rec->stats.errors++;
+        return(false);
+    }
+
+    rec->stats.blocks++;
+    rf->pos += len;
+    rf->flushed += audio;
+
+    if (rf->pos == len) {
+        rf->committed = playableBytes(rf);
+    } else if ((rf->flushed - rf->committed) >= rf->commitBytes) {
+        return(commitHeader(rec, rf));
+    }
+
+    return(true);
+}
+
+/* Encodes samples into a file's staging block, writing full blocks */
+static bool stage(WAV_REC *rec, WAV_REC_FILE *rf, const int32_t *src,
+    size_t samples)
+{
+    unsigned wordSize = rf->wf.wordSizeBytes;
+    size_t space;
+    size_t n;
+
+    while (samples) {
+        /* Round up, a straddling sample spills into the slack */
+        space = rec->bufSize - rf->fill;
+        n = (space + wordSize - 1) / wordSize;
+        if (n > samples) {
+            n = samples;
+        }
+        encodeWave(&rf->wf, src, rf->buf + rf->fill, n);
+        rf->fill += n * wordSize;
+        src += n; samples -= n;
+        if (rf->fill >= rec->bufSize) {
+            if (!flushBlock(rec, rf, rec->bufSize)) {
+                return(false);
+            }
+            rf->fill -= rec->bufSize;
+            memcpy(rf->buf, rf->buf + rec->bufSize, rf->fill);
+        }
+    }
+
+    return(true);
+}
+
+/* <base>.wav becomes <base>_<n>.wav, names without .wav get _<n> */
+static char *stemName(const char *path, unsigned n)
+{
+    size_t len = strlen(path);
+    const char *ext = "";
+    char *name;
+    char num[4];
+    int i;
+
+    if ((len >= 4) && (strcmp(path + len - 4, ".wav") == 0)) {
+        ext = path + len - 4;
+        len -= 4;
+    }
+
+    i = sizeof(num) - 1; num[i] = '\0';
+    do {
+        num[--i] = '0' + (n % 10); n /= 10;
+    } while (n && i);
+
+    name = WAV_REC_MALLOC(len + 1 + strlen(&num[i]) + strlen(ext) + 1);
+    if (name) {
+        memcpy(name, path, len);
+        name[len] = '_';
+        strcpy(name + len + 1, &num[i]);
+        strcat(name, ext);
+    }
+
+    return(name);
+}
+
+static void setFormat(WAV_FILE *wf, unsigned channels, unsigned sampleRate,
+    unsigned wordSizeBytes)
+{
+    memset(wf, 0, sizeof(*wf));
+    wf->channels = channels;
+    wf->sampleRate = sampleRate;
+    wf->wordSizeBytes = wordSizeBytes;
+    wf->frameSizeBytes = channels * wordSizeBytes;
+    switch (wordSizeBytes) {
+        case 2: wf->waveInfo.waveFmt = WAVE_FMT_SIGNED_16BIT_LE; break;
+        case 3: wf->waveInfo.waveFmt = WAVE_FMT_SIGNED_24BIT_LE; break;
+        default: wf->waveInfo.waveFmt = WAVE_FMT_SIGNED_32BIT_LE; break;
+    }
+}
+
+/*
+ * Reserves the largest contiguous run up to the configured recording
+ * time or 'share' of the free space, halving the request while the
+ * volume is too fragmented.  No preallocation at all still records,
+ * every block then allocates.
+ */
+static void preallocate(WAV_REC *rec, WAV_REC_FILE *rf, uint32_t clusterBytes,
+    uint64_t share)
+{
+    uint64_t want;
+    uint64_t cap;
+    FRESULT res;
+
+    want = (uint64_t)WAV_REC_PREALLOC_SECONDS * rf->wf.sampleRate *
+        rf->wf.frameSizeBytes + WAV_REC_HDR_SIZE;
+    cap = (uint64_t)WAV_REC_HDR_SIZE + WAV_REC_MAX_DATA;
+    if (cap > share) {
+        cap = share;
+    }
+    if (want > cap) {
+        want = cap;
+    }
+
+    want = (want + clusterBytes - 1) / clusterBytes * clusterBytes;
+    cap = 0xFFFFFFFFUL / clusterBytes * clusterBytes;
+    if (want > cap) {
+        want = cap;
+    }
+
+    rf->prealloc = 0;
+    while (want >= rec->bufSize) {
+        res = f_expand(&rf->f, (FSIZE_t)want, 1);
+        if (res == FR_OK) {
+            rf->prealloc = want;
+            break;
+        }
+        if (res != FR_DENIED) {
+            break;
+        }
+        want = (want / 2 + clusterBytes - 1) / clusterBytes * clusterBytes;
+    }
+
+    if (rf->prealloc) {
+        rf->clmt[0] = WAV_REC_CLMT_SIZE;
+        rf->f.cltbl = rf->clmt;
+        if (f_lseek(&rf->f, CREATE_LINKMAP) != FR_OK) {
+            rf->f.cltbl = NULL;
+        }
+        f_lseek(&rf->f, 0);
+        rec->stats.preallocBytes += rf->prealloc;
+    }
+}
+
+static bool openFile(WAV_REC *rec, WAV_REC_FILE *rf, const char *name,
+    unsigned channels, unsigned sampleRate, unsigned wordSizeBytes,
+    unsigned filesLeft)
+{
+    uint32_t clusterBytes;
+    size_t bufSize;
+    FATFS *fs;
+    DWORD freeClusters;
+    FRESULT res;
+
+    res = f_open(&rf->f, name, FA_CREATE_ALWAYS | FA_WRITE);
+    if (res != FR_OK) {
+        return(false);
+    }
+    rf->open = true;
+
+    setFormat(&rf->wf, channels, sampleRate, wordSizeBytes);
+    rf->commitBytes = WAV_REC_COMMIT_SECONDS * sampleRate *
+        rf->wf.frameSizeBytes;
+
+    /* Whole clusters per write, sized once for all files */
+    clusterBytes = (uint32_t)rf->f.obj.fs->csize * FF_MAX_SS;
+    if (rec->bufSize == 0) {
+        bufSize = (WAV_REC_WRITE_SIZE + clusterBytes - 1) /
+            clusterBytes * clusterBytes;
+        rec->bufSize = bufSize;
+        rec->stats.clusterBytes = clusterBytes;
+        rec->stats.writeBytes = bufSize;
+    }
+
+    rf->buf = WAV_REC_MALLOC(rec->bufSize + WAV_REC_SLACK + WAV_REC_HDR_SIZE);
+    if (rf->buf == NULL) {
+        return(false);
+    }
+    rf->hdr = rf->buf + rec->bufSize + WAV_REC_SLACK;
+
+    /* Header placeholder, filled in when the first block goes out */
+    rf->fill = WAV_REC_HDR_SIZE;
+    rf->pos = 0;
+
+    /* Stems opened later get an even share of what is left */
+    res = f_getfree(name, &freeClusters, &fs);
+    if (res != FR_OK) {
+        return(false);
+    }
+    preallocate(rec, rf, clusterBytes,
+        (uint64_t)freeClusters * clusterBytes / filesLeft);
+
+    /* Record the allocation so a power loss doesn't leak it */
+    return(f_sync(&rf->f) == FR_OK);
+}
+
+static bool closeFile(WAV_REC *rec, WAV_REC_FILE *rf)
+{
+    FRESULT res;
+    bool ok = true;
+
+    if (!rf->open) {
+        return(true);
+    }
+
+    ok = flushBlock(rec, rf, rf->fill);
+    if (ok) {
+        ok = commitHeader(rec, rf);
+    }
+
+    /* Drop any partial frame and the unused preallocation */
+    res = f_lseek(&rf->f, WAV_REC_HDR_SIZE + rf->committed);
+    rf->f.cltbl = NULL;
+    if (res == FR_OK) {
+        res = f_truncate(&rf->f);
+    }
+    if (f_close(&rf->f) != FR_OK) {
+        res = FR_DISK_ERR;
+    }
+    if (res != FR_OK) {
+        rec->stats.errors++;
+        ok = false;
+    }
+    rf->open = false;
+
+    return(ok);
+}
+
+static void freeRec(WAV_REC *rec)
+{
+    unsigned i;
+
+    for (i = 0; i < rec->nFiles; i++) {
+        if (rec->file[i].buf) {
+            WAV_REC_FREE(rec->file[i].buf);
+        }
+    }
+    WAV_REC_FREE(rec);
+}
+
+WAV_REC *wav_rec_open(const char *path, unsigned channels,
+    unsigned sampleRate, unsigned wordSizeBytes, unsigned stemChannels)
+{
+    WAV_REC *rec;
+    WAV_REC_FILE *rf;
+    unsigned stemCh;
+    unsigned largest;
+    char *name;
+    bool ok;
+    unsigned i;
+
+    if ((channels == 0) || (wordSizeBytes < 2) || (wordSizeBytes > 4)) {
+        return(NULL);
+    }
+    if ((stemChannels == 0) || (stemChannels > channels)) {
+        stemChannels = channels;
+    }
+    if ((channels + stemChannels - 1) / stemChannels > WAV_REC_MAX_FILES) {
+        return(NULL);
+    }
+
+    rec = WAV_REC_MALLOC(sizeof(*rec));
+    if (rec == NULL) {
+        return(NULL);
+    }
+    memset(rec, 0, sizeof(*rec));
+    rec->channels = channels;
+    rec->stemChannels = stemChannels;
+    rec->nFiles = (channels + stemChannels - 1) / stemChannels;
+
+    ok = true;
+    for (i = 0; ok && (i < rec->nFiles); i++) {
+        rf = &rec->file[i];
+        rf->firstChannel = i * stemChannels;
+        stemCh = channels - rf->firstChannel;
+        if (stemCh > stemChannels) {
+            stemCh = stemChannels;
+        }
+        if (rec->nFiles > 1) {
+            name = stemName(path, i + 1);
+        } else {
+            name = (char *)path;
+        }
+        ok = (name != NULL) &&
+            openFile(rec, rf, name, stemCh, sampleRate, wordSizeBytes,
+                rec->nFiles - i);
+        if (name && (name != path)) {
+            WAV_REC_FREE(name);
+        }
+    }
+
+    if (!ok) {
+        /* Don't leave the preallocations behind */
+        for (i = 0; i < rec->nFiles; i++) {
+            rf = &rec->file[i];
+            if (rf->open) {
+                rf->f.cltbl = NULL;
+                if (f_lseek(&rf->f, 0) == FR_OK) {
+                    f_truncate(&rf->f);
+                }
+                f_close(&rf->f);
+            }
+        }
+        freeRec(rec);
+        return(NULL);
+    }
+
+    /* The widest stem hits the RIFF limit first */
+    largest = stemChannels * wordSizeBytes;
+    rec->maxSamples = (uint64_t)(WAV_REC_MAX_DATA / largest) * channels;
+    rec->stats.files = rec->nFiles;
+
+    return(rec);
+}
+
+size_t wav_rec_write(WAV_REC *rec, const int32_t *src, size_t samples)
+{
+    WAV_REC_FILE *rf;
+    size_t total;
+    size_t n;
+
+    if (samples > rec->maxSamples - rec->samples) {
+        samples = rec->maxSamples - rec->samples;
+    }
+    total = samples;
+
+    /* Split each frame into runs of channels that share a stem */
+    while (samples) {
+        rf = &rec->file[rec->chanPos / rec->stemChannels];
+        if (rec->nFiles == 1) {
+            n = samples;
+        } else {
+            n = rf->firstChannel + rf->wf.channels - rec->chanPos;
+            if (n > samples) {
+                n = samples;
+            }
+        }
+        if (!stage(rec, rf, src, n)) {
+            return((size_t)-1);
+        }
+        src += n; samples -= n;
+        rec->chanPos = (rec->chanPos + n) % rec->channels;
+    }
+
+    rec->samples += total;
+
+    return(total);
+}
+
+bool wav_rec_close(WAV_REC *rec)
+{
+    bool ok = true;
+    unsigned i;
+
+    for (i = 0; i < rec->nFiles; i++) {
+        if (!closeFile(rec, &rec->file[i])) {
+            ok = false;
+        }
+    }
+    freeRec(rec);
+
+    return(ok);
+}
+
+void wav_rec_stats(WAV_REC *rec, WAV_REC_STATS *stats)
+{
+    *stats = rec->stats;
+    stats->frames = rec->samples / rec->channels;
+}
@@ -0,0 +1,75 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _wav_rec_h
+#define _wav_rec_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Multitrack WAV recorder writing straight to a FatFs volume.
+ *
+ * Each file is preallocated as one contiguous run of clusters with
+ * f_expand() and written in whole-cluster blocks from a staging buffer
+ * so FatFs hands them to the disk driver without touching its sector
+ * cache or the FAT.  The header occupies the first sector (padded with
+ * a JUNK chunk) and is rewritten every WAV_REC_COMMIT_SECONDS so a
+ * power loss leaves a playable file holding everything up to the last
+ * commit.
+ *
+ * A session may be split into stem files of 'stemChannels' channels
+ * each, named <base>_1.wav, <base>_2.wav, ...  The last stem gets
+ * whatever channels remain.
+ */
+
+typedef struct WAV_REC_STATS {
+    unsigned files;
+    uint32_t clusterBytes;
+    uint32_t writeBytes;       /* Staging block size */
+    uint64_t preallocBytes;    /* Summed over all files */
+    uint64_t frames;
+    uint32_t blocks;
+    uint32_t appendBlocks;     /* Blocks written past the preallocation */
+    uint32_t commits;
+    uint32_t errors;
+} WAV_REC_STATS;
+
+typedef struct WAV_REC WAV_REC;
+
+/*
+ * Creates the file(s) and reserves space.  'path' must name a FatFs
+ * volume, e.g. "sd:take1.wav".  'wordSizeBytes' is 2, 3 or 4.  A
+ * 'stemChannels' of 0 records every channel into one file.  Returns
+ * NULL on a file system error or if out of memory.
+ */
+WAV_REC *wav_rec_open(const char *path, unsigned channels,
+    unsigned sampleRate, unsigned wordSizeBytes, unsigned stemChannels);
+
+/*
+ * Records interleaved left-justified 32-bit samples, the ring buffer
+ * format.  'samples' need not be a whole number of frames.  Returns the
+ * number of samples taken, short once the RIFF size limit is reached
+ * and (size_t)-1 on a write error.
+ */
+size_t wav_rec_write(WAV_REC *rec, const int32_t *src, size_t samples);
+
+/*
+ * Writes out staged audio, commits the final header, returns unused
+ * preallocated space and closes all files.  Returns false if anything
+ * failed along the way.
+ */
+bool wav_rec_close(WAV_REC *rec);
+
+void wav_rec_stats(WAV_REC *rec, WAV_REC_STATS *stats);
+
+#endif
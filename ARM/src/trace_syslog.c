@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "trace_syslog.h"
+#include "trace_log.h"
+#include "syslog.h"
+#include "clocks.h"
+#include "ipc.h"
+#include "umm_malloc.h"
+#include "task_cfg.h"
+
+#define TRACE_SYSLOG_PERIOD_MS  (100)
+#define TRACE_SYSLOG_LINE_MAX   (128)
+
+static const char *coreNames[TRACE_LOG_MAX_CORES] = {
+    "ARM", "SHARC0", "SHARC1"
+};
+
+static SemaphoreHandle_t drainLock;
+static uint32_t lastLost[TRACE_LOG_MAX_CORES];
+
+void trace_syslog_drain(void)
+{
+    TRACE_LOG_ENTRY entry;
+    TRACE_LOG *log;
+    char msg[TRACE_SYSLOG_LINE_MAX];
+    uint32_t us;
+    unsigned core;
+
+    xSemaphoreTake(drainLock, portMAX_DELAY);
+    for (core = 0; core < TRACE_LOG_MAX_CORES; core++) {
+        log = trace_log_get(core);
+        if (log == NULL) {
+            continue;
+        }
+        while (trace_log_read(log, &entry)) {
+            trace_log_format(&entry, msg, sizeof(msg));
+            us = entry.timestamp / (CGU_TS_CLK / 1000000);
+            syslog_printf("%s %10u us: %s", coreNames[core],
+                (unsigned)us, msg);
+        }
+        if (log->lost != lastLost[core]) {
+            syslog_printf("%s: %u trace entries lost", coreNames[core],
+                (unsigned)(log->lost - lastLost[core]));
+            lastLost[core] = log->lost;
+        }
+    }
+    xSemaphoreGive(drainLock);
+}
+
+static portTASK_FUNCTION(traceSyslogTask, pvParameters)
+{
+    while (1) {
+        trace_syslog_drain();
+        vTaskDelay(pdMS_TO_TICKS(TRACE_SYSLOG_PERIOD_MS));
+    }
+}
+
+void trace_syslog_init(void)
+{
+    void *mem;
+
+    drainLock = xSemaphoreCreateMutex();
+
+    mem = umm_malloc_heap(UMM_SDRAM_HEAP,
+        TRACE_LOG_SIZE(TRACE_LOG_ARM_ENTRIES));
+    trace_log_init(mem, TRACE_LOG_ARM_ENTRIES, IPC_CORE_ARM);
+
+    xTaskCreate(traceSyslogTask, "TraceTask", TRACE_TASK_STACK_SIZE,
+        NULL, TRACE_TASK_PRIORITY, NULL);
+}
@@ -0,0 +1,26 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _trace_syslog_h
+#define _trace_syslog_h
+
+#include "trace_log.h"
+
+/*
+ * Creates the ARM trace log and a background task that formats the
+ * ARM and SHARC trace logs into the syslog.
+ */
+void trace_syslog_init(void);
+
+/* Formats all pending trace entries into the syslog (task context) */
+void trace_syslog_drain(void);
+
+#endif
@@ -12,6 +12,10 @@
 #include <stdint.h>
 #include <string.h>
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "util.h"
 
 uint32_t roundUpPow2(uint32_t x)
@@ -75,3 +79,81 @@ void copyAndConvert(
         }
     }
 }
+
+/*
+ * Byte-reverses (network <-> host order) and word size converts a
+ * contiguous run of interleaved samples.  Only 16 and 32-bit words
+ * are supported.  16-bit samples are left justified when widened and
+ * truncated when narrowed, the same as copyAndConvert().
+ *
+ * 'src' and 'dst' need not be aligned.
+ */
+void swapAndConvert(
+    void *src, unsigned srcWordSize,
+    void *dst, unsigned dstWordSize,
+    unsigned samples)
+{
+    uint8_t *s8 = src;
+    uint8_t *d8 = dst;
+    uint32_t u32;
+    uint16_t u16;
+    unsigned i = 0;
+
+    if ((srcWordSize == sizeof(uint16_t)) && (dstWordSize == sizeof(uint32_t))) {
+#if defined(__ARM_NEON)
+        for (; (i + 8) <= samples; i += 8) {
+            int16x8_t v = vreinterpretq_s16_u8(vrev16q_u8(vld1q_u8(s8)));
+            vst1q_u8(d8, vreinterpretq_u8_s32(vshll_n_s16(vget_low_s16(v), 16)));
+            vst1q_u8(d8 + 16, vreinterpretq_u8_s32(vshll_n_s16(vget_high_s16(v), 16)));
+            s8 += 16; d8 += 32;
+        }
+#endif
+        for (; i < samples; i++) {
+            u32 = ((uint32_t)s8[0] << 24) | ((uint32_t)s8[1] << 16);
+            memcpy(d8, &u32, sizeof(u32));
+            s8 += 2; d8 += 4;
+        }
+    } else if ((srcWordSize == sizeof(uint32_t)) && (dstWordSize == sizeof(uint32_t))) {
+#if defined(__ARM_NEON)
+        for (; (i + 4) <= samples; i += 4) {
+            vst1q_u8(d8, vrev32q_u8(vld1q_u8(s8)));
+            s8 += 16; d8 += 16;
+        }
+#endif
+        for (; i < samples; i++) {
+            u32 = ((uint32_t)s8[0] << 24) | ((uint32_t)s8[1] << 16) |
+                  ((uint32_t)s8[2] << 8) | (uint32_t)s8[3];
+            memcpy(d8, &u32, sizeof(u32));
+            s8 += 4; d8 += 4;
+        }
+    } else if ((srcWordSize == sizeof(uint32_t)) && (dstWordSize == sizeof(uint16_t))) {
+#if defined(__ARM_NEON)
+        for (; (i + 8) <= samples; i += 8) {
+            uint16x8_t v = vcombine_u16(
+                vshrn_n_u32(vreinterpretq_u32_u8(vld1q_u8(s8)), 16),
+                vshrn_n_u32(vreinterpretq_u32_u8(vld1q_u8(s8 + 16)), 16)
+            );
+            vst1q_u8(d8, vrev16q_u8(vreinterpretq_u8_u16(v)));
+            s8 += 32; d8 += 16;
+        }
+#endif
+        for (; i < samples; i++) {
+            memcpy(&u32, s8, sizeof(u32));
+            d8[0] = (uint8_t)(u32 >> 24);
+            d8[1] = (uint8_t)(u32 >> 16);
+            s8 += 4; d8 += 2;
+        }
+    } else if ((srcWordSize == sizeof(uint16_t)) && (dstWordSize == sizeof(uint16_t))) {
+#if defined(__ARM_NEON)
+        for (; (i + 8) <= samples; i += 8) {
+            vst1q_u8(d8, vrev16q_u8(vld1q_u8(s8)));
+            s8 += 16; d8 += 16;
+        }
+#endif
+        for (; i < samples; i++) {
+            u16 = ((uint16_t)s8[0] << 8) | (uint16_t)s8[1];
+            memcpy(d8, &u16, sizeof(u16));
+            s8 += 2; d8 += 2;
+        }
+    }
+}
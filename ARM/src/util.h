@@ -15,6 +15,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <time.h>
+#include <sys/time.h>
 
 /* Sprinkled throughout source */
 uint32_t getTimeStamp(void);
@@ -32,6 +33,12 @@ void copyAndConvert(
     unsigned frames, bool zero
 );
 
+void swapAndConvert(
+    void *src, unsigned srcWordSize,
+    void *dst, unsigned dstWordSize,
+    unsigned samples
+);
+
 uint32_t roundUpPow2(uint32_t x);
 
 #endif
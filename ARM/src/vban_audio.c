@@ -21,69 +21,127 @@
 #include "util.h"
 #include "vban_audio.h"
 #include "vban_stream.h"
-#include "umm_malloc.h"
+#include "audio_pool.h"
+#include "trace_log.h"
 #include "clock_domain.h"
 
-static unsigned vbanRxUnderflow = 0;
+static unsigned vbanRxUnderflow[VBAN_RX_STREAMS];
+static unsigned vbanRxOverflow[VBAN_RX_STREAMS];
 static unsigned vbanTxOverflow = 0;
 
+static const STREAM_ID vbanRxStreamIDs[VBAN_RX_STREAMS] = {
+    STREAM_ID_VBAN_RX, STREAM_ID_VBAN2_RX, STREAM_ID_VBAN3_RX
+};
+static const unsigned vbanRxClockDomainMasks[VBAN_RX_STREAMS] = {
+    CLOCK_DOMAIN_BITM_VBAN_RX, CLOCK_DOMAIN_BITM_VBAN2_RX,
+    CLOCK_DOMAIN_BITM_VBAN3_RX
+};
+
 /* Task notification values */
 enum {
     VBAN_TASK_NO_ACTION,
-    VBAN_TASK_AUDIO_RX_MORE_DATA,
     VBAN_TASK_AUDIO_TX_MORE_DATA,
 };
 
-static SYSTEM_AUDIO_TYPE rxBuffer[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
-static SYSTEM_AUDIO_TYPE txBuffer[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
+STREAM_ID vbanRxStreamID(unsigned idx)
+{
+    return(vbanRxStreamIDs[idx]);
+}
 
-/* This task puts VBAN frames into the VBAN Rx ring buffer */
-portTASK_FUNCTION(vbanRxTask, pvParameters)
+unsigned vbanRxClockDomainMask(unsigned idx)
 {
-    APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
-    VBAN_STREAM *vbanRx = &context->vbanRx;
-    PaUtilRingBuffer *vbanRxRB = context->vbanRxRB;
-    uint32_t whatToDo;
-    unsigned samplesIn;
+    return(vbanRxClockDomainMasks[idx]);
+}
+
+/*
+ * This callback puts VBAN payloads into the Rx ring buffer of the
+ * stream they were demultiplexed to (lwIP receive context).  When the
+ * stream and routable channel counts match, samples are converted
+ * straight into the ring buffer's write regions.  Otherwise channels
+ * are remapped a block at a time.
+ */
+static void vbanRxAudio(VBAN_STREAM *vbanRx, void *data, unsigned samples,
+    void *usrPtr)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
+    unsigned idx = vbanRx - context->vbanRx;
+    PaUtilRingBuffer *vbanRxRB = context->vbanRxRB[idx];
+    ring_buffer_size_t size1, size2;
+    void *buf1, *buf2;
     unsigned samplesOut;
     unsigned framesIn;
     unsigned framesOut;
-    void *data;
+    uint8_t *in = data;
+    void *rxBuffer;
 
-    while (1) {
-        xSemaphoreTake((SemaphoreHandle_t)vbanRx->lock, portMAX_DELAY);
-        if (vbanRx->enabled) {
-            samplesIn = vbanReadSamplesAvailable(vbanRx, &data);
-            samplesOut = PaUtil_GetRingBufferWriteAvailable(vbanRxRB);
-            while (samplesIn && (samplesOut >= samplesIn)) {
-                framesIn = samplesIn / vbanRx->streamChannels;
-                framesOut = samplesOut / vbanRx->channels;
-                if (framesOut > SYSTEM_BLOCK_SIZE) {
-                    framesOut = SYSTEM_BLOCK_SIZE;
-                }
-                if (framesOut > framesIn) {
-                    framesOut = framesIn;
-                }
-                copyAndConvert(
-                    data, vbanRx->wordSizeBytes, vbanRx->streamChannels,
-                    rxBuffer, sizeof(SYSTEM_AUDIO_TYPE), vbanRx->channels,
-                    framesOut, false
-                );
-                PaUtil_WriteRingBuffer(vbanRxRB, rxBuffer, framesOut * vbanRx->channels);
-                vbanReadSamples(vbanRx, framesOut * vbanRx->streamChannels);
-                samplesOut = PaUtil_GetRingBufferWriteAvailable(vbanRxRB);
-                samplesIn = vbanReadSamplesAvailable(vbanRx, &data);
-                if (vbanRx->preRoll && (samplesOut < (VBAN_RING_BUF_SAMPLES / 2))) {
-                    vbanRx->preRoll = false;
-                }
+    if (vbanRxRB == NULL) {
+        return;
+    }
+
+    framesIn = samples / vbanRx->streamChannels;
+    samplesOut = PaUtil_GetRingBufferWriteAvailable(vbanRxRB);
+    if (samplesOut < (framesIn * vbanRx->channels)) {
+        vbanRxOverflow[idx]++;
+        TRACE_LOG3(TRACE_ID_VBAN_RX_OVERFLOW, idx, samplesOut,
+            framesIn * vbanRx->channels);
+        return;
+    }
+
+    if (vbanRx->streamChannels == vbanRx->channels) {
+        PaUtil_GetRingBufferWriteRegions(vbanRxRB, samples,
+            &buf1, &size1, &buf2, &size2);
+        copyAndConvert(
+            in, vbanRx->wordSizeBytes, 1,
+            buf1, sizeof(SYSTEM_AUDIO_TYPE), 1,
+            size1, false
+        );
+        if (size2) {
+            copyAndConvert(
+                in + size1 * vbanRx->wordSizeBytes, vbanRx->wordSizeBytes, 1,
+                buf2, sizeof(SYSTEM_AUDIO_TYPE), 1,
+                size2, false
+            );
+        }
+        PaUtil_AdvanceRingBufferWriteIndex(vbanRxRB, samples);
+    } else {
+        rxBuffer = audio_pool_scratch_take(AUDIO_POOL_SCRATCH_NET);
+        if (rxBuffer == NULL) {
+            vbanRxOverflow[idx]++;
+            return;
+        }
+        while (framesIn) {
+            framesOut = framesIn;
+            if (framesOut > SYSTEM_BLOCK_SIZE) {
+                framesOut = SYSTEM_BLOCK_SIZE;
             }
-        } else {
-            PaUtil_FlushRingBuffer(vbanRxRB);
-            vbanRx->preRoll = true;
+            copyAndConvert(
+                in, vbanRx->wordSizeBytes, vbanRx->streamChannels,
+                rxBuffer, sizeof(SYSTEM_AUDIO_TYPE), vbanRx->channels,
+                framesOut, true
+            );
+            PaUtil_WriteRingBuffer(vbanRxRB, rxBuffer, framesOut * vbanRx->channels);
+            in += framesOut * vbanRx->streamChannels * vbanRx->wordSizeBytes;
+            framesIn -= framesOut;
         }
-        xSemaphoreGive((SemaphoreHandle_t)vbanRx->lock);
-        whatToDo = ulTaskNotifyTake(pdTRUE, 1);
+        audio_pool_scratch_give(AUDIO_POOL_SCRATCH_NET);
     }
+
+    samplesOut = PaUtil_GetRingBufferWriteAvailable(vbanRxRB);
+    if (vbanRx->preRoll && (samplesOut < (vbanRxRB->bufferSize / 2))) {
+        vbanRx->preRoll = false;
+    }
+}
+
+/* Wakes the Tx task once VBAN_TX_WAKE_BLOCKS are queued (ISR context) */
+static void vbanTxHighWatermark(PaUtilRingBuffer *rb, void *usrPtr)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
+    BaseType_t wake = pdFALSE;
+
+    xTaskNotifyFromISR(context->vbanTxTaskHandle,
+        VBAN_TASK_AUDIO_TX_MORE_DATA, eSetValueWithoutOverwrite, &wake
+    );
+    portYIELD_FROM_ISR(wake);
 }
 
 /* This task emits VBAN frames from the VBAN Tx ring buffer */
@@ -91,96 +149,136 @@ portTASK_FUNCTION(vbanTxTask, pvParameters)
 {
     APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
     VBAN_STREAM *vbanTx = &context->vbanTx;
-    PaUtilRingBuffer *vbanTxRB = context->vbanTxRB;
+    PaUtilRingBuffer *vbanTxRB;
+    ring_buffer_size_t size1, size2;
+    void *buf1, *buf2;
     uint32_t whatToDo;
     unsigned samplesIn;
     unsigned samplesOut;
     unsigned wsize;
-    bool ok;
     void *data;
 
     while (1) {
         xSemaphoreTake((SemaphoreHandle_t)vbanTx->lock, portMAX_DELAY);
-        if (vbanTx->enabled) {
+        vbanTxRB = context->vbanTxRB;
+        if (vbanTx->enabled && vbanTxRB) {
             samplesIn = PaUtil_GetRingBufferReadAvailable(vbanTxRB);
             samplesOut = vbanTx->channels * SYSTEM_BLOCK_SIZE;
-            ok = true;
-            while (ok && (samplesIn > samplesOut)) {
+            while (samplesIn > samplesOut) {
                 wsize = vbanWriteSamplesAvailable(vbanTx, &data);
                 if (wsize > samplesOut) {
                     wsize = samplesOut;
                 }
-                if (vbanTx->wordSizeBytes == sizeof(SYSTEM_AUDIO_TYPE)) {
-                    PaUtil_ReadRingBuffer(vbanTxRB, data, wsize);
-                } else {
-                    PaUtil_ReadRingBuffer(vbanTxRB, txBuffer, wsize);
+                PaUtil_GetRingBufferReadRegions(vbanTxRB, wsize,
+                    &buf1, &size1, &buf2, &size2);
+                copyAndConvert(
+                    buf1, sizeof(SYSTEM_AUDIO_TYPE), 1,
+                    data, vbanTx->wordSizeBytes, 1,
+                    size1, false
+                );
+                if (size2) {
                     copyAndConvert(
-                        txBuffer, sizeof(SYSTEM_AUDIO_TYPE), vbanTx->channels,
-                        data, vbanTx->wordSizeBytes, vbanTx->channels,
-                        wsize / vbanTx->channels, false
+                        buf2, sizeof(SYSTEM_AUDIO_TYPE), 1,
+                        (uint8_t *)data + size1 * vbanTx->wordSizeBytes,
+                        vbanTx->wordSizeBytes, 1,
+                        size2, false
                     );
                 }
+                PaUtil_AdvanceRingBufferReadIndex(vbanTxRB, wsize);
                 vbanWriteSamples(vbanTx, wsize);
                 samplesIn = PaUtil_GetRingBufferReadAvailable(vbanTxRB);
             }
-        } else {
+        } else if (vbanTxRB) {
             PaUtil_FlushRingBuffer(vbanTxRB);
         }
         xSemaphoreGive((SemaphoreHandle_t)vbanTx->lock);
-        whatToDo = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+        whatToDo = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     }
 }
 
-static void vban_audio_init_stream(VBAN_STREAM *rs)
+static void vban_audio_init_stream(VBAN_STREAM *rs, APP_CONTEXT *context)
 {
     rs->lock =  (SemaphoreHandle_t)xSemaphoreCreateMutex();
     rs->port = 6980;
     rs->channels = 2;
     rs->wordSizeBytes = sizeof(int16_t);
+    rs->usrPtr = context;
+}
+
+static PaUtilRingBuffer **vbanRing(APP_CONTEXT *context, VBAN_STREAM *rs)
+{
+    if (rs == &context->vbanTx) {
+        return(&context->vbanTxRB);
+    }
+    return(&context->vbanRxRB[rs - context->vbanRx]);
+}
+
+/*
+ * Allocates the stream's ring buffer and opens the stream.  Call with
+ * the stream's lock held after the stream is configured.
+ */
+bool vban_audio_open(APP_CONTEXT *context, VBAN_STREAM *rs)
+{
+    PaUtilRingBuffer **slot = vbanRing(context, rs);
+    PaUtilRingBuffer *rb;
+    bool ok;
+
+    if (rs->enabled) {
+        return(false);
+    }
+
+    audio_pool_ring_free(slot);
+    rb = audio_pool_ring_alloc(rs->channels, VBAN_RING_LATENCY_MS);
+    if (rb == NULL) {
+        return(false);
+    }
+
+    /* The ISR wakes the Tx task, which otherwise blocks indefinitely */
+    if (rs == &context->vbanTx) {
+        audio_pool_ring_watermarks(rb, 0, NULL,
+            VBAN_TX_WAKE_BLOCKS * rs->channels * SYSTEM_BLOCK_SIZE,
+            vbanTxHighWatermark, context);
+    }
+    *slot = rb;
+
+    ok = vbanOpenStream(rs);
+    if (!ok) {
+        audio_pool_ring_free(slot);
+    }
+
+    return(ok);
+}
+
+/* Closes the stream and returns its ring buffer to the audio pool */
+void vban_audio_close(APP_CONTEXT *context, VBAN_STREAM *rs)
+{
+    vbanCloseStream(rs);
+    audio_pool_ring_free(vbanRing(context, rs));
 }
 
 void vban_audio_init(APP_CONTEXT *context)
 {
-    uint32_t dataSize;
-
-    /* Allocate and configure the vban rx ring buffer.
-     * The ring buffer unit of measure is in SYSTEM_AUDIO_TYPE sized
-     * words
-     */
-    context->vbanRxRB =
-        (PaUtilRingBuffer *)umm_malloc(sizeof(PaUtilRingBuffer));
-    assert(context->vbanRxRB);
-    dataSize = roundUpPow2(VBAN_RING_BUF_SAMPLES);
-    context->vbanRxRBData = umm_calloc(dataSize, sizeof(SYSTEM_AUDIO_TYPE));
-    assert(context->vbanRxRBData);
-    PaUtil_InitializeRingBuffer(context->vbanRxRB,
-        sizeof(SYSTEM_AUDIO_TYPE), dataSize, context->vbanRxRBData);
-
-    /* Allocate and configure the vban tx ring buffer.
-     * The ring buffer unit of measure is in SYSTEM_AUDIO_TYPE sized
-     * words
-     */
-    context->vbanTxRB =
-        (PaUtilRingBuffer *)umm_malloc(sizeof(PaUtilRingBuffer));
-    assert(context->vbanTxRB);
-    dataSize = roundUpPow2(VBAN_RING_BUF_SAMPLES);
-    context->vbanTxRBData = umm_calloc(dataSize, sizeof(SYSTEM_AUDIO_TYPE));
-    assert(context->vbanTxRBData);
-    PaUtil_InitializeRingBuffer(context->vbanTxRB,
-        sizeof(SYSTEM_AUDIO_TYPE), dataSize, context->vbanTxRBData);
-
-    vban_audio_init_stream(&context->vbanRx);
-    vban_audio_init_stream(&context->vbanTx);
-
-    xTaskCreate(vbanRxTask, "vbanRxTask", VBAN_TASK_STACK_SIZE,
-        context, VBAN_TASK_PRIORITY, &context->vbanRxTaskHandle );
+    unsigned i;
+
+    /* Ring buffers are allocated from the audio pool on open */
+    for (i = 0; i < VBAN_RX_STREAMS; i++) {
+        context->vbanRxRB[i] = NULL;
+    }
+    context->vbanTxRB = NULL;
+
+    for (i = 0; i < VBAN_RX_STREAMS; i++) {
+        vban_audio_init_stream(&context->vbanRx[i], context);
+        context->vbanRx[i].rxCallback = vbanRxAudio;
+    }
+    vban_audio_init_stream(&context->vbanTx, context);
+
     xTaskCreate(vbanTxTask, "vbanTxTask", VBAN_TASK_STACK_SIZE,
         context, VBAN_TASK_PRIORITY, &context->vbanTxTaskHandle );
 
 }
 
 /* Transfers VBAN Tx audio (ISR context) */
-int xferVbanTxAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
+int xferVbanTxAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd,
     unsigned *numChannels)
 {
     unsigned samplesIn;
@@ -188,7 +286,6 @@ int xferVbanTxAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
     VBAN_STREAM *vbanTx = &context->vbanTx;
     PaUtilRingBuffer *vbanTxRB = context->vbanTxRB;
     CLOCK_DOMAIN myCd;
-    BaseType_t wake;
 
     static bool first = true;
 
@@ -198,7 +295,8 @@ int xferVbanTxAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
     }
     clock_domain_set_active(context, myCd, CLOCK_DOMAIN_BITM_VBAN_TX);
 
-    if (!vbanTx->enabled) {
+    *audio = audio_pool_ring_block(vbanTxRB);
+    if (!vbanTx->enabled || (*audio == NULL)) {
         *numChannels = 0;
         first = true;
         return(1);
@@ -209,55 +307,67 @@ int xferVbanTxAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
 
     if ((samplesIn == 0) || (samplesOut == 0)) {
          *numChannels = 0;
+        audio_pool_ring_update(vbanTxRB);
         return(1);
     }
 
     if (samplesIn <= samplesOut) {
         if (!first) {
             PaUtil_WriteRingBuffer(
-                vbanTxRB, audio, vbanTx->channels * SYSTEM_BLOCK_SIZE
+                vbanTxRB, *audio, vbanTx->channels * SYSTEM_BLOCK_SIZE
             );
         }
     } else {
         vbanTxOverflow++;
+        TRACE_LOG1(TRACE_ID_VBAN_TX_OVERFLOW, samplesOut);
     }
 
-    memset(audio, 0, samplesIn * sizeof(SYSTEM_AUDIO_TYPE));
+    memset(*audio, 0, samplesIn * sizeof(SYSTEM_AUDIO_TYPE));
     *numChannels = vbanTx->channels;
     first = false;
 
-    if (samplesOut < (VBAN_RING_BUF_SAMPLES / 2)) {
-        xTaskNotifyFromISR(context->vbanTxTaskHandle,
-            VBAN_TASK_AUDIO_TX_MORE_DATA, eSetValueWithoutOverwrite, &wake
-        );
-        portYIELD_FROM_ISR(wake);
-    }
+    audio_pool_ring_update(vbanTxRB);
 
     return(1);
 }
 
-/* Transfers VBAN Rx audio (ISR context) */
-int xferVbanRxAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
-    unsigned *numChannels)
+/* Transfers VBAN Rx audio for stream 'idx' (ISR context) */
+int xferVbanRxAudio(APP_CONTEXT *context, unsigned idx, void **audio,
+    CLOCK_DOMAIN cd, unsigned *numChannels)
 {
     unsigned samplesIn;
     unsigned samplesOut;
-    VBAN_STREAM *vbanRx = &context->vbanRx;
-    PaUtilRingBuffer *vbanRxRB = context->vbanRxRB;
+    VBAN_STREAM *vbanRx = &context->vbanRx[idx];
+    PaUtilRingBuffer *vbanRxRB = context->vbanRxRB[idx];
+    unsigned mask = vbanRxClockDomainMasks[idx];
     CLOCK_DOMAIN myCd;
 
-    myCd = clock_domain_get(context, CLOCK_DOMAIN_BITM_VBAN_RX);
+    myCd = clock_domain_get(context, mask);
     if (myCd != cd) {
         return(0);
     }
-    clock_domain_set_active(context, myCd, CLOCK_DOMAIN_BITM_VBAN_RX);
+    clock_domain_set_active(context, myCd, mask);
 
-    if (!vbanRx->enabled || vbanRx->preRoll) {
+    *audio = audio_pool_ring_block(vbanRxRB);
+    if (*audio == NULL) {
         *numChannels = 0;
         return(1);
     }
 
     samplesIn = PaUtil_GetRingBufferReadAvailable(vbanRxRB);
+
+    /* Drain stale audio from the consumer side while stopped */
+    if (!vbanRx->enabled) {
+        PaUtil_AdvanceRingBufferReadIndex(vbanRxRB, samplesIn);
+        *numChannels = 0;
+        return(1);
+    }
+
+    if (vbanRx->preRoll) {
+        *numChannels = 0;
+        return(1);
+    }
+
     samplesOut = vbanRx->channels * SYSTEM_BLOCK_SIZE;
 
     if ((samplesIn == 0) || (samplesOut == 0)) {
@@ -267,12 +377,13 @@ int xferVbanRxAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
 
     if (samplesIn >= samplesOut) {
         PaUtil_ReadRingBuffer(
-            vbanRxRB, audio, samplesOut
+            vbanRxRB, *audio, samplesOut
         );
         *numChannels = vbanRx->channels;
     } else {
         vbanRx->preRoll = true;
-        vbanRxUnderflow++;
+        vbanRxUnderflow[idx]++;
+        TRACE_LOG2(TRACE_ID_VBAN_RX_UNDERFLOW, idx, samplesIn);
         *numChannels = 0;
     }
 
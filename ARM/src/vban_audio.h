@@ -14,13 +14,20 @@
 
 #include "context.h"
 #include "ipc.h"
+#include "vban_stream.h"
 
 void vban_audio_init(APP_CONTEXT *context);
 
-int xferVbanRxAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
-    unsigned *numChannels);
+bool vban_audio_open(APP_CONTEXT *context, VBAN_STREAM *rs);
+void vban_audio_close(APP_CONTEXT *context, VBAN_STREAM *rs);
+
+int xferVbanRxAudio(APP_CONTEXT *context, unsigned idx, void **audio,
+    CLOCK_DOMAIN cd, unsigned *numChannels);
+
+STREAM_ID vbanRxStreamID(unsigned idx);
+unsigned vbanRxClockDomainMask(unsigned idx);
 
-int xferVbanTxAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
+int xferVbanTxAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd,
     unsigned *numChannels);
 
 #endif
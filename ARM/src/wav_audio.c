@@ -20,8 +20,12 @@
 #include "context.h"
 #include "util.h"
 #include "wav_file.h"
+#include "wav_rec.h"
+#include "track_cache.h"
+#include "wav_cue.h"
 #include "wav_audio.h"
-#include "umm_malloc.h"
+#include "audio_pool.h"
+#include "trace_log.h"
 #include "clock_domain.h"
 #include "task_cfg.h"
 
@@ -35,54 +39,151 @@ enum {
     WAV_TASK_AUDIO_SINK_MORE_DATA,
 };
 
-static SYSTEM_AUDIO_TYPE srcBuffer[WAV_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
-static SYSTEM_AUDIO_TYPE srcBuffer2[WAV_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
-static SYSTEM_AUDIO_TYPE sinkBuffer2[WAV_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
-static SYSTEM_AUDIO_TYPE sinkBuffer3[WAV_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
+/* Wakes the src task when the ring drains to half full (ISR context) */
+static void wavSrcLowWatermark(PaUtilRingBuffer *rb, void *usrPtr)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
+    BaseType_t wake = pdFALSE;
+
+    xTaskNotifyFromISR(context->wavSrcTaskHandle,
+        WAV_TASK_AUDIO_SRC_MORE_DATA, eSetValueWithoutOverwrite, &wake
+    );
+    portYIELD_FROM_ISR(wake);
+}
+
+/* Wakes the sink task when the ring fills to half full (ISR context) */
+static void wavSinkHighWatermark(PaUtilRingBuffer *rb, void *usrPtr)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
+    BaseType_t wake = pdFALSE;
+
+    xTaskNotifyFromISR(context->wavSinkTaskHandle,
+        WAV_TASK_AUDIO_SINK_MORE_DATA, eSetValueWithoutOverwrite, &wake
+    );
+    portYIELD_FROM_ISR(wake);
+}
+
+/*
+ * FLAC frames decode to 32-bit samples, so they go straight into the
+ * ring's write regions without the file scratch buffer.
+ */
+static bool wavSrcFillFlac(WAV_FILE *wavSrc, PaUtilRingBuffer *wavSrcRB,
+    unsigned samples)
+{
+    ring_buffer_size_t size1, size2;
+    void *buf1, *buf2;
+    size_t rsize, rsize2;
+
+    PaUtil_GetRingBufferWriteRegions(wavSrcRB, samples,
+        &buf1, &size1, &buf2, &size2);
+    rsize = readWave(wavSrc, buf1, size1);
+    if (rsize == 0) {
+        /* End of stream rewinds, nothing after that means no frames */
+        rsize = readWave(wavSrc, buf1, size1);
+    }
+    if ((rsize == 0) || (rsize == (size_t)-1)) {
+        return(false);
+    }
+    if ((rsize == size1) && size2) {
+        rsize2 = readWave(wavSrc, buf2, size2);
+        if (rsize2 == (size_t)-1) {
+            return(false);
+        }
+        rsize += rsize2;
+    }
+    PaUtil_AdvanceRingBufferWriteIndex(wavSrcRB, rsize);
+
+    return(true);
+}
 
 /* This task keeps the wav src ring buffer full */
 portTASK_FUNCTION(wavSrcTask, pvParameters)
 {
     APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
     WAV_FILE *wavSrc = &context->wavSrc;
-    PaUtilRingBuffer *wavSrcRB = context->wavSrcRB;
+    WAV_CUE *cue = &context->wavSrcCue;
+    PaUtilRingBuffer *wavSrcRB;
+    ring_buffer_size_t size1, size2;
+    void *buf1, *buf2;
     uint32_t whatToDo;
     unsigned samplesIn;
     unsigned samplesOut;
     size_t rsize;
+    void *scratch;
+    bool retry;
+    bool more;
     bool ok;
 
     while (1) {
         xSemaphoreTake((SemaphoreHandle_t)wavSrc->lock, portMAX_DELAY);
-        if (wavSrc->enabled) {
-            samplesIn = WAV_MAX_CHANNELS * SYSTEM_BLOCK_SIZE;
+        wavSrcRB = context->wavSrcRB;
+        retry = false;
+        more = false;
+        if (wavSrc->enabled && wavSrcRB) {
+            samplesIn = AUDIO_POOL_SCRATCH_SAMPLES;
             samplesOut = PaUtil_GetRingBufferWriteAvailable(wavSrcRB);
             ok = true;
+            wav_cue_seek(cue, wavSrcRB);
             while (ok && (samplesOut >= samplesIn)) {
-                rsize = readWave(wavSrc, srcBuffer, samplesIn);
-                ok = (rsize >= 0);
+                /* A jump may have happened since the last write */
+                wav_cue_seek(cue, wavSrcRB);
+                if (wavSrc->flac) {
+                    ok = wavSrcFillFlac(wavSrc, wavSrcRB, samplesIn);
+                    samplesOut = PaUtil_GetRingBufferWriteAvailable(wavSrcRB);
+                    continue;
+                }
+                scratch = audio_pool_scratch_take(AUDIO_POOL_SCRATCH_FILE);
+                if (scratch == NULL) {
+                    retry = true;
+                    break;
+                }
+                rsize = readWave(wavSrc, scratch, samplesIn);
+                if (rsize == 0) {
+                    /* End of data rewinds, nothing after that is no frames */
+                    rsize = readWave(wavSrc, scratch, samplesIn);
+                }
+                ok = (rsize != 0) && (rsize != (size_t)-1);
                 if (ok) {
-                    if (wavSrc->wordSizeBytes == sizeof(SYSTEM_AUDIO_TYPE)) {
-                        PaUtil_WriteRingBuffer(wavSrcRB, srcBuffer, rsize);
-                    } else {
-                        copyAndConvert(
-                            srcBuffer, wavSrc->wordSizeBytes, wavSrc->channels,
-                            srcBuffer2, sizeof(SYSTEM_AUDIO_TYPE), wavSrc->channels,
-                            rsize / wavSrc->channels, true
-                        );
-                        PaUtil_WriteRingBuffer(wavSrcRB, srcBuffer2, rsize);
+                    /* Decode straight into the ring's write regions */
+                    PaUtil_GetRingBufferWriteRegions(wavSrcRB, rsize,
+                        &buf1, &size1, &buf2, &size2);
+                    decodeWave(wavSrc, scratch, buf1, size1);
+                    if (size2) {
+                        decodeWave(wavSrc,
+                            (uint8_t *)scratch + size1 * wavSrc->wordSizeBytes,
+                            buf2, size2);
                     }
+                    PaUtil_AdvanceRingBufferWriteIndex(wavSrcRB, rsize);
                     samplesOut = PaUtil_GetRingBufferWriteAvailable(wavSrcRB);
                 }
+                audio_pool_scratch_give(AUDIO_POOL_SCRATCH_FILE);
             }
             if (!ok) {
                 wavSrc->enabled = false;
             }
-        } else {
+            /* Pin cue and loop audio a piece at a time, the ring first */
+            if (ok) {
+                scratch = audio_pool_scratch_take(AUDIO_POOL_SCRATCH_FILE);
+                if (scratch) {
+                    more = wav_cue_service(cue, scratch,
+                        AUDIO_POOL_SCRATCH_SAMPLES);
+                    audio_pool_scratch_give(AUDIO_POOL_SCRATCH_FILE);
+                } else {
+                    retry = true;
+                }
+            }
+        } else if (wavSrcRB) {
             PaUtil_FlushRingBuffer(wavSrcRB);
         }
         xSemaphoreGive((SemaphoreHandle_t)wavSrc->lock);
-        whatToDo = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+        /* The ring's watermark has gone by, it won't wake us again */
+        if (retry) {
+            vTaskDelay(pdMS_TO_TICKS(WAV_SCRATCH_RETRY_MS));
+        } else if (more) {
+            taskYIELD();
+        } else {
+            whatToDo = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
     }
 }
 
@@ -91,72 +192,125 @@ portTASK_FUNCTION(wavSinkTask, pvParameters)
 {
     APP_CONTEXT *context = (APP_CONTEXT *)pvParameters;
     WAV_FILE *wavSink = &context->wavSink;
-    PaUtilRingBuffer *wavSinkRB = context->wavSinkRB;
+    PaUtilRingBuffer *wavSinkRB;
+    ring_buffer_size_t size1, size2;
+    void *buf1, *buf2;
     uint32_t whatToDo;
     unsigned samplesIn;
     unsigned samplesOut;
     size_t wsize;
+    void *scratch;
+    bool retry;
     bool ok;
 
     while (1) {
         xSemaphoreTake((SemaphoreHandle_t)wavSink->lock, portMAX_DELAY);
-        if (wavSink->enabled) {
+        wavSinkRB = context->wavSinkRB;
+        retry = false;
+        if (wavSink->enabled && wavSinkRB) {
             samplesIn = PaUtil_GetRingBufferReadAvailable(wavSinkRB);
             samplesOut = wavSink->channels * SYSTEM_BLOCK_SIZE;
             ok = true;
+            if (wavSink->rec) {
+                /* The recorder stages and encodes on its own */
+                PaUtil_GetRingBufferReadRegions(wavSinkRB, samplesIn,
+                    &buf1, &size1, &buf2, &size2);
+                ok = (wav_rec_write(wavSink->rec, buf1, size1) == size1);
+                if (ok && size2) {
+                    ok = (wav_rec_write(wavSink->rec, buf2, size2) == size2);
+                }
+                PaUtil_AdvanceRingBufferReadIndex(wavSinkRB, samplesIn);
+                if (!ok) {
+                    wavSink->enabled = false;
+                }
+                samplesIn = 0;
+            }
             while (ok && (samplesIn >= samplesOut)) {
-                PaUtil_ReadRingBuffer(
-                    wavSinkRB, sinkBuffer2, samplesOut
-                );
-                if (wavSink->wordSizeBytes == sizeof(SYSTEM_AUDIO_TYPE)) {
-                    wsize = writeWave(wavSink, sinkBuffer2, samplesOut);
-                } else {
-                    copyAndConvert(
-                        sinkBuffer2, sizeof(SYSTEM_AUDIO_TYPE), wavSink->channels,
-                        sinkBuffer3, wavSink->wordSizeBytes, wavSink->channels,
-                        samplesOut / wavSink->channels, true
-                    );
-                    wsize = writeWave(wavSink, sinkBuffer3, samplesOut);
+                scratch = audio_pool_scratch_take(AUDIO_POOL_SCRATCH_FILE);
+                if (scratch == NULL) {
+                    retry = true;
+                    break;
+                }
+                /* Encode straight out of the ring's read regions */
+                PaUtil_GetRingBufferReadRegions(wavSinkRB, samplesOut,
+                    &buf1, &size1, &buf2, &size2);
+                encodeWave(wavSink, buf1, scratch, size1);
+                if (size2) {
+                    encodeWave(wavSink, buf2,
+                        (uint8_t *)scratch + size1 * wavSink->wordSizeBytes,
+                        size2);
                 }
+                PaUtil_AdvanceRingBufferReadIndex(wavSinkRB, samplesOut);
+                wsize = writeWave(wavSink, scratch, samplesOut);
+                audio_pool_scratch_give(AUDIO_POOL_SCRATCH_FILE);
                 samplesIn = PaUtil_GetRingBufferReadAvailable(wavSinkRB);
             }
-        } else {
+        } else if (wavSinkRB) {
             PaUtil_FlushRingBuffer(wavSinkRB);
         }
         xSemaphoreGive((SemaphoreHandle_t)wavSink->lock);
-        whatToDo = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+        if (retry) {
+            vTaskDelay(pdMS_TO_TICKS(WAV_SCRATCH_RETRY_MS));
+        } else {
+            whatToDo = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+    }
+}
+
+/* Loads track cache regions ahead of playback and for queued tracks */
+portTASK_FUNCTION(trackCacheTask, pvParameters)
+{
+    while (1) {
+        while (track_cache_service()) {
+        }
+        vTaskDelay(pdMS_TO_TICKS(TRACK_CACHE_POLL_MS));
+    }
+}
+
+static PaUtilRingBuffer **wavRing(APP_CONTEXT *context, WAV_FILE *wf)
+{
+    return((wf == &context->wavSrc) ? &context->wavSrcRB : &context->wavSinkRB);
+}
+
+/*
+ * Allocates the ring buffer of an opened wave file.  Call with the
+ * file's lock held after the channel count is final.
+ */
+bool wav_audio_open_ring(APP_CONTEXT *context, WAV_FILE *wf)
+{
+    PaUtilRingBuffer **slot = wavRing(context, wf);
+    PaUtilRingBuffer *rb;
+
+    audio_pool_ring_free(slot);
+    rb = audio_pool_ring_alloc(wf->channels, WAV_RING_LATENCY_MS);
+    if (rb == NULL) {
+        return(false);
+    }
+
+    /* The ISR wakes the task, which otherwise blocks indefinitely */
+    if (wf == &context->wavSrc) {
+        audio_pool_ring_watermarks(rb,
+            rb->bufferSize / 2, wavSrcLowWatermark, 0, NULL, context);
+    } else {
+        audio_pool_ring_watermarks(rb,
+            0, NULL, rb->bufferSize / 2, wavSinkHighWatermark, context);
     }
+    *slot = rb;
+
+    return(true);
+}
+
+/* Returns the ring buffer of a closed wave file to the audio pool */
+void wav_audio_close_ring(APP_CONTEXT *context, WAV_FILE *wf)
+{
+    audio_pool_ring_free(wavRing(context, wf));
 }
 
 void wav_audio_init(APP_CONTEXT *context)
 {
-    uint32_t dataSize;
-
-    /* Allocate and configure the wave file source ring buffer.
-     * The ring buffer unit of measure is in SYSTEM_AUDIO_TYPE sized
-     * words
-     */
-    context->wavSrcRB =
-        (PaUtilRingBuffer *)umm_malloc(sizeof(PaUtilRingBuffer));
-    assert(context->wavSrcRB);
-    dataSize = roundUpPow2(WAV_RING_BUF_SAMPLES);
-    context->wavSrcRBData = umm_calloc(dataSize, sizeof(SYSTEM_AUDIO_TYPE));
-    assert(context->wavSrcRBData);
-    PaUtil_InitializeRingBuffer(context->wavSrcRB,
-        sizeof(SYSTEM_AUDIO_TYPE), dataSize, context->wavSrcRBData);
-
-    /* Allocate and configure the wave file sink ring buffer.
-     * The ring buffer unit of measure is in SYSTEM_AUDIO_TYPE sized
-     * words
-     */
-    context->wavSinkRB =
-        (PaUtilRingBuffer *)umm_malloc(sizeof(PaUtilRingBuffer));
-    assert(context->wavSinkRB);
-    dataSize = roundUpPow2(WAV_RING_BUF_SAMPLES);
-    context->wavSinkRBData = umm_calloc(dataSize, sizeof(SYSTEM_AUDIO_TYPE));
-    assert(context->wavSinkRBData);
-    PaUtil_InitializeRingBuffer(context->wavSinkRB,
-        sizeof(SYSTEM_AUDIO_TYPE), dataSize, context->wavSinkRBData);
+    /* Ring buffers are allocated from the audio pool on open */
+    context->wavSrcRB = NULL;
+    context->wavSinkRB = NULL;
 
     context->wavSrc.lock =  (SemaphoreHandle_t)xSemaphoreCreateMutex();
     context->wavSink.lock =  (SemaphoreHandle_t)xSemaphoreCreateMutex();
@@ -166,9 +320,13 @@ void wav_audio_init(APP_CONTEXT *context)
     xTaskCreate(wavSinkTask, "WavSinkTask", WAV_TASK_STACK_SIZE,
         context, WAV_TASK_PRIORITY, &context->wavSinkTaskHandle );
 
+    track_cache_init();
+    xTaskCreate(trackCacheTask, "TrackCacheTask", TRACK_CACHE_TASK_STACK_SIZE,
+        context, TRACK_CACHE_TASK_PRIORITY, NULL );
+
 }
 
-int xferWavSinkAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
+int xferWavSinkAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd,
     unsigned *numChannels)
 {
     unsigned samplesIn;
@@ -176,7 +334,6 @@ int xferWavSinkAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
     WAV_FILE *wavSink = &context->wavSink;
     PaUtilRingBuffer *wavSinkRB = context->wavSinkRB;
     CLOCK_DOMAIN myCd;
-    BaseType_t wake;
 
     static bool first = true;
 
@@ -186,7 +343,8 @@ int xferWavSinkAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
     }
     clock_domain_set_active(context, myCd, CLOCK_DOMAIN_BITM_WAV_SINK);
 
-    if (!wavSink->enabled || (wavSink->channels == 0)) {
+    *audio = audio_pool_ring_block(wavSinkRB);
+    if (!wavSink->enabled || (wavSink->channels == 0) || (*audio == NULL)) {
         *numChannels = 0;
         first = true;
         return(1);
@@ -197,34 +355,31 @@ int xferWavSinkAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
 
     if ((samplesIn == 0) || (samplesOut == 0)) {
         *numChannels = 0;
+        audio_pool_ring_update(wavSinkRB);
         return(1);
     }
 
     if (samplesIn <= samplesOut) {
         if (!first) {
             PaUtil_WriteRingBuffer(
-                wavSinkRB, audio, samplesIn
+                wavSinkRB, *audio, samplesIn
             );
         }
     } else {
         wavSinkOverflow++;
+        TRACE_LOG2(TRACE_ID_WAV_SINK_OVERFLOW, samplesOut, samplesIn);
     }
 
-    memset(audio, 0, samplesIn * sizeof(SYSTEM_AUDIO_TYPE));
+    memset(*audio, 0, samplesIn * sizeof(SYSTEM_AUDIO_TYPE));
     *numChannels = wavSink->channels;
     first = false;
 
-    if (samplesOut < (WAV_RING_BUF_SAMPLES / 2)) {
-        xTaskNotifyFromISR(context->wavSinkTaskHandle,
-            WAV_TASK_AUDIO_SINK_MORE_DATA, eSetValueWithoutOverwrite, &wake
-        );
-        portYIELD_FROM_ISR(wake);
-    }
+    audio_pool_ring_update(wavSinkRB);
 
     return(1);
 }
 
-int xferWavSrcAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
+int xferWavSrcAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd,
     unsigned *numChannels)
 {
     unsigned samplesIn;
@@ -232,7 +387,7 @@ int xferWavSrcAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
     WAV_FILE *wavSrc = &context->wavSrc;
     PaUtilRingBuffer *wavSrcRB = context->wavSrcRB;
     CLOCK_DOMAIN myCd;
-    BaseType_t wake;
+    bool wake;
 
     myCd = clock_domain_get(context, CLOCK_DOMAIN_BITM_WAV_SRC);
     if (myCd != cd) {
@@ -240,35 +395,51 @@ int xferWavSrcAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
     }
     clock_domain_set_active(context, myCd, CLOCK_DOMAIN_BITM_WAV_SRC);
 
-    if (!wavSrc->enabled || (wavSrc->channels == 0)) {
+    *audio = audio_pool_ring_block(wavSrcRB);
+    if (!wavSrc->enabled || (wavSrc->channels == 0) || (*audio == NULL)) {
         *numChannels = 0;
         return(1);
     }
 
+    /* Cues and loops play from RAM, the ring behind them */
+    if (context->wavSrcCue.wf) {
+        if (wav_cue_xfer(&context->wavSrcCue, wavSrcRB, *audio, &wake)) {
+            *numChannels = wavSrc->channels;
+        } else {
+            wavSrcUnderflow++;
+            TRACE_LOG2(TRACE_ID_WAV_SRC_UNDERFLOW,
+                PaUtil_GetRingBufferReadAvailable(wavSrcRB),
+                wavSrc->channels * SYSTEM_BLOCK_SIZE);
+            *numChannels = 0;
+        }
+        if (wake) {
+            wavSrcLowWatermark(wavSrcRB, context);
+        }
+        audio_pool_ring_update(wavSrcRB);
+        return(1);
+    }
+
     samplesIn = PaUtil_GetRingBufferReadAvailable(wavSrcRB);
     samplesOut = wavSrc->channels * SYSTEM_BLOCK_SIZE;
 
     if ((samplesIn == 0) || (samplesOut == 0)) {
         *numChannels = 0;
+        audio_pool_ring_update(wavSrcRB);
         return(1);
     }
 
     if (samplesIn >= samplesOut) {
         PaUtil_ReadRingBuffer(
-            wavSrcRB, audio, samplesOut
+            wavSrcRB, *audio, samplesOut
         );
         *numChannels = wavSrc->channels;
     } else {
         wavSrcUnderflow++;
+        TRACE_LOG2(TRACE_ID_WAV_SRC_UNDERFLOW, samplesIn, samplesOut);
         *numChannels = 0;
     }
 
-    if (samplesIn < (WAV_RING_BUF_SAMPLES / 2)) {
-        xTaskNotifyFromISR(context->wavSrcTaskHandle,
-            WAV_TASK_AUDIO_SRC_MORE_DATA, eSetValueWithoutOverwrite, &wake
-        );
-        portYIELD_FROM_ISR(wake);
-    }
+    audio_pool_ring_update(wavSrcRB);
 
     return(1);
 }
@@ -18,10 +18,13 @@
 
 void wav_audio_init(APP_CONTEXT *context);
 
-int xferWavSinkAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
+bool wav_audio_open_ring(APP_CONTEXT *context, WAV_FILE *wf);
+void wav_audio_close_ring(APP_CONTEXT *context, WAV_FILE *wf);
+
+int xferWavSinkAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd,
     unsigned *numChannels);
 
-int xferWavSrcAudio(APP_CONTEXT *context, void *audio, CLOCK_DOMAIN cd,
+int xferWavSrcAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd,
     unsigned *numChannels);
 
 #endif
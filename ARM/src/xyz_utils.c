@@ -5,7 +5,9 @@
 #include <complex.h>
 
 #include "adi_fft_wrapper.h"
+#include "fft_queue.h"
 #include "syslog.h"
+#include "trace_log.h"
 #include "wav_file.h"
 /* #include "fft.h" */
 #include "xyz_utils.h"
@@ -20,6 +22,9 @@ static float audioOutBuffer[N_FFT] = {};
 #pragma align 32
 static complex_float tempBuffer[N_FFT] = {};
 
+/* Shared FFT accelerator queue, NULL to use the accelerator directly */
+static FFT_QUEUE *fftQueue = NULL;
+
 XYZ_Scale XYZ_Maj = {0, 2, 4, 5, 7, 9, 11};
 XYZ_Scale XYZ_Min = {0, 2, 3, 5, 7, 8, 10};
 
@@ -59,6 +64,40 @@ void my_fft_error_handler (ADI_FFT_HANDLE     h,
     }
 }
 
+void xyz_set_fft_queue(FFT_QUEUE *q) {
+    fftQueue = q;
+}
+
+/*
+ * |X[k]|^2 of audioInBuffer into audioOutBuffer.  Analysis goes through
+ * the FFT queue at background priority so it never holds up live users
+ * of the accelerator.
+ */
+static float *xyz_rfft_mag_sq(void) {
+    FFT_JOB job;
+
+    if (fftQueue == NULL) {
+        return accel_rfft_large_mag_sq(audioInBuffer, audioOutBuffer,
+                                       tempBuffer, accel_twiddles_4096,
+                                       1, 1.0, N_FFT);
+    }
+
+    memset(&job, 0, sizeof(job));
+    job.type = FFT_JOB_RFFT_MAG_SQ;
+    job.npts = N_FFT;
+    job.scale = 1.0f;
+    job.in = audioInBuffer;
+    job.out = audioOutBuffer;
+    job.temp = tempBuffer;
+    job.twiddles = accel_twiddles_4096;
+    job.twiddleStride = 1;
+    job.priority = FFT_QUEUE_PRIO_BACKGROUND;
+    if (!fft_queue_submit(fftQueue, &job) || !fft_queue_wait(fftQueue, &job)) {
+        return NULL;
+    }
+    return audioOutBuffer;
+}
+
 float XYZ_hz_to_midi(float freq) {
     float midi;
     midi = 12 * (log2(freq) - log2(440.0)) + 69;
@@ -202,9 +241,8 @@ XYZ_Key *xyz_estimate_key(char *fname) {
         // void *result_fft;
         // void *result_mag;
         size_t samplesRead;
-        int twiddle_stride = 1;
 
-        syslog_printf("Taking rfft with %d samples.\n", N_FFT);
+        TRACE_LOG1(TRACE_ID_XYZ_RFFT_START, N_FFT);
         // Investigating the following syntax
 
         /* // Zero out the buffers before use */
@@ -227,11 +265,9 @@ XYZ_Key *xyz_estimate_key(char *fname) {
             // Process the 'samplesRead' samples in 'audioInBuffer'
             /* Set error handler */
             accel_fft_set_error_handler(my_fft_error_handler);
-            result = accel_rfft_large_mag_sq(audioInBuffer, audioOutBuffer,
-                                         tempBuffer, accel_twiddles_4096,
-                                         twiddle_stride, 1.0, N_FFT);
+            result = xyz_rfft_mag_sq();
             if (!result) {
-                syslog_printf("Error %u while taking rfft.\n", result);
+                TRACE_LOG0(TRACE_ID_XYZ_RFFT_ERROR);
                 // result = fft_mag(audioInBuffer, audioOutBuffer, N_FFT);
                 // if (!result) {
                 //     syslog_printf("Error while taking fft.\n");
@@ -254,7 +290,6 @@ XYZ_Key *xyz_estimate_key(char *fname) {
         }
         */
         }
-        syslog_printf("fft_mag of first sample: %.6f", audioOutBuffer[0]);
 
         float hps_result[N_FFT / 4];
         for (int i = 0; i < N_FFT / 4; i++) {
@@ -273,13 +308,16 @@ XYZ_Key *xyz_estimate_key(char *fname) {
             }
         }
         freq = max_index * wf->sampleRate / N_FFT;
-        syslog_printf("Estimated fundamental freq: %f", freq);
 
         float midi;
+        unsigned centiMidi;
 
         char keyBuffer[8];
 
         midi = XYZ_hz_to_midi(freq);
+        centiMidi = (midi > 0.0f) ? (unsigned)(midi * 100.0f) : 0;
+        TRACE_LOG3(TRACE_ID_XYZ_FUNDAMENTAL, freq,
+            centiMidi / 100, centiMidi % 100);
         XYZ_midi_to_note(midi, keyBuffer, sizeof(keyBuffer));
         syslog_printf("Estimated key: %s", keyBuffer);
 
@@ -7,6 +7,7 @@
 #include <string.h>
 
 #include "adi_fft_wrapper.h"
+#include "fft_queue.h"
 
 // Inspiration for structures comes from librosa
 // https://librosa.org/
@@ -102,6 +103,14 @@ typedef struct {
     int decimal;
 } XYZ_BPM;
 
+/*!****************************************************************
+ * @brief Runs the analysis transforms through an FFT queue.
+ *
+ * @param [in]  q          Shared FFT queue, NULL to call the
+ *                         accelerator directly
+ ******************************************************************/
+void xyz_set_fft_queue(FFT_QUEUE *q);
+
 float XYZ_hz_to_midi(float freq);
 
 void XYZ_midi_to_note(float midi_note, char *buffer, size_t buffer_size);
@@ -22,10 +22,43 @@
 
 /* IPC includes */
 #include "ipc.h"
+#include "trace_log.h"
+#include "pconv.h"
+#include "sae_lock.h"
 
 SAE_CONTEXT *saeContext = NULL;
-IPC_MSG_AUDIO *streamInfo[IPC_STREAM_ID_MAX];
+IPC_MSG_AUDIO_DESC *streamInfo[IPC_STREAM_ID_MAX];
+static IPC_MSG_AUDIO_DESC audioDesc[IPC_STREAM_ID_MAX];
 SAE_MSG_BUFFER *cyclesMsg = NULL;
+SAE_MSG_BUFFER *traceMsg = NULL;
+static uint32_t maxCycles[IPC_CYCLE_DOMAIN_MAX];
+
+/*
+ * Convolver on this core's node (IPC_TYPE_CONV).  The FFT accelerator
+ * is shared with the ARM's FFT queue through the IPC_TYPE_FFT_LEASE
+ * lease.  Each block the convolver takes it if the ARM isn't using it
+ * and transforms in software if it is, or before the lease arrives.
+ */
+#define CONV_NODE   0
+
+static PCONV_SOFT_FFT convSoft;
+static PCONV_FFT convSoftFft;
+static PCONV_FFT convAccelFft;
+#if defined(__ADSP21000__)
+static PCONV_ACCEL_FFT convAccel;
+#endif
+static IPC_MSG_FFT_LEASE *fftLease;
+
+static PCONV conv;
+/* Volatile, the IPC interrupt convolves while the background loop loads */
+static volatile bool convOn;
+static float convMem[PCONV_MEM_SIZE(PCONV_PARTS(IPC_CONV_TAPS),
+    IPC_CONV_CHANNELS) / sizeof(float)];
+static float convBuf[PCONV_BLOCK * IPC_CONV_CHANNELS];
+
+/* Response piece waiting for the background loop, and where it's up to */
+static IPC_MSG_CONV * volatile convPending;
+static uint32_t convNext;
 
 /***********************************************************************
  * Audio functions
@@ -36,56 +69,203 @@ SAE_MSG_BUFFER *cyclesMsg = NULL;
  * code uses src and sink to help minimize confusion.  In all cases,
  * src buffers are copied to sink buffers.
  */
-#pragma optimize_for_speed
-static void processAudio(IPC_MSG_PROCESS_AUDIO *process)
+
+/* Takes the accelerator for one block, false leaves it in software */
+static bool convFftTake(void)
 {
-    uint8_t clockDomain = process->clockDomain;
-    IPC_MSG_AUDIO *src, *sink, *stream;
-    unsigned i, channel, frame, channels;
-    int32_t *in, *out;
-    cycle_t startCycles;
-    cycle_t finalCycles;
+    if ((fftLease == NULL) || !sae_lock(&fftLease->lock)) {
+        pconv_set_fft(&conv, &convSoftFft);
+        return(false);
+    }
+    if (fftLease->owner != IPC_CORE_SHARC0) {
+#if defined(__ADSP21000__)
+        pconv_accel_fft_reset(&convAccel);
+#endif
+        fftLease->owner = IPC_CORE_SHARC0;
+    }
+    pconv_set_fft(&conv, &convAccelFft);
 
-    START_CYCLE_COUNT(startCycles);
+    return(true);
+}
+
+/* pconv_process() has waited out its last transform by now */
+static void convFftGive(bool taken)
+{
+    if (taken) {
+        sae_unlock(&fftLease->lock);
+    }
+}
 
-    src = streamInfo[IPC_STREAMID_SHARC0_IN];
-    sink = streamInfo[IPC_STREAMID_SHARC0_OUT];
+/* A node's streams, the link stands in for the chained ends */
+static void nodeStreams(unsigned node, IPC_MSG_AUDIO_DESC **src,
+    IPC_MSG_AUDIO_DESC **sink)
+{
+    IPC_MSG_AUDIO_DESC *link = streamInfo[IPC_STREAMID_SHARC_LINK];
 
-    if ((src == NULL) || (sink == NULL)) {
-        return;
+    if (node == 0) {
+        *src = streamInfo[IPC_STREAMID_SHARC0_IN];
+        *sink = link ? link : streamInfo[IPC_STREAMID_SHARC0_OUT];
+    } else {
+        *src = link ? link : streamInfo[IPC_STREAMID_SHARC1_IN];
+        *sink = streamInfo[IPC_STREAMID_SHARC1_OUT];
     }
-    if (src->clockDomain != clockDomain) {
-        return;
+}
+
+static bool jobInDomain(unsigned job, uint8_t clockDomain)
+{
+    IPC_MSG_AUDIO_DESC *src, *sink;
+
+    nodeStreams(job / IPC_DSP_GROUPS, &src, &sink);
+
+    return(sink && (sink->clockDomain == clockDomain));
+}
+
+/*
+ * Convolves sink channels 'first' up to 'last' in place, fixed point
+ * through a float copy.
+ */
+static void convolve(IPC_MSG_AUDIO_DESC *sink, unsigned first,
+    unsigned last)
+{
+    unsigned frame, channel, n;
+    int32_t *fixed;
+    float *data;
+    float y;
+
+    if (last > IPC_CONV_CHANNELS) {
+        last = IPC_CONV_CHANNELS;
     }
-    if (sink->clockDomain != clockDomain) {
+    if ((first >= last) || (sink->numFrames != PCONV_BLOCK)) {
         return;
     }
 
-#if 1
-    if (src->numFrames != sink->numFrames) {
+    if (sink->format == IPC_AUDIO_FORMAT_FLOAT) {
+        data = (float *)sink->data + first;
+        pconv_process(&conv, first, last, data, data, sink->numChannels);
         return;
     }
-    if (src->wordSize != sink->wordSize) {
-        return;
+
+    n = last - first;
+    fixed = (int32_t *)sink->data + first;
+    for (frame = 0; frame < PCONV_BLOCK; frame++) {
+        for (channel = 0; channel < n; channel++) {
+            convBuf[frame * n + channel] =
+                (float)fixed[frame * sink->numChannels + channel] *
+                (1.0f / 2147483648.0f);
+        }
     }
-    if (src->wordSize != sizeof(int32_t)) {
-        return;
+
+    pconv_process(&conv, first, last, convBuf, convBuf, n);
+
+    for (frame = 0; frame < PCONV_BLOCK; frame++) {
+        for (channel = 0; channel < n; channel++) {
+            y = convBuf[frame * n + channel];
+            fixed[frame * sink->numChannels + channel] =
+                (y >= 1.0f) ? INT32_MAX :
+                (y < -1.0f) ? INT32_MIN : (int32_t)(y * 2147483648.0f);
+        }
     }
-#endif
+}
 
-    channels = (src->numChannels < sink->numChannels) ?
-        src->numChannels : sink->numChannels;
-    in = src->data;
-    out = sink->data;
+/*
+ * One channel group of one node.  Every sink channel in the group is
+ * written, silence where there is no matching source channel, so the
+ * groups can run on either core without clearing the sink first.
+ * Samples move as whole words and 0 is silence in both formats, so
+ * this is the same for fixed and float streams.  This core's node then
+ * goes through the convolver if it's on.
+ */
+#pragma optimize_for_speed
+static bool runJob(unsigned job, uint8_t clockDomain)
+{
+    IPC_MSG_AUDIO_DESC *src, *sink;
+    unsigned group = job % IPC_DSP_GROUPS;
+    unsigned first, last, copy;
+    unsigned channel, frame;
+    int32_t *in, *out;
+    bool taken;
+
+    nodeStreams(job / IPC_DSP_GROUPS, &src, &sink);
 
-    for (frame = 0; frame < src->numFrames; frame++) {
-        for (channel = 0; channel < channels; channel++) {
+    if ((sink == NULL) || (sink->clockDomain != clockDomain)) {
+        return(false);
+    }
+    if (sink->wordSize != sizeof(int32_t)) {
+        return(false);
+    }
+    if ((src == NULL) || (src->clockDomain != clockDomain) ||
+        (src->numFrames != sink->numFrames) ||
+        (src->wordSize != sink->wordSize)) {
+        src = NULL;
+    }
+
+    first = (group * sink->numChannels) / IPC_DSP_GROUPS;
+    last = ((group + 1) * sink->numChannels) / IPC_DSP_GROUPS;
+    copy = first;
+    if (src) {
+        copy = (src->numChannels < last) ? src->numChannels : last;
+        if (copy < first) {
+            copy = first;
+        }
+    }
+
+    in = src ? (int32_t *)src->data : NULL;
+    out = (int32_t *)sink->data;
+
+    for (frame = 0; frame < sink->numFrames; frame++) {
+        for (channel = first; channel < copy; channel++) {
             *(out + channel) = *(in + channel);
         }
-        in += src->numChannels;
+        for (; channel < last; channel++) {
+            *(out + channel) = 0;
+        }
+        if (in) {
+            in += src->numChannels;
+        }
         out += sink->numChannels;
     }
 
+    if (convOn && ((job / IPC_DSP_GROUPS) == CONV_NODE)) {
+        taken = convFftTake();
+        convolve(sink, first, last);
+        convFftGive(taken);
+    }
+
+    return(true);
+}
+
+/* Runs this core's share of 'plan' */
+static void processAudio(uint8_t clockDomain, uint32_t plan)
+{
+    IPC_MSG_CYCLES *cycles = NULL;
+    IPC_MSG_AUDIO_DESC *stream;
+    unsigned i, job;
+    cycle_t startCycles, jobStart;
+    cycle_t finalCycles, jobFinal;
+    bool ran;
+
+    START_CYCLE_COUNT(startCycles);
+
+    if (cyclesMsg) {
+        cycles = &((IPC_MSG *)sae_getMsgBufferPayload(cyclesMsg))->cycles;
+    }
+
+    for (job = 0; job < IPC_DSP_JOBS; job++) {
+        if (IPC_DSP_JOB_CORE(plan, job) != IPC_CORE_SHARC0) {
+            /* The other core has it, don't report a stale cost */
+            if (cycles && jobInDomain(job, clockDomain)) {
+                cycles->jobCycles[job] = 0;
+            }
+            continue;
+        }
+        START_CYCLE_COUNT(jobStart);
+        ran = runJob(job, clockDomain);
+        STOP_CYCLE_COUNT(jobFinal, jobStart);
+        if (cycles && ran) {
+            cycles->jobCycles[job] = jobFinal;
+        }
+    }
+
     /* Invalidate all streams associated with this clock domain */
     for (i = 0; i < IPC_STREAM_ID_MAX; i++) {
         stream = streamInfo[i];
@@ -96,35 +276,158 @@ static void processAudio(IPC_MSG_PROCESS_AUDIO *process)
 
     STOP_CYCLE_COUNT(finalCycles, startCycles);
 
-    if (cyclesMsg &&(clockDomain < IPC_CYCLE_DOMAIN_MAX)) {
-        IPC_MSG *msg = sae_getMsgBufferPayload(cyclesMsg);
-        msg->cycles.cycles[clockDomain] = finalCycles;
+    if (cycles && (clockDomain < IPC_CYCLE_DOMAIN_MAX)) {
+        cycles->cycles[clockDomain] = finalCycles;
+    }
+
+    /* Trace each new worst case */
+    if ((clockDomain < IPC_CYCLE_DOMAIN_MAX) &&
+        (finalCycles > maxCycles[clockDomain])) {
+        maxCycles[clockDomain] = finalCycles;
+        TRACE_LOG2(TRACE_ID_SHARC_CYCLES, clockDomain, finalCycles);
     }
 }
 
-static void newAudio(IPC_MSG_AUDIO *audio)
+/*
+ * Streams are copied out of their messages so a descriptor sent in an
+ * IPC_TYPE_BLOCK message outlives it.
+ */
+static void newAudio(const IPC_MSG_AUDIO_DESC *audio, bool clear)
 {
-    bool clear = false;
-    bool unknown = false;
+    IPC_MSG_AUDIO_DESC *desc;
 
-    switch (audio->streamID) {
-        case IPC_STREAMID_SHARC0_IN:
-            break;
-        case IPC_STREAMID_SHARC0_OUT:
-            clear = true;
-            break;
-        default:
-            unknown = true;
-            break;
+    if ((audio->streamID == IPC_STREAMID_UNKNOWN) ||
+        (audio->streamID >= IPC_STREAM_ID_MAX)) {
+        TRACE_LOG1(TRACE_ID_SHARC_UNKNOWN_STREAM, audio->streamID);
+        return;
+    }
+
+    desc = &audioDesc[audio->streamID];
+    *desc = *audio;
+    streamInfo[audio->streamID] = desc;
+    if (clear) {
+        memset((void *)desc->data, 0,
+            desc->numChannels * desc->numFrames * desc->wordSize);
+    }
+}
+
+/* Single stream (IPC_TYPE_AUDIO) message, only ever our own streams */
+static void newAudioMsg(IPC_MSG_AUDIO *audio)
+{
+    IPC_MSG_AUDIO_DESC desc;
+
+    desc.streamID = audio->streamID;
+    desc.clockDomain = audio->clockDomain;
+    desc.wordSize = audio->wordSize;
+    desc.format = IPC_AUDIO_FORMAT_FIXED;
+    desc.numChannels = audio->numChannels;
+    desc.numFrames = audio->numFrames;
+    desc.data = (uintptr_t)audio->data;
+    newAudio(&desc, audio->streamID == IPC_STREAMID_SHARC0_OUT);
+}
+
+/*
+ * All streams and the process command (IPC_TYPE_BLOCK) in one message.
+ * Returns true if the block chains on to SHARC1, node 0 then writes the
+ * link rather than SHARC0_OUT.
+ */
+static bool newBlock(IPC_MSG_BLOCK *block)
+{
+    IPC_MSG_AUDIO_DESC *desc;
+    bool chain = false;
+    unsigned i;
+
+    streamInfo[IPC_STREAMID_SHARC_LINK] = NULL;
+    for (i = 0; i < block->numStreams; i++) {
+        desc = &block->stream[i];
+        newAudio(desc, false);
+        if (desc->streamID == IPC_STREAMID_SHARC_LINK) {
+            chain = true;
+        }
+    }
+
+    /* Nothing writes SHARC0_OUT while chained, keep it silent */
+    desc = streamInfo[IPC_STREAMID_SHARC0_OUT];
+    if (chain && desc) {
+        memset((void *)desc->data, 0,
+            desc->numChannels * desc->numFrames * desc->wordSize);
+    }
+
+    processAudio(block->clockDomain, block->plan);
+
+    return(chain);
+}
+
+/*
+ * New impulse response piece, queued for the background loop.  The
+ * sender holds the message until 'done' so it outlives our reference.
+ */
+static void newConv(IPC_MSG_CONV *msg)
+{
+    if (convPending) {
+        msg->done = IPC_CONV_REJECTED;
+        return;
     }
+    /* Traced here, the background loop is a different interrupt level */
+    if (msg->offset + msg->count >= msg->taps) {
+        TRACE_LOG3(TRACE_ID_SHARC_CONV, CONV_NODE,
+            msg->channels ? msg->taps : 0, msg->channels);
+    }
+    convPending = msg;
+}
 
-    if (!unknown) {
-        streamInfo[audio->streamID] = audio;
-        if (clear) {
-            memset(audio->data, 0,
-                audio->numChannels * audio->numFrames * audio->wordSize);
+/*
+ * Transforms the pending response piece, from the background loop so
+ * the audio interrupt never waits on it.  The convolver is off from
+ * the first piece, so nothing else uses its transform buffer, and back
+ * on with the last.  Channels past the last reuse it.
+ */
+static void convService(void)
+{
+    IPC_MSG_CONV *msg = convPending;
+    unsigned channel, src;
+    unsigned channels, taps;
+
+    if (msg == NULL) {
+        return;
+    }
+
+    if ((msg->offset != 0) && (msg->offset != convNext)) {
+        msg->done = IPC_CONV_REJECTED;
+        convPending = NULL;
+        return;
+    }
+
+    channels = msg->channels;
+    if (channels > IPC_CONV_CHANNELS) {
+        channels = IPC_CONV_CHANNELS;
+    }
+    taps = channels ? msg->taps : 0;
+
+    /*
+     * Keep the interrupt off the filter before the first pconv call, then
+     * load on the software FFT, the background loop never takes the lease
+     */
+    convOn = false;
+    pconv_set_fft(&conv, &convSoftFft);
+    if (taps) {
+        for (channel = 0; channel < IPC_CONV_CHANNELS; channel++) {
+            src = (channel < channels) ? channel : channels - 1;
+            pconv_load_ir(&conv, channel, msg->offset,
+                msg->ir + src * msg->count, msg->count);
+        }
+    }
+    convNext = msg->offset + msg->count;
+
+    if (convNext >= taps) {
+        for (channel = 0; channel < IPC_CONV_CHANNELS; channel++) {
+            pconv_set_taps(&conv, channel, taps);
         }
+        convOn = (taps > 0);
     }
+
+    msg->done = IPC_CONV_LOADED;
+    convPending = NULL;
 }
 
 /***********************************************************************
@@ -168,6 +471,7 @@ static void ipcMsgRx(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *buffer,
     SAE_RESULT result;
     IPC_MSG *msg = (IPC_MSG *)payload;
     IPC_MSG *replyMsg;
+    bool chain;
 
     /* Process the message */
     switch (msg->type) {
@@ -180,10 +484,31 @@ static void ipcMsgRx(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *buffer,
             }
             break;
         case IPC_TYPE_PROCESS_AUDIO:
-            processAudio((IPC_MSG_PROCESS_AUDIO *)&msg->process);
+            processAudio(msg->process.clockDomain, IPC_DSP_HOME_PLAN);
+            /* Output is ready, an ARM waiting on it can route it now */
+            msg->process.done[IPC_PROCESS_DONE_IDX(IPC_CORE_SHARC0)] = 1;
             break;
         case IPC_TYPE_AUDIO:
-            newAudio((IPC_MSG_AUDIO *)&msg->audio);
+            newAudioMsg((IPC_MSG_AUDIO *)&msg->audio);
+            break;
+        case IPC_TYPE_BLOCK:
+            chain = newBlock(&msg->block);
+            /* Output is ready, an ARM waiting on it can route it now */
+            msg->block.done[IPC_PROCESS_DONE_IDX(IPC_CORE_SHARC0)] = 1;
+            /* SHARC1 picks up from the link straight away */
+            if (chain) {
+                sae_refMsgBuffer(saeContext, buffer);
+                ipcToCore(saeContext, buffer, IPC_CORE_SHARC1);
+            }
+            break;
+        case IPC_TYPE_CONV:
+            if (msg->conv.node == CONV_NODE) {
+                newConv(&msg->conv);
+            }
+            break;
+        case IPC_TYPE_FFT_LEASE:
+            /* The ARM keeps it referenced for good */
+            fftLease = &msg->fftLease;
             break;
         case IPC_TYPE_CYCLES:
             if (cyclesMsg) {
@@ -221,6 +546,26 @@ int main(int argc, char **argv)
         msg->cycles.max = IPC_CYCLE_DOMAIN_MAX;
     }
 
+    /* Create a persistent trace log in shared L2 and hand it to the ARM */
+    traceMsg = sae_createMsgBuffer(saeContext,
+        IPC_MSG_TRACE_LOG_SIZE(TRACE_LOG_SHARC_ENTRIES), (void **)&msg);
+    if (traceMsg) {
+        msg->type = IPC_TYPE_TRACE_LOG;
+        trace_log_init(&msg->traceLog, TRACE_LOG_SHARC_ENTRIES, IPC_CORE_SHARC0);
+        sae_refMsgBuffer(saeContext, traceMsg);
+        ipcToCore(saeContext, traceMsg, IPC_CORE_ARM);
+    }
+
+    /* Convolver, passes through until it gets an impulse response */
+    pconv_soft_fft_init(&convSoft, &convSoftFft);
+#if defined(__ADSP21000__)
+    pconv_accel_fft_init(&convAccel, &convAccelFft);
+#else
+    convAccelFft = convSoftFft;
+#endif
+    pconv_init(&conv, convMem, sizeof(convMem), IPC_CONV_CHANNELS,
+        PCONV_PARTS(IPC_CONV_TAPS), &convSoftFft);
+
     /* Register an IPC message Rx callback */
     sae_registerMsgReceivedCallback(saeContext, ipcMsgRx, NULL);
 
@@ -228,6 +573,7 @@ int main(int argc, char **argv)
     quickIpcToCore(saeContext, IPC_TYPE_SHARC0_READY, IPC_CORE_ARM);
 
     while(1) {
+        convService();
         asm("nop;");
     };
 }
@@ -0,0 +1,62 @@
+// Micro-benchmark helpers shared by the kernel regression tests.
+//
+// Every kernel test checks the Code Under Test against a plain scalar
+// reference for bit-exactness first, then times both with BENCH() and
+// prints the cost per unit and the speedup.  An optimized kernel (NEON,
+// SHARC) is only acceptable when the equivalence checks pass and the
+// reported speedup is > 1.
+//
+// Timing only reports, it never fails a test, so the suite stays
+// deterministic on loaded build machines.
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS    2000
+#endif
+
+// Keeps the optimizer from discarding benchmarked work
+#define BENCH_CLOBBER()     __asm__ __volatile__("" ::: "memory")
+
+static inline uint64_t bench_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Runs 'stmt_' BENCH_ITERATIONS times, best of three, result in ns
+#define BENCH(ns_, stmt_) \
+    do { \
+        uint64_t best_ = UINT64_MAX; \
+        int rep_; \
+        for (rep_ = 0; rep_ < 3; rep_++) { \
+            uint64_t t0_ = bench_ns(); \
+            unsigned it_; \
+            for (it_ = 0; it_ < BENCH_ITERATIONS; it_++) { \
+                stmt_; \
+                BENCH_CLOBBER(); \
+            } \
+            t0_ = bench_ns() - t0_; \
+            if (t0_ < best_) { \
+                best_ = t0_; \
+            } \
+        } \
+        (ns_) = best_; \
+    } while (0)
+
+// Prints one reference vs. CUT line, 'units' processed per iteration
+static inline void bench_report(char const *name, uint64_t refNs,
+    uint64_t cutNs, unsigned units, char const *unitName)
+{
+    double div = (double)BENCH_ITERATIONS * units;
+    printf("  bench %-28s ref %7.2f ns/%s  cut %7.2f ns/%s  x%.2f\n",
+        name, refNs / div, unitName, cutNs / div, unitName,
+        cutNs ? (double)refNs / cutNs : 0.0);
+}
+
+#endif // BENCH_H_
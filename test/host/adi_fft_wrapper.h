@@ -0,0 +1,52 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Host stand-in for the CCES FFT accelerator wrapper.  Only the parts
+ * used by the application, tests supply the functions.
+ */
+#ifndef _host_adi_fft_wrapper_h
+#define _host_adi_fft_wrapper_h
+
+#include <stdint.h>
+
+typedef struct {
+    float re;
+    float im;
+} complex_float;
+
+typedef void *ADI_FFT_HANDLE;
+
+typedef enum {
+    ADI_FFT_ERROR_GIC,
+    ADI_FFT_ERROR_FFT,
+    ADI_FFT_ERROR_SIZE,
+    ADI_FFT_ERROR_NUM_CHANNELS,
+    ADI_FFT_ERROR_ALIGNMENT,
+    ADI_FFT_ERROR_ALIGNMENT_CACHE,
+    ADI_FFT_ERROR_TWIDDLES,
+    ADI_FFT_ERROR_FIR_BLOCK_SIZE
+} ADI_FFT_ERROR_KIND;
+
+#define ADI_FFT_HW_ERROR_DETECTED   (1)
+
+typedef void (*ADI_FFT_ERROR_HANDLER)(ADI_FFT_HANDLE h,
+    ADI_FFT_ERROR_KIND aek, void *error_handle, unsigned int error_code);
+
+extern const complex_float accel_twiddles_4096[];
+
+void accel_fft_set_error_handler(ADI_FFT_ERROR_HANDLER handler);
+float *accel_rfft_large_mag_sq(const float *input, float *output,
+    complex_float *temp, const complex_float *twiddles, int twiddle_stride,
+    float scale, int n);
+int adi_fft_GetHWErrorStatus(ADI_FFT_HANDLE h, uint32_t *status);
+
+#endif
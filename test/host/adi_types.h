@@ -0,0 +1,23 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/* Host stand-in for the CCES basic types */
+#ifndef _host_adi_types_h
+#define _host_adi_types_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef char char_t;
+typedef float float32_t;
+typedef double float64_t;
+
+#endif
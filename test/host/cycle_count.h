@@ -0,0 +1,31 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/* Host stand-in for the SHARC cycle counter macros */
+#ifndef _host_cycle_count_h
+#define _host_cycle_count_h
+
+#include <stdint.h>
+#include <time.h>
+
+typedef uint64_t cycle_t;
+
+static inline cycle_t host_cycles(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((cycle_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+#define START_CYCLE_COUNT(start)          (start) = host_cycles()
+#define STOP_CYCLE_COUNT(final, start)    (final) = host_cycles() - (start)
+
+#endif
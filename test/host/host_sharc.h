@@ -0,0 +1,26 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Forced include for the SHARC mains when built into the render
+ * harness.  Both SHARC images link into one process so the Makefile
+ * renames their globals and main(), and the idle loop at the end of
+ * main() parks the core's thread instead of spinning.
+ */
+#ifndef _host_sharc_h
+#define _host_sharc_h
+
+#include <string.h>
+#include <stdbool.h>
+
+void host_core_idle(void);
+
+#endif
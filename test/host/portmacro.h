@@ -0,0 +1,67 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Host port definitions for the render harness and host tests.  The
+ * FreeRTOS headers are used as-is but the kernel itself is replaced by
+ * the thin pthread implementation in render/host_rtos.c, which only
+ * covers the API subset the audio code uses.  Each task is a thread and
+ * "ISRs" run on the harness's main thread.
+ */
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#include <stdint.h>
+
+#define portCHAR        char
+#define portFLOAT       float
+#define portDOUBLE      double
+#define portLONG        long
+#define portSHORT       short
+#define portSTACK_TYPE  uint32_t
+#define portBASE_TYPE   long
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define portMAX_DELAY               ( TickType_t ) 0xffffffffUL
+#define portTICK_TYPE_IS_ATOMIC     1
+#define portSTACK_GROWTH            ( -1 )
+#define portTICK_PERIOD_MS          ( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT          8
+
+extern void vPortEnterCritical( void );
+extern void vPortExitCritical( void );
+extern void vPortYield( void );
+
+#define portYIELD()                             vPortYield()
+#define portEND_SWITCHING_ISR( xSwitchRequired ) ( void ) ( xSwitchRequired )
+#define portYIELD_FROM_ISR( x )                 portEND_SWITCHING_ISR( x )
+
+#define portENTER_CRITICAL()                    vPortEnterCritical()
+#define portEXIT_CRITICAL()                     vPortExitCritical()
+#define portDISABLE_INTERRUPTS()                vPortEnterCritical()
+#define portENABLE_INTERRUPTS()                 vPortExitCritical()
+#define portSET_INTERRUPT_MASK_FROM_ISR()       ( vPortEnterCritical(), 0 )
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )  vPortExitCritical()
+
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void *pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters )       void vFunction( void *pvParameters )
+
+#define vPortTaskUsesFPU()
+#define portTASK_USES_FLOATING_POINT()
+
+#define portNOP()
+#define portINLINE __inline
+
+#endif
@@ -0,0 +1,22 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Host stand-in for the CCES interrupt API.  All simulated ISRs run on
+ * the render harness's main thread so they never preempt each other.
+ */
+#ifndef _host_interrupt_h
+#define _host_interrupt_h
+
+#define adi_rtl_disable_interrupts()
+#define adi_rtl_reenable_interrupts()
+
+#endif
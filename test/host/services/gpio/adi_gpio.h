@@ -0,0 +1,21 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/* Host stand-in for the CCES GPIO service types */
+#ifndef _host_adi_gpio_h
+#define _host_adi_gpio_h
+
+typedef int ADI_GPIO_PORT;
+typedef int ADI_GPIO_DIRECTION;
+typedef int ADI_GPIO_PIN_INTERRUPT;
+typedef int ADI_GPIO_RESULT;
+
+#endif
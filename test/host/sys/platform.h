@@ -0,0 +1,28 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Host stand-in for the CCES platform header.  The CGU timestamp
+ * counter is a variable the host program defines, the render harness
+ * advances it with the simulated sample clock.
+ */
+#ifndef _host_platform_h
+#define _host_platform_h
+
+#include <stdint.h>
+
+#include <runtime/cache/adi_cache.h>
+
+extern volatile uint32_t hostTsCount;
+
+#define pREG_CGU0_TSCOUNT0  (&hostTsCount)
+
+#endif
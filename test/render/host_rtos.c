@@ -0,0 +1,316 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Minimal FreeRTOS kernel stand-in for the render harness.
+ *
+ * Only the API subset used by the audio graph is implemented.  Tasks
+ * are detached pthreads, task notifications and semaphores are
+ * condition variables and critical sections share one recursive
+ * mutex.  Priorities are ignored, the harness never depends on
+ * scheduling order for its output.
+ */
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+struct tskTaskControlBlock {
+    pthread_t thread;
+    TaskFunction_t code;
+    void *params;
+    char name[configMAX_TASK_NAME_LEN];
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t value[configTASK_NOTIFICATION_ARRAY_ENTRIES];
+    bool pending[configTASK_NOTIFICATION_ARRAY_ENTRIES];
+};
+
+struct QueueDefinition {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    UBaseType_t count;
+};
+
+static pthread_mutex_t criticalLock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static __thread TaskHandle_t currentTask = NULL;
+
+/* Absolute CLOCK_REALTIME deadline 'ticks' from now */
+static void tickDeadline(TickType_t ticks, struct timespec *ts)
+{
+    uint64_t ns;
+
+    clock_gettime(CLOCK_REALTIME, ts);
+    ns = (uint64_t)ticks * (1000000000ULL / configTICK_RATE_HZ) + ts->tv_nsec;
+    ts->tv_sec += ns / 1000000000ULL;
+    ts->tv_nsec = ns % 1000000000ULL;
+}
+
+/* Waits on 'cond', returns false on timeout */
+static bool condWait(pthread_cond_t *cond, pthread_mutex_t *lock,
+    TickType_t ticks, struct timespec *deadline)
+{
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, lock);
+        return(true);
+    }
+    return(pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT);
+}
+
+/***********************************************************************
+ * Tasks
+ **********************************************************************/
+static void *taskEntry(void *arg)
+{
+    TaskHandle_t task = (TaskHandle_t)arg;
+
+    currentTask = task;
+    task->code(task->params);
+
+    return(NULL);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName,
+    const configSTACK_DEPTH_TYPE usStackDepth, void * const pvParameters,
+    UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask)
+{
+    TaskHandle_t task;
+
+    task = calloc(1, sizeof(*task));
+    if (task == NULL) {
+        return(errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY);
+    }
+    task->code = pxTaskCode;
+    task->params = pvParameters;
+    strncpy(task->name, pcName, sizeof(task->name) - 1);
+    pthread_mutex_init(&task->lock, NULL);
+    pthread_cond_init(&task->cond, NULL);
+
+    /* Publish the handle before the task can use it */
+    if (pxCreatedTask) {
+        *pxCreatedTask = task;
+    }
+
+    if (pthread_create(&task->thread, NULL, taskEntry, task) != 0) {
+        if (pxCreatedTask) {
+            *pxCreatedTask = NULL;
+        }
+        free(task);
+        return(errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY);
+    }
+    pthread_detach(task->thread);
+
+    return(pdPASS);
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+    struct timespec ts;
+
+    ts.tv_sec = xTicksToDelay / configTICK_RATE_HZ;
+    ts.tv_nsec = (xTicksToDelay % configTICK_RATE_HZ) *
+        (1000000000L / configTICK_RATE_HZ);
+    nanosleep(&ts, NULL);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((TickType_t)(ts.tv_sec * configTICK_RATE_HZ +
+        ts.tv_nsec / (1000000000L / configTICK_RATE_HZ)));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return(currentTask);
+}
+
+/***********************************************************************
+ * Task notifications
+ **********************************************************************/
+uint32_t ulTaskGenericNotifyTake(UBaseType_t uxIndexToWaitOn,
+    BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    TaskHandle_t task = currentTask;
+    struct timespec deadline;
+    uint32_t value;
+
+    if (xTicksToWait != portMAX_DELAY) {
+        tickDeadline(xTicksToWait, &deadline);
+    }
+
+    pthread_mutex_lock(&task->lock);
+    while ((task->value[uxIndexToWaitOn] == 0) && (xTicksToWait != 0)) {
+        if (!condWait(&task->cond, &task->lock, xTicksToWait, &deadline)) {
+            break;
+        }
+    }
+    value = task->value[uxIndexToWaitOn];
+    if (value) {
+        task->value[uxIndexToWaitOn] = xClearCountOnExit ? 0 : value - 1;
+    }
+    task->pending[uxIndexToWaitOn] = false;
+    pthread_mutex_unlock(&task->lock);
+
+    return(value);
+}
+
+BaseType_t xTaskGenericNotify(TaskHandle_t xTaskToNotify,
+    UBaseType_t uxIndexToNotify, uint32_t ulValue, eNotifyAction eAction,
+    uint32_t *pulPreviousNotificationValue)
+{
+    TaskHandle_t task = xTaskToNotify;
+    BaseType_t result = pdPASS;
+    uint32_t *value;
+
+    if (task == NULL) {
+        return(pdFAIL);
+    }
+
+    pthread_mutex_lock(&task->lock);
+    value = &task->value[uxIndexToNotify];
+    if (pulPreviousNotificationValue) {
+        *pulPreviousNotificationValue = *value;
+    }
+    switch (eAction) {
+        case eSetBits:
+            *value |= ulValue;
+            break;
+        case eIncrement:
+            (*value)++;
+            break;
+        case eSetValueWithOverwrite:
+            *value = ulValue;
+            break;
+        case eSetValueWithoutOverwrite:
+            if (task->pending[uxIndexToNotify]) {
+                result = pdFAIL;
+            } else {
+                *value = ulValue;
+            }
+            break;
+        case eNoAction:
+        default:
+            break;
+    }
+    task->pending[uxIndexToNotify] = true;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+
+    return(result);
+}
+
+BaseType_t xTaskGenericNotifyFromISR(TaskHandle_t xTaskToNotify,
+    UBaseType_t uxIndexToNotify, uint32_t ulValue, eNotifyAction eAction,
+    uint32_t *pulPreviousNotificationValue,
+    BaseType_t *pxHigherPriorityTaskWoken)
+{
+    if (pxHigherPriorityTaskWoken) {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+    return(xTaskGenericNotify(xTaskToNotify, uxIndexToNotify, ulValue,
+        eAction, pulPreviousNotificationValue));
+}
+
+/***********************************************************************
+ * Semaphores and mutexes (no priority inheritance)
+ **********************************************************************/
+QueueHandle_t xQueueCreateMutex(const uint8_t ucQueueType)
+{
+    QueueHandle_t q;
+
+    q = calloc(1, sizeof(*q));
+    if (q) {
+        pthread_mutex_init(&q->lock, NULL);
+        pthread_cond_init(&q->cond, NULL);
+        q->count = 1;
+    }
+
+    return(q);
+}
+
+QueueHandle_t xQueueCreateCountingSemaphore(const UBaseType_t uxMaxCount,
+    const UBaseType_t uxInitialCount)
+{
+    QueueHandle_t q;
+
+    q = xQueueCreateMutex(queueQUEUE_TYPE_COUNTING_SEMAPHORE);
+    if (q) {
+        q->count = uxInitialCount;
+    }
+
+    return(q);
+}
+
+BaseType_t xQueueSemaphoreTake(QueueHandle_t xQueue, TickType_t xTicksToWait)
+{
+    struct timespec deadline;
+    BaseType_t result = pdFALSE;
+
+    if (xTicksToWait != portMAX_DELAY) {
+        tickDeadline(xTicksToWait, &deadline);
+    }
+
+    pthread_mutex_lock(&xQueue->lock);
+    while ((xQueue->count == 0) && (xTicksToWait != 0)) {
+        if (!condWait(&xQueue->cond, &xQueue->lock, xTicksToWait, &deadline)) {
+            break;
+        }
+    }
+    if (xQueue->count) {
+        xQueue->count--;
+        result = pdTRUE;
+    }
+    pthread_mutex_unlock(&xQueue->lock);
+
+    return(result);
+}
+
+/* Only used as xSemaphoreGive() */
+BaseType_t xQueueGenericSend(QueueHandle_t xQueue,
+    const void * const pvItemToQueue, TickType_t xTicksToWait,
+    const BaseType_t xCopyPosition)
+{
+    pthread_mutex_lock(&xQueue->lock);
+    xQueue->count++;
+    pthread_cond_signal(&xQueue->cond);
+    pthread_mutex_unlock(&xQueue->lock);
+
+    return(pdPASS);
+}
+
+/***********************************************************************
+ * Port layer
+ **********************************************************************/
+void vPortEnterCritical(void)
+{
+    pthread_mutex_lock(&criticalLock);
+}
+
+void vPortExitCritical(void)
+{
+    pthread_mutex_unlock(&criticalLock);
+}
+
+void vPortYield(void)
+{
+    sched_yield();
+}
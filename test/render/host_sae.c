@@ -0,0 +1,178 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * SHARC Audio Engine stand-in for the render harness.
+ *
+ * All three "cores" live in one process.  Message buffers are plain
+ * reference counted heap allocations and sae_sendMsgBuffer() calls the
+ * destination core's receive callback directly on the sender's thread.
+ * Delivery order matches the hardware queues so the SHARC sees the
+ * audio ping/pong and process messages in the same sequence as on the
+ * board.
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "sae.h"
+#include "sae_lock.h"
+
+struct _SAE_CONTEXT {
+    SAE_CORE_IDX idx;
+    SAE_MSG_RECEIVED_CALLBACK msgRxCb;
+    void *msgRxUsrPtr;
+};
+
+struct _SAE_MSG_BUFFER {
+    uint32_t refCount;
+    size_t size;
+    uint64_t payload[];
+};
+
+static SAE_CONTEXT saeCores[IPC_MAX_CORES];
+static SAE_HEAP_INFO saeHeap;
+
+SAE_RESULT sae_initialize(SAE_CONTEXT **context, SAE_CORE_IDX saeIdx,
+    bool saeMaster)
+{
+    if ((saeIdx < SAE_CORE_IDX_0) || (saeIdx >= IPC_MAX_CORES)) {
+        return(SAE_RESULT_ERROR);
+    }
+    saeCores[saeIdx].idx = saeIdx;
+    *context = &saeCores[saeIdx];
+    return(SAE_RESULT_OK);
+}
+
+SAE_RESULT sae_unInitialize(SAE_CONTEXT **contextPtr)
+{
+    (*contextPtr)->msgRxCb = NULL;
+    *contextPtr = NULL;
+    return(SAE_RESULT_OK);
+}
+
+SAE_RESULT sae_heapInfo(SAE_CONTEXT *context, SAE_HEAP_INFO *heapInfo)
+{
+    *heapInfo = saeHeap;
+    return(SAE_RESULT_OK);
+}
+
+SAE_MSG_BUFFER *sae_createMsgBuffer(SAE_CONTEXT *context, size_t size,
+    void **payload)
+{
+    SAE_MSG_BUFFER *msg;
+
+    msg = calloc(1, sizeof(*msg) + size);
+    if (msg == NULL) {
+        return(NULL);
+    }
+    msg->refCount = 1;
+    msg->size = size;
+    if (payload) {
+        *payload = msg->payload;
+    }
+
+    __atomic_fetch_add(&saeHeap.allocBlocks, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&saeHeap.allocSize, size, __ATOMIC_RELAXED);
+
+    return(msg);
+}
+
+size_t sae_getMsgBufferSize(SAE_MSG_BUFFER *msg)
+{
+    return(msg->size);
+}
+
+void *sae_getMsgBufferPayload(SAE_MSG_BUFFER *msg)
+{
+    return(msg->payload);
+}
+
+SAE_RESULT sae_refMsgBuffer(SAE_CONTEXT *context, SAE_MSG_BUFFER *msg)
+{
+    __atomic_fetch_add(&msg->refCount, 1, __ATOMIC_ACQ_REL);
+    return(SAE_RESULT_OK);
+}
+
+SAE_RESULT sae_unRefMsgBuffer(SAE_CONTEXT *context, SAE_MSG_BUFFER *msg)
+{
+    uint32_t refCount;
+
+    refCount = __atomic_sub_fetch(&msg->refCount, 1, __ATOMIC_ACQ_REL);
+    if (refCount == 0) {
+        __atomic_fetch_sub(&saeHeap.allocBlocks, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_sub(&saeHeap.allocSize, msg->size, __ATOMIC_RELAXED);
+        free(msg);
+    } else if (refCount == UINT32_MAX) {
+        return(SAE_RESULT_REFERENCE_ERROR);
+    }
+
+    return(SAE_RESULT_OK);
+}
+
+/* Messages are never queued, there is nothing to receive */
+SAE_RESULT sae_receiveMsgBuffer(SAE_CONTEXT *context, SAE_MSG_BUFFER **msg)
+{
+    *msg = NULL;
+    return(SAE_RESULT_QUEUE_EMPTY);
+}
+
+SAE_RESULT sae_sendMsgBuffer(SAE_CONTEXT *context, SAE_MSG_BUFFER *msg,
+    uint8_t dstCoreIdx, bool signalDstCore)
+{
+    SAE_CONTEXT *dst;
+
+    if (dstCoreIdx >= IPC_MAX_CORES) {
+        return(SAE_RESULT_ERROR);
+    }
+
+    dst = &saeCores[dstCoreIdx];
+    if (dst->msgRxCb == NULL) {
+        return(SAE_RESULT_CORE_NOT_READY);
+    }
+
+    /* The receiver owns the sent reference */
+    dst->msgRxCb(dst, msg, msg->payload, dst->msgRxUsrPtr);
+
+    return(SAE_RESULT_OK);
+}
+
+SAE_RESULT sae_registerMsgReceivedCallback(SAE_CONTEXT *context,
+    SAE_MSG_RECEIVED_CALLBACK cb, void *usrPtr)
+{
+    context->msgRxUsrPtr = usrPtr;
+    context->msgRxCb = cb;
+    return(SAE_RESULT_OK);
+}
+
+/* Cross-core locks, the "cores" share one address space */
+bool sae_lock(volatile uint32_t *lock)
+{
+    uint32_t unlocked = SAE_SHARC_ARM_IPC_UNLOCKED;
+
+    return(__atomic_compare_exchange_n(lock, &unlocked,
+        SAE_SHARC_ARM_IPC_LOCKED, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+}
+
+bool sae_unlock(volatile uint32_t *lock)
+{
+    __atomic_store_n(lock, SAE_SHARC_ARM_IPC_UNLOCKED, __ATOMIC_SEQ_CST);
+    return(true);
+}
+
+/*
+ * A SHARC main()'s background loop.  Messages arrive on the sender's
+ * thread, the loop keeps its own for work done outside them.
+ */
+void host_core_idle(void)
+{
+    usleep(100);
+}
@@ -0,0 +1,233 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Stand-ins for the parts of the ARM application the render harness
+ * does not run.  Network and VU streams join their clock domains like
+ * the real drivers but never carry audio, USB is backed by the
+ * harness's own block buffers, the heaps map onto libc and there is no
+ * FatFs volume for the WAV recorder.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "context.h"
+#include "clock_domain.h"
+#include "rtp_audio.h"
+#include "vban_audio.h"
+#include "avtp_audio.h"
+#include "usb_audio.h"
+#include "vu_audio.h"
+#include "gptp_clock.h"
+#include "cpu_load.h"
+#include "umm_malloc.h"
+#include "route.h"
+#include "wav_rec.h"
+#include "util.h"
+
+#include "render.h"
+
+APP_CONTEXT mainAppContext;
+
+SYSTEM_AUDIO_TYPE hostUsbRxBuffer[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
+SYSTEM_AUDIO_TYPE hostUsbTxBuffer[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
+
+static SYSTEM_AUDIO_TYPE hostVuBuffer[VU_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
+
+static const unsigned rtpRxMasks[RTP_RX_STREAMS] = {
+    CLOCK_DOMAIN_BITM_RTP_RX, CLOCK_DOMAIN_BITM_RTP2_RX, CLOCK_DOMAIN_BITM_RTP3_RX
+};
+static const STREAM_ID rtpRxStreams[RTP_RX_STREAMS] = {
+    STREAM_ID_RTP_RX, STREAM_ID_RTP2_RX, STREAM_ID_RTP3_RX
+};
+static const unsigned vbanRxMasks[VBAN_RX_STREAMS] = {
+    CLOCK_DOMAIN_BITM_VBAN_RX, CLOCK_DOMAIN_BITM_VBAN2_RX, CLOCK_DOMAIN_BITM_VBAN3_RX
+};
+static const STREAM_ID vbanRxStreams[VBAN_RX_STREAMS] = {
+    STREAM_ID_VBAN_RX, STREAM_ID_VBAN2_RX, STREAM_ID_VBAN3_RX
+};
+
+/* Joins the clock domain without any audio */
+static int xferSilent(APP_CONTEXT *context, unsigned mask, CLOCK_DOMAIN cd,
+    void **audio, unsigned *numChannels)
+{
+    CLOCK_DOMAIN myCd;
+
+    myCd = clock_domain_get(context, mask);
+    if (myCd != cd) {
+        return(0);
+    }
+    clock_domain_set_active(context, myCd, mask);
+
+    if (audio) {
+        *audio = NULL;
+    }
+    *numChannels = 0;
+
+    return(1);
+}
+
+/***********************************************************************
+ * RTP / VBAN / AVTP
+ **********************************************************************/
+int xferRtpRxAudio(APP_CONTEXT *context, unsigned idx, void **audio,
+    CLOCK_DOMAIN cd, unsigned *numChannels)
+{
+    return(xferSilent(context, rtpRxMasks[idx], cd, audio, numChannels));
+}
+
+STREAM_ID rtpRxStreamID(unsigned idx)
+{
+    return(rtpRxStreams[idx]);
+}
+
+int xferRtpTxAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd,
+    unsigned *numChannels)
+{
+    return(xferSilent(context, CLOCK_DOMAIN_BITM_RTP_TX, cd, audio, numChannels));
+}
+
+int xferVbanRxAudio(APP_CONTEXT *context, unsigned idx, void **audio,
+    CLOCK_DOMAIN cd, unsigned *numChannels)
+{
+    return(xferSilent(context, vbanRxMasks[idx], cd, audio, numChannels));
+}
+
+STREAM_ID vbanRxStreamID(unsigned idx)
+{
+    return(vbanRxStreams[idx]);
+}
+
+int xferVbanTxAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd,
+    unsigned *numChannels)
+{
+    return(xferSilent(context, CLOCK_DOMAIN_BITM_VBAN_TX, cd, audio, numChannels));
+}
+
+int xferAvtpRxAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd,
+    unsigned *numChannels)
+{
+    return(xferSilent(context, CLOCK_DOMAIN_BITM_AVTP_RX, cd, audio, numChannels));
+}
+
+int xferAvtpTxAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd,
+    unsigned *numChannels)
+{
+    return(xferSilent(context, CLOCK_DOMAIN_BITM_AVTP_TX, cd, audio, numChannels));
+}
+
+/***********************************************************************
+ * USB / VU
+ **********************************************************************/
+int xferUsbRxAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd)
+{
+    unsigned numChannels;
+
+    if (!xferSilent(context, CLOCK_DOMAIN_BITM_USB_RX, cd, NULL, &numChannels)) {
+        return(0);
+    }
+    *audio = hostUsbRxBuffer;
+
+    return(1);
+}
+
+int xferUsbTxAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd)
+{
+    unsigned numChannels;
+
+    if (!xferSilent(context, CLOCK_DOMAIN_BITM_USB_TX, cd, NULL, &numChannels)) {
+        return(0);
+    }
+    memset(hostUsbTxBuffer, 0,
+        context->cfg.usbInChannels * context->cfg.usbWordSize * SYSTEM_BLOCK_SIZE);
+    *audio = hostUsbTxBuffer;
+
+    return(1);
+}
+
+int xferVUSinkAudio(APP_CONTEXT *context, void **audio, CLOCK_DOMAIN cd)
+{
+    unsigned numChannels;
+
+    if (!xferSilent(context, CLOCK_DOMAIN_BITM_VU_IN, cd, NULL, &numChannels)) {
+        return(0);
+    }
+    *audio = hostVuBuffer;
+
+    return(1);
+}
+
+/***********************************************************************
+ * WAV recorder, sinks render through stdio only
+ **********************************************************************/
+size_t wav_rec_write(WAV_REC *rec, const int32_t *src, size_t samples)
+{
+    return((size_t)-1);
+}
+
+/***********************************************************************
+ * Clocks and CPU load
+ **********************************************************************/
+bool gptpClockNow(APP_CONTEXT *context, uint64_t *now)
+{
+    return(false);
+}
+
+uint32_t getTimeStamp(void)
+{
+    return(hostTsCount);
+}
+
+void cpuLoadISREnter(void)
+{
+}
+
+void cpuLoadISRExit(void)
+{
+}
+
+/***********************************************************************
+ * Heaps
+ **********************************************************************/
+void *umm_malloc_heap(umm_heap_t heap, size_t size)
+{
+    return(malloc(size));
+}
+
+void *umm_calloc_heap(umm_heap_t heap, size_t num, size_t size)
+{
+    return(calloc(num, size));
+}
+
+void umm_free_heap(umm_heap_t heap, void *ptr)
+{
+    free(ptr);
+}
+
+void *umm_calloc_aligned(size_t num, size_t item_size, size_t alignment)
+{
+    void *ptr;
+
+    if (alignment < sizeof(void *)) {
+        alignment = sizeof(void *);
+    }
+    if (posix_memalign(&ptr, alignment, num * item_size) != 0) {
+        return(NULL);
+    }
+    memset(ptr, 0, num * item_size);
+
+    return(ptr);
+}
+
+void umm_free_aligned(void *ptr)
+{
+    free(ptr);
+}
@@ -0,0 +1,857 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+/*
+ * Offline render harness.
+ *
+ * Runs the real ARM audio graph (processAudio(), routeAudio(), the
+ * clock domains and the WAV src/sink tasks) together with both SHARC
+ * images on the host.  The codec, SPDIF and A2B DMA completion
+ * callbacks are ticked back to back from WAV files, one SYSTEM_BLOCK_SIZE
+ * block per tick, and every sink is written to a WAV file.  Nothing
+ * waits on a real clock so a render runs as fast as the host allows and
+ * the output is bit-exact from run to run.
+ *
+ * Usage:
+ *   render [-s seconds] [-a a2bChannels] [-u usbChannels] [-w wavChannels]
+ *          [-b 16|24|32] [-r routes.txt] [-i stream=in.wav]... [-o stream=out.wav]...
+ *          [-z] [-c] [-j plan] [-x node=ir.wav]
+ *
+ * -z routes the SHARC output in the same block it was processed in
+ * (the 'sharc sync' mode) rather than a block later.  -c chains SHARC0
+ * straight into SHARC1 (the 'sharc chain on' mode).  -j runs the SHARC
+ * DSP jobs to a fixed plan, a bit per job set for SHARC1 (see
+ * IPC_DSP_JOBS), there are no cycle counts to balance on.  -x loads
+ * the impulse responses in a wave file on a DSP node's convolver (the
+ * 'sharc conv' command), one per channel.
+ *
+ * Streams are codec, spdif, a2b, usb and wav.  The route file holds
+ * shell 'route' commands, one per line, '#' starts a comment:
+ *   route 0 codec 0 sharc0 0 2
+ *   route 1 sharc0 0 codec 0 2
+ *   route 2 wav 0 codec 2 2 6 mix
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "context.h"
+#include "clock_domain.h"
+#include "process_audio.h"
+#include "codec_audio.h"
+#include "spdif_audio.h"
+#include "a2b_audio.h"
+#include "sharc_audio.h"
+#include "wav_audio.h"
+#include "wav_file.h"
+#include "audio_pool.h"
+#include "util.h"
+#include "route.h"
+#include "clocks.h"
+#include "ipc.h"
+#include "sae.h"
+#include "trace_log.h"
+
+#include "render.h"
+
+/* SHARC mains, renamed by the makefile */
+int sharc0_main(int argc, char **argv);
+int sharc1_main(int argc, char **argv);
+
+volatile uint32_t hostTsCount = 0;
+
+/* A host, non-WAV, stream endpoint */
+typedef struct RENDER_PORT {
+    const char *name;
+    void *buf;
+    unsigned channels;
+    unsigned wordSize;
+    WAV_FILE wf;
+    bool open;
+    uint64_t frames;
+} RENDER_PORT;
+
+enum {
+    RENDER_PORT_CODEC = 0,
+    RENDER_PORT_SPDIF,
+    RENDER_PORT_A2B,
+    RENDER_PORT_USB,
+    RENDER_PORT_MAX
+};
+
+static SYSTEM_AUDIO_TYPE codecIn[CODEC_DMA_CHANNELS * SYSTEM_BLOCK_SIZE];
+static SYSTEM_AUDIO_TYPE codecOut[CODEC_DMA_CHANNELS * SYSTEM_BLOCK_SIZE];
+static SYSTEM_AUDIO_TYPE spdifIn[SPDIF_DMA_CHANNELS * SYSTEM_BLOCK_SIZE];
+static SYSTEM_AUDIO_TYPE spdifOut[SPDIF_DMA_CHANNELS * SYSTEM_BLOCK_SIZE];
+static SYSTEM_AUDIO_TYPE a2bIn[A2B_DMA_CHANNELS * SYSTEM_BLOCK_SIZE];
+static SYSTEM_AUDIO_TYPE a2bOut[A2B_DMA_CHANNELS * SYSTEM_BLOCK_SIZE];
+
+/* File side conversion buffers, native file format and decoded */
+static SYSTEM_AUDIO_TYPE renderScratch[WAV_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
+static int32_t renderDecoded[WAV_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
+
+static RENDER_PORT inPorts[RENDER_PORT_MAX];
+static RENDER_PORT outPorts[RENDER_PORT_MAX];
+
+static const char * const portNames[RENDER_PORT_MAX] = {
+    "codec", "spdif", "a2b", "usb"
+};
+
+/***********************************************************************
+ * Routing
+ **********************************************************************/
+static STREAM_ID renderStream(const char *stream, bool src)
+{
+    if (strcmp(stream, "usb") == 0) {
+        return(src ? STREAM_ID_USB_RX : STREAM_ID_USB_TX);
+    } else if (strcmp(stream, "codec") == 0) {
+        return(src ? STREAM_ID_CODEC_IN : STREAM_ID_CODEC_OUT);
+    } else if (strcmp(stream, "spdif") == 0) {
+        return(src ? STREAM_ID_SPDIF_IN : STREAM_ID_SPDIF_OUT);
+    } else if (strcmp(stream, "a2b") == 0) {
+        return(src ? STREAM_ID_A2B_IN : STREAM_ID_A2B_OUT);
+    } else if (strcmp(stream, "wav") == 0) {
+        return(src ? STREAM_ID_WAV_SRC : STREAM_ID_WAV_SINK);
+    } else if (strcmp(stream, "sharc0") == 0) {
+        return(src ? STREAM_ID_SHARC0_OUT : STREAM_ID_SHARC0_IN);
+    } else if (strcmp(stream, "sharc1") == 0) {
+        return(src ? STREAM_ID_SHARC1_OUT : STREAM_ID_SHARC1_IN);
+    } else if (strcmp(stream, "vu") == 0) {
+        return(src ? STREAM_ID_MAX : STREAM_ID_VU_IN);
+    } else if (strcmp(stream, "rtp") == 0) {
+        return(src ? STREAM_ID_RTP_RX : STREAM_ID_RTP_TX);
+    } else if (strcmp(stream, "vban") == 0) {
+        return(src ? STREAM_ID_VBAN_RX : STREAM_ID_VBAN_TX);
+    } else if (strcmp(stream, "avtp") == 0) {
+        return(src ? STREAM_ID_AVTP_RX : STREAM_ID_AVTP_TX);
+    } else if (strcmp(stream, "off") == 0) {
+        return(STREAM_ID_UNKNOWN);
+    }
+
+    return(STREAM_ID_MAX);
+}
+
+/* Same arguments as the shell 'route' command */
+static bool parseRoute(APP_CONTEXT *context, int argc, char **argv)
+{
+    ROUTE_INFO *route;
+    STREAM_ID srcID, sinkID;
+    int idx;
+    int channels;
+    int attenuation;
+
+    if ((argc < 7) || (strcmp(argv[0], "route") != 0)) {
+        return(false);
+    }
+
+    idx = atoi(argv[1]);
+    if ((idx < 0) || (idx >= MAX_AUDIO_ROUTES)) {
+        return(false);
+    }
+
+    srcID = renderStream(argv[2], true);
+    sinkID = renderStream(argv[4], false);
+    if ((srcID == STREAM_ID_MAX) || (sinkID == STREAM_ID_MAX)) {
+        return(false);
+    }
+
+    channels = atoi(argv[6]);
+    if ((channels < 0) || (channels > SYSTEM_MAX_CHANNELS)) {
+        return(false);
+    }
+
+    attenuation = (argc >= 8) ? abs(atoi(argv[7])) : 0;
+    if (attenuation > 120) {
+        attenuation = 120;
+    }
+
+    route = &context->routingTable[idx];
+    route->srcID = srcID;
+    route->srcOffset = atoi(argv[3]);
+    route->sinkID = sinkID;
+    route->sinkOffset = atoi(argv[5]);
+    route->channels = channels;
+    route->attenuation = attenuation;
+    route->mix = (argc >= 9) && (strcmp(argv[8], "mix") == 0);
+
+    return(true);
+}
+
+static bool loadRoutes(APP_CONTEXT *context, const char *fname)
+{
+    char line[256];
+    char *argv[16];
+    char *tok;
+    int argc;
+    int lineNum = 0;
+    bool ok = true;
+    FILE *f;
+
+    f = fopen(fname, "r");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot open %s\n", fname);
+        return(false);
+    }
+
+    while (ok && fgets(line, sizeof(line), f)) {
+        lineNum++;
+        if ((tok = strchr(line, '#'))) {
+            *tok = '\0';
+        }
+        argc = 0;
+        for (tok = strtok(line, " \t\r\n"); tok && (argc < 16);
+             tok = strtok(NULL, " \t\r\n")) {
+            argv[argc++] = tok;
+        }
+        if (argc == 0) {
+            continue;
+        }
+        ok = parseRoute(context, argc, argv);
+        if (!ok) {
+            fprintf(stderr, "%s:%d: bad route\n", fname, lineNum);
+        }
+    }
+
+    fclose(f);
+
+    return(ok);
+}
+
+/***********************************************************************
+ * Host stream endpoints
+ **********************************************************************/
+static bool checkWaveSrc(WAV_FILE *wf)
+{
+    if (wf->waveInfo.waveFmt == WAVE_FMT_UNKNOWN) {
+        fprintf(stderr, "%s: unsupported sample format\n", wf->fname);
+        return(false);
+    }
+    if (wf->channels > WAV_MAX_CHANNELS) {
+        fprintf(stderr, "%s: more than %d channels\n", wf->fname, WAV_MAX_CHANNELS);
+        return(false);
+    }
+    if (wf->sampleRate != SYSTEM_SAMPLE_RATE) {
+        fprintf(stderr, "%s: sample rate mismatch: %u\n",
+            wf->fname, wf->sampleRate);
+    }
+    return(true);
+}
+
+static bool openPort(RENDER_PORT *port, char *fname, bool isSrc, unsigned bits)
+{
+    WAV_FILE *wf = &port->wf;
+
+    wf->fname = fname;
+    wf->isSrc = isSrc;
+    if (!isSrc) {
+        wf->channels = port->channels;
+        wf->sampleRate = SYSTEM_SAMPLE_RATE;
+        wf->wordSizeBytes = bits / 8;
+        wf->frameSizeBytes = wf->channels * wf->wordSizeBytes;
+    }
+
+    port->open = openWave(wf);
+    if (!port->open) {
+        fprintf(stderr, "Cannot open %s\n", fname);
+        return(false);
+    }
+    if (isSrc) {
+        if (!checkWaveSrc(wf)) {
+            closeWave(wf);
+            port->open = false;
+            return(false);
+        }
+        port->frames = wf->dataSize / wf->channels;
+    }
+
+    return(true);
+}
+
+/* Loads the next input block, silence once the file runs out */
+static void readPort(RENDER_PORT *port)
+{
+    WAV_FILE *wf = &port->wf;
+    unsigned frames;
+    size_t rsize;
+
+    memset(port->buf, 0, port->channels * port->wordSize * SYSTEM_BLOCK_SIZE);
+    if (!port->open || (port->frames == 0)) {
+        return;
+    }
+
+    frames = (port->frames < SYSTEM_BLOCK_SIZE) ?
+        (unsigned)port->frames : SYSTEM_BLOCK_SIZE;
+    rsize = readWave(wf, renderScratch, frames * wf->channels);
+    if (rsize != (frames * wf->channels)) {
+        port->frames = 0;
+        return;
+    }
+    decodeWave(wf, renderScratch, renderDecoded, frames * wf->channels);
+    copyAndConvert(
+        renderDecoded, sizeof(int32_t), wf->channels,
+        port->buf, port->wordSize, port->channels,
+        frames, false
+    );
+    port->frames -= frames;
+}
+
+static void writePort(RENDER_PORT *port)
+{
+    WAV_FILE *wf = &port->wf;
+
+    if (!port->open) {
+        return;
+    }
+    copyAndConvert(
+        port->buf, port->wordSize, port->channels,
+        renderDecoded, sizeof(int32_t), wf->channels,
+        SYSTEM_BLOCK_SIZE, false
+    );
+    encodeWave(wf, renderDecoded, renderScratch,
+        SYSTEM_BLOCK_SIZE * wf->channels);
+    writeWave(wf, renderScratch, SYSTEM_BLOCK_SIZE * wf->channels);
+}
+
+/***********************************************************************
+ * WAV src/sink tasks
+ **********************************************************************/
+static bool openWavStream(APP_CONTEXT *context, WAV_FILE *wf, char *fname,
+    bool isSrc, unsigned channels, unsigned bits)
+{
+    bool ok;
+
+    xSemaphoreTake((SemaphoreHandle_t)wf->lock, portMAX_DELAY);
+    if (!isSrc) {
+        wf->channels = channels;
+        wf->sampleRate = SYSTEM_SAMPLE_RATE;
+        wf->wordSizeBytes = bits / 8;
+        wf->frameSizeBytes = wf->channels * wf->wordSizeBytes;
+    }
+    wf->fname = fname;
+    wf->isSrc = isSrc;
+    ok = openWave(wf);
+    if (!ok) {
+        fprintf(stderr, "Cannot open %s\n", fname);
+    } else {
+        if (isSrc && !checkWaveSrc(wf)) {
+            closeWave(wf);
+            ok = false;
+        } else if (!wav_audio_open_ring(context, wf)) {
+            fprintf(stderr, "Out of audio buffer memory\n");
+            closeWave(wf);
+            ok = false;
+        }
+    }
+    xSemaphoreGive((SemaphoreHandle_t)wf->lock);
+
+    return(ok);
+}
+
+static void closeWavStream(APP_CONTEXT *context, WAV_FILE *wf)
+{
+    xSemaphoreTake((SemaphoreHandle_t)wf->lock, portMAX_DELAY);
+    if (wf->enabled) {
+        closeWave(wf);
+    }
+    wav_audio_close_ring(context, wf);
+    xSemaphoreGive((SemaphoreHandle_t)wf->lock);
+}
+
+/*
+ * The src task normally refills at the ring's low watermark.  Make
+ * sure a whole block is there before every tick so a slow host shows
+ * up as a slow render rather than an underflow.
+ */
+static void waitWavSrc(APP_CONTEXT *context)
+{
+    PaUtilRingBuffer *rb = context->wavSrcRB;
+    unsigned need;
+
+    if (!context->wavSrc.enabled || (rb == NULL)) {
+        return;
+    }
+    need = context->wavSrc.channels * SYSTEM_BLOCK_SIZE;
+    while (PaUtil_GetRingBufferReadAvailable(rb) < need) {
+        xTaskNotifyGive(context->wavSrcTaskHandle);
+        usleep(50);
+    }
+}
+
+/* Keeps room for the next block in the sink ring, or empties it */
+static void drainWavSink(APP_CONTEXT *context, bool all)
+{
+    PaUtilRingBuffer *rb = context->wavSinkRB;
+    unsigned block;
+
+    if (!context->wavSink.enabled || (rb == NULL)) {
+        return;
+    }
+    block = context->wavSink.channels * SYSTEM_BLOCK_SIZE;
+    if (!all && (PaUtil_GetRingBufferWriteAvailable(rb) >= (2 * block))) {
+        return;
+    }
+    while (PaUtil_GetRingBufferReadAvailable(rb) >= block) {
+        xTaskNotifyGive(context->wavSinkTaskHandle);
+        usleep(50);
+    }
+}
+
+/***********************************************************************
+ * SHARC
+ **********************************************************************/
+static void ipcMsgHandler(SAE_CONTEXT *saeContext, SAE_MSG_BUFFER *buffer,
+    void *payload, void *usrPtr)
+{
+    APP_CONTEXT *context = (APP_CONTEXT *)usrPtr;
+    IPC_MSG *msg = (IPC_MSG *)payload;
+
+    switch (msg->type) {
+        case IPC_TYPE_SHARC0_READY:
+            context->sharc0Ready = true;
+            break;
+        case IPC_TYPE_SHARC1_READY:
+            context->sharc1Ready = true;
+            break;
+        case IPC_TYPE_TRACE_LOG:
+            /* Keep the reference, the SHARC writes the log in place */
+            if (trace_log_attach(&msg->traceLog)) {
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+
+    sae_unRefMsgBuffer(saeContext, buffer);
+}
+
+/* Same layout as sae_buffer_init() on the board */
+static SAE_MSG_BUFFER *allocateIpcAudioMsg(APP_CONTEXT *context,
+    uint16_t size, uint8_t streamID, uint8_t numChannels, uint8_t wordSize,
+    void **audioPtr)
+{
+    SAE_MSG_BUFFER *msgBuffer;
+    IPC_MSG *msg;
+
+    msgBuffer = sae_createMsgBuffer(context->saeContext,
+        sizeof(*msg) + size, (void **)&msg);
+    if (msgBuffer == NULL) {
+        return(NULL);
+    }
+
+    msg->type = IPC_TYPE_AUDIO;
+    msg->audio.streamID = streamID;
+    msg->audio.numChannels = numChannels;
+    msg->audio.wordSize = wordSize;
+    msg->audio.numFrames = size / (numChannels * wordSize);
+    *audioPtr = msg->audio.data;
+
+    return(msgBuffer);
+}
+
+static void saeBufferInit(APP_CONTEXT *context)
+{
+    int i;
+
+    context->sharc0AudioInLen =
+        SHARC0_AUDIO_IN_CHANNELS * sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+    context->sharc0AudioOutLen =
+        SHARC0_AUDIO_OUT_CHANNELS * sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+    context->sharc1AudioInLen =
+        SHARC1_AUDIO_IN_CHANNELS * sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+    context->sharc1AudioOutLen =
+        SHARC1_AUDIO_OUT_CHANNELS * sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+    context->sharcLinkAudioLen =
+        SHARC_LINK_CHANNELS * sizeof(SYSTEM_AUDIO_TYPE) * SYSTEM_BLOCK_SIZE;
+
+    for (i = 0; i < 2; i++) {
+        context->sharc0MsgIn[i] = allocateIpcAudioMsg(context,
+            context->sharc0AudioInLen, IPC_STREAMID_SHARC0_IN,
+            SHARC0_AUDIO_IN_CHANNELS, sizeof(SYSTEM_AUDIO_TYPE),
+            &context->sharc0AudioIn[i]);
+        context->sharc0MsgOut[i] = allocateIpcAudioMsg(context,
+            context->sharc0AudioOutLen, IPC_STREAMID_SHARC0_OUT,
+            SHARC0_AUDIO_OUT_CHANNELS, sizeof(SYSTEM_AUDIO_TYPE),
+            &context->sharc0AudioOut[i]);
+        context->sharc1MsgIn[i] = allocateIpcAudioMsg(context,
+            context->sharc1AudioInLen, IPC_STREAMID_SHARC1_IN,
+            SHARC1_AUDIO_IN_CHANNELS, sizeof(SYSTEM_AUDIO_TYPE),
+            &context->sharc1AudioIn[i]);
+        context->sharc1MsgOut[i] = allocateIpcAudioMsg(context,
+            context->sharc1AudioOutLen, IPC_STREAMID_SHARC1_OUT,
+            SHARC1_AUDIO_OUT_CHANNELS, sizeof(SYSTEM_AUDIO_TYPE),
+            &context->sharc1AudioOut[i]);
+        context->sharcLinkMsg[i] = allocateIpcAudioMsg(context,
+            context->sharcLinkAudioLen, IPC_STREAMID_SHARC_LINK,
+            SHARC_LINK_CHANNELS, sizeof(SYSTEM_AUDIO_TYPE),
+            &context->sharcLinkAudio[i]);
+    }
+}
+
+static void *sharc0Core(void *arg)
+{
+    sharc0_main(0, NULL);
+    return(NULL);
+}
+
+static void *sharc1Core(void *arg)
+{
+    sharc1_main(0, NULL);
+    return(NULL);
+}
+
+static void startSharcs(APP_CONTEXT *context)
+{
+    pthread_t t;
+
+    pthread_create(&t, NULL, sharc0Core, NULL);
+    pthread_detach(t);
+    pthread_create(&t, NULL, sharc1Core, NULL);
+    pthread_detach(t);
+
+    while (!context->sharc0Ready || !context->sharc1Ready) {
+        usleep(100);
+    }
+}
+
+/***********************************************************************
+ * Render
+ **********************************************************************/
+static void renderTick(APP_CONTEXT *context, bool a2b)
+{
+    unsigned i;
+
+    for (i = 0; i < RENDER_PORT_MAX; i++) {
+        readPort(&inPorts[i]);
+    }
+    waitWavSrc(context);
+
+    /* DMA completion order within one SYSTEM clock domain period */
+    codecAudioIn(codecIn, sizeof(codecIn), context);
+    spdifAudioIn(spdifIn, sizeof(spdifIn), context);
+    if (a2b) {
+        a2bAudioIn(a2bIn, sizeof(a2bIn), context);
+    }
+    codecAudioOut(codecOut, sizeof(codecOut), context);
+    spdifAudioOut(spdifOut, sizeof(spdifOut), context);
+    if (a2b) {
+        a2bAudioOut(a2bOut, sizeof(a2bOut), context);
+    }
+
+    for (i = 0; i < RENDER_PORT_MAX; i++) {
+        writePort(&outPorts[i]);
+    }
+    drainWavSink(context, false);
+}
+
+static void dumpTraceLogs(void)
+{
+    TRACE_LOG_ENTRY entry;
+    TRACE_LOG *log;
+    char buf[128];
+    unsigned core;
+
+    for (core = 0; core < TRACE_LOG_MAX_CORES; core++) {
+        log = trace_log_get(core);
+        if (log == NULL) {
+            continue;
+        }
+        while (trace_log_read(log, &entry)) {
+            trace_log_format(&entry, buf, sizeof(buf));
+            fprintf(stderr, "core %u: %s\n", core, buf);
+        }
+    }
+}
+
+static int portIndex(const char *name)
+{
+    int i;
+
+    for (i = 0; i < RENDER_PORT_MAX; i++) {
+        if (strcmp(name, portNames[i]) == 0) {
+            return(i);
+        }
+    }
+    return(-1);
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "Usage: render [-s seconds] [-a a2bChannels] [-u usbChannels]\n"
+        "              [-w wavSinkChannels] [-b 16|24|32] [-r routes.txt]\n"
+        "              [-i stream=in.wav]... [-o stream=out.wav]... [-z] [-c]\n"
+        "              [-j plan] [-x node=ir.wav]\n"
+        "  stream - codec, spdif, a2b, usb or wav\n"
+        "  -z     - route SHARC output in the same block\n"
+        "  -c     - chain SHARC0 into SHARC1\n"
+        "  -j     - SHARC DSP job plan, bit set runs the job on SHARC1\n"
+        "  -x     - convolve DSP node 0 or 1 with the responses in ir.wav\n");
+}
+
+int main(int argc, char **argv)
+{
+    APP_CONTEXT *context = &mainAppContext;
+    char *inFiles[RENDER_PORT_MAX + 1] = { NULL };
+    char *outFiles[RENDER_PORT_MAX + 1] = { NULL };
+    char *routeFile = NULL;
+    char *convFiles[IPC_DSP_NODES] = { NULL };
+    FFT_QUEUE_LEASE fftLease;
+    double seconds = 0.0;
+    unsigned a2bChannels = 0;
+    unsigned usbChannels = USB_DEFAULT_IN_AUDIO_CHANNELS;
+    unsigned wavChannels = 2;
+    unsigned bits = 32;
+    uint64_t blocks, block, frames;
+    struct timespec start, end;
+    double elapsed;
+    RENDER_PORT *port;
+    char **files;
+    char *eq;
+    int idx;
+    int opt;
+    int i;
+    bool sharcSync = false;
+    bool sharcChain = false;
+    long plan = -1;
+    bool ok = true;
+
+    while ((opt = getopt(argc, argv, "s:a:u:w:b:r:i:o:zcj:x:h")) != -1) {
+        switch (opt) {
+            case 's':
+                seconds = atof(optarg);
+                break;
+            case 'a':
+                a2bChannels = atoi(optarg);
+                break;
+            case 'u':
+                usbChannels = atoi(optarg);
+                break;
+            case 'w':
+                wavChannels = atoi(optarg);
+                break;
+            case 'b':
+                bits = atoi(optarg);
+                break;
+            case 'r':
+                routeFile = optarg;
+                break;
+            case 'z':
+                sharcSync = true;
+                break;
+            case 'c':
+                sharcChain = true;
+                break;
+            case 'j':
+                plan = strtol(optarg, NULL, 0);
+                break;
+            case 'x':
+                eq = strchr(optarg, '=');
+                idx = eq ? atoi(optarg) : -1;
+                if ((idx < 0) || (idx >= IPC_DSP_NODES)) {
+                    ok = false;
+                    break;
+                }
+                convFiles[idx] = eq + 1;
+                break;
+            case 'i':
+            case 'o':
+                files = (opt == 'i') ? inFiles : outFiles;
+                eq = strchr(optarg, '=');
+                if (eq == NULL) {
+                    ok = false;
+                    break;
+                }
+                *eq = '\0';
+                idx = (strcmp(optarg, "wav") == 0) ?
+                    RENDER_PORT_MAX : portIndex(optarg);
+                if (idx < 0) {
+                    fprintf(stderr, "Unknown stream %s\n", optarg);
+                    ok = false;
+                    break;
+                }
+                files[idx] = eq + 1;
+                break;
+            default:
+                ok = false;
+                break;
+        }
+    }
+    if ((bits != 16) && (bits != 24) && (bits != 32)) {
+        ok = false;
+    }
+    if ((a2bChannels > A2B_DMA_CHANNELS) || (usbChannels == 0) ||
+        (usbChannels > SYSTEM_MAX_CHANNELS) || (wavChannels == 0) ||
+        (wavChannels > WAV_MAX_CHANNELS)) {
+        ok = false;
+    }
+    if (!ok) {
+        usage();
+        return(1);
+    }
+
+    /* Application context, the same order as main() on the board */
+    memset(context, 0, sizeof(*context));
+    context->cfg.usbOutChannels = usbChannels;
+    context->cfg.usbInChannels = usbChannels;
+    context->cfg.usbWordSize = USB_DEFAULT_WORD_SIZE;
+    context->routingTable = calloc(MAX_AUDIO_ROUTES, sizeof(ROUTE_INFO));
+    clock_domain_init(context);
+    if (a2bChannels) {
+        context->a2bInChannels = a2bChannels;
+        context->a2bOutChannels = a2bChannels;
+        clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_A2B_IN);
+        clock_domain_set(context, CLOCK_DOMAIN_SYSTEM, CLOCK_DOMAIN_BITM_A2B_OUT);
+    }
+    audio_pool_init();
+    wav_audio_init(context);
+
+    sae_initialize(&context->saeContext, IPC_CORE_ARM, true);
+    sae_registerMsgReceivedCallback(context->saeContext, ipcMsgHandler, context);
+    saeBufferInit(context);
+    startSharcs(context);
+
+    /* ARM trace log, after the SHARCs have set up theirs */
+    trace_log_init(malloc(TRACE_LOG_SIZE(TRACE_LOG_ARM_ENTRIES)),
+        TRACE_LOG_ARM_ENTRIES, IPC_CORE_ARM);
+
+    /* SHARC0 convolves under the FFT accelerator lease, as on the board */
+    if (!sharcFftLease(context, &fftLease)) {
+        return(1);
+    }
+
+    context->sharcSync = sharcSync;
+    context->sharcChain = sharcChain;
+    sharc_sched_init(&context->sharcSched,
+        (uint32_t)(((uint64_t)CCLK * SYSTEM_BLOCK_SIZE) / SYSTEM_SAMPLE_RATE));
+    if (plan >= 0) {
+        sharc_sched_enable(&context->sharcSched, true);
+        context->sharcSched.plan = (uint32_t)plan;
+    }
+    for (i = 0; i < IPC_DSP_NODES; i++) {
+        if (convFiles[i] && !sharcConvLoad(context, i, convFiles[i])) {
+            fprintf(stderr, "Can't load %s\n", convFiles[i]);
+            return(1);
+        }
+    }
+
+    if (routeFile && !loadRoutes(context, routeFile)) {
+        return(1);
+    }
+
+    /* Host stream endpoints */
+    for (i = 0; i < RENDER_PORT_MAX; i++) {
+        inPorts[i].name = outPorts[i].name = portNames[i];
+        inPorts[i].wordSize = outPorts[i].wordSize = sizeof(SYSTEM_AUDIO_TYPE);
+    }
+    inPorts[RENDER_PORT_CODEC].buf = codecIn;
+    outPorts[RENDER_PORT_CODEC].buf = codecOut;
+    inPorts[RENDER_PORT_CODEC].channels = CODEC_DMA_CHANNELS;
+    outPorts[RENDER_PORT_CODEC].channels = CODEC_DMA_CHANNELS;
+    inPorts[RENDER_PORT_SPDIF].buf = spdifIn;
+    outPorts[RENDER_PORT_SPDIF].buf = spdifOut;
+    inPorts[RENDER_PORT_SPDIF].channels = SPDIF_DMA_CHANNELS;
+    outPorts[RENDER_PORT_SPDIF].channels = SPDIF_DMA_CHANNELS;
+    inPorts[RENDER_PORT_A2B].buf = a2bIn;
+    outPorts[RENDER_PORT_A2B].buf = a2bOut;
+    inPorts[RENDER_PORT_A2B].channels = a2bChannels;
+    outPorts[RENDER_PORT_A2B].channels = a2bChannels;
+    inPorts[RENDER_PORT_USB].buf = hostUsbRxBuffer;
+    outPorts[RENDER_PORT_USB].buf = hostUsbTxBuffer;
+    inPorts[RENDER_PORT_USB].channels = context->cfg.usbOutChannels;
+    outPorts[RENDER_PORT_USB].channels = context->cfg.usbInChannels;
+    inPorts[RENDER_PORT_USB].wordSize = context->cfg.usbWordSize;
+    outPorts[RENDER_PORT_USB].wordSize = context->cfg.usbWordSize;
+
+    /* Default length is the longest non-looping input */
+    frames = 0;
+    for (i = 0; ok && (i < RENDER_PORT_MAX); i++) {
+        port = &inPorts[i];
+        if (inFiles[i]) {
+            if ((i == RENDER_PORT_A2B) && (a2bChannels == 0)) {
+                fprintf(stderr, "A2B input needs -a\n");
+                ok = false;
+                break;
+            }
+            ok = openPort(port, inFiles[i], true, bits);
+            if (ok && (port->frames > frames)) {
+                frames = port->frames;
+            }
+        }
+        if (ok && outFiles[i]) {
+            if ((i == RENDER_PORT_A2B) && (a2bChannels == 0)) {
+                fprintf(stderr, "A2B output needs -a\n");
+                ok = false;
+                break;
+            }
+            ok = openPort(&outPorts[i], outFiles[i], false, bits);
+        }
+    }
+    if (ok && inFiles[RENDER_PORT_MAX]) {
+        ok = openWavStream(context, &context->wavSrc, inFiles[RENDER_PORT_MAX],
+            true, 0, bits);
+    }
+    if (ok && outFiles[RENDER_PORT_MAX]) {
+        ok = openWavStream(context, &context->wavSink, outFiles[RENDER_PORT_MAX],
+            false, wavChannels, bits);
+    }
+    if (seconds > 0.0) {
+        frames = (uint64_t)(seconds * SYSTEM_SAMPLE_RATE);
+    }
+    if (ok && (frames == 0)) {
+        fprintf(stderr, "Nothing to render, give -s or an input file\n");
+        ok = false;
+    }
+    if (!ok) {
+        return(1);
+    }
+
+    blocks = (frames + SYSTEM_BLOCK_SIZE - 1) / SYSTEM_BLOCK_SIZE;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (block = 0; block < blocks; block++) {
+        renderTick(context, a2bChannels > 0);
+        hostTsCount = (uint32_t)(((block + 1) * SYSTEM_BLOCK_SIZE *
+            (uint64_t)CGU_TS_CLK) / SYSTEM_SAMPLE_RATE);
+    }
+    drainWavSink(context, true);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    closeWavStream(context, &context->wavSink);
+    closeWavStream(context, &context->wavSrc);
+    for (i = 0; i < RENDER_PORT_MAX; i++) {
+        if (inPorts[i].open) {
+            closeWave(&inPorts[i].wf);
+        }
+        if (outPorts[i].open) {
+            closeWave(&outPorts[i].wf);
+        }
+    }
+
+    dumpTraceLogs();
+
+    elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    frames = blocks * SYSTEM_BLOCK_SIZE;
+    fprintf(stderr, "Rendered %.3fs in %.3fs (%.1fx real time)\n",
+        (double)frames / SYSTEM_SAMPLE_RATE, elapsed,
+        elapsed > 0.0 ? ((double)frames / SYSTEM_SAMPLE_RATE) / elapsed : 0.0);
+
+    return(0);
+}
@@ -0,0 +1,27 @@
+/**
+ * Copyright (c) 2026 - Analog Devices Inc. All Rights Reserved.
+ * This software is proprietary and confidential to Analog Devices, Inc.
+ * and its licensors.
+ *
+ * This software is subject to the terms and conditions of the license set
+ * forth in the project LICENSE file. Downloading, reproducing, distributing or
+ * otherwise using the software constitutes acceptance of the license. The
+ * software may not be used except as expressly authorized under the license.
+ */
+
+#ifndef _render_h
+#define _render_h
+
+#include "context.h"
+
+/*
+ * USB audio seen by the graph.  The harness fills the Rx block before
+ * each tick and drains the Tx block after it.
+ */
+extern SYSTEM_AUDIO_TYPE hostUsbRxBuffer[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
+extern SYSTEM_AUDIO_TYPE hostUsbTxBuffer[SYSTEM_MAX_CHANNELS * SYSTEM_BLOCK_SIZE];
+
+/* Simulated CGU timestamp counter */
+extern volatile uint32_t hostTsCount;
+
+#endif
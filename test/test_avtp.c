@@ -0,0 +1,287 @@
+// AAF talker/listener host test.  The wire is a pcap capture: the
+// talker's link writes each frame as a pcap record and the listener is
+// fed by replaying the capture, so a failing run can be inspected with
+// any pcap viewer.
+//
+// Build and run from the repository root:
+//   gcc -I test/et -I ARM/include -I ARM/src/simple-services/avtp-stream
+//       test/test_avtp.c ARM/src/simple-services/avtp-stream/avtp_stream.c
+//       test/et/et.c test/et/et_host.c -o test_avtp && ./test_avtp
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "avtp_stream.h" // Code Under Test (CUT)
+#include "et.h"  // ET: embedded test
+
+#define PCAP_FILE      "test_avtp.pcap"
+#define PCAP_MAGIC     0xA1B2C3D4u
+#define PCAP_LINKTYPE_ETHERNET 1
+
+#define CHANNELS       2
+#define FRAMES_PER_PKT 6
+#define RATE           48000
+#define PACKETS        20
+#define START_TIME     0xFFFFF000u  // gPTP ns wrap inside the run
+
+typedef struct {
+    FILE *fp;
+    uint8_t frame[AVTP_MAX_FRAME_SIZE];
+    uint32_t now;
+    uint32_t firstSent;
+    unsigned sent;
+} PCAP_LINK;
+
+static PCAP_LINK wire;
+static AVTP_STREAM talker;
+static AVTP_STREAM listener;
+
+static int16_t rxAudio[PACKETS * FRAMES_PER_PKT * CHANNELS];
+static unsigned rxSamples;
+static uint32_t rxTime[PACKETS];
+static unsigned rxPkts;
+
+static void put32le(FILE *fp, uint32_t v) {
+    uint8_t b[4] = { v, v >> 8, v >> 16, v >> 24 };
+    fwrite(b, 1, sizeof(b), fp);
+}
+
+static uint32_t get32le(const uint8_t *b) {
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+static uint8_t *pcapTxGet(void *linkPtr, void **handle) {
+    PCAP_LINK *link = (PCAP_LINK *)linkPtr;
+    *handle = link;
+    return link->frame;
+}
+
+static int pcapTxSend(void *linkPtr, void *handle, unsigned len) {
+    PCAP_LINK *link = (PCAP_LINK *)linkPtr;
+    put32le(link->fp, link->now / 1000000000u);
+    put32le(link->fp, (link->now % 1000000000u) / 1000u);
+    put32le(link->fp, len);
+    put32le(link->fp, len);
+    fwrite(link->frame, 1, len, link->fp);
+    if (link->sent++ == 0) {
+        link->firstSent = link->now;
+    }
+    return 0;
+}
+
+static uint32_t pcapNow(void *linkPtr) {
+    return ((PCAP_LINK *)linkPtr)->now;
+}
+
+static void rxCallback(AVTP_STREAM *as, void *data, unsigned samples,
+    uint32_t presentationTime, void *usrPtr)
+{
+    uint8_t *p = (uint8_t *)data;
+    unsigned i;
+
+    for (i = 0; i < samples; i++, p += 2) {
+        rxAudio[rxSamples++] = (int16_t)((p[0] << 8) | p[1]);
+    }
+    rxTime[rxPkts++] = presentationTime;
+}
+
+// Replays the capture into the listener, returns the number of records
+static unsigned pcapReplay(const char *name) {
+    uint8_t hdr[24];
+    uint8_t frame[AVTP_MAX_FRAME_SIZE];
+    unsigned records = 0;
+    uint32_t len;
+    FILE *fp;
+
+    fp = fopen(name, "rb");
+    if (fp == NULL) {
+        return 0;
+    }
+    if ((fread(hdr, 1, 24, fp) != 24) || (get32le(hdr) != PCAP_MAGIC)) {
+        fclose(fp);
+        return 0;
+    }
+    while (fread(hdr, 1, 16, fp) == 16) {
+        len = get32le(hdr + 8);
+        if ((len > sizeof(frame)) || (fread(frame, 1, len, fp) != len)) {
+            break;
+        }
+        avtpRecvFrame(&listener, frame, len);
+        records++;
+    }
+    fclose(fp);
+
+    return records;
+}
+
+static void talkerRun(unsigned packets) {
+    unsigned frame, ch, n;
+    uint8_t *data;
+
+    for (n = 0; n < packets * FRAMES_PER_PKT; n++) {
+        avtpWriteSamplesAvailable(&talker, (void **)&data);
+        for (ch = 0; ch < CHANNELS; ch++) {
+            frame = n * CHANNELS + ch;
+            data[2 * ch + 0] = (uint8_t)(frame >> 8);
+            data[2 * ch + 1] = (uint8_t)frame;
+        }
+        avtpWriteSamples(&talker, CHANNELS);
+        wire.now += 1000000000u / RATE;
+    }
+}
+
+static void openPair(uint16_t vlanID) {
+    static const uint8_t dst[6] = { 0x91, 0xE0, 0xF0, 0x00, 0xFE, 0x00 };
+    static const uint8_t src[6] = { 0x00, 0x05, 0xCD, 0x01, 0x02, 0x03 };
+
+    memset(&wire, 0, sizeof(wire));
+    wire.now = START_TIME;
+    wire.fp = fopen(PCAP_FILE, "wb");
+    put32le(wire.fp, PCAP_MAGIC);
+    put32le(wire.fp, 0x00040002u);  // version 2.4
+    put32le(wire.fp, 0);
+    put32le(wire.fp, 0);
+    put32le(wire.fp, 65535);
+    put32le(wire.fp, PCAP_LINKTYPE_ETHERNET);
+
+    memset(&talker, 0, sizeof(talker));
+    talker.channels = CHANNELS;
+    talker.wordSizeBytes = 2;
+    talker.sampleRate = RATE;
+    talker.framesPerPkt = FRAMES_PER_PKT;
+    talker.streamID = 0x0005CD0102030000ull;
+    talker.vlanID = vlanID;
+    talker.vlanPcp = 3;
+    memcpy(talker.dstMac, dst, 6);
+    memcpy(talker.srcMac, src, 6);
+    talker.link.txGet = pcapTxGet;
+    talker.link.txSend = pcapTxSend;
+    talker.link.now = pcapNow;
+    talker.link.linkPtr = &wire;
+
+    memset(&listener, 0, sizeof(listener));
+    listener.isRx = true;
+    listener.channels = CHANNELS;
+    listener.wordSizeBytes = 2;
+    listener.sampleRate = RATE;
+    listener.streamID = talker.streamID;
+    listener.rxCallback = rxCallback;
+    listener.link = talker.link;
+
+    rxSamples = 0;
+    rxPkts = 0;
+}
+
+void setup(void) {
+}
+
+void teardown(void) {
+    remove(PCAP_FILE);
+}
+
+// test group ----------------------------------------------------------------
+TEST_GROUP("AVTP") {
+
+TEST("open rejects unsupported formats") {
+    openPair(0);
+    talker.wordSizeBytes = 3;
+    VERIFY(!avtpOpenStream(&talker));
+    talker.wordSizeBytes = 2;
+    talker.sampleRate = 12345;
+    VERIFY(!avtpOpenStream(&talker));
+    talker.sampleRate = RATE;
+    VERIFY(avtpOpenStream(&talker));
+    VERIFY(talker.maxSamples == FRAMES_PER_PKT * CHANNELS);
+    fclose(wire.fp);
+}
+
+TEST("tagged talker to listener through pcap") {
+    unsigned i;
+    uint32_t step;
+
+    openPair(2);
+    VERIFY(avtpOpenStream(&talker));
+    VERIFY(avtpOpenStream(&listener));
+    talkerRun(PACKETS);
+    fclose(wire.fp);
+    VERIFY(wire.sent == PACKETS);
+
+    VERIFY(pcapReplay(PCAP_FILE) == PACKETS);
+    VERIFY(listener.rxPkts == PACKETS);
+    VERIFY(listener.rxSeqErrors == 0);
+    VERIFY(listener.rxFmtErrors == 0);
+    VERIFY(rxSamples == PACKETS * FRAMES_PER_PKT * CHANNELS);
+    for (i = 0; i < rxSamples; i++) {
+        VERIFY(rxAudio[i] == (int16_t)i);
+    }
+
+    // First packet presents one transit time after it was sent
+    VERIFY(rxTime[0] == wire.firstSent + talker.transitTime);
+    step = (uint32_t)((uint64_t)FRAMES_PER_PKT * 1000000000u / RATE);
+    for (i = 1; i < rxPkts; i++) {
+        VERIFY((uint32_t)(rxTime[i] - rxTime[i - 1]) == step);
+    }
+}
+
+TEST("listener filters stream ID and counts lost packets") {
+    uint8_t hdr[24];
+    uint8_t frame[AVTP_MAX_FRAME_SIZE];
+    unsigned n = 0;
+    uint32_t len;
+    FILE *fp;
+
+    openPair(0);
+    VERIFY(avtpOpenStream(&talker));
+    talkerRun(4);
+    fclose(wire.fp);
+
+    // Wrong stream ID ignores everything
+    listener.streamID = 0x1234;
+    VERIFY(avtpOpenStream(&listener));
+    VERIFY(pcapReplay(PCAP_FILE) == 4);
+    VERIFY(listener.rxPkts == 0);
+    avtpCloseStream(&listener);
+
+    // Drop the second record, the listener sees one sequence error
+    listener.streamID = 0;
+    VERIFY(avtpOpenStream(&listener));
+    fp = fopen(PCAP_FILE, "rb");
+    VERIFY(fread(hdr, 1, 24, fp) == 24);
+    while (fread(hdr, 1, 16, fp) == 16) {
+        len = get32le(hdr + 8);
+        VERIFY(fread(frame, 1, len, fp) == len);
+        if (n++ != 1) {
+            avtpRecvFrame(&listener, frame, len);
+        }
+    }
+    fclose(fp);
+    VERIFY(listener.rxPkts == 3);
+    VERIFY(listener.rxSeqErrors == 1);
+}
+
+TEST("listener rejects a format mismatch") {
+    openPair(0);
+    VERIFY(avtpOpenStream(&talker));
+    talkerRun(2);
+    fclose(wire.fp);
+
+    listener.channels = CHANNELS + 1;
+    VERIFY(avtpOpenStream(&listener));
+    VERIFY(pcapReplay(PCAP_FILE) == 2);
+    VERIFY(listener.rxFmtErrors == 2);
+    VERIFY(rxPkts == 0);
+}
+
+TEST("close sends the partial packet") {
+    openPair(0);
+    VERIFY(avtpOpenStream(&talker));
+    avtpWriteSamplesAvailable(&talker, NULL);
+    avtpWriteSamples(&talker, CHANNELS);
+    avtpCloseStream(&talker);
+    fclose(wire.fp);
+    VERIFY(wire.sent == 1);
+    VERIFY(!talker.enabled);
+}
+
+} // TEST_GROUP()
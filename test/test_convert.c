@@ -0,0 +1,239 @@
+// copyAndConvert() and swapAndConvert() bit-exact regression tests.
+// Hand-checked golden vectors pin the format, then every word size and
+// channel count combination is compared against a scalar reference over
+// pseudo-random data and benchmarked.  Build for the ARM (NEON) as well
+// as the host to check the vector paths.
+//
+// Build and run from the repository root:
+//   gcc -O2 -I test -I test/et -I ARM/src
+//       test/test_convert.c ARM/src/util.c
+//       test/et/et.c test/et/et_host.c -o test_convert && ./test_convert
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "util.h"  // Code Under Test (CUT)
+#include "et.h"  // ET: embedded test
+#include "bench.h"
+
+#define FRAMES      64
+#define MAX_CH      16
+#define SAMPLES     (FRAMES * MAX_CH)
+
+static uint8_t srcBuf[SAMPLES * 4 + 4];
+static uint8_t dstBuf[SAMPLES * 4 + 4];
+static uint8_t refBuf[SAMPLES * 4 + 4];
+static uint32_t seed;
+
+static uint32_t rnd(void) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed;
+}
+
+static void fill(void *buf, size_t len) {
+    uint8_t *b = buf;
+    size_t i;
+    for (i = 0; i < len; i++) {
+        b[i] = (uint8_t)(rnd() >> 24);
+    }
+}
+
+static uint32_t getWord(const uint8_t *p, unsigned ws) {
+    uint32_t u32;
+    uint16_t u16;
+    if (ws == 2) {
+        memcpy(&u16, p, 2);
+        return u16;
+    }
+    memcpy(&u32, p, 4);
+    return u32;
+}
+
+static void putWord(uint8_t *p, unsigned ws, uint32_t v) {
+    uint16_t u16 = (uint16_t)v;
+    if (ws == 2) {
+        memcpy(p, &u16, 2);
+    } else {
+        memcpy(p, &v, 4);
+    }
+}
+
+// Left justified widening, truncating narrowing
+static uint32_t convertWord(uint32_t v, unsigned sws, unsigned dws) {
+    if (sws == dws) {
+        return v;
+    }
+    return (sws == 2) ? (v << 16) : (v >> 16);
+}
+
+static void refCopyAndConvert(
+    void *src, unsigned sws, unsigned sch,
+    void *dst, unsigned dws, unsigned dch,
+    unsigned frames, bool zero)
+{
+    unsigned ch = sch < dch ? sch : dch;
+    unsigned f, c;
+    uint8_t *s = src, *d = dst;
+    if (zero) {
+        memset(dst, 0, dws * dch * frames);
+    }
+    for (f = 0; f < frames; f++) {
+        for (c = 0; c < ch; c++) {
+            putWord(d + (f * dch + c) * dws, dws,
+                convertWord(getWord(s + (f * sch + c) * sws, sws), sws, dws));
+        }
+    }
+}
+
+static uint32_t swapWord(uint32_t v, unsigned ws) {
+    if (ws == 2) {
+        return (uint16_t)((v >> 8) | (v << 8));
+    }
+    return __builtin_bswap32(v);
+}
+
+// Widening swaps before converting, narrowing (host to network) after
+static void refSwapAndConvert(
+    void *src, unsigned sws, void *dst, unsigned dws, unsigned samples)
+{
+    uint8_t *s = src, *d = dst;
+    uint32_t v;
+    unsigned i;
+    for (i = 0; i < samples; i++) {
+        v = getWord(s + i * sws, sws);
+        if (sws > dws) {
+            v = swapWord(convertWord(v, sws, dws), dws);
+        } else {
+            v = convertWord(swapWord(v, sws), sws, dws);
+        }
+        putWord(d + i * dws, dws, v);
+    }
+}
+
+void setup(void) {
+    seed = 0x12345678;
+    memset(dstBuf, 0xA5, sizeof(dstBuf));
+    memset(refBuf, 0xA5, sizeof(refBuf));
+}
+
+void teardown(void) {
+}
+
+// test group ----------------------------------------------------------------
+TEST_GROUP("convert") {
+
+TEST("copyAndConvert golden vectors") {
+    int16_t s16[4] = { 0x1234, -2, 0x7FFF, -32768 };
+    int32_t s32[4] = { 0x12345678, -1, 0x7FFFFFFF, (int32_t)0x80000000 };
+    int32_t d32[4];
+    int16_t d16[4];
+
+    copyAndConvert(s16, 2, 2, d32, 4, 2, 2, false);
+    VERIFY(d32[0] == 0x12340000);
+    VERIFY(d32[1] == (int32_t)0xFFFE0000);
+    VERIFY(d32[2] == 0x7FFF0000);
+    VERIFY(d32[3] == (int32_t)0x80000000);
+
+    copyAndConvert(s32, 4, 2, d16, 2, 2, 2, false);
+    VERIFY(d16[0] == 0x1234);
+    VERIFY(d16[1] == -1);
+    VERIFY(d16[2] == 0x7FFF);
+    VERIFY(d16[3] == -32768);
+
+    // Narrower sink keeps its own stride, wider sink zero filled
+    memset(d32, 0x5A, sizeof(d32));
+    copyAndConvert(s32, 4, 1, d32, 4, 2, 2, true);
+    VERIFY(d32[0] == 0x12345678 && d32[1] == 0);
+    VERIFY(d32[2] == -1 && d32[3] == 0);
+}
+
+TEST("swapAndConvert golden vectors") {
+    uint8_t be16[4] = { 0x12, 0x34, 0xFF, 0xFE };
+    uint8_t be32[8] = { 0x12, 0x34, 0x56, 0x78, 0x80, 0x00, 0x00, 0x01 };
+    int32_t d32[2];
+    int16_t d16[2];
+
+    swapAndConvert(be16, 2, d32, 4, 2);
+    VERIFY(d32[0] == 0x12340000);
+    VERIFY(d32[1] == (int32_t)0xFFFE0000);
+    swapAndConvert(be16, 2, d16, 2, 2);
+    VERIFY(d16[0] == 0x1234 && d16[1] == -2);
+    swapAndConvert(be32, 4, d32, 4, 2);
+    VERIFY(d32[0] == 0x12345678 && d32[1] == (int32_t)0x80000001);
+
+    // Narrowing runs host to network, e.g. RTP transmit
+    d32[0] = 0x12345678; d32[1] = (int32_t)0x80000001;
+    swapAndConvert(d32, 4, be16, 2, 2);
+    VERIFY(be16[0] == 0x12 && be16[1] == 0x34);
+    VERIFY(be16[2] == 0x80 && be16[3] == 0x00);
+}
+
+TEST("copyAndConvert matches the reference for all layouts") {
+    static const unsigned ws[2] = { 2, 4 };
+    static const unsigned chans[] = { 1, 2, 3, 8, 16 };
+    unsigned a, b, c, d, z;
+    int ok = 1;
+
+    for (a = 0; a < 2; a++) for (b = 0; b < 2; b++)
+    for (c = 0; c < ARRAY_NELEM(chans); c++)
+    for (d = 0; d < ARRAY_NELEM(chans); d++)
+    for (z = 0; z < 2; z++) {
+        fill(srcBuf, sizeof(srcBuf));
+        fill(dstBuf, sizeof(dstBuf));
+        memcpy(refBuf, dstBuf, sizeof(refBuf));
+        copyAndConvert(srcBuf, ws[a], chans[c], dstBuf, ws[b], chans[d],
+            FRAMES, z);
+        refCopyAndConvert(srcBuf, ws[a], chans[c], refBuf, ws[b], chans[d],
+            FRAMES, z);
+        if (memcmp(dstBuf, refBuf, sizeof(dstBuf)) != 0) {
+            printf("  mismatch src %u/%u dst %u/%u zero %u\n",
+                ws[a], chans[c], ws[b], chans[d], z);
+            ok = 0;
+        }
+    }
+    VERIFY(ok);
+}
+
+TEST("swapAndConvert matches the reference at any alignment") {
+    static const unsigned ws[2] = { 2, 4 };
+    unsigned a, b, off, n;
+    int ok = 1;
+
+    for (a = 0; a < 2; a++) for (b = 0; b < 2; b++)
+    for (off = 0; off < 4; off++)
+    for (n = 0; n < 40; n += 7) {
+        fill(srcBuf, sizeof(srcBuf));
+        memset(dstBuf, 0xA5, sizeof(dstBuf));
+        memset(refBuf, 0xA5, sizeof(refBuf));
+        swapAndConvert(srcBuf + off, ws[a], dstBuf + off, ws[b], n);
+        refSwapAndConvert(srcBuf + off, ws[a], refBuf + off, ws[b], n);
+        if (memcmp(dstBuf, refBuf, sizeof(dstBuf)) != 0) {
+            printf("  mismatch %u->%u offset %u samples %u\n",
+                ws[a], ws[b], off, n);
+            ok = 0;
+        }
+    }
+    VERIFY(ok);
+}
+
+TEST("benchmarks") {
+    uint64_t ref, cut;
+
+    fill(srcBuf, sizeof(srcBuf));
+    BENCH(ref, refCopyAndConvert(srcBuf, 2, 2, dstBuf, 4, 8, FRAMES, true));
+    BENCH(cut, copyAndConvert(srcBuf, 2, 2, dstBuf, 4, 8, FRAMES, true));
+    bench_report("copyAndConvert 16/2->32/8", ref, cut, FRAMES, "frame");
+    BENCH(ref, refCopyAndConvert(srcBuf, 4, 16, dstBuf, 4, 16, FRAMES, false));
+    BENCH(cut, copyAndConvert(srcBuf, 4, 16, dstBuf, 4, 16, FRAMES, false));
+    bench_report("copyAndConvert 32/16->32/16", ref, cut, FRAMES, "frame");
+    BENCH(ref, refSwapAndConvert(srcBuf, 2, dstBuf, 4, SAMPLES));
+    BENCH(cut, swapAndConvert(srcBuf, 2, dstBuf, 4, SAMPLES));
+    bench_report("swapAndConvert 16->32", ref, cut, SAMPLES, "smp");
+    BENCH(ref, refSwapAndConvert(srcBuf, 4, dstBuf, 2, SAMPLES));
+    BENCH(cut, swapAndConvert(srcBuf, 4, dstBuf, 2, SAMPLES));
+    bench_report("swapAndConvert 32->16", ref, cut, SAMPLES, "smp");
+    VERIFY(1);
+}
+
+} // TEST_GROUP()
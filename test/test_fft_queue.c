@@ -0,0 +1,493 @@
+// FFT accelerator job queue tests.  A scripted backend stands in for
+// the accelerator, recording every batch it is asked to start and
+// finishing jobs only when a test says so, so the start order, the
+// batching, cancels and callbacks can all be checked against a known
+// timeline.  The tests play the owner task by calling
+// fft_queue_service() themselves, and a waiter's sleep runs the owner
+// until something wakes it.  The stats are checked on a hand-stepped
+// timestamp.  The queue's own cost per job is reported against a
+// direct call.
+//
+// Build and run from the repository root:
+//   gcc -O2 -I test -I test/et -I test/host -I ARM/include -I ALL/include
+//       -I ARM/src/oss-services/FreeRTOS-ARM/include
+//       -I ARM/src/simple-services/sched-trace
+//       -I ARM/src/simple-services/fft-queue
+//       test/test_fft_queue.c ARM/src/simple-services/fft-queue/fft_queue.c
+//       test/et/et.c test/et/et_host.c -o test_fft_queue && ./test_fft_queue
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "fft_queue.h"  // Code Under Test (CUT)
+#include "et.h"  // ET: embedded test
+#include "bench.h"
+
+#define MAX_STARTS  64
+#define NPTS        256
+
+volatile uint32_t hostTsCount;
+
+static int lockDepth;
+static int lockErrors;
+static unsigned yields;
+static unsigned sleeps;
+static unsigned wakes;
+static unsigned ownerPasses;
+static UBaseType_t taskPriority;    // Of whoever calls in
+static UBaseType_t ownerPriority;   // Last set on the owner
+static unsigned prioritySets;
+
+// Single threaded, only checks the locking is balanced and not nested
+void vPortEnterCritical(void) {
+    if (lockDepth++ != 0) {
+        lockErrors++;
+    }
+}
+
+void vPortExitCritical(void) {
+    if (--lockDepth != 0) {
+        lockErrors++;
+    }
+}
+
+void vPortYield(void) {
+    yields++;
+}
+
+static FFT_QUEUE queue;
+
+// One task, the handle is only compared
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return (TaskHandle_t)&wakes;
+}
+
+BaseType_t xTaskGenericNotify(TaskHandle_t xTaskToNotify,
+    UBaseType_t uxIndexToNotify, uint32_t ulValue, eNotifyAction eAction,
+    uint32_t *pulPreviousNotificationValue) {
+    VERIFY(xTaskToNotify == xTaskGetCurrentTaskHandle());
+    VERIFY(uxIndexToNotify == FFT_QUEUE_NOTIFY_INDEX);
+    wakes++;
+    return pdPASS;
+}
+
+UBaseType_t uxTaskPriorityGet(const TaskHandle_t xTask) {
+    VERIFY(xTask == NULL);
+    return taskPriority;
+}
+
+void vTaskPrioritySet(TaskHandle_t xTask, UBaseType_t uxNewPriority) {
+    VERIFY(xTask == xTaskGetCurrentTaskHandle());
+    ownerPriority = uxNewPriority;
+    prioritySets++;
+}
+
+// Only fft_queue_run() backs off, the tests never run it
+void vTaskDelay(const TickType_t xTicksToDelay) {
+}
+
+// The owner gets to run while the caller sleeps, until a wake up
+uint32_t ulTaskGenericNotifyTake(UBaseType_t uxIndexToWaitOn,
+    BaseType_t xClearCountOnExit, TickType_t xTicksToWait) {
+    uint32_t n;
+
+    VERIFY(uxIndexToWaitOn == FFT_QUEUE_NOTIFY_INDEX);
+    sleeps++;
+    while (wakes == 0) {
+        VERIFY(++ownerPasses < 1000);
+        fft_queue_service(&queue);
+    }
+    n = wakes;
+    wakes = 0;
+    return n;
+}
+
+// Scripted backend ------------------------------------------------------------
+typedef struct SCRIPT {
+    FFT_QUEUE *q;
+    FFT_JOB *started[MAX_STARTS];   // Every job in start order
+    unsigned batchLen[MAX_STARTS];
+    unsigned nStarted;
+    unsigned nBatches;
+    unsigned running;               // Jobs started but not finished
+    unsigned depth;                 // start() nesting
+    unsigned maxDepth;
+    bool sync;                      // Finish each job inside start()
+    unsigned pollsToFinish;         // Polls before poll() finishes one
+    unsigned polls;
+    bool fail;
+    bool copy;                      // Stand-in transform, in to out
+} SCRIPT;
+
+static SCRIPT script;
+
+static void scriptStart(void *usr, FFT_JOB *const *jobs, unsigned n) {
+    SCRIPT *s = usr;
+    unsigned i;
+
+    if (++s->depth > s->maxDepth) {
+        s->maxDepth = s->depth;
+    }
+    if (s->nBatches == MAX_STARTS) {
+        s->nBatches = s->nStarted = 0;
+    }
+    s->batchLen[s->nBatches++] = n;
+    for (i = 0; i < n; i++) {
+        s->started[s->nStarted++] = jobs[i];
+        if (s->copy) {
+            memcpy(jobs[i]->out, jobs[i]->in, jobs[i]->npts * sizeof(float));
+        }
+    }
+    s->running += n;
+    if (s->sync) {
+        while (s->running) {
+            s->running--;
+            fft_queue_complete(s->q, !s->fail);
+        }
+    }
+    s->depth--;
+}
+
+static void scriptPoll(void *usr) {
+    SCRIPT *s = usr;
+
+    if (s->running && (++s->polls >= s->pollsToFinish)) {
+        s->polls = 0;
+        s->running--;
+        fft_queue_complete(s->q, !s->fail);
+    }
+}
+
+// Finishes the oldest running job
+static void finishOne(void) {
+    script.running--;
+    fft_queue_complete(&queue, !script.fail);
+}
+
+// The owner runs everything queued, finishing each job straight away
+static void drain(void) {
+    while (fft_queue_service(&queue)) {
+        finishOne();
+    }
+}
+
+static void queueInit(void) {
+    FFT_QUEUE_BACKEND be = { scriptStart, scriptPoll, &script };
+
+    memset(&script, 0, sizeof(script));
+    script.q = &queue;
+    script.pollsToFinish = UINT32_MAX;  // Only finishOne() unless told
+    fft_queue_init(&queue, &be);
+}
+
+static void jobInit(FFT_JOB *job, FFT_JOB_TYPE type, unsigned npts,
+    unsigned priority) {
+    memset(job, 0, sizeof(*job));
+    job->type = type;
+    job->npts = npts;
+    job->scale = 1.0f;
+    job->priority = priority;
+}
+
+// Callback that resubmits its job 'usr' more times
+static unsigned callbacks;
+
+static void resubmit(FFT_JOB *job, void *usr) {
+    unsigned *left = usr;
+
+    callbacks++;
+    if (*left) {
+        (*left)--;
+        VERIFY(fft_queue_submit(&queue, job));
+    }
+}
+
+void setup(void) {
+    lockDepth = lockErrors = 0;
+    yields = sleeps = wakes = ownerPasses = 0;
+    taskPriority = ownerPriority = 1;
+    prioritySets = 0;
+    callbacks = 0;
+    hostTsCount = 1000;
+    queueInit();
+}
+
+void teardown(void) {
+}
+
+// test group ----------------------------------------------------------------
+TEST_GROUP("fft_queue") {
+
+TEST("most urgent first, in order within a priority") {
+    FFT_JOB a, b, c, d, e;
+
+    // Different sizes so nothing is batched
+    jobInit(&a, FFT_JOB_RFFT, 64, FFT_QUEUE_PRIO_BACKGROUND);
+    jobInit(&b, FFT_JOB_RFFT, 128, FFT_QUEUE_PRIO_DISPLAY);
+    jobInit(&c, FFT_JOB_RFFT, 256, FFT_QUEUE_PRIO_LIVE);
+    jobInit(&d, FFT_JOB_RFFT, 512, FFT_QUEUE_PRIO_BACKGROUND);
+    jobInit(&e, FFT_JOB_RFFT, 1024, FFT_QUEUE_PRIO_LIVE);
+
+    // Only the owner starts jobs
+    VERIFY(fft_queue_submit(&queue, &a));
+    VERIFY(a.state == FFT_JOB_QUEUED && script.nStarted == 0 && wakes == 0);
+    VERIFY(fft_queue_service(&queue));
+    VERIFY(a.state == FFT_JOB_RUNNING);
+
+    // The rest wait behind 'a', a submit wakes the owner
+    queue.owner = xTaskGetCurrentTaskHandle();
+    VERIFY(fft_queue_submit(&queue, &b));
+    VERIFY(wakes == 1);
+    queue.owner = NULL;
+    VERIFY(fft_queue_submit(&queue, &c));
+    VERIFY(fft_queue_submit(&queue, &d));
+    VERIFY(fft_queue_submit(&queue, &e));
+    VERIFY(!fft_queue_submit(&queue, &d));
+    VERIFY(fft_queue_service(&queue));
+    VERIFY(script.nStarted == 1);
+    VERIFY(b.state == FFT_JOB_QUEUED);
+
+    finishOne();
+    drain();
+    VERIFY(!fft_queue_service(&queue));
+    VERIFY(script.nStarted == 5);
+    VERIFY(script.started[1] == &c);
+    VERIFY(script.started[2] == &e);
+    VERIFY(script.started[3] == &b);
+    VERIFY(script.started[4] == &d);
+    VERIFY(a.state == FFT_JOB_DONE && d.state == FFT_JOB_DONE && d.ok);
+    VERIFY(lockErrors == 0 && lockDepth == 0);
+}
+
+TEST("small jobs of one kind share a batch") {
+    static FFT_JOB small[FFT_QUEUE_BATCH + 2];
+    FFT_JOB first, other, large[2];
+    unsigned i;
+
+    jobInit(&first, FFT_JOB_CFFT, NPTS, FFT_QUEUE_PRIO_LIVE);
+    VERIFY(fft_queue_submit(&queue, &first));
+    fft_queue_service(&queue);
+
+    // Background jobs first, then a live one of the same kind
+    for (i = 0; i < FFT_QUEUE_BATCH + 2; i++) {
+        jobInit(&small[i], FFT_JOB_RFFT, NPTS,
+            (i == FFT_QUEUE_BATCH + 1) ? FFT_QUEUE_PRIO_LIVE :
+            FFT_QUEUE_PRIO_BACKGROUND);
+    }
+    jobInit(&other, FFT_JOB_IRFFT, NPTS, FFT_QUEUE_PRIO_BACKGROUND);
+    for (i = 0; i < FFT_QUEUE_BATCH + 1; i++) {
+        fft_queue_submit(&queue, &small[i]);
+    }
+    fft_queue_submit(&queue, &other);
+    fft_queue_submit(&queue, &small[FFT_QUEUE_BATCH + 1]);
+
+    // The live job leads a full batch of the background ones
+    finishOne();
+    fft_queue_service(&queue);
+    VERIFY(script.nBatches == 2);
+    VERIFY(script.batchLen[1] == FFT_QUEUE_BATCH);
+    VERIFY(script.started[1] == &small[FFT_QUEUE_BATCH + 1]);
+    for (i = 1; i < FFT_QUEUE_BATCH; i++) {
+        VERIFY(script.started[1 + i] == &small[i - 1]);
+    }
+
+    // The leftovers, 'other' in between keeps its place
+    drain();
+    VERIFY(script.nBatches == 4);
+    VERIFY(script.batchLen[2] == 2);
+    VERIFY(script.started[1 + FFT_QUEUE_BATCH] == &small[FFT_QUEUE_BATCH - 1]);
+    VERIFY(script.batchLen[3] == 1);
+    VERIFY(script.started[3 + FFT_QUEUE_BATCH] == &other);
+
+    // Large transforms always run alone
+    jobInit(&large[0], FFT_JOB_RFFT_MAG_SQ, 4096, FFT_QUEUE_PRIO_BACKGROUND);
+    jobInit(&large[1], FFT_JOB_RFFT_MAG_SQ, 4096, FFT_QUEUE_PRIO_BACKGROUND);
+    fft_queue_submit(&queue, &other);
+    fft_queue_submit(&queue, &large[0]);
+    fft_queue_submit(&queue, &large[1]);
+    drain();
+    VERIFY(script.batchLen[5] == 1 && script.batchLen[6] == 1);
+
+    {
+        FFT_QUEUE_STATS st;
+        fft_queue_stats(&queue, &st, false);
+        VERIFY(st.batches == 7);
+        VERIFY(st.batched == FFT_QUEUE_BATCH + 2);
+        VERIFY(st.jobs == FFT_QUEUE_BATCH + 7);
+        VERIFY(st.queuedMax == FFT_QUEUE_BATCH + 3);
+    }
+}
+
+TEST("cancel only takes back waiting jobs") {
+    FFT_JOB a, b, c;
+
+    jobInit(&a, FFT_JOB_RFFT, 64, FFT_QUEUE_PRIO_LIVE);
+    jobInit(&b, FFT_JOB_RFFT, 128, FFT_QUEUE_PRIO_DISPLAY);
+    jobInit(&c, FFT_JOB_RFFT, 256, FFT_QUEUE_PRIO_DISPLAY);
+    fft_queue_submit(&queue, &a);
+    fft_queue_service(&queue);
+    fft_queue_submit(&queue, &b);
+    fft_queue_submit(&queue, &c);
+
+    VERIFY(!fft_queue_cancel(&queue, &a));
+    VERIFY(fft_queue_cancel(&queue, &c));
+    VERIFY(c.state == FFT_JOB_IDLE);
+    VERIFY(!fft_queue_cancel(&queue, &c));
+
+    drain();
+    VERIFY(script.nStarted == 2 && script.started[1] == &b);
+
+    // A cancelled job can go again, waiting on it now returns at once
+    VERIFY(!fft_queue_wait(&queue, &c) && sleeps == 0);
+    VERIFY(fft_queue_submit(&queue, &c));
+    fft_queue_service(&queue);
+    VERIFY(c.state == FFT_JOB_RUNNING);
+}
+
+TEST("callbacks may resubmit from inside start") {
+    FFT_JOB a;
+    unsigned left = 20;
+
+    script.sync = true;
+    jobInit(&a, FFT_JOB_RFFT, NPTS, FFT_QUEUE_PRIO_LIVE);
+    a.done = resubmit;
+    a.usr = &left;
+    VERIFY(fft_queue_submit(&queue, &a));
+    VERIFY(!fft_queue_service(&queue));
+
+    // Each run is started from the loop, never from inside the last
+    VERIFY(callbacks == 21);
+    VERIFY(script.nStarted == 21);
+    VERIFY(script.maxDepth == 1);
+    VERIFY(a.state == FFT_JOB_DONE && a.ok);
+    VERIFY(lockErrors == 0 && lockDepth == 0);
+}
+
+TEST("wait sleeps until the owner has finished the job") {
+    FFT_JOB a, b;
+
+    script.pollsToFinish = 3;
+    jobInit(&a, FFT_JOB_RFFT, 64, FFT_QUEUE_PRIO_BACKGROUND);
+    jobInit(&b, FFT_JOB_RFFT, 128, FFT_QUEUE_PRIO_BACKGROUND);
+    fft_queue_submit(&queue, &a);
+    fft_queue_submit(&queue, &b);
+
+    // Finishing 'a' on the way doesn't wake the waiter on 'b'
+    VERIFY(fft_queue_wait(&queue, &b));
+    VERIFY(a.state == FFT_JOB_DONE && b.state == FFT_JOB_DONE);
+    VERIFY(sleeps == 1 && ownerPasses == 7 && yields == 0);
+    VERIFY(b.waiter == NULL);
+
+    // Failures come back to the waiter and are counted
+    script.fail = true;
+    fft_queue_submit(&queue, &a);
+    VERIFY(!fft_queue_wait(&queue, &a));
+    VERIFY(!fft_queue_wait(&queue, &a));
+    {
+        FFT_QUEUE_STATS st;
+        fft_queue_stats(&queue, &st, false);
+        VERIFY(st.errors == 1 && st.jobs == 3);
+    }
+}
+
+TEST("the owner runs at the priority of the tasks it works for") {
+    FFT_JOB a, b;
+
+    // As fft_queue_run() sets it up, from a lowest priority task
+    queue.owner = xTaskGetCurrentTaskHandle();
+    queue.basePriority = queue.ownerPriority = 1;
+
+    jobInit(&a, FFT_JOB_RFFT_MAG_SQ, 4096, FFT_QUEUE_PRIO_BACKGROUND);
+    jobInit(&b, FFT_JOB_RFFT, 64, FFT_QUEUE_PRIO_LIVE);
+
+    // A priority 2 task's large job runs at 2, not above it
+    taskPriority = 2;
+    VERIFY(fft_queue_submit(&queue, &a));
+    VERIFY(ownerPriority == 2 && prioritySets == 1);
+    VERIFY(fft_queue_service(&queue));
+    VERIFY(ownerPriority == 2 && prioritySets == 1);
+
+    // A priority 4 task waiting behind it lifts the owner to 4
+    taskPriority = 4;
+    VERIFY(fft_queue_submit(&queue, &b));
+    VERIFY(ownerPriority == 4 && prioritySets == 2);
+
+    // Each finished job lets go of its task's priority
+    finishOne();
+    VERIFY(fft_queue_service(&queue));
+    VERIFY(ownerPriority == 4);
+    finishOne();
+    VERIFY(!fft_queue_service(&queue));
+    VERIFY(ownerPriority == 1 && prioritySets == 3);
+
+    // A cancel does too
+    taskPriority = 3;
+    VERIFY(fft_queue_submit(&queue, &b));
+    VERIFY(ownerPriority == 3);
+    VERIFY(fft_queue_cancel(&queue, &b));
+    VERIFY(ownerPriority == 1 && prioritySets == 5);
+    VERIFY(lockErrors == 0 && lockDepth == 0);
+}
+
+TEST("latency and utilization stats") {
+    FFT_QUEUE_STATS st;
+    FFT_JOB a, b;
+
+    jobInit(&a, FFT_JOB_RFFT, 64, FFT_QUEUE_PRIO_BACKGROUND);
+    jobInit(&b, FFT_JOB_RFFT, 128, FFT_QUEUE_PRIO_LIVE);
+
+    // a runs 1000..1300, b waits from 1100 and runs 1300..1350
+    fft_queue_submit(&queue, &a);
+    fft_queue_service(&queue);
+    hostTsCount = 1100;
+    fft_queue_submit(&queue, &b);
+    hostTsCount = 1300;
+    finishOne();
+    fft_queue_service(&queue);
+    hostTsCount = 1350;
+    finishOne();
+    hostTsCount = 2000;
+
+    fft_queue_stats(&queue, &st, true);
+    VERIFY(st.elapsed == 1000);
+    VERIFY(st.busy == 350);
+    VERIFY(st.prio[FFT_QUEUE_PRIO_BACKGROUND].jobs == 1);
+    VERIFY(st.prio[FFT_QUEUE_PRIO_BACKGROUND].latencyMax == 300);
+    VERIFY(st.prio[FFT_QUEUE_PRIO_BACKGROUND].waitMax == 0);
+    VERIFY(st.prio[FFT_QUEUE_PRIO_LIVE].latencySum == 250);
+    VERIFY(st.prio[FFT_QUEUE_PRIO_LIVE].waitMax == 200);
+    VERIFY(b.started == 1300 && b.finished == 1350);
+
+    // Reset starts over from now
+    hostTsCount = 2500;
+    fft_queue_stats(&queue, &st, false);
+    VERIFY(st.jobs == 0 && st.busy == 0 && st.elapsed == 500);
+    VERIFY(!fft_queue_submit(&queue, &(FFT_JOB){ .priority =
+        FFT_QUEUE_PRIORITIES }));
+}
+
+TEST("benchmarks") {
+    static float in[NPTS], out[NPTS];
+    FFT_JOB job;
+    uint64_t refNs, cutNs;
+    unsigned i;
+
+    // The same stand-in transform, called directly and through the queue
+    for (i = 0; i < NPTS; i++) {
+        in[i] = (float)i;
+    }
+    script.sync = true;
+    script.copy = true;
+    jobInit(&job, FFT_JOB_RFFT, NPTS, FFT_QUEUE_PRIO_LIVE);
+    job.in = in;
+    job.out = out;
+
+    BENCH(refNs, memcpy(out, in, sizeof(out)));
+    BENCH(cutNs, (fft_queue_submit(&queue, &job), fft_queue_service(&queue)));
+    VERIFY(memcmp(out, in, sizeof(out)) == 0);
+    bench_report("direct vs queued job", refNs, cutNs, 1, "job");
+    VERIFY(1);
+}
+
+} // TEST_GROUP()
@@ -0,0 +1,789 @@
+// FLAC decoder bit-exact regression tests.  A small reference encoder
+// in this file writes streams that use every subframe type, stereo
+// mode, wasted bits and residual coding option, the decoder must give
+// back the original PCM bit for bit through randomly sized reads and
+// input chunks.  Damaged frames, the wav_file integration and the
+// decode speed as a realtime factor for one core are checked last.
+//
+// Build and run from the repository root:
+//   gcc -O2 -I test -I test/et -I test/host -I ARM/include -I ALL/include
+//       -I ARM/src/oss-services/FreeRTOS-ARM/include
+//       -I ARM/src/oss-services/umm_malloc -I ARM/src/simple-services/sched-trace
+//       -I ARM/src/simple-services/wav-file -I ARM/src/simple-services/flac-dec
+//       test/test_flac_dec.c ARM/src/simple-services/flac-dec/flac_dec.c
+//       ARM/src/simple-services/wav-file/wav_file.c
+//       test/et/et.c test/et/et_host.c -lm -o test_flac_dec && ./test_flac_dec
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "flac_dec.h"  // Code Under Test (CUT)
+#include "wav_file.h"
+#include "umm_malloc.h"
+#include "et.h"  // ET: embedded test
+#include "bench.h"
+
+#define FNAME       "test_flac_dec.flac"
+#define BLOCK       1152
+#define LAST_BLOCK  1000
+#define FRAMES      (2 * BLOCK + LAST_BLOCK)
+#define STREAM_MAX  (8 * 1024 * 1024)
+#define BENCH_SECS  10
+#define ENC_BLOCK   4096
+
+enum { SUB_CONSTANT, SUB_VERBATIM, SUB_FIXED, SUB_LPC };
+
+typedef struct SUBFRAME {
+    int type;
+    unsigned order;
+    unsigned precision;
+    int shift;
+    int32_t coef[32];
+    unsigned wasted;           // Requested, used if the data allows
+    int escape;                // Force an escaped second partition
+} SUBFRAME;
+
+typedef struct BITW {
+    uint8_t *p;
+    size_t len;
+    uint32_t acc;
+    unsigned n;
+} BITW;
+
+typedef struct MEMSRC {
+    const uint8_t *p;
+    size_t len;
+    size_t pos;
+    unsigned chunk;            // Max bytes per read, 0 for any
+} MEMSRC;
+
+static uint8_t *stream;
+static int32_t *pcmL, *pcmR, *out;
+static uint32_t seed;
+static size_t frameOffset[4];
+
+// wav_file_cfg.h and flac_dec_cfg.h allocate from the umm heaps
+void *umm_calloc_aligned(size_t num, size_t item_size, size_t alignment) {
+    (void)alignment;
+    return calloc(num, item_size);
+}
+
+void umm_free_aligned(void *ptr) {
+    free(ptr);
+}
+
+void *umm_calloc_heap(umm_heap_t heap, size_t num, size_t size) {
+    (void)heap;
+    return calloc(num, size);
+}
+
+void umm_free_heap(umm_heap_t heap, void *ptr) {
+    (void)heap;
+    free(ptr);
+}
+
+static uint32_t rnd(void) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+// Reference CRCs, bit at a time
+static uint8_t refCrc8(const uint8_t *p, size_t len) {
+    uint8_t crc = 0;
+    unsigned i;
+    while (len--) {
+        crc ^= *p++;
+        for (i = 0; i < 8; i++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint16_t refCrc16(const uint8_t *p, size_t len) {
+    uint16_t crc = 0;
+    unsigned i;
+    while (len--) {
+        crc ^= (uint16_t)(*p++ << 8);
+        for (i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x8005) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Bit writer ----------------------------------------------------------------
+static void put(BITW *w, uint32_t v, unsigned bits) {
+    while (bits--) {
+        w->acc = (w->acc << 1) | ((v >> bits) & 1);
+        if (++w->n == 8) {
+            w->p[w->len++] = (uint8_t)w->acc;
+            w->acc = 0; w->n = 0;
+        }
+    }
+}
+
+static void putSigned(BITW *w, int32_t v, unsigned bits) {
+    put(w, (uint32_t)v & (bits < 32 ? (1u << bits) - 1 : ~0u), bits);
+}
+
+static void putUnary(BITW *w, uint32_t q) {
+    while (q--) {
+        put(w, 0, 1);
+    }
+    put(w, 1, 1);
+}
+
+static void putAlign(BITW *w) {
+    while (w->n) {
+        put(w, 0, 1);
+    }
+}
+
+// Stream and frame encoder --------------------------------------------------
+static void encStreamInfo(BITW *w, unsigned channels, unsigned bps,
+    unsigned maxBlock, uint64_t totalFrames, unsigned padding)
+{
+    put(w, 0x664C6143, 32);
+    put(w, padding ? 0 : 1, 1); put(w, 0, 7); put(w, 34, 24);
+    put(w, maxBlock, 16); put(w, maxBlock, 16);
+    put(w, 0, 24); put(w, 0, 24);
+    put(w, 48000, 20); put(w, channels - 1, 3); put(w, bps - 1, 5);
+    put(w, (uint32_t)(totalFrames >> 32), 4); put(w, (uint32_t)totalFrames, 32);
+    put(w, 0, 32); put(w, 0, 32); put(w, 0, 32); put(w, 0, 32);
+    if (padding) {
+        put(w, 1, 1); put(w, 1, 7); put(w, padding, 24);
+        while (padding--) {
+            put(w, 0, 8);
+        }
+    }
+}
+
+static void encUtf8(BITW *w, uint32_t v) {
+    unsigned n, i;
+    if (v < 0x80) {
+        put(w, v, 8);
+        return;
+    }
+    for (n = 2; (n < 6) && (v >= (1u << (5 * n + 1))); n++) {
+    }
+    put(w, (0xFF00u >> n) | (v >> (6 * (n - 1))), 8);
+    for (i = n - 1; i-- > 0;) {
+        put(w, 0x80 | ((v >> (6 * i)) & 0x3F), 8);
+    }
+}
+
+static unsigned signedBits(int32_t v) {
+    unsigned b = 1;
+    while ((v < -(1 << (b - 1))) || (v >= (1 << (b - 1)))) {
+        b++;
+    }
+    return b;
+}
+
+static void encResidual(BITW *w, const int32_t *r, unsigned n,
+    unsigned order, unsigned porder, int escape)
+{
+    unsigned parts = 1u << porder, psize = n >> porder;
+    unsigned p, i, k, bestK, cnt, raw, method;
+    uint64_t bits, best;
+    uint32_t u;
+    const int32_t *x;
+
+    // Five bit parameters only when some partition needs them
+    method = 0;
+    for (i = order; i < n; i++) {
+        u = ((uint32_t)r[i] << 1) ^ (uint32_t)(r[i] >> 31);
+        if (u >> 20) {
+            method = 1;
+        }
+    }
+    put(w, method, 2);
+    put(w, porder, 4);
+    x = r + order;
+    for (p = 0; p < parts; p++) {
+        cnt = (p == 0) ? psize - order : psize;
+        if (escape && (p == parts - 1)) {
+            raw = 0;
+            for (i = 0; i < cnt; i++) {
+                raw = raw > signedBits(x[i]) ? raw : signedBits(x[i]);
+            }
+            put(w, method ? 31 : 15, method ? 5 : 4);
+            put(w, raw, 5);
+            for (i = 0; i < cnt; i++) {
+                putSigned(w, x[i], raw);
+            }
+            x += cnt;
+            continue;
+        }
+        best = UINT64_MAX; bestK = 0;
+        for (k = 0; k < (method ? 31u : 15u); k++) {
+            bits = 0;
+            for (i = 0; i < cnt; i++) {
+                u = ((uint32_t)x[i] << 1) ^ (uint32_t)(x[i] >> 31);
+                bits += (u >> k) + 1 + k;
+            }
+            if (bits < best) {
+                best = bits; bestK = k;
+            }
+        }
+        put(w, bestK, method ? 5 : 4);
+        for (i = 0; i < cnt; i++) {
+            u = ((uint32_t)x[i] << 1) ^ (uint32_t)(x[i] >> 31);
+            putUnary(w, u >> bestK);
+            put(w, u & ((1u << bestK) - 1), bestK);
+        }
+        x += cnt;
+    }
+}
+
+static void encSubframe(BITW *w, const int32_t *src, unsigned n,
+    unsigned bps, const SUBFRAME *sf)
+{
+    static int32_t x[ENC_BLOCK], r[ENC_BLOCK];
+    static const int fixed[5][4] = {
+        { 0 }, { 1 }, { 2, -1 }, { 3, -3, 1 }, { 4, -6, 4, -1 }
+    };
+    unsigned i, j, wasted, porder;
+    uint32_t all = 0;
+    int64_t sum;
+
+    for (i = 0; i < n; i++) {
+        all |= (uint32_t)src[i];
+    }
+    wasted = 0;
+    while (sf->wasted && all && !(all & (1u << wasted)) &&
+        (wasted < sf->wasted)) {
+        wasted++;
+    }
+    for (i = 0; i < n; i++) {
+        x[i] = src[i] >> wasted;
+    }
+    bps -= wasted;
+
+    put(w, 0, 1);
+    switch (sf->type) {
+        case SUB_CONSTANT: put(w, 0, 6); break;
+        case SUB_VERBATIM: put(w, 1, 6); break;
+        case SUB_FIXED: put(w, 8 + sf->order, 6); break;
+        default: put(w, 31 + sf->order, 6); break;
+    }
+    if (wasted) {
+        put(w, 1, 1); putUnary(w, wasted - 1);
+    } else {
+        put(w, 0, 1);
+    }
+
+    if (sf->type == SUB_CONSTANT) {
+        putSigned(w, x[0], bps);
+        return;
+    }
+    if (sf->type == SUB_VERBATIM) {
+        for (i = 0; i < n; i++) {
+            putSigned(w, x[i], bps);
+        }
+        return;
+    }
+
+    for (i = 0; i < sf->order; i++) {
+        putSigned(w, x[i], bps);
+    }
+    if (sf->type == SUB_LPC) {
+        put(w, sf->precision - 1, 4);
+        putSigned(w, sf->shift, 5);
+        for (i = 0; i < sf->order; i++) {
+            putSigned(w, sf->coef[i], sf->precision);
+        }
+    }
+    for (i = sf->order; i < n; i++) {
+        sum = 0;
+        for (j = 0; j < sf->order; j++) {
+            sum += (int64_t)x[i - 1 - j] *
+                ((sf->type == SUB_FIXED) ? fixed[sf->order][j] : sf->coef[j]);
+        }
+        r[i] = x[i] - (int32_t)(sum >> (sf->type == SUB_FIXED ? 0 : sf->shift));
+    }
+    // Largest partition order the block size and predictor allow, up to 4
+    for (porder = 4; porder && (((n >> porder) << porder) != n ||
+        (n >> porder) < sf->order); porder--) {
+    }
+    encResidual(w, r, n, sf->order, porder, sf->escape);
+}
+
+// chMode 0 is mono, 1 independent stereo, 8..10 the decorrelated modes
+static void encFrame(BITW *w, const int32_t *l, const int32_t *r,
+    unsigned n, unsigned chMode, unsigned bps, int bpsInHeader,
+    uint32_t frameNum, const SUBFRAME *sf)
+{
+    static const unsigned bpsCode[25] = {
+        [8] = 1, [12] = 2, [16] = 4, [20] = 5, [24] = 6
+    };
+    static int32_t a[ENC_BLOCK], b[ENC_BLOCK];
+    uint8_t *start = w->p + w->len;
+    unsigned i, code, bpsA, bpsB;
+
+    put(w, 0x3FFE, 14); put(w, 0, 1); put(w, 0, 1);
+    if (n == 192) {
+        code = 1;
+    } else if (n == 1152) {
+        code = 3;
+    } else if (n == 4096) {
+        code = 12;
+    } else {
+        code = (n <= 256) ? 6 : 7;
+    }
+    put(w, code, 4);
+    put(w, 10, 4);                              // 48 kHz
+    put(w, (chMode == 0) ? 0 : (chMode == 1) ? 1 : chMode, 4);
+    put(w, bpsInHeader ? bpsCode[bps] : 0, 3);
+    put(w, 0, 1);
+    encUtf8(w, frameNum);
+    if (code == 6) {
+        put(w, n - 1, 8);
+    } else if (code == 7) {
+        put(w, n - 1, 16);
+    }
+    put(w, refCrc8(start, (w->p + w->len) - start), 8);
+
+    bpsA = bpsB = bps;
+    for (i = 0; i < n; i++) {
+        switch (chMode) {
+            case 8: a[i] = l[i]; b[i] = l[i] - r[i]; break;
+            case 9: a[i] = l[i] - r[i]; b[i] = r[i]; break;
+            case 10: a[i] = (l[i] + r[i]) >> 1; b[i] = l[i] - r[i]; break;
+            default: a[i] = l[i]; b[i] = r[i]; break;
+        }
+    }
+    bpsA += (chMode == 9);
+    bpsB += (chMode == 8) || (chMode == 10);
+
+    encSubframe(w, a, n, bpsA, sf);
+    if (chMode) {
+        encSubframe(w, b, n, bpsB, sf);
+    }
+    putAlign(w);
+    put(w, refCrc16(start, (w->p + w->len) - start), 16);
+}
+
+// Three frames, the last one short with an explicit 16-bit block size
+static size_t encStream(unsigned chMode, unsigned bps, const SUBFRAME *sf) {
+    BITW w = { stream, 0, 0, 0 };
+    unsigned f;
+
+    encStreamInfo(&w, chMode ? 2 : 1, bps, BLOCK, FRAMES, 100);
+    for (f = 0; f < 3; f++) {
+        frameOffset[f] = w.len;
+        encFrame(&w, pcmL + f * BLOCK, pcmR + f * BLOCK,
+            (f < 2) ? BLOCK : LAST_BLOCK, chMode, bps, f != 1, f, sf);
+    }
+    frameOffset[3] = w.len;
+    return w.len;
+}
+
+// Test signal, a few partials plus noise, 'wasted' low bits cleared
+static void genPcm(int32_t *x, unsigned n, unsigned bps, double f0,
+    unsigned wasted, int constant)
+{
+    double full = (double)(1 << (bps - 1)) - 1.0;
+    unsigned i;
+    int32_t v;
+
+    for (i = 0; i < n; i++) {
+        if (constant) {
+            v = (int32_t)(full * 0.3) + (int32_t)f0;
+        } else {
+            v = (int32_t)(full * (0.5 * sin(f0 * i) + 0.25 * sin(3.1 * f0 * i) +
+                0.05 * ((double)(rnd() & 0xFFFF) / 32768.0 - 1.0)));
+        }
+        x[i] = (int32_t)((uint32_t)v & ~((1u << wasted) - 1));
+    }
+}
+
+static size_t memRead(void *usr, void *buf, size_t len) {
+    MEMSRC *m = (MEMSRC *)usr;
+    size_t n = m->len - m->pos;
+    n = (n > len) ? len : n;
+    if (m->chunk && (n > 1)) {
+        n = 1 + rnd() % ((n < m->chunk) ? n : m->chunk);
+    }
+    memcpy(buf, m->p + m->pos, n);
+    m->pos += n;
+    return n;
+}
+
+// Decodes the whole stream with random read sizes
+static size_t decodeAll(FLAC_DEC *dec, unsigned maxRead) {
+    size_t done = 0, n;
+    do {
+        n = flac_dec_read(dec, out + done, 1 + rnd() % maxRead);
+        done += (n == (size_t)-1) ? 0 : n;
+    } while (n && (n != (size_t)-1));
+    return done;
+}
+
+static int matchesPcm(unsigned channels, unsigned bps, size_t frames) {
+    size_t i;
+    unsigned s = 32 - bps;
+    for (i = 0; i < frames; i++) {
+        if (out[i * channels] != (int32_t)((uint32_t)pcmL[i] << s)) {
+            return 0;
+        }
+        if ((channels == 2) &&
+            (out[i * 2 + 1] != (int32_t)((uint32_t)pcmR[i] << s))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Levinson-Durbin LPC for the benchmark encoder, quantized like libFLAC
+static void lpcDesign(const int32_t *x, unsigned n, unsigned order,
+    unsigned precision, SUBFRAME *sf)
+{
+    double ac[33], lpc[33], tmp[33], err, k, cmax;
+    unsigned i, j, lag;
+    int e;
+
+    for (lag = 0; lag <= order; lag++) {
+        ac[lag] = 0.0;
+        for (i = lag; i < n; i++) {
+            ac[lag] += (double)x[i] * x[i - lag] *
+                (0.54 - 0.46 * cos(2.0 * M_PI * i / (n - 1)));
+        }
+    }
+    ac[0] *= 1.0 + 1e-9;
+    err = ac[0] + 1e-9;
+    memset(lpc, 0, sizeof(lpc));
+    for (i = 0; i < order; i++) {
+        k = -ac[i + 1];
+        for (j = 0; j < i; j++) {
+            k -= lpc[j] * ac[i - j];
+        }
+        k /= err;
+        memcpy(tmp, lpc, sizeof(tmp));
+        lpc[i] = k;
+        for (j = 0; j < i; j++) {
+            lpc[j] = tmp[j] + k * tmp[i - 1 - j];
+        }
+        err *= 1.0 - k * k;
+    }
+    cmax = 0.0;
+    for (i = 0; i < order; i++) {
+        cmax = fabs(lpc[i]) > cmax ? fabs(lpc[i]) : cmax;
+    }
+    frexp(cmax, &e);
+    sf->type = SUB_LPC;
+    sf->order = order;
+    sf->precision = precision;
+    sf->shift = (int)precision - e - 1;
+    sf->shift = sf->shift > 15 ? 15 : sf->shift < 0 ? 0 : sf->shift;
+    for (i = 0; i < order; i++) {
+        sf->coef[i] = (int32_t)lround(-lpc[i] * (1 << sf->shift));
+        if (sf->coef[i] >= (1 << (precision - 1))) {
+            sf->coef[i] = (1 << (precision - 1)) - 1;
+        } else if (sf->coef[i] < -(1 << (precision - 1))) {
+            sf->coef[i] = -(1 << (precision - 1));
+        }
+    }
+    sf->wasted = 0;
+    sf->escape = 0;
+}
+
+void setup(void) {
+    seed = 0xF1AC;
+    if (stream == NULL) {
+        stream = malloc(STREAM_MAX);
+        pcmL = malloc(BENCH_SECS * 48000 * sizeof(int32_t));
+        pcmR = malloc(BENCH_SECS * 48000 * sizeof(int32_t));
+        out = malloc(BENCH_SECS * 48000 * 2 * sizeof(int32_t));
+    }
+}
+
+void teardown(void) {
+    remove(FNAME);
+}
+
+// test group ----------------------------------------------------------------
+TEST_GROUP("flac_dec") {
+
+TEST("reference CRCs match the published check values") {
+    VERIFY(refCrc8((const uint8_t *)"123456789", 9) == 0xF4);
+    VERIFY(refCrc16((const uint8_t *)"123456789", 9) == 0xFEE8);
+}
+
+TEST("frame numbers are coded UTF-8 style") {
+    uint8_t buf[8];
+    BITW w = { buf, 0, 0, 0 };
+    encUtf8(&w, 0x7F);
+    encUtf8(&w, 0x80);
+    VERIFY(w.len == 3);
+    VERIFY(buf[0] == 0x7F && buf[1] == 0xC2 && buf[2] == 0x80);
+}
+
+TEST("non-FLAC and out of range streams are rejected") {
+    static const uint8_t riff[16] = "RIFF\0\0\0\0WAVEfmt ";
+    MEMSRC m = { riff, sizeof(riff), 0, 0 };
+    BITW w = { stream, 0, 0, 0 };
+
+    VERIFY(flac_dec_open(memRead, &m) == NULL);
+
+    encStreamInfo(&w, 2, 32, BLOCK, 0, 0);
+    m = (MEMSRC){ stream, w.len + 64, 0, 0 };
+    VERIFY(flac_dec_open(memRead, &m) == NULL);
+
+    w.len = 0;
+    encStreamInfo(&w, 2, 16, 16384, 0, 0);
+    m = (MEMSRC){ stream, w.len + 64, 0, 0 };
+    VERIFY(flac_dec_open(memRead, &m) == NULL);
+}
+
+TEST("hand assembled constant frame decodes to the golden value") {
+    BITW w = { stream, 0, 0, 0 };
+    uint8_t *start;
+    FLAC_DEC *dec;
+    MEMSRC m;
+    int32_t pcm[20];
+
+    encStreamInfo(&w, 1, 16, 16, 16, 0);
+    start = w.p + w.len;
+    put(&w, 0xFFF8, 16);                        // sync, fixed blocking
+    put(&w, 0x6A, 8);                           // 8-bit block size, 48 kHz
+    put(&w, 0x08, 8);                           // mono, 16 bits
+    put(&w, 0x00, 8);                           // frame 0
+    put(&w, 15, 8);                             // 16 samples
+    put(&w, refCrc8(start, 6), 8);
+    put(&w, 0x00, 8);                           // CONSTANT, no wasted bits
+    put(&w, 0x1234, 16);
+    put(&w, refCrc16(start, (w.p + w.len) - start), 16);
+
+    m = (MEMSRC){ stream, w.len, 0, 0 };
+    dec = flac_dec_open(memRead, &m);
+    VERIFY(dec != NULL);
+    VERIFY(flac_dec_info(dec)->channels == 1);
+    VERIFY(flac_dec_info(dec)->bitsPerSample == 16);
+    VERIFY(flac_dec_info(dec)->totalFrames == 16);
+    VERIFY(flac_dec_audio_offset(dec) == 42);
+    VERIFY(flac_dec_read(dec, pcm, 20) == 16);
+    VERIFY(pcm[0] == 0x12340000 && pcm[15] == 0x12340000);
+    VERIFY(flac_dec_read(dec, pcm, 20) == 0);
+    flac_dec_close(dec);
+}
+
+TEST("every subframe type and stereo mode round trips bit-exact") {
+    static const unsigned modes[] = { 0, 1, 8, 9, 10 };
+    static const unsigned bpss[] = { 8, 16, 24 };
+    SUBFRAME sfs[10];
+    FLAC_DEC *dec;
+    FLAC_DEC_STATS st;
+    MEMSRC m;
+    unsigned s, b, c, i, ch;
+    size_t len;
+    int ok = 1;
+
+    memset(sfs, 0, sizeof(sfs));
+    sfs[0].type = SUB_CONSTANT;
+    sfs[1].type = SUB_VERBATIM; sfs[1].wasted = 3;
+    for (i = 0; i <= 4; i++) {
+        sfs[2 + i].type = SUB_FIXED; sfs[2 + i].order = i;
+        sfs[2 + i].escape = (i == 2);
+    }
+    // Sine predictor, an odd order and a full 32 tap filter
+    sfs[7].type = SUB_LPC; sfs[7].order = 2; sfs[7].precision = 15;
+    sfs[7].shift = 13; sfs[7].coef[0] = 16380; sfs[7].coef[1] = -8192;
+    sfs[8].type = SUB_LPC; sfs[8].order = 7; sfs[8].precision = 12;
+    sfs[8].shift = 10; sfs[8].wasted = 2;
+    sfs[9].type = SUB_LPC; sfs[9].order = 32; sfs[9].precision = 15;
+    sfs[9].shift = 14; sfs[9].escape = 1;
+    for (i = 0; i < 32; i++) {
+        sfs[8].coef[i] = (int32_t)(rnd() % 400) - 200;
+        sfs[9].coef[i] = (int32_t)(rnd() % 2000) - 1000;
+    }
+    sfs[8].coef[0] = 1024;
+    sfs[9].coef[0] = 16000;
+
+    for (s = 0; s < ARRAY_NELEM(sfs); s++)
+    for (b = 0; b < ARRAY_NELEM(bpss); b++)
+    for (c = 0; c < ARRAY_NELEM(modes); c++) {
+        ch = modes[c] ? 2 : 1;
+        genPcm(pcmL, FRAMES, bpss[b], 0.01 + s * 0.003, sfs[s].wasted,
+            sfs[s].type == SUB_CONSTANT);
+        genPcm(pcmR, FRAMES, bpss[b], 0.013 + s * 0.002, sfs[s].wasted,
+            sfs[s].type == SUB_CONSTANT);
+        len = encStream(modes[c], bpss[b], &sfs[s]);
+        m = (MEMSRC){ stream, len, 0, 13 };
+        dec = flac_dec_open(memRead, &m);
+        if ((dec == NULL) || (decodeAll(dec, 3 * 64) != FRAMES * ch) ||
+            !matchesPcm(ch, bpss[b], FRAMES)) {
+            printf("  mismatch sub %u bps %u mode %u\n", s, bpss[b], modes[c]);
+            ok = 0;
+        }
+        if (dec) {
+            flac_dec_stats(dec, &st);
+            ok = ok && (st.frames == 3) && !st.crcErrors && !st.syncErrors;
+            flac_dec_close(dec);
+        }
+    }
+    VERIFY(ok);
+}
+
+TEST("restart replays the stream from the first frame") {
+    SUBFRAME sf = { SUB_FIXED, 2 };
+    FLAC_DEC *dec;
+    MEMSRC m;
+    size_t len;
+
+    genPcm(pcmL, FRAMES, 16, 0.02, 0, 0);
+    genPcm(pcmR, FRAMES, 16, 0.03, 0, 0);
+    len = encStream(10, 16, &sf);
+    m = (MEMSRC){ stream, len, 0, 0 };
+    dec = flac_dec_open(memRead, &m);
+    VERIFY(dec != NULL);
+    VERIFY(flac_dec_read(dec, out, 5000) == 5000);
+    m.pos = flac_dec_audio_offset(dec);
+    flac_dec_restart(dec);
+    VERIFY(decodeAll(dec, 500) == FRAMES * 2);
+    VERIFY(matchesPcm(2, 16, FRAMES));
+    flac_dec_close(dec);
+}
+
+TEST("a bad frame CRC plays silence, a bad header is skipped") {
+    SUBFRAME sf = { SUB_LPC, 2, 15, 13, { 16380, -8192 } };
+    FLAC_DEC *dec;
+    FLAC_DEC_STATS st;
+    MEMSRC m;
+    size_t len, i;
+    int ok;
+
+    genPcm(pcmL, FRAMES, 16, 0.02, 0, 0);
+    genPcm(pcmR, FRAMES, 16, 0.03, 0, 0);
+    len = encStream(8, 16, &sf);
+
+    // Footer CRC of the middle frame
+    stream[frameOffset[2] - 1] ^= 0x01;
+    m = (MEMSRC){ stream, len, 0, 7 };
+    dec = flac_dec_open(memRead, &m);
+    VERIFY(dec != NULL);
+    VERIFY(decodeAll(dec, 256) == FRAMES * 2);
+    flac_dec_stats(dec, &st);
+    VERIFY(st.frames == 3 && st.crcErrors == 1);
+    ok = 1;
+    for (i = BLOCK * 2; i < BLOCK * 4; i++) {
+        ok = ok && (out[i] == 0);
+    }
+    VERIFY(ok);
+    memmove(out + BLOCK * 2, out + BLOCK * 4, LAST_BLOCK * 2 * sizeof(int32_t));
+    memmove(pcmL + BLOCK, pcmL + BLOCK * 2, LAST_BLOCK * sizeof(int32_t));
+    memmove(pcmR + BLOCK, pcmR + BLOCK * 2, LAST_BLOCK * sizeof(int32_t));
+    VERIFY(matchesPcm(2, 16, BLOCK + LAST_BLOCK));
+    flac_dec_close(dec);
+
+    // Header CRC-8 of the middle frame, fixed block size so byte 6
+    genPcm(pcmL, FRAMES, 16, 0.02, 0, 0);
+    genPcm(pcmR, FRAMES, 16, 0.03, 0, 0);
+    len = encStream(8, 16, &sf);
+    stream[frameOffset[1] + 5] ^= 0x80;
+    m = (MEMSRC){ stream, len, 0, 0 };
+    dec = flac_dec_open(memRead, &m);
+    VERIFY(dec != NULL);
+    VERIFY(decodeAll(dec, 256) == (BLOCK + LAST_BLOCK) * 2);
+    flac_dec_stats(dec, &st);
+    VERIFY(st.frames == 2 && st.syncErrors >= 1);
+    memmove(pcmL + BLOCK, pcmL + BLOCK * 2, LAST_BLOCK * sizeof(int32_t));
+    memmove(pcmR + BLOCK, pcmR + BLOCK * 2, LAST_BLOCK * sizeof(int32_t));
+    VERIFY(matchesPcm(2, 16, BLOCK + LAST_BLOCK));
+    flac_dec_close(dec);
+}
+
+TEST("wav_file opens FLAC sources and loops them") {
+    SUBFRAME sf = { SUB_FIXED, 3 };
+    WAV_FILE wf;
+    FILE *f;
+    size_t len, n;
+    int32_t *buf;
+
+    genPcm(pcmL, FRAMES, 24, 0.02, 0, 0);
+    genPcm(pcmR, FRAMES, 24, 0.03, 0, 0);
+    len = encStream(9, 24, &sf);
+    f = fopen(FNAME, "wb");
+    VERIFY(f && (fwrite(stream, len, 1, f) == 1));
+    fclose(f);
+
+    memset(&wf, 0, sizeof(wf));
+    wf.fname = FNAME;
+    wf.isSrc = true;
+    VERIFY(openWave(&wf));
+    VERIFY(wf.waveInfo.waveFmt == WAVE_FMT_FLAC);
+    VERIFY(strcmp(waveFmtName(wf.waveInfo.waveFmt), "FLAC") == 0);
+    VERIFY(wf.channels == 2 && wf.sampleRate == 48000);
+    VERIFY(wf.wordSizeBytes == 4 && wf.frameSizeBytes == 8);
+    VERIFY(wf.dataSize == FRAMES * 2);
+
+    // Reads stop at the end of the stream, the next one starts over
+    n = 0;
+    while (n < FRAMES * 2) {
+        len = readWave(&wf, out + n, 700);
+        VERIFY(len != 0 && len != (size_t)-1);
+        n += len;
+    }
+    VERIFY(n == FRAMES * 2);
+    VERIFY(matchesPcm(2, 24, FRAMES));
+    buf = out + FRAMES * 2;
+    VERIFY(readWave(&wf, buf, 2) == 2);
+    decodeWave(&wf, buf, buf, 2);
+    VERIFY(buf[0] == out[0] && buf[1] == out[1]);
+
+    // Channel overrides do not apply to FLAC
+    overrideWave(&wf, 1);
+    VERIFY(wf.channels == 2);
+    closeWave(&wf);
+    VERIFY(wf.flac == NULL);
+}
+
+TEST("benchmarks") {
+    static const unsigned blockSize = 4096;
+    unsigned frames = BENCH_SECS * 48000;
+    BITW w = { stream, 0, 0, 0 };
+    SUBFRAME sf;
+    FLAC_DEC *dec;
+    MEMSRC m;
+    uint64_t t, best;
+    unsigned f, n, rep;
+    double s;
+
+    // Program-like material, partials with vibrato plus a noise floor
+    for (f = 0; f < frames; f++) {
+        s = 0.3 * sin(2 * M_PI * 220.0 * f / 48000 + 2 * sin(f * 3e-4)) +
+            0.2 * sin(2 * M_PI * 331.0 * f / 48000) +
+            0.1 * sin(2 * M_PI * 1250.0 * f / 48000) +
+            0.003 * ((double)(rnd() & 0xFFFF) / 32768.0 - 1.0);
+        pcmL[f] = (int32_t)(s * 32767.0);
+        pcmR[f] = (int32_t)(s * 0.8 * 32767.0 + 0.002 * (rnd() & 0x3FF));
+    }
+    encStreamInfo(&w, 2, 16, blockSize, frames, 0);
+    for (f = 0; f < frames; f += blockSize) {
+        n = (frames - f < blockSize) ? frames - f : blockSize;
+        lpcDesign(pcmL + f, n, 8, 12, &sf);
+        encFrame(&w, pcmL + f, pcmR + f, n, 8, 16, 1, f / blockSize, &sf);
+    }
+
+    best = UINT64_MAX;
+    for (rep = 0; rep < 3; rep++) {
+        m = (MEMSRC){ stream, w.len, 0, 0 };
+        dec = flac_dec_open(memRead, &m);
+        VERIFY(dec != NULL);
+        t = bench_ns();
+        VERIFY(flac_dec_read(dec, out, frames * 2) == frames * 2);
+        t = bench_ns() - t;
+        best = (t < best) ? t : best;
+        flac_dec_close(dec);
+    }
+    VERIFY(matchesPcm(2, 16, frames));
+    printf("  bench %-28s %.2f ns/smp  x%.0f realtime  ratio %.2f\n",
+        "flac 16/2 LPC8 4096", (double)best / (frames * 2),
+        BENCH_SECS * 1e9 / best, (double)(frames * 4) / w.len);
+}
+
+} // TEST_GROUP()
@@ -0,0 +1,327 @@
+// 802.1AS slave and media clock host test against a simulated
+// grandmaster.  The simulation runs in true time; the slave's local
+// clock has a fixed offset and frequency error and the link has a
+// symmetric propagation delay.
+//
+// Build and run from the repository root:
+//   gcc -I test/et -I ARM/include -I ARM/src/simple-services/gptp
+//       test/test_gptp.c ARM/src/simple-services/gptp/gptp.c
+//       ARM/src/simple-services/gptp/media_clock.c
+//       test/et/et.c test/et/et_host.c -o test_gptp && ./test_gptp
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "gptp.h"        // Code Under Test (CUT)
+#include "media_clock.h" // Code Under Test (CUT)
+#include "et.h"  // ET: embedded test
+
+#define NS_PER_SEC      1000000000ULL
+#define SYNC_INTERVAL   125000000ULL
+#define POLL_INTERVAL   100000000ULL
+#define LINK_DELAY      500
+#define RESIDENCE       10000
+#define LOCAL_OFFSET    (5 * NS_PER_SEC + 123456)
+#define LOCAL_PPB       (-35000)
+
+static const uint8_t GM_ID[8] = { 0x00, 0x1B, 0x21, 0xFF, 0xFE, 0x00, 0x00, 0x01 };
+static const uint8_t SLAVE_ID[8] = { 0x00, 0x05, 0xCD, 0xFF, 0xFE, 0x01, 0x02, 0x03 };
+
+static GPTP slave;
+static uint64_t simTime;     // true (grandmaster) time
+static uint16_t gmSeq;
+static int64_t localPpb;
+static uint64_t localBase, simBase;
+
+// Slave transmit queue, processed by the simulated link partner
+typedef struct {
+    uint8_t frame[14 + GPTP_MAX_MSG_SIZE];
+    unsigned len;
+    bool timestamp;
+} TX_FRAME;
+
+static TX_FRAME txq[8];
+static unsigned txqLen;
+static unsigned slaveResps;
+static unsigned slaveRespFups;
+static uint64_t lastRespT2, lastRespT3;
+
+// Local clock, continuous across frequency changes
+static uint64_t localTime(uint64_t t) {
+    int64_t d = (int64_t)(t - simBase);
+    return localBase + d + d * localPpb / (int64_t)NS_PER_SEC;
+}
+
+static void localSetPpb(int64_t ppb) {
+    localBase = localTime(simTime);
+    simBase = simTime;
+    localPpb = ppb;
+}
+
+static void put16(uint8_t *p, uint16_t v) { p[0] = v >> 8; p[1] = v; }
+static void put32(uint8_t *p, uint32_t v) {
+    put16(p, v >> 16); put16(p + 2, v);
+}
+static uint16_t get16(const uint8_t *p) { return (p[0] << 8) | p[1]; }
+static uint32_t get32(const uint8_t *p) {
+    return ((uint32_t)get16(p) << 16) | get16(p + 2);
+}
+static void putTs(uint8_t *p, uint64_t t) {
+    put16(p, (t / NS_PER_SEC) >> 32);
+    put32(p + 2, t / NS_PER_SEC);
+    put32(p + 6, t % NS_PER_SEC);
+}
+static uint64_t getTs(const uint8_t *p) {
+    return (((uint64_t)get16(p) << 32) | get32(p + 2)) * NS_PER_SEC +
+        get32(p + 6);
+}
+
+static int slaveTxMsg(void *linkPtr, uint8_t *msg, unsigned len, bool timestamp) {
+    TX_FRAME *f = &txq[txqLen++];
+    memset(f->frame, 0, 14);
+    f->frame[12] = 0x88; f->frame[13] = 0xF7;
+    memcpy(f->frame + 14, msg, len);
+    f->len = 14 + len;
+    f->timestamp = timestamp;
+    return 0;
+}
+
+// Builds a grandmaster message in 'frame', returns the frame length
+static unsigned gmMsg(uint8_t *frame, uint8_t type, unsigned len, uint16_t seq) {
+    uint8_t *msg = frame + 14;
+    memset(frame, 0, 14 + len);
+    frame[12] = 0x88; frame[13] = 0xF7;
+    msg[0] = 0x10 | type;
+    msg[1] = 0x02;
+    put16(msg + 2, len);
+    memcpy(msg + 20, GM_ID, 8);
+    put16(msg + 28, 1);
+    put16(msg + 30, seq);
+    return 14 + len;
+}
+
+static void gmAnnounce(void) {
+    uint8_t frame[14 + 64];
+    unsigned len = gmMsg(frame, 0xB, 64, gmSeq);
+    frame[14 + 47] = 246;                   // priority1
+    frame[14 + 48] = 248;                   // clockClass
+    frame[14 + 52] = 248;                   // priority2
+    memcpy(frame + 14 + 53, GM_ID, 8);
+    gptpRecvFrame(&slave, frame, len, localTime(simTime + LINK_DELAY));
+}
+
+static void gmSync(void) {
+    uint8_t frame[14 + 76];
+    unsigned len;
+
+    len = gmMsg(frame, 0x0, 44, gmSeq);
+    gptpRecvFrame(&slave, frame, len, localTime(simTime + LINK_DELAY));
+    len = gmMsg(frame, 0x8, 76, gmSeq);
+    putTs(frame + 14 + 34, simTime);
+    gptpRecvFrame(&slave, frame, len, localTime(simTime + LINK_DELAY));
+    gmSeq++;
+}
+
+// The link partner answers Pdelay_Req and collects the slave's answers
+static void partnerService(void) {
+    uint8_t frame[14 + 54];
+    unsigned i, len;
+    uint64_t t2, t3;
+    uint8_t *msg;
+
+    for (i = 0; i < txqLen; i++) {
+        msg = txq[i].frame + 14;
+        if (txq[i].timestamp) {
+            gptpTxTimestamp(&slave, txq[i].frame, txq[i].len, localTime(simTime));
+        }
+        switch (msg[0] & 0x0F) {
+        case 0x2:   // slave's Pdelay_Req
+            t2 = simTime + LINK_DELAY;
+            t3 = t2 + RESIDENCE;
+            len = gmMsg(frame, 0x3, 54, get16(msg + 30));
+            putTs(frame + 14 + 34, t2);
+            memcpy(frame + 14 + 44, msg + 20, 10);
+            gptpRecvFrame(&slave, frame, len, localTime(t3 + LINK_DELAY));
+            len = gmMsg(frame, 0xA, 54, get16(msg + 30));
+            putTs(frame + 14 + 34, t3);
+            memcpy(frame + 14 + 44, msg + 20, 10);
+            gptpRecvFrame(&slave, frame, len, localTime(t3 + LINK_DELAY));
+            break;
+        case 0x3:   // slave's Pdelay_Resp
+            slaveResps++;
+            lastRespT2 = getTs(msg + 34);
+            break;
+        case 0xA:   // slave's Pdelay_Resp_Follow_Up
+            slaveRespFups++;
+            lastRespT3 = getTs(msg + 34);
+            break;
+        default:
+            break;
+        }
+    }
+    txqLen = 0;
+}
+
+// Runs the simulation for 'duration' ns
+static void simRun(uint64_t duration, bool syncs) {
+    uint64_t end = simTime + duration;
+    uint64_t nextSync = simTime;
+    uint64_t nextPoll = simTime;
+    uint64_t nextAnnounce = simTime;
+
+    while (simTime < end) {
+        if (syncs && (simTime >= nextAnnounce)) {
+            gmAnnounce();
+            nextAnnounce += NS_PER_SEC;
+        }
+        if (syncs && (simTime >= nextSync)) {
+            gmSync();
+            nextSync += SYNC_INTERVAL;
+        }
+        if (simTime >= nextPoll) {
+            gptpPoll(&slave, localTime(simTime));
+            partnerService();
+            nextPoll += POLL_INTERVAL;
+        }
+        simTime += 5000000;
+    }
+}
+
+static int64_t mappingError(void) {
+    uint64_t master;
+    gptpLocalToMaster(&slave, localTime(simTime), &master);
+    return (int64_t)(master - simTime);
+}
+
+static void simStart(int64_t ppb) {
+    memset(&slave, 0, sizeof(slave));
+    memcpy(slave.clockIdentity, SLAVE_ID, 8);
+    slave.link.txMsg = slaveTxMsg;
+    gptpInit(&slave);
+    simTime = 1000 * NS_PER_SEC;
+    simBase = 0;
+    localBase = LOCAL_OFFSET;
+    localPpb = ppb;
+    gmSeq = 0;
+    txqLen = 0;
+    slaveResps = slaveRespFups = 0;
+}
+
+void setup(void) {
+}
+
+void teardown(void) {
+}
+
+// test group ----------------------------------------------------------------
+TEST_GROUP("gPTP") {
+
+TEST("no mapping before the first sync") {
+    uint64_t master;
+    simStart(LOCAL_PPB);
+    VERIFY(!gptpLocalToMaster(&slave, 1234, &master));
+    VERIFY(master == 1234);
+    VERIFY(!gptpLocked(&slave));
+}
+
+TEST("slave locks to the simulated master") {
+    GPTP_STATS stats;
+    int64_t err;
+
+    simStart(LOCAL_PPB);
+    simRun(30 * NS_PER_SEC, true);
+    gptpGetStats(&slave, &stats);
+
+    VERIFY(stats.locked);
+    VERIFY(stats.locks == 1);
+    VERIFY(stats.asCapable);
+    VERIFY(stats.pdelays >= 28);
+    VERIFY(stats.meanPathDelay >= LINK_DELAY - 5);
+    VERIFY(stats.meanPathDelay <= LINK_DELAY + 5);
+    VERIFY(stats.offset < 50 && stats.offset > -50);
+
+    // Master is ~35 ppm fast relative to the local clock
+    VERIFY(stats.ratePpb > 34000 && stats.ratePpb < 36500);
+
+    err = mappingError();
+    VERIFY(err < 100 && err > -100);
+}
+
+TEST("mapping slews, it never jumps, after a frequency change") {
+    GPTP_STATS stats;
+    int64_t err;
+
+    simStart(LOCAL_PPB);
+    simRun(20 * NS_PER_SEC, true);
+    localSetPpb(LOCAL_PPB + 2000);
+    simRun(20 * NS_PER_SEC, true);
+    gptpGetStats(&slave, &stats);
+    VERIFY(stats.locked);
+    VERIFY(stats.steps == 0);
+    err = mappingError();
+    VERIFY(err < 100 && err > -100);
+}
+
+TEST("lost master unlocks") {
+    GPTP_STATS stats;
+
+    simStart(LOCAL_PPB);
+    simRun(10 * NS_PER_SEC, true);
+    VERIFY(gptpLocked(&slave));
+    simRun(1 * NS_PER_SEC, false);
+    gptpGetStats(&slave, &stats);
+    VERIFY(!stats.locked);
+    VERIFY(stats.timeouts == 1);
+}
+
+TEST("slave answers peer delay requests") {
+    uint8_t frame[14 + 54];
+    unsigned len;
+
+    simStart(0);
+    len = gmMsg(frame, 0x2, 54, 77);
+    gptpRecvFrame(&slave, frame, len, 5000);
+    VERIFY(txqLen == 1);
+    simTime = 0;
+    localBase = LOCAL_OFFSET;
+    partnerService();
+    VERIFY(slaveResps == 1);
+    VERIFY(slaveRespFups == 1);
+    VERIFY(lastRespT2 == 5000);
+    VERIFY(lastRespT3 == LOCAL_OFFSET);
+}
+
+TEST("media clock tracks a slow audio clock through jitter") {
+    MEDIA_CLOCK mc;
+    uint64_t t = 77 * NS_PER_SEC;
+    uint64_t truth;
+    uint32_t lfsr = 0xACE1u;
+    int64_t err, maxErr = 0, sumErr = 0;
+    int32_t jitter;
+    unsigned i;
+
+    // 32 frames at 48 kHz, audio clock 100 ppm slow
+    mediaClockInit(&mc, 48000, 32);
+    VERIFY(mc.period == 666666);
+    for (i = 0; i < 20000; i++) {
+        truth = t + (uint64_t)i * 666733;
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+        jitter = (int32_t)(lfsr % 4001) - 2000;
+        mediaClockUpdate(&mc, truth + jitter);
+        if (i > 5000) {
+            err = (int64_t)(mc.t0 - truth);
+            if (err < 0) err = -err;
+            if (err > maxErr) maxErr = err;
+            sumErr += err;
+        }
+    }
+    VERIFY(mc.resyncs == 0);
+    // Filtered block times are well inside the +/-2us input jitter
+    VERIFY(maxErr < 2000);
+    VERIFY(sumErr / 14999 < 500);
+    VERIFY(mediaClockRatePpb(&mc) > -102000);
+    VERIFY(mediaClockRatePpb(&mc) < -98000);
+}
+
+} // TEST_GROUP()
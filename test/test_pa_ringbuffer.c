@@ -0,0 +1,186 @@
+// PaUtil ring buffer regression tests.  Region splitting at the wrap
+// point is checked directly, random read/write sizes are checked against
+// a reference FIFO model and a producer/consumer thread pair checks the
+// lock-free indices.  Block throughput is reported against plain
+// memcpy() into a linear buffer.
+//
+// Build and run from the repository root:
+//   gcc -O2 -I test -I test/et -I ARM/src/oss-services/pa-ringbuffer -pthread
+//       test/test_pa_ringbuffer.c ARM/src/oss-services/pa-ringbuffer/pa_ringbuffer.c
+//       test/et/et.c test/et/et_host.c -o test_pa_ringbuffer && ./test_pa_ringbuffer
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "pa_ringbuffer.h"  // Code Under Test (CUT)
+#include "et.h"  // ET: embedded test
+#include "bench.h"
+
+#define ELEMENTS    256
+#define BLOCK       (64 * 2)
+#define TRANSFERS   2000000
+
+static PaUtilRingBuffer rb;
+static uint32_t rbMem[ELEMENTS];
+static uint32_t seed;
+static volatile int stop;
+
+// Reference FIFO, a linear buffer indexed with free running counters
+static uint32_t refMem[ELEMENTS];
+static unsigned refHead, refTail;
+
+static uint32_t rnd(void) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+static unsigned refWrite(const uint32_t *d, unsigned n) {
+    unsigned i, room = ELEMENTS - (refHead - refTail);
+    n = n < room ? n : room;
+    for (i = 0; i < n; i++) {
+        refMem[(refHead + i) % ELEMENTS] = d[i];
+    }
+    refHead += n;
+    return n;
+}
+
+static unsigned refRead(uint32_t *d, unsigned n) {
+    unsigned i, avail = refHead - refTail;
+    n = n < avail ? n : avail;
+    for (i = 0; i < n; i++) {
+        d[i] = refMem[(refTail + i) % ELEMENTS];
+    }
+    refTail += n;
+    return n;
+}
+
+static void *producer(void *arg) {
+    uint32_t next = 0, block[17];
+    ring_buffer_size_t n, i;
+    (void)arg;
+    while ((next < TRANSFERS) && !stop) {
+        n = 1 + next % 17;
+        for (i = 0; i < n; i++) {
+            block[i] = next + i;
+        }
+        next += PaUtil_WriteRingBuffer(&rb, block, n);
+    }
+    return NULL;
+}
+
+void setup(void) {
+    seed = 1;
+    refHead = refTail = 0;
+    memset(rbMem, 0, sizeof(rbMem));
+    PaUtil_InitializeRingBuffer(&rb, sizeof(uint32_t), ELEMENTS, rbMem);
+}
+
+void teardown(void) {
+}
+
+// test group ----------------------------------------------------------------
+TEST_GROUP("pa_ringbuffer") {
+
+TEST("init rejects sizes that are not a power of 2") {
+    PaUtilRingBuffer bad;
+    VERIFY(PaUtil_InitializeRingBuffer(&bad, 4, 48, rbMem) == -1);
+    VERIFY(PaUtil_InitializeRingBuffer(&bad, 4, 64, rbMem) == 0);
+    VERIFY(PaUtil_GetRingBufferReadAvailable(&bad) == 0);
+    VERIFY(PaUtil_GetRingBufferWriteAvailable(&bad) == 64);
+}
+
+TEST("full and empty are distinguished") {
+    static uint32_t data[ELEMENTS + 8];
+    VERIFY(PaUtil_WriteRingBuffer(&rb, data, ELEMENTS + 8) == ELEMENTS);
+    VERIFY(PaUtil_GetRingBufferReadAvailable(&rb) == ELEMENTS);
+    VERIFY(PaUtil_GetRingBufferWriteAvailable(&rb) == 0);
+    VERIFY(PaUtil_WriteRingBuffer(&rb, data, 1) == 0);
+    VERIFY(PaUtil_ReadRingBuffer(&rb, data, ELEMENTS + 8) == ELEMENTS);
+    VERIFY(PaUtil_GetRingBufferReadAvailable(&rb) == 0);
+    VERIFY(PaUtil_ReadRingBuffer(&rb, data, 1) == 0);
+}
+
+TEST("regions split exactly at the wrap point") {
+    uint32_t data[ELEMENTS];
+    void *p1, *p2;
+    ring_buffer_size_t s1, s2;
+
+    // Move both indices to 10 short of the end
+    PaUtil_WriteRingBuffer(&rb, data, ELEMENTS - 10);
+    PaUtil_ReadRingBuffer(&rb, data, ELEMENTS - 10);
+
+    VERIFY(PaUtil_GetRingBufferWriteRegions(&rb, 16, &p1, &s1, &p2, &s2) == 16);
+    VERIFY(p1 == &rbMem[ELEMENTS - 10] && s1 == 10);
+    VERIFY(p2 == &rbMem[0] && s2 == 6);
+    // The advance returns the new index, wrapped with the extra bit
+    VERIFY(PaUtil_AdvanceRingBufferWriteIndex(&rb, 16) == ELEMENTS + 6);
+
+    VERIFY(PaUtil_GetRingBufferReadRegions(&rb, 100, &p1, &s1, &p2, &s2) == 16);
+    VERIFY(p1 == &rbMem[ELEMENTS - 10] && s1 == 10);
+    VERIFY(p2 == &rbMem[0] && s2 == 6);
+
+    // Exactly reaching the end stays one region
+    PaUtil_AdvanceRingBufferReadIndex(&rb, 10);
+    VERIFY(PaUtil_GetRingBufferReadRegions(&rb, 6, &p1, &s1, &p2, &s2) == 6);
+    VERIFY(p1 == &rbMem[0] && s1 == 6 && p2 == NULL && s2 == 0);
+}
+
+TEST("random transfers match the reference FIFO") {
+    static uint32_t in[ELEMENTS], out[ELEMENTS], refOut[ELEMENTS];
+    unsigned i, j, n, w, r;
+    int ok = 1;
+
+    for (i = 0; (i < 100000) && ok; i++) {
+        n = rnd() % (ELEMENTS / 2);
+        if (rnd() & 1) {
+            for (j = 0; j < n; j++) {
+                in[j] = rnd();
+            }
+            w = PaUtil_WriteRingBuffer(&rb, in, n);
+            ok = (w == refWrite(in, n));
+        } else {
+            r = PaUtil_ReadRingBuffer(&rb, out, n);
+            ok = (r == refRead(refOut, n)) &&
+                (memcmp(out, refOut, r * sizeof(uint32_t)) == 0);
+        }
+        ok = ok && (PaUtil_GetRingBufferReadAvailable(&rb) ==
+            (ring_buffer_size_t)(refHead - refTail));
+    }
+    VERIFY(ok);
+}
+
+TEST("producer and consumer threads see every element in order") {
+    pthread_t t;
+    uint32_t next = 0, block[32];
+    ring_buffer_size_t n, i;
+    int ok = 1;
+
+    stop = 0;
+    pthread_create(&t, NULL, producer, NULL);
+    while (ok && (next < TRANSFERS)) {
+        n = PaUtil_ReadRingBuffer(&rb, block, 1 + next % 32);
+        for (i = 0; i < n; i++) {
+            ok = ok && (block[i] == next + i);
+        }
+        next += n;
+    }
+    stop = 1;
+    pthread_join(t, NULL);
+    VERIFY(ok);
+    VERIFY(PaUtil_GetRingBufferReadAvailable(&rb) == 0);
+}
+
+TEST("benchmarks") {
+    static uint32_t in[BLOCK], out[BLOCK], lin[BLOCK];
+    uint64_t ref, cut;
+
+    BENCH(ref, memcpy(lin, in, sizeof(in)); memcpy(out, lin, sizeof(out)));
+    BENCH(cut, PaUtil_WriteRingBuffer(&rb, in, BLOCK - 3);
+        PaUtil_ReadRingBuffer(&rb, out, BLOCK - 3));
+    bench_report("write+read block", ref, cut, BLOCK, "smp");
+    VERIFY(1);
+}
+
+} // TEST_GROUP()
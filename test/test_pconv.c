@@ -0,0 +1,320 @@
+// Partitioned convolver host tests.  Output is checked against a
+// direct time domain convolution in double, with the transforms done
+// at once and deferred to wait() as on the accelerator, and both are
+// benchmarked on a long impulse response.
+//
+// Build and run from the repository root:
+//   gcc -O2 -I test -I test/et -I test/host -I ALL/src/pconv
+//       test/test_pconv.c ALL/src/pconv/pconv.c
+//       test/et/et.c test/et/et_host.c -lm -o test_pconv && ./test_pconv
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "pconv.h"  // Code Under Test (CUT)
+#include "et.h"  // ET: embedded test
+#include "bench.h"
+
+#define CHANNELS    4
+#define MAX_TAPS    4096
+#define MAX_PARTS   PCONV_PARTS(MAX_TAPS)
+#define BLOCKS      80
+#define FRAMES      (BLOCKS * PCONV_BLOCK)
+
+static PCONV conv;
+static PCONV_SOFT_FFT soft;
+static PCONV_FFT fft;
+static float mem[PCONV_MEM_SIZE(MAX_PARTS, CHANNELS) / sizeof(float)];
+static float ir[CHANNELS][MAX_TAPS];
+static float in[FRAMES * CHANNELS];
+static float out[FRAMES * CHANNELS];
+static uint32_t seed;
+
+static uint32_t rnd(void) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed;
+}
+
+static float rndf(void) {
+    return (float)(int32_t)rnd() / 2147483648.0f;
+}
+
+// Backend that only runs a transform in wait(), one at a time
+typedef struct DEFER_FFT {
+    PCONV_FFT soft;
+    const void *in;
+    void *out;
+    int pending;            // 0 none, 1 rfft, -1 irfft
+    unsigned overlaps;      // Transforms started with one in flight
+    unsigned transforms;
+} DEFER_FFT;
+
+static DEFER_FFT defer;
+
+static void deferRfft(void *usr, const float *in, complex_float *out) {
+    DEFER_FFT *d = usr;
+    d->overlaps += (d->pending != 0);
+    d->in = in; d->out = out; d->pending = 1;
+}
+
+static void deferIrfft(void *usr, const complex_float *in, float *out) {
+    DEFER_FFT *d = usr;
+    d->overlaps += (d->pending != 0);
+    d->in = in; d->out = out; d->pending = -1;
+}
+
+static void deferWait(void *usr) {
+    DEFER_FFT *d = usr;
+    if (d->pending > 0) {
+        d->soft.rfft(d->soft.usr, d->in, d->out);
+    } else if (d->pending < 0) {
+        d->soft.irfft(d->soft.usr, d->in, d->out);
+    }
+    d->transforms += (d->pending != 0);
+    d->pending = 0;
+}
+
+static void deferInit(PCONV_FFT *f) {
+    memset(&defer, 0, sizeof(defer));
+    pconv_soft_fft_init(&soft, &defer.soft);
+    f->rfft = deferRfft;
+    f->irfft = deferIrfft;
+    f->wait = deferWait;
+    f->usr = &defer;
+}
+
+// Direct convolution of one interleaved channel
+static void refConv(const float *x, const float *h, unsigned taps,
+    float *y, unsigned channels, unsigned frames)
+{
+    unsigned n, k;
+    double acc;
+
+    for (n = 0; n < frames; n++) {
+        acc = 0.0;
+        for (k = 0; k < taps && k <= n; k++) {
+            acc += (double)h[k] * x[(n - k) * channels];
+        }
+        y[n * channels] = (float)acc;
+    }
+}
+
+static float maxErr(const float *a, const float *b, unsigned n) {
+    float e = 0.0f, d;
+    unsigned i;
+
+    for (i = 0; i < n; i++) {
+        d = fabsf(a[i] - b[i]);
+        if (d > e) {
+            e = d;
+        }
+    }
+    return e;
+}
+
+static void runBlocks(unsigned first, unsigned last, unsigned stride,
+    float *src, float *dst)
+{
+    unsigned b;
+
+    for (b = 0; b < BLOCKS; b++) {
+        pconv_process(&conv, first, last,
+            src + b * PCONV_BLOCK * stride + first,
+            dst + b * PCONV_BLOCK * stride + first, stride);
+    }
+}
+
+void setup(void) {
+    unsigned i, c;
+
+    seed = 0xC0FFEE;
+    for (i = 0; i < FRAMES * CHANNELS; i++) {
+        in[i] = rndf() * 0.5f;
+    }
+    for (c = 0; c < CHANNELS; c++) {
+        for (i = 0; i < MAX_TAPS; i++) {
+            ir[c][i] = rndf() * expf(-(float)i / 600.0f) * 0.1f;
+        }
+    }
+    memset(out, 0, sizeof(out));
+    pconv_soft_fft_init(&soft, &fft);
+}
+
+void teardown(void) {
+}
+
+// test group ----------------------------------------------------------------
+TEST_GROUP("pconv") {
+
+TEST("transform round trip") {
+    complex_float bins[PCONV_BINS];
+    float x[PCONV_FFT_SIZE], y[PCONV_FFT_SIZE];
+    unsigned i;
+
+    for (i = 0; i < PCONV_FFT_SIZE; i++) {
+        x[i] = rndf();
+    }
+    fft.rfft(fft.usr, x, bins);
+    fft.wait(fft.usr);
+    fft.irfft(fft.usr, bins, y);
+    fft.wait(fft.usr);
+    for (i = 0; i < PCONV_FFT_SIZE; i++) {
+        y[i] /= PCONV_FFT_SIZE;
+    }
+    VERIFY(maxErr(x, y, PCONV_FFT_SIZE) < 1e-5f);
+
+    // A unit impulse has a flat spectrum
+    memset(x, 0, sizeof(x));
+    x[0] = 1.0f;
+    fft.rfft(fft.usr, x, bins);
+    for (i = 0; i < PCONV_BINS; i++) {
+        VERIFY(fabsf(bins[i].re - 1.0f) < 1e-6f && fabsf(bins[i].im) < 1e-6f);
+    }
+}
+
+TEST("matches direct convolution on every channel") {
+    static float ref[FRAMES * CHANNELS];
+    static const unsigned taps[CHANNELS] = { 1, 64, 1000, MAX_TAPS };
+    unsigned c;
+
+    VERIFY(pconv_init(&conv, mem, sizeof(mem), CHANNELS, MAX_PARTS, &fft));
+    for (c = 0; c < CHANNELS; c++) {
+        VERIFY(pconv_set_ir(&conv, c, ir[c], taps[c]));
+        refConv(in + c, ir[c], taps[c], ref + c, CHANNELS, FRAMES);
+    }
+    runBlocks(0, CHANNELS, CHANNELS, in, out);
+    VERIFY(maxErr(out, ref, FRAMES * CHANNELS) < 1e-5f);
+}
+
+TEST("transforms deferred to wait() give the same output") {
+    static float ref[FRAMES * CHANNELS];
+    PCONV_FFT deferred;
+    unsigned c;
+
+    VERIFY(pconv_init(&conv, mem, sizeof(mem), CHANNELS, MAX_PARTS, &fft));
+    for (c = 0; c < CHANNELS; c++) {
+        pconv_set_ir(&conv, c, ir[c], 700 + c * 300);
+    }
+    runBlocks(0, CHANNELS, CHANNELS, in, ref);
+
+    deferInit(&deferred);
+    VERIFY(pconv_init(&conv, mem, sizeof(mem), CHANNELS, MAX_PARTS,
+        &deferred));
+    for (c = 0; c < CHANNELS; c++) {
+        pconv_set_ir(&conv, c, ir[c], 700 + c * 300);
+    }
+    defer.transforms = 0;
+    runBlocks(0, CHANNELS, CHANNELS, in, out);
+    VERIFY(memcmp(out, ref, sizeof(out)) == 0);
+    VERIFY(defer.overlaps == 0);
+    VERIFY(defer.transforms == 2 * CHANNELS * BLOCKS);
+}
+
+TEST("in place, channel subsets and pass through") {
+    static float ref[FRAMES * CHANNELS];
+    unsigned i, c;
+
+    VERIFY(pconv_init(&conv, mem, sizeof(mem), CHANNELS, MAX_PARTS, &fft));
+    pconv_set_ir(&conv, 1, ir[1], 300);
+    pconv_set_ir(&conv, 3, ir[3], 2000);
+    refConv(in + 1, ir[1], 300, ref + 1, CHANNELS, FRAMES);
+    refConv(in + 3, ir[3], 2000, ref + 3, CHANNELS, FRAMES);
+    for (i = 0; i < FRAMES; i++) {
+        ref[i * CHANNELS] = in[i * CHANNELS];
+        ref[i * CHANNELS + 2] = in[i * CHANNELS + 2];
+    }
+
+    // Two groups, as two DSP jobs would run them, in place
+    memcpy(out, in, sizeof(out));
+    for (i = 0; i < BLOCKS; i++) {
+        for (c = 0; c < CHANNELS; c += 2) {
+            float *p = out + i * PCONV_BLOCK * CHANNELS + c;
+            pconv_process(&conv, c, c + 2, p, p, CHANNELS);
+        }
+    }
+    VERIFY(maxErr(out, ref, FRAMES * CHANNELS) < 1e-5f);
+}
+
+TEST("loading a response clears its history") {
+    float x[PCONV_BLOCK], y[PCONV_BLOCK];
+    unsigned i;
+
+    VERIFY(pconv_init(&conv, mem, sizeof(mem), 1, MAX_PARTS, &fft));
+    pconv_set_ir(&conv, 0, ir[0], MAX_TAPS);
+    for (i = 0; i < PCONV_BLOCK; i++) {
+        x[i] = 1.0f;
+    }
+    pconv_process(&conv, 0, 1, x, y, 1);
+
+    // A unit impulse response and silence in, only silence out
+    memset(x, 0, sizeof(x));
+    x[0] = 1.0f;
+    pconv_set_ir(&conv, 0, x, 1);
+    memset(x, 0, sizeof(x));
+    pconv_process(&conv, 0, 1, x, y, 1);
+    for (i = 0; i < PCONV_BLOCK; i++) {
+        VERIFY(y[i] == 0.0f);
+    }
+}
+
+TEST("a response loaded a piece at a time is the same") {
+    static float ref[FRAMES * CHANNELS];
+    unsigned offset, len;
+
+    VERIFY(pconv_init(&conv, mem, sizeof(mem), 1, MAX_PARTS, &fft));
+    pconv_set_ir(&conv, 0, ir[0], 3000);
+    runBlocks(0, 1, 1, in, ref);
+
+    VERIFY(pconv_init(&conv, mem, sizeof(mem), 1, MAX_PARTS, &fft));
+    for (offset = 0; offset < 3000; offset += len) {
+        len = (3000 - offset < 256) ? 3000 - offset : 256;
+        VERIFY(pconv_load_ir(&conv, 0, offset, ir[0] + offset, len));
+        VERIFY(conv.chan[0].parts == 0);
+    }
+    pconv_set_taps(&conv, 0, 3000);
+    runBlocks(0, 1, 1, in, out);
+    VERIFY(memcmp(out, ref, FRAMES * sizeof(float)) == 0);
+
+    VERIFY(!pconv_load_ir(&conv, 0, 100, ir[0], 64));
+}
+
+TEST("limits") {
+    VERIFY(!pconv_init(&conv, mem, PCONV_MEM_SIZE(MAX_PARTS, CHANNELS) - 1,
+        CHANNELS, MAX_PARTS, &fft));
+    VERIFY(!pconv_init(&conv, mem, sizeof(mem), PCONV_MAX_CHANNELS + 1, 1,
+        &fft));
+    VERIFY(pconv_init(&conv, mem, sizeof(mem), CHANNELS, MAX_PARTS, &fft));
+    VERIFY(!pconv_set_ir(&conv, 0, ir[0], MAX_TAPS + 1));
+    VERIFY(conv.chan[0].parts == MAX_PARTS);
+    VERIFY(!pconv_set_ir(&conv, CHANNELS, ir[0], 1));
+}
+
+TEST("benchmarks") {
+    float x[PCONV_BLOCK];
+    uint64_t refNs, cutNs;
+    unsigned i;
+
+    for (i = 0; i < PCONV_BLOCK; i++) {
+        x[i] = in[i];
+    }
+    VERIFY(pconv_init(&conv, mem, sizeof(mem), 1, MAX_PARTS, &fft));
+    pconv_set_ir(&conv, 0, ir[0], MAX_TAPS);
+
+    // Time domain FIR, one block against the full response
+    BENCH(refNs,
+        for (i = 0; i < PCONV_BLOCK; i++) {
+            unsigned k;
+            float acc = 0.0f;
+            for (k = 0; k < MAX_TAPS; k++) {
+                acc += ir[0][k] * in[(i + MAX_TAPS - k) % (FRAMES)];
+            }
+            out[i] = acc;
+        });
+    BENCH(cutNs, pconv_process(&conv, 0, 1, x, x, 1));
+    bench_report("4096 tap FIR vs pconv", refNs, cutNs, PCONV_BLOCK, "smp");
+    VERIFY(1);
+}
+
+} // TEST_GROUP()
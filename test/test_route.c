@@ -0,0 +1,384 @@
+// routeAudio() bit-exact regression tests.  Golden vectors pin the
+// attenuation, mix and word size rules, a scalar reference covers random
+// route tables and both are benchmarked on a full system block.  The
+// float stream conversions are checked for round trips and saturation.
+//
+// Build and run from the repository root:
+//   gcc -O2 -I test -I test/et -I test/host -I ARM/src
+//       test/test_route.c ARM/src/route_audio.c
+//       test/et/et.c test/et/et_host.c -o test_route && ./test_route
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "route.h"  // Code Under Test (CUT)
+#include "et.h"  // ET: embedded test
+#include "bench.h"
+
+#define FRAMES      64
+#define MAX_CH      16
+#define NUM_ROUTES  8
+
+static STREAM_INFO streams[STREAM_ID_MAX];
+static int32_t bufs[STREAM_ID_MAX][FRAMES * MAX_CH];
+static int32_t refBufs[STREAM_ID_MAX][FRAMES * MAX_CH];
+static ROUTE_INFO routes[NUM_ROUTES];
+static uint32_t seed;
+
+static uint32_t rnd(void) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed;
+}
+
+static void addStream(STREAM_INFO *s, void *data, STREAM_ID id,
+    unsigned channels, unsigned wordSize, CLOCK_DOMAIN cd)
+{
+    s[id].streamID = id;
+    s[id].numChannels = channels;
+    s[id].numFrames = FRAMES;
+    s[id].wordSize = wordSize;
+    s[id].clockDomain = cd;
+    s[id].flush = false;
+    s[id].isFloat = false;
+    s[id].data = data;
+}
+
+static int32_t getSample(STREAM_INFO *s, unsigned frame, unsigned ch) {
+    if (s->wordSize == sizeof(int16_t)) {
+        return (int32_t)((int16_t *)s->data)[frame * s->numChannels + ch] << 16;
+    }
+    return ((int32_t *)s->data)[frame * s->numChannels + ch];
+}
+
+static void putSample(STREAM_INFO *s, unsigned frame, unsigned ch,
+    int32_t v, bool mix)
+{
+    if (s->wordSize == sizeof(int16_t)) {
+        int16_t *p = &((int16_t *)s->data)[frame * s->numChannels + ch];
+        *p = mix ? (int16_t)(*p + (v >> 16)) : (int16_t)(v >> 16);
+    } else {
+        int32_t *p = &((int32_t *)s->data)[frame * s->numChannels + ch];
+        *p = mix ? (int32_t)((uint32_t)*p + (uint32_t)v) : v;
+    }
+}
+
+// Straightforward per-sample statement of the routing rules
+static void refRouteAudio(CLOCK_DOMAIN cd, STREAM_INFO *s,
+    ROUTE_INFO *r, unsigned numRoutes)
+{
+    STREAM_INFO *src, *sink;
+    unsigned i, f, c;
+    int32_t v;
+
+    for (i = 0; i < numRoutes; i++) {
+        if ((r[i].srcID == STREAM_ID_UNKNOWN) ||
+            (r[i].sinkID == STREAM_ID_UNKNOWN)) {
+            continue;
+        }
+        src = &s[r[i].srcID]; sink = &s[r[i].sinkID];
+        if (!src->data || !sink->data ||
+            (src->clockDomain != cd) || (sink->clockDomain != cd) ||
+            (src->numFrames != sink->numFrames) ||
+            (r[i].srcOffset >= src->numChannels) ||
+            (r[i].sinkOffset >= sink->numChannels)) {
+            continue;
+        }
+        for (f = 0; f < src->numFrames; f++) {
+            for (c = 0; c < r[i].channels; c++) {
+                if (r[i].sinkOffset + c >= sink->numChannels) {
+                    continue;
+                }
+                v = (r[i].srcOffset + c < src->numChannels) ?
+                    getSample(src, f, r[i].srcOffset + c) : 0;
+                v >>= r[i].attenuation / 6;
+                putSample(sink, f, r[i].sinkOffset + c, v, r[i].mix);
+            }
+        }
+    }
+    for (i = 0; i < STREAM_ID_MAX; i++) {
+        if ((s[i].streamID != STREAM_ID_UNKNOWN) && (s[i].clockDomain == cd)) {
+            s[i].streamID = STREAM_ID_UNKNOWN;
+            s[i].data = NULL;
+        }
+    }
+}
+
+// Same random streams for the CUT and the reference
+static void randomGraph(STREAM_INFO *cut, STREAM_INFO *ref) {
+    static const STREAM_ID ids[] = {
+        STREAM_ID_CODEC_IN, STREAM_ID_CODEC_OUT, STREAM_ID_SPDIF_IN,
+        STREAM_ID_SPDIF_OUT, STREAM_ID_USB_RX, STREAM_ID_USB_TX,
+        STREAM_ID_WAV_SRC, STREAM_ID_WAV_SINK
+    };
+    unsigned i, ch, ws;
+    CLOCK_DOMAIN cd;
+
+    memset(cut, 0, sizeof(streams));
+    memset(ref, 0, sizeof(streams));
+    for (i = 0; i < ARRAY_NELEM(ids); i++) {
+        ch = 1 + rnd() % MAX_CH;
+        ws = (rnd() & 1) ? sizeof(int16_t) : sizeof(int32_t);
+        cd = (rnd() % 4) ? CLOCK_DOMAIN_SYSTEM : CLOCK_DOMAIN_A2B;
+        addStream(cut, bufs[ids[i]], ids[i], ch, ws, cd);
+        addStream(ref, refBufs[ids[i]], ids[i], ch, ws, cd);
+    }
+    for (i = 0; i < NUM_ROUTES; i++) {
+        routes[i].srcID = ids[rnd() % ARRAY_NELEM(ids)];
+        routes[i].sinkID = ids[rnd() % ARRAY_NELEM(ids)];
+        routes[i].srcOffset = rnd() % MAX_CH;
+        routes[i].sinkOffset = rnd() % MAX_CH;
+        routes[i].channels = 1 + rnd() % MAX_CH;
+        routes[i].attenuation = (rnd() % 8) * 6;
+        routes[i].mix = rnd() & 1;
+    }
+}
+
+void setup(void) {
+    unsigned i, j;
+    seed = 0xC0FFEE;
+    memset(streams, 0, sizeof(streams));
+    memset(routes, 0, sizeof(routes));
+    for (i = 0; i < STREAM_ID_MAX; i++) {
+        for (j = 0; j < FRAMES * MAX_CH; j++) {
+            bufs[i][j] = (int32_t)rnd();
+        }
+    }
+    memcpy(refBufs, bufs, sizeof(bufs));
+}
+
+void teardown(void) {
+}
+
+// test group ----------------------------------------------------------------
+TEST_GROUP("route") {
+
+TEST("16-bit source to 32-bit sink with attenuation") {
+    int16_t in[FRAMES * 2];
+    int32_t out[FRAMES * 2];
+    unsigned f;
+
+    for (f = 0; f < FRAMES; f++) {
+        in[f * 2] = 0x4000; in[f * 2 + 1] = -0x4000;
+    }
+    memset(out, 0, sizeof(out));
+    addStream(streams, in, STREAM_ID_USB_RX, 2, 2, CLOCK_DOMAIN_SYSTEM);
+    addStream(streams, out, STREAM_ID_CODEC_OUT, 2, 4, CLOCK_DOMAIN_SYSTEM);
+    routes[0] = (ROUTE_INFO){ STREAM_ID_USB_RX, STREAM_ID_CODEC_OUT,
+        0, 0, 2, 6, 0 };
+    routeAudio(CLOCK_DOMAIN_SYSTEM, streams, STREAM_ID_MAX, routes, 1);
+    VERIFY(out[0] == 0x20000000);
+    VERIFY(out[1] == -0x20000000);
+    VERIFY(out[FRAMES * 2 - 1] == -0x20000000);
+    VERIFY(streams[STREAM_ID_USB_RX].data == NULL);
+    VERIFY(streams[STREAM_ID_CODEC_OUT].streamID == STREAM_ID_UNKNOWN);
+}
+
+TEST("offsets, mix and missing source channels") {
+    int32_t in[FRAMES * 2];
+    int16_t out[FRAMES * 4];
+    unsigned f;
+
+    for (f = 0; f < FRAMES; f++) {
+        in[f * 2] = 0x10000000; in[f * 2 + 1] = 0x20000000;
+        out[f * 4] = 1; out[f * 4 + 1] = 1; out[f * 4 + 2] = 1;
+        out[f * 4 + 3] = 1;
+    }
+    addStream(streams, in, STREAM_ID_WAV_SRC, 2, 4, CLOCK_DOMAIN_SYSTEM);
+    addStream(streams, out, STREAM_ID_USB_TX, 4, 2, CLOCK_DOMAIN_SYSTEM);
+    // src ch 1 and a missing ch 2 mixed into sink ch 2..3
+    routes[0] = (ROUTE_INFO){ STREAM_ID_WAV_SRC, STREAM_ID_USB_TX,
+        1, 2, 4, 0, 1 };
+    routeAudio(CLOCK_DOMAIN_SYSTEM, streams, STREAM_ID_MAX, routes, 1);
+    VERIFY(out[0] == 1 && out[1] == 1);
+    VERIFY(out[2] == 0x2001);
+    VERIFY(out[3] == 1);
+}
+
+TEST("routes outside the clock domain are left alone") {
+    int32_t in[FRAMES], out[FRAMES];
+
+    memset(in, 0x11, sizeof(in));
+    memset(out, 0, sizeof(out));
+    addStream(streams, in, STREAM_ID_A2B_IN, 1, 4, CLOCK_DOMAIN_A2B);
+    addStream(streams, out, STREAM_ID_CODEC_OUT, 1, 4, CLOCK_DOMAIN_SYSTEM);
+    routes[0] = (ROUTE_INFO){ STREAM_ID_A2B_IN, STREAM_ID_CODEC_OUT,
+        0, 0, 1, 0, 0 };
+    routeAudio(CLOCK_DOMAIN_SYSTEM, streams, STREAM_ID_MAX, routes, 1);
+    VERIFY(out[0] == 0);
+    VERIFY(streams[STREAM_ID_A2B_IN].data == in);
+    VERIFY(streams[STREAM_ID_CODEC_OUT].data == NULL);
+}
+
+TEST("routing in two passes by sink") {
+    int32_t in[FRAMES], toDsp[FRAMES], fromDsp[FRAMES], out[FRAMES];
+    const uint32_t mask = 1u << STREAM_ID_SHARC0_IN;
+
+    memset(in, 0x11, sizeof(in));
+    memset(toDsp, 0, sizeof(toDsp));
+    memset(fromDsp, 0x22, sizeof(fromDsp));
+    memset(out, 0, sizeof(out));
+    addStream(streams, in, STREAM_ID_CODEC_IN, 1, 4, CLOCK_DOMAIN_SYSTEM);
+    addStream(streams, toDsp, STREAM_ID_SHARC0_IN, 1, 4, CLOCK_DOMAIN_SYSTEM);
+    addStream(streams, NULL, STREAM_ID_SHARC0_OUT, 1, 4, CLOCK_DOMAIN_SYSTEM);
+    addStream(streams, out, STREAM_ID_CODEC_OUT, 1, 4, CLOCK_DOMAIN_SYSTEM);
+    routes[0] = (ROUTE_INFO){ STREAM_ID_SHARC0_OUT, STREAM_ID_CODEC_OUT,
+        0, 0, 1, 0, 0 };
+    routes[1] = (ROUTE_INFO){ STREAM_ID_CODEC_IN, STREAM_ID_SHARC0_IN,
+        0, 0, 1, 0, 0 };
+
+    // Only the route into the DSP, the streams stay for the second pass
+    routeAudioSinks(CLOCK_DOMAIN_SYSTEM, streams, STREAM_ID_MAX, routes, 2,
+        mask, true);
+    VERIFY(toDsp[FRAMES - 1] == 0x11111111);
+    VERIFY(out[0] == 0);
+    VERIFY(streams[STREAM_ID_CODEC_IN].data == in);
+
+    // The DSP output turns up in between
+    streams[STREAM_ID_SHARC0_OUT].data = fromDsp;
+    routeAudioSinks(CLOCK_DOMAIN_SYSTEM, streams, STREAM_ID_MAX, routes, 2,
+        mask, false);
+    VERIFY(out[FRAMES - 1] == 0x22222222);
+    routeAudioRelease(CLOCK_DOMAIN_SYSTEM, streams, STREAM_ID_MAX);
+    VERIFY(streams[STREAM_ID_SHARC0_OUT].data == NULL);
+}
+
+TEST("random route tables match the reference") {
+    STREAM_INFO ref[STREAM_ID_MAX];
+    unsigned n, i;
+    int ok = 1;
+
+    for (n = 0; n < 500 && ok; n++) {
+        randomGraph(streams, ref);
+        routeAudio(CLOCK_DOMAIN_SYSTEM, streams, STREAM_ID_MAX,
+            routes, NUM_ROUTES);
+        refRouteAudio(CLOCK_DOMAIN_SYSTEM, ref, routes, NUM_ROUTES);
+        ok = (memcmp(bufs, refBufs, sizeof(bufs)) == 0);
+        for (i = 0; i < STREAM_ID_MAX; i++) {
+            ok = ok && (streams[i].streamID == ref[i].streamID) &&
+                ((streams[i].data == NULL) == (ref[i].data == NULL));
+        }
+    }
+    VERIFY(ok);
+}
+
+TEST("16-bit audio through a float stream is bit-exact") {
+    int16_t in[FRAMES * 2], out[FRAMES * 2];
+    float dsp[FRAMES * 2];
+    unsigned i;
+
+    for (i = 0; i < FRAMES * 2; i++) {
+        in[i] = (int16_t)rnd();
+    }
+    in[0] = INT16_MIN; in[1] = INT16_MAX;
+    memset(out, 0, sizeof(out));
+    addStream(streams, in, STREAM_ID_CODEC_IN, 2, 2, CLOCK_DOMAIN_SYSTEM);
+    addStream(streams, dsp, STREAM_ID_SHARC0_IN, 2, 4, CLOCK_DOMAIN_SYSTEM);
+    streams[STREAM_ID_SHARC0_IN].isFloat = true;
+    routes[0] = (ROUTE_INFO){ STREAM_ID_CODEC_IN, STREAM_ID_SHARC0_IN,
+        0, 0, 2, 0, 0 };
+    routeAudio(CLOCK_DOMAIN_SYSTEM, streams, STREAM_ID_MAX, routes, 1);
+    VERIFY(dsp[0] == -1.0f);
+    VERIFY(dsp[1] == 32767.0f / 32768.0f);
+
+    // Back out through the DSP output as if passed straight through
+    addStream(streams, dsp, STREAM_ID_SHARC0_OUT, 2, 4, CLOCK_DOMAIN_SYSTEM);
+    addStream(streams, out, STREAM_ID_CODEC_OUT, 2, 2, CLOCK_DOMAIN_SYSTEM);
+    streams[STREAM_ID_SHARC0_OUT].isFloat = true;
+    routes[0] = (ROUTE_INFO){ STREAM_ID_SHARC0_OUT, STREAM_ID_CODEC_OUT,
+        0, 0, 2, 0, 0 };
+    routeAudio(CLOCK_DOMAIN_SYSTEM, streams, STREAM_ID_MAX, routes, 1);
+    VERIFY(memcmp(in, out, sizeof(in)) == 0);
+}
+
+TEST("float mixes keep headroom, fixed point sinks saturate") {
+    int32_t a[FRAMES], b[FRAMES], out[FRAMES];
+    float dsp[FRAMES];
+    unsigned f;
+
+    for (f = 0; f < FRAMES; f++) {
+        a[f] = 0x60000000; b[f] = (f & 1) ? -0x60000000 : 0x60000000;
+        out[f] = (f & 1) ? -0x60000000 : 0x60000000;
+    }
+    addStream(streams, a, STREAM_ID_CODEC_IN, 1, 4, CLOCK_DOMAIN_SYSTEM);
+    addStream(streams, b, STREAM_ID_USB_RX, 1, 4, CLOCK_DOMAIN_SYSTEM);
+    addStream(streams, dsp, STREAM_ID_SHARC0_IN, 1, 4, CLOCK_DOMAIN_SYSTEM);
+    streams[STREAM_ID_SHARC0_IN].isFloat = true;
+    routes[0] = (ROUTE_INFO){ STREAM_ID_CODEC_IN, STREAM_ID_SHARC0_IN,
+        0, 0, 1, 0, 0 };
+    routes[1] = (ROUTE_INFO){ STREAM_ID_USB_RX, STREAM_ID_SHARC0_IN,
+        0, 0, 1, 0, 1 };
+    routeAudio(CLOCK_DOMAIN_SYSTEM, streams, STREAM_ID_MAX, routes, 2);
+    VERIFY(dsp[0] == 1.5f);
+    VERIFY(dsp[1] == 0.0f);
+
+    // +1.5 mixed over +0.75 and 0.0 over -0.75, clipped not wrapped
+    addStream(streams, dsp, STREAM_ID_SHARC0_OUT, 1, 4, CLOCK_DOMAIN_SYSTEM);
+    addStream(streams, out, STREAM_ID_CODEC_OUT, 1, 4, CLOCK_DOMAIN_SYSTEM);
+    streams[STREAM_ID_SHARC0_OUT].isFloat = true;
+    routes[0] = (ROUTE_INFO){ STREAM_ID_SHARC0_OUT, STREAM_ID_CODEC_OUT,
+        0, 0, 1, 0, 1 };
+    routeAudio(CLOCK_DOMAIN_SYSTEM, streams, STREAM_ID_MAX, routes, 1);
+    VERIFY(out[0] == INT32_MAX);
+    VERIFY(out[1] == -0x60000000);
+
+    // Full scale negative and beyond
+    for (f = 0; f < FRAMES; f++) {
+        dsp[f] = (f & 1) ? -1.0f : -4.0f;
+    }
+    addStream(streams, dsp, STREAM_ID_SHARC0_OUT, 1, 4, CLOCK_DOMAIN_SYSTEM);
+    addStream(streams, out, STREAM_ID_CODEC_OUT, 1, 4, CLOCK_DOMAIN_SYSTEM);
+    streams[STREAM_ID_SHARC0_OUT].isFloat = true;
+    routes[0].mix = 0;
+    routeAudio(CLOCK_DOMAIN_SYSTEM, streams, STREAM_ID_MAX, routes, 1);
+    VERIFY(out[0] == INT32_MIN);
+    VERIFY(out[1] == INT32_MIN);
+}
+
+TEST("benchmarks") {
+    STREAM_INFO ref[STREAM_ID_MAX];
+    uint64_t refNs, cutNs;
+    unsigned i;
+
+    for (i = 0; i < NUM_ROUTES; i++) {
+        routes[i] = (ROUTE_INFO){ STREAM_ID_CODEC_IN + (i & 1),
+            STREAM_ID_USB_TX, 0, 0, MAX_CH, 6, i > 0 };
+    }
+    BENCH(refNs,
+        memset(ref, 0, sizeof(ref));
+        addStream(ref, refBufs[0], STREAM_ID_CODEC_IN, MAX_CH, 4, 0);
+        addStream(ref, refBufs[1], STREAM_ID_CODEC_OUT, MAX_CH, 2, 0);
+        addStream(ref, refBufs[2], STREAM_ID_USB_TX, MAX_CH, 4, 0);
+        refRouteAudio(CLOCK_DOMAIN_SYSTEM, ref, routes, NUM_ROUTES));
+    BENCH(cutNs,
+        memset(streams, 0, sizeof(streams));
+        addStream(streams, bufs[0], STREAM_ID_CODEC_IN, MAX_CH, 4, 0);
+        addStream(streams, bufs[1], STREAM_ID_CODEC_OUT, MAX_CH, 2, 0);
+        addStream(streams, bufs[2], STREAM_ID_USB_TX, MAX_CH, 4, 0);
+        routeAudio(CLOCK_DOMAIN_SYSTEM, streams, STREAM_ID_MAX,
+            routes, NUM_ROUTES));
+    bench_report("routeAudio 8 routes x 16ch", refNs, cutNs,
+        FRAMES * MAX_CH * NUM_ROUTES, "smp");
+
+    // Fixed point routes against the same routes into a float stream
+    BENCH(refNs,
+        memset(streams, 0, sizeof(streams));
+        addStream(streams, bufs[0], STREAM_ID_CODEC_IN, MAX_CH, 4, 0);
+        addStream(streams, bufs[1], STREAM_ID_CODEC_OUT, MAX_CH, 2, 0);
+        addStream(streams, bufs[2], STREAM_ID_USB_TX, MAX_CH, 4, 0);
+        routeAudio(CLOCK_DOMAIN_SYSTEM, streams, STREAM_ID_MAX,
+            routes, NUM_ROUTES));
+    BENCH(cutNs,
+        memset(streams, 0, sizeof(streams));
+        addStream(streams, bufs[0], STREAM_ID_CODEC_IN, MAX_CH, 4, 0);
+        addStream(streams, bufs[1], STREAM_ID_CODEC_OUT, MAX_CH, 2, 0);
+        addStream(streams, bufs[2], STREAM_ID_USB_TX, MAX_CH, 4, 0);
+        streams[STREAM_ID_USB_TX].isFloat = true;
+        routeAudio(CLOCK_DOMAIN_SYSTEM, streams, STREAM_ID_MAX,
+            routes, NUM_ROUTES));
+    bench_report("routeAudio int32 vs float", refNs, cutNs,
+        FRAMES * MAX_CH * NUM_ROUTES, "smp");
+    VERIFY(1);
+}
+
+} // TEST_GROUP()
@@ -0,0 +1,192 @@
+// SHARC DSP job scheduler host tests.  Plans are checked against an
+// exhaustive search of all 2^IPC_DSP_JOBS assignments, and the
+// hysteresis and overload rules against hand built loads.
+//
+// Build and run from the repository root:
+//   gcc -O2 -I test/et -I test/host -I ALL/include -I ALL/src/sae
+//       -I ALL/src/trace-log -I ARM/src
+//       test/test_sharc_sched.c ARM/src/sharc_sched.c
+//       test/et/et.c test/et/et_host.c -o test_sharc_sched && ./test_sharc_sched
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sharc_sched.h"  // Code Under Test (CUT)
+#include "et.h"  // ET: embedded test
+
+#define BUDGET  600000
+
+static SHARC_SCHED sched;
+static uint32_t seed;
+
+static uint32_t rnd(void) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed;
+}
+
+// Costs as if reported by the cores under the current plan
+static void report(SHARC_SCHED *s, const uint32_t *cost)
+{
+    uint32_t jobCycles[2][IPC_DSP_JOBS];
+    unsigned job, core;
+
+    memset(jobCycles, 0, sizeof(jobCycles));
+    for (job = 0; job < IPC_DSP_JOBS; job++) {
+        core = (sharc_sched_plan(s) >> job) & 1;
+        jobCycles[core][job] = cost[job];
+    }
+    sharc_sched_cycles(s, jobCycles[0]);
+    sharc_sched_cycles(s, jobCycles[1]);
+}
+
+static uint32_t bestCost(SHARC_SCHED *s)
+{
+    uint32_t best = UINT32_MAX;
+    uint32_t plan, c;
+
+    for (plan = 0; plan < (1u << IPC_DSP_JOBS); plan++) {
+        c = sharc_sched_cost(s, plan, NULL);
+        if (c < best) {
+            best = c;
+        }
+    }
+    return best;
+}
+
+void setup(void) {
+    memset(&sched, 0, sizeof(sched));
+}
+
+void teardown(void) {
+}
+
+// test group ----------------------------------------------------------------
+TEST_GROUP("sharc_sched") {
+
+TEST("disabled runs the home plan") {
+    uint32_t cost[IPC_DSP_JOBS] = { 90000, 90000, 90000, 90000, 0, 0, 0, 0 };
+
+    sharc_sched_init(&sched, BUDGET);
+    report(&sched, cost);
+    VERIFY(!sharc_sched_balance(&sched));
+    VERIFY(sharc_sched_plan(&sched) == IPC_DSP_HOME_PLAN);
+    VERIFY(sharc_sched_cores(IPC_DSP_HOME_PLAN, 0) == 1);
+    VERIFY(sharc_sched_cores(IPC_DSP_HOME_PLAN, 1) == 2);
+}
+
+TEST("one busy node is split across both cores") {
+    uint32_t cost[IPC_DSP_JOBS] = { 90000, 90000, 90000, 90000, 0, 0, 0, 0 };
+    uint32_t load[2];
+    uint32_t plan;
+
+    sharc_sched_init(&sched, BUDGET);
+    sharc_sched_enable(&sched, true);
+    report(&sched, cost);
+    VERIFY(sharc_sched_balance(&sched));
+    plan = sharc_sched_plan(&sched);
+    sharc_sched_cost(&sched, plan, load);
+    VERIFY(load[0] == 180000);
+    VERIFY(load[1] == 180000);
+    VERIFY(sharc_sched_cores(plan, 0) == 3);
+    VERIFY(sched.rebalances == 1);
+
+    // Reports under the new plan change nothing
+    report(&sched, cost);
+    VERIFY(!sharc_sched_balance(&sched));
+    VERIFY(sharc_sched_plan(&sched) == plan);
+}
+
+TEST("small gains are held off by the hysteresis") {
+    uint32_t cost[IPC_DSP_JOBS] = {
+        50000, 50000, 50000, 50000, 40000, 40000, 40000, 40000 };
+
+    // Home is 200k/160k, the best split 180k/180k is only 10% better
+    sharc_sched_init(&sched, BUDGET);
+    sharc_sched_enable(&sched, true);
+    report(&sched, cost);
+    VERIFY(!sharc_sched_balance(&sched));
+    VERIFY(sharc_sched_plan(&sched) == IPC_DSP_HOME_PLAN);
+}
+
+TEST("an overloaded core is always relieved") {
+    uint32_t cost[IPC_DSP_JOBS] = {
+        150000, 150000, 150000, 150000, 120000, 120000, 120000, 120000 };
+    uint32_t load[2];
+
+    // SHARC0 would need 100% of a block, the split keeps both under 90%
+    sharc_sched_init(&sched, BUDGET);
+    sharc_sched_enable(&sched, true);
+    report(&sched, cost);
+    VERIFY(sharc_sched_balance(&sched));
+    sharc_sched_cost(&sched, sharc_sched_plan(&sched), load);
+    VERIFY(load[0] == 540000);
+    VERIFY(load[1] == 540000);
+}
+
+TEST("disabling goes back home") {
+    uint32_t cost[IPC_DSP_JOBS] = { 90000, 90000, 90000, 90000, 0, 0, 0, 0 };
+
+    sharc_sched_init(&sched, BUDGET);
+    sharc_sched_enable(&sched, true);
+    report(&sched, cost);
+    VERIFY(sharc_sched_balance(&sched));
+    sharc_sched_enable(&sched, false);
+    VERIFY(sharc_sched_plan(&sched) == IPC_DSP_HOME_PLAN);
+    VERIFY(!sharc_sched_balance(&sched));
+}
+
+TEST("pinned nodes stay home") {
+    uint32_t cost[IPC_DSP_JOBS] = { 90000, 90000, 90000, 90000, 0, 0, 0, 0 };
+    uint32_t load[2];
+
+    sharc_sched_init(&sched, BUDGET);
+    sharc_sched_enable(&sched, true);
+    report(&sched, cost);
+    VERIFY(sharc_sched_balance(&sched));
+    VERIFY(sharc_sched_cores(sharc_sched_plan(&sched), 0) == 3);
+
+    // Pinning moves node 0 straight back and balancing leaves it there
+    sharc_sched_pin(&sched, 0, true);
+    VERIFY(sharc_sched_cores(sharc_sched_plan(&sched), 0) == 1);
+    report(&sched, cost);
+    VERIFY(!sharc_sched_balance(&sched));
+    sharc_sched_cost(&sched, sharc_sched_plan(&sched), load);
+    VERIFY(load[0] == 360000);
+
+    // Node 1 is still free to take load, then node 0 is let go again
+    cost[4] = 200000;
+    report(&sched, cost);
+    sharc_sched_balance(&sched);
+    VERIFY((sharc_sched_plan(&sched) & IPC_DSP_NODE_MASK(0)) == 0);
+    sharc_sched_pin(&sched, 0, false);
+    VERIFY(sharc_sched_balance(&sched));
+    VERIFY(sharc_sched_cores(sharc_sched_plan(&sched), 0) == 3);
+}
+
+TEST("random loads land near the best plan") {
+    uint32_t cost[IPC_DSP_JOBS];
+    uint32_t best, got;
+    unsigned i, job;
+
+    seed = 7;
+    for (i = 0; i < 200; i++) {
+        for (job = 0; job < IPC_DSP_JOBS; job++) {
+            cost[job] = rnd() % 150000;
+        }
+        sharc_sched_init(&sched, BUDGET);
+        sharc_sched_enable(&sched, true);
+        report(&sched, cost);
+        sharc_sched_balance(&sched);
+        best = bestCost(&sched);
+        got = sharc_sched_cost(&sched, sharc_sched_plan(&sched), NULL);
+
+        // Longest first is within 7/6 of optimal on two cores, and
+        // only the hysteresis keeps a worse plan
+        VERIFY((uint64_t)got * 6 <= (uint64_t)best * 7 ||
+            sharc_sched_plan(&sched) == IPC_DSP_HOME_PLAN);
+        VERIFY(got <= sharc_sched_cost(&sched, IPC_DSP_HOME_PLAN, NULL));
+    }
+}
+
+} // TEST_GROUP()
@@ -0,0 +1,148 @@
+// Binary trace log host test.  The concurrent test hammers one log from
+// several writer threads while a reader drains it, the same pattern as
+// nested ISRs on the ARM.
+//
+// Build and run from the repository root:
+//   gcc -I test/et -I ALL/include -I ALL/src/trace-log
+//       -D'TRACE_LOG_TIMESTAMP()=0' -pthread
+//       test/test_trace_log.c ALL/src/trace-log/trace_log.c
+//       test/et/et.c test/et/et_host.c -o test_trace_log && ./test_trace_log
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "trace_log.h"  // Code Under Test (CUT)
+#include "et.h"  // ET: embedded test
+
+#define ENTRIES     64
+#define WRITERS     4
+#define WRITES      200000
+
+static uint64_t logMem[TRACE_LOG_SIZE(ENTRIES) / sizeof(uint64_t) + 1];
+static TRACE_LOG *log;
+static volatile int writersDone;
+
+static void *writer(void *arg) {
+    uint32_t w = (uint32_t)(uintptr_t)arg;
+    uint32_t i;
+    for (i = 0; i < WRITES; i++) {
+        TRACE_LOG3(TRACE_ID_RTP_RX_OVERFLOW, w, i, ~i);
+    }
+    __atomic_fetch_add(&writersDone, 1, __ATOMIC_SEQ_CST);
+    return NULL;
+}
+
+void setup(void) {
+    log = trace_log_init(logMem, ENTRIES, 0);
+}
+
+void teardown(void) {
+}
+
+// test group ----------------------------------------------------------------
+TEST_GROUP("trace_log") {
+
+TEST("init rejects sizes that are not a power of 2") {
+    VERIFY(trace_log_init(logMem, 48, 0) == NULL);
+    VERIFY(trace_log_init(logMem, 0, 0) == NULL);
+    VERIFY(log != NULL);
+    VERIFY(trace_log_get(0) == log);
+}
+
+TEST("entries read back in order and format lazily") {
+    TRACE_LOG_ENTRY e;
+    char buf[128];
+
+    TRACE_LOG2(TRACE_ID_WAV_SRC_UNDERFLOW, 12, 128);
+    TRACE_LOG1(TRACE_ID_RTP_TX_OVERFLOW, 7);
+    VERIFY(trace_log_read(log, &e));
+    VERIFY(e.id == TRACE_ID_WAV_SRC_UNDERFLOW);
+    VERIFY(e.nargs == 2);
+    trace_log_format(&e, buf, sizeof(buf));
+    VERIFY(strcmp(buf, "WAV src underflow, level 12 of 128") == 0);
+    VERIFY(trace_log_read(log, &e));
+    trace_log_format(&e, buf, sizeof(buf));
+    VERIFY(strcmp(buf, "RTP tx overflow, free 7") == 0);
+    VERIFY(!trace_log_read(log, &e));
+    VERIFY(log->lost == 0);
+}
+
+TEST("a full log overwrites the oldest entries") {
+    TRACE_LOG_ENTRY e;
+    uint32_t i;
+
+    for (i = 0; i < ENTRIES + 10; i++) {
+        TRACE_LOG1(TRACE_ID_RTP_TX_OVERFLOW, i);
+    }
+    VERIFY(trace_log_read(log, &e));
+    VERIFY(e.args[0] == 10);
+    VERIFY(log->lost == 10);
+    for (i = 11; i < ENTRIES + 10; i++) {
+        VERIFY(trace_log_read(log, &e));
+        VERIFY(e.args[0] == i);
+    }
+    VERIFY(!trace_log_read(log, &e));
+}
+
+TEST("reader stops at an entry still being written") {
+    TRACE_LOG_ENTRY e;
+
+    TRACE_LOG1(TRACE_ID_RTP_TX_OVERFLOW, 1);
+    log->entry[0].seq = 0;
+    VERIFY(!trace_log_read(log, &e));
+    log->entry[0].seq = 1;
+    VERIFY(trace_log_read(log, &e));
+}
+
+TEST("attach validates the log header") {
+    TRACE_LOG bad;
+    memset(&bad, 0, sizeof(bad));
+    VERIFY(!trace_log_attach(&bad));
+    bad.magic = TRACE_LOG_MAGIC;
+    bad.core = TRACE_LOG_MAX_CORES;
+    VERIFY(!trace_log_attach(&bad));
+    VERIFY(trace_log_get(TRACE_LOG_MAX_CORES) == NULL);
+}
+
+TEST("concurrent writers never corrupt or reorder entries") {
+    pthread_t t[WRITERS];
+    uint32_t next[WRITERS];
+    uint32_t reads = 0;
+    TRACE_LOG_ENTRY e;
+    int ok = 1;
+    uintptr_t w;
+
+    memset(next, 0, sizeof(next));
+    writersDone = 0;
+    for (w = 0; w < WRITERS; w++) {
+        pthread_create(&t[w], NULL, writer, (void *)w);
+    }
+    while (ok) {
+        if (!trace_log_read(log, &e)) {
+            if (writersDone == WRITERS) {
+                break;
+            }
+            continue;
+        }
+        reads++;
+        // Each writer's own entries stay in order and intact
+        ok = (e.id == TRACE_ID_RTP_RX_OVERFLOW) && (e.args[0] < WRITERS) &&
+            (e.args[2] == ~e.args[1]) && (e.args[1] >= next[e.args[0]]);
+        if (ok) {
+            next[e.args[0]] = e.args[1] + 1;
+        }
+    }
+    for (w = 0; w < WRITERS; w++) {
+        pthread_join(t[w], NULL);
+    }
+    while (ok && trace_log_read(log, &e)) {
+        reads++;
+    }
+    VERIFY(ok);
+    VERIFY(reads > 0);
+    VERIFY(reads + log->lost == WRITERS * WRITES);
+}
+
+} // TEST_GROUP()
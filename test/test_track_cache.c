@@ -0,0 +1,383 @@
+// SDRAM track cache tests.  Host files stand in for the SD card and the
+// FreeRTOS mutexes are single threaded stubs.  Every read through the
+// cache is checked against the file bytes, whether it hits or misses.
+// Queued preloads, read-ahead wrapping and the eviction order are
+// checked through the hit/miss/load counters, and readWave() through the
+// cache is compared with the plain fread() path.  The cost of a random
+// access read from a resident track is reported against fseek()+fread().
+//
+// The cache instance lives for the whole run, so each test uses its own
+// files and leaves nothing open or queued behind.
+//
+// Build and run from the repository root:
+//   gcc -O2 -I test -I test/et -I test/host -I ARM/include -I ALL/include
+//       -I ARM/src/oss-services/FreeRTOS-ARM/include
+//       -I ARM/src/oss-services/umm_malloc -I ARM/src/simple-services/sched-trace
+//       -I ARM/src/simple-services/wav-file -I ARM/src/simple-services/flac-dec
+//       -I ARM/src/simple-services/track-cache
+//       test/test_track_cache.c ARM/src/simple-services/track-cache/track_cache.c
+//       ARM/src/simple-services/wav-file/wav_file.c
+//       ARM/src/simple-services/flac-dec/flac_dec.c
+//       test/et/et.c test/et/et_host.c -o test_track_cache && ./test_track_cache
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+#include "track_cache.h"  // Code Under Test (CUT)
+#include "track_cache_cfg.h"
+#include "wav_file.h"
+#include "umm_malloc.h"
+#include "et.h"  // ET: embedded test
+#include "bench.h"
+
+#define REGION      TRACK_CACHE_REGION_SIZE
+#define CACHE_REGIONS   (TRACK_CACHE_SIZE / TRACK_CACHE_REGION_SIZE)
+#define MAX_OPEN    2
+
+static TRACK_CACHE_TRACK *opened[MAX_OPEN];
+static TRACK_CACHE_STATS before;
+static WAV_FILE wf, wfRef;
+static uint8_t buf[2 * REGION + 100];
+static uint32_t seed;
+
+// Single threaded, the locks only have to exist
+QueueHandle_t xQueueCreateMutex(const uint8_t ucQueueType) {
+    static int dummy;
+    (void)ucQueueType;
+    return (QueueHandle_t)&dummy;
+}
+
+BaseType_t xQueueSemaphoreTake(QueueHandle_t xQueue, TickType_t xTicksToWait) {
+    (void)xQueue; (void)xTicksToWait;
+    return pdTRUE;
+}
+
+BaseType_t xQueueGenericSend(QueueHandle_t xQueue, const void * const pvItemToQueue,
+    TickType_t xTicksToWait, const BaseType_t xCopyPosition) {
+    (void)xQueue; (void)pvItemToQueue; (void)xTicksToWait; (void)xCopyPosition;
+    return pdTRUE;
+}
+
+// track_cache_cfg.h and wav_file_cfg.h allocate from the umm heaps
+void *umm_calloc_aligned(size_t num, size_t item_size, size_t alignment) {
+    (void)alignment;
+    return calloc(num, item_size);
+}
+
+void umm_free_aligned(void *ptr) {
+    free(ptr);
+}
+
+void *umm_calloc_heap(umm_heap_t heap, size_t num, size_t size) {
+    (void)heap;
+    return calloc(num, size);
+}
+
+void umm_free_heap(umm_heap_t heap, void *ptr) {
+    (void)heap;
+    free(ptr);
+}
+
+// helpers -------------------------------------------------------------------
+static uint32_t rnd(void) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed;
+}
+
+// File contents depend on the name so a stale track can't pass a check
+static uint8_t byteAt(const char *fname, uint32_t offset) {
+    uint32_t x = offset * 2654435761u ^ (uint32_t)fname[strlen(fname) - 5];
+    return (uint8_t)(x >> 13);
+}
+
+static int makeFile(const char *fname, uint32_t size) {
+    static uint8_t chunk[4096];
+    FILE *f = fopen(fname, "wb");
+    uint32_t off, i, n;
+    int ok = (f != NULL);
+
+    for (off = 0; ok && (off < size); off += n) {
+        n = (size - off) < sizeof(chunk) ? (size - off) : sizeof(chunk);
+        for (i = 0; i < n; i++) {
+            chunk[i] = byteAt(fname, off + i);
+        }
+        ok = (fwrite(chunk, 1, n, f) == n);
+    }
+    if (f) {
+        fclose(f);
+    }
+    return ok;
+}
+
+static int matches(const char *fname, uint32_t offset, size_t len) {
+    size_t i;
+    for (i = 0; i < len; i++) {
+        if (buf[i] != byteAt(fname, offset + i)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static TRACK_CACHE_TRACK *openTrack(const char *fname) {
+    TRACK_CACHE_TRACK *t = track_cache_open(fname);
+    unsigned i;
+    for (i = 0; t && (i < MAX_OPEN); i++) {
+        if (opened[i] == NULL) {
+            opened[i] = t;
+            break;
+        }
+    }
+    return t;
+}
+
+static unsigned settle(void) {
+    unsigned n = 0;
+    while (track_cache_service()) {
+        n++;
+    }
+    return n;
+}
+
+// Counter deltas since setup()
+static TRACK_CACHE_STATS delta(void) {
+    TRACK_CACHE_STATS s;
+    track_cache_stats(&s);
+    s.hits -= before.hits; s.misses -= before.misses;
+    s.loads -= before.loads; s.evictions -= before.evictions;
+    s.readErrors -= before.readErrors;
+    return s;
+}
+
+static size_t readAt(TRACK_CACHE_TRACK *t, uint32_t offset, size_t len) {
+    return track_cache_read(t, offset, buf, len);
+}
+
+static void removeFiles(void) {
+    static const char *names[] = {
+        "tc_a.bin", "tc_b.bin", "tc_c.bin", "tc_d.bin", "tc_e.bin",
+        "tc_f.bin", "tc_w.wav"
+    };
+    unsigned i;
+    for (i = 0; i < ARRAY_NELEM(names); i++) {
+        remove(names[i]);
+    }
+}
+
+void setup(void) {
+    static int initialized;
+    if (!initialized) {
+        track_cache_init();
+        atexit(removeFiles);
+        initialized = 1;
+    }
+    memset(opened, 0, sizeof(opened));
+    track_cache_stats(&before);
+    seed = 12345;
+}
+
+void teardown(void) {
+    unsigned i;
+    for (i = 0; i < MAX_OPEN; i++) {
+        if (opened[i]) {
+            track_cache_close(opened[i]);
+        }
+    }
+    track_cache_queue(NULL);
+    if (wf.f) {
+        closeWave(&wf);
+    }
+    if (wfRef.f) {
+        closeWave(&wfRef);
+    }
+    memset(&wf, 0, sizeof(wf));
+    memset(&wfRef, 0, sizeof(wfRef));
+}
+
+// test group ----------------------------------------------------------------
+TEST_GROUP("track_cache") {
+
+TEST("reads match the file at any offset, resident or not") {
+    const uint32_t size = 3 * REGION + 777;
+    TRACK_CACHE_TRACK *t;
+    uint32_t off;
+    size_t len;
+    unsigned i;
+    int ok = 1;
+
+    VERIFY(makeFile("tc_a.bin", size));
+    VERIFY(track_cache_open("tc_missing.bin") == NULL);
+    t = openTrack("tc_a.bin");
+    VERIFY(t != NULL);
+
+    for (i = 0; i < 200; i++) {
+        // Half the reads before the read-ahead is loaded, half after
+        if (i == 100) {
+            VERIFY(settle() == 4);
+        }
+        off = rnd() % size;
+        len = 1 + rnd() % sizeof(buf);
+        if (len > size - off) {
+            len = size - off;
+        }
+        ok = ok && (readAt(t, off, len) == len) &&
+            matches("tc_a.bin", off, len);
+    }
+    VERIFY(ok);
+    VERIFY(delta().hits > 0);
+    VERIFY(delta().misses > 0);
+
+    // Short at the end of file, nothing past it
+    VERIFY(readAt(t, size - 10, 100) == 10);
+    VERIFY(matches("tc_a.bin", size - 10, 10));
+    VERIFY(readAt(t, size, 100) == 0);
+    VERIFY(delta().readErrors == 0);
+}
+
+TEST("queued tracks preload from the start and read as hits") {
+    const uint32_t size = 4 * REGION + 123;
+    TRACK_CACHE_TRACK *t;
+    uint32_t off;
+
+    VERIFY(makeFile("tc_b.bin", size));
+    VERIFY(track_cache_queue("tc_b.bin"));
+    VERIFY(!track_cache_queue("tc_missing.bin"));
+    VERIFY(settle() == 5);
+    VERIFY(delta().loads == 5);
+
+    t = openTrack("tc_b.bin");
+    VERIFY(t != NULL);
+    for (off = 0; off < size; off += 1000) {
+        VERIFY(readAt(t, off, 1000) == (off + 1000 > size ? size - off : 1000));
+    }
+    VERIFY(delta().misses == 0);
+    VERIFY(readAt(t, REGION - 50, 100) == 100 && matches("tc_b.bin", REGION - 50, 100));
+
+    // Everything is resident, reopening costs no loads either
+    VERIFY(settle() == 0);
+}
+
+TEST("read-ahead follows the play position and wraps to the start") {
+    const uint32_t size = 10 * REGION;
+    TRACK_CACHE_TRACK *t;
+    TRACK_CACHE_STATS s;
+
+    VERIFY(makeFile("tc_c.bin", size));
+    t = openTrack("tc_c.bin");
+    VERIFY(t != NULL);
+    VERIFY(settle() == TRACK_CACHE_READ_AHEAD);
+
+    // Jump near the end, the window covers 8, 9, 0 and 1
+    VERIFY(readAt(t, 8 * REGION, 1) == 1);
+    VERIFY(settle() == 2);
+    s = delta();
+    VERIFY(readAt(t, 9 * REGION + 5, 10) == 10 && matches("tc_c.bin", 9 * REGION + 5, 10));
+    VERIFY(readAt(t, 0, 10) == 10);
+    VERIFY(readAt(t, REGION, 10) == 10);
+    VERIFY(delta().misses == s.misses);
+    VERIFY(delta().hits == s.hits + 3);
+    VERIFY(delta().evictions == 0);
+}
+
+TEST("preloads never evict queued tracks, read-ahead takes their tail") {
+    const uint32_t big = CACHE_REGIONS * REGION;
+    TRACK_CACHE_TRACK *t;
+    TRACK_CACHE_STATS s;
+
+    // Fills the whole cache, evicting the idle tracks of earlier tests
+    VERIFY(makeFile("tc_d.bin", big));
+    VERIFY(makeFile("tc_e.bin", 2 * REGION));
+    VERIFY(track_cache_queue("tc_d.bin"));
+    VERIFY(settle() == CACHE_REGIONS);
+    VERIFY(delta().evictions > 0);
+
+    // A later queued track has nowhere to go
+    s = delta();
+    VERIFY(track_cache_queue("tc_e.bin"));
+    VERIFY(settle() == 0);
+
+    // The playing track does, at the expense of the last queued regions
+    t = openTrack("tc_a.bin");
+    VERIFY(t != NULL);
+    VERIFY(settle() == TRACK_CACHE_READ_AHEAD);
+    VERIFY(delta().evictions == s.evictions + TRACK_CACHE_READ_AHEAD);
+
+    // Opening the queued track finds its head resident, its tail not
+    t = openTrack("tc_d.bin");
+    VERIFY(t != NULL);
+    s = delta();
+    VERIFY(readAt(t, 0, 10) == 10 && matches("tc_d.bin", 0, 10));
+    VERIFY(delta().hits == s.hits + 1);
+    VERIFY(readAt(t, big - 10, 10) == 10 && matches("tc_d.bin", big - 10, 10));
+    VERIFY(delta().misses == s.misses + 1);
+}
+
+TEST("readWave through the cache matches the file path") {
+    static int32_t pcm[8192], out[1000], ref[1000];
+    unsigned i, n;
+    int ok = 1;
+
+    for (i = 0; i < ARRAY_NELEM(pcm); i++) {
+        pcm[i] = (int32_t)(i * 0x9E3779B9u);
+    }
+    wf.fname = "tc_w.wav"; wf.isSrc = false;
+    wf.channels = 2; wf.sampleRate = 48000;
+    wf.wordSizeBytes = 4; wf.frameSizeBytes = 8;
+    VERIFY(openWave(&wf));
+    for (i = 0; i < 20; i++) {
+        writeWave(&wf, pcm, ARRAY_NELEM(pcm));
+    }
+    closeWave(&wf);
+
+    memset(&wf, 0, sizeof(wf));
+    wf.fname = "tc_w.wav"; wf.isSrc = true;
+    wfRef = wf;
+    VERIFY(openWave(&wf));
+    VERIFY(openWave(&wfRef));
+    wf.readUsr = openTrack("tc_w.wav");
+    VERIFY(wf.readUsr != NULL);
+    wf.read = track_cache_read;
+
+    // Odd sizes straddle regions and loop past the end of the data
+    for (i = 0; i < 500; i++) {
+        n = 1 + rnd() % ARRAY_NELEM(out);
+        if (i % 16 == 0) {
+            settle();
+        }
+        ok = ok && (readWave(&wf, out, n) == readWave(&wfRef, ref, n));
+        ok = ok && (memcmp(out, ref, n * 4) == 0) &&
+            (wf.dataOffset == wfRef.dataOffset);
+    }
+    VERIFY(ok);
+    VERIFY(delta().hits > 0);
+}
+
+TEST("benchmarks") {
+    const uint32_t size = 8 * REGION;
+    TRACK_CACHE_TRACK *t;
+    uint64_t ref, cut;
+    FILE *f;
+
+    VERIFY(makeFile("tc_f.bin", size));
+    VERIFY(track_cache_queue("tc_f.bin"));
+    settle();
+    t = openTrack("tc_f.bin");
+    VERIFY(t != NULL);
+
+    f = fopen("tc_f.bin", "rb");
+    VERIFY(f != NULL);
+    seed = 1;
+    BENCH(ref,
+        fseek(f, rnd() % (size - 4096), SEEK_SET); fread(buf, 1, 4096, f));
+    fclose(f);
+    seed = 1;
+    BENCH(cut, readAt(t, rnd() % (size - 4096), 4096));
+    bench_report("random 4K read", ref, cut, 4096, "B");
+}
+
+} // TEST_GROUP()
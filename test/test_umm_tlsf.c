@@ -0,0 +1,197 @@
+// umm_malloc host test covering the TLSF and first-fit heap backends.
+//
+// Build and run from the repository root:
+//   gcc -I test/et -I ARM/include -I ARM/src/oss-services/umm_malloc
+//       test/test_umm_tlsf.c ARM/src/oss-services/umm_malloc/umm_malloc.c
+//       test/et/et.c test/et/et_host.c -o test_umm_tlsf && ./test_umm_tlsf
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "umm_malloc.h"     // Code Under Test (CUT)
+#include "umm_malloc_cfg.h" // Code Under Test (CUT)
+#include "et.h"  // ET: embedded test
+
+#define HEAP_SIZE   (1024 * 1024)
+#define NUM_PTRS    256
+
+static uint64_t heapMem[2][HEAP_SIZE / sizeof(uint64_t)];
+static void *ptrs[NUM_PTRS];
+static size_t sizes[NUM_PTRS];
+static uint32_t lfsr;
+
+static uint32_t rnd(void) {
+    lfsr ^= lfsr << 13;
+    lfsr ^= lfsr >> 17;
+    lfsr ^= lfsr << 5;
+    return lfsr;
+}
+
+static int fill(void *p, size_t size, unsigned tag) {
+    memset(p, tag & 0xFF, size);
+    return 1;
+}
+
+static int filled(void *p, size_t size, unsigned tag) {
+    unsigned char *c = p;
+    size_t i;
+    for (i = 0; i < size; i++) {
+        if (c[i] != (tag & 0xFF)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Random malloc/realloc/free, checking contents and heap consistency
+static int stress(umm_heap_t heap, unsigned iterations) {
+    unsigned i, n;
+    void *p;
+
+    memset(ptrs, 0, sizeof(ptrs));
+    for (i = 0; i < iterations; i++) {
+        n = rnd() % NUM_PTRS;
+        if (ptrs[n] == NULL) {
+            sizes[n] = 1 + rnd() % ((rnd() & 7) ? 256 : 16384);
+            ptrs[n] = umm_malloc_heap(heap, sizes[n]);
+            if (ptrs[n]) {
+                fill(ptrs[n], sizes[n], n);
+            }
+        } else if (rnd() & 3) {
+            if (!filled(ptrs[n], sizes[n], n)) {
+                return 0;
+            }
+            umm_free_heap(heap, ptrs[n]);
+            ptrs[n] = NULL;
+        } else {
+            size_t size = 1 + rnd() % 8192;
+            p = umm_realloc_heap(heap, ptrs[n], size);
+            if (p) {
+                if (!filled(p, size < sizes[n] ? size : sizes[n], n)) {
+                    return 0;
+                }
+                ptrs[n] = p;
+                sizes[n] = size;
+                fill(p, size, n);
+            }
+        }
+        if ((i % 64) == 0 && !umm_integrity_check(heap)) {
+            return 0;
+        }
+    }
+    for (n = 0; n < NUM_PTRS; n++) {
+        umm_free_heap(heap, ptrs[n]);
+    }
+    return umm_integrity_check(heap);
+}
+
+void setup(void) {
+    lfsr = 0x12345678;
+    umm_init(UMM_SDRAM_HEAP, heapMem[0], HEAP_SIZE);
+    umm_init(UMM_L2_CACHED_HEAP, heapMem[1], HEAP_SIZE);
+}
+
+void teardown(void) {
+}
+
+// test group ----------------------------------------------------------------
+TEST_GROUP("umm_malloc") {
+
+TEST("heaps use the configured allocator") {
+    VERIFY(strcmp(umm_heap_allocator(UMM_SDRAM_HEAP), "TLSF") == 0);
+    VERIFY(strcmp(umm_heap_allocator(UMM_L2_CACHED_HEAP), "First-fit") == 0);
+}
+
+TEST("TLSF allocations are aligned and distinct") {
+    char *a = umm_malloc_heap(UMM_SDRAM_HEAP, 1);
+    char *b = umm_malloc_heap(UMM_SDRAM_HEAP, 100);
+    char *c = umm_malloc_heap(UMM_SDRAM_HEAP, 5000);
+    VERIFY(a && b && c);
+    VERIFY(((uintptr_t)a & 7) == 0);
+    VERIFY(((uintptr_t)b & 7) == 0);
+    VERIFY(((uintptr_t)c & 7) == 0);
+    VERIFY(b >= a + 1 && c >= b + 100);
+    VERIFY(umm_malloc_heap(UMM_SDRAM_HEAP, 0) == NULL);
+    VERIFY(umm_malloc_heap(UMM_SDRAM_HEAP, 2 * HEAP_SIZE) == NULL);
+    umm_free_heap(UMM_SDRAM_HEAP, b);
+    umm_free_heap(UMM_SDRAM_HEAP, a);
+    umm_free_heap(UMM_SDRAM_HEAP, c);
+    VERIFY(umm_integrity_check(UMM_SDRAM_HEAP));
+}
+
+TEST("TLSF coalesces back to one free block") {
+    UMM_HEAP_INFO before, after;
+    umm_info(UMM_SDRAM_HEAP, &before, NULL, 0);
+    VERIFY(before.freeEntries == 1);
+    VERIFY(before.fragmentation == 0);
+    VERIFY(stress(UMM_SDRAM_HEAP, 20000));
+    umm_info(UMM_SDRAM_HEAP, &after, NULL, 0);
+    VERIFY(after.freeEntries == 1);
+    VERIFY(after.usedEntries == 0);
+    VERIFY(after.freeBytes == before.freeBytes);
+    VERIFY(umm_free_heap_size(UMM_SDRAM_HEAP) == before.freeBytes);
+}
+
+TEST("TLSF fills the heap without losing memory") {
+    UMM_HEAP_INFO info;
+    unsigned n = 0;
+    void *p[200];
+
+    while (n < 200 && (p[n] = umm_malloc_heap(UMM_SDRAM_HEAP, 8000)) != NULL) {
+        n++;
+    }
+    // Good fit lists cost at most one size class of the request
+    VERIFY(n * 8000 > HEAP_SIZE * 9 / 10);
+    umm_info(UMM_SDRAM_HEAP, &info, NULL, 0);
+    VERIFY(info.usedEntries == n);
+    while (n--) {
+        umm_free_heap(UMM_SDRAM_HEAP, p[n]);
+    }
+    VERIFY(umm_integrity_check(UMM_SDRAM_HEAP));
+}
+
+TEST("TLSF realloc grows in place into free space") {
+    char *a = umm_malloc_heap(UMM_SDRAM_HEAP, 64);
+    char *b;
+    fill(a, 64, 0x5A);
+    b = umm_realloc_heap(UMM_SDRAM_HEAP, a, 4096);
+    VERIFY(b == a);
+    VERIFY(filled(b, 64, 0x5A));
+    b = umm_realloc_heap(UMM_SDRAM_HEAP, b, 16);
+    VERIFY(b == a);
+    umm_free_heap(UMM_SDRAM_HEAP, b);
+    VERIFY(umm_integrity_check(UMM_SDRAM_HEAP));
+}
+
+TEST("first-fit heap still works behind the dispatcher") {
+    UMM_HEAP_INFO info;
+    VERIFY(stress(UMM_L2_CACHED_HEAP, 5000));
+    umm_info(UMM_L2_CACHED_HEAP, &info, NULL, 0);
+    VERIFY(info.usedEntries == 0);
+    VERIFY(info.freeBytes == info.totalBytes);
+    VERIFY(info.fragmentation == 0);
+}
+
+TEST("statistics track allocations and used bytes") {
+    UMM_HEAP_STATS stats;
+    void *a, *b;
+
+    umm_heap_stats(UMM_SDRAM_HEAP, NULL, 1);
+    a = umm_malloc_heap(UMM_SDRAM_HEAP, 1000);
+    b = umm_malloc_heap(UMM_SDRAM_HEAP, 2000);
+    VERIFY(umm_malloc_heap(UMM_SDRAM_HEAP, 4 * HEAP_SIZE) == NULL);
+    umm_heap_stats(UMM_SDRAM_HEAP, &stats, 0);
+    VERIFY(stats.allocs == 2);
+    VERIFY(stats.failures == 1);
+    VERIFY(stats.usedBytes >= 3000);
+    VERIFY(stats.usedBytes < 3100);
+    umm_free_heap(UMM_SDRAM_HEAP, a);
+    umm_free_heap(UMM_SDRAM_HEAP, b);
+    umm_heap_stats(UMM_SDRAM_HEAP, &stats, 0);
+    VERIFY(stats.frees == 2);
+    VERIFY(stats.usedBytes == 0);
+    VERIFY(stats.peakUsedBytes >= 3000);
+}
+
+} // TEST_GROUP()
@@ -0,0 +1,621 @@
+// Loop and hot-cue engine tests.  A host file plays through a real
+// PaUtil ring fed by a copy of the wav src task loop, and every output
+// frame is checked against the file frame it must come from, including
+// the crossfades.  Jumps are checked to play correctly straight away
+// with the source task stalled, and the stream is checked to carry on
+// without a gap once the pin runs out.  Scratch playback is checked to
+// take over and hand back without a gap, and to follow the jog rate in
+// either direction.  The xfer path cost per block is reported against a
+// bare ring read.
+//
+// Build and run from the repository root:
+//   gcc -O2 -I test -I test/et -I test/host -I ARM/include -I ALL/include
+//       -I ARM/src/oss-services/FreeRTOS-ARM/include
+//       -I ARM/src/oss-services/umm_malloc -I ARM/src/simple-services/sched-trace
+//       -I ARM/src/oss-services/pa-ringbuffer
+//       -I ARM/src/simple-services/wav-file -I ARM/src/simple-services/flac-dec
+//       -I ARM/src/simple-services/wav-cue
+//       test/test_wav_cue.c ARM/src/simple-services/wav-cue/wav_cue.c
+//       ARM/src/simple-services/wav-cue/wav_scratch.c
+//       ARM/src/simple-services/wav-file/wav_file.c
+//       ARM/src/simple-services/flac-dec/flac_dec.c
+//       ARM/src/oss-services/pa-ringbuffer/pa_ringbuffer.c
+//       test/et/et.c test/et/et_host.c -o test_wav_cue && ./test_wav_cue
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "wav_cue.h"  // Code Under Test (CUT)
+#include "wav_file.h"
+#include "pa_ringbuffer.h"
+#include "umm_malloc.h"
+#include "et.h"  // ET: embedded test
+#include "bench.h"
+
+#define FNAME       "test_wav_cue.wav"
+#define RATE        48000
+#define FRAMES      RATE
+#define CHANNELS    2
+#define BLOCK       64
+#define CHUNK       (64 * BLOCK)
+#define RING        16384
+#define XF          WAV_CUE_XFADE_FRAMES
+#define PIN_FRAMES  (WAV_CUE_PIN_MS * RATE / 1000)
+
+static WAV_CUE cue;
+static WAV_SCRATCH win;
+static WAV_FILE wf;
+static PaUtilRingBuffer rb;
+static int32_t rbMem[RING];
+static int32_t scratch[CHUNK];
+static int32_t out[BLOCK * CHANNELS];
+static FILE *hookFile;
+static unsigned hookReads;
+
+// Single threaded, critical sections have nothing to exclude
+void vPortEnterCritical(void) {
+}
+
+void vPortExitCritical(void) {
+}
+
+// wav_cue_cfg.h and wav_file_cfg.h allocate from the umm heaps
+void *umm_malloc_heap(umm_heap_t heap, size_t size) {
+    (void)heap;
+    return malloc(size);
+}
+
+void *umm_calloc_heap(umm_heap_t heap, size_t num, size_t size) {
+    (void)heap;
+    return calloc(num, size);
+}
+
+void umm_free_heap(umm_heap_t heap, void *ptr) {
+    (void)heap;
+    free(ptr);
+}
+
+void *umm_calloc_aligned(size_t num, size_t item_size, size_t alignment) {
+    (void)alignment;
+    return calloc(num, item_size);
+}
+
+void umm_free_aligned(void *ptr) {
+    free(ptr);
+}
+
+// helpers -------------------------------------------------------------------
+static int32_t sampleAt(uint32_t frame, unsigned ch) {
+    return (int32_t)((frame % FRAMES) * 16 + ch);
+}
+
+// Positioned reads through a handle of their own, like the track cache
+static size_t hookRead(void *usr, uint32_t offset, void *buf, size_t len) {
+    (void)usr;
+    hookReads++;
+    if (fseek(hookFile, offset, SEEK_SET) != 0) {
+        return (size_t)-1;
+    }
+    return fread(buf, 1, len, hookFile);
+}
+
+static int writeFile(void) {
+    static int32_t pcm[FRAMES * CHANNELS];
+    WAV_FILE sink;
+    unsigned f, c;
+
+    for (f = 0; f < FRAMES; f++) {
+        for (c = 0; c < CHANNELS; c++) {
+            pcm[f * CHANNELS + c] = sampleAt(f, c);
+        }
+    }
+    memset(&sink, 0, sizeof(sink));
+    sink.fname = FNAME; sink.isSrc = false;
+    sink.channels = CHANNELS; sink.sampleRate = RATE;
+    sink.wordSizeBytes = 4; sink.frameSizeBytes = 4 * CHANNELS;
+    if (!openWave(&sink)) {
+        return 0;
+    }
+    writeWave(&sink, pcm, FRAMES * CHANNELS);
+    closeWave(&sink);
+    return 1;
+}
+
+static int openSrc(int hook) {
+    memset(&wf, 0, sizeof(wf));
+    wf.fname = FNAME; wf.isSrc = true;
+    if (!openWave(&wf)) {
+        return 0;
+    }
+    if (hook) {
+        hookFile = fopen(FNAME, "rb");
+        wf.read = hookRead;
+    }
+    PaUtil_InitializeRingBuffer(&rb, sizeof(int32_t), RING, rbMem);
+    return wav_cue_attach(&cue, &wf, BLOCK, NULL);
+}
+
+// The wav src task loop, minus the RTOS
+static void srcTask(void) {
+    ring_buffer_size_t size1, size2;
+    void *buf1, *buf2;
+    size_t rsize;
+
+    wav_cue_seek(&cue, &rb);
+    while (PaUtil_GetRingBufferWriteAvailable(&rb) >= CHUNK) {
+        wav_cue_seek(&cue, &rb);
+        rsize = readWave(&wf, scratch, CHUNK);
+        PaUtil_GetRingBufferWriteRegions(&rb, rsize,
+            &buf1, &size1, &buf2, &size2);
+        decodeWave(&wf, scratch, buf1, size1);
+        if (size2) {
+            decodeWave(&wf, scratch + size1, buf2, size2);
+        }
+        PaUtil_AdvanceRingBufferWriteIndex(&rb, rsize);
+    }
+    wav_cue_service(&cue, scratch, CHUNK);
+}
+
+static void pinAll(void) {
+    while (wav_cue_service(&cue, scratch, CHUNK)) {
+    }
+}
+
+static void scratchAll(void) {
+    while (wav_cue_service(&cue, scratch, CHUNK)) {
+    }
+}
+
+// Scratch render timer, in ns
+static uint32_t hostStamp(void) {
+    return (uint32_t)bench_ns();
+}
+
+static int xfer(void) {
+    bool wake;
+    return wav_cue_xfer(&cue, &rb, out, &wake);
+}
+
+// Frame i of the last block came from file frame 'frame'
+static int frameIs(unsigned i, uint32_t frame) {
+    unsigned c;
+    for (c = 0; c < CHANNELS; c++) {
+        if (out[i * CHANNELS + c] != sampleAt(frame, c)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Frame i of the last block is 'pos' into a fade from 'from' to 'to'
+static int fadeIs(unsigned i, uint32_t to, uint32_t from, unsigned pos) {
+    int64_t a, b;
+    unsigned c;
+    for (c = 0; c < CHANNELS; c++) {
+        a = sampleAt(from, c); b = sampleAt(to, c);
+        if (out[i * CHANNELS + c] != (int32_t)(a + ((b - a) * pos) / XF)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Each frame of the last block moves on from the one before, channel 0
+// being 'slope' up within rounding
+static int slopeIs(int32_t *prev, int slope) {
+    int d;
+    unsigned i;
+    for (i = 0; i < BLOCK; i++) {
+        d = out[i * CHANNELS] - *prev;
+        *prev = out[i * CHANNELS];
+        if ((d < slope - 1) || (d > slope + 1)) {
+            printf("  frame %u: step %d, want %d\n", i, d, slope);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Plays 'blocks' blocks that must run on from 'frame', returns the next
+static uint32_t playOn(uint32_t frame, unsigned blocks, int runTask) {
+    unsigned b, i;
+    for (b = 0; b < blocks; b++) {
+        if (runTask) {
+            srcTask();
+        }
+        if (!xfer()) {
+            return UINT32_MAX;
+        }
+        for (i = 0; i < BLOCK; i++, frame++) {
+            if (!frameIs(i, frame)) {
+                printf("  block %u frame %u: %d, want %u\n", b, i,
+                    out[i * CHANNELS] / 16, frame % FRAMES);
+                return UINT32_MAX;
+            }
+        }
+    }
+    return frame;
+}
+
+static void removeFile(void) {
+    remove(FNAME);
+}
+
+void setup(void) {
+    static int written;
+    if (!written) {
+        written = writeFile();
+        atexit(removeFile);
+    }
+    memset(&cue, 0, sizeof(cue));
+    hookReads = 0;
+}
+
+void teardown(void) {
+    wav_cue_attach(&cue, NULL, 0, NULL);
+    wav_scratch_free(&win);
+    if (wf.f) {
+        closeWave(&wf);
+    }
+    if (hookFile) {
+        fclose(hookFile);
+        hookFile = NULL;
+    }
+}
+
+// test group ----------------------------------------------------------------
+TEST_GROUP("wav_cue") {
+
+TEST("plays the file unchanged and wraps at the end") {
+    int hook;
+    for (hook = 0; hook <= 1; hook++) {
+        VERIFY(openSrc(hook));
+        // Nothing in the ring yet is an underflow, not silence
+        VERIFY(!xfer());
+        VERIFY(playOn(0, FRAMES / BLOCK + 10, 1) == FRAMES + 10 * BLOCK);
+        VERIFY(wav_cue_position(&cue) == 10 * BLOCK);
+        teardown();
+    }
+}
+
+TEST("FLAC sources are left detached") {
+    VERIFY(openSrc(0));
+    wf.flac = (FLAC_DEC *)&wf;
+    VERIFY(!wav_cue_attach(&cue, &wf, BLOCK, NULL));
+    VERIFY(cue.wf == NULL);
+    VERIFY(!wav_cue_set(&cue, 0, 0));
+    wf.flac = NULL;
+}
+
+TEST("hot cues play at once and the ring takes over without a gap") {
+    uint32_t frame;
+    unsigned i;
+
+    VERIFY(openSrc(1));
+    VERIFY(wav_cue_set(&cue, 0, 30000));
+    VERIFY(!wav_cue_jump(&cue, 0));
+    frame = playOn(0, 20, 1);
+    VERIFY(cue.pins[0].ready);
+
+    // The source task stalls from here until the pin is nearly done
+    VERIFY(wav_cue_jump(&cue, 0));
+    VERIFY(xfer());
+    for (i = 0; i < XF; i++) {
+        VERIFY(fadeIs(i, 30000 + i, frame + i, i));
+    }
+    for (; i < BLOCK; i++) {
+        VERIFY(frameIs(i, 30000 + i));
+    }
+    hookReads = 0;
+    frame = playOn(30000 + BLOCK, PIN_FRAMES / BLOCK - 4, 0);
+    VERIFY(frame != UINT32_MAX);
+    VERIFY(hookReads == 0);
+
+    // Past the end of the pin and on through the wrap at the end of file
+    VERIFY(playOn(frame, 500, 1) == frame + 500 * BLOCK);
+    VERIFY(cue.stats.jumps == 1);
+    VERIFY(cue.stats.underflows == 0);
+    VERIFY(cue.playing == NULL);
+}
+
+TEST("cues near the end of the file pin the wrapped audio") {
+    VERIFY(openSrc(0));
+    VERIFY(wav_cue_set(&cue, 7, FRAMES - 1000));
+    pinAll();
+    VERIFY(cue.pins[7].ready);
+    VERIFY(playOn(0, 4, 1) == 4 * BLOCK);
+    VERIFY(wav_cue_jump(&cue, 7));
+    VERIFY(xfer());
+    VERIFY(frameIs(BLOCK - 1, FRAMES - 1000 + BLOCK - 1));
+    VERIFY(playOn(FRAMES - 1000 + BLOCK, 400, 1) != UINT32_MAX);
+}
+
+TEST("loops wrap sample-accurately with a seam crossfade") {
+    const uint32_t in = 10000, out = 14321;
+    uint32_t frame;
+    unsigned i, n, wraps;
+
+    VERIFY(openSrc(1));
+    VERIFY(wav_cue_loop(&cue, in, out));
+    // Played linearly from the start up to the out point
+    frame = playOn(0, out / BLOCK, 1);
+    VERIFY(frame == out / BLOCK * BLOCK);
+    VERIFY(cue.playing == &cue.pins[WAV_CUE_LOOP]);
+
+    // Then round the loop three times without the source task, and
+    // one more block to get clear of the seam
+    wraps = 0;
+    for (n = 0; n < 2; n += (wraps == 3)) {
+        VERIFY(xfer());
+        for (i = 0; i < BLOCK; i++) {
+            if (frame == out) {
+                frame = in;
+                wraps++;
+            }
+            if ((wraps > 0) && (frame - in < XF)) {
+                VERIFY(fadeIs(i, frame, out + frame - in, frame - in));
+            } else {
+                VERIFY(frameIs(i, frame));
+            }
+            frame++;
+        }
+    }
+    VERIFY(cue.stats.loops == 3);
+    VERIFY(cue.stats.jumps == 0);
+
+    // Exiting plays on past the out point, through the pinned tail and
+    // into the ring, which was seeked there when the loop started
+    wav_cue_loop_exit(&cue);
+    VERIFY(playOn(frame, 300, 1) == frame + 300 * BLOCK);
+    VERIFY(cue.stats.underflows == 0);
+}
+
+TEST("a loop shrinks in place and a late loop jumps back") {
+    const uint32_t in = 5000, len = 8192;
+    WAV_CUE_PIN *pin = &cue.pins[WAV_CUE_LOOP];
+    int32_t *buf;
+    uint32_t frame;
+    unsigned b, i;
+
+    VERIFY(openSrc(0));
+    VERIFY(wav_cue_loop(&cue, in, in + len));
+    pinAll();
+    frame = playOn(0, (in + 1000) / BLOCK, 1);
+    VERIFY(cue.playing == pin);
+
+    // Halving keeps the pin and wraps at the new out point
+    buf = pin->buf;
+    VERIFY(wav_cue_loop(&cue, in, in + len / 2));
+    VERIFY(pin->ready && (pin->buf == buf));
+    for (b = 0; b < (len / 2) / BLOCK + 2; b++) {
+        VERIFY(xfer());
+        for (i = 0; i < BLOCK; i++, frame++) {
+            if (frame == in + len / 2) {
+                frame = in;
+            }
+            VERIFY((frame - in < XF) || frameIs(i, frame));
+        }
+    }
+    VERIFY(cue.stats.loops >= 1);
+
+    // A loop the play position is already past jumps to its in point
+    VERIFY(!wav_cue_loop(&cue, 20000, 21000));
+    wav_cue_loop_exit(&cue);
+    while (cue.playing) {
+        srcTask();
+        VERIFY(xfer());
+    }
+    VERIFY(wav_cue_loop(&cue, 1000, 2000));
+    pinAll();
+    srcTask();
+    VERIFY(xfer());
+    VERIFY(cue.stats.jumps == 1);
+    for (i = XF; i < BLOCK; i++) {
+        VERIFY(frameIs(i, 1000 + i));
+    }
+}
+
+TEST("beat lengths follow the tempo") {
+    VERIFY(openSrc(0));
+    VERIFY(wav_cue_beat_frames(&cue, 1, 1) == RATE / 2);
+    VERIFY(wav_cue_beat_frames(&cue, 4, 1) == 2 * RATE);
+    VERIFY(wav_cue_beat_frames(&cue, 1, 8) == RATE / 16);
+    cue.bpm = 128.0f;
+    VERIFY(wav_cue_beat_frames(&cue, 1, 1) == 22500);
+    VERIFY(wav_cue_beat_frames(&cue, 1, 0) == 0);
+}
+
+TEST("scratch takes over in place once its window is loaded") {
+    uint32_t frame;
+
+    // Close enough to a block boundary to need two window blocks
+    VERIFY(openSrc(1));
+    frame = playOn(0, 15, 1);
+    VERIFY(!wav_cue_jog(&cue, -1.0f));
+    VERIFY(wav_cue_scratch(&cue, true));
+
+    // The ring carries on until the window around the head is in
+    frame = playOn(frame, 1, 1);
+    VERIFY(!cue.scratching);
+    scratchAll();
+
+    // Rate 1 from a whole frame is bit-exact
+    VERIFY(playOn(frame, 50, 1) == frame + 50 * BLOCK);
+    VERIFY(cue.scratching);
+    VERIFY(cue.stats.scratchBlocks == 50);
+    VERIFY(cue.scratch.misses == 0);
+}
+
+TEST("the jog sets the rate in either direction") {
+    uint32_t frame;
+    int32_t prev;
+    unsigned b;
+
+    VERIFY(openSrc(0));
+    playOn(0, 200, 1);
+    VERIFY(wav_cue_scratch(&cue, true));
+    scratchAll();
+    VERIFY(xfer());
+    VERIFY(cue.scratching);
+
+    // Slews through a stop to full reverse in four blocks
+    VERIFY(wav_cue_jog(&cue, -1.0f));
+    for (b = 0; b < 4; b++) {
+        srcTask();
+        VERIFY(xfer());
+    }
+    VERIFY(cue.scratch.rate == -1.0f);
+    frame = wav_cue_position(&cue);
+    prev = out[(BLOCK - 1) * CHANNELS];
+    for (b = 0; b < 20; b++) {
+        srcTask();
+        VERIFY(xfer());
+        VERIFY(slopeIs(&prev, -16));
+    }
+    VERIFY(wav_cue_position(&cue) == frame - 20 * BLOCK);
+
+    // Half speed forwards interpolates between frames
+    VERIFY(wav_cue_jog(&cue, 0.5f));
+    for (b = 0; b < 3; b++) {
+        srcTask();
+        VERIFY(xfer());
+    }
+    prev = out[(BLOCK - 1) * CHANNELS];
+    for (b = 0; b < 20; b++) {
+        srcTask();
+        VERIFY(xfer());
+        VERIFY(slopeIs(&prev, 8));
+    }
+    VERIFY(cue.scratch.misses == 0);
+    VERIFY(cue.stats.underflows == 0);
+}
+
+TEST("reverse play wraps through the start of the file") {
+    uint32_t frame;
+    unsigned b;
+
+    VERIFY(openSrc(0));
+    playOn(0, 3, 1);
+    VERIFY(wav_cue_scratch(&cue, true));
+    scratchAll();
+    VERIFY(xfer());
+    VERIFY(wav_cue_jog(&cue, -1.0f));
+    for (b = 0; b < 4; b++) {
+        VERIFY(xfer());
+    }
+    frame = wav_cue_position(&cue);
+    for (b = 0; b < 10; b++) {
+        srcTask();
+        VERIFY(xfer());
+    }
+    VERIFY(wav_cue_position(&cue) == FRAMES + frame - 10 * BLOCK);
+    VERIFY(cue.scratch.misses == 0);
+}
+
+TEST("releasing scratch crossfades back onto the ring") {
+    unsigned n, i;
+
+    VERIFY(openSrc(1));
+    playOn(0, 100, 1);
+    VERIFY(wav_cue_scratch(&cue, true));
+    scratchAll();
+    VERIFY(wav_cue_jog(&cue, -1.0f));
+    for (n = 0; n < 30; n++) {
+        srcTask();
+        VERIFY(xfer());
+    }
+
+    // Back to rate 1, then on to the ring a pin's length ahead
+    VERIFY(wav_cue_scratch(&cue, false));
+    VERIFY(!wav_cue_jog(&cue, -1.0f));
+    for (n = 0; cue.scratching && (n < 400); n++) {
+        srcTask();
+        VERIFY(xfer());
+    }
+    VERIFY(!cue.scratching);
+    VERIFY(n <= 6 + PIN_FRAMES / BLOCK);
+    for (i = XF; i < BLOCK; i++) {
+        VERIFY(frameIs(i, cue.handFrame + i));
+    }
+    VERIFY(playOn(cue.handFrame + BLOCK, 300, 1) != UINT32_MAX);
+    VERIFY(cue.stats.underflows == 0);
+}
+
+TEST("the window follows the head and misses play silence") {
+    uint32_t misses;
+    unsigned b, i;
+    int any;
+
+    VERIFY(openSrc(0));
+    VERIFY(wav_scratch_init(&win, CHANNELS, FRAMES,
+        8 * WAV_SCRATCH_BLOCK_FRAMES));
+    wav_scratch_locate(&win, 20000);
+    VERIFY(!wav_scratch_ready(&win, 20000, BLOCK));
+    while (wav_scratch_service(&win, &wf, scratch, CHUNK, NULL)) {
+    }
+    VERIFY(win.loads == 7);
+    VERIFY(wav_scratch_ready(&win, 20000, BLOCK));
+
+    // With the source task stalled the head runs out of the window
+    wav_scratch_jog(&win, 4.0f);
+    for (b = 0; (b < 100) && (win.misses == 0); b++) {
+        wav_scratch_render(&win, out, BLOCK);
+    }
+    VERIFY(win.misses > 0);
+    wav_scratch_render(&win, out, BLOCK);
+    for (i = 0; i < BLOCK * CHANNELS; i++) {
+        VERIFY(out[i] == 0);
+    }
+
+    // Refilled around where the head is now, it plays again
+    while (wav_scratch_service(&win, &wf, scratch, CHUNK, NULL)) {
+    }
+    misses = win.misses;
+    wav_scratch_render(&win, out, BLOCK);
+    VERIFY(win.misses == misses);
+    for (any = 0, i = 0; i < BLOCK * CHANNELS; i++) {
+        any |= (out[i] != 0);
+    }
+    VERIFY(any);
+}
+
+TEST("benchmarks") {
+    static int32_t block[BLOCK * CHANNELS];
+    uint64_t ref, cut;
+    bool wake;
+
+    VERIFY(openSrc(0));
+    BENCH(ref,
+        PaUtil_WriteRingBuffer(&rb, block, BLOCK * CHANNELS);
+        PaUtil_ReadRingBuffer(&rb, out, BLOCK * CHANNELS));
+    BENCH(cut,
+        PaUtil_WriteRingBuffer(&rb, block, BLOCK * CHANNELS);
+        wav_cue_xfer(&cue, &rb, out, &wake));
+    bench_report("xfer from the ring", ref, cut, BLOCK, "frm");
+
+    VERIFY(wav_cue_loop(&cue, 0, 4 * BLOCK + 7));
+    pinAll();
+    BENCH(cut,
+        PaUtil_WriteRingBuffer(&rb, block, BLOCK * CHANNELS);
+        wav_cue_xfer(&cue, &rb, out, &wake));
+    bench_report("xfer looping", ref, cut, BLOCK, "frm");
+    teardown();
+
+    // Scratch at a rate that never lands on a whole frame
+    VERIFY(openSrc(0));
+    VERIFY(wav_cue_attach(&cue, &wf, BLOCK, hostStamp));
+    VERIFY(wav_cue_scratch(&cue, true));
+    scratchAll();
+    VERIFY(wav_cue_jog(&cue, -1.37f));
+    BENCH(cut, wav_cue_xfer(&cue, &rb, out, &wake));
+    bench_report("xfer scratching, cubic", ref, cut, BLOCK, "frm");
+    printf("  scratch render %lu ns/block, peak %lu\n",
+        (unsigned long)cue.stats.renderTicks,
+        (unsigned long)cue.stats.peakRenderTicks);
+    VERIFY(cue.stats.scratchBlocks > 0);
+    VERIFY(cue.scratch.misses == 0);
+}
+
+} // TEST_GROUP()
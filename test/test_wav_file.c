@@ -0,0 +1,434 @@
+// WAV reader/writer bit-exact regression tests.  Written files are
+// checked byte for byte against a golden header, read back through the
+// CUT and the header parser is fed hand-built RIFX and
+// WAVE_FORMAT_EXTENSIBLE files.  The sample format decoders and encoders
+// are checked against golden vectors and a scalar reference.  readWave()
+// throughput is reported against a bare fread() of the same file and the
+// converters against the reference.
+//
+// Build and run from the repository root:
+//   gcc -O2 -I test -I test/et -I test/host -I ARM/include -I ALL/include
+//       -I ARM/src/oss-services/FreeRTOS-ARM/include
+//       -I ARM/src/oss-services/umm_malloc -I ARM/src/simple-services/sched-trace
+//       -I ARM/src/simple-services/wav-file -I ARM/src/simple-services/flac-dec
+//       test/test_wav_file.c ARM/src/simple-services/wav-file/wav_file.c
+//       ARM/src/simple-services/flac-dec/flac_dec.c test/et/et.c test/et/et_host.c -o test_wav_file && ./test_wav_file
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "wav_file.h"  // Code Under Test (CUT)
+#include "umm_malloc.h"
+#include "et.h"  // ET: embedded test
+#include "bench.h"
+
+#define FNAME       "test_wav_file.wav"
+#define FRAMES      1024
+#define CHANNELS    2
+
+static WAV_FILE wf;
+static int32_t samples32[FRAMES * CHANNELS];
+static int16_t samples16[FRAMES * CHANNELS];
+static uint8_t fileData[256];
+
+// wav_file_cfg.h and flac_dec_cfg.h allocate from the umm heaps
+void *umm_calloc_aligned(size_t num, size_t item_size, size_t alignment) {
+    (void)alignment;
+    return calloc(num, item_size);
+}
+
+void umm_free_aligned(void *ptr) {
+    free(ptr);
+}
+
+void *umm_calloc_heap(umm_heap_t heap, size_t num, size_t size) {
+    (void)heap;
+    return calloc(num, size);
+}
+
+void umm_free_heap(umm_heap_t heap, void *ptr) {
+    (void)heap;
+    free(ptr);
+}
+
+static void put16(uint8_t *p, uint16_t v, int be) {
+    p[be ? 1 : 0] = (uint8_t)v; p[be ? 0 : 1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v, int be) {
+    put16(p + (be ? 2 : 0), (uint16_t)v, be);
+    put16(p + (be ? 0 : 2), (uint16_t)(v >> 16), be);
+}
+
+// Builds a file with a 'LIST' chunk ahead of 'fmt ' to exercise skipping
+static size_t buildWaveTag(int be, int extensible, uint16_t tag, uint16_t bits,
+    uint16_t validBits, const void *data, uint32_t dataSize)
+{
+    uint8_t *p = fileData;
+    uint32_t fmtSize = extensible ? 40 : 16;
+    size_t len;
+
+    memcpy(p, be ? "RIFX" : "RIFF", 4); p += 8;
+    memcpy(p, "WAVE", 4); p += 4;
+    memcpy(p, "LIST", 4); put32(p + 4, 4, be); memcpy(p + 8, "INFO", 4);
+    p += 12;
+    memcpy(p, "fmt ", 4); put32(p + 4, fmtSize, be); p += 8;
+    memset(p, 0, fmtSize);
+    put16(p + 0, extensible ? 0xFFFE : tag, be);
+    put16(p + 2, CHANNELS, be);
+    put32(p + 4, 48000, be);
+    put32(p + 8, 48000 * CHANNELS * bits / 8, be);
+    put16(p + 12, CHANNELS * bits / 8, be);
+    put16(p + 14, bits, be);
+    if (extensible) {
+        put16(p + 16, 22, be);
+        put16(p + 18, validBits, be);
+        put32(p + 20, 0x3, be);
+        put32(p + 24, tag, be);  // KSDATAFORMAT_SUBTYPE_xxx Data1
+    }
+    p += fmtSize;
+    memcpy(p, "data", 4); put32(p + 4, dataSize, be); p += 8;
+    memcpy(p, data, dataSize); p += dataSize;
+    len = p - fileData;
+    put32(fileData + 4, len - 8, be);
+    return len;
+}
+
+static size_t buildWave(int be, int extensible, uint16_t bits,
+    uint16_t validBits, const void *data, uint32_t dataSize)
+{
+    return buildWaveTag(be, extensible, 0x0001, bits, validBits,
+        data, dataSize);
+}
+
+// Independent statement of each sample format's Q31 mapping
+static int32_t refDecode(WAVE_FMT fmt, const uint8_t *p) {
+    uint32_t u = 0;
+    float f;
+    double d;
+    switch (fmt) {
+        case WAVE_FMT_UNSIGNED_8BIT:
+            return (int32_t)((uint32_t)(p[0] - 128) << 24);
+        case WAVE_FMT_SIGNED_16BIT_LE:
+            return (int32_t)(((uint32_t)p[1] << 24) | ((uint32_t)p[0] << 16));
+        case WAVE_FMT_SIGNED_24BIT_LE:
+            return (int32_t)(((uint32_t)p[2] << 24) | ((uint32_t)p[1] << 16) |
+                ((uint32_t)p[0] << 8));
+        case WAVE_FMT_SIGNED_32BIT_LE:
+            memcpy(&u, p, 4);
+            return (int32_t)u;
+        case WAVE_FMT_FLOAT_32BIT_LE:
+            memcpy(&f, p, 4);
+            d = (double)f * 2147483648.0;
+            if (d != d) {
+                return 0;
+            }
+            return d >= 2147483647.0 ? INT32_MAX :
+                d <= -2147483648.0 ? INT32_MIN : (int32_t)d;
+        default:
+            return 0;
+    }
+}
+
+static void refDecodeBlock(WAVE_FMT fmt, unsigned ws, const uint8_t *src,
+    int32_t *dst, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++) {
+        dst[i] = refDecode(fmt, src + i * ws);
+    }
+}
+
+static int writeFile(const void *data, size_t len) {
+    FILE *f = fopen(FNAME, "wb");
+    int ok = f && (fwrite(data, 1, len, f) == len);
+    if (f) {
+        fclose(f);
+    }
+    return ok;
+}
+
+static int openSrc(void) {
+    memset(&wf, 0, sizeof(wf));
+    wf.fname = FNAME;
+    wf.isSrc = true;
+    return openWave(&wf);
+}
+
+void setup(void) {
+    unsigned i;
+    for (i = 0; i < FRAMES * CHANNELS; i++) {
+        samples32[i] = (int32_t)(i * 0x9E3779B9u);
+        samples16[i] = (int16_t)(samples32[i] >> 16);
+    }
+    memset(&wf, 0, sizeof(wf));
+}
+
+void teardown(void) {
+    if (wf.f) {
+        closeWave(&wf);
+    }
+    remove(FNAME);
+}
+
+// test group ----------------------------------------------------------------
+TEST_GROUP("wav_file") {
+
+TEST("16-bit sink writes the golden header and data") {
+    static const uint8_t golden[44] = {
+        'R','I','F','F', 0x24,0x10,0x00,0x00, 'W','A','V','E',
+        'f','m','t',' ', 0x10,0x00,0x00,0x00, 0x01,0x00, 0x02,0x00,
+        0x80,0xBB,0x00,0x00, 0x00,0xEE,0x02,0x00, 0x04,0x00, 0x10,0x00,
+        'd','a','t','a', 0x00,0x10,0x00,0x00
+    };
+    uint8_t hdr[44];
+    FILE *f;
+
+    wf.fname = FNAME; wf.isSrc = false;
+    wf.channels = CHANNELS; wf.sampleRate = 48000;
+    wf.wordSizeBytes = 2; wf.frameSizeBytes = 2 * CHANNELS;
+    VERIFY(openWave(&wf));
+    VERIFY(writeWave(&wf, samples16, FRAMES * CHANNELS) == FRAMES * CHANNELS);
+    closeWave(&wf);
+
+    f = fopen(FNAME, "rb");
+    VERIFY(f != NULL);
+    VERIFY(fread(hdr, 1, sizeof(hdr), f) == sizeof(hdr));
+    fclose(f);
+    VERIFY(memcmp(hdr, golden, sizeof(golden)) == 0);
+}
+
+TEST("16 and 32-bit files round trip bit-exact") {
+    static int32_t buf[FRAMES * CHANNELS];
+    unsigned ws;
+
+    for (ws = 2; ws <= 4; ws += 2) {
+        memset(&wf, 0, sizeof(wf));
+        wf.fname = FNAME; wf.isSrc = false;
+        wf.channels = CHANNELS; wf.sampleRate = 48000;
+        wf.wordSizeBytes = ws; wf.frameSizeBytes = ws * CHANNELS;
+        VERIFY(openWave(&wf));
+        writeWave(&wf, ws == 2 ? (void *)samples16 : (void *)samples32,
+            FRAMES * CHANNELS);
+        closeWave(&wf);
+
+        VERIFY(openSrc());
+        VERIFY(wf.waveInfo.waveFmt ==
+            (ws == 2 ? WAVE_FMT_SIGNED_16BIT_LE : WAVE_FMT_SIGNED_32BIT_LE));
+        VERIFY(wf.channels == CHANNELS);
+        VERIFY(wf.sampleRate == 48000);
+        VERIFY(wf.dataSize == FRAMES * CHANNELS);
+        VERIFY(readWave(&wf, buf, FRAMES * CHANNELS) == FRAMES * CHANNELS);
+        VERIFY(memcmp(buf, ws == 2 ? (void *)samples16 : (void *)samples32,
+            FRAMES * CHANNELS * ws) == 0);
+        // Reads loop back to the start of the data
+        VERIFY(readWave(&wf, buf, 2) == 2);
+        VERIFY(memcmp(buf, ws == 2 ? (void *)samples16 : (void *)samples32,
+            2 * ws) == 0);
+        closeWave(&wf);
+    }
+}
+
+TEST("RIFX header is parsed big endian") {
+    uint8_t data[8] = { 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0 };
+
+    VERIFY(writeFile(fileData, buildWave(1, 0, 16, 0, data, sizeof(data))));
+    VERIFY(openSrc());
+    VERIFY(memcmp(wf.waveInfo.riffHead, "RIFX", 4) == 0);
+    VERIFY(wf.waveInfo.audioFormat == 0x0001);
+    VERIFY(wf.channels == CHANNELS);
+    VERIFY(wf.sampleRate == 48000);
+    VERIFY(wf.frameSizeBytes == 4);
+    VERIFY(wf.dataSize == 4);
+    VERIFY(wf.waveInfo.waveFmt == WAVE_FMT_SIGNED_16BIT_LE);
+}
+
+TEST("extensible header fields are parsed") {
+    VERIFY(writeFile(fileData, buildWave(0, 1, 32, 32, samples32, 64)));
+    VERIFY(openSrc());
+    VERIFY(wf.waveInfo.audioFormat == 0xFFFE);
+    VERIFY(wf.waveInfo.extensionSize == 22);
+    VERIFY(wf.waveInfo.validBitsPerSample == 32);
+    VERIFY(wf.waveInfo.channelMask == 0x3);
+    VERIFY(wf.waveInfo.subAudioFormat.Data1 == 0x0001);
+    VERIFY(wf.waveInfo.waveFmt == WAVE_FMT_SIGNED_32BIT_LE);
+    VERIFY(wf.dataSize == 16);
+    closeWave(&wf);
+
+    // 24 valid bits in a 32-bit container, big endian
+    VERIFY(writeFile(fileData, buildWave(1, 1, 32, 24, samples32, 64)));
+    VERIFY(openSrc());
+    VERIFY(wf.waveInfo.validBitsPerSample == 24);
+    VERIFY(wf.waveInfo.channelMask == 0x3);
+    VERIFY(wf.wordSizeBytes == 4);
+    VERIFY(wf.waveInfo.waveFmt == WAVE_FMT_SIGNED_32BIT_LE);
+}
+
+TEST("sample formats are detected from the fmt chunk") {
+    static const struct {
+        int extensible; uint16_t tag; uint16_t bits; WAVE_FMT fmt;
+    } cases[] = {
+        { 0, 0x0001,  8, WAVE_FMT_UNSIGNED_8BIT },
+        { 0, 0x0001, 16, WAVE_FMT_SIGNED_16BIT_LE },
+        { 0, 0x0001, 24, WAVE_FMT_SIGNED_24BIT_LE },
+        { 1, 0x0001, 24, WAVE_FMT_SIGNED_24BIT_LE },
+        { 0, 0x0001, 32, WAVE_FMT_SIGNED_32BIT_LE },
+        { 0, 0x0003, 32, WAVE_FMT_FLOAT_32BIT_LE },
+        { 1, 0x0003, 32, WAVE_FMT_FLOAT_32BIT_LE },
+        { 0, 0x0003, 64, WAVE_FMT_UNKNOWN },
+        { 0, 0x0001, 12, WAVE_FMT_UNKNOWN },
+    };
+    unsigned i;
+    int ok = 1;
+
+    for (i = 0; i < ARRAY_NELEM(cases); i++) {
+        VERIFY(writeFile(fileData, buildWaveTag(0, cases[i].extensible,
+            cases[i].tag, cases[i].bits, cases[i].bits, samples32, 48)));
+        VERIFY(openSrc());
+        if (wf.waveInfo.waveFmt != cases[i].fmt) {
+            printf("  case %u: %s\n", i, waveFmtName(wf.waveInfo.waveFmt));
+            ok = 0;
+        }
+        closeWave(&wf);
+    }
+    VERIFY(ok);
+}
+
+TEST("decoders match golden vectors") {
+    static const uint8_t u8[4] = { 0x00, 0x80, 0xFF, 0x81 };
+    static const uint8_t s24[6] = { 0x56, 0x34, 0x12, 0xFF, 0xFF, 0xFF };
+    static const float f32[6] = { 0.5f, -1.0f, 1.0f, 2.0f, -3.0f, -0.25f };
+    int32_t out[6];
+
+    wf.waveInfo.waveFmt = WAVE_FMT_UNSIGNED_8BIT;
+    decodeWave(&wf, u8, out, 4);
+    VERIFY(out[0] == INT32_MIN && out[1] == 0);
+    VERIFY(out[2] == 0x7F000000 && out[3] == 0x01000000);
+
+    wf.waveInfo.waveFmt = WAVE_FMT_SIGNED_24BIT_LE;
+    decodeWave(&wf, s24, out, 2);
+    VERIFY(out[0] == 0x12345600 && out[1] == -256);
+
+    wf.waveInfo.waveFmt = WAVE_FMT_FLOAT_32BIT_LE;
+    decodeWave(&wf, f32, out, 6);
+    VERIFY(out[0] == 0x40000000 && out[1] == INT32_MIN);
+    VERIFY(out[2] == INT32_MAX && out[3] == INT32_MAX);
+    VERIFY(out[4] == INT32_MIN && out[5] == -0x20000000);
+}
+
+TEST("decoders match the reference and encoders invert them") {
+    static const WAVE_FMT fmts[] = {
+        WAVE_FMT_UNSIGNED_8BIT, WAVE_FMT_SIGNED_16BIT_LE,
+        WAVE_FMT_SIGNED_24BIT_LE, WAVE_FMT_SIGNED_32BIT_LE,
+        WAVE_FMT_FLOAT_32BIT_LE
+    };
+    static const unsigned ws[] = { 1, 2, 3, 4, 4 };
+    static uint8_t in[FRAMES * 4 + 4], back[FRAMES * 4 + 4];
+    static int32_t out[FRAMES], ref[FRAMES];
+    unsigned f, n, i;
+    float x;
+    int ok = 1;
+
+    for (f = 0; f < ARRAY_NELEM(fmts); f++) {
+        wf.waveInfo.waveFmt = fmts[f];
+        wf.wordSizeBytes = ws[f];
+        for (i = 0; i < sizeof(in); i++) {
+            in[i] = (uint8_t)(samples32[i % (FRAMES * CHANNELS)] >> 24);
+        }
+        if (fmts[f] == WAVE_FMT_FLOAT_32BIT_LE) {
+            for (i = 0; i < FRAMES; i++) {
+                x = (float)samples32[i] / 2147483648.0f;
+                memcpy(in + i * 4, &x, 4);
+            }
+        }
+        // Odd lengths exercise the scalar tails behind the vector loops
+        for (n = 1; n <= FRAMES; n = n * 2 + 1) {
+            memset(out, 0x5A, sizeof(out));
+            decodeWave(&wf, in, out, n);
+            refDecodeBlock(fmts[f], ws[f], in, ref, n);
+            ok = ok && (memcmp(out, ref, n * sizeof(int32_t)) == 0);
+            memset(back, 0x5A, sizeof(back));
+            encodeWave(&wf, out, back, n);
+            ok = ok && (memcmp(back, in, n * ws[f]) == 0) &&
+                (back[n * ws[f]] == 0x5A);
+        }
+        if (!ok) {
+            printf("  mismatch %s\n", waveFmtName(fmts[f]));
+            break;
+        }
+    }
+    VERIFY(ok);
+}
+
+TEST("24-bit sink round trips through the file") {
+    static int32_t buf[FRAMES * CHANNELS];
+    static uint8_t packed[FRAMES * CHANNELS * 3];
+    unsigned i;
+
+    wf.fname = FNAME; wf.isSrc = false;
+    wf.channels = CHANNELS; wf.sampleRate = 48000;
+    wf.wordSizeBytes = 3; wf.frameSizeBytes = 3 * CHANNELS;
+    VERIFY(openWave(&wf));
+    VERIFY(wf.waveInfo.waveFmt == WAVE_FMT_SIGNED_24BIT_LE);
+    encodeWave(&wf, samples32, packed, FRAMES * CHANNELS);
+    writeWave(&wf, packed, FRAMES * CHANNELS);
+    closeWave(&wf);
+
+    VERIFY(openSrc());
+    VERIFY(wf.waveInfo.waveFmt == WAVE_FMT_SIGNED_24BIT_LE);
+    VERIFY(wf.frameSizeBytes == 3 * CHANNELS);
+    VERIFY(wf.dataSize == FRAMES * CHANNELS);
+    VERIFY(readWave(&wf, packed, FRAMES * CHANNELS) == FRAMES * CHANNELS);
+    decodeWave(&wf, packed, buf, FRAMES * CHANNELS);
+    for (i = 0; i < FRAMES * CHANNELS; i++) {
+        VERIFY(buf[i] == (int32_t)(samples32[i] & 0xFFFFFF00));
+    }
+}
+
+TEST("non-WAVE files are rejected") {
+    size_t len = buildWave(0, 0, 16, 0, samples16, 16);
+    memcpy(fileData + 8, "AVI ", 4);
+    VERIFY(writeFile(fileData, len));
+    VERIFY(!openSrc());
+}
+
+TEST("benchmarks") {
+    static int32_t buf[256];
+    uint64_t ref, cut;
+    FILE *f;
+    unsigned i;
+
+    wf.fname = FNAME; wf.isSrc = false;
+    wf.channels = CHANNELS; wf.sampleRate = 48000;
+    wf.wordSizeBytes = 4; wf.frameSizeBytes = 4 * CHANNELS;
+    VERIFY(openWave(&wf));
+    for (i = 0; i < 16; i++) {
+        writeWave(&wf, samples32, FRAMES * CHANNELS);
+    }
+    closeWave(&wf);
+
+    f = fopen(FNAME, "rb");
+    VERIFY(f != NULL);
+    BENCH(ref,
+        if (fread(buf, 4, 256, f) != 256) { fseek(f, 44, SEEK_SET); });
+    fclose(f);
+    VERIFY(openSrc());
+    BENCH(cut, readWave(&wf, buf, 256));
+    bench_report("readWave 32-bit", ref, cut, 256, "smp");
+    closeWave(&wf);
+
+    wf.waveInfo.waveFmt = WAVE_FMT_SIGNED_24BIT_LE;
+    BENCH(ref, refDecodeBlock(WAVE_FMT_SIGNED_24BIT_LE, 3,
+        (uint8_t *)samples32, samples32 + FRAMES, FRAMES));
+    BENCH(cut, decodeWave(&wf, samples32, samples32 + FRAMES, FRAMES));
+    bench_report("decodeWave 24-bit", ref, cut, FRAMES, "smp");
+    wf.waveInfo.waveFmt = WAVE_FMT_FLOAT_32BIT_LE;
+    BENCH(ref, refDecodeBlock(WAVE_FMT_FLOAT_32BIT_LE, 4,
+        (uint8_t *)samples32, samples32 + FRAMES, FRAMES));
+    BENCH(cut, decodeWave(&wf, samples32, samples32 + FRAMES, FRAMES));
+    bench_report("decodeWave float", ref, cut, FRAMES, "smp");
+}
+
+} // TEST_GROUP()
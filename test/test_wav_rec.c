@@ -0,0 +1,494 @@
+// Preallocated WAV recorder tests.  FatFs runs on a RAM disk, the
+// recorded files are read back and checked byte for byte against the
+// encoded input, including stem splits and writes that end mid-frame.
+// A copy of the disk taken between two header commits stands in for a
+// power loss and must mount and hold a playable file.  Disk traffic is
+// compared against plain appending f_write() calls last.
+//
+// Build and run from the repository root:
+//   gcc -O2 -I test -I test/et -I test/host -I ARM/include -I ALL/include
+//       -I ARM/src/oss-services/FreeRTOS-ARM/include
+//       -I ARM/src/oss-services/umm_malloc -I ARM/src/simple-services/sched-trace
+//       -I ARM/src/oss-services/FatFs -I ARM/src/simple-services/wav-file
+//       -I ARM/src/simple-services/flac-dec -I ARM/src/simple-services/wav-rec
+//       test/test_wav_rec.c ARM/src/simple-services/wav-rec/wav_rec.c
+//       ARM/src/simple-services/wav-file/wav_file.c
+//       ARM/src/simple-services/flac-dec/flac_dec.c
+//       ARM/src/oss-services/FatFs/ff.c ARM/src/oss-services/FatFs/ffunicode.c
+//       test/et/et.c test/et/et_host.c -o test_wav_rec && ./test_wav_rec
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "wav_rec.h"  // Code Under Test (CUT)
+#include "ff.h"
+#include "diskio.h"
+#include "umm_malloc.h"
+#include "et.h"  // ET: embedded test
+#include "bench.h"
+
+#define DISK_SECTORS    (64 * 1024 * 1024 / 512)
+#define RATE            48000
+#define COMMIT_BYTES(ch, ws)  (2 * RATE * (ch) * (ws))
+
+typedef struct RAM_DISK {
+    uint8_t *img;
+    unsigned writes;
+    unsigned metaSectors;
+    unsigned dataSectors;
+} RAM_DISK;
+
+static RAM_DISK disk[2];
+static FATFS fs[2];
+static uint8_t *fileData;
+static int32_t *pcm;
+static uint32_t seed;
+
+// FatFs platform hooks: RAM disks 0 ("SD:") and 1 ("MSD:") -----------------
+DSTATUS disk_initialize(BYTE pdrv) {
+    return (pdrv < 2 && disk[pdrv].img) ? 0 : STA_NOINIT;
+}
+
+DSTATUS disk_status(BYTE pdrv) {
+    return disk_initialize(pdrv);
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count) {
+    memcpy(buff, disk[pdrv].img + sector * 512, count * 512);
+    return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count) {
+    RAM_DISK *d = &disk[pdrv];
+    memcpy(d->img + sector * 512, buff, count * 512);
+    d->writes++;
+    if (fs[pdrv].fs_type && sector >= fs[pdrv].database) {
+        d->dataSectors += count;
+    } else {
+        d->metaSectors += count;
+    }
+    return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff) {
+    switch (cmd) {
+        case GET_SECTOR_COUNT: *(LBA_t *)buff = DISK_SECTORS; break;
+        case GET_BLOCK_SIZE: *(DWORD *)buff = 1; break;
+        default: break;
+    }
+    return RES_OK;
+}
+
+DWORD get_fattime(void) {
+    return ((DWORD)(2026 - 1980) << 25) | (1 << 21) | (1 << 16);
+}
+
+void *ff_memalloc(UINT msize) {
+    return malloc(msize);
+}
+
+void ff_memfree(void *mblock) {
+    free(mblock);
+}
+
+int ff_cre_syncobj(BYTE vol, FF_SYNC_t *sobj) {
+    (void)vol; *sobj = NULL;
+    return 1;
+}
+
+int ff_req_grant(FF_SYNC_t sobj) {
+    (void)sobj;
+    return 1;
+}
+
+void ff_rel_grant(FF_SYNC_t sobj) {
+    (void)sobj;
+}
+
+int ff_del_syncobj(FF_SYNC_t sobj) {
+    (void)sobj;
+    return 1;
+}
+
+// wav_rec_cfg.h and wav_file_cfg.h allocate from the umm heaps
+void *umm_malloc_heap_aligned(umm_heap_t heap, size_t size, size_t alignment) {
+    (void)heap; (void)alignment;
+    return malloc(size);
+}
+
+void umm_free_heap_aligned(umm_heap_t heap, void *ptr) {
+    (void)heap;
+    free(ptr);
+}
+
+void *umm_calloc_aligned(size_t num, size_t item_size, size_t alignment) {
+    (void)alignment;
+    return calloc(num, item_size);
+}
+
+void umm_free_aligned(void *ptr) {
+    free(ptr);
+}
+
+void *umm_calloc_heap(umm_heap_t heap, size_t num, size_t size) {
+    (void)heap;
+    return calloc(num, size);
+}
+
+void umm_free_heap(umm_heap_t heap, void *ptr) {
+    (void)heap;
+    free(ptr);
+}
+
+// helpers -------------------------------------------------------------------
+static uint32_t rnd(void) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed;
+}
+
+static int32_t sampleAt(unsigned frame, unsigned ch) {
+    return (int32_t)(frame * 2654435761u ^ (ch + 1) * 0x9E3779B9u);
+}
+
+static void fillPcm(unsigned frames, unsigned channels) {
+    unsigned f, c;
+    for (f = 0; f < frames; f++) {
+        for (c = 0; c < channels; c++) {
+            pcm[f * channels + c] = sampleAt(f, c);
+        }
+    }
+}
+
+static void format(BYTE fmt, DWORD au) {
+    MKFS_PARM opt = { fmt, 1, 0, 0, au };
+    static uint8_t work[32 * 1024];
+    memset(&fs[0], 0, sizeof(fs[0]));
+    VERIFY(f_mkfs("SD:", &opt, work, sizeof(work)) == FR_OK);
+    VERIFY(f_mount(&fs[0], "SD:", 1) == FR_OK);
+}
+
+static void resetCounts(void) {
+    disk[0].writes = 0;
+    disk[0].metaSectors = 0;
+    disk[0].dataSectors = 0;
+}
+
+// Mounts a copy of the disk as it is right now, as if power was cut
+static void powerLoss(void) {
+    memcpy(disk[1].img, disk[0].img, (size_t)DISK_SECTORS * 512);
+    VERIFY(f_mount(&fs[1], "MSD:", 1) == FR_OK);
+}
+
+static size_t readFile(const char *path, FSIZE_t *fsize) {
+    FIL f;
+    UINT br;
+    if (f_open(&f, path, FA_READ) != FR_OK) {
+        return 0;
+    }
+    *fsize = f_size(&f);
+    f_read(&f, fileData, (UINT)f_size(&f), &br);
+    f_close(&f);
+    return br;
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t get16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+// Checks the one sector header, returns the data chunk size
+static uint32_t checkHeader(unsigned channels, unsigned ws) {
+    uint32_t dataBytes = get32(fileData + 508);
+    VERIFY(memcmp(fileData, "RIFF", 4) == 0);
+    VERIFY(get32(fileData + 4) == 504 + dataBytes);
+    VERIFY(memcmp(fileData + 8, "WAVEfmt ", 8) == 0);
+    VERIFY(get16(fileData + 20) == 1);
+    VERIFY(get16(fileData + 22) == channels);
+    VERIFY(get32(fileData + 24) == RATE);
+    VERIFY(get16(fileData + 32) == channels * ws);
+    VERIFY(get16(fileData + 34) == ws * 8);
+    VERIFY(memcmp(fileData + 36, "JUNK", 4) == 0);
+    VERIFY(get32(fileData + 40) == 512 - 52);
+    VERIFY(memcmp(fileData + 504, "data", 4) == 0);
+    VERIFY(dataBytes % (channels * ws) == 0);
+    return dataBytes;
+}
+
+// True if the file's audio matches channels [first, first + channels)
+static int matchesPcm(unsigned first, unsigned channels, unsigned totalCh,
+    unsigned ws, unsigned frames) {
+    const uint8_t *p = fileData + 512;
+    unsigned f, c, b;
+    uint32_t v;
+    for (f = 0; f < frames; f++) {
+        for (c = first; c < first + channels; c++) {
+            v = (uint32_t)pcm[f * totalCh + c];
+            for (b = 0; b < ws; b++) {
+                if (*p++ != (uint8_t)(v >> (8 * (4 - ws + b)))) {
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+// Writes interleaved samples in random sized pieces
+static void recordRandom(WAV_REC *rec, size_t samples) {
+    size_t i, n;
+    for (i = 0; i < samples; i += n) {
+        n = 1 + rnd() % 3001;
+        n = (n > samples - i) ? samples - i : n;
+        VERIFY(wav_rec_write(rec, pcm + i, n) == n);
+    }
+}
+
+static unsigned linkMapFragments(const char *path) {
+    DWORD clmt[64];
+    FIL f;
+    clmt[0] = 64;
+    if (f_open(&f, path, FA_READ) != FR_OK) {
+        return 0;
+    }
+    f.cltbl = clmt;
+    f_lseek(&f, CREATE_LINKMAP);
+    f_close(&f);
+    return (clmt[0] - 2) / 2;
+}
+
+void setup(void) {
+    seed = 0x5EC0;
+    if (pcm == NULL) {
+        disk[0].img = malloc((size_t)DISK_SECTORS * 512);
+        disk[1].img = malloc((size_t)DISK_SECTORS * 512);
+        fileData = malloc((size_t)DISK_SECTORS * 512);
+        pcm = malloc(8 * 1024 * 1024);
+    }
+    memset(disk[0].img, 0, (size_t)DISK_SECTORS * 512);
+    memset(&fs, 0, sizeof(fs));
+}
+
+void teardown(void) {
+    f_mount(NULL, "SD:", 0);
+    f_mount(NULL, "MSD:", 0);
+}
+
+// test group ----------------------------------------------------------------
+TEST_GROUP("wav_rec") {
+
+TEST("header is one sector and audio starts on a cluster boundary") {
+    unsigned frames = 100000;
+    WAV_REC_STATS stats;
+    FSIZE_t fsize = 0;
+    WAV_REC *rec;
+
+    format(FM_FAT, 4096);
+    fillPcm(frames, 2);
+    rec = wav_rec_open("SD:take.wav", 2, RATE, 2, 0);
+    VERIFY(rec != NULL);
+    VERIFY(wav_rec_write(rec, pcm, frames * 2) == frames * 2);
+    wav_rec_stats(rec, &stats);
+    VERIFY(stats.files == 1);
+    VERIFY(stats.clusterBytes == 4096);
+    VERIFY(stats.writeBytes == 32 * 1024);
+    VERIFY(stats.preallocBytes > frames * 4);
+    VERIFY(stats.appendBlocks == 0);
+    VERIFY(stats.frames == frames);
+    VERIFY(wav_rec_close(rec));
+
+    VERIFY(readFile("SD:take.wav", &fsize) == 512 + frames * 4);
+    VERIFY(fsize == 512 + frames * 4);
+    VERIFY(checkHeader(2, 2) == frames * 4);
+    VERIFY(matchesPcm(0, 2, 2, 2, frames));
+    VERIFY(linkMapFragments("SD:take.wav") == 1);
+}
+
+TEST("unused preallocation goes back to the volume on close") {
+    DWORD freeBefore, freeDuring, freeAfter;
+    FATFS *pfs;
+    WAV_REC *rec;
+
+    format(FM_FAT, 4096);
+    fillPcm(1000, 2);
+    VERIFY(f_getfree("SD:", &freeBefore, &pfs) == FR_OK);
+    rec = wav_rec_open("SD:take.wav", 2, RATE, 2, 0);
+    VERIFY(rec != NULL);
+    VERIFY(f_getfree("SD:", &freeDuring, &pfs) == FR_OK);
+    VERIFY(freeBefore - freeDuring > 1000);
+    VERIFY(wav_rec_write(rec, pcm, 2000) == 2000);
+    VERIFY(wav_rec_close(rec));
+    VERIFY(f_getfree("SD:", &freeAfter, &pfs) == FR_OK);
+    VERIFY(freeBefore - freeAfter == (512 + 4000 + 4095) / 4096);
+}
+
+TEST("stems split channels and survive writes that end mid-frame") {
+    unsigned frames = 60000;
+    WAV_REC_STATS stats;
+    FSIZE_t fsize = 0;
+    WAV_REC *rec;
+
+    format(FM_EXFAT, 32 * 1024);
+    fillPcm(frames, 5);
+    rec = wav_rec_open("SD:session.wav", 5, RATE, 3, 2);
+    VERIFY(rec != NULL);
+    recordRandom(rec, frames * 5);
+    wav_rec_stats(rec, &stats);
+    VERIFY(stats.files == 3);
+    VERIFY(stats.appendBlocks == 0);
+    VERIFY(wav_rec_close(rec));
+
+    VERIFY(readFile("SD:session_1.wav", &fsize) == 512 + frames * 6);
+    VERIFY(checkHeader(2, 3) == frames * 6);
+    VERIFY(matchesPcm(0, 2, 5, 3, frames));
+    VERIFY(readFile("SD:session_2.wav", &fsize) == 512 + frames * 6);
+    VERIFY(checkHeader(2, 3) == frames * 6);
+    VERIFY(matchesPcm(2, 2, 5, 3, frames));
+    VERIFY(readFile("SD:session_3.wav", &fsize) == 512 + frames * 3);
+    VERIFY(checkHeader(1, 3) == frames * 3);
+    VERIFY(matchesPcm(4, 1, 5, 3, frames));
+}
+
+TEST("a power loss keeps everything up to the last header commit") {
+    unsigned frames = 600000;
+    WAV_REC_STATS stats;
+    FSIZE_t fsize = 0;
+    uint32_t dataBytes;
+    WAV_REC *rec;
+    size_t i;
+
+    format(FM_FAT, 4096);
+    fillPcm(frames, 2);
+    rec = wav_rec_open("SD:take.wav", 2, RATE, 4, 0);
+    VERIFY(rec != NULL);
+    for (i = 0; i < frames * 2; i += 1024) {
+        VERIFY(wav_rec_write(rec, pcm + i, 1024) == 1024);
+        wav_rec_stats(rec, &stats);
+        if (stats.commits == 2) {
+            break;
+        }
+    }
+    VERIFY(stats.commits == 2);
+
+    // The card holds the whole preallocation and a header for the
+    // audio written up to the second commit
+    powerLoss();
+    VERIFY(readFile("MSD:take.wav", &fsize) == fsize);
+    VERIFY(fsize == stats.preallocBytes);
+    dataBytes = checkHeader(2, 4);
+    VERIFY(dataBytes >= 2 * COMMIT_BYTES(2, 4));
+    VERIFY(dataBytes < 2 * (COMMIT_BYTES(2, 4) + stats.writeBytes) +
+        stats.writeBytes);
+    VERIFY(matchesPcm(0, 2, 2, 4, dataBytes / 8));
+
+    VERIFY(wav_rec_close(rec));
+    VERIFY(readFile("SD:take.wav", &fsize) == 512 + (i + 1024) * 4);
+}
+
+TEST("a fragmented volume shrinks the preallocation, then appends") {
+    static uint8_t chunk[1024 * 1024];
+    unsigned frames = 1000000;
+    WAV_REC_STATS stats;
+    FSIZE_t fsize = 0;
+    WAV_REC *rec;
+    char name[24];
+    UINT bw;
+    FIL f;
+    int n, i;
+
+    // Fill the volume with 1MB files and delete every other one
+    format(FM_FAT, 4096);
+    for (n = 0; ; n++) {
+        sprintf(name, "SD:f%02d.bin", n);
+        VERIFY(f_open(&f, name, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK);
+        f_write(&f, chunk, sizeof(chunk), &bw);
+        f_close(&f);
+        if (bw != sizeof(chunk)) {
+            break;
+        }
+    }
+    for (i = 0; i < n; i += 2) {
+        sprintf(name, "SD:f%02d.bin", i);
+        VERIFY(f_unlink(name) == FR_OK);
+    }
+
+    fillPcm(frames, 2);
+    rec = wav_rec_open("SD:take.wav", 2, RATE, 2, 0);
+    VERIFY(rec != NULL);
+    wav_rec_stats(rec, &stats);
+    VERIFY(stats.preallocBytes >= 512 * 1024);
+    VERIFY(stats.preallocBytes <= sizeof(chunk));
+    VERIFY(wav_rec_write(rec, pcm, frames * 2) == frames * 2);
+    wav_rec_stats(rec, &stats);
+    VERIFY(stats.appendBlocks > 0);
+    VERIFY(stats.errors == 0);
+    VERIFY(wav_rec_close(rec));
+
+    VERIFY(readFile("SD:take.wav", &fsize) == 512 + frames * 4);
+    VERIFY(checkHeader(2, 2) == frames * 4);
+    VERIFY(matchesPcm(0, 2, 2, 2, frames));
+}
+
+TEST("bad formats and too many stems are rejected") {
+    format(FM_FAT, 4096);
+    VERIFY(wav_rec_open("SD:x.wav", 0, RATE, 2, 0) == NULL);
+    VERIFY(wav_rec_open("SD:x.wav", 2, RATE, 1, 0) == NULL);
+    VERIFY(wav_rec_open("SD:x.wav", 2, RATE, 5, 0) == NULL);
+    VERIFY(wav_rec_open("SD:x.wav", 32, RATE, 2, 2) == NULL);
+    VERIFY(wav_rec_open("NONE:x.wav", 2, RATE, 2, 0) == NULL);
+}
+
+TEST("benchmarks") {
+    unsigned frames = 200000;
+    unsigned channels = 8;
+    size_t bytes = (size_t)frames * channels * 2;
+    static uint8_t block[16 * 1024];
+    unsigned writes;
+    WAV_REC_STATS stats;
+    uint64_t t;
+    WAV_REC *rec;
+    size_t i;
+    UINT bw;
+    FIL f;
+
+    // SDXC layout, 128K clusters.  Only the streaming phase is counted,
+    // not open and close.
+    format(FM_EXFAT, 128 * 1024);
+    fillPcm(frames, channels);
+
+    // Baseline: the stdio path, 16K appends growing the file as it goes
+    VERIFY(f_open(&f, "SD:base.wav", FA_CREATE_ALWAYS | FA_WRITE) == FR_OK);
+    resetCounts();
+    t = bench_ns();
+    for (i = 0; i < bytes; i += sizeof(block)) {
+        f_write(&f, block, sizeof(block), &bw);
+    }
+    t = bench_ns() - t;
+    writes = disk[0].writes;
+    printf("  bench %-28s %6.1f writes/MB  %5.1f meta sectors/MB  %.2f ms\n",
+        "append 16K", writes * 1048576.0 / bytes,
+        disk[0].metaSectors * 1048576.0 / bytes, t / 1e6);
+    f_close(&f);
+
+    rec = wav_rec_open("SD:rec.wav", channels, RATE, 2, 0);
+    VERIFY(rec != NULL);
+    resetCounts();
+    t = bench_ns();
+    VERIFY(wav_rec_write(rec, pcm, frames * channels) == frames * channels);
+    t = bench_ns() - t;
+    wav_rec_stats(rec, &stats);
+    printf("  bench %-28s %6.1f writes/MB  %5.1f meta sectors/MB  %.2f ms\n",
+        "wav_rec 128K contiguous", disk[0].writes * 1048576.0 / bytes,
+        disk[0].metaSectors * 1048576.0 / bytes, t / 1e6);
+
+    // One directory sector per header commit and nothing else
+    VERIFY(disk[0].writes < writes);
+    VERIFY(disk[0].metaSectors <= stats.commits);
+    VERIFY(wav_rec_close(rec));
+}
+
+} // TEST_GROUP()
@@ -0,0 +1,339 @@
+// xyz_utils analyzer regression tests.  The pitch helpers are checked
+// against golden values, the track length and key estimators run on
+// generated WAV files.  The FFT accelerator is replaced by a naive DFT
+// so xyz_estimate_key() is checked end to end up to the reported note,
+// both calling it directly and through an FFT queue.
+//
+// Build and run from the repository root:
+//   gcc -O2 -Wno-unknown-pragmas -I test -I test/et -I test/host
+//       -I ARM/include -I ALL/include -I ARM/src
+//       -I ARM/src/oss-services/FreeRTOS-ARM/include
+//       -I ARM/src/oss-services/umm_malloc -I ARM/src/simple-services/sched-trace
+//       -I ARM/src/simple-services/wav-file -I ARM/src/simple-services/flac-dec
+//       -I ARM/src/simple-services/syslog -I ARM/src/simple-services/fft-queue
+//       -I ALL/src/trace-log -D'TRACE_LOG_TIMESTAMP()=0'
+//       test/test_xyz_utils.c ARM/src/xyz_utils.c
+//       ARM/src/simple-services/fft-queue/fft_queue.c
+//       ARM/src/simple-services/wav-file/wav_file.c
+//       ARM/src/simple-services/flac-dec/flac_dec.c ALL/src/trace-log/trace_log.c
+//       test/et/et.c test/et/et_host.c -lm -o test_xyz_utils && ./test_xyz_utils
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+
+#include "adi_fft_wrapper.h"
+#include "xyz_utils.h"  // Code Under Test (CUT)
+#include "umm_malloc.h"
+#include "et.h"  // ET: embedded test
+#include "bench.h"
+
+#define FNAME       "test_xyz_utils.wav"
+#define N_FFT       4096
+
+static char lastLog[256];
+
+volatile uint32_t hostTsCount;
+
+// Platform stand-ins ----------------------------------------------------------
+void vPortEnterCritical(void) {
+}
+
+void vPortExitCritical(void) {
+}
+
+void vPortYield(void) {
+}
+
+// FFT queue waits, the owner runs while the estimator sleeps
+static FFT_QUEUE queue;
+static unsigned wakes;
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return (TaskHandle_t)&wakes;
+}
+
+BaseType_t xTaskGenericNotify(TaskHandle_t xTaskToNotify,
+    UBaseType_t uxIndexToNotify, uint32_t ulValue, eNotifyAction eAction,
+    uint32_t *pulPreviousNotificationValue) {
+    wakes++;
+    return pdPASS;
+}
+
+uint32_t ulTaskGenericNotifyTake(UBaseType_t uxIndexToWaitOn,
+    BaseType_t xClearCountOnExit, TickType_t xTicksToWait) {
+    uint32_t n;
+
+    while (wakes == 0) {
+        fft_queue_service(&queue);
+    }
+    n = wakes;
+    wakes = 0;
+    return n;
+}
+
+UBaseType_t uxTaskPriorityGet(const TaskHandle_t xTask) {
+    return tskIDLE_PRIORITY + 1;
+}
+
+void vTaskPrioritySet(TaskHandle_t xTask, UBaseType_t uxNewPriority) {
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay) {
+}
+
+const complex_float accel_twiddles_4096[1];
+
+void accel_fft_set_error_handler(ADI_FFT_ERROR_HANDLER handler) {
+    (void)handler;
+}
+
+int adi_fft_GetHWErrorStatus(ADI_FFT_HANDLE h, uint32_t *status) {
+    (void)h;
+    *status = 0;
+    return 0;
+}
+
+// |X[k]|^2 of the first n/2 bins, same layout as the accelerator
+float *accel_rfft_large_mag_sq(const float *input, float *output,
+    complex_float *temp, const complex_float *twiddles, int twiddle_stride,
+    float scale, int n)
+{
+    int k, i;
+    (void)temp; (void)twiddles; (void)twiddle_stride;
+    for (k = 0; k < n / 2; k++) {
+        double re = 0.0, im = 0.0;
+        for (i = 0; i < n; i++) {
+            double a = -2.0 * M_PI * (double)k * i / n;
+            re += input[i] * cos(a);
+            im += input[i] * sin(a);
+        }
+        output[k] = (float)((re * re + im * im) * scale);
+    }
+    return output;
+}
+
+void syslog_printf(char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(lastLog, sizeof(lastLog), fmt, args);
+    va_end(args);
+}
+
+void *umm_calloc_aligned(size_t num, size_t item_size, size_t alignment) {
+    (void)alignment;
+    return calloc(num, item_size);
+}
+
+void umm_free_aligned(void *ptr) {
+    free(ptr);
+}
+
+void *umm_calloc_heap(umm_heap_t heap, size_t num, size_t size) {
+    (void)heap;
+    return calloc(num, size);
+}
+
+void umm_free_heap(umm_heap_t heap, void *ptr) {
+    (void)heap;
+    free(ptr);
+}
+
+// Helpers ---------------------------------------------------------------------
+static void put16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+    put16(p, (uint16_t)v); put16(p + 2, (uint16_t)(v >> 16));
+}
+
+// Mono WAVE_FORMAT_EXTENSIBLE file, 'bits' per sample
+static int writeWave(uint16_t bits, const void *data, uint32_t dataSize) {
+    uint8_t hdr[68];
+    FILE *f;
+    int ok;
+
+    memset(hdr, 0, sizeof(hdr));
+    memcpy(hdr, "RIFF", 4); put32(hdr + 4, sizeof(hdr) - 8 + dataSize);
+    memcpy(hdr + 8, "WAVE", 4);
+    memcpy(hdr + 12, "fmt ", 4); put32(hdr + 16, 40);
+    put16(hdr + 20, 0xFFFE); put16(hdr + 22, 1);
+    put32(hdr + 24, 48000); put32(hdr + 28, 48000 * bits / 8);
+    put16(hdr + 32, bits / 8); put16(hdr + 34, bits);
+    put16(hdr + 36, 22); put16(hdr + 38, bits); put32(hdr + 40, 0x4);
+    hdr[44] = (bits == 32) ? 0x03 : 0x01;  // IEEE float or PCM subtype
+    memcpy(hdr + 60, "data", 4); put32(hdr + 64, dataSize);
+
+    f = fopen(FNAME, "wb");
+    ok = f && (fwrite(hdr, sizeof(hdr), 1, f) == 1) &&
+        (!dataSize || (fwrite(data, dataSize, 1, f) == 1));
+    if (f) {
+        fclose(f);
+    }
+    return ok;
+}
+
+static float refHzToMidi(float freq) {
+    return 69.0f + 12.0f * log2f(freq / 440.0f);
+}
+
+// FFT queue backend running the stand-in transform when polled
+static FFT_JOB *queued;
+static unsigned queuedPrio;
+
+static void queueStart(void *usr, FFT_JOB *const *jobs, unsigned n) {
+    (void)usr;
+    (void)n;
+    queued = jobs[0];
+    queuedPrio = jobs[0]->priority;
+}
+
+static void queuePoll(void *usr) {
+    FFT_JOB *job = queued;
+    (void)usr;
+    if (job) {
+        queued = NULL;
+        accel_rfft_large_mag_sq(job->in, job->out, job->temp, job->twiddles,
+            job->twiddleStride, job->scale, job->npts);
+        fft_queue_complete(&queue, true);
+    }
+}
+
+static void writeTone(void) {
+    static float tone[N_FFT];
+    unsigned i, h;
+
+    // Harmonic product spectrum needs the overtones of a real note
+    for (i = 0; i < N_FFT; i++) {
+        tone[i] = 0.0f;
+        for (h = 1; h <= 4; h++) {
+            tone[i] += 0.2f / h *
+                sinf(2.0f * (float)M_PI * 440.0f * h * i / 48000.0f);
+        }
+    }
+    VERIFY(writeWave(32, tone, sizeof(tone)));
+}
+
+void setup(void) {
+    lastLog[0] = '\0';
+    xyz_set_fft_queue(NULL);
+}
+
+void teardown(void) {
+    remove(FNAME);
+}
+
+// test group ----------------------------------------------------------------
+TEST_GROUP("xyz_utils") {
+
+TEST("hz to midi golden values") {
+    VERIFY(fabsf(XYZ_hz_to_midi(440.0f) - 69.0f) < 1e-4f);
+    VERIFY(fabsf(XYZ_hz_to_midi(880.0f) - 81.0f) < 1e-4f);
+    VERIFY(fabsf(XYZ_hz_to_midi(261.6256f) - 60.0f) < 1e-3f);
+    VERIFY(fabsf(XYZ_hz_to_midi(27.5f) - 21.0f) < 1e-4f);
+}
+
+TEST("midi to note golden strings") {
+    char buf[8];
+    XYZ_midi_to_note(69.0f, buf, sizeof(buf));
+    VERIFY(strcmp(buf, "A4") == 0);
+    XYZ_midi_to_note(60.4f, buf, sizeof(buf));
+    VERIFY(strcmp(buf, "C4") == 0);
+    XYZ_midi_to_note(60.6f, buf, sizeof(buf));
+    VERIFY(strcmp(buf, "C#4") == 0);
+    XYZ_midi_to_note(0.0f, buf, sizeof(buf));
+    VERIFY(strcmp(buf, "C-1") == 0);
+    XYZ_midi_to_note(127.0f, buf, sizeof(buf));
+    VERIFY(strcmp(buf, "G9") == 0);
+    XYZ_midi_to_note(128.0f, buf, sizeof(buf));
+    VERIFY(strcmp(buf, "Invalid") == 0);
+    XYZ_midi_to_note(-1.0f, buf, sizeof(buf));
+    VERIFY(strcmp(buf, "Invalid") == 0);
+}
+
+TEST("key strings") {
+    XYZ_Key key;
+    memset(&key, 0, sizeof(key));
+    key.tonic = XYZ_A; key.accidental = XYZ_NAT; key.scale = XYZ_MIN;
+    xyz_update_key_string(&key);
+    VERIFY(strcmp(key.key_string, "A  Min") == 0);
+    key.tonic = XYZ_F; key.accidental = XYZ_SHARP; key.scale = XYZ_MAJ;
+    xyz_update_key_string(&key);
+    VERIFY(strcmp(key.key_string, "F # Maj") == 0);
+    key.tonic = XYZ_B; key.accidental = XYZ_FLAT;
+    xyz_update_key_string(&key);
+    VERIFY(strcmp(key.key_string, "B bMaj") == 0);
+}
+
+TEST("track length from the data size and byte rate") {
+    static int16_t silence[48000 + 4800];
+    XYZ_TrackLength *tl;
+
+    VERIFY(writeWave(16, silence, sizeof(silence)));
+    tl = xyz_get_length(FNAME);
+    VERIFY(tl != NULL);
+    VERIFY(tl->hours == 0 && tl->mins == 0);
+    VERIFY(tl->secs == 1 && tl->ms == 100);
+    free(tl);
+
+    VERIFY(xyz_get_length("no_such_file.wav") == NULL);
+}
+
+TEST("key estimate finds the fundamental of a tone") {
+    XYZ_Key *key;
+
+    writeTone();
+    key = xyz_estimate_key(FNAME);
+    VERIFY(key != NULL);
+    VERIFY(strcmp(lastLog, "Estimated key: A4") == 0);
+    VERIFY(key->KEY_UNKNOWN);
+    free(key);
+}
+
+TEST("key estimate through the FFT queue") {
+    FFT_QUEUE_BACKEND be = { queueStart, queuePoll, NULL };
+    FFT_QUEUE_STATS st;
+    XYZ_Key *key;
+
+    fft_queue_init(&queue, &be);
+    xyz_set_fft_queue(&queue);
+    writeTone();
+    key = xyz_estimate_key(FNAME);
+    VERIFY(key != NULL);
+    VERIFY(strcmp(lastLog, "Estimated key: A4") == 0);
+    free(key);
+
+    // One background job, finished by the owner
+    fft_queue_stats(&queue, &st, false);
+    VERIFY(st.jobs == 1 && st.errors == 0);
+    VERIFY(queuedPrio == FFT_QUEUE_PRIO_BACKGROUND);
+}
+
+TEST("bpm estimate is not implemented") {
+    XYZ_BPM bpm = xyz_estimate_bpm(FNAME);
+    VERIFY(bpm.whole == -1 && bpm.decimal == -1);
+}
+
+TEST("benchmarks") {
+    static float freqs[1024];
+    volatile float sink;
+    uint64_t ref, cut;
+    unsigned i;
+
+    for (i = 0; i < ARRAY_NELEM(freqs); i++) {
+        freqs[i] = 20.0f + i * 19.5f;
+    }
+    BENCH(ref, for (i = 0; i < ARRAY_NELEM(freqs); i++) {
+        sink = refHzToMidi(freqs[i]); });
+    BENCH(cut, for (i = 0; i < ARRAY_NELEM(freqs); i++) {
+        sink = XYZ_hz_to_midi(freqs[i]); });
+    (void)sink;
+    bench_report("XYZ_hz_to_midi", ref, cut, ARRAY_NELEM(freqs), "call");
+    VERIFY(1);
+}
+
+} // TEST_GROUP()